@@ -5,6 +5,13 @@ VERSION_STR = '\\"$${VERSION}\\"'
 DEFINES += PDCALC_VERSION=\"$${VERSION_STR}\"
 CONFIG += c++14
 
+# STATIC_PLUGINS names the plugins to link into pdCalc rather than build as
+# libraries it loads, e.g.,
+#   qmake -r "STATIC_PLUGINS = hyperbolicLnPlugin statisticsPlugin"
+# plugins.pdp still selects the plugins pdCalc loads. Linked plugins, and pdCalc
+# with them, are built with link time code generation. The plugins' tests and
+# benchmarks load the plugins' libraries, so they need a build without them.
+
 unix:DEFINES += POSIX
 win32:DEFINES += WIN32
 
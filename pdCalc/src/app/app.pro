@@ -1,5 +1,6 @@
 TEMPLATE = subdirs
 
 SUBDIRS += pdCalc \
+           pdCalcPluginHost \
            pdCalc-simple-cli \
            pdCalc-simple-gui
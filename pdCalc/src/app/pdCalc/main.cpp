@@ -24,19 +24,38 @@
 #include "ui/cli/Cli.h"
 #include "backend/AppObservers.h"
 #include "backend/CommandDispatcher.h"
+#include "backend/CommandWorker.h"
 #include <memory>
 #include "backend/Stack.h"
 #include "utilities/Exception.h"
 #include "backend/CoreCommands.h"
 #include "ui/gui/MainWindow.h"
 #include "backend/PluginLoader.h"
+#include "backend/PluginHost.h"
 #include <vector>
 #include "backend/Plugin.h"
 #include "backend/CommandRepository.h"
+#include "backend/StackSnapshot.h"
 #include <set>
 #include <sstream>
 
-using std::set;
+// the plugins linked into pdCalc, as configured by STATIC_PLUGINS in the build
+#ifdef STATIC_HYPERBOLICLNPLUGIN
+#include "plugins/hyperbolicLnPlugin/HyperbolicLnPlugin.h"
+#endif
+#ifdef STATIC_STATISTICSPLUGIN
+#include "plugins/statisticsPlugin/StatisticsPlugin.h"
+#endif
+#ifdef STATIC_MATRIXPLUGIN
+#include "plugins/matrixPlugin/MatrixPlugin.h"
+#endif
+#ifdef STATIC_FFTPLUGIN
+#include "plugins/fftPlugin/FftPlugin.h"
+#endif
+#ifdef STATIC_RANDOMPLUGIN
+#include "plugins/randomPlugin/RandomPlugin.h"
+#endif
+
 using std::vector;
 using std::cin;
 using std::cout;
@@ -121,25 +140,143 @@ void usage()
          << "\t--gui, -g: graphical user interface\n"
          << "\t--cli, -c: command line interface\n"
          << "\t--batch <in> [out], -b <in> [out]: batch interface (out optional)\n"
+         << "\t--load <file>: start from the stack snapshot in file\n"
+         << "\t--save <file>: save a stack snapshot to file on exit\n"
+         << "\t--journal <file>: recover the session journaled to file and journal it\n"
+         << "\t--journal-window <ms>: how long journaled entries wait to reach disk (default 50)\n"
+         << "\t--checkpoint <n>: snapshot the journaled session every n entries, which keeps\n"
+         << "\t    the journal short but clears the undo history each time (default never)\n"
+         << "\t--versioned: keep versions of the stack so undo:n and redo:n jump at once\n"
+         << "\t--history-file <file>: spill undo history older than the window to file\n"
+         << "\t--history-window <n>: entries of spilled undo history kept in memory (default 10000)\n"
+         << "\t--branches: keep every branch of the undo history instead of spilling it\n"
+         << "\t--budget-steps <n>: undo an entry that takes more than n steps\n"
+         << "\t--budget-ms <ms>: undo an entry that runs longer than ms milliseconds\n"
+         << "\t--reload-plugins: reload a plugin whose file changes, without restarting\n"
+         << "\t--isolate-plugins: run plugins in a helper process, restarted if a plugin crashes\n"
          << endl;
        
     exit(0);
 }
 
-void setupUi(UserInterface& ui, CommandDispatcher& ce)
+// a count given on the command line; anything else is a usage error
+unsigned long parseCount(const string& s)
 {
-    RegisterCoreCommands(ui);
+    unsigned long n;
+    std::istringstream iss{s};
+    if( s.empty() || s[0] == '-' || !(iss >> n) || !iss.eof() ) usage();
 
-    ui.attach(UserInterface::CommandEntered, make_unique<CommandIssuedObserver>( ce ) );
+    return n;
+}
 
-    Stack::Instance().attach(Stack::StackChanged, make_unique<StackUpdatedObserver>( ui ) );
+// snapshots named on the command line, loaded once the interface is set up and
+// saved when it closes, the journal that makes the session crash safe, and how the
+// undo history is kept: with versions of the stack, spilled to a file, or as a tree
+// of branches
+struct Snapshots
+{
+    string load;
+    string save;
+    string journal;
+    unsigned journalWindow = 50;
+    size_t checkpoint = 0;
+    bool versioned = false;
+    string historyFile;
+    size_t historyWindow = 10000;
+    bool branches = false;
+};
+
+// how long any one entry may run; zero is no limit
+struct Budget
+{
+    size_t steps = 0;
+    unsigned milliseconds = 0;
+};
+
+// how plugins are loaded: reloaded when their files change, and isolated in a
+// helper process, host
+struct Plugins
+{
+    bool reload = false;
+    bool isolate = false;
+    string host;
+};
+
+// pdCalcPluginHost, beside pdCalc, or on the path if pdCalc was found there
+string pluginHostExecutable(const string& pdCalc)
+{
+    const auto slash = pdCalc.find_last_of("/\\");
+    const string directory{ slash == string::npos ? "" : pdCalc.substr(0, slash + 1) };
+#ifdef WIN32
+    return directory + "pdCalcPluginHost.exe";
+#else
+    return directory + "pdCalcPluginHost";
+#endif
+}
+
+// registers the plugins linked into pdCalc, which load when plugins.pdp names them
+void registerStaticPlugins()
+{
+#ifdef STATIC_HYPERBOLICLNPLUGIN
+    RegisterHyperbolicLnPlugin();
+#endif
+#ifdef STATIC_STATISTICSPLUGIN
+    RegisterStatisticsPlugin();
+#endif
+#ifdef STATIC_MATRIXPLUGIN
+    RegisterMatrixPlugin();
+#endif
+#ifdef STATIC_FFTPLUGIN
+    RegisterFftPlugin();
+#endif
+#ifdef STATIC_RANDOMPLUGIN
+    RegisterRandomPlugin();
+#endif
+
+    return;
+}
+
+// the host isolated plugins run in, or null, in which case they run in pdCalc
+std::shared_ptr<PluginHost> startPluginHost(UserInterface& ui, const Plugins& plugins)
+{
+    if(!plugins.isolate) return nullptr;
+
+    try
+    {
+        return std::make_shared<PluginHost>(plugins.host);
+    }
+    catch(Exception& e)
+    {
+        ui.postMessage( e.what() + "; plugins run in pdCalc" );
+    }
+
+    return nullptr;
+}
+
+void loadSnapshot(UserInterface& ui, const Snapshots& snapshots)
+{
+    if( snapshots.load.empty() ) return;
+
+    try
+    {
+        RestoreStackSnapshot(snapshots.load);
+    }
+    catch(Exception& e)
+    {
+        ui.postMessage( e.what() );
+    }
+
+    return;
 }
 
-void registerCommand(UserInterface& ui, const string& label, CommandPtr c)
+// a recovered session takes the place of a loaded snapshot
+void startJournal(UserInterface& ui, CommandDispatcher& ce, const Snapshots& snapshots)
 {
+    if( snapshots.journal.empty() ) return;
+
     try
     {
-        CommandRepository::Instance().registerCommand(label, std::move(c));
+        ce.startJournal(snapshots.journal, snapshots.journalWindow, snapshots.checkpoint);
     }
     catch(Exception& e)
     {
@@ -149,29 +286,84 @@ void registerCommand(UserInterface& ui, const string& label, CommandPtr c)
     return;
 }
 
-set<string> setupPlugins(UserInterface& ui, PluginLoader& loader)
+void spillHistory(UserInterface& ui, CommandDispatcher& ce, const Snapshots& snapshots)
+{
+    if( snapshots.historyFile.empty() ) return;
+
+    try
+    {
+        ce.spillHistory(snapshots.historyFile, snapshots.historyWindow);
+    }
+    catch(Exception& e)
+    {
+        ui.postMessage( e.what() );
+    }
+
+    return;
+}
+
+void saveSnapshot(const Snapshots& snapshots)
+{
+    if( snapshots.save.empty() ) return;
+
+    try
+    {
+        SaveStackSnapshot(snapshots.save);
+    }
+    catch(Exception& e)
+    {
+        cerr << e.what() << endl;
+    }
+
+    return;
+}
+
+void setupUi(UserInterface& ui, CommandDispatcher& ce)
+{
+    RegisterCoreCommands(ui);
+
+    ui.attach(UserInterface::CommandEntered, make_unique<CommandIssuedObserver>( ce ) );
+}
+
+// the window hands its commands to the worker and stays responsive while they run
+void setupUi(MainWindow& gui, CommandWorker& worker)
+{
+    RegisterCoreCommands(gui);
+
+    gui.attach(UserInterface::CommandEntered, make_unique<CommandQueuedObserver>( worker ) );
+    gui.setCommandWorker(&worker);
+}
+
+// the interface follows the stack only once the session is restored, so that
+// replaying a journal does not redraw it per entry, and the budget applies to new
+// entries only
+void startSession(UserInterface& ui, CommandDispatcher& ce, const Snapshots& snapshots, const Budget& budget)
+{
+    loadSnapshot(ui, snapshots);
+    if(snapshots.versioned) ce.setVersionedHistory(true);
+    spillHistory(ui, ce, snapshots);
+    if(snapshots.branches) ce.keepBranches();
+    startJournal(ui, ce, snapshots);
+    ce.setBudget(budget.steps, budget.milliseconds);
+
+    Stack::Instance().attach(Stack::StackChanged, make_unique<StackUpdatedObserver>( ui ) );
+    if(Stack::Instance().size() > 0) ui.stackChanged();
+
+    return;
+}
+
+// with reloading, a plugin whose file changes is reloaded while pdCalc runs; its
+// buttons stay as they were
+void setupPlugins(UserInterface& ui, PluginLoader& loader, const Plugins& plugins)
 {
     // for now, I don't want to allow the plugin file to be a command
     // line option, so I simply code the name of the searched plugin file
     auto pluginFile = "plugins.pdp";
     loader.loadPlugins(ui, pluginFile);
-    auto plugins = loader.getPlugins();
-
-    set<string> injectedCommands;
-    for(auto p : plugins)
+    loader.registerCommands(ui);
+    for( auto p : loader.getPlugins() )
     {
-        auto apiVersion = p->apiVersion();
-        if(apiVersion.major != 1 || apiVersion.minor != 0)
-        {
-            ui.postMessage("Plugin API version is incompatible. Need v. 1.0.");
-            continue;
-        }
-        auto descriptor = p->getPluginDescriptor();
-        for(int i = 0; i < descriptor.nCommands; ++i)
-        {
-            registerCommand(ui, descriptor.commandNames[i], MakeCommandPtr(descriptor.commands[i]->clone()) );
-            injectedCommands.insert(descriptor.commandNames[i]);
-        }
+        if( !PluginLoader::Supported(*p) ) continue;
 
         // if gui, setup buttons
         auto mw = dynamic_cast<MainWindow*>(&ui);
@@ -206,10 +398,21 @@ set<string> setupPlugins(UserInterface& ui, PluginLoader& loader)
         }
     }
 
-    return injectedCommands;
+    if(!plugins.reload) return;
+
+    try
+    {
+        loader.watchPlugins(ui);
+    }
+    catch(Exception& e)
+    {
+        ui.postMessage( e.what() );
+    }
+
+    return;
 }
 
-void runGui(int argc, char* argv[])
+void runGui(int argc, char* argv[], const Snapshots& snapshots, const Budget& budget, const Plugins& plugins)
 try
 {
     QApplication app{argc, argv};
@@ -218,20 +421,28 @@ try
 
     // PluginLoader must be before CommandDispatcher so that memory on Command stack
     // is released before plugins are freed
-    PluginLoader loader;
+    PluginLoader loader{ startPluginHost(gui, plugins) };
     CommandDispatcher ce{gui};
 
-    setupUi(gui, ce);
-    set<string> injectedCommands{setupPlugins(gui, loader)};
+    // the session is restored before the worker takes its first command, and the
+    // worker is idle again before the stack is saved
+    CommandWorker worker{ce};
+
+    setupUi(gui, worker);
+    setupPlugins(gui, loader, plugins);
 
     gui.setupFinalButtons();
+    startSession(gui, ce, snapshots, budget);
     gui.show();
     gui.fixSize();
 
     app.exec();
+    worker.cancel();
+    worker.wait();
+    gui.setCommandWorker(nullptr);
+    saveSnapshot(snapshots);
 
-    for(auto i : injectedCommands)
-        CommandRepository::Instance().deregisterCommand(i);
+    loader.deregisterCommands();
 
     return;
 }
@@ -241,7 +452,8 @@ catch(Exception& e)
          << e.what() << endl;
 }
 
-void runBatch(const string& in, const string& out)
+void runBatch(const string& in, const string& out, const Snapshots& snapshots, const Budget& budget,
+    const Plugins& plugins)
 {
     BatchIo io{in, out};
 
@@ -249,37 +461,39 @@ void runBatch(const string& in, const string& out)
 
     // PluginLoader must be before CommandDispatcher so that memory on Command stack
     // is released before plugins are freed
-    PluginLoader loader;
+    PluginLoader loader{ startPluginHost(cli, plugins) };
     CommandDispatcher ce{cli};
 
     setupUi(cli, ce);
-    set<string> injectedCommands{setupPlugins(cli, loader)};
+    setupPlugins(cli, loader, plugins);
 
+    startSession(cli, ce, snapshots, budget);
     cli.execute(true, true);
+    saveSnapshot(snapshots);
 
-    for(auto i : injectedCommands)
-        CommandRepository::Instance().deregisterCommand(i);
+    loader.deregisterCommands();
 
     return;
 }
 
-void runCli()
+void runCli(const Snapshots& snapshots, const Budget& budget, const Plugins& plugins)
 try
 {
     Cli cli{cin, cout};
 
     // PluginLoader must be before CommandDispatcher so that memory on Command stack
     // is released before plugins are freed
-    PluginLoader loader;
+    PluginLoader loader{ startPluginHost(cli, plugins) };
     CommandDispatcher ce{cli};
 
     setupUi(cli, ce);
-    set<string> injectedCommands{setupPlugins(cli, loader)};
+    setupPlugins(cli, loader, plugins);
 
+    startSession(cli, ce, snapshots, budget);
     cli.execute();
+    saveSnapshot(snapshots);
 
-    for(auto i : injectedCommands)
-        CommandRepository::Instance().deregisterCommand(i);
+    loader.deregisterCommands();
 
     return;
 }  
@@ -297,22 +511,52 @@ catch(...)
 
 int main(int argc, char* argv[])
 {
-    if(argc == 1) runGui(argc, argv); // default
-    else if(argc == 2)
+    enum class Interface { Gui, Cli, Batch };
+    Interface ui{Interface::Gui}; // default
+    string in, out;
+    Snapshots snapshots;
+    Budget budget;
+    Plugins plugins;
+    plugins.host = pluginHostExecutable(argv[0]);
+
+    for(int i = 1; i < argc; ++i)
     {
-        string arg(argv[1]);
-        if(arg == "--gui" || arg == "-g") runGui(argc, argv);
-        else if(arg == "--cli" || arg == "-c") runCli();
+        string arg(argv[i]);
+        if(arg == "--gui" || arg == "-g") ui = Interface::Gui;
+        else if(arg == "--cli" || arg == "-c") ui = Interface::Cli;
+        else if( (arg == "--batch" || arg == "-b") && i + 1 < argc )
+        {
+            ui = Interface::Batch;
+            in = argv[++i];
+            if(i + 1 < argc && argv[i + 1][0] != '-') out = argv[++i];
+        }
+        else if(arg == "--load" && i + 1 < argc) snapshots.load = argv[++i];
+        else if(arg == "--save" && i + 1 < argc) snapshots.save = argv[++i];
+        else if(arg == "--versioned") snapshots.versioned = true;
+        else if(arg == "--history-file" && i + 1 < argc) snapshots.historyFile = argv[++i];
+        else if(arg == "--history-window" && i + 1 < argc) snapshots.historyWindow = parseCount(argv[++i]);
+        else if(arg == "--branches") snapshots.branches = true;
+        else if(arg == "--reload-plugins") plugins.reload = true;
+        else if(arg == "--isolate-plugins") plugins.isolate = true;
+        else if(arg == "--journal" && i + 1 < argc) snapshots.journal = argv[++i];
+        else if(arg == "--journal-window" && i + 1 < argc) snapshots.journalWindow = parseCount(argv[++i]);
+        else if(arg == "--checkpoint" && i + 1 < argc) snapshots.checkpoint = parseCount(argv[++i]);
+        else if(arg == "--budget-steps" && i + 1 < argc) budget.steps = parseCount(argv[++i]);
+        else if(arg == "--budget-ms" && i + 1 < argc) budget.milliseconds = parseCount(argv[++i]);
         else usage();
     }
-    else if(argc == 3 || argc == 4)
+
+    // a tree of history is kept in memory, so it cannot also be spilled
+    if( snapshots.branches && !snapshots.historyFile.empty() ) usage();
+
+    registerStaticPlugins();
+
+    switch(ui)
     {
-        string cmd(argv[1]);
-        string file(argv[2]);
-        if(cmd == "--batch" || cmd == "-b") runBatch(file, (argc == 4 ? argv[3] : "") );
-        else usage();
+    case Interface::Gui: runGui(argc, argv, snapshots, budget, plugins); break;
+    case Interface::Cli: runCli(snapshots, budget, plugins); break;
+    case Interface::Batch: runBatch(in, out, snapshots, budget, plugins); break;
     }
-    else usage();
 
     return 0;
 }
@@ -12,5 +12,13 @@ win32:CONFIG += console
 
 SOURCES += main.cpp
 
+# the plugins linked into pdCalc (see common.pri), ahead of the libraries they use
+for(plugin, STATIC_PLUGINS) {
+    unix:LIBS += -L$$HOME/lib -l$$plugin
+    win32:LIBS += -L$$HOME/bin -l$$plugin
+    DEFINES += STATIC_$$upper($$plugin)
+}
+!isEmpty(STATIC_PLUGINS): CONFIG += ltcg
+
 unix:LIBS += -L$$HOME/lib -lpdCalcGui -lpdCalcCli -lpdCalcBackend -lpdCalcUtilities
 win32:LIBS += -L$$HOME/bin -lpdCalcGui1 -lpdCalcCli1 -lpdCalcBackend1 -lpdCalcUtilities1
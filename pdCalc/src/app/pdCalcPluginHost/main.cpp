@@ -0,0 +1,34 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+// The helper process in which pdCalc runs plugins when it is started with
+// --isolate-plugins (see PluginHost). It is started by pdCalc, not by hand.
+
+#include <iostream>
+#include "backend/PluginHost.h"
+
+int main(int argc, char* argv[])
+{
+    if(argc != 2)
+    {
+        std::cerr << "pdCalcPluginHost is started by pdCalc to run its plugins" << std::endl;
+        return 2;
+    }
+
+    return pdCalc::PluginHost::Serve(argv[1]);
+}
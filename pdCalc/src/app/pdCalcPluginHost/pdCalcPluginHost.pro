@@ -0,0 +1,16 @@
+HOME = ../../..
+include ($$HOME/common.pri)
+TEMPLATE = app
+TARGET = pdCalcPluginHost
+DEPENDPATH += .
+INCLUDEPATH += $$HOME/src
+DESTDIR = $$HOME/bin
+
+QT -= gui core
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += main.cpp
+
+unix:LIBS += -L$$HOME/lib -lpdCalcBackend -lpdCalcUtilities
+win32:LIBS += -L$$HOME/bin -lpdCalcBackend1 -lpdCalcUtilities1
@@ -17,6 +17,7 @@
 // along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
 
 #include "AppObservers.h"
+#include "CommandWorker.h"
 #include "utilities/Exception.h"
 #include "ui/cli/Cli.h"
 #include "Stack.h"
@@ -51,14 +52,36 @@ void CommandIssuedObserver::notifyImpl(std::shared_ptr<EventData> eventData)
     return;
 }
 
+CommandQueuedObserver::CommandQueuedObserver(CommandWorker& worker)
+: Observer("CommandQueued")
+, worker_(worker)
+{ }
+
+void CommandQueuedObserver::notifyImpl(std::shared_ptr<EventData> eventData)
+{
+    auto data = dynamic_pointer_cast<CommandData>(eventData);
+    if(!data)
+    {
+        throw Exception("Could not convert CommandData to a command");
+    }
+    else
+    {
+        worker_.commandEntered( data->command() );
+    }
+
+    return;
+}
+
 StackUpdatedObserver::StackUpdatedObserver(UserInterface& ui)
 : Observer("StackUpdated")
 , ui_(ui)
 { }
 
-void StackUpdatedObserver::notifyImpl(std::shared_ptr<EventData>)
+void StackUpdatedObserver::notifyImpl(std::shared_ptr<EventData> eventData)
 {
-    ui_.stackChanged();
+    auto data = dynamic_pointer_cast<StackChangedData>(eventData);
+    if(data) ui_.stackChangedBy( data->change() );
+    else ui_.stackChanged();
 
     return;
 }
@@ -25,6 +25,7 @@
 namespace pdCalc {
 
 class UserInterface;
+class CommandWorker;
 
 class CommandIssuedObserver : public Observer
 {
@@ -37,6 +38,18 @@ private:
     CommandDispatcher& ce_;
 };
 
+// hands commands to a worker rather than running them as they are issued
+class CommandQueuedObserver : public Observer
+{
+public:
+    explicit CommandQueuedObserver(CommandWorker& worker);
+
+private:
+    void notifyImpl(std::shared_ptr<EventData>) override;
+
+    CommandWorker& worker_;
+};
+
 class StackUpdatedObserver : public Observer
 {
 public:
@@ -0,0 +1,50 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef APPEND_FILE_H
+#define APPEND_FILE_H
+
+// This is the base class to abstract OS specific durable appends to a file. Data
+// written is only guaranteed to survive a crash of the process or the machine once
+// sync has returned, which POSIX systems do with fdatasync and Windows with
+// FlushFileBuffers.
+
+#include <cstddef>
+
+namespace pdCalc {
+
+class AppendFile
+{
+public:
+    virtual ~AppendFile();
+
+    // appends n bytes at the end of the file; throws Exception on failure
+    virtual void write(const char* data, size_t n) = 0;
+
+    // returns once everything written has reached the disk; throws Exception on
+    // failure
+    virtual void sync() = 0;
+
+    // discards everything from size on, so that the next write lands there; throws
+    // Exception on failure
+    virtual void truncate(size_t size) = 0;
+};
+
+}
+
+#endif
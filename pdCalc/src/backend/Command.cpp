@@ -19,9 +19,54 @@
 #include "Command.h"
 #include "Stack.h"
 #include "utilities/Exception.h"
+#include "utilities/BigNumber.h"
+#include <cmath>
 
 namespace pdCalc {
 
+namespace {
+
+using ExactValue = Stack::ExactValue;
+
+// an operand's exact value: its own, or else its double, which is exact unless it
+// is an infinity or NaN
+ExactValue ExactOperand(double d, const ExactValue& exact)
+{
+    if( exact || !std::isfinite(d) ) return exact;
+    else return std::make_shared<const BigFloat>( BigFloat::FromDouble(d) );
+}
+
+// the exact result of op in exact mode; null when exact mode is off, an operand has
+// no exact value, op declines or runs out of memory, and the double result stands
+template<typename Op>
+ExactValue ExactResult(Op op, double top, const ExactValue& topExact, double next = 0, const ExactValue& nextExact = nullptr) noexcept
+{
+    const unsigned digits{ Stack::Instance().precision() };
+    if(digits == 0) return nullptr;
+
+    try
+    {
+        auto t = ExactOperand(top, topExact);
+        auto n = ExactOperand(next, nextExact);
+        return t && n ? op(*n, *t, digits) : nullptr;
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+// pushes a result, whose double is the exact value's nearest when it has one
+void PushResult(double d, const ExactValue& exact)
+{
+    if(exact) Stack::Instance().push(exact->toDouble(), exact);
+    else Stack::Instance().push(d);
+
+    return;
+}
+
+}
+
 void Command::execute()
 {
     checkPreconditionsImpl();
@@ -59,6 +104,8 @@ BinaryCommand::BinaryCommand(const BinaryCommand& rhs)
 : Command(rhs)
 , top_{rhs.top_}
 , next_{rhs.next_}
+, topExact_{rhs.topExact_}
+, nextExact_{rhs.nextExact_}
 { }
 
 BinaryCommand::~BinaryCommand()
@@ -70,12 +117,19 @@ void BinaryCommand::checkPreconditionsImpl() const
         throw Exception{"Stack must have 2 elements"};
 }
 
-void BinaryCommand::executeImpl() noexcept
+void BinaryCommand::popOperands() noexcept
 {
     // suppress change signal so only one event raised for the execute
-    top_ = Stack::Instance().pop(true);
-    next_ = Stack::Instance().pop(true);
-    Stack::Instance().push( binaryOperation(next_, top_) );
+    top_ = Stack::Instance().pop(topExact_, true);
+    next_ = Stack::Instance().pop(nextExact_, true);
+
+    return;
+}
+
+void BinaryCommand::pushResult(double d, ExactOperation* exactOp) noexcept
+{
+    auto exact = exactOp ? ExactResult(exactOp, top_, topExact_, next_, nextExact_) : nullptr;
+    PushResult(d, exact);
 
     return;
 }
@@ -84,8 +138,8 @@ void BinaryCommand::undoImpl() noexcept
 {
     // suppress change signal so only one event raised for the execute
     Stack::Instance().pop(true);
-    Stack::Instance().push(next_, true);
-    Stack::Instance().push(top_);
+    Stack::Instance().push(next_, nextExact_, true);
+    Stack::Instance().push(top_, topExact_);
 
     return;
 }
@@ -93,6 +147,7 @@ void BinaryCommand::undoImpl() noexcept
 UnaryCommand::UnaryCommand(const UnaryCommand& rhs)
 : Command(rhs)
 , top_(rhs.top_)
+, topExact_(rhs.topExact_)
 {
 }
 
@@ -105,11 +160,19 @@ void UnaryCommand::checkPreconditionsImpl() const
         throw Exception{"Stack must have one element"};
 }
 
-void UnaryCommand::executeImpl() noexcept
+void UnaryCommand::popOperand() noexcept
 {
     // suppress change signal so only one event raised for the execute
-    top_ = Stack::Instance().pop(true);
-    Stack::Instance().push( unaryOperation(top_) );
+    top_ = Stack::Instance().pop(topExact_, true);
+
+    return;
+}
+
+void UnaryCommand::pushResult(double d, ExactOperation* exactOp) noexcept
+{
+    auto exact = exactOp ? ExactResult([exactOp](const BigFloat&, const BigFloat& top, unsigned digits)
+        { return exactOp(top, digits); }, top_, topExact_) : nullptr;
+    PushResult(d, exact);
 
     return;
 }
@@ -118,7 +181,7 @@ void UnaryCommand::undoImpl() noexcept
 {
     // suppress change signal so only one event raised for the execute
     Stack::Instance().pop(true);
-    Stack::Instance().push(top_);
+    Stack::Instance().push(top_, topExact_);
 
     return;
 }
@@ -141,54 +204,4 @@ PluginCommand *PluginCommand::cloneImpl() const
     else return p;
 }
 
-BinaryCommandAlternative::BinaryCommandAlternative(const std::string& help, std::function<BinaryCommandAlternative::BinaryCommandOp> f)
-: helpMsg_{help}
-, command_{f}
-{ }
-
-void BinaryCommandAlternative::checkPreconditionsImpl() const
-{
-    if( Stack::Instance().size() < 2 )
-        throw Exception{"Stack must have 2 elements"};
-}
-
-BinaryCommandAlternative::BinaryCommandAlternative(const BinaryCommandAlternative& rhs)
-: Command{rhs}
-, top_{rhs.top_}
-, next_{rhs.next_}
-, helpMsg_{rhs.helpMsg_}
-, command_{rhs.command_}
-{ }
-
-const char *BinaryCommandAlternative::helpMessageImpl() const noexcept
-{
-    return helpMsg_.c_str();
-}
-
-BinaryCommandAlternative* BinaryCommandAlternative::cloneImpl() const
-{
-    return new BinaryCommandAlternative{*this};
-}
-
-void BinaryCommandAlternative::executeImpl() noexcept
-{
-    // suppress change signal so only one event raised for the execute
-    top_ = Stack::Instance().pop(true);
-    next_ = Stack::Instance().pop(true);
-    Stack::Instance().push( command_(next_, top_) );
-
-    return;
-}
-
-void BinaryCommandAlternative::undoImpl() noexcept
-{
-    // suppress change signal so only one event raised for the execute
-    Stack::Instance().pop(true);
-    Stack::Instance().push(next_, true);
-    Stack::Instance().push(top_);
-
-    return;
-}
-
-
 }
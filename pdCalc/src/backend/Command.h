@@ -21,10 +21,12 @@
 
 #include <string>
 #include <memory>
-#include <functional>
 
 namespace pdCalc {
 
+class BigFloat;
+class LibraryCommand;
+
 class Command
 {
 public:
@@ -65,6 +67,9 @@ private:
     Command(Command&&) = delete;
     Command& operator=(const Command&) = delete;
     Command& operator=(Command&&) = delete;
+
+    // stands in for a plugin's command, forwarding to it (see PluginLoader)
+    friend class LibraryCommand;
 };
 
 // Base class for binary operations: take two elements from stack and return
@@ -73,69 +78,83 @@ private:
 // Precondition: Binary operations must have at least two elements
 // on the stack
 // The reason to have a binary operations class is because undo,
-// redo, and preconditions can be implemented identically
+// redo, and preconditions can be implemented identically. The operations
+// themselves are generated from it by BinaryOperation (see CoreCommands.h).
 class BinaryCommand : public Command
 {
 public:
     virtual ~BinaryCommand();
 
 protected:
+    // In exact mode, the operation on the operands' exact values, carried to digits
+    // significant digits. Returning null leaves the double result without an exact
+    // value.
+    using ExactOperation = std::shared_ptr<const BigFloat>(const BigFloat& next,
+        const BigFloat& top, unsigned digits);
+
     // throws an exception if the stack size is less than two
     void checkPreconditionsImpl() const override;
 
     BinaryCommand() { }
     BinaryCommand(const BinaryCommand&);
 
+    // the two halves of an execute: popOperands takes the two elements from the
+    // stack into top_ and next_, and pushResult returns d to the stack, or in exact
+    // mode, the result of exactOp, if it is not null and does not decline
+    void popOperands() noexcept;
+    void pushResult(double d, ExactOperation* exactOp) noexcept;
+
+    double top_;
+    double next_;
+
 private:
     BinaryCommand(BinaryCommand&&) = delete;
     BinaryCommand& operator=(const BinaryCommand&) = delete;
     BinaryCommand& operator=(BinaryCommand&&) = delete;
 
-    // takes two elements from the stack, applies the binary operation
-    // and returns the result to the stack
-    void executeImpl() noexcept override;
-
     // drops the result and returns the original two numbers to the stack
     void undoImpl() noexcept override;
 
-    virtual double binaryOperation(double next, double top) const noexcept = 0;
-
-    double top_;
-    double next_;
+    std::shared_ptr<const BigFloat> topExact_;
+    std::shared_ptr<const BigFloat> nextExact_;
 };
 
 // Base class for unary operations: take one element from the stack and return
 // one result.
 // Precondition: Unary operations must have at least one element on the stack.
 // The reason to have a unary operations class is to avoid repetition for
-// all classes implementing a unary interface.
+// all classes implementing a unary interface. The operations themselves are
+// generated from it by UnaryOperation (see CoreCommands.h).
 class UnaryCommand : public Command
 {
 public:
     virtual ~UnaryCommand();
 
 protected:
+    // the exact mode counterpart of the operation, as for BinaryCommand
+    using ExactOperation = std::shared_ptr<const BigFloat>(const BigFloat& top, unsigned digits);
+
     // throws an exception if the stack size is less than one
     void checkPreconditionsImpl() const override;
 
     UnaryCommand() { }
     UnaryCommand(const UnaryCommand&);
 
+    // the two halves of an execute, as for BinaryCommand
+    void popOperand() noexcept;
+    void pushResult(double d, ExactOperation* exactOp) noexcept;
+
+    double top_;
+
 private:
     UnaryCommand(UnaryCommand&&) = delete;
     UnaryCommand& operator=(const UnaryCommand&) = delete;
     UnaryCommand& operator=(UnaryCommand&&) = delete;
 
-    // takes one element from the stack, applies the binary operation
-    // and returns the result to teh stack
-    void executeImpl() noexcept override;
-
     // drops the result and returns the original number to the stack
     void undoImpl() noexcept override;
 
-    virtual double unaryOperation(double top) const noexcept = 0;
-
-    double top_;
+    std::shared_ptr<const BigFloat> topExact_;
 };
 
 class PluginCommand : public Command
@@ -151,41 +170,6 @@ private:
     PluginCommand* cloneImpl() const override final;
 };
 
-// This shows an entirely different design using function and lambdas.
-class BinaryCommandAlternative final : public Command
-{
-    using BinaryCommandOp = double(double, double);
-public:
-    BinaryCommandAlternative(const std::string& help, std::function<BinaryCommandOp> f);
-    ~BinaryCommandAlternative() = default;
-
-private:
-    BinaryCommandAlternative(BinaryCommandAlternative&&) = delete;
-    BinaryCommandAlternative& operator=(const BinaryCommandAlternative&) = delete;
-    BinaryCommandAlternative& operator=(BinaryCommandAlternative&&) = delete;
-
-    // throws an exception if the stack size is less than two
-    void checkPreconditionsImpl() const override;
-
-    BinaryCommandAlternative(const BinaryCommandAlternative&);
-
-    const char* helpMessageImpl() const noexcept override;
-
-    // takes two elements from the stack, applies the binary operation
-    // and returns the result to the stack
-    void executeImpl() noexcept override;
-
-    // drops the result and returns the original two numbers to the stack
-    void undoImpl() noexcept override;
-
-    BinaryCommandAlternative* cloneImpl() const override;
-
-    double top_;
-    double next_;
-    std::string helpMsg_;
-    std::function<BinaryCommandOp> command_;
-};
-
 inline void CommandDeleter(Command* p)
 {
     p->deallocate();
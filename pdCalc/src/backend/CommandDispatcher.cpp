@@ -22,13 +22,19 @@
 #include "CoreCommands.h"
 #include "utilities/Exception.h"
 #include <sstream>
-#include <regex>
 #include <cassert>
 #include <algorithm>
 #include "utilities/UserInterface.h"
 #include <fstream>
 #include "utilities/Tokenizer.h"
 #include "StoredProcedure.h"
+#include "MapProcedure.h"
+#include "StackSnapshot.h"
+#include "Journal.h"
+#include "ImportNumbers.h"
+#include "Stack.h"
+#include "utilities/BigNumber.h"
+#include "utilities/CancellationToken.h"
 
 using std::string;
 using std::ostringstream;
@@ -38,44 +44,113 @@ using std::istringstream;
 
 namespace pdCalc {
 
+namespace {
+
+// the count of an entry such as undo:3, which must be a positive integer
+bool toCount(const string& s, size_t& n)
+{
+    if( s.empty() || s.size() > 9 || !std::all_of( s.begin(), s.end(), [](char c){ return c >= '0' && c <= '9'; } ) )
+        return false;
+
+    n = std::stoul(s);
+    return n > 0;
+}
+
+}
+
 class CommandDispatcher::CommandDispatcherImpl
 {
 public:
-    explicit CommandDispatcherImpl(UserInterface& ui);
+    CommandDispatcherImpl(UserInterface& ui, CancellationToken* token);
 
     void executeCommand(const string& command);
-
+    void startJournal(const string& filename, unsigned windowMilliseconds, size_t checkpointEntries);
+    void setBudget(size_t steps, unsigned milliseconds);
+    void setVersionedHistory(bool versioned);
+    void spillHistory(const string& filename, size_t window);
+    void keepBranches();
+    CancellationToken& cancellationToken() { return token_; }
 
 private:
+    bool undoRedo(const string& count, bool undo);
+    bool undoRedo(size_t n, bool undo);
+    bool switchBranch(const string& branch);
+    void printBranches() const;
     bool isNum(const string&, double& d);
-    void handleCommand(CommandPtr command);
+    bool enterNumber(const string&, double d);
+    bool handleCommand(CommandPtr command);
     void printHelp() const;
+    void saveSnapshot(const string& filename);
+    void journal(const string& command, bool isNumber, double d);
+    void checkpoint();
 
     CommandManager manager_;
     UserInterface& ui_;
+
+    std::unique_ptr<Journal> journal_;
+    string journalFile_;
+    size_t checkpointEntries_;
+    size_t sinceCheckpoint_;
+
+    // the dispatcher's own token, unless it runs a procedure's commands
+    CancellationToken ownToken_;
+    CancellationToken& token_;
+    bool nested_;
 };
 
-CommandDispatcher::CommandDispatcherImpl::CommandDispatcherImpl(UserInterface& ui)
+CommandDispatcher::CommandDispatcherImpl::CommandDispatcherImpl(UserInterface& ui, CancellationToken* token)
 : ui_(ui)
+, checkpointEntries_{0}
+, sinceCheckpoint_{0}
+, token_(token ? *token : ownToken_)
+, nested_{token != nullptr}
 { }
 
 void CommandDispatcher::CommandDispatcherImpl::executeCommand(const string& command)
 {
+    // a procedure's commands are steps of the entry that called it
+    if(!nested_) token_.restart();
+
     // entry of a number simply goes onto the the stack
     double d;
-    if( isNum(command, d) )
-        manager_.executeCommand(MakeCommandPtr<EnterNumber>(d));
+    const bool isNumber{ isNum(command, d) };
+
+    // whether the entry changed the stack or its history, and so is journaled
+    bool changed{false};
+    if(isNumber)
+        changed = enterNumber(command, d);
     else if(command == "undo")
-        manager_.undo();
+        changed = undoRedo(1, true);
     else if(command == "redo")
-        manager_.redo();
+        changed = undoRedo(1, false);
+    else if(command.size() > 5 && command.compare(0, 5, "undo:") == 0)
+        changed = undoRedo(command.substr(5), true);
+    else if(command.size() > 5 && command.compare(0, 5, "redo:") == 0)
+        changed = undoRedo(command.substr(5), false);
+    else if(command == "branches")
+        printBranches();
+    else if(command.size() > 7 && command.compare(0, 7, "branch:") == 0)
+        changed = switchBranch( command.substr(7) );
     else if(command == "help")
         printHelp();
-    else if(command.size() > 6 && command.substr(0, 5) == "proc:")
+    else if(command.size() > 6 && command.compare(0, 5, "proc:") == 0)
     {
         auto filename = command.substr(5, command.size() - 5);
-        handleCommand( MakeCommandPtr<StoredProcedure>(ui_, filename) );
+        changed = handleCommand( MakeCommandPtr<StoredProcedure>(ui_, filename, &token_) );
+    }
+    else if(command.size() > 5 && command.compare(0, 4, "map:") == 0)
+    {
+        auto filename = command.substr(4, command.size() - 4);
+        changed = handleCommand( MakeCommandPtr<MapProcedure>(filename, &token_) );
     }
+    else if(command.size() > 6 && command.compare(0, 5, "save:") == 0)
+        saveSnapshot( command.substr(5) );
+    else if(command.size() > 6 && command.compare(0, 5, "load:") == 0)
+        changed = handleCommand( MakeCommandPtr<LoadSnapshot>( command.substr(5) ) );
+    else if(command.size() > 8 && command.compare(0, 7, "import:") == 0)
+        changed = handleCommand( MakeCommandPtr<ImportNumbers>( command.substr(7), ImportNumbers::Format::Text ) );
+    else if(command.size() > 11 && command.compare(0, 10, "importbin:") == 0)
+        changed = handleCommand( MakeCommandPtr<ImportNumbers>( command.substr(10), ImportNumbers::Format::Binary ) );
     else
     {
         auto c = CommandRepository::Instance().allocateCommand(command);
@@ -85,17 +160,207 @@ void CommandDispatcher::CommandDispatcherImpl::executeCommand(const string& comm
             oss << "Command " << command << " is not a known command";
             ui_.postMessage( oss.str() );
         }
-        else handleCommand( std::move(c) );
+        else changed = handleCommand( std::move(c) );
+    }
+
+    if(changed && journal_) journal(command, isNumber, d);
+
+    return;
+}
+
+void CommandDispatcher::CommandDispatcherImpl::startJournal(const string& filename, unsigned windowMilliseconds,
+    size_t checkpointEntries)
+{
+    journal_.reset();
+    journalFile_ = filename;
+    checkpointEntries_ = checkpointEntries;
+
+    // the checkpoint's tag is the generation of the journal that continues from it;
+    // a journal of another generation was already folded into a later checkpoint
+    uint64_t generation{0};
+    const string snapshot{filename + ".pss"};
+    if( std::ifstream{snapshot} )
+    {
+        try
+        {
+            generation = RestoreStackSnapshot(snapshot);
+        }
+        catch(Exception& e)
+        {
+            ui_.postMessage( e.what() );
+        }
+    }
+
+    // replayed entries run as they did originally, numbers included, so the undo
+    // history is rebuilt along with the stack; they count toward the next checkpoint
+    sinceCheckpoint_ = Journal::Replay(filename, generation,
+        [this](double d){ manager_.executeCommand( MakeCommandPtr<EnterNumber>(d) ); },
+        [this](const string& token){ executeCommand(token); });
+
+    journal_ = std::make_unique<Journal>(filename, generation, windowMilliseconds);
+
+    return;
+}
+
+// numbers are journaled as doubles unless exact mode needs their text
+void CommandDispatcher::CommandDispatcherImpl::journal(const string& command, bool isNumber, double d)
+{
+    try
+    {
+        if( isNumber && Stack::Instance().precision() == 0 )
+            journal_->recordNumber(d);
+        else
+            journal_->recordToken(command);
+
+        if(checkpointEntries_ > 0 && ++sinceCheckpoint_ >= checkpointEntries_)
+            checkpoint();
+    }
+    catch(Exception& e)
+    {
+        // a journal that cannot be written is abandoned, not retried per entry
+        journal_.reset();
+        ui_.postMessage( e.what() );
+    }
+
+    return;
+}
+
+// the snapshot is written before the journal restarts, so a crash between the two
+// recovers from the new snapshot and ignores the old journal by its generation
+void CommandDispatcher::CommandDispatcherImpl::checkpoint()
+{
+    const uint64_t generation{ journal_->generation() + 1 };
+    SaveStackSnapshot(journalFile_ + ".pss", generation);
+    journal_->restart(generation);
+    manager_.clear();
+    sinceCheckpoint_ = 0;
+
+    return;
+}
+
+// in exact mode, the number also keeps its decimal value to the current precision
+bool CommandDispatcher::CommandDispatcherImpl::enterNumber(const string& s, double d)
+{
+    const unsigned digits{ Stack::Instance().precision() };
+
+    try
+    {
+        if(digits == 0)
+            manager_.executeCommand( MakeCommandPtr<EnterNumber>(d), &token_ );
+        else
+        {
+            auto exact = std::make_shared<const BigFloat>( BigFloat::FromString(s, digits) );
+            manager_.executeCommand( MakeCommandPtr<EnterNumber>(exact->toDouble(), exact), &token_ );
+        }
+    }
+    catch(Exception& e)
+    {
+        if( !nested_ || !token_.stopped() ) ui_.postMessage( e.what() );
+        return false;
+    }
+
+    return true;
+}
+
+bool CommandDispatcher::CommandDispatcherImpl::handleCommand(CommandPtr c)
+{
+    try
+    {
+        manager_.executeCommand( std::move(c), &token_ );
+    }
+    catch(Exception& e)
+    {
+        if( !nested_ || !token_.stopped() ) ui_.postMessage( e.what() );
+        return false;
+    }
+
+    return true;
+}
+
+bool CommandDispatcher::CommandDispatcherImpl::undoRedo(const string& count, bool undo)
+{
+    size_t n;
+    if( !toCount(count, n) )
+    {
+        ui_.postMessage( (undo ? "undo: " : "redo: ") + count + " is not a positive count" );
+        return false;
+    }
+
+    return undoRedo(n, undo);
+}
+
+// Spilled history is read back from disk, which can fail partway. The entry is
+// then not journaled as it was typed, since replaying it would take every step,
+// but as the steps that were taken, if any.
+bool CommandDispatcher::CommandDispatcherImpl::undoRedo(size_t n, bool undo)
+{
+    const size_t available{ undo ? manager_.getUndoSize() : manager_.getRedoSize() };
+    if(available == 0) return false;
+
+    try
+    {
+        if(undo) manager_.undo(n);
+        else manager_.redo(n);
     }
+    catch(Exception& e)
+    {
+        ui_.postMessage( e.what() );
+
+        const size_t left{ undo ? manager_.getUndoSize() : manager_.getRedoSize() };
+        if(journal_ && left < available)
+            journal( (undo ? "undo:" : "redo:") + std::to_string(available - left), false, 0 );
+
+        return false;
+    }
+
+    return true;
+}
+
+// branches are numbered from 1 for the user
+bool CommandDispatcher::CommandDispatcherImpl::switchBranch(const string& branch)
+{
+    size_t n;
+    if( !toCount(branch, n) || n > manager_.branches().size() )
+    {
+        ui_.postMessage( "branch: " + branch + " is not a branch of the undo history" );
+        return false;
+    }
+
+    manager_.switchBranch(n - 1);
+
+    return true;
+}
+
+void CommandDispatcher::CommandDispatcherImpl::printBranches() const
+{
+    auto branches = manager_.branches();
+    if( branches.empty() )
+    {
+        ui_.postMessage("The undo history has no branches");
+        return;
+    }
+
+    ostringstream oss;
+    for(size_t i = 0; i < branches.size(); ++i)
+    {
+        const auto& b = branches[i];
+        oss << (i == manager_.currentBranch() ? "* " : "  ") << "branch " << i + 1 << ": "
+            << b.commands << " entries, forked after " << b.fork << ", "
+            << b.ownBytes << " bytes own, " << b.sharedBytes << " bytes shared";
+        if(i + 1 < branches.size()) oss << "\n";
+    }
+
+    ui_.postMessage( oss.str() );
 
     return;
 }
 
-void CommandDispatcher::CommandDispatcherImpl::handleCommand(CommandPtr c)
+// saving leaves the stack alone, so it is not a command and cannot be undone
+void CommandDispatcher::CommandDispatcherImpl::saveSnapshot(const string& filename)
 {
     try
     {
-        manager_.executeCommand( std::move(c) );
+        SaveStackSnapshot(filename);
     }
     catch(Exception& e)
     {
@@ -111,7 +376,11 @@ void CommandDispatcher::CommandDispatcherImpl::printHelp() const
     set<string> allCommands = CommandRepository::Instance().getAllCommandNames();
     oss << "\n";
     oss << "undo: undo last operation\n"
-        << "redo: redo last operation\n";
+        << "redo: redo last operation\n"
+        << "undo:n: undo the last n operations\n"
+        << "redo:n: redo the last n operations\n"
+        << "branches: list the branches of the undo history\n"
+        << "branch:n: switch to the end of branch n of the undo history\n";
 
     for(auto i : allCommands)
     {
@@ -123,33 +392,102 @@ void CommandDispatcher::CommandDispatcherImpl::printHelp() const
 
 }
 
-// uses a C++11 regular expression to check if this is a valid double number
-// if so, converts it into one and returns it
+// if s is a number, converts it into one and returns it
 bool CommandDispatcher::CommandDispatcherImpl::isNum(const string& s, double& d)
 {
-     if(s == "+" || s == "-") return false;
+    return TokenIsNumber(s, d);
+}
+
+void CommandDispatcher::commandEntered(const std::string& command)
+{
+    pimpl_->executeCommand(command);
 
-     std::regex dpRegex("((\\+|-)?[[:digit:]]*)(\\.(([[:digit:]]+)?))?((e|E)((\\+|-)?)[[:digit:]]+)?");
-     bool isNumber{ std::regex_match(s, dpRegex) };
+    return;
+}
 
-     if(isNumber)
-     {
-         d = std::stod(s);
-     }
+void CommandDispatcher::startJournal(const std::string& filename, unsigned windowMilliseconds,
+    size_t checkpointEntries)
+{
+    pimpl_->startJournal(filename, windowMilliseconds, checkpointEntries);
 
-     return isNumber;
+    return;
 }
 
-void CommandDispatcher::commandEntered(const std::string& command)
+void CommandDispatcher::CommandDispatcherImpl::setBudget(size_t steps, unsigned milliseconds)
 {
-    pimpl_->executeCommand(command);
+    token_.setBudget( steps, std::chrono::milliseconds{milliseconds} );
 
     return;
 }
 
+void CommandDispatcher::setBudget(size_t steps, unsigned milliseconds)
+{
+    pimpl_->setBudget(steps, milliseconds);
+
+    return;
+}
+
+// The manager's versions are only cheap to keep if the stack is persistent, and
+// a persistent stack costs every change, so it is persistent only while the
+// manager keeps versions; a manager keeping deltas never does.
+void CommandDispatcher::CommandDispatcherImpl::setVersionedHistory(bool versioned)
+{
+    manager_.setVersioned(versioned);
+    Stack::Instance().setPersistent( manager_.versioned() );
+
+    return;
+}
+
+void CommandDispatcher::CommandDispatcherImpl::spillHistory(const string& filename, size_t window)
+{
+    manager_.spillHistory(filename, window);
+    Stack::Instance().setPersistent( manager_.versioned() );
+
+    return;
+}
+
+void CommandDispatcher::CommandDispatcherImpl::keepBranches()
+{
+    manager_.keepBranches();
+    Stack::Instance().setPersistent( manager_.versioned() );
+
+    return;
+}
+
+void CommandDispatcher::keepBranches()
+{
+    pimpl_->keepBranches();
+
+    return;
+}
+
+void CommandDispatcher::spillHistory(const std::string& filename, size_t window)
+{
+    pimpl_->spillHistory(filename, window);
+
+    return;
+}
+
+void CommandDispatcher::setVersionedHistory(bool versioned)
+{
+    pimpl_->setVersionedHistory(versioned);
+
+    return;
+}
+
+CancellationToken& CommandDispatcher::cancellationToken()
+{
+    return pimpl_->cancellationToken();
+}
+
 CommandDispatcher::CommandDispatcher(UserInterface& ui)
 {
-    pimpl_ = std::make_unique<CommandDispatcherImpl>(ui);
+    pimpl_ = std::make_unique<CommandDispatcherImpl>(ui, nullptr);
+}
+
+CommandDispatcher::CommandDispatcher(UserInterface& ui, CancellationToken& token)
+{
+    pimpl_ = std::make_unique<CommandDispatcherImpl>(ui, &token);
 }
 
 CommandDispatcher::~CommandDispatcher()
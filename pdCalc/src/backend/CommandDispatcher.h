@@ -27,6 +27,7 @@
 namespace pdCalc {
 
 class UserInterface;
+class CancellationToken;
 
 class CommandDispatcher
 {
@@ -34,10 +35,53 @@ class CommandDispatcher
 
 public:
     explicit CommandDispatcher(UserInterface& ui);
+
+    // A dispatcher for the commands of a procedure, which run as steps of the entry
+    // that called the procedure, under its token. An entry the token stops is undone
+    // without a message, since the caller reports it.
+    CommandDispatcher(UserInterface& ui, CancellationToken& token);
     ~CommandDispatcher();
 
     void commandEntered(const std::string& command);
 
+    // Recovers the session journaled to filename, if any, and journals every entry
+    // from now on. Recovery restores the checkpoint snapshot, filename.pss, and
+    // replays the journal recorded after it, which rebuilds the undo history back to
+    // the checkpoint. Entries become durable in batches once per window, so a crash
+    // loses at most the last window of work. Every checkpointEntries entries (never
+    // if 0), the stack is saved to a new checkpoint, the journal is emptied, and the
+    // undo history is cleared, since a recovered session could not undo past the
+    // checkpoint. Throws Exception if the journal cannot be written.
+    void startJournal(const std::string& filename, unsigned windowMilliseconds, size_t checkpointEntries);
+
+    // Every entry from now on may take at most steps steps, the commands and control
+    // flow of the procedures it runs included, and at most milliseconds; zero is no
+    // limit. An entry that exceeds its budget is undone, leaving the stack and the undo
+    // history as they were before it, and the interface is told why.
+    void setBudget(size_t steps, unsigned milliseconds);
+
+    // With versioned history, each entry keeps the versions of the stack around it in
+    // place of its commands, and the stack is made persistent, so undo:n and redo:n
+    // jump n entries in time proportional to how much the stack differs rather than
+    // to n. Changing this setting clears the undo history.
+    void setVersionedHistory(bool versioned);
+
+    // Keeps only the window most recent entries of the undo history in memory and
+    // spills older ones to filename, from which undo reads them back (see
+    // CommandManager::spillHistory). This clears the undo history, and throws
+    // Exception if filename cannot be written.
+    void spillHistory(const std::string& filename, size_t window);
+
+    // Keeps every branch of the undo history (see CommandManager::keepBranches): an
+    // entry after undo starts a new branch instead of discarding what was undone.
+    // branches then lists them, with the memory each takes, and branch:n switches to
+    // the end of branch n. This clears the undo history.
+    void keepBranches();
+
+    // lets another thread cancel the running entry, with the same effect as running
+    // out of budget
+    CancellationToken& cancellationToken();
+
 private:
     CommandDispatcher(const CommandDispatcher&) = delete;
     CommandDispatcher(CommandDispatcher&&) = delete;
@@ -20,27 +20,129 @@
 #include <stack>
 #include <vector>
 #include <list>
+#include <deque>
+#include <algorithm>
 #include "Command.h"
+#include "Stack.h"
+#include "SpilledHistory.h"
+#include "utilities/CancellationToken.h"
+#include "utilities/Exception.h"
 
 using std::unique_ptr;
 using std::make_unique;
 using std::stack;
 using std::vector;
 using std::list;
+using std::deque;
+using std::string;
 
 namespace pdCalc {
 
+namespace {
+
+// stands in for a command that has executed, as the versions of the stack around it
+class VersionedCommand : public Command
+{
+public:
+    VersionedCommand(StackVersion before, StackVersion after)
+    : before_{ std::move(before) }, after_{ std::move(after) }
+    { }
+
+private:
+    VersionedCommand(const VersionedCommand&) = delete;
+    VersionedCommand(VersionedCommand&&) = delete;
+    VersionedCommand& operator=(const VersionedCommand&) = delete;
+    VersionedCommand& operator=(VersionedCommand&&) = delete;
+
+    void executeImpl() noexcept override { Stack::Instance().checkout(after_); }
+    void undoImpl() noexcept override { Stack::Instance().checkout(before_); }
+    Command* cloneImpl() const noexcept override { return nullptr; }
+    const char* helpMessageImpl() const noexcept override { return "Restores a version of the stack"; }
+
+    StackVersion before_;
+    StackVersion after_;
+};
+
+// stands in for a command that has executed, as the change it made to the stack
+class DeltaCommand : public Command
+{
+public:
+    explicit DeltaCommand(StackDelta d) : delta_{ std::move(d) } { }
+
+    const StackDelta& delta() const { return delta_; }
+    StackDelta& delta() { return delta_; }
+
+private:
+    DeltaCommand(const DeltaCommand&) = delete;
+    DeltaCommand(DeltaCommand&&) = delete;
+    DeltaCommand& operator=(const DeltaCommand&) = delete;
+    DeltaCommand& operator=(DeltaCommand&&) = delete;
+
+    void executeImpl() noexcept override { Stack::Instance().applyDelta(delta_, true); }
+    void undoImpl() noexcept override { Stack::Instance().applyDelta(delta_, false); }
+    Command* cloneImpl() const noexcept override { return nullptr; }
+    const char* helpMessageImpl() const noexcept override { return "Reapplies a change to the stack"; }
+
+    StackDelta delta_;
+};
+
+// records a delta of the stack while a command runs, ending the recording however
+// the command finishes
+class DeltaRecording
+{
+public:
+    explicit DeltaRecording(bool on) : on_{on} { if(on_) Stack::Instance().beginDelta(); }
+    ~DeltaRecording() { if(on_) Stack::Instance().endDelta(); }
+
+    StackDelta finish()
+    {
+        on_ = false;
+        return Stack::Instance().endDelta();
+    }
+
+private:
+    DeltaRecording(const DeltaRecording&) = delete;
+    DeltaRecording(DeltaRecording&&) = delete;
+    DeltaRecording& operator=(const DeltaRecording&) = delete;
+    DeltaRecording& operator=(DeltaRecording&&) = delete;
+
+    bool on_;
+};
+
+}
+
 class CommandManager::CommandManagerImpl
 {
 public:
+    CommandManagerImpl() : versioned_{false} { }
     virtual ~CommandManagerImpl(){}
 
     virtual size_t getUndoSize() const = 0;
     virtual size_t getRedoSize() const = 0;
 
-    virtual void executeCommand(CommandPtr c) = 0;
-    virtual void undo() = 0;
-    virtual void redo() = 0;
+    // enters a command that has executed onto the undo stack and clears the redo stack
+    virtual void push(CommandPtr c) = 0;
+
+    // moves a command between the stacks, undoing or executing it only if apply is set
+    virtual void undo(bool apply) = 0;
+    virtual void redo(bool apply) = 0;
+    virtual void clear() = 0;
+
+    // whether the strategy takes its commands as DeltaCommands
+    virtual bool keepsDeltas() const { return false; }
+
+    // only a tree has branches
+    virtual vector<Branch> branches() const { return {}; }
+    virtual size_t currentBranch() const { return 0; }
+    virtual void switchBranch(size_t) { throw Exception{"The undo history has no branches"}; }
+
+    // whether commands are kept as versions of the stack, which a strategy keeping
+    // deltas never does
+    bool versioned() const { return versioned_ && !keepsDeltas(); }
+    void setVersioned(bool versioned) { versioned_ = versioned; }
+
+private:
+    bool versioned_;
 };
 
 class CommandManager::UndoRedoStackStrategy : public CommandManager::CommandManagerImpl
@@ -49,9 +151,10 @@ public:
     size_t getUndoSize() const override { return undoStack_.size(); }
     size_t getRedoSize() const override { return redoStack_.size(); }
 
-    void executeCommand(CommandPtr c) override;
-    void undo() override;
-    void redo() override;
+    void push(CommandPtr c) override;
+    void undo(bool apply) override;
+    void redo(bool apply) override;
+    void clear() override;
 
 private:
     void flushStack(stack<CommandPtr>& st);
@@ -60,22 +163,20 @@ private:
     stack<CommandPtr> redoStack_;
 };
 
-void CommandManager::UndoRedoStackStrategy::executeCommand(CommandPtr c)
+void CommandManager::UndoRedoStackStrategy::push(CommandPtr c)
 {
-    c->execute();
-
     undoStack_.push( std::move(c) );
     flushStack(redoStack_);
 
     return;
 }
 
-void CommandManager::UndoRedoStackStrategy::undo()
+void CommandManager::UndoRedoStackStrategy::undo(bool apply)
 {
     if( getUndoSize() == 0 ) return;
 
     auto& c = undoStack_.top();
-    c->undo();
+    if(apply) c->undo();
 
     redoStack_.push( std::move(c) );
     undoStack_.pop();
@@ -83,12 +184,12 @@ void CommandManager::UndoRedoStackStrategy::undo()
     return;
 }
 
-void CommandManager::UndoRedoStackStrategy::redo()
+void CommandManager::UndoRedoStackStrategy::redo(bool apply)
 {
     if( getRedoSize() == 0 ) return;
 
     auto& c = redoStack_.top();
-    c->execute();
+    if(apply) c->execute();
 
     undoStack_.push( std::move(c) );
     redoStack_.pop();
@@ -96,6 +197,14 @@ void CommandManager::UndoRedoStackStrategy::redo()
     return;
 }
 
+void CommandManager::UndoRedoStackStrategy::clear()
+{
+    flushStack(undoStack_);
+    flushStack(redoStack_);
+
+    return;
+}
+
 void CommandManager::UndoRedoStackStrategy::flushStack(stack<CommandPtr>& st)
 {
     while( !st.empty() )
@@ -114,9 +223,10 @@ public:
     size_t getUndoSize() const override { return undoSize_;}
     size_t getRedoSize() const override { return redoSize_; }
 
-    void executeCommand(CommandPtr c) override;
-    void undo() override;
-    void redo() override;
+    void push(CommandPtr c) override;
+    void undo(bool apply) override;
+    void redo(bool apply) override;
+    void clear() override;
 
 private:
     void flush();
@@ -127,10 +237,8 @@ private:
     vector<CommandPtr> undoRedoList_;
 };
 
-void CommandManager::UndoRedoListStrategyVector::executeCommand(CommandPtr c)
+void CommandManager::UndoRedoListStrategyVector::push(CommandPtr c)
 {
-    c->execute();
-
     flush();
     undoRedoList_.emplace_back( std::move(c) );
     cur_ = undoRedoList_.size() - 1;
@@ -140,11 +248,11 @@ void CommandManager::UndoRedoListStrategyVector::executeCommand(CommandPtr c)
     return;
 }
 
-void CommandManager::UndoRedoListStrategyVector::undo()
+void CommandManager::UndoRedoListStrategyVector::undo(bool apply)
 {
     if(getUndoSize() == 0) return;
 
-    undoRedoList_[cur_]->undo();
+    if(apply) undoRedoList_[cur_]->undo();
     --cur_;
     --undoSize_;
     ++redoSize_;
@@ -152,18 +260,28 @@ void CommandManager::UndoRedoListStrategyVector::undo()
     return;
 }
 
-void CommandManager::UndoRedoListStrategyVector::redo()
+void CommandManager::UndoRedoListStrategyVector::redo(bool apply)
 {
     if(getRedoSize() == 0) return;
 
     ++cur_;
-    undoRedoList_[cur_]->execute();
+    if(apply) undoRedoList_[cur_]->execute();
     --redoSize_;
     ++undoSize_;
 
     return;
 }
 
+void CommandManager::UndoRedoListStrategyVector::clear()
+{
+    undoRedoList_.clear();
+    cur_ = -1;
+    undoSize_ = 0;
+    redoSize_ = 0;
+
+    return;
+}
+
 void CommandManager::UndoRedoListStrategyVector::flush()
 {
     if(!undoRedoList_.empty()) undoRedoList_.erase(undoRedoList_.begin() + cur_ + 1, undoRedoList_.end());
@@ -179,9 +297,10 @@ public:
     size_t getUndoSize() const override { return undoSize_; }
     size_t getRedoSize() const override { return redoSize_; }
 
-    void executeCommand(CommandPtr c) override;
-    void undo() override;
-    void redo() override;
+    void push(CommandPtr c) override;
+    void undo(bool apply) override;
+    void redo(bool apply) override;
+    void clear() override;
 
 private:
     void flush();
@@ -192,10 +311,8 @@ private:
     list<CommandPtr>::iterator cur_;
 };
 
-void CommandManager::UndoRedoListStrategy::executeCommand(CommandPtr c)
+void CommandManager::UndoRedoListStrategy::push(CommandPtr c)
 {
-    c->execute();
-
     flush();
     undoRedoList_.emplace_back( std::move(c) );
     ++undoSize_;
@@ -206,26 +323,36 @@ void CommandManager::UndoRedoListStrategy::executeCommand(CommandPtr c)
     return;
 }
 
-void CommandManager::UndoRedoListStrategy::undo()
+void CommandManager::UndoRedoListStrategy::undo(bool apply)
 {
     if(undoSize_ == 0) return;
 
     --undoSize_;
     ++redoSize_;
-    (*cur_)->undo();
+    if(apply) (*cur_)->undo();
     --cur_;
 
     return;
 }
 
-void CommandManager::UndoRedoListStrategy::redo()
+void CommandManager::UndoRedoListStrategy::redo(bool apply)
 {
     if(redoSize_ == 0) return;
 
     --redoSize_;
     ++undoSize_;
     ++cur_;
-    (*cur_)->execute();
+    if(apply) (*cur_)->execute();
+
+    return;
+}
+
+void CommandManager::UndoRedoListStrategy::clear()
+{
+    undoRedoList_.clear();
+    cur_ = undoRedoList_.end();
+    undoSize_ = 0;
+    redoSize_ = 0;
 
     return;
 }
@@ -237,6 +364,275 @@ void CommandManager::UndoRedoListStrategy::flush()
     if(!undoRedoList_.empty()) undoRedoList_.erase(i, undoRedoList_.end());
 }
 
+// The commands from spilled_'s position on are in recent_, and the position is at
+// the end of spilled_ unless undo has gone back into it; either way, the manager's
+// position is the undo size.
+class CommandManager::UndoRedoSpillStrategy : public CommandManager::CommandManagerImpl
+{
+public:
+    UndoRedoSpillStrategy(const string& filename, size_t window)
+    : spilled_{filename}, window_{window}, undoSize_{0}, redoSize_{0}
+    { }
+
+    size_t getUndoSize() const override { return undoSize_; }
+    size_t getRedoSize() const override { return redoSize_; }
+
+    void push(CommandPtr c) override;
+    void undo(bool apply) override;
+    void redo(bool apply) override;
+    void clear() override;
+    bool keepsDeltas() const override { return true; }
+
+private:
+    size_t spilled() const { return spilled_.before() + spilled_.after(); }
+
+    SpilledHistory spilled_;
+    size_t window_;
+    deque<CommandPtr> recent_;
+    size_t undoSize_;
+    size_t redoSize_;
+};
+
+// the command is entered before the oldest ones are spilled, and a spill that
+// cannot be written keeps its records to write later, so no history is lost
+void CommandManager::UndoRedoSpillStrategy::push(CommandPtr c)
+{
+    if( undoSize_ < spilled() )
+    {
+        spilled_.truncate();
+        recent_.clear();
+    }
+    else recent_.erase( recent_.begin() + (undoSize_ - spilled()), recent_.end() );
+
+    recent_.push_back( std::move(c) );
+    ++undoSize_;
+    redoSize_ = 0;
+
+    while(recent_.size() > window_)
+    {
+        CommandPtr oldest{ std::move( recent_.front() ) };
+        recent_.pop_front();
+        spilled_.append( static_cast<const DeltaCommand&>(*oldest).delta() );
+    }
+
+    return;
+}
+
+void CommandManager::UndoRedoSpillStrategy::undo(bool apply)
+{
+    if(undoSize_ == 0) return;
+
+    if( undoSize_ > spilled() )
+    {
+        if(apply) recent_[undoSize_ - spilled() - 1]->undo();
+    }
+    else
+    {
+        StackDelta d{ spilled_.previous() };
+        if(apply) Stack::Instance().applyDelta(d, false);
+    }
+
+    --undoSize_;
+    ++redoSize_;
+
+    return;
+}
+
+void CommandManager::UndoRedoSpillStrategy::redo(bool apply)
+{
+    if(redoSize_ == 0) return;
+
+    if( undoSize_ < spilled() )
+    {
+        StackDelta d{ spilled_.next() };
+        if(apply) Stack::Instance().applyDelta(d, true);
+    }
+    else if(apply) recent_[undoSize_ - spilled()]->execute();
+
+    ++undoSize_;
+    --redoSize_;
+
+    return;
+}
+
+void CommandManager::UndoRedoSpillStrategy::clear()
+{
+    recent_.clear();
+    spilled_.clear();
+    undoSize_ = 0;
+    redoSize_ = 0;
+
+    return;
+}
+
+// The nodes form a tree rooted at nodes_[0], which stands for the empty history;
+// every other node holds the delta of the command that leads to it from its parent.
+// A node belongs to the branch that made it, and each branch's end is a leaf. The
+// current node is on the current branch, and from every node of that branch, next
+// leads toward its end, so redo follows it and the redo size is the distance to it.
+class CommandManager::UndoRedoTreeStrategy : public CommandManager::CommandManagerImpl
+{
+public:
+    UndoRedoTreeStrategy() { clear(); }
+
+    size_t getUndoSize() const override { return nodes_[cur_].depth; }
+    size_t getRedoSize() const override
+    { return branches_.empty() ? 0 : nodes_[ branches_[branch_].end ].depth - nodes_[cur_].depth; }
+
+    void push(CommandPtr c) override;
+    void undo(bool apply) override;
+    void redo(bool apply) override;
+    void clear() override;
+    bool keepsDeltas() const override { return true; }
+
+    vector<Branch> branches() const override;
+    size_t currentBranch() const override { return branch_; }
+    void switchBranch(size_t b) override;
+
+private:
+    static const size_t None = static_cast<size_t>(-1);
+
+    struct Node
+    {
+        StackDelta delta;
+        size_t parent;
+        size_t next;
+        size_t depth;
+        size_t pathBytes; // of this node and its ancestors
+    };
+
+    struct BranchEnd
+    {
+        size_t end;
+        size_t fork;
+        size_t bytes; // of the nodes the branch owns
+    };
+
+    static size_t bytes(const Node& n);
+
+    deque<Node> nodes_;
+    vector<BranchEnd> branches_;
+    size_t cur_;
+    size_t branch_;
+};
+
+// the memory a node takes, with its delta's elements
+size_t CommandManager::UndoRedoTreeStrategy::bytes(const Node& n)
+{
+    const StackDelta& d = n.delta;
+    return sizeof(Node) + (d.removed.capacity() + d.added.capacity()) * sizeof(double)
+        + (d.removedExact.capacity() + d.addedExact.capacity()) * sizeof(Stack::ExactValue);
+}
+
+// a command executed at the end of the current branch extends it; anywhere else, it
+// starts a new branch, leaving the commands that could have been redone on the old one
+void CommandManager::UndoRedoTreeStrategy::push(CommandPtr c)
+{
+    const size_t parent{cur_};
+    nodes_.push_back( Node{ std::move( static_cast<DeltaCommand&>(*c).delta() ), parent, None,
+        nodes_[parent].depth + 1, 0} );
+    cur_ = nodes_.size() - 1;
+
+    Node& n = nodes_.back();
+    const size_t b{ bytes(n) };
+    n.pathBytes = nodes_[parent].pathBytes + b;
+    nodes_[parent].next = cur_;
+
+    if( branches_.empty() || branches_[branch_].end != parent )
+    {
+        branches_.push_back( BranchEnd{cur_, nodes_[parent].depth, 0} );
+        branch_ = branches_.size() - 1;
+    }
+    branches_[branch_].end = cur_;
+    branches_[branch_].bytes += b;
+
+    return;
+}
+
+void CommandManager::UndoRedoTreeStrategy::undo(bool apply)
+{
+    if(getUndoSize() == 0) return;
+
+    if(apply) Stack::Instance().applyDelta(nodes_[cur_].delta, false);
+    cur_ = nodes_[cur_].parent;
+
+    return;
+}
+
+void CommandManager::UndoRedoTreeStrategy::redo(bool apply)
+{
+    if(getRedoSize() == 0) return;
+
+    cur_ = nodes_[cur_].next;
+    if(apply) Stack::Instance().applyDelta(nodes_[cur_].delta, true);
+
+    return;
+}
+
+void CommandManager::UndoRedoTreeStrategy::clear()
+{
+    nodes_.clear();
+    nodes_.push_back( Node{ StackDelta{}, None, None, 0, 0 } );
+    branches_.clear();
+    cur_ = 0;
+    branch_ = 0;
+
+    return;
+}
+
+vector<CommandManager::Branch> CommandManager::UndoRedoTreeStrategy::branches() const
+{
+    vector<Branch> v;
+    v.reserve( branches_.size() );
+    for(const auto& b : branches_)
+    {
+        const Node& end = nodes_[b.end];
+        v.push_back( Branch{end.depth, b.fork, b.bytes, end.pathBytes - b.bytes} );
+    }
+
+    return v;
+}
+
+// The walks up from the current node and from the end of b meet at the fork, the
+// second recording the way back down. Only the last change to the stack raises
+// StackChanged, which covers all of them.
+void CommandManager::UndoRedoTreeStrategy::switchBranch(size_t b)
+{
+    if( b >= branches_.size() ) throw Exception{"The undo history has no such branch"};
+
+    vector<size_t> down;
+    size_t up{cur_};
+    size_t target{ branches_[b].end };
+    while(nodes_[target].depth > nodes_[up].depth)
+    {
+        down.push_back(target);
+        target = nodes_[target].parent;
+    }
+    while(nodes_[up].depth > nodes_[target].depth) up = nodes_[up].parent;
+    while(up != target)
+    {
+        down.push_back(target);
+        target = nodes_[target].parent;
+        up = nodes_[up].parent;
+    }
+    const size_t fork{up};
+
+    Stack& stack = Stack::Instance();
+    for(size_t n = cur_; n != fork; n = nodes_[n].parent)
+        stack.applyDelta( nodes_[n].delta, false, nodes_[n].parent != fork || !down.empty() );
+
+    for(auto i = down.rbegin(); i != down.rend(); ++i)
+    {
+        nodes_[ nodes_[*i].parent ].next = *i;
+        stack.applyDelta( nodes_[*i].delta, true, i + 1 != down.rend() );
+    }
+
+    cur_ = branches_[b].end;
+    branch_ = b;
+
+    return;
+}
+
 CommandManager::CommandManager(UndoRedoStrategy st)
 {
     switch(st)
@@ -252,6 +648,10 @@ CommandManager::CommandManager(UndoRedoStrategy st)
     case UndoRedoStrategy::ListStrategyVector:
         pimpl_ = make_unique<UndoRedoListStrategyVector>();
         break;
+
+    case UndoRedoStrategy::TreeStrategy:
+        pimpl_ = make_unique<UndoRedoTreeStrategy>();
+        break;
     }
 }
 
@@ -268,21 +668,106 @@ size_t CommandManager::getRedoSize() const
     return pimpl_->getRedoSize();
 }
 
-void CommandManager::executeCommand(CommandPtr c)
+// a command that ran out of budget, or was cancelled, is undone and forgotten
+void CommandManager::executeCommand(CommandPtr c, CancellationToken* token)
 {
-    pimpl_->executeCommand( std::move(c) );
+    const bool versions{ pimpl_->versioned() };
+    StackVersion before;
+    if(versions) before = Stack::Instance().version();
+    DeltaRecording recording{ pimpl_->keepsDeltas() };
+
+    c->execute();
+
+    if( token && !token->step() )
+    {
+        c->undo();
+        throw Exception{ token->reason() };
+    }
+
+    if( pimpl_->keepsDeltas() ) c = MakeCommandPtr<DeltaCommand>( recording.finish() );
+    else if(versions) c = MakeCommandPtr<VersionedCommand>( std::move(before), Stack::Instance().version() );
+
+    pimpl_->push( std::move(c) );
     return;
 }
 
 void CommandManager::undo()
 {
-    pimpl_->undo();
+    pimpl_->undo(true);
     return;
 }
 
 void CommandManager::redo()
 {
-    pimpl_->redo();
+    pimpl_->redo(true);
+    return;
+}
+
+// with versions, only the last command moved restores the stack
+void CommandManager::undo(size_t n)
+{
+    const bool versions{ pimpl_->versioned() };
+    n = std::min( n, getUndoSize() );
+    for(size_t i = 1; i <= n; ++i)
+        pimpl_->undo(!versions || i == n);
+
+    return;
+}
+
+void CommandManager::redo(size_t n)
+{
+    const bool versions{ pimpl_->versioned() };
+    n = std::min( n, getRedoSize() );
+    for(size_t i = 1; i <= n; ++i)
+        pimpl_->redo(!versions || i == n);
+
+    return;
+}
+
+void CommandManager::spillHistory(const string& filename, size_t window)
+{
+    pimpl_ = make_unique<UndoRedoSpillStrategy>(filename, window);
+    return;
+}
+
+void CommandManager::keepBranches()
+{
+    pimpl_ = make_unique<UndoRedoTreeStrategy>();
+    return;
+}
+
+vector<CommandManager::Branch> CommandManager::branches() const
+{
+    return pimpl_->branches();
+}
+
+size_t CommandManager::currentBranch() const
+{
+    return pimpl_->currentBranch();
+}
+
+void CommandManager::switchBranch(size_t b)
+{
+    pimpl_->switchBranch(b);
+    return;
+}
+
+void CommandManager::setVersioned(bool versioned)
+{
+    clear();
+    pimpl_->setVersioned(versioned);
+
+    return;
+}
+
+bool CommandManager::versioned() const
+{
+    return pimpl_->versioned();
+}
+
+void CommandManager::clear()
+{
+    pimpl_->clear();
     return;
 }
 
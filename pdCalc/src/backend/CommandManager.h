@@ -20,18 +20,36 @@
 #define COMMAND_MANAGER_H
 
 #include <memory>
+#include <string>
+#include <vector>
 #include "Command.h"
 
 namespace pdCalc {
 
+class CancellationToken;
+
 class CommandManager
 {
     class CommandManagerImpl;
     class UndoRedoStackStrategy;
     class UndoRedoListStrategyVector;
     class UndoRedoListStrategy;
+    class UndoRedoSpillStrategy;
+    class UndoRedoTreeStrategy;
 public:
-    enum class UndoRedoStrategy { ListStrategy, StackStrategy, ListStrategyVector };
+    enum class UndoRedoStrategy { ListStrategy, StackStrategy, ListStrategyVector, TreeStrategy };
+
+    // A branch of a tree of undo history runs from the first command to a command
+    // nothing was executed after. It shares the commands up to its fork, the number
+    // of commands before it left the branch it was made from, and owns the rest.
+    // Memory is that of the deltas kept for the commands and their bookkeeping.
+    struct Branch
+    {
+        size_t commands;
+        size_t fork;
+        size_t ownBytes;
+        size_t sharedBytes;
+    };
 
     explicit CommandManager(UndoRedoStrategy st = UndoRedoStrategy::StackStrategy);
     ~CommandManager();
@@ -41,7 +59,11 @@ public:
 
     // This function call executes the command, enters the new command onto the undo stack,
     // and it clears the redo stack. This is consistent with typical undo/redo functionality.
-    void executeCommand(CommandPtr c);
+    // Given a token, the command counts as a step of its evaluation (see CancellationToken).
+    // If the evaluation must stop, whether by a cancellation or by exhausting its budget
+    // in this command or a procedure the command ran, the command is undone instead, the
+    // stacks are left alone, and Exception is thrown with the reason.
+    void executeCommand(CommandPtr c, CancellationToken* token = nullptr);
 
     // This function undoes the command at the top of the undo stack and moves this command
     // to the redo stack. It does nothing if the undo stack is empty.
@@ -51,6 +73,49 @@ public:
     // to the undo stack. It does nothing if the redo stack is empty.
     void redo();
 
+    // These functions undo (redo) the last n commands, or as many as there are. Without
+    // versions, each command is undone (redone) in turn.
+    void undo(size_t n);
+    void redo(size_t n);
+
+    // This function discards the undo and redo stacks without undoing or redoing anything.
+    void clear();
+
+    // With versions, the manager keeps the versions of the stack before and after each
+    // command in place of the command, and undo and redo check those out rather than
+    // running anything. Then undoing or redoing n commands restores the stack once, in
+    // time proportional to how much it differs, which is cheap when the stack is
+    // persistent (see Stack::setPersistent). Changing this setting clears the manager.
+    // A manager that keeps deltas (see spillHistory and keepBranches) is never
+    // versioned, whatever the setting.
+    void setVersioned(bool versioned);
+    bool versioned() const;
+
+    // From now on, the manager keeps each command as the StackDelta it made, holds
+    // only the window most recent ones in memory, and spills older ones to an
+    // append-only segment file, filename, from which undo pages them back in (see
+    // SpilledHistory), so that memory stays bounded however long the history. A
+    // spilling manager keeps deltas rather than versions. This clears the manager,
+    // and throws Exception if filename cannot be written.
+    void spillHistory(const std::string& filename, size_t window);
+
+    // From now on, the manager keeps its history as a tree (TreeStrategy): executing
+    // a command after undo starts a new branch instead of discarding the commands
+    // undone, and redo follows the current branch. Each command is kept as the
+    // StackDelta it made, once however many branches share it. This clears the
+    // manager.
+    void keepBranches();
+
+    // The branches of a tree of history, in the order they were made, and the one undo
+    // and redo follow. Other histories report no branches.
+    std::vector<Branch> branches() const;
+    size_t currentBranch() const;
+
+    // Undoes back to where the current branch and branch b fork, then redoes to the
+    // end of b, so the time taken is proportional to the commands between the two
+    // rather than to the length of either. Throws Exception if there is no branch b.
+    void switchBranch(size_t b);
+
 private:
     CommandManager(CommandManager&) = delete;
     CommandManager(CommandManager&& ) = delete;
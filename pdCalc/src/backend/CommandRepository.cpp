@@ -19,12 +19,18 @@
 #include "CommandRepository.h"
 #include "Command.h"
 #include <unordered_map>
+#include <algorithm>
+#include <mutex>
 #include "../utilities/Exception.h"
 #include <sstream>
 
 using std::string;
 using std::unordered_map;
 using std::set;
+using std::vector;
+using std::pair;
+using std::mutex;
+using std::lock_guard;
 
 namespace pdCalc {
 
@@ -34,8 +40,9 @@ public:
     CommandRepositoryImpl();
     void registerCommand(const string& name, CommandPtr c);
     CommandPtr deregisterCommand(const string& name);
+    vector<CommandPtr> replaceCommands(const vector<string>& remove, vector<pair<string, CommandPtr>> add);
 
-    size_t getNumberCommands() const { return repository_.size(); }
+    size_t getNumberCommands() const;
     CommandPtr allocateCommand(const string& name) const;
 
     bool hasKey(const string& s) const;
@@ -47,20 +54,32 @@ public:
 
 private:
     using Repository = unordered_map<string, CommandPtr>;
+
+    bool registered(const string& s) const { return repository_.find(s) != repository_.end(); }
+
     Repository repository_;
+    mutable mutex mutex_;
 };
 
 CommandRepository::CommandRepositoryImpl::CommandRepositoryImpl()
 {
 }
 
+size_t CommandRepository::CommandRepositoryImpl::getNumberCommands() const
+{
+    lock_guard<mutex> lock{mutex_};
+    return repository_.size();
+}
+
 bool CommandRepository::CommandRepositoryImpl::hasKey(const string& s) const
 {
-    return repository_.find(s) != repository_.end();
+    lock_guard<mutex> lock{mutex_};
+    return registered(s);
 }
 
 set<string> CommandRepository::CommandRepositoryImpl::getAllCommandNames() const
 {
+    lock_guard<mutex> lock{mutex_};
     set<string> tmp;
 
     for(auto i = repository_.begin(); i != repository_.end(); ++i)
@@ -71,6 +90,7 @@ set<string> CommandRepository::CommandRepositoryImpl::getAllCommandNames() const
 
 void CommandRepository::CommandRepositoryImpl::printHelp(const std::string& command, std::ostream& os)
 {
+    lock_guard<mutex> lock{mutex_};
     auto it = repository_.find(command);
     if(it != repository_.end())
         os << command << ": " << it->second->helpMessage();
@@ -80,15 +100,22 @@ void CommandRepository::CommandRepositoryImpl::printHelp(const std::string& comm
     return;
 }
 
+// the commands are destroyed once the lock is released
 void CommandRepository::CommandRepositoryImpl::clearAllCommands()
 {
-    repository_.clear();
+    Repository cleared;
+    {
+        lock_guard<mutex> lock{mutex_};
+        cleared.swap(repository_);
+    }
+
     return;
 }
 
 void CommandRepository::CommandRepositoryImpl::registerCommand(const string& name, CommandPtr c)
 {
-    if( hasKey(name) )
+    lock_guard<mutex> lock{mutex_};
+    if( registered(name) )
     {
         std::ostringstream oss;
         oss << "Command " << name << " already registered";
@@ -102,7 +129,8 @@ void CommandRepository::CommandRepositoryImpl::registerCommand(const string& nam
 
 CommandPtr CommandRepository::CommandRepositoryImpl::deregisterCommand(const string& name)
 {
-    if( hasKey(name) )
+    lock_guard<mutex> lock{mutex_};
+    if( registered(name) )
     {
         auto i = repository_.find(name);
         auto tmp = MakeCommandPtr( i->second.release() );
@@ -114,12 +142,41 @@ CommandPtr CommandRepository::CommandRepositoryImpl::deregisterCommand(const str
 
 CommandPtr CommandRepository::CommandRepositoryImpl::allocateCommand(const string &name) const
 {
-    if( hasKey(name) )
+    lock_guard<mutex> lock{mutex_};
+    auto i = repository_.find(name);
+    if( i != repository_.end() )
+        return MakeCommandPtr( i->second->clone() );
+    else return MakeCommandPtr(nullptr);
+}
+
+vector<CommandPtr> CommandRepository::CommandRepositoryImpl::replaceCommands(const vector<string>& remove,
+    vector<pair<string, CommandPtr>> add)
+{
+    lock_guard<mutex> lock{mutex_};
+    for(const auto& c : add)
     {
-        const auto& command = repository_.find(name)->second;
-        return MakeCommandPtr( command->clone() );
+        if( registered(c.first) && std::find( remove.begin(), remove.end(), c.first ) == remove.end() )
+        {
+            std::ostringstream oss;
+            oss << "Command " << c.first << " already registered";
+            throw Exception{ oss.str() };
+        }
     }
-    else return MakeCommandPtr(nullptr);
+
+    vector<CommandPtr> removed;
+    for(const auto& name : remove)
+    {
+        auto i = repository_.find(name);
+        if( i == repository_.end() ) continue;
+
+        removed.push_back( std::move(i->second) );
+        repository_.erase(i);
+    }
+
+    for(auto& c : add)
+        repository_.emplace( c.first, std::move(c.second) );
+
+    return removed;
 }
 
 CommandRepository::CommandRepository()
@@ -147,6 +204,12 @@ CommandPtr CommandRepository::deregisterCommand(const string& name)
     return pimpl_->deregisterCommand(name);
 }
 
+std::vector<CommandPtr> CommandRepository::replaceCommands(const std::vector<string>& remove,
+    std::vector<std::pair<string, CommandPtr>> add)
+{
+    return pimpl_->replaceCommands( remove, std::move(add) );
+}
+
 size_t CommandRepository::getNumberCommands() const
 {
     return pimpl_->getNumberCommands();
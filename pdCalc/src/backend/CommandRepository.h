@@ -22,11 +22,15 @@
 // The CommandRepository class is responsible for returning a Command by name. New commands
 // can be dynamically added at runtime (to support) plugins, and commands can also be
 // deregistered (if desired if a plugin is removed). New commands are returned as clones
-// of the registered Command. This makes use of the Prototype pattern.
+// of the registered Command. This makes use of the Prototype pattern. The repository
+// may be used from several threads at once, so that a plugin can be reloaded while
+// commands run.
 
 #include <memory>
 #include <string>
 #include <set>
+#include <vector>
+#include <utility>
 #include <iostream>
 #include "Command.h"
 
@@ -47,6 +51,13 @@ public:
     // if the command does not exist
     CommandPtr deregisterCommand(const std::string& name);
 
+    // deregisters the commands named in remove and registers those in add at once, so
+    // that no command is allocated from a mixture of the two, and returns the commands
+    // removed: throws, changing nothing, if a command in add has the name of another
+    // that stays registered
+    std::vector<CommandPtr> replaceCommands(const std::vector<std::string>& remove,
+        std::vector<std::pair<std::string, CommandPtr>> add);
+
     // returns the number of commands currently registered
     size_t getNumberCommands() const;
 
@@ -0,0 +1,183 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "CommandWorker.h"
+#include "CommandDispatcher.h"
+#include "utilities/CancellationToken.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using std::string;
+using std::deque;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+namespace pdCalc {
+
+class CommandWorker::CommandWorkerImpl
+{
+public:
+    explicit CommandWorkerImpl(CommandDispatcher& ce);
+    ~CommandWorkerImpl();
+
+    void commandEntered(const string& command);
+    void cancel();
+    void wait();
+    bool busy() const;
+    size_t progress() const { return token_.steps(); }
+
+private:
+    void work();
+
+    CommandDispatcher& ce_;
+    CancellationToken& token_;
+
+    mutable mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable idle_;
+    deque<string> queue_;
+    bool running_;
+    bool stop_;
+
+    std::thread thread_;
+};
+
+CommandWorker::CommandWorkerImpl::CommandWorkerImpl(CommandDispatcher& ce)
+: ce_(ce)
+, token_(ce.cancellationToken())
+, running_{false}
+, stop_{false}
+{
+    thread_ = std::thread{ [this]{ work(); } };
+}
+
+CommandWorker::CommandWorkerImpl::~CommandWorkerImpl()
+{
+    {
+        lock_guard<mutex> lock{mutex_};
+        stop_ = true;
+        queue_.clear();
+        token_.cancel();
+    }
+    queued_.notify_one();
+    thread_.join();
+
+    token_.reset();
+}
+
+void CommandWorker::CommandWorkerImpl::commandEntered(const string& command)
+{
+    {
+        lock_guard<mutex> lock{mutex_};
+        queue_.push_back(command);
+    }
+    queued_.notify_one();
+
+    return;
+}
+
+// a cancellation is forgotten only as an entry starts, under the lock, so it reaches
+// the running entry or finds the queue it clears, never the next entry
+void CommandWorker::CommandWorkerImpl::cancel()
+{
+    lock_guard<mutex> lock{mutex_};
+    queue_.clear();
+    if(running_) token_.cancel();
+
+    return;
+}
+
+void CommandWorker::CommandWorkerImpl::wait()
+{
+    unique_lock<mutex> lock{mutex_};
+    idle_.wait(lock, [this]{ return queue_.empty() && !running_; });
+
+    return;
+}
+
+bool CommandWorker::CommandWorkerImpl::busy() const
+{
+    lock_guard<mutex> lock{mutex_};
+
+    return running_ || !queue_.empty();
+}
+
+void CommandWorker::CommandWorkerImpl::work()
+{
+    unique_lock<mutex> lock{mutex_};
+    while(true)
+    {
+        queued_.wait(lock, [this]{ return stop_ || !queue_.empty(); });
+        if(stop_) return;
+
+        string command{ std::move( queue_.front() ) };
+        queue_.pop_front();
+        token_.reset();
+        running_ = true;
+
+        lock.unlock();
+        ce_.commandEntered(command);
+        lock.lock();
+
+        running_ = false;
+        if( queue_.empty() ) idle_.notify_all();
+    }
+}
+
+CommandWorker::CommandWorker(CommandDispatcher& ce)
+: pimpl_{ std::make_unique<CommandWorkerImpl>(ce) }
+{ }
+
+CommandWorker::~CommandWorker()
+{ }
+
+void CommandWorker::commandEntered(const string& command)
+{
+    pimpl_->commandEntered(command);
+
+    return;
+}
+
+void CommandWorker::cancel()
+{
+    pimpl_->cancel();
+
+    return;
+}
+
+void CommandWorker::wait()
+{
+    pimpl_->wait();
+
+    return;
+}
+
+bool CommandWorker::busy() const
+{
+    return pimpl_->busy();
+}
+
+size_t CommandWorker::progress() const
+{
+    return pimpl_->progress();
+}
+
+}
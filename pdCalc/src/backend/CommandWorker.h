@@ -0,0 +1,71 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMMAND_WORKER_H
+#define COMMAND_WORKER_H
+
+#include <memory>
+#include <string>
+
+namespace pdCalc {
+
+class CommandDispatcher;
+
+// Runs the entries for a dispatcher, in order, on a thread of their own, so that an
+// interface stays responsive while a long procedure runs. Every change to the stack,
+// and every message, then reaches the interface on the worker's thread, and the
+// interface must hand them to its own. The dispatcher, and the stack, must not be
+// used from any other thread while the worker lives.
+class CommandWorker
+{
+    class CommandWorkerImpl;
+public:
+    explicit CommandWorker(CommandDispatcher& ce);
+
+    // cancels the running entry, discards the queued ones, and waits for the thread
+    ~CommandWorker();
+
+    // queues command to run after those already queued
+    void commandEntered(const std::string& command);
+
+    // Discards the queued entries and stops the running one at its next step (see
+    // CommandDispatcher::cancellationToken), rolling the stack back to where the entry
+    // found it.
+    void cancel();
+
+    // blocks until every queued entry has run
+    void wait();
+
+    // whether an entry is queued or running
+    bool busy() const;
+
+    // the steps the running entry has taken so far
+    size_t progress() const;
+
+private:
+    CommandWorker(const CommandWorker&) = delete;
+    CommandWorker(CommandWorker&&) = delete;
+    CommandWorker& operator=(const CommandWorker&) = delete;
+    CommandWorker& operator=(CommandWorker&&) = delete;
+
+    std::unique_ptr<CommandWorkerImpl> pimpl_;
+};
+
+}
+
+#endif
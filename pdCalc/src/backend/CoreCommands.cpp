@@ -17,8 +17,12 @@
 // along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
 
 #include "CoreCommands.h"
+#include "CoreOperations.h"
 #include "Stack.h"
 #include "utilities/Exception.h"
+#include "utilities/BigNumber.h"
+#include "utilities/VectorMath.h"
+#include "utilities/BlockAlgorithms.h"
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -28,6 +32,8 @@
 
 using std::vector;
 using std::string;
+using std::shared_ptr;
+using std::make_shared;
 
 namespace pdCalc {
 
@@ -35,38 +41,47 @@ namespace {
 
 double eps = 1e-12; // arbitrary floating closeness
 
-bool topOfStackisBetween(double lb, double ub)
+// limits beyond which pow and root leave exact mode for the double result
+const long long MaxExactPower = 1000000000;
+const long long MaxExactMagnitude = 1000000000000000000;
+const long long MaxExactRoot = 100;
+
+// checks the count on top of the stack for a command on the block below it and
+// returns the count
+size_t checkBlockCount()
 {
-    assert(lb <= ub);
+    const Stack& stack = Stack::Instance();
+    if( stack.size() < 1 )
+        throw Exception{"Stack must have a count on top"};
 
-    auto v = Stack::Instance().getElements(1);
-    auto d = v.back();
+    double count{ stack.getElements(1).front() };
+    if( !(count >= 1.0) || count != std::floor(count) )
+        throw Exception{"Count must be a positive integer"};
 
-    return d >= lb && d <= ub;
+    if(count > stack.size() - 1)
+        throw Exception{"Stack has fewer elements than the count"};
+
+    return static_cast<size_t>(count);
 }
 
-// for y^x, we must have
-// 1) If y == 0, x must be >= 0
-// 2) If y < 0, x must be integral
-// also works for nth rootOf(y) for x = 1/n
-bool passesPowerTest(double y, double x)
+// pushes back the operands of a block command, bottom first, with their exact
+// values, which are top first
+void restoreOperands(const vector<double>& operands, const vector<shared_ptr<const BigFloat>>& exact)
 {
-    auto pass = true;
+    Stack& stack = Stack::Instance();
 
-    // check against true 0; otherwise it is invertible
-    // although not well conditioned
-    if(y == 0 && x < 0)
-    {
-        pass = false;
-    }
+    bool anyExact{false};
+    for(const auto& e : exact)
+        anyExact = anyExact || e;
 
-    double intPart;
-    if( y < 0 && std::modf(x, &intPart) != 0.0 )
+    if(anyExact)
     {
-        pass = false;
+        for(size_t i = 0; i < operands.size(); ++i)
+            stack.push( operands[i], exact[operands.size() - 1 - i], i + 1 < operands.size() );
     }
+    else stack.pushElements( operands.data(), operands.size(), false );
 
-    return pass;
+    return;
 }
 
 void registerCommand(UserInterface& ui, const string& label, CommandPtr c)
@@ -85,14 +100,61 @@ void registerCommand(UserInterface& ui, const string& label, CommandPtr c)
 
 }
 
+// tan is infinite at odd multiples of pi/2
+const char* TangentDomain(double x)
+{
+    double d{ x + M_PI / 2. };
+    double r{ std::fabs(d) / std::fabs(M_PI) };
+    int w{ static_cast<int>(std::floor(r + eps)) };
+    r = r - w;
+
+    return r < eps && r > -eps ? "Infinite result" : nullptr;
+}
+
+const char* InverseTrigDomain(double x)
+{
+    return x >= -1 && x <= 1 ? nullptr : "Invalid argument";
+}
+
+// for y^x, we must have
+// 1) If y == 0, x must be >= 0
+// 2) If y < 0, x must be integral
+// also works for nth rootOf(y) for x = 1/n
+bool PassesPowerTest(double y, double x)
+{
+    auto pass = true;
+
+    // check against true 0; otherwise it is invertible
+    // although not well conditioned
+    if(y == 0 && x < 0)
+    {
+        pass = false;
+    }
+
+    double intPart;
+    if( y < 0 && std::modf(x, &intPart) != 0.0 )
+    {
+        pass = false;
+    }
+
+    return pass;
+}
+
 EnterNumber::EnterNumber(double d)
 : Command{}
 , number_{d}
 { }
 
+EnterNumber::EnterNumber(double d, shared_ptr<const BigFloat> exact)
+: Command{}
+, number_{d}
+, exact_{exact}
+{ }
+
 EnterNumber::EnterNumber(const EnterNumber& rhs)
 : Command{rhs}
 , number_{rhs.number_}
+, exact_{rhs.exact_}
 { }
 
 EnterNumber::~EnterNumber()
@@ -100,7 +162,7 @@ EnterNumber::~EnterNumber()
 
 void EnterNumber::executeImpl() noexcept
 {
-    Stack::Instance().push(number_);
+    Stack::Instance().push(number_, exact_);
 
     return;
 }
@@ -158,6 +220,7 @@ const char* SwapTopOfStack::helpMessageImpl() const noexcept
 DropTopOfStack::DropTopOfStack(const DropTopOfStack& rhs)
 : Command{rhs}
 , droppedNumber_{rhs.droppedNumber_}
+, droppedExact_{rhs.droppedExact_}
 { }
 
 DropTopOfStack::~DropTopOfStack()
@@ -171,13 +234,13 @@ void DropTopOfStack::checkPreconditionsImpl() const
 
 void DropTopOfStack::executeImpl() noexcept
 {
-    droppedNumber_ = Stack::Instance().pop();
+    droppedNumber_ = Stack::Instance().pop(droppedExact_);
     return;
 }
 
 void DropTopOfStack::undoImpl() noexcept
 {
-    Stack::Instance().push(droppedNumber_);
+    Stack::Instance().push(droppedNumber_, droppedExact_);
     return;
 }
 
@@ -194,6 +257,7 @@ const char* DropTopOfStack::helpMessageImpl() const noexcept
 ClearStack::ClearStack(const ClearStack& rhs)
 : Command{rhs}
 , stack_{rhs.stack_}
+, exact_{rhs.exact_}
 { }
 
 ClearStack::~ClearStack()
@@ -203,12 +267,15 @@ void ClearStack::executeImpl() noexcept
 {
     const auto n = Stack::Instance().size();
     if(n == 0) return;
+    shared_ptr<const BigFloat> exact;
     for(auto i = 0u; i < n - 1; ++i)
     {
-        stack_.push( Stack::Instance().pop(true) );
+        stack_.push( Stack::Instance().pop(exact, true) );
+        exact_.push(exact);
     }
 
-    stack_.push( Stack::Instance().pop(false) );
+    stack_.push( Stack::Instance().pop(exact, false) );
+    exact_.push(exact);
 
     return;
 }
@@ -219,12 +286,14 @@ void ClearStack::undoImpl() noexcept
     if(n == 0) return;
     for(auto i = 0u; i < n - 1; ++i)
     {
-        Stack::Instance().push(stack_.top(), true);
+        Stack::Instance().push(stack_.top(), exact_.top(), true);
         stack_.pop();
+        exact_.pop();
     }
 
-    Stack::Instance().push(stack_.top(), false);
+    Stack::Instance().push(stack_.top(), exact_.top(), false);
     stack_.pop();
+    exact_.pop();
 
     return;
 }
@@ -239,333 +308,391 @@ const char* ClearStack::helpMessageImpl() const noexcept
     return "Clear the stack";
 }
 
-Add::Add(const Add& rhs)
-: BinaryCommand{rhs}
-{ }
-
-Add::~Add()
-{ }
+namespace {
 
-const char* Add::helpMessageImpl() const noexcept
+// throws the error of Op::Domain for the operands on the stack
+template<typename Op>
+void checkBinaryDomain()
 {
-    return "Replace first two elements on the stack with their sum";
-}
+    double v[2];
+    Stack::Instance().peekElements(2, v);
+    if( const char* error = Op::Domain(v[0], v[1]) )
+        throw Exception{error};
 
-Add* Add::cloneImpl() const
-{
-    return new Add{*this};
+    return;
 }
 
-double Add::binaryOperation(double next, double top) const noexcept
+template<typename Op>
+void checkUnaryDomain()
 {
-    return next + top;
-}
+    double top;
+    Stack::Instance().peekElements(1, &top);
+    if( const char* error = Op::Domain(top) )
+        throw Exception{error};
 
-Subtract::Subtract(const Subtract& rhs)
-: BinaryCommand{rhs}
-{ }
+    return;
+}
 
-Subtract::~Subtract()
-{ }
+}
 
-double Subtract::binaryOperation(double next, double top) const noexcept
+shared_ptr<const BigFloat> AddOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    return next - top;
+    return make_shared<const BigFloat>( BigFloat::Add(next, top, digits) );
 }
 
-Subtract* Subtract::cloneImpl() const
+void AddOperation::CheckPreconditions()
 {
-    return new Subtract{*this};
+    checkBinaryDomain<AddOperation>();
 }
 
-const char* Subtract::helpMessageImpl() const noexcept
+shared_ptr<const BigFloat> SubtractOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    return "Replace first two elements on the stack with their difference";
+    return make_shared<const BigFloat>( BigFloat::Subtract(next, top, digits) );
 }
 
-Divide::Divide(const Divide& rhs)
-: BinaryCommand{rhs}
-{ }
-
-Divide::~Divide()
-{ }
-
-void Divide::checkPreconditionsImpl() const
+void SubtractOperation::CheckPreconditions()
 {
-    BinaryCommand::checkPreconditionsImpl();
-    auto v = Stack::Instance().getElements(1);
-    if(v.front() == 0. || v.front() == -0.)
-        throw Exception{"Division by zero"};
-
-    return;
+    checkBinaryDomain<SubtractOperation>();
 }
 
-double Divide::binaryOperation(double next, double top) const noexcept
+shared_ptr<const BigFloat> MultiplyOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    return next / top;
+    return make_shared<const BigFloat>( BigFloat::Multiply(next, top, digits) );
 }
 
-Divide* Divide::cloneImpl() const
+void MultiplyOperation::CheckPreconditions()
 {
-    return new Divide{*this};
+    checkBinaryDomain<MultiplyOperation>();
 }
 
-const char* Divide::helpMessageImpl() const noexcept
+shared_ptr<const BigFloat> DivideOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    return "Replace first two elements on the stack with their quotient";
+    return make_shared<const BigFloat>( BigFloat::Divide(next, top, digits) );
 }
 
-Power::Power(const Power& rhs)
-: BinaryCommand{rhs}
-{ }
-
-Power::~Power()
-{ }
-
-void Power::checkPreconditionsImpl() const
+void DivideOperation::CheckPreconditions()
 {
-    BinaryCommand::checkPreconditionsImpl();
+    // in exact mode, a divisor too small for a double is still divisible
+    auto exact = Stack::Instance().getExactElements(1);
+    if( Stack::Instance().precision() > 0 && exact.front() )
+    {
+        if( exact.front()->isZero() )
+            throw Exception{"Division by zero"};
 
-    auto v = Stack::Instance().getElements(2);
-    if( !passesPowerTest(v[1], v[0]) )
-        throw Exception{"Invalid result"};
+        return;
+    }
+
+    checkBinaryDomain<DivideOperation>();
 
     return;
 }
 
-double Power::binaryOperation(double next, double top) const noexcept
+// only integer powers are exact; the result's decimal exponent must also stay well
+// inside a long long
+shared_ptr<const BigFloat> PowerOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    return std::pow(next, top);
-}
+    long long n;
+    if( !top.toInteger(n) || n > MaxExactPower || n < -MaxExactPower ) return nullptr;
 
-Power* Power::cloneImpl() const
-{
-    return new Power{*this};
+    const long long magnitude{ std::abs(next.exponent()) + static_cast<long long>( next.mantissa().nDigits() ) };
+    if( magnitude > MaxExactMagnitude / MaxExactPower ) return nullptr;
+
+    return make_shared<const BigFloat>( BigFloat::Pow(next, n, digits) );
 }
 
-const char* Power::helpMessageImpl() const noexcept
+void PowerOperation::CheckPreconditions()
 {
-    return "Replace first two elements on the stack, y, x, with y^x. Note, x is top of stack";
+    checkBinaryDomain<PowerOperation>();
 }
 
-Root::Root(const Root& rhs)
-: BinaryCommand{rhs}
-{ }
-
-Root::~Root()
-{ }
-
-void Root::checkPreconditionsImpl() const
+// only roots of small positive integer index are exact, since the work grows with
+// the index times the precision
+shared_ptr<const BigFloat> RootOperation::Exact(const BigFloat& next, const BigFloat& top, unsigned digits)
 {
-    BinaryCommand::checkPreconditionsImpl();
+    long long n;
+    if( !top.toInteger(n) || n < 1 || n > MaxExactRoot ) return nullptr;
+    if( next.negative() && n % 2 == 0 ) return nullptr;
 
-    auto v = Stack::Instance().getElements(2);
-    if( !passesPowerTest(v[1], 1. / v[0]) || v[0] == 0.0 )
-        throw Exception{"Invalid result"};
+    return make_shared<const BigFloat>( BigFloat::Root(next, static_cast<unsigned>(n), digits) );
 }
 
-double Root::binaryOperation(double next, double top) const noexcept
+void RootOperation::CheckPreconditions()
 {
-    return std::pow(next, 1. / top);
+    checkBinaryDomain<RootOperation>();
 }
 
-Root* Root::cloneImpl() const
+void SineOperation::CheckPreconditions()
 {
-    return new Root{*this};
+    checkUnaryDomain<SineOperation>();
 }
 
-const char* Root::helpMessageImpl() const noexcept
+void CosineOperation::CheckPreconditions()
 {
-    return "Replace first two elements on teh stack, y, x, with xth root of y. Note, x is top of stack";
+    checkUnaryDomain<CosineOperation>();
 }
 
-Sine::Sine(const Sine& rhs)
-: UnaryCommand{rhs}
-{ }
-
-Sine::~Sine()
-{ }
-
-double Sine::unaryOperation(double top) const noexcept
+void TangentOperation::CheckPreconditions()
 {
-    return std::sin(top);
+    checkUnaryDomain<TangentOperation>();
 }
 
-Sine* Sine::cloneImpl() const
+void ArcsineOperation::CheckPreconditions()
 {
-    return new Sine{*this};
+    checkUnaryDomain<ArcsineOperation>();
 }
 
-const char* Sine::helpMessageImpl() const noexcept
+void ArccosineOperation::CheckPreconditions()
 {
-    return "Replace the first element, x, on the stack with sin(x). x must be in radians";
+    checkUnaryDomain<ArccosineOperation>();
 }
 
-Cosine::Cosine(const Cosine& rhs)
-: UnaryCommand{rhs}
-{ }
+void ArctangentOperation::CheckPreconditions()
+{
+    checkUnaryDomain<ArctangentOperation>();
+}
 
-Cosine::~Cosine()
-{ }
+shared_ptr<const BigFloat> NegateOperation::Exact(const BigFloat& top, unsigned)
+{
+    return make_shared<const BigFloat>(-top);
+}
 
-double Cosine::unaryOperation(double top) const noexcept
+void NegateOperation::CheckPreconditions()
 {
-    return std::cos(top);
+    checkUnaryDomain<NegateOperation>();
 }
 
-Cosine* Cosine::cloneImpl() const
+shared_ptr<const BigFloat> SquareOperation::Exact(const BigFloat& top, unsigned digits)
 {
-    return new Cosine{*this};
+    return make_shared<const BigFloat>( BigFloat::Multiply(top, top, digits) );
 }
 
-const char* Cosine::helpMessageImpl() const noexcept
+void SquareOperation::CheckPreconditions()
 {
-    return "Replace the first element, x, on the stack with cos(x). x must be in radians";
+    checkUnaryDomain<SquareOperation>();
 }
 
-Tangent::Tangent(const Tangent& rhs)
-: UnaryCommand{rhs}
-{ }
+template<typename Op>
+void BinaryOperation<Op>::checkPreconditionsImpl() const
+{
+    BinaryCommand::checkPreconditionsImpl();
+    Op::CheckPreconditions();
 
-Tangent::~Tangent()
-{ }
+    return;
+}
 
-double Tangent::unaryOperation(double top) const noexcept
+template<typename Op>
+void BinaryOperation<Op>::executeImpl() noexcept
 {
-    return std::tan(top);
+    popOperands();
+    pushResult( Op::Apply(next_, top_), Op::Exact );
+
+    return;
 }
 
-Tangent* Tangent::cloneImpl() const
+template<typename Op>
+BinaryOperation<Op>* BinaryOperation<Op>::cloneImpl() const
 {
-    return new Tangent{*this};
+    return new BinaryOperation{*this};
 }
 
-const char* Tangent::helpMessageImpl() const noexcept
+template<typename Op>
+const char* BinaryOperation<Op>::helpMessageImpl() const noexcept
 {
-    return "Replace the first element, x, on the stack with tan(x). x must be in radians";
+    return Op::Help;
 }
 
-void Tangent::checkPreconditionsImpl() const
+template<typename Op>
+void UnaryOperation<Op>::checkPreconditionsImpl() const
 {
     UnaryCommand::checkPreconditionsImpl();
-
-    auto v = Stack::Instance().getElements(1);
-    double d{ v.back() + M_PI / 2. };
-    double r{ std::fabs(d) / std::fabs(M_PI) };
-    int w{ static_cast<int>(std::floor(r + eps)) };
-    r = r - w;
-    if(r < eps && r > -eps)
-        throw Exception{"Infinite result"};
+    Op::CheckPreconditions();
 
     return;
 }
 
-Arcsine::Arcsine(const Arcsine& rhs)
-: UnaryCommand{rhs}
-{ }
+template<typename Op>
+void UnaryOperation<Op>::executeImpl() noexcept
+{
+    popOperand();
+    pushResult( Op::Apply(top_), Op::Exact );
 
-Arcsine::~Arcsine()
-{ }
+    return;
+}
 
-double Arcsine::unaryOperation(double top) const noexcept
+template<typename Op>
+UnaryOperation<Op>* UnaryOperation<Op>::cloneImpl() const
 {
-    return std::asin(top);
+    return new UnaryOperation{*this};
 }
 
-Arcsine* Arcsine::cloneImpl() const
+template<typename Op>
+const char* UnaryOperation<Op>::helpMessageImpl() const noexcept
 {
-    return new Arcsine{*this};
+    return Op::Help;
 }
 
-const char* Arcsine::helpMessageImpl() const noexcept
+template class BinaryOperation<AddOperation>;
+template class BinaryOperation<SubtractOperation>;
+template class BinaryOperation<MultiplyOperation>;
+template class BinaryOperation<DivideOperation>;
+template class BinaryOperation<PowerOperation>;
+template class BinaryOperation<RootOperation>;
+template class UnaryOperation<SineOperation>;
+template class UnaryOperation<CosineOperation>;
+template class UnaryOperation<TangentOperation>;
+template class UnaryOperation<ArcsineOperation>;
+template class UnaryOperation<ArccosineOperation>;
+template class UnaryOperation<ArctangentOperation>;
+template class UnaryOperation<NegateOperation>;
+template class UnaryOperation<SquareOperation>;
+
+BlockUnaryCommand::BlockUnaryCommand(const string& help, Kernel* kernel, Domain* domain)
+: Command{}
+, helpMsg_{help}
+, kernel_{kernel}
+, domain_{domain}
 {
-    return "Replace the first element, x, on the stack with arcsin(x). Returns result in radians";
+    assert(kernel_);
 }
 
-void Arcsine::checkPreconditionsImpl() const
+BlockUnaryCommand::BlockUnaryCommand(const BlockUnaryCommand& rhs)
+: Command{rhs}
+, helpMsg_{rhs.helpMsg_}
+, kernel_{rhs.kernel_}
+, domain_{rhs.domain_}
+{ }
+
+BlockUnaryCommand::~BlockUnaryCommand()
+{ }
+
+void BlockUnaryCommand::checkPreconditionsImpl() const
 {
-    UnaryCommand::checkPreconditionsImpl();
+    size_t count{ checkBlockCount() };
 
-    if(!topOfStackisBetween(-1, 1))
-        throw Exception{"Invalid argument"};
+    if(domain_)
+    {
+        const Stack& stack = Stack::Instance();
+        operands_.resize(count + 1);
+        stack.peekElements( operands_.size(), operands_.data() );
+        for(size_t i = 0; i + 1 < operands_.size(); ++i)
+        {
+            if( const char* error = domain_(operands_[i]) )
+                throw Exception{error};
+        }
+    }
 
     return;
 }
 
-Arccosine::Arccosine(const Arccosine& rhs)
-: UnaryCommand{rhs}
-{ }
+void BlockUnaryCommand::executeImpl() noexcept
+{
+    Stack& stack = Stack::Instance();
+    size_t n{ static_cast<size_t>( stack.getElements(1).front() ) };
 
-Arccosine::~Arccosine()
-{ }
+    // the results carry no exact values, but the operands may, and undo restores them
+    operandsExact_ = stack.getExactElements(n + 1);
+    operands_.resize(n + 1);
+    stack.popElements( operands_.size(), operands_.data(), true );
 
-double Arccosine::unaryOperation(double top) const noexcept
-{
-    return std::acos(top);
+    vector<double> results(n);
+    kernel_( operands_.data(), results.data(), n );
+    stack.pushElements( results.data(), n, false );
+
+    return;
 }
 
-Arccosine* Arccosine::cloneImpl() const
+void BlockUnaryCommand::undoImpl() noexcept
 {
-    return new Arccosine{*this};
+    Stack& stack = Stack::Instance();
+    size_t n{ operands_.size() - 1 };
+    vector<double> results(n);
+    stack.popElements( n, results.data(), true );
+
+    restoreOperands(operands_, operandsExact_);
+
+    // a redo pops the operands again, so there is no reason to hold on to them
+    vector<double>{}.swap(operands_);
+    operandsExact_.clear();
+
+    return;
 }
 
-const char* Arccosine::helpMessageImpl() const noexcept
+BlockUnaryCommand* BlockUnaryCommand::cloneImpl() const
 {
-    return "Replace the first element, x, on the stack with arccos(x). Returns result in radians";
+    return new BlockUnaryCommand{*this};
 }
 
-void Arccosine::checkPreconditionsImpl() const
+const char* BlockUnaryCommand::helpMessageImpl() const noexcept
 {
-    UnaryCommand::checkPreconditionsImpl();
-
-    if(!topOfStackisBetween(-1, 1))
-        throw Exception{"Invalid argument"};
+    return helpMsg_.c_str();
+}
 
-    return;
+BlockCommand::BlockCommand(const string& help, Kernel* kernel)
+: Command{}
+, helpMsg_{help}
+, kernel_{kernel}
+, nResults_{0}
+{
+    assert(kernel_);
 }
 
-Arctangent::Arctangent(const Arctangent& rhs)
-: UnaryCommand{rhs}
+BlockCommand::BlockCommand(const BlockCommand& rhs)
+: Command{rhs}
+, helpMsg_{rhs.helpMsg_}
+, kernel_{rhs.kernel_}
+, nResults_{0}
 { }
 
-Arctangent::~Arctangent()
+BlockCommand::~BlockCommand()
 { }
 
-double Arctangent::unaryOperation(double top) const noexcept
+void BlockCommand::checkPreconditionsImpl() const
 {
-    return std::atan(top);
+    checkBlockCount();
+
+    return;
 }
 
-Arctangent* Arctangent::cloneImpl() const
+void BlockCommand::executeImpl() noexcept
 {
-    return new Arctangent{*this};
+    Stack& stack = Stack::Instance();
+    size_t n{ static_cast<size_t>( stack.getElements(1).front() ) };
+
+    // as with BlockUnaryCommand, the results carry no exact values, but undo
+    // restores those of the operands
+    operandsExact_ = stack.getExactElements(n + 1);
+    operands_.resize(n + 1);
+    stack.popElements( operands_.size(), operands_.data(), true );
+
+    vector<double> results( operands_.begin(), operands_.end() - 1 );
+    nResults_ = kernel_( results.data(), n );
+    stack.pushElements( results.data(), nResults_, false );
+
+    return;
 }
 
-const char* Arctangent::helpMessageImpl() const noexcept
+void BlockCommand::undoImpl() noexcept
 {
-    return "Replace the first element, x, on the stack with arctan(x). Returns result in radians";
-}
+    Stack& stack = Stack::Instance();
+    vector<double> results(nResults_);
+    stack.popElements( nResults_, results.data(), true );
 
-Negate::Negate(const Negate& rhs)
-: UnaryCommand{rhs}
-{ }
+    restoreOperands(operands_, operandsExact_);
 
-Negate::~Negate()
-{ }
+    vector<double>{}.swap(operands_);
+    operandsExact_.clear();
 
-double Negate::unaryOperation(double top) const noexcept
-{
-    return -top;
+    return;
 }
 
-Negate* Negate::cloneImpl() const
+BlockCommand* BlockCommand::cloneImpl() const
 {
-    return new Negate{*this};
+    return new BlockCommand{*this};
 }
 
-const char* Negate::helpMessageImpl() const noexcept
+const char* BlockCommand::helpMessageImpl() const noexcept
 {
-    return "Negates the top number on the stack";
+    return helpMsg_.c_str();
 }
 
 Duplicate::Duplicate(const Duplicate& rhs)
@@ -584,7 +711,8 @@ void Duplicate::checkPreconditionsImpl() const
 void Duplicate::executeImpl() noexcept
 {
     auto v = Stack::Instance().getElements(1);
-    Stack::Instance().push( v.back() );
+    auto exact = Stack::Instance().getExactElements(1);
+    Stack::Instance().push( v.back(), exact.back() );
 
     return;
 }
@@ -606,6 +734,57 @@ const char* Duplicate::helpMessageImpl() const noexcept
     return "Duplicates the top number on the stack";
 }
 
+SetPrecision::SetPrecision(const SetPrecision& rhs)
+: Command{rhs}
+, digits_{rhs.digits_}
+, digitsExact_{rhs.digitsExact_}
+, previous_{rhs.previous_}
+{ }
+
+SetPrecision::~SetPrecision()
+{ }
+
+void SetPrecision::checkPreconditionsImpl() const
+{
+    if( Stack::Instance().size() < 1 )
+        throw Exception{"Stack must have 1 element"};
+
+    auto d = Stack::Instance().getElements(1).front();
+    double intPart;
+    if( std::modf(d, &intPart) != 0.0 || d < 0 || d > MaxPrecision )
+        throw Exception{"Precision must be an integer from 0 to " + std::to_string(MaxPrecision)};
+
+    return;
+}
+
+void SetPrecision::executeImpl() noexcept
+{
+    // the precision is set first, so that the pop's event shows the stack in its mode
+    previous_ = Stack::Instance().precision();
+    Stack::Instance().setPrecision( static_cast<unsigned>( Stack::Instance().getElements(1).front() ) );
+    digits_ = Stack::Instance().pop(digitsExact_);
+
+    return;
+}
+
+void SetPrecision::undoImpl() noexcept
+{
+    Stack::Instance().setPrecision(previous_);
+    Stack::Instance().push(digits_, digitsExact_);
+
+    return;
+}
+
+SetPrecision* SetPrecision::cloneImpl() const
+{
+    return new SetPrecision{*this};
+}
+
+const char* SetPrecision::helpMessageImpl() const noexcept
+{
+    return "Carry subsequent entries and arithmetic to x significant digits exactly, or return to double arithmetic if x is 0";
+}
+
 void RegisterCoreCommands(UserInterface& ui)
 {
     registerCommand( ui, "swap", MakeCommandPtr<SwapTopOfStack>() );
@@ -613,12 +792,7 @@ void RegisterCoreCommands(UserInterface& ui)
     registerCommand( ui, "clear", MakeCommandPtr<ClearStack>() );
     registerCommand( ui, "+", MakeCommandPtr<Add>() );
     registerCommand( ui, "-", MakeCommandPtr<Subtract>() );
-    registerCommand
-    (
-        ui, "*",
-        MakeCommandPtr<BinaryCommandAlternative>("Replace first two elements on the stack with their product",
-        [](double d, double f){ return d * f; })
-    );
+    registerCommand( ui, "*", MakeCommandPtr<Multiply>() );
     registerCommand( ui, "/", MakeCommandPtr<Divide>() );
     registerCommand( ui, "pow", MakeCommandPtr<Power>() );
     registerCommand( ui, "root", MakeCommandPtr<Root>() );
@@ -628,8 +802,70 @@ void RegisterCoreCommands(UserInterface& ui)
     registerCommand( ui, "arcsin", MakeCommandPtr<Arcsine>() );
     registerCommand( ui, "arccos", MakeCommandPtr<Arccosine>() );
     registerCommand( ui, "arctan", MakeCommandPtr<Arctangent>() );
+    registerCommand
+    (
+        ui, "sinn",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their sines. Note, n is top of stack",
+        VectorMath::Sin)
+    );
+    registerCommand
+    (
+        ui, "cosn",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their cosines. Note, n is top of stack",
+        VectorMath::Cos)
+    );
+    registerCommand
+    (
+        ui, "tann",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their tangents. Note, n is top of stack",
+        VectorMath::Tan, TangentDomain)
+    );
+    registerCommand
+    (
+        ui, "arcsinn",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their arcsines. Note, n is top of stack",
+        VectorMath::Asin, InverseTrigDomain)
+    );
+    registerCommand
+    (
+        ui, "arccosn",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their arccosines. Note, n is top of stack",
+        VectorMath::Acos, InverseTrigDomain)
+    );
+    registerCommand
+    (
+        ui, "arctann",
+        MakeCommandPtr<BlockUnaryCommand>("Replace the top n elements on the stack with their arctangents. Note, n is top of stack",
+        VectorMath::Atan)
+    );
+    registerCommand
+    (
+        ui, "sortn",
+        MakeCommandPtr<BlockCommand>("Sort the top n elements on the stack, increasing toward the top. Note, n is top of stack",
+        [](double* x, size_t n){ BlockAlgorithms::Sort(x, n); return n; })
+    );
+    registerCommand
+    (
+        ui, "uniquen",
+        MakeCommandPtr<BlockCommand>("Remove repeated values from the top n elements on the stack, keeping the deepest of each. Note, n is top of stack",
+        BlockAlgorithms::Unique)
+    );
+    registerCommand
+    (
+        ui, "cumsumn",
+        MakeCommandPtr<BlockCommand>("Replace the top n elements on the stack with their running sums, starting from the deepest. Note, n is top of stack",
+        [](double* x, size_t n){ BlockAlgorithms::PrefixSum(x, n); return n; })
+    );
+    registerCommand
+    (
+        ui, "cumprodn",
+        MakeCommandPtr<BlockCommand>("Replace the top n elements on the stack with their running products, starting from the deepest. Note, n is top of stack",
+        [](double* x, size_t n){ BlockAlgorithms::PrefixProduct(x, n); return n; })
+    );
     registerCommand( ui, "neg", MakeCommandPtr<Negate>() );
+    registerCommand( ui, "sq", MakeCommandPtr<Square>() );
     registerCommand( ui, "dup", MakeCommandPtr<Duplicate>() );
+    registerCommand( ui, "prec", MakeCommandPtr<SetPrecision>() );
 
     return;
 }
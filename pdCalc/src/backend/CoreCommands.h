@@ -22,6 +22,7 @@
 #include "Command.h"
 #include <string>
 #include <stack>
+#include <vector>
 
 namespace pdCalc {
 
@@ -31,6 +32,9 @@ class EnterNumber : public Command
 {
 public:
     explicit EnterNumber(double d);
+
+    // in exact mode, a number entered with its exact value; d is its nearest double
+    EnterNumber(double d, std::shared_ptr<const BigFloat> exact);
     explicit EnterNumber(const EnterNumber&);
     ~EnterNumber();
 
@@ -50,6 +54,7 @@ private:
     const char* helpMessageImpl() const noexcept override;
 
     double number_;
+    std::shared_ptr<const BigFloat> exact_;
 };
 
 // swaps two numbers on the stack
@@ -108,6 +113,7 @@ private:
     const char* helpMessageImpl() const noexcept override;
 
     double droppedNumber_;
+    std::shared_ptr<const BigFloat> droppedExact_;
 };
 
 // clear the stack
@@ -135,290 +141,235 @@ private:
     const char* helpMessageImpl() const noexcept override;
 
     std::stack<double> stack_;
+    std::stack< std::shared_ptr<const BigFloat> > exact_;
 };
 
-// adds two elements on the stack
-class Add : public BinaryCommand
+// Binary commands generated from an operation, Op, such as those of CoreOperations.h,
+// which lists the static members an operation supplies. Op is only declared here.
+// The instantiations of the operations below are in CoreCommands.cpp, where Apply is
+// inlined into executeImpl rather than called through the vtable. A clone copies only
+// the operands.
+template<typename Op>
+class BinaryOperation final : public BinaryCommand
 {
 public:
-    Add() { }
-    explicit Add(const Add&);
-    ~Add();
+    BinaryOperation() { }
+    explicit BinaryOperation(const BinaryOperation& rhs) : BinaryCommand{rhs} { }
+    ~BinaryOperation() { }
 
 private:
-    Add(Add&&) = delete;
-    Add& operator=(const Add&) = delete;
-    Add& operator=(Add&&) = delete;
+    BinaryOperation(BinaryOperation&&) = delete;
+    BinaryOperation& operator=(const BinaryOperation&) = delete;
+    BinaryOperation& operator=(BinaryOperation&&) = delete;
+
+    void checkPreconditionsImpl() const override;
 
-    double binaryOperation(double next, double top) const noexcept override;
+    void executeImpl() noexcept override;
 
-    Add* cloneImpl() const override;
+    BinaryOperation* cloneImpl() const override;
 
     const char* helpMessageImpl() const noexcept override;
 };
 
-// subtracts two elements on the stack
-class Subtract : public BinaryCommand
+// unary commands generated from an operation, Op, as for BinaryOperation, except that
+// Apply(top) takes the one operand
+template<typename Op>
+class UnaryOperation final : public UnaryCommand
 {
 public:
-    Subtract() { }
-    explicit Subtract(const Subtract&);
-    ~Subtract();
+    UnaryOperation() { }
+    explicit UnaryOperation(const UnaryOperation& rhs) : UnaryCommand{rhs} { }
+    ~UnaryOperation() { }
 
 private:
-    Subtract(Subtract&&) = delete;
-    Subtract& operator=(const Subtract&) = delete;
-    Subtract& operator=(Subtract&&) = delete;
+    UnaryOperation(UnaryOperation&&) = delete;
+    UnaryOperation& operator=(const UnaryOperation&) = delete;
+    UnaryOperation& operator=(UnaryOperation&&) = delete;
+
+    void checkPreconditionsImpl() const override;
 
-    double binaryOperation(double next, double top) const noexcept override;
+    void executeImpl() noexcept override;
 
-    Subtract* cloneImpl() const override;
+    UnaryOperation* cloneImpl() const override;
 
     const char* helpMessageImpl() const noexcept override;
 };
 
-// class Multiply is missing. It is achieved through BinaryCommandAlterative.
-// See its creation in RegisterCoreCommands()
-
-// divides two elements on the stack
-// precondition: divisor cannot be zero
-class Divide : public BinaryCommand
-{
-public:
-    Divide() { }
-    explicit Divide(const Divide&);
-    ~Divide();
-
-private:
-    Divide(Divide&&) = delete;
-    Divide& operator=(const Divide&) = delete;
-    Divide& operator=(Divide&&) = delete;
+struct AddOperation;
+struct SubtractOperation;
+struct MultiplyOperation;
+struct DivideOperation;
+struct PowerOperation;
+struct RootOperation;
+struct SineOperation;
+struct CosineOperation;
+struct TangentOperation;
+struct ArcsineOperation;
+struct ArccosineOperation;
+struct ArctangentOperation;
+struct NegateOperation;
+struct SquareOperation;
 
-    // checks binary preconditions
-    // and throws if division by 0
-    // checks for true 0, not epsilon close
-    void checkPreconditionsImpl() const override;
+// adds two elements on the stack
+using Add = BinaryOperation<AddOperation>;
 
-    double binaryOperation(double next, double top) const noexcept override;
+// subtracts two elements on the stack
+using Subtract = BinaryOperation<SubtractOperation>;
 
-    Divide* cloneImpl() const override;
+// multiplies two elements on the stack
+using Multiply = BinaryOperation<MultiplyOperation>;
 
-    const char* helpMessageImpl() const noexcept override;
-};
+// divides two elements on the stack
+// precondition: divisor cannot be zero (true 0, not epsilon close)
+using Divide = BinaryOperation<DivideOperation>;
 
 // takes two numbers from the stack (y == next, x == top) and implements y^x
 // preconditions: 1) Two elements on the stack
 //                2) If y == 0, x must be >= 0
 //                3) If y < 0, x must be integral
-class Power : public BinaryCommand
-{
-public:
-    Power() { }
-    explicit Power(const Power&);
-    ~Power();
-
-private:
-    Power(Power&&) = delete;
-    Power& operator=(const Power&) = delete;
-    Power& operator=(Power&&) = delete;
-
-    // throws if preconditions are not met
-    void checkPreconditionsImpl() const override;
-
-    double binaryOperation(double next, double top) const noexcept override;
-
-    Power* cloneImpl() const override;
-
-    const char* helpMessageImpl() const noexcept override;
-};
+using Power = BinaryOperation<PowerOperation>;
 
 // takes two numbers from the stack (y == next, x == top) and implements xth root of y
 // preconditions: 1) Two elements on the stack
 //                2) If y == 0, x must be >= 0
 //                3) If y < 0, 1/x must be integral
 //                4) x != 0
-class Root : public BinaryCommand
-{
-public:
-    Root() { }
-    explicit Root(const Root&);
-    ~Root();
-
-private:
-    Root(Root&&) = delete;
-    Root& operator=(const Root&) = delete;
-    Root& operator=(Root&&) = delete;
-
-    // throws if preconditions are not met
-    void checkPreconditionsImpl() const override;
-
-    double binaryOperation(double next, double top) const noexcept override;
-
-    Root* cloneImpl() const override;
-
-    const char* helpMessageImpl() const noexcept override;
-};
+using Root = BinaryOperation<RootOperation>;
 
 // takes the sine of a number on the stack in radians
 // precondition: at least one number on the stack
-class Sine : public UnaryCommand
-{
-public:
-    Sine() { }
-    explicit Sine(const Sine&);
-    ~Sine();
-
-private:
-    Sine(Sine&&) = delete;
-    Sine& operator=(const Sine&) = delete;
-    Sine& operator=(Sine&&) = delete;
-
-    double unaryOperation(double top) const noexcept override;
-
-    Sine* cloneImpl() const override;
-
-    const char* helpMessageImpl() const noexcept override;
-};
+using Sine = UnaryOperation<SineOperation>;
 
 // takes the cosine of a number on the stack in radians
 // precondition: at least one number on the stack
-class Cosine : public UnaryCommand
-{
-public:
-    Cosine() { }
-    explicit Cosine(const Cosine&);
-    ~Cosine();
-
-private:
-    Cosine(Cosine&&) = delete;
-    Cosine& operator=(const Cosine&) = delete;
-    Cosine& operator=(Cosine&&) = delete;
-
-    double unaryOperation(double top) const noexcept override;
-
-    Cosine* cloneImpl() const override;
-
-    const char* helpMessageImpl() const noexcept override;
-};
+using Cosine = UnaryOperation<CosineOperation>;
 
 // takes the tangent of a number on the stack in radians
 // preconditions: 1) at least one number on the stack
 //                2) number cannot be a multiple of pi/2 +/- pi
-class Tangent : public UnaryCommand
-{
-public:
-    Tangent() { }
-    explicit Tangent(const Tangent&);
-    ~Tangent();
-
-private:
-    Tangent(Tangent&&) = delete;
-    Tangent& operator=(const Tangent&) = delete;
-    Tangent& operator=(Tangent&&) = delete;
-
-    // checks unary condition
-    // throws if a multiple of pi/2 +/- pi
-    void checkPreconditionsImpl() const override;
-
-    double unaryOperation(double top) const noexcept override;
-
-    Tangent* cloneImpl() const override;
-
-    const char* helpMessageImpl() const noexcept override;
-};
+using Tangent = UnaryOperation<TangentOperation>;
 
 // takes the arcsine of a number on the stack and returns radians
 // preconditions: 1) at least one number on the stack
 //                2) number, x, must satisfy -1 <= x <= 1
-class Arcsine : public UnaryCommand
-{
-public:
-    Arcsine() { }
-    explicit Arcsine(const Arcsine&);
-    ~Arcsine();
-
-private:
-    Arcsine(Arcsine&&) = delete;
-    Arcsine& operator=(const Arcsine&) = delete;
-    Arcsine& operator=(Arcsine&&) = delete;
+using Arcsine = UnaryOperation<ArcsineOperation>;
 
-    // checks unary condition
-    // throws if value outside [-1, 1]
-    void checkPreconditionsImpl() const override;
-
-    double unaryOperation(double top) const noexcept override;
+// takes the arccosine of a number on the stack and returns radians
+// preconditions: 1) at least one number on the stack
+//                2) number, x, must satisfy -1 <= x <= 1
+using Arccosine = UnaryOperation<ArccosineOperation>;
 
-    Arcsine* cloneImpl() const override;
+// takes the arctangent of a number on the stack and returns radians
+// precondition: at least one number on the stack
+using Arctangent = UnaryOperation<ArctangentOperation>;
 
-    const char* helpMessageImpl() const noexcept override;
-};
+// takes the top of the stack and negates it
+// precondition: at least one number on the stack
+using Negate = UnaryOperation<NegateOperation>;
 
-// takes the arccosine of a number on the stack and returns radians
-// preconditions: 1) at lesat one number on the stack
-//                2) number, x, must satisfy -1 <= x <= 1
-class Arccosine : public UnaryCommand
+// squares the top of the stack; the same result as dup followed by *
+// precondition: at least one number on the stack
+using Square = UnaryOperation<SquareOperation>;
+
+extern template class BinaryOperation<AddOperation>;
+extern template class BinaryOperation<SubtractOperation>;
+extern template class BinaryOperation<MultiplyOperation>;
+extern template class BinaryOperation<DivideOperation>;
+extern template class BinaryOperation<PowerOperation>;
+extern template class BinaryOperation<RootOperation>;
+extern template class UnaryOperation<SineOperation>;
+extern template class UnaryOperation<CosineOperation>;
+extern template class UnaryOperation<TangentOperation>;
+extern template class UnaryOperation<ArcsineOperation>;
+extern template class UnaryOperation<ArccosineOperation>;
+extern template class UnaryOperation<ArctangentOperation>;
+extern template class UnaryOperation<NegateOperation>;
+extern template class UnaryOperation<SquareOperation>;
+
+// applies a function to each of the n elements below a count n on the top of the
+// stack, evaluating the whole block at once with the VectorMath kernels; the count
+// and the block are replaced by the n results, and undo restores them as one command
+// preconditions: 1) the top of the stack is a positive integer count, n
+//                2) at least n numbers below the count
+//                3) each of the n numbers in the domain of the function
+class BlockUnaryCommand final : public Command
 {
 public:
-    Arccosine() { }
-    explicit Arccosine(const Arccosine&);
-    ~Arccosine();
+    using Kernel = void(const double*, double*, size_t);
+
+    // returns an error message if the argument is outside the function's domain
+    using Domain = const char*(double);
+
+    BlockUnaryCommand(const std::string& help, Kernel* kernel, Domain* domain = nullptr);
+    ~BlockUnaryCommand();
 
 private:
-    Arccosine(Arccosine&&) = delete;
-    Arccosine& operator=(const Arccosine&) = delete;
-    Arccosine& operator=(Arccosine&&) = delete;
+    BlockUnaryCommand(BlockUnaryCommand&&) = delete;
+    BlockUnaryCommand& operator=(const BlockUnaryCommand&) = delete;
+    BlockUnaryCommand& operator=(BlockUnaryCommand&&) = delete;
+
+    BlockUnaryCommand(const BlockUnaryCommand&);
 
-    // check unary condition
-    // throws if value outside [-1, 1]
     void checkPreconditionsImpl() const override;
 
-    double unaryOperation(double top) const noexcept override;
+    void executeImpl() noexcept override;
+
+    // drops the results and returns the count and the original numbers to the stack
+    void undoImpl() noexcept override;
 
-    Arccosine* cloneImpl() const override;
+    BlockUnaryCommand* cloneImpl() const override;
 
     const char* helpMessageImpl() const noexcept override;
+
+    std::string helpMsg_;
+    Kernel* kernel_;
+    Domain* domain_;
+
+    // operands in stack order, bottom first: the block, then the count
+    mutable std::vector<double> operands_;
+    std::vector<std::shared_ptr<const BigFloat>> operandsExact_;
 };
 
-// takes the arctangent of a number ron the stack and returns radians
-// precondition: at least one number on the stack
-class Arctangent : public UnaryCommand
+// replaces the n elements below a count n on the top of the stack with the results
+// of an algorithm over the whole block, which may leave fewer than n; the count and
+// the block are replaced by the results, and undo restores them as one command
+// preconditions: 1) the top of the stack is a positive integer count, n
+//                2) at least n numbers below the count
+class BlockCommand final : public Command
 {
 public:
-    Arctangent() { }
-    explicit Arctangent(const Arctangent&);
-    ~Arctangent();
+    // works on the block in place, in stack order, bottom first, and returns the
+    // number of results left at its front
+    using Kernel = size_t(double*, size_t);
+
+    BlockCommand(const std::string& help, Kernel* kernel);
+    ~BlockCommand();
 
 private:
-    Arctangent(Arctangent&&) = delete;
-    Arctangent& operator=(const Arctangent&) = delete;
-    Arctangent& operator=(Arctangent&&) = delete;
+    BlockCommand(BlockCommand&&) = delete;
+    BlockCommand& operator=(const BlockCommand&) = delete;
+    BlockCommand& operator=(BlockCommand&&) = delete;
 
-    double unaryOperation(double top) const noexcept override;
+    BlockCommand(const BlockCommand&);
 
-    Arctangent* cloneImpl() const override;
+    void checkPreconditionsImpl() const override;
 
-    const char* helpMessageImpl() const noexcept override;
-};
+    void executeImpl() noexcept override;
 
-// takes the top of the stack and negates it
-// precondition: at least one number on the stack
-class Negate : public UnaryCommand
-{
-public:
-    Negate() { }
-    explicit Negate(const Negate&);
-    ~Negate();
+    // drops the results and returns the count and the original numbers to the stack
+    void undoImpl() noexcept override;
 
- private:
-    Negate(Negate&&) = delete;
-    Negate& operator=(const Negate&) = delete;
-    Negate& operator=(Negate&&) = delete;
+    BlockCommand* cloneImpl() const override;
 
-    double unaryOperation(double top) const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
 
-    Negate* cloneImpl() const override;
+    std::string helpMsg_;
+    Kernel* kernel_;
 
-    const char* helpMessageImpl() const noexcept override;
+    // operands in stack order, bottom first: the block, then the count
+    std::vector<double> operands_;
+    std::vector<std::shared_ptr<const BigFloat>> operandsExact_;
+    size_t nResults_;
 };
 
 // takes the top of the stack and duplicates it
@@ -447,6 +398,40 @@ private:
 
 };
 
+// sets the precision of exact mode from the top of the stack: numbers entered and
+// results of the arithmetic commands then carry that many significant digits, and
+// 0 returns to plain double arithmetic
+// precondition: the top of the stack is an integer between 0 and MaxPrecision
+class SetPrecision : public Command
+{
+public:
+    SetPrecision() { }
+    explicit SetPrecision(const SetPrecision&);
+    ~SetPrecision();
+
+    static const unsigned MaxPrecision = 1000000;
+
+private:
+    SetPrecision(SetPrecision&&) = delete;
+    SetPrecision& operator=(const SetPrecision&) = delete;
+    SetPrecision& operator=(SetPrecision&&) = delete;
+
+    void checkPreconditionsImpl() const override;
+
+    void executeImpl() noexcept override;
+
+    // restores the previous precision and returns the number to the stack
+    void undoImpl() noexcept override;
+
+    SetPrecision* cloneImpl() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+
+    double digits_;
+    std::shared_ptr<const BigFloat> digitsExact_;
+    unsigned previous_;
+};
+
 class UserInterface;
 void RegisterCoreCommands(UserInterface& ui);
 
@@ -0,0 +1,188 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CORE_OPERATIONS_H
+#define CORE_OPERATIONS_H
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+namespace pdCalc {
+
+class BigFloat;
+
+// tan is infinite at odd multiples of pi/2; returns an error message or nullptr
+const char* TangentDomain(double x);
+
+// returns an error message or nullptr
+const char* InverseTrigDomain(double x);
+
+// for y^x, y == 0 needs x >= 0 and y < 0 needs an integral x; also works for the
+// nth root of y with x = 1/n
+bool PassesPowerTest(double y, double x);
+
+// The operations behind the arithmetic core commands (see BinaryOperation and
+// UnaryOperation in CoreCommands.h), and the only definition of what they compute
+// and of which operands are invalid, so that code evaluating them off the stack, such
+// as MapProcedure, agrees with the commands. Each supplies
+//   Help                        the help message, in static storage
+//   Apply(next, top)            the result of doubles, or Apply(top) if unary
+//   Domain(next, top)           an error message if the doubles are invalid operands,
+//                               else nullptr; Domain(top) if unary
+//   Exact                       computes the exact result in exact mode, or is nullptr
+//   CheckPreconditions()        throws if the operands on the stack are invalid, by
+//                               Domain unless exact mode allows more; the stack size
+//                               has already been checked
+// Exact and CheckPreconditions are defined in CoreCommands.cpp.
+
+struct AddOperation
+{
+    static constexpr const char* Help = "Replace first two elements on the stack with their sum";
+    static double Apply(double next, double top) { return next + top; }
+    static const char* Domain(double, double) { return nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct SubtractOperation
+{
+    static constexpr const char* Help = "Replace first two elements on the stack with their difference";
+    static double Apply(double next, double top) { return next - top; }
+    static const char* Domain(double, double) { return nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct MultiplyOperation
+{
+    static constexpr const char* Help = "Replace first two elements on the stack with their product";
+    static double Apply(double next, double top) { return next * top; }
+    static const char* Domain(double, double) { return nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+// division by true 0, not epsilon close, is invalid
+struct DivideOperation
+{
+    static constexpr const char* Help = "Replace first two elements on the stack with their quotient";
+    static double Apply(double next, double top) { return next / top; }
+    static const char* Domain(double, double top) { return top == 0. ? "Division by zero" : nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct PowerOperation
+{
+    static constexpr const char* Help = "Replace first two elements on the stack, y, x, with y^x. Note, x is top of stack";
+    static double Apply(double next, double top) { return std::pow(next, top); }
+    static const char* Domain(double next, double top) { return PassesPowerTest(next, top) ? nullptr : "Invalid result"; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct RootOperation
+{
+    static constexpr const char* Help = "Replace first two elements on teh stack, y, x, with xth root of y. Note, x is top of stack";
+    static double Apply(double next, double top) { return std::pow(next, 1. / top); }
+
+    static const char* Domain(double next, double top)
+    {
+        return PassesPowerTest(next, 1. / top) && top != 0.0 ? nullptr : "Invalid result";
+    }
+
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& next, const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct SineOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with sin(x). x must be in radians";
+    static double Apply(double top) { return std::sin(top); }
+    static const char* Domain(double) { return nullptr; }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct CosineOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with cos(x). x must be in radians";
+    static double Apply(double top) { return std::cos(top); }
+    static const char* Domain(double) { return nullptr; }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct TangentOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with tan(x). x must be in radians";
+    static double Apply(double top) { return std::tan(top); }
+    static const char* Domain(double top) { return TangentDomain(top); }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct ArcsineOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with arcsin(x). Returns result in radians";
+    static double Apply(double top) { return std::asin(top); }
+    static const char* Domain(double top) { return InverseTrigDomain(top); }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct ArccosineOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with arccos(x). Returns result in radians";
+    static double Apply(double top) { return std::acos(top); }
+    static const char* Domain(double top) { return InverseTrigDomain(top); }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct ArctangentOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with arctan(x). Returns result in radians";
+    static double Apply(double top) { return std::atan(top); }
+    static const char* Domain(double) { return nullptr; }
+    static constexpr std::nullptr_t Exact{};
+    static void CheckPreconditions();
+};
+
+struct NegateOperation
+{
+    static constexpr const char* Help = "Negates the top number on the stack";
+    static double Apply(double top) { return -top; }
+    static const char* Domain(double) { return nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+struct SquareOperation
+{
+    static constexpr const char* Help = "Replace the first element, x, on the stack with x squared";
+    static double Apply(double top) { return top * top; }
+    static const char* Domain(double) { return nullptr; }
+    static std::shared_ptr<const BigFloat> Exact(const BigFloat& top, unsigned digits);
+    static void CheckPreconditions();
+};
+
+}
+
+#endif
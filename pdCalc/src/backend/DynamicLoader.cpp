@@ -24,4 +24,9 @@ DynamicLoader::~DynamicLoader()
 {
 }
 
+std::string DynamicLoader::loadedFrom() const
+{
+    return {};
+}
+
 }
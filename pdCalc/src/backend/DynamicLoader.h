@@ -46,6 +46,11 @@ public:
     virtual Plugin* allocatePlugin(const std::string& pluginName) = 0;
     virtual void deallocatePlugin(Plugin*) = 0;
 
+    // the file the plugin allocated last was loaded from, as the system found it,
+    // which for a name without a directory may be anywhere on the library search
+    // path; empty if it is not known
+    virtual std::string loadedFrom() const;
+
     // Get the plugin allocation name for derived classes
     static const std::string GetPluginAllocationName() { return "AllocPlugin"; }
     static const std::string GetPluginDeallocationName() { return "DeallocPlugin"; }
@@ -0,0 +1,46 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+// This is the base class to abstract OS specific watching of files for changes.
+// Linux is told of changes by inotify, other POSIX systems look for them twice a
+// second, and Windows waits for change notifications on the files' directories.
+// A file changes when it is written in place or when another file is renamed over
+// it, as install(1) does; either way, it is reported once it is complete.
+
+#include <functional>
+#include <string>
+
+namespace pdCalc {
+
+class FileWatcher
+{
+public:
+    // called, on the watcher's own thread, with the name of a file that changed as
+    // it was given to the watcher
+    using Changed = std::function<void(const std::string& filename)>;
+
+    // stops watching, waiting for a call of changed that is under way to return
+    virtual ~FileWatcher();
+};
+
+}
+
+#endif
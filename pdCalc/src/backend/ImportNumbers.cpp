@@ -0,0 +1,175 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ImportNumbers.h"
+#include "Stack.h"
+#include "MappedFile.h"
+#include "PlatformFactory.h"
+#include "utilities/Exception.h"
+#include "utilities/NumberParsing.h"
+#include "utilities/ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::ostringstream;
+
+namespace pdCalc {
+
+namespace {
+
+const size_t CopyChunk = size_t{1} << 17;
+
+bool littleEndian()
+{
+    const uint16_t probe{1};
+    char first;
+    std::memcpy( &first, &probe, sizeof(first) );
+
+    return first == 1;
+}
+
+uint64_t swapBytes(uint64_t w)
+{
+    w = ((w & 0x00FF00FF00FF00FFULL) << 8) | ((w >> 8) & 0x00FF00FF00FF00FFULL);
+    w = ((w & 0x0000FFFF0000FFFFULL) << 16) | ((w >> 16) & 0x0000FFFF0000FFFFULL);
+    return (w << 32) | (w >> 32);
+}
+
+// names the bad token, and its line, in the message
+string badTokenMessage(const string& filename, const char* text, size_t n, size_t offset)
+{
+    const size_t line{ static_cast<size_t>( std::count(text, text + offset, '\n') ) + 1 };
+
+    size_t end{offset};
+    while( end < n && !NumberParsing::IsSeparator(text[end]) && end - offset < 32 ) ++end;
+
+    ostringstream oss;
+    oss << filename << " line " << line << ": " << string{text + offset, end - offset} << " is not a number";
+
+    return oss.str();
+}
+
+}
+
+vector<double> ReadTextNumbers(const string& filename)
+{
+    auto file = PlatformFactory::Instance().createMappedFile(filename);
+
+    vector<double> x;
+    size_t badToken;
+    if( !NumberParsing::ParseText(file->data(), file->size(), x, badToken) )
+        throw Exception{ badTokenMessage(filename, file->data(), file->size(), badToken) };
+
+    return x;
+}
+
+vector<double> ReadBinaryNumbers(const string& filename)
+{
+    auto file = PlatformFactory::Instance().createMappedFile(filename);
+    const size_t size{ file->size() };
+    if(size % sizeof(double) != 0)
+        throw Exception{filename + " is not a whole number of doubles"};
+
+    const size_t n{ size / sizeof(double) };
+    vector<double> x(n);
+    const char* data{ file->data() };
+    const bool swap{ !littleEndian() };
+    ThreadPool::Instance().parallelFor(n, CopyChunk, [&](size_t, size_t begin, size_t end)
+    {
+        std::memcpy( x.data() + begin, data + begin * sizeof(double), (end - begin) * sizeof(double) );
+        if(!swap) return;
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            uint64_t w;
+            std::memcpy( &w, &x[i], sizeof(w) );
+            w = swapBytes(w);
+            std::memcpy( &x[i], &w, sizeof(w) );
+        }
+    });
+
+    return x;
+}
+
+ImportNumbers::ImportNumbers(const string& filename, Format format)
+: filename_{filename}
+, format_{format}
+{ }
+
+ImportNumbers::~ImportNumbers()
+{ }
+
+// the file is read, once, as the precondition, so that a bad file leaves the stack
+// alone; so does a file of no numbers, which would leave an undo record that
+// undoes nothing
+void ImportNumbers::checkPreconditionsImpl() const
+{
+    if(!read_)
+    {
+        numbers_ = format_ == Format::Text ? ReadTextNumbers(filename_) : ReadBinaryNumbers(filename_);
+        count_ = numbers_.size();
+        read_ = true;
+    }
+
+    if(count_ == 0)
+        throw Exception{filename_ + " holds no numbers; nothing imported"};
+
+    return;
+}
+
+// onto an empty stack, the numbers are exchanged in rather than copied
+void ImportNumbers::executeImpl() noexcept
+{
+    Stack& stack = Stack::Instance();
+    if( stack.size() == 0 )
+    {
+        vector<Stack::ExactValue> noExact;
+        stack.swapElements(numbers_, noExact);
+    }
+    else
+        stack.pushElements( numbers_.data(), count_ );
+
+    vector<double>{}.swap(numbers_);
+
+    return;
+}
+
+void ImportNumbers::undoImpl() noexcept
+{
+    numbers_.resize(count_);
+    Stack::Instance().popElements( count_, numbers_.data() );
+
+    return;
+}
+
+Command* ImportNumbers::cloneImpl() const noexcept
+{
+    return 0;
+}
+
+const char* ImportNumbers::helpMessageImpl() const noexcept
+{
+    return format_ == Format::Text ? "Pushes the numbers in a text or CSV file onto the stack"
+        : "Pushes the little endian doubles in a binary file onto the stack";
+}
+
+}
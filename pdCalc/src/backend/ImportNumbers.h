@@ -0,0 +1,78 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMPORT_NUMBERS_H
+#define IMPORT_NUMBERS_H
+
+#include "Command.h"
+#include <string>
+#include <vector>
+
+namespace pdCalc {
+
+// Bulk import of numbers from a file onto the stack, without passing them through
+// the dispatcher one token at a time. Files are read through a memory mapping. A
+// text file holds decimal numbers separated by whitespace, commas or semicolons,
+// so CSV files of numbers import as they are, row by row; the numbers are found
+// and parsed in parallel chunks. A binary file holds little endian doubles and
+// nothing else. Imported numbers carry no exact values.
+
+// the numbers in a text file, in order; throws Exception if the file cannot be
+// read or holds anything but numbers
+std::vector<double> ReadTextNumbers(const std::string& filename);
+
+// the doubles in a binary file, in order; throws Exception if the file cannot be
+// read or its size is not a multiple of a double
+std::vector<double> ReadBinaryNumbers(const std::string& filename);
+
+// pushes every number of a file onto the stack, the first deepest, as a single
+// command that undo removes at once
+// precondition: the file can be read as the given format
+class ImportNumbers : public Command
+{
+public:
+    enum class Format { Text, Binary };
+
+    ImportNumbers(const std::string& filename, Format format);
+    ~ImportNumbers();
+
+private:
+    ImportNumbers() = delete;
+    ImportNumbers(ImportNumbers&&) = delete;
+    ImportNumbers& operator=(const ImportNumbers&) = delete;
+    ImportNumbers& operator=(ImportNumbers&&) = delete;
+    ImportNumbers(const ImportNumbers&) = delete;
+
+    void checkPreconditionsImpl() const override;
+    void executeImpl() noexcept override;
+    void undoImpl() noexcept override;
+    Command* cloneImpl() const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
+
+    std::string filename_;
+    Format format_;
+
+    // the numbers while they are off the stack: before execution and after undo
+    mutable std::vector<double> numbers_;
+    mutable size_t count_ = 0;
+    mutable bool read_ = false;
+};
+
+}
+
+#endif
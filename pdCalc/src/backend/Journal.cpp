@@ -0,0 +1,548 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Journal.h"
+#include "AppendFile.h"
+#include "MappedFile.h"
+#include "PlatformFactory.h"
+#include "utilities/Exception.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::function;
+using std::unique_lock;
+using std::mutex;
+
+namespace pdCalc {
+
+namespace {
+
+const char Magic[8] = {'p', 'd', 'C', 'a', 'l', 'c', 'J', 'L'};
+const uint32_t JournalVersion = 2;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t zero;
+    uint64_t generation;
+};
+
+static_assert(sizeof(Header) == 24, "the journal header is 24 bytes");
+
+const size_t BatchHeaderSize = sizeof(uint32_t) + sizeof(uint64_t);
+const size_t MaxVarint = 10;
+
+// a power of two, so positions wrap with a mask
+const size_t RingSize = size_t{1} << 20;
+
+const char NumberRecord = 'n';
+const char TokenRecord = 't';
+
+// FNV-1a taken a word at a time, then bytewise over the rest; a batch holds a
+// window of entries, and hashing it bytewise was most of the flusher's work
+uint64_t checksum(const char* p, size_t n)
+{
+    uint64_t h{0xCBF29CE484222325ULL};
+    size_t i{0};
+    for(; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        uint64_t w;
+        std::memcpy( &w, p + i, sizeof(w) );
+        h ^= w;
+        h *= 0x100000001B3ULL;
+    }
+    for(; i < n; ++i)
+    {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 0x100000001B3ULL;
+    }
+
+    return h;
+}
+
+// writes v at p, returning the number of bytes, at most MaxVarint
+size_t putVarint(char* p, uint64_t v)
+{
+    size_t n{0};
+    while(v >= 0x80)
+    {
+        p[n++] = static_cast<char>( (v & 0x7F) | 0x80 );
+        v >>= 7;
+    }
+    p[n++] = static_cast<char>(v);
+
+    return n;
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& v)
+{
+    v = 0;
+    for(int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        const unsigned char c = static_cast<unsigned char>(*p++);
+        v |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if( !(c & 0x80) ) return true;
+    }
+
+    return false;
+}
+
+// calls number and token, if given, for each record of one batch, returning false
+// if the records are malformed; tokens holds those the journal has defined
+bool replayBatch(const char* p, const char* end, vector<string>& tokens, const function<void(double)>& number,
+    const function<void(const string&)>& token, size_t& entries)
+{
+    while(p < end)
+    {
+        const char type{*p++};
+        if(type == NumberRecord)
+        {
+            double d;
+            if( static_cast<size_t>(end - p) < sizeof(d) ) return false;
+            std::memcpy( &d, p, sizeof(d) );
+            p += sizeof(d);
+            if(number) number(d);
+        }
+        else if(type == TokenRecord)
+        {
+            uint64_t id;
+            if( !getVarint(p, end, id) || id > tokens.size() ) return false;
+            if( id == tokens.size() )
+            {
+                uint64_t length;
+                if( !getVarint(p, end, length) || length > static_cast<uint64_t>(end - p) ) return false;
+                tokens.emplace_back( p, static_cast<size_t>(length) );
+                p += length;
+            }
+            if(token) token(tokens[id]);
+        }
+        else return false;
+
+        ++entries;
+    }
+
+    return true;
+}
+
+// the length of the intact part of the journal in p, header included, or 0 if it
+// is not a journal of the generation; the intact batches are replayed, and the
+// tokens they define are returned in tokens
+size_t scan(const char* p, size_t size, uint64_t generation, vector<string>& tokens,
+    const function<void(double)>& number, const function<void(const string&)>& token, size_t& entries)
+{
+    entries = 0;
+
+    Header header;
+    if( size < sizeof(header) ) return 0;
+    std::memcpy( &header, p, sizeof(header) );
+    if( std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != JournalVersion
+        || header.generation != generation )
+    {
+        return 0;
+    }
+
+    size_t intact{ sizeof(header) };
+    while(size - intact >= BatchHeaderSize)
+    {
+        uint32_t length;
+        uint64_t sum;
+        std::memcpy( &length, p + intact, sizeof(length) );
+        std::memcpy( &sum, p + intact + sizeof(length), sizeof(sum) );
+
+        const char* records{ p + intact + BatchHeaderSize };
+        if( length > size - intact - BatchHeaderSize || checksum(records, length) != sum ) break;
+
+        const size_t defined{ tokens.size() };
+        if( !replayBatch(records, records + length, tokens, number, token, entries) )
+        {
+            tokens.resize(defined);
+            break;
+        }
+
+        intact += BatchHeaderSize + length;
+    }
+
+    return intact;
+}
+
+}
+
+Journal::Journal(const string& filename, uint64_t generation, unsigned windowMilliseconds)
+: filename_{filename}
+, generation_{generation}
+, window_{windowMilliseconds}
+, head_{0}
+, tail_{0}
+, failed_{false}
+, durable_{0}
+, syncRequested_{false}
+, stop_{false}
+{
+    // a journal of the generation is continued if it is whole; otherwise its intact
+    // batches are copied into a new one, so that batches appended later are not
+    // hidden behind a torn one
+    bool whole{false};
+    string intact;
+    vector<string> tokens;
+    try
+    {
+        auto existing = PlatformFactory::Instance().createMappedFile(filename);
+        size_t entries;
+        size_t length{ scan(existing->data(), existing->size(), generation, tokens, nullptr, nullptr, entries) };
+        whole = length > 0 && length == existing->size();
+        if( length > sizeof(Header) ) intact.assign( existing->data() + sizeof(Header), length - sizeof(Header) );
+    }
+    catch(Exception&)
+    { }
+
+    if(whole) file_ = PlatformFactory::Instance().createAppendFile(filename_, false);
+    else create(intact);
+
+    // the tokens already defined keep their ids
+    clearTokenCache();
+    for(size_t i = 0; i < tokens.size(); ++i)
+        tokenIds_.emplace(tokens[i], i);
+
+    if(window_ > 0)
+    {
+        ring_.resize(RingSize);
+        thread_ = std::thread{ [this]{ flusher(); } };
+    }
+}
+
+Journal::~Journal()
+{
+    if( thread_.joinable() )
+    {
+        {
+            std::lock_guard<mutex> lock{mutex_};
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    return;
+}
+
+void Journal::recordNumber(double d)
+{
+    throwIfFailed();
+
+    char r[1 + sizeof(d)];
+    r[0] = NumberRecord;
+    std::memcpy( r + 1, &d, sizeof(d) );
+    record( r, sizeof(r) );
+
+    return;
+}
+
+// a token the journal has defined is recorded by its id alone
+void Journal::recordUncachedToken(const string& token)
+{
+    throwIfFailed();
+
+    CachedToken& cached = tokenCache_[ CacheSlot(token) ];
+    if( cached.length == 0 || cached.token != token )
+    {
+        auto i = tokenIds_.find(token);
+        if( i == tokenIds_.end() )
+        {
+            defineToken(token, cached);
+            return;
+        }
+
+        cache(token, i->second, cached);
+    }
+
+    record(cached.record, cached.length);
+
+    return;
+}
+
+void Journal::defineToken(const string& token, CachedToken& cached)
+{
+    const uint64_t id{ tokenIds_.size() };
+    tokenIds_.emplace(token, id);
+    cache(token, id, cached);
+
+    char r[2 * MaxVarint];
+    definition_.assign( cached.record, cached.length );
+    definition_.append( r, putVarint( r, token.size() ) );
+    definition_ += token;
+    record( definition_.data(), definition_.size() );
+
+    return;
+}
+
+void Journal::cache(const string& token, uint64_t id, CachedToken& cached)
+{
+    cached.token = token;
+    cached.record[0] = TokenRecord;
+    cached.length = static_cast<unsigned char>( 1 + putVarint(cached.record + 1, id) );
+
+    return;
+}
+
+void Journal::clearTokenCache()
+{
+    for(auto& cached : tokenCache_)
+        cached.length = 0;
+
+    return;
+}
+
+// copies an encoded record into the ring and publishes it to the flusher; with a
+// window of zero, or for a record too large for the ring, the record is written
+// and synced as its own batch, after everything before it
+void Journal::record(const char* r, size_t n)
+{
+    if( n > ring_.size() / 2 )
+    {
+        sync();
+        std::lock_guard<mutex> fileLock{fileMutex_};
+        writeBatch(r, n);
+        return;
+    }
+
+    const uint64_t head{ head_.load(std::memory_order_relaxed) };
+    if( ring_.size() - (head - tail_.load(std::memory_order_acquire)) < n )
+        waitForSpace(n);
+
+    // records are a few bytes, for which a loop is cheaper than calls to memcpy
+    const size_t mask{ ring_.size() - 1 };
+    char* ring{ ring_.data() };
+    for(size_t i = 0; i < n; ++i)
+        ring[(head + i) & mask] = r[i];
+    head_.store(head + n, std::memory_order_release);
+
+    return;
+}
+
+// a full ring is flushed without waiting out the window
+void Journal::waitForSpace(size_t n)
+{
+    unique_lock<mutex> lock{mutex_};
+    syncRequested_ = true;
+    wake_.notify_one();
+    flushed_.wait( lock, [&]
+    {
+        const uint64_t used{ head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire) };
+        return ring_.size() - used >= n || !error_.empty();
+    });
+
+    if( !error_.empty() ) throw Exception{error_};
+
+    return;
+}
+
+void Journal::sync()
+{
+    throwIfFailed();
+    if( ring_.empty() ) return;
+
+    const uint64_t target{ head_.load(std::memory_order_relaxed) };
+    unique_lock<mutex> lock{mutex_};
+    if(durable_ < target)
+    {
+        syncRequested_ = true;
+        wake_.notify_one();
+        flushed_.wait( lock, [&]{ return durable_ >= target || !error_.empty(); } );
+    }
+
+    if( !error_.empty() ) throw Exception{error_};
+
+    return;
+}
+
+void Journal::restart(uint64_t generation)
+{
+    throwIfFailed();
+
+    unique_lock<mutex> lock{mutex_};
+    std::lock_guard<mutex> fileLock{fileMutex_};
+
+    const uint64_t head{ head_.load(std::memory_order_relaxed) };
+    tail_.store(head, std::memory_order_release);
+    durable_ = head;
+    tokenIds_.clear();
+    clearTokenCache();
+    generation_ = generation;
+
+    try
+    {
+        file_.reset();
+        create("");
+    }
+    catch(Exception& e)
+    {
+        error_ = e.what();
+        failed_.store(true, std::memory_order_relaxed);
+        throw;
+    }
+
+    return;
+}
+
+void Journal::throwIfFailed()
+{
+    if( failed_.load(std::memory_order_relaxed) )
+    {
+        std::lock_guard<mutex> lock{mutex_};
+        throw Exception{error_};
+    }
+
+    return;
+}
+
+// the group commit: once per window, everything in the ring is written as a batch
+void Journal::flusher()
+{
+    string records;
+    unique_lock<mutex> lock{mutex_};
+    for(;;)
+    {
+        wake_.wait_for( lock, std::chrono::milliseconds(window_), [this]{ return stop_ || syncRequested_; } );
+        syncRequested_ = false;
+
+        const uint64_t tail{ tail_.load(std::memory_order_relaxed) };
+        const uint64_t head{ head_.load(std::memory_order_acquire) };
+        if(head == tail)
+        {
+            flushed_.notify_all();
+            if(stop_) return;
+            continue;
+        }
+
+        const size_t n( head - tail );
+        const size_t at( tail & (ring_.size() - 1) );
+        const size_t first{ std::min( n, ring_.size() - at ) };
+        records.assign( &ring_[at], first );
+        records.append( ring_.data(), n - first );
+        tail_.store(head, std::memory_order_release);
+
+        unique_lock<mutex> fileLock{fileMutex_};
+        lock.unlock();
+        flushed_.notify_all();
+
+        string error;
+        try
+        {
+            writeBatch( records.data(), records.size() );
+        }
+        catch(Exception& e)
+        {
+            error = e.what();
+        }
+        fileLock.unlock();
+        lock.lock();
+
+        if( error.empty() ) durable_ = std::max(durable_, head);
+        else
+        {
+            if( error_.empty() ) error_ = error;
+            failed_.store(true, std::memory_order_relaxed);
+        }
+        flushed_.notify_all();
+    }
+}
+
+// the batch is framed and written with a single write, then synced
+void Journal::writeBatch(const char* records, size_t n)
+{
+    if(!file_) throw Exception{"Could not write " + filename_};
+
+    string frame;
+    frame.reserve(BatchHeaderSize + n);
+    const uint32_t length(n);
+    const uint64_t sum{ checksum(records, n) };
+    frame.append( reinterpret_cast<const char*>(&length), sizeof(length) );
+    frame.append( reinterpret_cast<const char*>(&sum), sizeof(sum) );
+    frame.append(records, n);
+
+    file_->write( frame.data(), frame.size() );
+    file_->sync();
+
+    return;
+}
+
+// writes the header and batches beside the journal and moves them over it, as
+// SaveStackSnapshot does, then opens the result for appending
+void Journal::create(const string& batches)
+{
+    Header header;
+    std::memcpy( header.magic, Magic, sizeof(Magic) );
+    header.version = JournalVersion;
+    header.zero = 0;
+    header.generation = generation_;
+
+    const string temporary{ filename_ + ".tmp" };
+    try
+    {
+        auto file = PlatformFactory::Instance().createAppendFile(temporary, true);
+        file->write( reinterpret_cast<const char*>(&header), sizeof(header) );
+        file->write( batches.data(), batches.size() );
+        file->sync();
+    }
+    catch(Exception&)
+    {
+        std::remove( temporary.c_str() );
+        throw Exception{"Could not write " + filename_};
+    }
+
+    // rename does not replace an existing file on every platform
+    if( std::rename(temporary.c_str(), filename_.c_str()) != 0 )
+    {
+        std::remove( filename_.c_str() );
+        if( std::rename(temporary.c_str(), filename_.c_str()) != 0 )
+        {
+            std::remove( temporary.c_str() );
+            throw Exception{"Could not write " + filename_};
+        }
+    }
+
+    file_ = PlatformFactory::Instance().createAppendFile(filename_, false);
+
+    return;
+}
+
+size_t Journal::Replay(const string& filename, uint64_t generation, const function<void(double)>& number,
+    const function<void(const string&)>& token)
+{
+    size_t entries{0};
+    try
+    {
+        auto file = PlatformFactory::Instance().createMappedFile(filename);
+        vector<string> tokens;
+        scan(file->data(), file->size(), generation, tokens, number, token, entries);
+    }
+    catch(Exception&)
+    {
+        return 0;
+    }
+
+    return entries;
+}
+
+}
@@ -0,0 +1,200 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pdCalc {
+
+class AppendFile;
+
+// A Journal is a write ahead log of the entries a session executes, numbers and
+// command tokens, from which the session is rebuilt after a crash. Entries are
+// encoded as compact binary records into a ring buffer, which takes no lock, and a
+// background thread writes whatever the ring holds as one batch per durability
+// window and syncs it, so the cost of a sync is shared by the whole batch rather
+// than paid per entry. A crash loses at most the entries of the last window. A
+// window of zero writes and syncs every entry before record returns. Only one
+// thread may record.
+//
+// A journal continues from a stack snapshot whose tag is its generation; restart
+// empties the journal under a new generation once a new snapshot holds everything
+// it recorded. Numbers and checksums are stored in the byte order of the machine
+// that wrote them.
+//
+// Layout, all integers unsigned:
+//     24 byte header: "pdCalcJL", version (4 bytes), zeros (4), generation (8)
+//     batches, each the length of its records (4), their checksum (8), and the
+//         records; a batch that is cut short or fails its checksum ends the
+//         journal
+//     records: a number is 'n' and the double (8); a token is 't', its id as a
+//         base 128 varint, and, the first time the journal uses the id, the
+//         length of the token as a varint and its text
+class Journal
+{
+public:
+    // opens filename to continue a journal of the same generation, or starts a
+    // new one, discarding the file, if its generation differs or it is not a
+    // journal; throws Exception if the file cannot be written
+    Journal(const std::string& filename, uint64_t generation, unsigned windowMilliseconds);
+
+    // writes and syncs everything recorded
+    ~Journal();
+
+    // throw Exception if an earlier batch could not be written; a token recorded
+    // recently goes straight into the ring, inline in the caller
+    void recordNumber(double d);
+    inline void recordToken(const std::string& token);
+
+    // returns once everything recorded is on disk; throws Exception if it cannot
+    // be written
+    void sync();
+
+    // drops everything recorded and empties the journal under a new generation;
+    // throws Exception if the journal cannot be written
+    void restart(uint64_t generation);
+
+    uint64_t generation() const { return generation_; }
+
+    // calls number and token for each entry of the journal in filename, in order,
+    // if the journal is of the given generation, and returns the number of entries
+    // replayed; a missing, foreign or damaged file replays nothing
+    static size_t Replay(const std::string& filename, uint64_t generation,
+        const std::function<void(double)>& number, const std::function<void(const std::string&)>& token);
+
+private:
+    Journal(const Journal&) = delete;
+    Journal(Journal&&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    Journal& operator=(Journal&&) = delete;
+
+    // a token and the record of its id, a 't' and a varint; a length of zero marks
+    // an empty slot
+    static const size_t MaxTokenRecord = 11;
+    struct CachedToken
+    {
+        std::string token;
+        char record[MaxTokenRecord];
+        unsigned char length;
+    };
+
+    static size_t CacheSlot(const std::string& token);
+    static bool SameToken(const std::string& a, const std::string& b);
+    void recordUncachedToken(const std::string& token);
+    void defineToken(const std::string& token, CachedToken& cached);
+    void cache(const std::string& token, uint64_t id, CachedToken& cached);
+    void clearTokenCache();
+    void record(const char* r, size_t n);
+    void waitForSpace(size_t n);
+    void flusher();
+    void writeBatch(const char* records, size_t n);
+    void create(const std::string& batches);
+    void throwIfFailed();
+
+    std::string filename_;
+    uint64_t generation_;
+    unsigned window_;
+    std::unique_ptr<AppendFile> file_;
+
+    // owned by the recording thread: the ids of the tokens the journal has defined,
+    // and the record defining a new one
+    std::unordered_map<std::string, uint64_t> tokenIds_;
+    std::string definition_;
+
+    // The records of recently recorded tokens, each in a slot chosen by its length
+    // and its end characters, so that a token the session repeats is recorded
+    // without hashing its text or encoding its id.
+    static const size_t TokenCacheSize = 64;
+    std::array<CachedToken, TokenCacheSize> tokenCache_;
+
+    // the ring of encoded records; head_ and tail_ count bytes from the start, the
+    // recording thread advancing head_ and the flusher tail_
+    std::vector<char> ring_;
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> tail_;
+    std::atomic<bool> failed_;
+
+    // mutex_ guards the flusher's state and is taken before fileMutex_, which
+    // guards the file
+    uint64_t durable_;
+    bool syncRequested_;
+    bool stop_;
+    std::string error_;
+    std::mutex mutex_;
+    std::mutex fileMutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::thread thread_;
+};
+
+// commands differ mostly in length and in their first and last characters
+inline size_t Journal::CacheSlot(const std::string& token)
+{
+    if( token.empty() ) return 0;
+    const size_t front{ static_cast<unsigned char>( token.front() ) };
+    const size_t back{ static_cast<unsigned char>( token.back() ) };
+
+    return (token.size() * 31 + front * 7 + back) % TokenCacheSize;
+}
+
+// tokens are a few characters, which a loop compares faster than a call to memcmp
+inline bool Journal::SameToken(const std::string& a, const std::string& b)
+{
+    if( a.size() != b.size() ) return false;
+    for(size_t i = 0; i < a.size(); ++i)
+        if(a[i] != b[i]) return false;
+
+    return true;
+}
+
+// the ring is empty, and this path is never taken, with a window of zero
+inline void Journal::recordToken(const std::string& token)
+{
+    const CachedToken& cached = tokenCache_[ CacheSlot(token) ];
+    const uint64_t head{ head_.load(std::memory_order_relaxed) };
+    const bool fits{ ring_.size() - (head - tail_.load(std::memory_order_acquire)) >= cached.length };
+    if( cached.length == 0 || !fits || !SameToken(cached.token, token) || failed_.load(std::memory_order_relaxed) )
+    {
+        recordUncachedToken(token);
+        return;
+    }
+
+    const size_t mask{ ring_.size() - 1 };
+    char* ring{ ring_.data() };
+    for(size_t i = 0; i < cached.length; ++i)
+        ring[(head + i) & mask] = cached.record[i];
+    head_.store(head + cached.length, std::memory_order_release);
+
+    return;
+}
+
+}
+
+#endif
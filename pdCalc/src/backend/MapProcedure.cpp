@@ -0,0 +1,386 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MapProcedure.h"
+#include "StoredProcedure.h"
+#include "ProcedureOptimizer.h"
+#include "CoreOperations.h"
+#include "Stack.h"
+#include "utilities/Exception.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/Tokenizer.h"
+#include "utilities/CancellationToken.h"
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <utility>
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// elements per chunk below which the thread pool is not worth waking
+const size_t MinChunk = 64;
+
+// elements, and loop iterations, between looks at the token
+const size_t PollInterval = 256;
+
+const char* OutsideElement = "Procedure reaches outside its element";
+
+}
+
+MapProcedure::MapProcedure(const string& filename, CancellationToken* token)
+: filename_{filename}
+, token_{token}
+{ }
+
+MapProcedure::~MapProcedure()
+{ }
+
+void MapProcedure::checkPreconditionsImpl() const
+{
+    const Stack& stack = Stack::Instance();
+    if( stack.size() < 1 )
+        throw Exception{"Stack must have a count on top"};
+
+    double count{ stack.getElements(1).front() };
+    if( !(count >= 1.0) || count != std::floor(count) )
+        throw Exception{"Count must be a positive integer"};
+
+    if(count > stack.size() - 1)
+        throw Exception{"Stack has fewer elements than the count"};
+
+    if(!compiled_)
+    {
+        compile();
+        compiled_ = true;
+    }
+
+    operands_.resize( static_cast<size_t>(count) + 1 );
+    stack.peekElements( operands_.size(), operands_.data() );
+    evaluate();
+
+    return;
+}
+
+// resolves every step of the procedure once so that evaluation never looks up a
+// command; anything that is not a number, control flow, or a core command acting on
+// the top of the stack could touch more than the element and is rejected
+void MapProcedure::compile() const
+{
+    using Op = Step::Op;
+
+    static const std::map<string, Op> commands = {
+        {"+", Op::Add}, {"-", Op::Subtract}, {"*", Op::Multiply}, {"/", Op::Divide},
+        {"pow", Op::Power}, {"root", Op::Root}, {"neg", Op::Negate}, {"sq", Op::Square},
+        {"dup", Op::Duplicate}, {"drop", Op::Drop}, {"swap", Op::Swap},
+        {"sin", Op::Sine}, {"cos", Op::Cosine}, {"tan", Op::Tangent},
+        {"arcsin", Op::Arcsine}, {"arccos", Op::Arccosine}, {"arctan", Op::Arctangent}
+    };
+
+    Tokenizer::Tokens tokens = StoredProcedure::Load(filename_);
+
+    // every element starts alone on a plain double stack
+    try
+    {
+        ProcedureOptimizer optimizer{1, true};
+        tokens = optimizer.optimize(tokens);
+    }
+    catch(...)
+    { }
+
+    vector<Step> program;
+    for(const auto& i : StoredProcedure::Compile(tokens))
+    {
+        switch(i.op)
+        {
+        case StoredProcedure::Instruction::Op::Command:
+        {
+            Step s{Op::Number, 0.0, 0};
+            if( !TokenIsNumber(i.command, s.value) )
+            {
+                auto c = commands.find(i.command);
+                if( c == commands.end() )
+                    throw Exception{"Map procedures cannot use " + i.command};
+
+                s.op = c->second;
+            }
+            program.push_back(s);
+            break;
+        }
+        case StoredProcedure::Instruction::Op::Times:
+            program.push_back( Step{Op::Times, 0.0, i.target} );
+            break;
+        case StoredProcedure::Instruction::Op::Loop:
+            program.push_back( Step{Op::Loop, 0.0, i.target} );
+            break;
+        case StoredProcedure::Instruction::Op::If:
+            program.push_back( Step{Op::If, 0.0, i.target} );
+            break;
+        case StoredProcedure::Instruction::Op::Jump:
+            program.push_back( Step{Op::Jump, 0.0, i.target} );
+            break;
+        }
+    }
+
+    program_.swap(program);
+
+    return;
+}
+
+namespace {
+
+// the core command's operation on the top of the stack, with its checks; returns an
+// error message or nullptr
+template<typename Operation>
+const char* applyUnary(vector<double>& stack)
+{
+    if( stack.empty() ) return OutsideElement;
+
+    double& top = stack.back();
+    if( const char* error = Operation::Domain(top) ) return error;
+    top = Operation::Apply(top);
+
+    return nullptr;
+}
+
+template<typename Operation>
+const char* applyBinary(vector<double>& stack)
+{
+    if( stack.size() < 2 ) return OutsideElement;
+
+    const double top{ stack.back() };
+    double& next = stack[stack.size() - 2];
+    if( const char* error = Operation::Domain(next, top) ) return error;
+    next = Operation::Apply(next, top);
+    stack.pop_back();
+
+    return nullptr;
+}
+
+// runs the program on a stack holding only x, with the checks of the core commands;
+// returns an error message, or nullptr with the result; a long loop gives up once the
+// token has expired
+template<typename Step>
+const char* evaluateElement(const vector<Step>& program, double x, vector<double>& stack,
+    vector<unsigned long long>& loops, const CancellationToken* token, double& result)
+{
+    using Op = typename Step::Op;
+
+    stack.clear();
+    stack.push_back(x);
+    loops.clear();
+
+    size_t iterations{0};
+    size_t pc{0};
+    while( pc < program.size() )
+    {
+        const char* error{nullptr};
+        const Step& s = program[pc++];
+        switch(s.op)
+        {
+        case Op::Number:
+            stack.push_back(s.value);
+            break;
+
+        case Op::Add: error = applyBinary<AddOperation>(stack); break;
+        case Op::Subtract: error = applyBinary<SubtractOperation>(stack); break;
+        case Op::Multiply: error = applyBinary<MultiplyOperation>(stack); break;
+        case Op::Divide: error = applyBinary<DivideOperation>(stack); break;
+        case Op::Power: error = applyBinary<PowerOperation>(stack); break;
+        case Op::Root: error = applyBinary<RootOperation>(stack); break;
+        case Op::Negate: error = applyUnary<NegateOperation>(stack); break;
+        case Op::Square: error = applyUnary<SquareOperation>(stack); break;
+        case Op::Sine: error = applyUnary<SineOperation>(stack); break;
+        case Op::Cosine: error = applyUnary<CosineOperation>(stack); break;
+        case Op::Tangent: error = applyUnary<TangentOperation>(stack); break;
+        case Op::Arcsine: error = applyUnary<ArcsineOperation>(stack); break;
+        case Op::Arccosine: error = applyUnary<ArccosineOperation>(stack); break;
+        case Op::Arctangent: error = applyUnary<ArctangentOperation>(stack); break;
+
+        case Op::Duplicate:
+        {
+            if( stack.empty() ) return OutsideElement;
+
+            double top{ stack.back() };
+            stack.push_back(top);
+            break;
+        }
+
+        case Op::Drop:
+            if( stack.empty() ) return OutsideElement;
+
+            stack.pop_back();
+            break;
+
+        case Op::Swap:
+            if( stack.size() < 2 ) return OutsideElement;
+
+            std::swap( stack[stack.size() - 1], stack[stack.size() - 2] );
+            break;
+
+        case Op::Times:
+        {
+            if( stack.empty() ) return OutsideElement;
+
+            double count{ stack.back() };
+            if( !(count >= 0 && count <= 1e18 && std::floor(count) == count) )
+                return "times: count must be a nonnegative integer";
+
+            stack.pop_back();
+            if(count == 0) pc = s.target;
+            else loops.push_back( static_cast<unsigned long long>(count) );
+            break;
+        }
+
+        case Op::Loop:
+            if( token && ++iterations % PollInterval == 0 && token->expired() )
+                return token->reason();
+
+            if(--loops.back() > 0) pc = s.target;
+            else loops.pop_back();
+            break;
+
+        case Op::If:
+        {
+            if( stack.empty() ) return OutsideElement;
+
+            double condition{ stack.back() };
+            stack.pop_back();
+            if(condition == 0) pc = s.target;
+            break;
+        }
+
+        case Op::Jump:
+            pc = s.target;
+            break;
+        }
+
+        if(error) return error;
+    }
+
+    if(stack.size() != 1)
+        return "Procedure must leave one result";
+
+    result = stack.back();
+
+    return nullptr;
+}
+
+}
+
+// evaluates every element, in parallel; on failure, reports the element nearest the
+// top of the stack, whatever the order the chunks ran in, unless the token stopped
+// the evaluation
+void MapProcedure::evaluate() const
+{
+    const size_t n{ operands_.size() - 1 };
+    results_.resize(n);
+
+    ThreadPool& pool = ThreadPool::Instance();
+    const size_t nChunks{ pool.nChunks(n, MinChunk) };
+
+    // the failing element nearest the top in each chunk, and why
+    vector<std::pair<size_t, const char*>> failures(nChunks, {n, nullptr});
+
+    pool.parallelFor(n, MinChunk, [&](size_t chunk, size_t begin, size_t end)
+    {
+        vector<double> stack;
+        vector<unsigned long long> loops;
+        for(size_t i = end; i > begin; --i)
+        {
+            if( token_ && (end - i) % PollInterval == 0 && token_->expired() ) return;
+
+            if( const char* error = evaluateElement(program_, operands_[i - 1], stack, loops, token_, results_[i - 1]) )
+            {
+                failures[chunk] = {i - 1, error};
+                return;
+            }
+        }
+    });
+
+    if( token_ && !token_->poll() )
+        throw Exception{ token_->reason() };
+
+    for(auto f = failures.rbegin(); f != failures.rend(); ++f)
+    {
+        if(f->second)
+        {
+            std::ostringstream oss;
+            oss << "Element " << n - f->first << " below the count: " << f->second;
+            throw Exception{ oss.str() };
+        }
+    }
+
+    return;
+}
+
+void MapProcedure::executeImpl() noexcept
+{
+    Stack& stack = Stack::Instance();
+    const size_t n{ results_.size() };
+
+    // the results carry no exact values, but the operands may, and undo restores them
+    operandsExact_ = stack.getExactElements(n + 1);
+    operands_.resize(n + 1);
+    stack.popElements( operands_.size(), operands_.data(), true );
+    stack.pushElements( results_.data(), n, false );
+
+    return;
+}
+
+void MapProcedure::undoImpl() noexcept
+{
+    Stack& stack = Stack::Instance();
+    const size_t n{ operands_.size() - 1 };
+    stack.popElements( n, results_.data(), true );
+
+    bool exact{false};
+    for(const auto& e : operandsExact_)
+        exact = exact || e;
+
+    if(exact)
+    {
+        // operandsExact_ is top first
+        for(size_t i = 0; i < operands_.size(); ++i)
+            stack.push( operands_[i], operandsExact_[operands_.size() - 1 - i], i + 1 < operands_.size() );
+    }
+    else stack.pushElements( operands_.data(), operands_.size(), false );
+
+    // a redo evaluates the elements again, so there is no reason to hold on to them
+    vector<double>{}.swap(operands_);
+    vector<double>{}.swap(results_);
+    operandsExact_.clear();
+
+    return;
+}
+
+Command* MapProcedure::cloneImpl() const noexcept
+{
+    return 0;
+}
+
+const char* MapProcedure::helpMessageImpl() const noexcept
+{
+    return "Applies a stored procedure to each of the n elements below a count n";
+}
+
+}
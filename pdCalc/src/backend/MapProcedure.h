@@ -0,0 +1,92 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MAP_PROCEDURE_H
+#define MAP_PROCEDURE_H
+
+#include "Command.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace pdCalc {
+
+class BigFloat;
+class CancellationToken;
+
+// applies a stored procedure to each of the n elements below a count n on the top
+// of the stack; the count and the elements are replaced by the n results, in order,
+// and undo restores them as one command
+// Each element is evaluated on a stack of its own holding just that element, so the
+// elements are evaluated in parallel. The procedure may use numbers, the arithmetic,
+// trigonometric, and stack commands of the core, and control flow; it must leave one
+// number on its stack and may not reach below its element. Evaluation is in double
+// precision, and the results carry no exact values.
+// preconditions: 1) the top of the stack is a positive integer count, n
+//                2) at least n numbers below the count
+//                3) a procedure that uses only the commands above
+//                4) the procedure succeeds on each of the n numbers
+//                5) given a token, the evaluation is not cancelled or out of time; it
+//                   looks at the token every so many elements and loop iterations
+class MapProcedure : public Command
+{
+public:
+    explicit MapProcedure(const std::string& filename, CancellationToken* token = nullptr);
+    ~MapProcedure();
+
+private:
+    MapProcedure() = delete;
+    MapProcedure(MapProcedure&&) = delete;
+    MapProcedure& operator=(const MapProcedure&) = delete;
+    MapProcedure& operator=(MapProcedure&&) = delete;
+    MapProcedure(const MapProcedure&) = delete;
+
+    // a procedure step resolved to what the evaluator does
+    struct Step
+    {
+        enum class Op { Number, Add, Subtract, Multiply, Divide, Power, Root, Negate, Square,
+            Duplicate, Drop, Swap, Sine, Cosine, Tangent, Arcsine, Arccosine, Arctangent,
+            Times, Loop, If, Jump };
+
+        Op op;
+        double value;  // for Number
+        size_t target; // for jumps
+    };
+
+    void checkPreconditionsImpl() const override;
+    void compile() const;
+    void evaluate() const;
+    void executeImpl() noexcept override;
+    void undoImpl() noexcept override;
+    Command* cloneImpl() const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
+
+    std::string filename_;
+    CancellationToken* token_;
+    mutable std::vector<Step> program_;
+    mutable bool compiled_ = false;
+
+    // operands in stack order, bottom first: the elements, then the count
+    mutable std::vector<double> operands_;
+    std::vector<std::shared_ptr<const BigFloat>> operandsExact_;
+    mutable std::vector<double> results_;
+};
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// This is the base class to abstract OS specific mapping of files into memory,
+// which POSIX systems do with mmap and Windows with file mapping objects. A
+// MappedFile is a read only view of the whole file, or of a range of it, which
+// stays valid for the lifetime of the object.
+
+#include <cstddef>
+
+namespace pdCalc {
+
+class MappedFile
+{
+public:
+    virtual ~MappedFile();
+
+    // the contents of the file, which is nullptr for an empty file
+    virtual const char* data() const = 0;
+    virtual size_t size() const = 0;
+};
+
+}
+
+#endif
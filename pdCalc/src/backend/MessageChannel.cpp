@@ -0,0 +1,211 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MessageChannel.h"
+#include "ProcessChannel.h"
+#include "utilities/Exception.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace pdCalc {
+
+namespace {
+
+const uint64_t Magic = 0x6c6e6e6168436470; // "pdChannl"
+
+// how often a waiting side looks before it sleeps, and how long it sleeps before it
+// looks again
+const int Spins = 1000;
+const int SleepMilliseconds = 100;
+
+// how long the helper waits, a millisecond at a time, for the parent to lay out the
+// memory, which it does only once the helper has started
+const int LayoutMilliseconds = 5000;
+
+const size_t CacheLine = 64;
+
+}
+
+// The ring a side writes is indexed by the side, 0 for the parent and 1 for the
+// helper; each index is on a cache line of its own, so that the two sides do not
+// contend for one line. The indices only grow.
+struct MessageChannel::Layout
+{
+    struct alignas(CacheLine) Flag { std::atomic<uint32_t> value; };
+    struct alignas(CacheLine) Index { std::atomic<uint64_t> value; };
+
+    std::atomic<uint64_t> magic;
+    uint64_t capacity;
+    Flag asleep[2];
+    Index heads[2];
+    Index tails[2];
+};
+
+MessageChannel::MessageChannel(ProcessChannel& channel, bool parent)
+: channel_{channel}
+, layout_{nullptr}
+, side_{parent ? 0 : 1}
+, out_{nullptr}
+, in_{nullptr}
+, capacity_{0}
+, tail_{0}
+, head_{0}
+{
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "a channel's indices must be lock free");
+
+    const size_t offset{ (sizeof(Layout) + CacheLine - 1) / CacheLine * CacheLine };
+    if(channel.size() < offset + 2 * CacheLine)
+        throw Exception{"The memory of the channel is too small"};
+
+    if(parent)
+    {
+        layout_ = new (channel.memory()) Layout;
+        layout_->capacity = (channel.size() - offset) / 2 / CacheLine * CacheLine;
+        for(int i = 0; i < 2; ++i)
+        {
+            layout_->asleep[i].value.store(0);
+            layout_->heads[i].value.store(0);
+            layout_->tails[i].value.store(0);
+        }
+        layout_->magic.store(Magic, std::memory_order_release);
+    }
+    else
+    {
+        layout_ = reinterpret_cast<Layout*>( channel.memory() );
+        for(int i = 0; i < LayoutMilliseconds && layout_->magic.load(std::memory_order_acquire) != Magic; ++i)
+            channel.wait(1);
+
+        if( layout_->magic.load(std::memory_order_acquire) != Magic
+            || layout_->capacity != (channel.size() - offset) / 2 / CacheLine * CacheLine )
+            throw Exception{"The memory of the channel is not laid out"};
+    }
+
+    capacity_ = layout_->capacity;
+    out_ = channel.memory() + offset + side_ * capacity_;
+    in_ = channel.memory() + offset + (1 - side_) * capacity_;
+}
+
+MessageChannel::~MessageChannel()
+{ }
+
+void MessageChannel::write(const void* p, size_t n)
+{
+    auto& head = layout_->heads[side_].value;
+    auto room = [&]{ return capacity_ - ( tail_ - head.load(std::memory_order_acquire) ); };
+
+    const char* from{ static_cast<const char*>(p) };
+    while(n > 0)
+    {
+        const uint64_t free{ room() };
+        if(free == 0)
+        {
+            flush();
+            waitFor( [&]{ return room() > 0; } );
+            continue;
+        }
+
+        const uint64_t at{ tail_ % capacity_ };
+        const size_t k{ static_cast<size_t>( std::min<uint64_t>( std::min<uint64_t>(n, free), capacity_ - at ) ) };
+        std::memcpy(out_ + at, from, k);
+        tail_ += k;
+        from += k;
+        n -= k;
+    }
+
+    return;
+}
+
+// The other side's flag is cleared by whoever rings, so that it is rung once
+// however many flushes come while it sleeps.
+void MessageChannel::flush()
+{
+    auto& tail = layout_->tails[side_].value;
+    if( tail.load(std::memory_order_relaxed) == tail_ ) return;
+
+    tail.store(tail_);
+    if( layout_->asleep[1 - side_].value.exchange(0) != 0 ) channel_.notify();
+
+    return;
+}
+
+// the writer may be waiting for the room made
+void MessageChannel::read(void* p, size_t n)
+{
+    flush();
+
+    auto& tail = layout_->tails[1 - side_].value;
+    auto& head = layout_->heads[1 - side_].value;
+
+    char* to{ static_cast<char*>(p) };
+    while(n > 0)
+    {
+        const uint64_t available{ tail.load(std::memory_order_acquire) - head_ };
+        if(available == 0)
+        {
+            waitFor( [&]{ return tail.load(std::memory_order_acquire) != head_; } );
+            continue;
+        }
+
+        const uint64_t at{ head_ % capacity_ };
+        const size_t k{ static_cast<size_t>( std::min<uint64_t>( std::min<uint64_t>(n, available), capacity_ - at ) ) };
+        std::memcpy(to, in_ + at, k);
+        head_ += k;
+        to += k;
+        n -= k;
+
+        head.store(head_);
+        if( layout_->asleep[1 - side_].value.exchange(0) != 0 ) channel_.notify();
+    }
+
+    return;
+}
+
+uint64_t MessageChannel::consumed() const
+{
+    return layout_->heads[side_].value.load(std::memory_order_acquire);
+}
+
+// This side says it is asleep before it looks a last time, and the other side
+// publishes before it looks to see whether to ring, so that one of them sees the
+// other (both are sequentially consistent), and no ring is lost.
+template<typename Ready>
+void MessageChannel::waitFor(Ready ready)
+{
+    for(int i = 0; i < Spins; ++i)
+    {
+        if( ready() ) return;
+        std::this_thread::yield();
+    }
+
+    auto& asleep = layout_->asleep[side_].value;
+    for(;;)
+    {
+        asleep.store(1);
+        if( ready() ) break;
+        channel_.wait(SleepMilliseconds);
+        if( ready() ) break;
+    }
+    asleep.store(0);
+
+    return;
+}
+
+}
@@ -0,0 +1,84 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MESSAGE_CHANNEL_H
+#define MESSAGE_CHANNEL_H
+
+// Two rings of bytes in the memory of a ProcessChannel, one each way, each with one
+// writer and one reader, so that messages pass between the processes without a
+// system call. Writes are batched: what one side writes becomes visible to the other
+// only when it flushes, and a flush rings the other side's doorbell only if that side
+// is asleep, so that a batch of messages, or a long one, costs at most one wake up.
+// A side that must wait for the other spins briefly before it sleeps. A message
+// longer than a ring streams through it, the writer waiting for the reader to make
+// room.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pdCalc {
+
+class ProcessChannel;
+
+class MessageChannel
+{
+public:
+    // the parent's side lays out the channel's memory, which the helper's side then
+    // waits for; throws Exception if the memory is too small or not laid out in time
+    MessageChannel(ProcessChannel& channel, bool parent);
+    ~MessageChannel();
+
+    // appends n bytes to what is to be flushed, flushing and waiting for room if the
+    // ring fills; throws Exception if the other side goes away meanwhile
+    void write(const void* p, size_t n);
+
+    // makes everything written visible to the other side
+    void flush();
+
+    // flushes, then reads n bytes, waiting for them; throws Exception if the other
+    // side goes away first
+    void read(void* p, size_t n);
+
+    // bytes written so far, and bytes of them read by the other side
+    uint64_t written() const { return tail_; }
+    uint64_t consumed() const;
+
+private:
+    MessageChannel(const MessageChannel&) = delete;
+    MessageChannel(MessageChannel&&) = delete;
+    MessageChannel& operator=(const MessageChannel&) = delete;
+    MessageChannel& operator=(MessageChannel&&) = delete;
+
+    struct Layout;
+
+    template<typename Ready>
+    void waitFor(Ready ready);
+
+    ProcessChannel& channel_;
+    Layout* layout_;
+    int side_;
+    char* out_;
+    char* in_;
+    uint64_t capacity_;
+    uint64_t tail_; // of the ring out, as far as written
+    uint64_t head_; // of the ring in, as far as read
+};
+
+}
+
+#endif
@@ -20,10 +20,16 @@
 #define PLATFORM_FACTORY_H
 
 #include <memory>
+#include <string>
+#include <vector>
+#include "FileWatcher.h"
 
 namespace pdCalc {
 
 class DynamicLoader;
+class MappedFile;
+class AppendFile;
+class ProcessChannel;
 
 class PlatformFactory
 {
@@ -33,6 +39,32 @@ public:
 
     virtual std::unique_ptr<DynamicLoader> createDynamicLoader() = 0;
 
+    // maps the whole of filename into memory, read only; throws Exception if the
+    // file cannot be opened or mapped
+    virtual std::unique_ptr<MappedFile> createMappedFile(const std::string& filename) = 0;
+
+    // maps length bytes of filename from offset, which need not be aligned, so that
+    // only that range of a large file is resident; throws Exception if the file
+    // cannot be opened or mapped or is too short
+    virtual std::unique_ptr<MappedFile> createMappedFile(const std::string& filename, size_t offset, size_t length) = 0;
+
+    // opens filename for durable appends, creating it if necessary and emptying it
+    // if truncate is true; throws Exception if the file cannot be opened
+    virtual std::unique_ptr<AppendFile> createAppendFile(const std::string& filename, bool truncate) = 0;
+
+    // watches filenames until the watcher is destroyed, calling changed with each
+    // that changes; throws Exception if the files cannot be watched
+    virtual std::unique_ptr<FileWatcher> createFileWatcher(const std::vector<std::string>& filenames,
+        FileWatcher::Changed changed) = 0;
+
+    // starts executable, a helper process, with size bytes of memory shared with it;
+    // throws Exception if it cannot be started
+    virtual std::unique_ptr<ProcessChannel> createProcessChannel(const std::string& executable, size_t size) = 0;
+
+    // the helper's end of the channel described to it by its parent; throws Exception
+    // if description does not describe one
+    virtual std::unique_ptr<ProcessChannel> openProcessChannel(const std::string& description) = 0;
+
 protected:
     PlatformFactory();
 
@@ -0,0 +1,773 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PluginHost.h"
+#include "Command.h"
+#include "DynamicLoader.h"
+#include "MessageChannel.h"
+#include "PlatformFactory.h"
+#include "Plugin.h"
+#include "ProcessChannel.h"
+#include "Stack.h"
+#include "utilities/Exception.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::array;
+using std::map;
+using std::unique_ptr;
+using std::shared_ptr;
+using std::mutex;
+using std::lock_guard;
+
+namespace pdCalc {
+
+namespace {
+
+// shared by the two rings, so that 64k elements of a stack cross in one turn
+const size_t ChannelSize = size_t{1} << 20;
+
+enum class Op : uint32_t { Hello, Load, Unload, Call, Exit };
+enum class Status : uint32_t { Ok, Failed };
+
+// followed by the file name of a Load or, for a Call, the elements of the stack
+// above those the helper keeps, bottom first
+struct Request
+{
+    Op op;
+    uint32_t plugin;
+    uint32_t command;
+    uint32_t unused;
+    uint64_t kept;   // elements of the helper's stack a Call keeps
+    uint64_t length; // bytes of the file name, elements sent
+};
+
+// followed by the plugin of a Load, the elements a Call added, or the message of a
+// failure
+struct Reply
+{
+    Status status;
+    uint32_t unused;
+    uint64_t base;   // of a Call's change to the stack
+    uint64_t length; // elements added, bytes of the message
+};
+
+template<typename T>
+void put(MessageChannel& c, const T& t)
+{
+    c.write( &t, sizeof(T) );
+    return;
+}
+
+template<typename T>
+T get(MessageChannel& c)
+{
+    T t;
+    c.read( &t, sizeof(T) );
+
+    return t;
+}
+
+string getBytes(MessageChannel& c, uint64_t n)
+{
+    string s(n, '\0');
+    c.read( &s[0], n );
+
+    return s;
+}
+
+void putString(MessageChannel& c, const char* s)
+{
+    const string t{ s ? s : "" };
+    put<uint64_t>( c, t.size() );
+    c.write( t.data(), t.size() );
+
+    return;
+}
+
+string getString(MessageChannel& c)
+{
+    return getBytes( c, get<uint64_t>(c) );
+}
+
+// what the parent knows of a plugin loaded in the helper
+struct Description
+{
+    Plugin::ApiVersion version;
+    vector<string> names;
+    vector<string> helps;
+    bool hasButtons;
+    vector<array<string, 4>> buttons; // as the members of PluginButtonDescriptor
+    string loadedFrom; // as the helper's loader found it
+};
+
+void putDescription(MessageChannel& c, const Plugin& p, const string& loadedFrom)
+{
+    const auto version = p.apiVersion();
+    put<int32_t>(c, version.major);
+    put<int32_t>(c, version.minor);
+
+    const auto& d = p.getPluginDescriptor();
+    put<uint64_t>(c, d.nCommands);
+    for(int i = 0; i < d.nCommands; ++i)
+    {
+        putString( c, d.commandNames[i] );
+        putString( c, d.commands[i]->helpMessage() );
+    }
+
+    const auto b = p.getPluginButtonDescriptor();
+    put<uint32_t>( c, b != nullptr );
+    put<uint64_t>( c, b ? b->nButtons : 0 );
+    for(int i = 0; b && i < b->nButtons; ++i)
+    {
+        putString( c, b->dispPrimaryCmd[i] );
+        putString( c, b->primaryCmd[i] );
+        putString( c, b->dispShftCmd[i] );
+        putString( c, b->shftCmd[i] );
+    }
+    putString( c, loadedFrom.c_str() );
+
+    return;
+}
+
+Description getDescription(MessageChannel& c)
+{
+    Description d;
+    d.version.major = get<int32_t>(c);
+    d.version.minor = get<int32_t>(c);
+
+    const auto nCommands = get<uint64_t>(c);
+    for(uint64_t i = 0; i < nCommands; ++i)
+    {
+        d.names.push_back( getString(c) );
+        d.helps.push_back( getString(c) );
+    }
+
+    d.hasButtons = get<uint32_t>(c) != 0;
+    const auto nButtons = get<uint64_t>(c);
+    for(uint64_t i = 0; i < nButtons; ++i)
+    {
+        array<string, 4> b;
+        for(auto& s : b) s = getString(c);
+        d.buttons.push_back( std::move(b) );
+    }
+    d.loadedFrom = getString(c);
+
+    return d;
+}
+
+void fail(MessageChannel& c, const string& message)
+{
+    put( c, Reply{Status::Failed, 0, 0, message.size()} );
+    c.write( message.data(), message.size() );
+
+    return;
+}
+
+}
+
+// The parent's end of the helper, shared by the host and the plugins loaded in the
+// helper, all of which it serves, one request at a time.
+class HostConnection : public std::enable_shared_from_this<HostConnection>
+{
+public:
+    explicit HostConnection(const string& executable);
+    ~HostConnection();
+
+    // the plugin filename is in the helper, or null if it could not be loaded
+    Plugin* load(const string& filename);
+    void unload(uint32_t plugin);
+
+    // runs the command on the stack, returning how it would change; throws
+    // Exception with the command's message if it fails, or if the helper stops in it
+    StackDelta call(uint32_t plugin, uint32_t command);
+
+    size_t restarts() const;
+    long processId() const;
+
+private:
+    HostConnection(const HostConnection&) = delete;
+    HostConnection(HostConnection&&) = delete;
+    HostConnection& operator=(const HostConnection&) = delete;
+    HostConnection& operator=(HostConnection&&) = delete;
+
+    void start();
+    void stop();
+
+    template<typename Exchange>
+    void exchange(Exchange e);
+
+    string executable_;
+    unique_ptr<ProcessChannel> process_;
+    unique_ptr<MessageChannel> channel_; // null while the helper is stopped
+    map<uint32_t, string> loaded_; // loaded again by a restarted helper
+
+    // the helper's copy of the stack is the stack as it was at mark_, unless the
+    // helper has not been sent one since it started
+    bool sent_;
+    uint64_t mark_;
+
+    uint32_t nextPlugin_;
+    size_t restarts_;
+    mutable mutex mutex_;
+};
+
+class HostedPlugin;
+
+// A command of a plugin loaded in the helper. It runs there once, as its
+// precondition, so that a command that fails, or a helper that stops, leaves the
+// stack alone, and keeps the change, which it then makes, undoes, and redoes itself.
+class HostedCommand : public Command
+{
+public:
+    HostedCommand(const HostedPlugin& plugin, uint32_t index);
+
+private:
+    HostedCommand(const HostedCommand&) = delete;
+    HostedCommand(HostedCommand&&) = delete;
+    HostedCommand& operator=(const HostedCommand&) = delete;
+    HostedCommand& operator=(HostedCommand&&) = delete;
+
+    void checkPreconditionsImpl() const override;
+    void executeImpl() noexcept override;
+    void undoImpl() noexcept override;
+    Command* cloneImpl() const override;
+    const char* helpMessageImpl() const noexcept override;
+
+    const HostedPlugin& plugin_;
+    uint32_t index_;
+    mutable bool ran_;
+    mutable StackDelta delta_;
+};
+
+// A plugin loaded in the helper, as the parent sees it: its descriptors, and
+// commands that run in the helper.
+class HostedPlugin : public Plugin
+{
+public:
+    HostedPlugin(shared_ptr<HostConnection> connection, uint32_t id, Description d);
+    ~HostedPlugin();
+
+    const PluginDescriptor& getPluginDescriptor() const override { return descriptor_; }
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override;
+    ApiVersion apiVersion() const override { return description_.version; }
+
+    StackDelta call(uint32_t command) const { return connection_->call(id_, command); }
+    const char* help(uint32_t command) const { return description_.helps[command].c_str(); }
+    const string& loadedFrom() const { return description_.loadedFrom; }
+
+private:
+    shared_ptr<HostConnection> connection_;
+    uint32_t id_;
+    Description description_;
+    vector<char*> names_;
+    vector<CommandPtr> commands_;
+    vector<Command*> commandPointers_;
+    PluginDescriptor descriptor_;
+    array<vector<char*>, 4> buttons_;
+    PluginButtonDescriptor buttonDescriptor_;
+};
+
+// loads plugins in the helper
+class HostedLoader : public DynamicLoader
+{
+public:
+    explicit HostedLoader(shared_ptr<HostConnection> connection) : connection_{ std::move(connection) } { }
+
+    Plugin* allocatePlugin(const string& pluginName) override;
+    void deallocatePlugin(Plugin* p) override { delete p; }
+    string loadedFrom() const override { return loadedFrom_; }
+
+private:
+    shared_ptr<HostConnection> connection_;
+    string loadedFrom_;
+};
+
+HostConnection::HostConnection(const string& executable)
+: executable_{executable}
+, sent_{false}
+, mark_{0}
+, nextPlugin_{0}
+, restarts_{0}
+{
+    try
+    {
+        start();
+    }
+    catch(Exception&)
+    {
+        stop();
+        throw Exception{"Could not start the plugin host " + executable};
+    }
+}
+
+HostConnection::~HostConnection()
+{
+    if(!channel_) return;
+
+    try
+    {
+        put( *channel_, Request{Op::Exit, 0, 0, 0, 0, 0} );
+        channel_->flush();
+    }
+    catch(Exception&)
+    { }
+}
+
+// the helper is known to run once it answers
+void HostConnection::start()
+{
+    process_ = PlatformFactory::Instance().createProcessChannel(executable_, ChannelSize);
+    channel_ = std::make_unique<MessageChannel>(*process_, true);
+    sent_ = false;
+
+    put( *channel_, Request{Op::Hello, 0, 0, 0, 0, 0} );
+    if( get<Reply>(*channel_).status != Status::Ok )
+        throw Exception{"The plugin host did not answer"};
+
+    for(const auto& p : loaded_)
+    {
+        put( *channel_, Request{Op::Load, p.first, 0, 0, 0, p.second.size()} );
+        channel_->write( p.second.data(), p.second.size() );
+        const auto reply = get<Reply>(*channel_);
+        if(reply.status == Status::Ok) getDescription(*channel_);
+        else getBytes(*channel_, reply.length);
+    }
+
+    return;
+}
+
+void HostConnection::stop()
+{
+    channel_.reset();
+    process_.reset();
+
+    return;
+}
+
+// Runs e, which writes a request and reads its reply, with the lock held. If the
+// helper stops, it is restarted, and the request is sent again if the helper had
+// not begun to read it.
+template<typename Exchange>
+void HostConnection::exchange(Exchange e)
+{
+    for(int attempt = 0; ; ++attempt)
+    {
+        if(!channel_)
+        {
+            try
+            {
+                ++restarts_;
+                start();
+            }
+            catch(Exception&)
+            {
+                stop();
+                throw Exception{"Could not restart the plugin host " + executable_};
+            }
+        }
+
+        const uint64_t sent{ channel_->written() };
+        try
+        {
+            e(*channel_);
+            return;
+        }
+        catch(Exception&)
+        {
+            const bool begun{ channel_->consumed() > sent };
+            stop();
+            if(begun || attempt > 0)
+                throw Exception{"The plugin host stopped while running the command"};
+        }
+    }
+}
+
+Plugin* HostConnection::load(const string& filename)
+{
+    lock_guard<mutex> lock{mutex_};
+
+    const uint32_t id{ nextPlugin_++ };
+    Reply reply;
+    Description d;
+    try
+    {
+        exchange( [&](MessageChannel& c)
+        {
+            put( c, Request{Op::Load, id, 0, 0, 0, filename.size()} );
+            c.write( filename.data(), filename.size() );
+            reply = get<Reply>(c);
+            if(reply.status == Status::Ok) d = getDescription(c);
+            else getBytes(c, reply.length);
+        } );
+    }
+    catch(Exception&)
+    {
+        return nullptr;
+    }
+
+    if(reply.status != Status::Ok) return nullptr;
+
+    loaded_[id] = filename;
+
+    return new HostedPlugin{ shared_from_this(), id, std::move(d) };
+}
+
+// goes with the next request
+void HostConnection::unload(uint32_t plugin)
+{
+    lock_guard<mutex> lock{mutex_};
+
+    loaded_.erase(plugin);
+    if(!channel_) return;
+
+    try
+    {
+        put( *channel_, Request{Op::Unload, plugin, 0, 0, 0, 0} );
+    }
+    catch(Exception&)
+    {
+        stop();
+    }
+
+    return;
+}
+
+// The stack is not changed until the command is done, so its elements can be sent
+// from where they are, and the elements the command removed taken from there. The
+// helper's copy is sent only the elements changed since the last call, and is left
+// as the stack was, since the command's change may never be made.
+StackDelta HostConnection::call(uint32_t plugin, uint32_t command)
+{
+    lock_guard<mutex> lock{mutex_};
+
+    Stack& stack = Stack::Instance();
+    const auto& elements = stack.elements();
+
+    Reply reply;
+    vector<double> added;
+    string message;
+    exchange( [&](MessageChannel& c)
+    {
+        const size_t kept{ sent_ ? stack.unchangedSince(mark_) : 0 };
+        put( c, Request{Op::Call, plugin, command, 0, kept, elements.size() - kept} );
+        c.write( elements.data() + kept, (elements.size() - kept) * sizeof(double) );
+        mark_ = stack.mark();
+        sent_ = true;
+        reply = get<Reply>(c);
+        if(reply.status == Status::Ok)
+        {
+            added.resize(reply.length);
+            c.read( added.data(), added.size() * sizeof(double) );
+        }
+        else message = getBytes(c, reply.length);
+    } );
+
+    if(reply.status != Status::Ok)
+        throw Exception{message};
+    if( reply.base > elements.size() )
+        throw Exception{"The plugin host changed more than the stack"};
+
+    StackDelta d;
+    d.base = reply.base;
+    d.removed.assign( elements.begin() + d.base, elements.end() );
+    const auto& exact = stack.exactElements();
+    if( std::any_of( exact.begin() + std::min(d.base, exact.size()), exact.end(),
+        [](const Stack::ExactValue& e){ return e != nullptr; } ) )
+        d.removedExact.assign( exact.begin() + d.base, exact.end() );
+    d.added = std::move(added);
+    d.precisionBefore = d.precisionAfter = stack.precision();
+
+    return d;
+}
+
+size_t HostConnection::restarts() const
+{
+    lock_guard<mutex> lock{mutex_};
+    return restarts_;
+}
+
+long HostConnection::processId() const
+{
+    lock_guard<mutex> lock{mutex_};
+    return process_ ? process_->processId() : 0;
+}
+
+HostedCommand::HostedCommand(const HostedPlugin& plugin, uint32_t index)
+: Command{}
+, plugin_{plugin}
+, index_{index}
+, ran_{false}
+{ }
+
+void HostedCommand::checkPreconditionsImpl() const
+{
+    if(ran_) return;
+
+    delta_ = plugin_.call(index_);
+    ran_ = true;
+
+    return;
+}
+
+void HostedCommand::executeImpl() noexcept
+{
+    Stack::Instance().applyDelta(delta_, true);
+    return;
+}
+
+void HostedCommand::undoImpl() noexcept
+{
+    Stack::Instance().applyDelta(delta_, false);
+    return;
+}
+
+Command* HostedCommand::cloneImpl() const
+{
+    return new HostedCommand{plugin_, index_};
+}
+
+const char* HostedCommand::helpMessageImpl() const noexcept
+{
+    return plugin_.help(index_);
+}
+
+HostedPlugin::HostedPlugin(shared_ptr<HostConnection> connection, uint32_t id, Description d)
+: connection_{ std::move(connection) }
+, id_{id}
+, description_{ std::move(d) }
+{
+    for(uint32_t i = 0; i < description_.names.size(); ++i)
+    {
+        names_.push_back( &description_.names[i][0] );
+        commands_.push_back( MakeCommandPtr<HostedCommand>(*this, i) );
+        commandPointers_.push_back( commands_.back().get() );
+    }
+    descriptor_.nCommands = static_cast<int>( names_.size() );
+    descriptor_.commandNames = names_.data();
+    descriptor_.commands = commandPointers_.data();
+
+    for(auto& b : description_.buttons)
+        for(size_t i = 0; i < b.size(); ++i) buttons_[i].push_back( &b[i][0] );
+    buttonDescriptor_.nButtons = static_cast<int>( description_.buttons.size() );
+    buttonDescriptor_.dispPrimaryCmd = buttons_[0].data();
+    buttonDescriptor_.primaryCmd = buttons_[1].data();
+    buttonDescriptor_.dispShftCmd = buttons_[2].data();
+    buttonDescriptor_.shftCmd = buttons_[3].data();
+}
+
+HostedPlugin::~HostedPlugin()
+{
+    commands_.clear();
+    connection_->unload(id_);
+}
+
+const Plugin::PluginButtonDescriptor* HostedPlugin::getPluginButtonDescriptor() const
+{
+    return description_.hasButtons ? &buttonDescriptor_ : nullptr;
+}
+
+Plugin* HostedLoader::allocatePlugin(const string& pluginName)
+{
+    auto p = static_cast<HostedPlugin*>( connection_->load(pluginName) );
+    if(p) loadedFrom_ = p->loadedFrom();
+
+    return p;
+}
+
+PluginHost::PluginHost(const string& executable)
+: connection_{ std::make_shared<HostConnection>(executable) }
+{ }
+
+PluginHost::~PluginHost()
+{ }
+
+unique_ptr<DynamicLoader> PluginHost::createDynamicLoader()
+{
+    return std::make_unique<HostedLoader>(connection_);
+}
+
+size_t PluginHost::restarts() const
+{
+    return connection_->restarts();
+}
+
+long PluginHost::processId() const
+{
+    return connection_->processId();
+}
+
+namespace {
+
+// a plugin loaded in the helper
+class LoadedPlugin
+{
+public:
+    explicit LoadedPlugin(const string& filename)
+    : loader_{ PlatformFactory::Instance().createDynamicLoader() }
+    , plugin_{ loader_->allocatePlugin(filename) }
+    { }
+
+    ~LoadedPlugin() { if(plugin_) loader_->deallocatePlugin(plugin_); }
+
+    const Plugin* plugin() const { return plugin_; }
+    string loadedFrom() const { return loader_->loadedFrom(); }
+
+private:
+    LoadedPlugin(const LoadedPlugin&) = delete;
+    LoadedPlugin& operator=(const LoadedPlugin&) = delete;
+
+    unique_ptr<DynamicLoader> loader_;
+    Plugin* plugin_;
+};
+
+// Brings the helper's stack up to date with the elements of a Call, keeping the
+// bottom r.kept and reading the rest; elements is spare storage. Returns false if
+// the helper's stack has fewer than r.kept.
+bool receiveStack(MessageChannel& c, const Request& r, vector<double>& elements)
+{
+    Stack& stack = Stack::Instance();
+    vector<Stack::ExactValue> noExact;
+    stack.swapElements(elements, noExact, true);
+    if( r.kept > elements.size() ) return false;
+
+    elements.resize(r.kept);
+    elements.resize(r.kept + r.length);
+    c.read( elements.data() + r.kept, r.length * sizeof(double) );
+    stack.swapElements(elements, noExact, true);
+
+    return true;
+}
+
+// Runs a command on the helper's stack and replies with how the command changed it,
+// or with its message if it fails. The stack is left as it was, since the parent
+// makes the change.
+void runCommand(MessageChannel& c, const map<uint32_t, unique_ptr<LoadedPlugin>>& plugins, const Request& r)
+{
+    Stack& stack = Stack::Instance();
+
+    const auto p = plugins.find(r.plugin);
+    if( p == plugins.end() || static_cast<int>(r.command) >= p->second->plugin()->getPluginDescriptor().nCommands )
+    {
+        fail(c, "The plugin is not loaded in the plugin host");
+        return;
+    }
+
+    auto command = MakeCommandPtr( p->second->plugin()->getPluginDescriptor().commands[r.command]->clone() );
+    if(!command)
+    {
+        fail(c, "The plugin could not copy its command");
+        return;
+    }
+
+    stack.beginDelta();
+    try
+    {
+        command->execute();
+    }
+    catch(Exception& e)
+    {
+        stack.applyDelta(stack.endDelta(), false, true);
+        fail( c, e.what() );
+        return;
+    }
+    catch(std::exception& e)
+    {
+        stack.applyDelta(stack.endDelta(), false, true);
+        fail( c, e.what() );
+        return;
+    }
+
+    const StackDelta d{ stack.endDelta() };
+    stack.applyDelta(d, false, true);
+    put( c, Reply{Status::Ok, 0, d.base, d.added.size()} );
+    c.write( d.added.data(), d.added.size() * sizeof(double) );
+
+    return;
+}
+
+}
+
+// Replies are flushed by the read of the next request; the parent going away ends
+// the read with an Exception.
+int PluginHost::Serve(const string& description)
+{
+    unique_ptr<ProcessChannel> process;
+    unique_ptr<MessageChannel> c;
+    try
+    {
+        process = PlatformFactory::Instance().openProcessChannel(description);
+        c = std::make_unique<MessageChannel>(*process, false);
+    }
+    catch(Exception&)
+    {
+        return 2;
+    }
+
+    map<uint32_t, unique_ptr<LoadedPlugin>> plugins;
+    vector<double> elements;
+    try
+    {
+        for(;;)
+        {
+            const auto r = get<Request>(*c);
+            switch(r.op)
+            {
+            case Op::Hello:
+                put( *c, Reply{Status::Ok, 0, 0, 0} );
+                break;
+            case Op::Load:
+            {
+                auto p = std::make_unique<LoadedPlugin>( getBytes(*c, r.length) );
+                if( p->plugin() )
+                {
+                    put( *c, Reply{Status::Ok, 0, 0, 0} );
+                    putDescription( *c, *p->plugin(), p->loadedFrom() );
+                    plugins[r.plugin] = std::move(p);
+                }
+                else fail(*c, "");
+                break;
+            }
+            case Op::Unload:
+                plugins.erase(r.plugin);
+                break;
+            case Op::Call:
+                if( !receiveStack(*c, r, elements) ) return 1;
+                runCommand(*c, plugins, r);
+                break;
+            case Op::Exit:
+                return 0;
+            default:
+                return 1;
+            }
+        }
+    }
+    catch(Exception&)
+    { }
+
+    return 0;
+}
+
+}
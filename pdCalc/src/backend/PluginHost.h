@@ -0,0 +1,81 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PLUGIN_HOST_H
+#define PLUGIN_HOST_H
+
+// A PluginHost runs plugins in a helper process, pdCalcPluginHost, so that a plugin
+// that crashes or leaks takes down only the helper. Its loader (createDynamicLoader)
+// stands in for the platform's: a plugin it loads has the commands and buttons of
+// the plugin loaded in the helper, and running one of its commands brings the
+// helper's copy of the stack up to date, runs the command there, and brings back
+// what changed. Calls pass through memory shared with the helper (see
+// MessageChannel), and send only the elements changed since the last call, so that
+// a call costs what the commands change rather than the size of the stack; a helper
+// just started is sent the whole stack in one message. A command remembers what it
+// changed, so that undo and redo do not cross at all, and still work after the
+// helper restarts.
+// If the helper stops, it is restarted, and loads again the plugins loaded in it. A
+// call it had not yet begun is sent to the new helper; a call it stopped in fails,
+// leaving the stack as it was.
+
+#include <memory>
+#include <string>
+
+namespace pdCalc {
+
+class DynamicLoader;
+class HostConnection;
+
+class PluginHost
+{
+public:
+    // starts executable, the helper; throws Exception if it cannot be started
+    explicit PluginHost(const std::string& executable);
+
+    // The helper is told to exit once the last plugin loaded in it is deallocated,
+    // which may be after the host is gone.
+    ~PluginHost();
+
+    // loads plugins in the helper; a plugin that cannot be loaded is null, as for
+    // the platform's loader
+    std::unique_ptr<DynamicLoader> createDynamicLoader();
+
+    // times the helper has been restarted since it was started
+    size_t restarts() const;
+
+    // the helper's process id
+    long processId() const;
+
+    // The helper's side, which pdCalcPluginHost runs: serves the parent on the
+    // channel described by description until the parent says to exit or goes away.
+    // Returns the exit code.
+    static int Serve(const std::string& description);
+
+private:
+    PluginHost(const PluginHost&) = delete;
+    PluginHost(PluginHost&&) = delete;
+    PluginHost& operator=(const PluginHost&) = delete;
+    PluginHost& operator=(PluginHost&&) = delete;
+
+    std::shared_ptr<HostConnection> connection_;
+};
+
+}
+
+#endif
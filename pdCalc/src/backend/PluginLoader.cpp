@@ -18,47 +18,232 @@
 
 #include "PluginLoader.h"
 #include "utilities/UserInterface.h"
+#include "utilities/Exception.h"
 #include <fstream>
 #include <iterator>
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <utility>
+#include "Command.h"
+#include "CommandRepository.h"
 #include "DynamicLoader.h"
+#include "FileWatcher.h"
 #include "Plugin.h"
 #include "PlatformFactory.h"
+#include "PluginHost.h"
+#include "StaticPluginRegistry.h"
 
 using std::vector;
 using std::string;
+using std::set;
+using std::pair;
 using std::ifstream;
+using std::ofstream;
+using std::ostringstream;
 using std::unique_ptr;
+using std::shared_ptr;
+using std::weak_ptr;
+using std::mutex;
+using std::lock_guard;
 
 namespace pdCalc {
 
-class PluginDeleter
+// A version of a plugin and the library its code is in. The library is closed, and
+// the copy it was loaded from, if any, removed, once nothing refers to it.
+class PluginLibrary
 {
 public:
-    explicit PluginDeleter(DynamicLoader& d) : loader_{d} {}
-    void operator()(Plugin* p) { loader_.deallocatePlugin(p); }
+    // loads filename, or a copy of it, in host if it is not null, whose plugin is
+    // null if it cannot be loaded; throws Exception if the copy cannot be made. A
+    // plugin linked into pdCalc is allocated from StaticPluginRegistry instead.
+    PluginLibrary(const string& filename, bool copy, PluginHost* host);
+    ~PluginLibrary();
+
+    const Plugin* plugin() const { return plugin_; }
+
+    // the file the plugin was loaded from as the loader found it, or the name it
+    // was loaded by if the loader cannot tell
+    const string& loadedFrom() const { return loadedFrom_; }
+
+private:
+    PluginLibrary(const PluginLibrary&) = delete;
+    PluginLibrary(PluginLibrary&&) = delete;
+    PluginLibrary& operator=(const PluginLibrary&) = delete;
+    PluginLibrary& operator=(PluginLibrary&&) = delete;
+
+    unique_ptr<DynamicLoader> loader_;
+    Plugin* plugin_;
+    string copy_;
+    string loadedFrom_;
+};
+
+// A plugin's command, which keeps the plugin's library open for as long as it, or a
+// command cloned from it, lives.
+class LibraryCommand : public Command
+{
+public:
+    LibraryCommand(CommandPtr command, shared_ptr<const PluginLibrary> library);
 
 private:
-    DynamicLoader& loader_;
+    LibraryCommand(const LibraryCommand&) = delete;
+    LibraryCommand(LibraryCommand&&) = delete;
+    LibraryCommand& operator=(const LibraryCommand&) = delete;
+    LibraryCommand& operator=(LibraryCommand&&) = delete;
+
+    void checkPreconditionsImpl() const override { command_->checkPreconditionsImpl(); }
+    void executeImpl() noexcept override { command_->executeImpl(); }
+    void undoImpl() noexcept override { command_->undoImpl(); }
+    Command* cloneImpl() const override;
+    const char* helpMessageImpl() const noexcept override { return command_->helpMessageImpl(); }
+
+    // declared first, so that the command is gone before the library is released
+    shared_ptr<const PluginLibrary> library_;
+    CommandPtr command_;
 };
 
+namespace {
+
+// A name for a copy of filename beside it, unique to this process and this load, so
+// that the copy is loaded as a library of its own. The extension is kept, since
+// Windows adds one to a name without it.
+string copyName(const string& filename)
+{
+    static std::random_device random;
+    ostringstream oss;
+    oss << ".reload-" << std::hex << random() << random();
+
+    const auto slash = filename.find_last_of("/\\");
+    const auto dot = filename.find_last_of('.');
+    if( dot == string::npos || (slash != string::npos && dot < slash) ) return filename + oss.str();
+    else return filename.substr(0, dot) + oss.str() + filename.substr(dot);
+}
+
+void copyFile(const string& from, const string& to)
+{
+    ifstream in{from, std::ios::binary};
+    ofstream out{to, std::ios::binary | std::ios::trunc};
+    if(in && out) out << in.rdbuf();
+    out.close();
+
+    if(!in || !out)
+    {
+        std::remove( to.c_str() );
+        throw Exception{"Could not copy " + from};
+    }
+
+    return;
+}
+
+// the plugin's commands, each keeping its library open
+vector<pair<string, CommandPtr>> prototypes(const shared_ptr<const PluginLibrary>& library)
+{
+    const auto& descriptor = library->plugin()->getPluginDescriptor();
+
+    vector<pair<string, CommandPtr>> commands;
+    for(int i = 0; i < descriptor.nCommands; ++i)
+    {
+        auto c = MakeCommandPtr( descriptor.commands[i]->clone() );
+        if(c) commands.emplace_back( descriptor.commandNames[i], MakeCommandPtr<LibraryCommand>(std::move(c), library) );
+    }
+
+    return commands;
+}
+
+}
+
+// A copy that is loaded is removed at once, which POSIX systems allow; Windows does
+// not, until the library is closed. A copy loaded in a plugin host is kept until then
+// everywhere, since a helper that restarts loads it again.
+PluginLibrary::PluginLibrary(const string& filename, bool copy, PluginHost* host)
+: plugin_{nullptr}
+{
+    const auto& registry = StaticPluginRegistry::Instance();
+    if( registry.hasPlugin(filename) )
+    {
+        loader_ = registry.createDynamicLoader();
+        copy = false;
+        host = nullptr;
+    }
+    else if(host) loader_ = host->createDynamicLoader();
+    else loader_ = PlatformFactory::Instance().createDynamicLoader();
+
+    if(copy)
+    {
+        copy_ = copyName(filename);
+        copyFile(filename, copy_);
+    }
+
+    // may be null
+    plugin_ = loader_->allocatePlugin(copy ? copy_ : filename);
+    if(copy && (!host || !plugin_)) std::remove( copy_.c_str() );
+
+    loadedFrom_ = loader_->loadedFrom();
+    if( loadedFrom_.empty() ) loadedFrom_ = copy ? copy_ : filename;
+}
+
+PluginLibrary::~PluginLibrary()
+{
+    if(plugin_) loader_->deallocatePlugin(plugin_);
+    loader_.reset();
+    if( !copy_.empty() ) std::remove( copy_.c_str() );
+}
+
+LibraryCommand::LibraryCommand(CommandPtr command, shared_ptr<const PluginLibrary> library)
+: library_{ std::move(library) }
+, command_{ std::move(command) }
+{ }
+
+Command* LibraryCommand::cloneImpl() const
+{
+    auto c = MakeCommandPtr( command_->clone() );
+    return c ? new LibraryCommand{std::move(c), library_} : nullptr;
+}
+
 class PluginLoader::PluginLoaderImpl
 {
 public:
-    PluginLoaderImpl();
+    explicit PluginLoaderImpl(shared_ptr<PluginHost> host);
 
     void loadPlugins(UserInterface& ui, const string& pluginFileName);
     const vector<const Plugin *> getPlugins();
+    set<string> registerCommands(UserInterface& ui);
+    void deregisterCommands();
+    void watchPlugins(UserInterface& ui);
+    size_t openLibraries() const;
 
 private:
+    // a plugin's file, as the loader found it, so that a name without a directory
+    // is watched and copied where it was loaded from rather than beside pdCalc;
+    // the version of it loaded last; and the commands registered from it, if they
+    // were
+    struct Loaded
+    {
+        string filename;
+        shared_ptr<const PluginLibrary> library;
+        bool registered;
+        vector<string> commands;
+    };
+
     void load(UserInterface& ui, const string&);
+    void reload(const string& filename);
+
+    shared_ptr<PluginHost> host_;
+    vector<Loaded> plugins_;
+    vector<weak_ptr<const PluginLibrary>> libraries_; // every version loaded
+    UserInterface* ui_; // told of reloads
+    mutable mutex mutex_;
 
-    vector<unique_ptr<DynamicLoader>> loaders_;
-    vector<unique_ptr<Plugin, PluginDeleter>> plugins_;
+    // last, so that a reload under way finishes before anything else is destroyed;
+    // the watcher is destroyed without the lock, which a reload waits for
+    unique_ptr<FileWatcher> watcher_;
 };
 
-PluginLoader::PluginLoaderImpl::PluginLoaderImpl()
+PluginLoader::PluginLoaderImpl::PluginLoaderImpl(shared_ptr<PluginHost> host)
+: host_{ std::move(host) }
+, ui_{nullptr}
 {
 }
 
@@ -73,6 +258,7 @@ void PluginLoader::PluginLoaderImpl::loadPlugins(UserInterface& ui, const string
     {
         vector<string> pluginNames{ std::istream_iterator<string>(ifs), std::istream_iterator<string>() };
 
+        lock_guard<mutex> lock{mutex_};
         for(auto i : pluginNames) load(ui, i);
     }
 
@@ -81,27 +267,155 @@ void PluginLoader::PluginLoaderImpl::loadPlugins(UserInterface& ui, const string
 
 const vector<const Plugin*> PluginLoader::PluginLoaderImpl::getPlugins()
 {
+    lock_guard<mutex> lock{mutex_};
     vector<const Plugin*> v;
     for(auto& i : plugins_)
-        v.push_back( i.get() );
+        v.push_back( i.library->plugin() );
 
     return v;
 }
 
 void PluginLoader::PluginLoaderImpl::load(UserInterface& ui, const string& name)
 {
-    loaders_.emplace_back( PlatformFactory::Instance().createDynamicLoader() );
-
-    // may be null
-    auto p = loaders_.back()->allocatePlugin(name);
-    if(p) plugins_.emplace_back( p, PluginDeleter( *loaders_.back() ) );
+    auto library = std::make_shared<const PluginLibrary>( name, false, host_.get() );
+    if( library->plugin() )
+    {
+        plugins_.push_back( Loaded{library->loadedFrom(), library, false, {}} );
+        libraries_.push_back(library);
+    }
     else ui.postMessage("Error opening plugin");
 
     return;
 }
 
-PluginLoader::PluginLoader()
-: pimpl_{ new PluginLoaderImpl }
+set<string> PluginLoader::PluginLoaderImpl::registerCommands(UserInterface& ui)
+{
+    lock_guard<mutex> lock{mutex_};
+    set<string> names;
+    for(auto& p : plugins_)
+    {
+        if( !Supported( *p.library->plugin() ) )
+        {
+            ui.postMessage("Plugin API version is incompatible. Need v. 1.0.");
+            continue;
+        }
+
+        for(auto& c : prototypes(p.library))
+        {
+            try
+            {
+                CommandRepository::Instance().registerCommand( c.first, std::move(c.second) );
+            }
+            catch(Exception& e)
+            {
+                ui.postMessage( e.what() );
+                continue;
+            }
+
+            p.commands.push_back(c.first);
+            names.insert(c.first);
+        }
+        p.registered = true;
+    }
+
+    return names;
+}
+
+void PluginLoader::PluginLoaderImpl::deregisterCommands()
+{
+    unique_ptr<FileWatcher> watcher;
+    {
+        lock_guard<mutex> lock{mutex_};
+        watcher.swap(watcher_);
+    }
+    watcher.reset();
+
+    lock_guard<mutex> lock{mutex_};
+    for(auto& p : plugins_)
+    {
+        for(const auto& c : p.commands)
+            CommandRepository::Instance().deregisterCommand(c);
+
+        p.commands.clear();
+        p.registered = false;
+    }
+
+    return;
+}
+
+void PluginLoader::PluginLoaderImpl::watchPlugins(UserInterface& ui)
+{
+    vector<string> files;
+    {
+        lock_guard<mutex> lock{mutex_};
+        ui_ = &ui;
+        for(const auto& p : plugins_)
+        {
+            // a plugin linked into pdCalc has no file of its own to change
+            if( StaticPluginRegistry::Instance().hasPlugin(p.filename) ) continue;
+            if( std::find( files.begin(), files.end(), p.filename ) == files.end() ) files.push_back(p.filename);
+        }
+    }
+
+    auto watcher = PlatformFactory::Instance().createFileWatcher( files, [this](const string& f){ reload(f); } );
+    {
+        lock_guard<mutex> lock{mutex_};
+        watcher.swap(watcher_);
+    }
+
+    return;
+}
+
+// The new version must load before anything changes, and its commands replace the
+// old version's all at once or not at all; the old prototypes, and with them the old
+// library unless its commands are still in use, go when the reload returns.
+void PluginLoader::PluginLoaderImpl::reload(const string& filename)
+{
+    lock_guard<mutex> lock{mutex_};
+    try
+    {
+        auto library = std::make_shared<const PluginLibrary>( filename, true, host_.get() );
+        if( !library->plugin() )
+            throw Exception{"Error opening plugin " + filename};
+        if( !Supported( *library->plugin() ) )
+            throw Exception{"Plugin API version is incompatible. Need v. 1.0."};
+
+        for(auto& p : plugins_)
+        {
+            if(p.filename != filename) continue;
+
+            vector<pair<string, CommandPtr>> commands;
+            if(p.registered) commands = prototypes(library);
+
+            vector<string> names;
+            for(const auto& c : commands) names.push_back(c.first);
+
+            CommandRepository::Instance().replaceCommands( p.commands, std::move(commands) );
+            p.library = library;
+            p.commands = std::move(names);
+        }
+
+        libraries_.push_back(library);
+        ui_->postMessage("Reloaded plugin " + filename);
+    }
+    catch(Exception& e)
+    {
+        ui_->postMessage( e.what() );
+    }
+
+    return;
+}
+
+size_t PluginLoader::PluginLoaderImpl::openLibraries() const
+{
+    lock_guard<mutex> lock{mutex_};
+
+    return std::count_if( libraries_.begin(), libraries_.end(),
+        [](const weak_ptr<const PluginLibrary>& l){ return !l.expired(); } );
+}
+
+PluginLoader::PluginLoader(shared_ptr<PluginHost> host)
+: pimpl_{ new PluginLoaderImpl{ std::move(host) } }
 { }
 
 PluginLoader::~PluginLoader()
@@ -118,5 +432,33 @@ const std::vector<const Plugin*> PluginLoader::getPlugins()
     return pimpl_->getPlugins();
 }
 
+bool PluginLoader::Supported(const Plugin& p)
+{
+    auto apiVersion = p.apiVersion();
+
+    return apiVersion.major == 1 && apiVersion.minor == 0;
+}
+
+set<string> PluginLoader::registerCommands(UserInterface& ui)
+{
+    return pimpl_->registerCommands(ui);
+}
+
+void PluginLoader::deregisterCommands()
+{
+    pimpl_->deregisterCommands();
+    return;
 }
 
+void PluginLoader::watchPlugins(UserInterface& ui)
+{
+    pimpl_->watchPlugins(ui);
+    return;
+}
+
+size_t PluginLoader::openLibraries() const
+{
+    return pimpl_->openLibraries();
+}
+
+}
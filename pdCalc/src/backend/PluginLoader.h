@@ -24,26 +24,62 @@
 // on separate lines.
 // If a plugin cannot be loaded, the loader fails informs
 // the UI but ignores the error.
+// The loader can also watch the plugins' files and reload a
+// plugin whose file changes while pdCalc runs.
+// Given a PluginHost, the loader loads the plugins in the host's
+// helper process instead of in pdCalc.
+// A plugin linked into pdCalc (see StaticPluginRegistry) is
+// loaded from pdCalc itself, whatever the loader is given.
 
 #include <vector>
 #include <string>
 #include <memory>
+#include <set>
 
 namespace pdCalc {
 
 class Plugin;
+class PluginHost;
 class UserInterface;
 
 class PluginLoader
 {
     class PluginLoaderImpl;
 public:
-    PluginLoader();
+    explicit PluginLoader(std::shared_ptr<PluginHost> host = nullptr);
     ~PluginLoader();
 
     void loadPlugins(UserInterface& ui, const std::string& pluginFileName);
+
+    // the plugins in the versions loaded last; a plugin is good until it is reloaded
     const std::vector<const Plugin*> getPlugins();
 
+    // whether pdCalc supports the plugin's API version, 1.0
+    static bool Supported(const Plugin& p);
+
+    // Registers the plugins' commands with CommandRepository and returns their names.
+    // Each command keeps its plugin's library open for as long as it, or any command
+    // cloned from it, lives. A plugin of an unsupported API version, or a command
+    // whose name is taken, is reported to ui and skipped.
+    std::set<std::string> registerCommands(UserInterface& ui);
+
+    // stops watching, and deregisters the commands registered, in their current
+    // versions
+    void deregisterCommands();
+
+    // Watches the plugins' files, and when one changes, loads the new version from a
+    // copy, alongside the old, and swaps its commands for the old version's in
+    // CommandRepository all at once, telling ui. Commands of the old version still in
+    // use, as entries of the undo history or running, keep working, and its library
+    // is closed once the last of them is gone. Reloads happen, and are reported, on
+    // the watcher's thread. A plugin should be replaced by renaming its new version
+    // over it, since writing over the file first loaded changes code in use. Throws
+    // Exception if the files cannot be watched.
+    void watchPlugins(UserInterface& ui);
+
+    // the plugins' libraries open, including old versions still in use
+    size_t openLibraries() const;
+
 private:
     PluginLoader(const PluginLoader&) = delete;
     PluginLoader(PluginLoader&&) = delete;
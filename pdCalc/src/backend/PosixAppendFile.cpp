@@ -0,0 +1,85 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PosixAppendFile.h"
+#include "utilities/Exception.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+
+namespace pdCalc {
+
+PosixAppendFile::PosixAppendFile(const string& filename, bool truncate)
+: AppendFile{}
+, filename_{filename}
+, fd_{-1}
+{
+    fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+    if(fd_ < 0)
+        throw Exception{"Could not open " + filename};
+}
+
+PosixAppendFile::~PosixAppendFile()
+{
+    close(fd_);
+}
+
+void PosixAppendFile::write(const char* data, size_t n)
+{
+    while(n > 0)
+    {
+        ssize_t written{ ::write(fd_, data, n) };
+        if(written < 0)
+        {
+            if(errno == EINTR) continue;
+            throw Exception{"Could not write " + filename_};
+        }
+
+        data += written;
+        n -= static_cast<size_t>(written);
+    }
+
+    return;
+}
+
+void PosixAppendFile::sync()
+{
+    // the size of an appended file changes, which fdatasync also writes out
+#ifdef __APPLE__
+    int result{ fsync(fd_) };
+#else
+    int result{ fdatasync(fd_) };
+#endif
+    if(result != 0)
+        throw Exception{"Could not write " + filename_};
+
+    return;
+}
+
+// appends follow the end of the file, wherever it is
+void PosixAppendFile::truncate(size_t size)
+{
+    if( ftruncate( fd_, static_cast<off_t>(size) ) != 0 )
+        throw Exception{"Could not write " + filename_};
+
+    return;
+}
+
+}
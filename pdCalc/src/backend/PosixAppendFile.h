@@ -0,0 +1,51 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POSIX_APPEND_FILE_H
+#define POSIX_APPEND_FILE_H
+
+#include <string>
+#include "AppendFile.h"
+
+namespace pdCalc {
+
+class PosixAppendFile : public AppendFile
+{
+public:
+    // opens filename, creating it if necessary, and emptying it if truncate is
+    // true; throws Exception if the file cannot be opened
+    PosixAppendFile(const std::string& filename, bool truncate);
+    ~PosixAppendFile();
+
+    void write(const char* data, size_t n) override;
+    void sync() override;
+    void truncate(size_t size) override;
+
+private:
+    PosixAppendFile(const PosixAppendFile&) = delete;
+    PosixAppendFile(PosixAppendFile&&) = delete;
+    PosixAppendFile& operator=(const PosixAppendFile&) = delete;
+    PosixAppendFile& operator=(PosixAppendFile&&) = delete;
+
+    std::string filename_;
+    int fd_;
+};
+
+}
+
+#endif
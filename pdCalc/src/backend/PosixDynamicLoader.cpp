@@ -49,6 +49,9 @@ Plugin* PosixDynamicLoader::allocatePlugin(const std::string& pluginName)
         PluginAllocator allocator{ reinterpret_cast<PluginAllocator>(alloc) };
         if(allocator)
         {
+            Dl_info info;
+            if( dladdr(alloc, &info) != 0 && info.dli_fname ) loadedFrom_ = info.dli_fname;
+
             auto p = static_cast<Plugin*>((*allocator)());
             return p;
         }
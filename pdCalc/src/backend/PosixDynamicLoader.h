@@ -32,9 +32,11 @@ public:
 
     Plugin* allocatePlugin(const std::string& pluginName) override;
     void deallocatePlugin(Plugin* p) override;
+    std::string loadedFrom() const override { return loadedFrom_; }
 
 private:
     void* handle_;
+    std::string loadedFrom_;
 };
 
 }
@@ -18,6 +18,10 @@
 
 #include "PosixFactory.h"
 #include "PosixDynamicLoader.h"
+#include "PosixMappedFile.h"
+#include "PosixAppendFile.h"
+#include "PosixFileWatcher.h"
+#include "PosixProcessChannel.h"
 
 using std::unique_ptr;
 
@@ -32,5 +36,35 @@ unique_ptr<DynamicLoader> PosixFactory::createDynamicLoader()
     return std::make_unique<PosixDynamicLoader>();
 }
 
+unique_ptr<MappedFile> PosixFactory::createMappedFile(const std::string& filename)
+{
+    return std::make_unique<PosixMappedFile>(filename);
 }
 
+unique_ptr<MappedFile> PosixFactory::createMappedFile(const std::string& filename, size_t offset, size_t length)
+{
+    return std::make_unique<PosixMappedFile>(filename, offset, length);
+}
+
+unique_ptr<AppendFile> PosixFactory::createAppendFile(const std::string& filename, bool truncate)
+{
+    return std::make_unique<PosixAppendFile>(filename, truncate);
+}
+
+unique_ptr<FileWatcher> PosixFactory::createFileWatcher(const std::vector<std::string>& filenames,
+    FileWatcher::Changed changed)
+{
+    return std::make_unique<PosixFileWatcher>( filenames, std::move(changed) );
+}
+
+unique_ptr<ProcessChannel> PosixFactory::createProcessChannel(const std::string& executable, size_t size)
+{
+    return std::make_unique<PosixProcessChannel>(executable, size);
+}
+
+unique_ptr<ProcessChannel> PosixFactory::openProcessChannel(const std::string& description)
+{
+    return std::make_unique<PosixProcessChannel>(description);
+}
+
+}
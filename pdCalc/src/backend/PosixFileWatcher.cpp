@@ -0,0 +1,163 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PosixFileWatcher.h"
+#include "utilities/Exception.h"
+#include <cerrno>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// twice a second, without inotify
+const int PollMilliseconds = 500;
+
+#ifdef __linux__
+// a file written in place is complete once it is closed
+const uint32_t ChangeEvents = IN_CLOSE_WRITE | IN_MOVED_TO;
+#endif
+
+}
+
+PosixFileWatcher::PosixFileWatcher(const vector<string>& filenames, Changed changed)
+: FileWatcher{}
+, changed_{ std::move(changed) }
+, inotify_{-1}
+, stop_{-1, -1}
+{
+    if(pipe(stop_) != 0)
+        throw Exception{"Could not watch files"};
+
+#ifdef __linux__
+    inotify_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if(inotify_ < 0)
+    {
+        close(stop_[0]);
+        close(stop_[1]);
+        throw Exception{"Could not watch files"};
+    }
+#endif
+
+    for(const auto& f : filenames)
+    {
+        const auto slash = f.find_last_of('/');
+        const string directory{ slash == string::npos ? "." : f.substr(0, slash + 1) };
+        Watched w{ f, slash == string::npos ? f : f.substr(slash + 1), -1, 0, 0, 0 };
+
+#ifdef __linux__
+        w.directory = inotify_add_watch( inotify_, directory.c_str(), ChangeEvents );
+        if(w.directory < 0)
+        {
+            close(inotify_);
+            close(stop_[0]);
+            close(stop_[1]);
+            throw Exception{"Could not watch " + f};
+        }
+#endif
+
+        struct stat s;
+        if(stat(f.c_str(), &s) == 0)
+        {
+            w.inode = s.st_ino;
+            w.size = s.st_size;
+            w.modified = s.st_mtime;
+        }
+        files_.push_back( std::move(w) );
+    }
+
+    thread_ = std::thread{ [this]{ run(); } };
+}
+
+PosixFileWatcher::~PosixFileWatcher()
+{
+    const char stop{0};
+    while(write(stop_[1], &stop, 1) < 0 && errno == EINTR) { }
+    thread_.join();
+
+    if(inotify_ >= 0) close(inotify_);
+    close(stop_[0]);
+    close(stop_[1]);
+}
+
+// the thread waits for changes, or with no inotify, for the next time to look, until
+// the pipe is written
+void PosixFileWatcher::run()
+{
+    pollfd fds[2] = { {stop_[0], POLLIN, 0}, {inotify_, POLLIN, 0} };
+    const bool notified{ inotify_ >= 0 };
+
+    while(true)
+    {
+        if( ::poll(fds, notified ? 2 : 1, notified ? -1 : PollMilliseconds) < 0 )
+        {
+            if(errno == EINTR) continue;
+            return;
+        }
+        if(fds[0].revents != 0) return;
+
+        if(!notified) poll();
+#ifdef __linux__
+        else if(fds[1].revents & POLLIN)
+        {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t n{ read( inotify_, buffer, sizeof(buffer) ) };
+            if(n < 0 && errno != EINTR && errno != EAGAIN) return;
+
+            for(ssize_t i = 0; i < n; )
+            {
+                const inotify_event* e{ reinterpret_cast<const inotify_event*>(buffer + i) };
+                i += sizeof(inotify_event) + e->len;
+                if(e->len == 0) continue;
+
+                for(const auto& w : files_)
+                    if(w.directory == e->wd && w.name == e->name) changed_(w.filename);
+            }
+        }
+#endif
+    }
+}
+
+// without inotify, looks at each file for a change; one still being written has
+// changed again by the next look
+void PosixFileWatcher::poll()
+{
+    for(auto& w : files_)
+    {
+        struct stat s;
+        if(stat(w.filename.c_str(), &s) != 0) continue;
+        if(s.st_ino == w.inode && s.st_size == w.size && s.st_mtime == w.modified) continue;
+
+        w.inode = s.st_ino;
+        w.size = s.st_size;
+        w.modified = s.st_mtime;
+        changed_(w.filename);
+    }
+
+    return;
+}
+
+}
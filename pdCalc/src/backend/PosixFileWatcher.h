@@ -0,0 +1,69 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POSIX_FILE_WATCHER_H
+#define POSIX_FILE_WATCHER_H
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include "FileWatcher.h"
+
+namespace pdCalc {
+
+class PosixFileWatcher : public FileWatcher
+{
+public:
+    // starts watching filenames, calling changed with each that changes; throws
+    // Exception if they cannot be watched
+    PosixFileWatcher(const std::vector<std::string>& filenames, Changed changed);
+    ~PosixFileWatcher();
+
+private:
+    PosixFileWatcher(const PosixFileWatcher&) = delete;
+    PosixFileWatcher(PosixFileWatcher&&) = delete;
+    PosixFileWatcher& operator=(const PosixFileWatcher&) = delete;
+    PosixFileWatcher& operator=(PosixFileWatcher&&) = delete;
+
+    // A file is watched through its directory, since a file renamed over it is
+    // another file. Without inotify, it has changed when its inode, size, or
+    // modification time does.
+    struct Watched
+    {
+        std::string filename;
+        std::string name; // within its directory
+        int directory;    // the inotify watch
+        ino_t inode;
+        off_t size;
+        time_t modified;
+    };
+
+    void run();
+    void poll();
+
+    Changed changed_;
+    std::vector<Watched> files_;
+    int inotify_;
+    int stop_[2]; // a pipe, written to stop the thread
+    std::thread thread_;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PosixMappedFile.h"
+#include "utilities/Exception.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string;
+
+namespace pdCalc {
+
+PosixMappedFile::PosixMappedFile(const string& filename)
+: MappedFile{}
+, data_{nullptr}
+, size_{0}
+, view_{nullptr}
+, viewSize_{0}
+{
+    map(filename, true, 0, 0);
+}
+
+PosixMappedFile::PosixMappedFile(const string& filename, size_t offset, size_t length)
+: MappedFile{}
+, data_{nullptr}
+, size_{0}
+, view_{nullptr}
+, viewSize_{0}
+{
+    map(filename, false, offset, length);
+}
+
+PosixMappedFile::~PosixMappedFile()
+{
+    if(view_) munmap(view_, viewSize_);
+}
+
+// mmap needs an offset on a page boundary, so a range maps from the page holding
+// its first byte
+void PosixMappedFile::map(const string& filename, bool whole, size_t offset, size_t length)
+{
+    int fd{ open(filename.c_str(), O_RDONLY) };
+    if(fd < 0)
+        throw Exception{"Could not open " + filename};
+
+    struct stat status;
+    if(fstat(fd, &status) != 0)
+    {
+        close(fd);
+        throw Exception{"Could not read " + filename};
+    }
+
+    const size_t fileSize{ static_cast<size_t>(status.st_size) };
+    if(whole) length = fileSize;
+    else if(offset > fileSize || length > fileSize - offset)
+    {
+        close(fd);
+        throw Exception{"Could not read " + filename};
+    }
+
+    size_ = length;
+    if(size_ > 0)
+    {
+        const size_t page{ static_cast<size_t>( sysconf(_SC_PAGESIZE) ) };
+        const size_t start{ offset - offset % page };
+        viewSize_ = size_ + (offset - start);
+
+        void* p{ mmap(nullptr, viewSize_, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(start)) };
+        if(p == MAP_FAILED)
+        {
+            close(fd);
+            throw Exception{"Could not map " + filename};
+        }
+
+        // a whole file is read front to back, once
+        if(whole) madvise(p, viewSize_, MADV_SEQUENTIAL);
+        view_ = p;
+        data_ = static_cast<const char*>(p) + (offset - start);
+    }
+
+    // the mapping keeps the file open
+    close(fd);
+
+    return;
+}
+
+}
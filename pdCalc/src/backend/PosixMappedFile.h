@@ -0,0 +1,58 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POSIX_MAPPED_FILE_H
+#define POSIX_MAPPED_FILE_H
+
+#include <string>
+#include "MappedFile.h"
+
+namespace pdCalc {
+
+class PosixMappedFile : public MappedFile
+{
+public:
+    // throws Exception if the file cannot be opened or mapped
+    explicit PosixMappedFile(const std::string& filename);
+
+    // maps only length bytes from offset
+    PosixMappedFile(const std::string& filename, size_t offset, size_t length);
+    ~PosixMappedFile();
+
+    const char* data() const override { return data_; }
+    size_t size() const override { return size_; }
+
+private:
+    PosixMappedFile(const PosixMappedFile&) = delete;
+    PosixMappedFile(PosixMappedFile&&) = delete;
+    PosixMappedFile& operator=(const PosixMappedFile&) = delete;
+    PosixMappedFile& operator=(PosixMappedFile&&) = delete;
+
+    void map(const std::string& filename, bool whole, size_t offset, size_t length);
+
+    const char* data_;
+    size_t size_;
+
+    // the pages mapped, which start at or before data_
+    void* view_;
+    size_t viewSize_;
+};
+
+}
+
+#endif
@@ -0,0 +1,235 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PosixProcessChannel.h"
+#include "utilities/Exception.h"
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using std::string;
+using std::ostringstream;
+using std::istringstream;
+
+namespace pdCalc {
+
+namespace {
+
+// where the helper finds its ends of the channel
+const int HelperMemory = 3;
+const int HelperSocket = 4;
+
+// how long a helper whose channel has closed is given to exit before it is killed
+const int ExitMilliseconds = 1000;
+
+#ifdef MSG_NOSIGNAL
+const int SendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+const int SendFlags = MSG_DONTWAIT;
+#endif
+
+// a descriptor of this process's own, above any the helper is given, that is not
+// inherited by helpers started later
+int moveUp(int fd)
+{
+    const int moved{ fcntl(fd, F_DUPFD_CLOEXEC, HelperSocket + 1) };
+    close(fd);
+
+    return moved;
+}
+
+// a socket that writing to raises no SIGPIPE, whether or not send can say so
+void noSigPipe(int fd)
+{
+#ifdef SO_NOSIGPIPE
+    const int on{1};
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    fcntl( fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK );
+
+    return;
+}
+
+}
+
+// The memory is named only until it is opened, so that nothing is left behind
+// however either side ends. The helper is given its ends as descriptors 3 and 4;
+// everything else this process has open is closed in it, as every descriptor here
+// is opened close on exec. An executable named without a directory is looked for
+// on the path, as a shell would.
+PosixProcessChannel::PosixProcessChannel(const string& executable, size_t size)
+: memory_{nullptr}
+, size_{size}
+, socket_{-1}
+, helper_{0}
+, exited_{false}
+{
+    static std::random_device random;
+    ostringstream name;
+    name << "/pdCalc-" << getpid() << '-' << std::hex << random() << random();
+
+    int memory{ shm_open(name.str().c_str(), O_RDWR | O_CREAT | O_EXCL, 0600) };
+    if(memory < 0)
+        throw Exception{"Could not create memory for " + executable};
+    shm_unlink( name.str().c_str() );
+
+    int sockets[2];
+    if( ftruncate(memory, size) != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0 )
+    {
+        close(memory);
+        throw Exception{"Could not create memory for " + executable};
+    }
+
+    memory = moveUp(memory);
+    socket_ = moveUp(sockets[0]);
+    const int helperSocket{ moveUp(sockets[1]) };
+    noSigPipe(socket_);
+
+    try
+    {
+        map(memory);
+    }
+    catch(Exception&)
+    {
+        close(memory);
+        close(socket_);
+        close(helperSocket);
+        throw;
+    }
+
+    ostringstream description;
+    description << HelperMemory << ',' << HelperSocket << ',' << size;
+    const string arg{ description.str() };
+    char* argv[] = { const_cast<char*>( executable.c_str() ), const_cast<char*>( arg.c_str() ), nullptr };
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, memory, HelperMemory);
+    posix_spawn_file_actions_adddup2(&actions, helperSocket, HelperSocket);
+    const bool onPath{ executable.find('/') == string::npos };
+    const int error{ (onPath ? posix_spawnp : posix_spawn)(&helper_, executable.c_str(), &actions, nullptr, argv, environ) };
+    posix_spawn_file_actions_destroy(&actions);
+
+    close(memory);
+    close(helperSocket);
+    if(error != 0)
+    {
+        munmap(memory_, size_);
+        close(socket_);
+        throw Exception{"Could not start " + executable};
+    }
+}
+
+PosixProcessChannel::PosixProcessChannel(const string& description)
+: memory_{nullptr}
+, size_{0}
+, socket_{-1}
+, helper_{0}
+, exited_{false}
+{
+    int memory;
+    char comma1, comma2;
+    istringstream iss{description};
+    if( !(iss >> memory >> comma1 >> socket_ >> comma2 >> size_) || comma1 != ',' || comma2 != ',' )
+        throw Exception{"Not a channel: " + description};
+
+    fcntl(memory, F_SETFD, FD_CLOEXEC);
+    fcntl(socket_, F_SETFD, FD_CLOEXEC);
+    noSigPipe(socket_);
+    map(memory);
+    close(memory);
+}
+
+PosixProcessChannel::~PosixProcessChannel()
+{
+    if(memory_) munmap(memory_, size_);
+    close(socket_);
+
+    if(helper_ == 0 || exited_) return;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ExitMilliseconds};
+    while( waitpid(helper_, nullptr, WNOHANG) == 0 )
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+        {
+            kill(helper_, SIGKILL);
+            while(waitpid(helper_, nullptr, 0) < 0 && errno == EINTR) { }
+            break;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds{5} );
+    }
+}
+
+void PosixProcessChannel::map(int fd)
+{
+    void* p{ mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) };
+    if(p == MAP_FAILED)
+        throw Exception{"Could not map the memory of a channel"};
+
+    memory_ = static_cast<char*>(p);
+
+    return;
+}
+
+// a full socket already has the other side's attention
+void PosixProcessChannel::notify()
+{
+    const char ring{0};
+    while(send(socket_, &ring, 1, SendFlags) < 0 && errno == EINTR) { }
+
+    return;
+}
+
+// Every ring waiting is taken at once. The other side has gone when its end of the
+// socket closes; a helper is also looked for when the wait times out, in case its
+// end was inherited by something that outlives it.
+bool PosixProcessChannel::wait(int milliseconds)
+{
+    pollfd p{socket_, POLLIN, 0};
+    const int n{ poll(&p, 1, milliseconds) };
+    if(n > 0)
+    {
+        char rings[64];
+        const auto r = recv(socket_, rings, sizeof(rings), MSG_DONTWAIT);
+        if(r > 0) return true;
+        if( r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) )
+            throw Exception{"The other side of the channel has gone"};
+    }
+    else if( n == 0 && helper_ != 0 && !exited_ && waitpid(helper_, nullptr, WNOHANG) == helper_ )
+    {
+        exited_ = true;
+        throw Exception{"The other side of the channel has gone"};
+    }
+
+    return false;
+}
+
+}
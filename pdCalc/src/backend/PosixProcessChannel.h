@@ -0,0 +1,64 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POSIX_PROCESS_CHANNEL_H
+#define POSIX_PROCESS_CHANNEL_H
+
+#include <string>
+#include <sys/types.h>
+#include "ProcessChannel.h"
+
+namespace pdCalc {
+
+class PosixProcessChannel : public ProcessChannel
+{
+public:
+    // the parent's end: starts executable with size bytes of memory shared with it;
+    // throws Exception if either cannot be had
+    PosixProcessChannel(const std::string& executable, size_t size);
+
+    // the helper's end, from the description its parent passed it; throws Exception
+    // if it does not describe a channel
+    explicit PosixProcessChannel(const std::string& description);
+
+    ~PosixProcessChannel();
+
+    char* memory() override { return memory_; }
+    size_t size() const override { return size_; }
+    void notify() override;
+    bool wait(int milliseconds) override;
+    long processId() const override { return helper_; }
+
+private:
+    PosixProcessChannel(const PosixProcessChannel&) = delete;
+    PosixProcessChannel(PosixProcessChannel&&) = delete;
+    PosixProcessChannel& operator=(const PosixProcessChannel&) = delete;
+    PosixProcessChannel& operator=(PosixProcessChannel&&) = delete;
+
+    void map(int fd);
+
+    char* memory_;
+    size_t size_;
+    int socket_; // this side's end of a socket pair, whose bytes are the doorbell
+    pid_t helper_; // 0 in the helper
+    bool exited_;
+};
+
+}
+
+#endif
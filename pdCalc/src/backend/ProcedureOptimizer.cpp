@@ -0,0 +1,383 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ProcedureOptimizer.h"
+#include "CoreOperations.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <sstream>
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// what the optimizer knows of a core command: the elements it takes from the stack
+// and leaves on it, and whether it can fail on the values it takes
+struct Effect
+{
+    size_t takes;
+    size_t leaves;
+    bool mayFail;
+};
+
+const std::map<string, Effect>& CoreEffects()
+{
+    static const std::map<string, Effect> effects = {
+        {"swap", {2, 2, false}}, {"drop", {1, 0, false}}, {"dup", {1, 2, false}},
+        {"neg", {1, 1, false}}, {"sq", {1, 1, false}},
+        {"+", {2, 1, false}}, {"-", {2, 1, false}}, {"*", {2, 1, false}},
+        {"/", {2, 1, true}}, {"pow", {2, 1, true}}, {"root", {2, 1, true}},
+        {"sin", {1, 1, false}}, {"cos", {1, 1, false}}, {"tan", {1, 1, true}},
+        {"arcsin", {1, 1, true}}, {"arccos", {1, 1, true}}, {"arctan", {1, 1, false}},
+        {"prec", {1, 0, true}}
+    };
+
+    return effects;
+}
+
+// the operation of a core command on two literals, unless the command would fail on
+// them; the checks are the command's own
+template<typename Operation>
+bool foldBinary(double next, double top, double& result)
+{
+    if( Operation::Domain(next, top) ) return false;
+    result = Operation::Apply(next, top);
+
+    return true;
+}
+
+// a token that enters exactly d
+string numberToken(double d)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", d);
+    return buf;
+}
+
+string negatedToken(const string& s)
+{
+    if(s[0] == '-') return s.substr(1);
+    else if(s[0] == '+') return "-" + s.substr(1);
+    else return "-" + s;
+}
+
+}
+
+class ProcedureOptimizer::ProcedureOptimizerImpl
+{
+public:
+    ProcedureOptimizerImpl(size_t stackDepth, bool plain);
+
+    Tokenizer::Tokens optimize(const Tokenizer::Tokens&);
+    const vector<Rewrite>& rewrites() const { return rewrites_; }
+    string report() const;
+
+private:
+    // a token of the optimized procedure with what is known before it executes: a
+    // lower bound on the stack depth, and whether arithmetic is plain double
+    struct Step
+    {
+        string token;
+        bool literal;
+        double value;
+        size_t depth;
+        bool plain;
+    };
+
+    void emit(const string& token);
+    void advance(const Step&);
+    bool rewrite();
+    void replace(size_t n, const char* rule, const vector<string>& replacement);
+
+    bool isLiteral(size_t fromEnd) const;
+    bool isCommand(size_t fromEnd, const char* name) const;
+    const Step& step(size_t fromEnd) const { return steps_[steps_.size() - 1 - fromEnd]; }
+
+    size_t initialDepth_;
+    bool initialPlain_;
+
+    size_t depth_;
+    bool plain_;
+    vector<Step> steps_;
+
+    size_t nTokens_;
+    vector<Rewrite> rewrites_;
+};
+
+ProcedureOptimizer::ProcedureOptimizerImpl::ProcedureOptimizerImpl(size_t stackDepth, bool plain)
+: initialDepth_{stackDepth}
+, initialPlain_{plain}
+, depth_{stackDepth}
+, plain_{plain}
+, nTokens_{0}
+{ }
+
+Tokenizer::Tokens ProcedureOptimizer::ProcedureOptimizerImpl::optimize(const Tokenizer::Tokens& tokens)
+{
+    depth_ = initialDepth_;
+    plain_ = initialPlain_;
+    steps_.clear();
+    rewrites_.clear();
+    nTokens_ = tokens.size();
+
+    // undo and redo act on the procedure's own commands, which must stay as written
+    bool controlFlow{false};
+    bool changesPrecision{false};
+    for(const auto& t : tokens)
+    {
+        if(t == "undo" || t == "redo") return tokens;
+
+        controlFlow = controlFlow || t == "times" || t == "if" || t == "else" || t == "end";
+        changesPrecision = changesPrecision || t == "prec" || t.compare(0, 5, "proc:") == 0;
+    }
+
+    // control flow keywords are unknown commands, so no rewrite spans one and the
+    // depth after one is unknown; a loop can bring a precision change back around
+    // to its start, though, so with both nothing is plain
+    if(controlFlow && changesPrecision) plain_ = false;
+
+    for(const auto& t : tokens)
+        emit(t);
+
+    Tokenizer::Tokens optimized;
+    optimized.reserve( steps_.size() );
+    for(const auto& s : steps_)
+        optimized.push_back(s.token);
+
+    return optimized;
+}
+
+string ProcedureOptimizer::ProcedureOptimizerImpl::report() const
+{
+    std::ostringstream oss;
+    oss << "Optimized " << nTokens_ << " tokens to " << steps_.size() << " with " << rewrites_.size() << " rewrites";
+    for(const auto& r : rewrites_)
+        oss << "\n" << r.rule << ": " << r.before << " -> " << (r.after.empty() ? "(nothing)" : r.after);
+
+    return oss.str();
+}
+
+void ProcedureOptimizer::ProcedureOptimizerImpl::emit(const string& token)
+{
+    Step s{token, false, 0.0, depth_, plain_};
+    s.literal = TokenIsNumber(token, s.value);
+
+    steps_.push_back(s);
+    advance(s);
+
+    while( rewrite() );
+
+    return;
+}
+
+// the depth lower bound and plain arithmetic after s
+void ProcedureOptimizer::ProcedureOptimizerImpl::advance(const Step& s)
+{
+    if(s.literal)
+    {
+        // a number entered in exact mode can fail to convert
+        if(plain_) ++depth_;
+        return;
+    }
+
+    const auto& effects = CoreEffects();
+    auto e = effects.find(s.token);
+    if(s.token == "clear")
+    {
+        depth_ = 0;
+    }
+    else if( e != effects.end() )
+    {
+        // a command on too short a stack fails and leaves it as it was
+        const Effect& effect = e->second;
+        if(depth_ < effect.takes)
+            depth_ = std::min(depth_, effect.leaves);
+        else if(effect.mayFail)
+            depth_ = std::min(depth_, depth_ - effect.takes + effect.leaves);
+        else
+            depth_ = depth_ - effect.takes + effect.leaves;
+    }
+    else depth_ = 0;
+
+    // a nested procedure may change the precision too
+    if( s.token == "prec" || s.token.compare(0, 5, "proc:") == 0 )
+        plain_ = false;
+
+    return;
+}
+
+bool ProcedureOptimizer::ProcedureOptimizerImpl::isLiteral(size_t fromEnd) const
+{
+    return fromEnd < steps_.size() && step(fromEnd).literal;
+}
+
+bool ProcedureOptimizer::ProcedureOptimizerImpl::isCommand(size_t fromEnd, const char* name) const
+{
+    return fromEnd < steps_.size() && !step(fromEnd).literal && step(fromEnd).token == name;
+}
+
+// replaces the last n steps
+void ProcedureOptimizer::ProcedureOptimizerImpl::replace(size_t n, const char* rule, const vector<string>& replacement)
+{
+    Rewrite r{rule, "", ""};
+    for(size_t i = steps_.size() - n; i < steps_.size(); ++i)
+        r.before += (r.before.empty() ? "" : " ") + steps_[i].token;
+    for(const auto& t : replacement)
+        r.after += (r.after.empty() ? "" : " ") + t;
+    rewrites_.push_back(r);
+
+    depth_ = steps_[steps_.size() - n].depth;
+    plain_ = steps_[steps_.size() - n].plain;
+    steps_.resize(steps_.size() - n);
+
+    for(const auto& t : replacement)
+        emit(t);
+
+    return;
+}
+
+// applies the first rule matching the end of the optimized procedure
+bool ProcedureOptimizer::ProcedureOptimizerImpl::rewrite()
+{
+    // constant folding of two literals
+    if( isLiteral(2) && isLiteral(1) && step(2).plain )
+    {
+        const double a{ step(2).value };
+        const double b{ step(1).value };
+        const string& op = step(0).token;
+
+        bool fold{false};
+        double r{0};
+        if(op == "+") fold = foldBinary<AddOperation>(a, b, r);
+        else if(op == "-") fold = foldBinary<SubtractOperation>(a, b, r);
+        else if(op == "*") fold = foldBinary<MultiplyOperation>(a, b, r);
+        else if(op == "/") fold = foldBinary<DivideOperation>(a, b, r);
+        else if(op == "pow") fold = foldBinary<PowerOperation>(a, b, r);
+
+        if( fold && std::isfinite(r) )
+        {
+            replace(3, "fold", {numberToken(r)});
+            return true;
+        }
+
+        if( isCommand(0, "swap") )
+        {
+            string next{ step(2).token };
+            string top{ step(1).token };
+            replace(3, "fold", {top, next});
+            return true;
+        }
+    }
+
+    // constant folding of one literal
+    if( isLiteral(1) && step(1).plain )
+    {
+        const Step& lit = step(1);
+        if( isCommand(0, "neg") )
+        {
+            replace(2, "fold", {negatedToken(lit.token)});
+            return true;
+        }
+        if( isCommand(0, "sq") && std::isfinite(lit.value * lit.value) )
+        {
+            replace(2, "fold", {numberToken(lit.value * lit.value)});
+            return true;
+        }
+        if( isCommand(0, "dup") )
+        {
+            string t{ lit.token };
+            replace(2, "fold", {t, t});
+            return true;
+        }
+        if( isCommand(0, "drop") )
+        {
+            replace(2, "remove", {});
+            return true;
+        }
+
+        // x 1 *, x 1 /, x 1 pow, x 0 -, and x -0 + leave every x, NaN included, as it was
+        if(lit.depth >= 1)
+        {
+            const double c{ lit.value };
+            const string& op = step(0).token;
+            bool identity{ (c == 1 && (op == "*" || op == "/" || op == "pow"))
+                || (c == 0 && !std::signbit(c) && op == "-")
+                || (c == 0 && std::signbit(c) && op == "+") };
+            if( identity && !step(0).literal )
+            {
+                replace(2, "identity", {});
+                return true;
+            }
+        }
+    }
+
+    if( steps_.size() < 2 || step(1).literal ) return false;
+
+    const Step& first = step(1);
+    if( isCommand(1, "neg") && isCommand(0, "neg") && first.plain && first.depth >= 1 )
+    {
+        replace(2, "cancel", {});
+        return true;
+    }
+    if( isCommand(1, "swap") && isCommand(0, "swap") && first.depth >= 2 )
+    {
+        replace(2, "cancel", {});
+        return true;
+    }
+    if( isCommand(1, "dup") && isCommand(0, "drop") && first.depth >= 1 )
+    {
+        replace(2, "cancel", {});
+        return true;
+    }
+    if( isCommand(1, "dup") && isCommand(0, "*") && first.depth >= 1 )
+    {
+        replace(2, "fuse", {"sq"});
+        return true;
+    }
+
+    return false;
+}
+
+ProcedureOptimizer::ProcedureOptimizer(size_t stackDepth, bool plain)
+: pimpl_{ std::make_unique<ProcedureOptimizerImpl>(stackDepth, plain) }
+{ }
+
+ProcedureOptimizer::~ProcedureOptimizer()
+{ }
+
+Tokenizer::Tokens ProcedureOptimizer::optimize(const Tokenizer::Tokens& tokens)
+{
+    return pimpl_->optimize(tokens);
+}
+
+const vector<ProcedureOptimizer::Rewrite>& ProcedureOptimizer::rewrites() const
+{
+    return pimpl_->rewrites();
+}
+
+string ProcedureOptimizer::report() const
+{
+    return pimpl_->report();
+}
+
+}
@@ -0,0 +1,80 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROCEDURE_OPTIMIZER_H
+#define PROCEDURE_OPTIMIZER_H
+
+#include "utilities/Tokenizer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pdCalc {
+
+// Rewrites the tokens of a stored procedure into a shorter sequence with the same
+// observable effect: the same final stack, including exact values, and the same
+// error messages in the same order. The optimizer runs a small peephole pass over
+// the tokens, and it may do any of the following:
+//     fold constant arithmetic:          2 3 pow        ->  8
+//     remove cancelling pairs:           neg neg, swap swap, dup drop
+//     remove identities:                 1 *, 1 /, 1 pow, 0 -
+//     fuse idioms:                       dup *          ->  sq
+// A rewrite that removes a command's stack size check is made only where the
+// stack is known to be deep enough, counting from the depth when the procedure
+// starts. A rewrite that changes how a value is computed (folding, removing neg neg
+// or an identity) is made only in plain double arithmetic, since exact mode rounds
+// at every step and attaches exact values to results. A procedure that undoes or
+// redoes its own commands is left alone. Control flow keywords (times, if, else,
+// end) are barriers: no rewrite spans one.
+class ProcedureOptimizer
+{
+    class ProcedureOptimizerImpl;
+
+public:
+    struct Rewrite
+    {
+        std::string rule;
+        std::string before;
+        std::string after;
+    };
+
+    // stackDepth: the number of elements on the stack when the procedure starts
+    // plain: exact mode is off and no element on the stack has an exact value
+    ProcedureOptimizer(size_t stackDepth, bool plain);
+    ~ProcedureOptimizer();
+
+    Tokenizer::Tokens optimize(const Tokenizer::Tokens&);
+
+    // the rewrites of the last optimize, in the order they were applied
+    const std::vector<Rewrite>& rewrites() const;
+
+    // a summary line followed by one line per rewrite
+    std::string report() const;
+
+private:
+    ProcedureOptimizer(const ProcedureOptimizer&) = delete;
+    ProcedureOptimizer(ProcedureOptimizer&&) = delete;
+    ProcedureOptimizer& operator=(const ProcedureOptimizer&) = delete;
+    ProcedureOptimizer& operator=(ProcedureOptimizer&&) = delete;
+
+    std::unique_ptr<ProcedureOptimizerImpl> pimpl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROCESS_CHANNEL_H
+#define PROCESS_CHANNEL_H
+
+// This is the base class to abstract OS specific helper processes. A channel is a
+// helper process, a block of memory shared with it, and a doorbell each way: either
+// side can wake the other, and a side waiting at its doorbell learns when the other
+// has gone away, however it went. The parent's channel starts the helper, passing it
+// a description of the channel as its one argument, from which the helper opens its
+// end (see PlatformFactory). POSIX systems share the memory with shm_open and ring
+// the doorbells over a socket pair; Windows uses a file mapping and events.
+
+#include <cstddef>
+#include <string>
+
+namespace pdCalc {
+
+class ProcessChannel
+{
+public:
+    // the parent's channel ends the helper, after giving it a moment to exit on its
+    // own, as it should once told to
+    virtual ~ProcessChannel();
+
+    // the shared memory, zeroed when the parent creates it
+    virtual char* memory() = 0;
+    virtual size_t size() const = 0;
+
+    // rings the other side's doorbell; rings are not counted, and one rung after the
+    // other side has gone is lost
+    virtual void notify() = 0;
+
+    // waits up to milliseconds for this side's doorbell, returning whether it rang;
+    // throws Exception if the other side has gone away
+    virtual bool wait(int milliseconds) = 0;
+
+    // the helper's process id, for the parent's channel
+    virtual long processId() const = 0;
+};
+
+}
+
+#endif
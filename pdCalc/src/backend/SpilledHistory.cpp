@@ -0,0 +1,290 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "SpilledHistory.h"
+#include "Stack.h"
+#include "AppendFile.h"
+#include "MappedFile.h"
+#include "PlatformFactory.h"
+#include "utilities/BigNumber.h"
+#include "utilities/Exception.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// a view maps this much of the file, or a whole record if that is larger
+const size_t ViewBytes = size_t{1} << 24;
+
+// records are written in batches of about this much
+const size_t WriteBytes = size_t{1} << 16;
+
+template<typename T>
+void put(string& out, const T& x)
+{
+    out.append( reinterpret_cast<const char*>(&x), sizeof(x) );
+    return;
+}
+
+void putElements(string& out, const vector<double>& d)
+{
+    out.append( reinterpret_cast<const char*>( d.data() ), d.size() * sizeof(double) );
+    return;
+}
+
+void putExact(string& out, const vector<Stack::ExactValue>& exact)
+{
+    const uint64_t n( std::count_if(exact.begin(), exact.end(), [](const Stack::ExactValue& e){ return e != nullptr; }) );
+    put(out, n);
+    for(size_t i = 0; i < exact.size(); ++i)
+    {
+        if(!exact[i]) continue;
+
+        const string s{ exact[i]->toString() };
+        put( out, uint64_t{i} );
+        put( out, static_cast<uint32_t>( s.size() ) );
+        out += s;
+    }
+
+    return;
+}
+
+// reads a body, failing on anything that runs past its end
+class Reader
+{
+public:
+    Reader(const char* p, const char* end) : p_{p}, end_{end} { }
+
+    template<typename T>
+    bool get(T& x)
+    {
+        if( static_cast<size_t>(end_ - p_) < sizeof(x) ) return false;
+        std::memcpy(&x, p_, sizeof(x));
+        p_ += sizeof(x);
+        return true;
+    }
+
+    bool getElements(uint64_t n, vector<double>& d)
+    {
+        if( n > static_cast<size_t>(end_ - p_) / sizeof(double) ) return false;
+        d.resize(n);
+        std::memcpy( d.data(), p_, n * sizeof(double) );
+        p_ += n * sizeof(double);
+        return true;
+    }
+
+    bool getExact(size_t size, vector<Stack::ExactValue>& exact)
+    {
+        uint64_t n;
+        if( !get(n) ) return false;
+
+        for(uint64_t k = 0; k < n; ++k)
+        {
+            uint64_t position;
+            uint32_t length;
+            if( !get(position) || !get(length) || position >= size || length > static_cast<size_t>(end_ - p_) )
+                return false;
+
+            exact.resize(size);
+            exact[position] = std::make_shared<const BigFloat>( BigFloat::FromString( string{p_, length}, length ) );
+            p_ += length;
+        }
+
+        return true;
+    }
+
+    bool done() const { return p_ == end_; }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+StackDelta decode(const char* p, uint64_t body, const string& filename)
+{
+    StackDelta d;
+    uint64_t base, removed, added;
+    Reader r{p, p + body};
+    if( !r.get(base) || !r.get(d.precisionBefore) || !r.get(d.precisionAfter) || !r.get(removed) || !r.get(added)
+        || !r.getElements(removed, d.removed) || !r.getElements(added, d.added)
+        || !r.getExact(removed, d.removedExact) || !r.getExact(added, d.addedExact) || !r.done() )
+        throw Exception{filename + " is damaged"};
+    d.base = base;
+
+    return d;
+}
+
+}
+
+SpilledHistory::SpilledHistory(const string& filename)
+: filename_{filename}
+, end_{0}
+, flushed_{0}
+, position_{0}
+, before_{0}
+, after_{0}
+, viewOffset_{0}
+{
+    file_ = PlatformFactory::Instance().createAppendFile(filename, true);
+}
+
+SpilledHistory::~SpilledHistory()
+{
+    view_.reset();
+    file_.reset();
+    std::remove( filename_.c_str() );
+}
+
+void SpilledHistory::append(const StackDelta& d)
+{
+    const size_t start{ pending_.size() };
+    put( pending_, uint64_t{0} );
+    put( pending_, static_cast<uint64_t>(d.base) );
+    put( pending_, d.precisionBefore );
+    put( pending_, d.precisionAfter );
+    put( pending_, static_cast<uint64_t>( d.removed.size() ) );
+    put( pending_, static_cast<uint64_t>( d.added.size() ) );
+    putElements(pending_, d.removed);
+    putElements(pending_, d.added);
+    putExact(pending_, d.removedExact);
+    putExact(pending_, d.addedExact);
+
+    const uint64_t body{ pending_.size() - start - sizeof(uint64_t) };
+    std::memcpy( &pending_[start], &body, sizeof(body) );
+    put(pending_, body);
+
+    end_ += pending_.size() - start;
+    position_ = end_;
+    ++before_;
+
+    if( pending_.size() >= WriteBytes ) flush();
+
+    return;
+}
+
+// a batch written only in part is cut off, so that it can be written again whole
+void SpilledHistory::flush()
+{
+    if( pending_.empty() ) return;
+
+    try
+    {
+        file_->write( pending_.data(), pending_.size() );
+    }
+    catch(Exception&)
+    {
+        file_->truncate(flushed_);
+        throw;
+    }
+
+    flushed_ += pending_.size();
+    pending_.clear();
+
+    return;
+}
+
+StackDelta SpilledHistory::previous()
+{
+    uint64_t body;
+    std::memcpy( &body, view(position_ - sizeof(body), sizeof(body), true), sizeof(body) );
+    if( body > position_ - 2 * sizeof(body) )
+        throw Exception{filename_ + " is damaged"};
+
+    const uint64_t start{ position_ - body - 2 * sizeof(body) };
+    StackDelta d{ decode( view(start + sizeof(body), body, true), body, filename_ ) };
+
+    position_ = start;
+    --before_;
+    ++after_;
+
+    return d;
+}
+
+StackDelta SpilledHistory::next()
+{
+    uint64_t body;
+    std::memcpy( &body, view(position_, sizeof(body), false), sizeof(body) );
+    if( body > end_ - position_ - 2 * sizeof(body) )
+        throw Exception{filename_ + " is damaged"};
+
+    StackDelta d{ decode( view(position_ + sizeof(body), body, false), body, filename_ ) };
+
+    position_ += body + 2 * sizeof(body);
+    ++before_;
+    --after_;
+
+    return d;
+}
+
+// the view is dropped first, since a mapping past the end of a file faults
+void SpilledHistory::truncate()
+{
+    if(after_ == 0) return;
+
+    flush();
+    view_.reset();
+    file_->truncate(position_);
+    flushed_ = position_;
+    end_ = position_;
+    after_ = 0;
+
+    return;
+}
+
+void SpilledHistory::clear()
+{
+    view_.reset();
+    pending_.clear();
+    file_->truncate(0);
+    end_ = 0;
+    flushed_ = 0;
+    position_ = 0;
+    before_ = 0;
+    after_ = 0;
+
+    return;
+}
+
+// undo walks back through the file and redo forward, so a new view extends in the
+// direction of travel
+const char* SpilledHistory::view(uint64_t offset, size_t n, bool backward)
+{
+    if( view_ && offset >= viewOffset_ && offset + n <= viewOffset_ + view_->size() )
+        return view_->data() + (offset - viewOffset_);
+
+    flush();
+
+    const uint64_t length{ std::min<uint64_t>( std::max(n, ViewBytes), end_ ) };
+    uint64_t start{ offset };
+    if(backward) start = offset + n > length ? offset + n - length : 0;
+    else if(start + length > end_) start = end_ - length;
+
+    view_.reset();
+    view_ = PlatformFactory::Instance().createMappedFile(filename_, start, length);
+    viewOffset_ = start;
+
+    return view_->data() + (offset - viewOffset_);
+}
+
+}
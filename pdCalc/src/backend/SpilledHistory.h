@@ -0,0 +1,113 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SPILLED_HISTORY_H
+#define SPILLED_HISTORY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pdCalc {
+
+class AppendFile;
+class MappedFile;
+struct StackDelta;
+
+// SpilledHistory holds the undo history a CommandManager has moved out of memory,
+// as StackDeltas in an append-only segment file. Records are only ever written at
+// the end of the file and are read back through a mapped view of a few megabytes
+// of it, so that neither the records nor the pages of the file stay resident
+// however long the history grows. The history has a position among its records,
+// which undoing moves back and redoing moves forward; truncate discards the
+// records after the position, as entering a command discards what could be
+// redone. The file is scratch space for one session and is removed on
+// destruction.
+//
+// Layout: records, each the length of its body (8 bytes), the body, and the
+// length again, so that the file can be walked in either direction. A body is the
+// delta's base (8), its precisions before and after (4 each), the counts of
+// removed and added elements (8 each) and the elements, then the exact values of
+// the removed and of the added elements, each as a count (8) and that many
+// entries of a position (8), a length (4) and the decimal text. Integers and
+// doubles are in the byte order of the machine.
+class SpilledHistory
+{
+public:
+    // creates filename, emptying it if it exists; throws Exception if it cannot
+    // be written
+    explicit SpilledHistory(const std::string& filename);
+    ~SpilledHistory();
+
+    // the records before and after the position
+    size_t before() const { return before_; }
+    size_t after() const { return after_; }
+
+    // writes d at the end, which must be the position, and moves past it. Records
+    // are written in batches; if a batch cannot be written, Exception is thrown,
+    // and its records, d included, are kept to be written with the next one.
+    void append(const StackDelta& d);
+
+    // read the record before (after) the position and move back (forward) over
+    // it; throw Exception if the file cannot be read, leaving the position alone
+    StackDelta previous();
+    StackDelta next();
+
+    // discards the records after the position; throws Exception if the file
+    // cannot be written
+    void truncate();
+
+    // discards every record
+    void clear();
+
+    // the bytes of the file, which stay on disk
+    uint64_t bytes() const { return end_; }
+
+private:
+    SpilledHistory(const SpilledHistory&) = delete;
+    SpilledHistory(SpilledHistory&&) = delete;
+    SpilledHistory& operator=(const SpilledHistory&) = delete;
+    SpilledHistory& operator=(SpilledHistory&&) = delete;
+
+    void flush();
+
+    // the n bytes of the file from offset, mapping a view around them, which
+    // extends before them if backward and after them otherwise
+    const char* view(uint64_t offset, size_t n, bool backward);
+
+    std::string filename_;
+    std::unique_ptr<AppendFile> file_;
+
+    // end_ counts the records not yet written, which follow the flushed_ bytes
+    // written
+    uint64_t end_;
+    uint64_t flushed_;
+    uint64_t position_;
+    size_t before_;
+    size_t after_;
+
+    std::unique_ptr<MappedFile> view_;
+    uint64_t viewOffset_;
+
+    // the records encoded but not yet written
+    std::string pending_;
+};
+
+}
+
+#endif
@@ -18,13 +18,116 @@
 
 #include "Stack.h"
 #include "utilities/Exception.h"
-#include <deque>
+#include "utilities/BigNumber.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
 
 using std::vector;
 using std::string;
+using std::shared_ptr;
 
 namespace pdCalc {
 
+namespace {
+
+// elements per chunk of a persistent stack, and so the most a version copies
+const size_t ChunkSize = 32;
+
+const size_t NoChange = std::numeric_limits<size_t>::max();
+
+bool anyExact(const vector<Stack::ExactValue>& exact, size_t first, size_t last)
+{
+    return std::any_of(exact.begin() + first, exact.begin() + last, [](const Stack::ExactValue& e){ return e != nullptr; });
+}
+
+}
+
+// a full chunk of a persistent stack, never changed once made, resting on the chunks
+// below it
+struct StackChunk
+{
+    shared_ptr<const StackChunk> below;
+    size_t base; // the position of values[0] in the stack
+    double values[ChunkSize];
+    vector<Stack::ExactValue> exact; // empty if the chunk has no exact values
+};
+
+class StackVersionData
+{
+public:
+    shared_ptr<const StackChunk> chunks; // the topmost full chunk
+    vector<double> tail; // the elements above the chunks, bottom first
+    vector<Stack::ExactValue> tailExact; // empty or parallel to tail
+    size_t size;
+    unsigned precision;
+
+    // the elements in chunks, which start at position 0
+    size_t chunked() const { return chunks ? chunks->base + ChunkSize : 0; }
+};
+
+StackVersion::StackVersion()
+{ }
+
+StackVersion::StackVersion(shared_ptr<const StackVersionData> data)
+: data_{ std::move(data) }
+{ }
+
+size_t StackVersion::size() const
+{
+    return data_ ? data_->size : 0;
+}
+
+unsigned StackVersion::precision() const
+{
+    return data_ ? data_->precision : 0;
+}
+
+vector<double> StackVersion::getElements(size_t n) const
+{
+    vector<double> v;
+    if(!data_) return v;
+
+    n = std::min(n, data_->size);
+    v.reserve(n);
+    for(auto i = data_->tail.rbegin(); i != data_->tail.rend() && v.size() < n; ++i)
+        v.push_back(*i);
+
+    for(const StackChunk* c = data_->chunks.get(); c && v.size() < n; c = c->below.get())
+    {
+        for(size_t i = ChunkSize; i > 0 && v.size() < n; --i)
+            v.push_back( c->values[i - 1] );
+    }
+
+    return v;
+}
+
+void StackVersion::copyElements(vector<double>& d, vector<Stack::ExactValue>& exact) const
+{
+    d.clear();
+    exact.clear();
+    if(!data_) return;
+
+    const size_t chunked{ data_->chunked() };
+    d.resize(data_->size);
+    bool hasExact{ !data_->tailExact.empty() };
+    for(const StackChunk* c = data_->chunks.get(); c; c = c->below.get())
+    {
+        std::copy(c->values, c->values + ChunkSize, d.begin() + c->base);
+        hasExact = hasExact || !c->exact.empty();
+    }
+    std::copy(data_->tail.begin(), data_->tail.end(), d.begin() + chunked);
+
+    if(!hasExact) return;
+
+    exact.resize(data_->size);
+    for(const StackChunk* c = data_->chunks.get(); c; c = c->below.get())
+        std::copy(c->exact.begin(), c->exact.end(), exact.begin() + c->base);
+    std::copy(data_->tailExact.begin(), data_->tailExact.end(), exact.begin() + chunked);
+
+    return;
+}
+
 const string Stack::StackChanged = "stackChanged";
 const string Stack::StackError = "error";
 
@@ -34,6 +137,7 @@ const char* StackEventData::Message(StackEventData::ErrorConditions ec)
     {
     case ErrorConditions::Empty: return "Attempting to pop empty stack";
     case ErrorConditions::TooFewArguments: return "Need at least two stack elements to swap top";
+    case ErrorConditions::TooFewElements: return "Attempting to pop more elements than are on the stack";
     default: return "Unknown error";
     };
 }
@@ -49,28 +153,143 @@ public:
     explicit StackImpl(const Stack&);
     void push(double d, bool suppressChangeEvent);
     double pop(bool suppressChangeEvent);
+    void push(double d, const ExactValue& exact, bool suppressChangeEvent);
+    double pop(ExactValue& exact, bool suppressChangeEvent);
+    vector<ExactValue> getExactElements(size_t n) const;
+    unsigned precision() const { return precision_; }
+    void setPrecision(unsigned digits);
+    void pushElements(const double* d, size_t n, bool suppressChangeEvent);
+    void popElements(size_t n, double* d, bool suppressChangeEvent);
+    void peekElements(size_t n, double* d) const;
     void swapTop();
     vector<double> getElements(size_t n) const;
     void getElements(size_t n, vector<double>& v) const;
+    const vector<double>& elements() const { return stack_; }
+    const vector<ExactValue>& exactElements() const { return exact_; }
+    void swapElements(vector<double>& d, vector<ExactValue>& exact, bool suppressChangeEvent);
+    void setPersistent(bool persistent);
+    bool persistent() const { return persistent_; }
+    shared_ptr<const StackVersionData> version();
+    shared_ptr<const StackVersionData> published() const { return std::atomic_load(&published_); }
+    void checkout(const shared_ptr<const StackVersionData>& v, bool suppressChangeEvent);
+    void beginDelta();
+    StackDelta endDelta();
+    void applyDelta(const StackDelta& d, bool forward, bool suppressChangeEvent);
+    uint64_t mark() { unchanged_ = stack_.size(); return ++marks_; }
+    size_t unchangedSince(uint64_t m) const { return m == marks_ ? unchanged_ : 0; }
     size_t size() const { return stack_.size(); }
     void clear();
     double top() const;
 
 private:
+    // records, before the elements from depth up change, that the stack has been
+    // down to depth since the last StackChanged and the last mark
+    void lowered(size_t depth)
+    {
+        low_ = std::min(low_, depth);
+        dirty_ = std::min(dirty_, depth);
+        unchanged_ = std::min(unchanged_, depth);
+        if(recording_ && depth < mark_) record(depth);
+    }
+
+    // saves the elements of a delta being recorded from depth up to the lowest the
+    // stack had been, which are still those from before the delta began
+    void record(size_t depth);
+
+    // brings the chunks of a persistent stack up to date with the elements
+    void seal();
+
+    // raises StackChanged for everything since the last one
+    void changed();
+
     const Stack& parent_; // for raising events
-    std::deque<double> stack_;
+
+    // the size at the last StackChanged, and the lowest the stack has been since;
+    // together they give the popped and pushed counts of the next change
+    size_t eventSize_;
+    size_t low_;
+    uint64_t generation_;
+
+    // the last mark, and the lowest the stack has been since
+    uint64_t marks_;
+    size_t unchanged_;
+
+    // reused when no observer has kept the last one, so that an event allocates nothing;
+    // held as the type raise takes, so that passing it converts, and counts, nothing
+    std::shared_ptr<EventData> event_;
+
+    // vector rather than deque: all access is at the top, and a deque releases and
+    // reacquires a block whenever the top crosses a block boundary
+    vector<double> stack_;
+
+    // exact values parallel to stack_, left empty until an element first carries one
+    // so that double mode pays nothing for them
+    vector<ExactValue> exact_;
+    unsigned precision_;
+
+    // a persistent stack's full chunks, mirroring its bottom elements, except that
+    // positions from dirty_ up have changed since they were made
+    bool persistent_;
+    shared_ptr<const StackChunk> chunks_;
+    size_t dirty_;
+
+    // read by other threads, and so only loaded and stored atomically
+    shared_ptr<const StackVersionData> published_;
+
+    // while a delta is recorded, the elements lost from mark_ up, top first
+    bool recording_;
+    size_t mark_;
+    unsigned precisionBefore_;
+    vector<double> recorded_;
+    vector<ExactValue> recordedExact_;
 };
 
 Stack::StackImpl::StackImpl(const Stack& s)
 : parent_(s)
+, eventSize_{0}
+, low_{0}
+, generation_{0}
+, marks_{0}
+, unchanged_{0}
+, precision_{0}
+, persistent_{false}
+, dirty_{NoChange}
+, recording_{false}
+, mark_{0}
+, precisionBefore_{0}
+{
+
+}
+
+void Stack::StackImpl::changed()
 {
+    if(persistent_) std::atomic_store( &published_, version() );
+
+    const StackChange change{eventSize_ - low_, stack_.size() - low_, stack_.size(), ++generation_};
+    if( event_ && event_.use_count() == 1 ) static_cast<StackChangedData&>(*event_) = StackChangedData{change};
+    else event_ = std::make_shared<StackChangedData>(change);
 
+    eventSize_ = low_ = stack_.size();
+    parent_.raise(Stack::StackChanged, event_);
+
+    return;
+}
+
+// exact values are shown only in exact mode, so turning it on or off changes how
+// every element reads, and the next event reports the whole stack as changed
+void Stack::StackImpl::setPrecision(unsigned digits)
+{
+    if( (digits == 0) != (precision_ == 0) ) low_ = 0;
+    precision_ = digits;
+
+    return;
 }
 
 void Stack::StackImpl::push(double d, bool suppressChangeEvent)
 {
     stack_.push_back(d);
-    if(!suppressChangeEvent) parent_.raise(Stack::StackChanged, nullptr);
+    if( !exact_.empty() ) exact_.emplace_back();
+    if(!suppressChangeEvent) changed();
 
     return;
 }
@@ -86,13 +305,78 @@ double Stack::StackImpl::pop(bool suppressChangeEvent)
     }
     else
     {
+        lowered( stack_.size() - 1 );
         auto val = stack_.back();
         stack_.pop_back();
-        if(!suppressChangeEvent) parent_.raise(Stack::StackChanged, nullptr);
+        if( !exact_.empty() ) exact_.pop_back();
+        if(!suppressChangeEvent) changed();
         return val;
     }
 }
 
+void Stack::StackImpl::push(double d, const ExactValue& exact, bool suppressChangeEvent)
+{
+    if( exact || !exact_.empty() )
+    {
+        exact_.resize( stack_.size() );
+        exact_.push_back(exact);
+    }
+    stack_.push_back(d);
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
+double Stack::StackImpl::pop(ExactValue& exact, bool suppressChangeEvent)
+{
+    exact = exact_.empty() || stack_.empty() ? nullptr : exact_.back();
+    return pop(suppressChangeEvent);
+}
+
+void Stack::StackImpl::pushElements(const double* d, size_t n, bool suppressChangeEvent)
+{
+    stack_.insert(stack_.end(), d, d + n);
+    if( !exact_.empty() ) exact_.resize( stack_.size() );
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
+void Stack::StackImpl::popElements(size_t n, double* d, bool suppressChangeEvent)
+{
+    if( n > stack_.size() )
+    {
+        parent_.raise(Stack::StackError,
+            std::make_shared<StackEventData>(StackEventData::ErrorConditions::TooFewElements));
+
+        throw Exception{StackEventData::Message(StackEventData::ErrorConditions::TooFewElements)};
+    }
+
+    lowered( stack_.size() - n );
+    auto first = stack_.end() - n;
+    std::copy(first, stack_.end(), d);
+    stack_.erase(first, stack_.end());
+    if( !exact_.empty() ) exact_.resize( stack_.size() );
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
+void Stack::StackImpl::peekElements(size_t n, double* d) const
+{
+    if( n > stack_.size() )
+    {
+        parent_.raise(Stack::StackError,
+            std::make_shared<StackEventData>(StackEventData::ErrorConditions::TooFewElements));
+
+        throw Exception{StackEventData::Message(StackEventData::ErrorConditions::TooFewElements)};
+    }
+
+    std::copy(stack_.end() - n, stack_.end(), d);
+
+    return;
+}
+
 void Stack::StackImpl::swapTop()
 {
     if( stack_.size() < 2 )
@@ -104,6 +388,7 @@ void Stack::StackImpl::swapTop()
     }
     else
     {
+        lowered( stack_.size() - 2 );
         auto first = stack_.back();
         stack_.pop_back();
         auto second = stack_.back();
@@ -111,12 +396,22 @@ void Stack::StackImpl::swapTop()
         stack_.push_back(first);
         stack_.push_back(second);
 
-        parent_.raise(Stack::StackChanged, nullptr);
+        if( !exact_.empty() ) std::swap( exact_.back(), exact_[exact_.size() - 2] );
+
+        changed();
     }
 
     return;
 }
 
+vector<Stack::ExactValue> Stack::StackImpl::getExactElements(size_t n) const
+{
+    if(n > stack_.size()) n = stack_.size();
+
+    if( exact_.empty() ) return vector<ExactValue>(n);
+    else return vector<ExactValue>(exact_.rbegin(), exact_.rbegin() + n);
+}
+
 vector<double> Stack::StackImpl::getElements(size_t n) const
 {
     vector<double> v;
@@ -134,11 +429,211 @@ void Stack::StackImpl::getElements(size_t n, vector<double>& v) const
     return;
 }
 
+void Stack::StackImpl::swapElements(vector<double>& d, vector<ExactValue>& exact, bool suppressChangeEvent)
+{
+    assert( exact.empty() || exact.size() == d.size() );
+
+    lowered(0);
+    stack_.swap(d);
+    exact_.swap(exact);
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
+// chunks that reach a changed position are dropped, and the full chunks above the
+// rest are made anew, so that each element is copied into a chunk once for every time
+// it is pushed
+void Stack::StackImpl::seal()
+{
+    while(chunks_ && chunks_->base + ChunkSize > dirty_)
+        chunks_ = chunks_->below;
+    dirty_ = NoChange;
+
+    size_t chunked{ chunks_ ? chunks_->base + ChunkSize : 0 };
+    while(chunked + ChunkSize <= stack_.size())
+    {
+        auto c = std::make_shared<StackChunk>();
+        c->below = std::move(chunks_);
+        c->base = chunked;
+        std::copy(stack_.begin() + chunked, stack_.begin() + chunked + ChunkSize, c->values);
+        if( !exact_.empty() && anyExact(exact_, chunked, chunked + ChunkSize) )
+            c->exact.assign(exact_.begin() + chunked, exact_.begin() + chunked + ChunkSize);
+
+        chunks_ = std::move(c);
+        chunked += ChunkSize;
+    }
+
+    return;
+}
+
+void Stack::StackImpl::setPersistent(bool persistent)
+{
+    persistent_ = persistent;
+    chunks_.reset();
+    dirty_ = NoChange;
+    std::atomic_store( &published_, persistent ? version() : shared_ptr<const StackVersionData>{} );
+
+    return;
+}
+
+// without chunks, a version is all tail
+shared_ptr<const StackVersionData> Stack::StackImpl::version()
+{
+    if(persistent_) seal();
+
+    auto v = std::make_shared<StackVersionData>();
+    v->chunks = chunks_;
+    const size_t chunked{ v->chunked() };
+    v->tail.assign(stack_.begin() + chunked, stack_.end());
+    if( !exact_.empty() && anyExact(exact_, chunked, exact_.size()) )
+        v->tailExact.assign(exact_.begin() + chunked, exact_.end());
+    v->size = stack_.size();
+    v->precision = precision_;
+
+    return v;
+}
+
+// the elements below the first chunk in which the stack and v differ are left alone
+void Stack::StackImpl::checkout(const shared_ptr<const StackVersionData>& v, bool suppressChangeEvent)
+{
+    if(persistent_) seal();
+
+    const StackChunk* mine{ chunks_.get() };
+    const StackChunk* theirs{ v ? v->chunks.get() : nullptr };
+    while(mine != theirs)
+    {
+        if( !theirs || (mine && mine->base > theirs->base) ) mine = mine->below.get();
+        else if( !mine || theirs->base > mine->base ) theirs = theirs->below.get();
+        else
+        {
+            mine = mine->below.get();
+            theirs = theirs->below.get();
+        }
+    }
+    const size_t common{ mine ? mine->base + ChunkSize : 0 };
+
+    // v's chunks above the common ones, bottom first
+    vector<const StackChunk*> above;
+    for(const StackChunk* c = v ? v->chunks.get() : nullptr; c && c->base >= common; c = c->below.get())
+        above.push_back(c);
+    std::reverse( above.begin(), above.end() );
+
+    bool hasExact{ !exact_.empty() || (v && !v->tailExact.empty()) };
+    for(auto c : above) hasExact = hasExact || !c->exact.empty();
+
+    lowered(common);
+    stack_.resize(common);
+    exact_.resize(hasExact ? common : 0);
+    for(auto c : above)
+    {
+        stack_.insert(stack_.end(), c->values, c->values + ChunkSize);
+        if(!hasExact) continue;
+
+        if( c->exact.empty() ) exact_.resize( stack_.size() );
+        else exact_.insert( exact_.end(), c->exact.begin(), c->exact.end() );
+    }
+
+    if(v)
+    {
+        stack_.insert( stack_.end(), v->tail.begin(), v->tail.end() );
+        if(hasExact)
+        {
+            if( v->tailExact.empty() ) exact_.resize( stack_.size() );
+            else exact_.insert( exact_.end(), v->tailExact.begin(), v->tailExact.end() );
+        }
+    }
+
+    precision_ = v ? v->precision : 0;
+    if(persistent_)
+    {
+        chunks_ = v ? v->chunks : nullptr;
+        dirty_ = NoChange;
+    }
+
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
+void Stack::StackImpl::record(size_t depth)
+{
+    if( !exact_.empty() ) recordedExact_.resize( recorded_.size() );
+    for(size_t i = mark_; i > depth; --i)
+    {
+        recorded_.push_back( stack_[i - 1] );
+        if( !exact_.empty() ) recordedExact_.push_back( exact_[i - 1] );
+    }
+    mark_ = depth;
+
+    return;
+}
+
+void Stack::StackImpl::beginDelta()
+{
+    recording_ = true;
+    mark_ = stack_.size();
+    precisionBefore_ = precision_;
+    recorded_.clear();
+    recordedExact_.clear();
+
+    return;
+}
+
+StackDelta Stack::StackImpl::endDelta()
+{
+    recording_ = false;
+
+    StackDelta d;
+    d.base = mark_;
+    d.removed.assign( recorded_.rbegin(), recorded_.rend() );
+    if( !recordedExact_.empty() )
+    {
+        recordedExact_.resize( recorded_.size() );
+        if( std::any_of(recordedExact_.begin(), recordedExact_.end(), [](const ExactValue& e){ return e != nullptr; }) )
+            d.removedExact.assign( recordedExact_.rbegin(), recordedExact_.rend() );
+    }
+    d.added.assign( stack_.begin() + mark_, stack_.end() );
+    if( !exact_.empty() && anyExact(exact_, mark_, exact_.size()) )
+        d.addedExact.assign( exact_.begin() + mark_, exact_.end() );
+    d.precisionBefore = precisionBefore_;
+    d.precisionAfter = precision_;
+
+    vector<double>{}.swap(recorded_);
+    vector<ExactValue>{}.swap(recordedExact_);
+
+    return d;
+}
+
+void Stack::StackImpl::applyDelta(const StackDelta& d, bool forward, bool suppressChangeEvent)
+{
+    const vector<double>& values = forward ? d.added : d.removed;
+    const vector<ExactValue>& exact = forward ? d.addedExact : d.removedExact;
+    assert( d.base <= stack_.size() );
+
+    lowered(d.base);
+    stack_.resize(d.base);
+    stack_.insert( stack_.end(), values.begin(), values.end() );
+    if( !exact_.empty() || !exact.empty() )
+    {
+        exact_.resize(d.base);
+        if( exact.empty() ) exact_.resize( stack_.size() );
+        else exact_.insert( exact_.end(), exact.begin(), exact.end() );
+    }
+    precision_ = forward ? d.precisionAfter : d.precisionBefore;
+
+    if(!suppressChangeEvent) changed();
+
+    return;
+}
+
 void Stack::StackImpl::clear()
 {
+    lowered(0);
     stack_.clear();
+    exact_.clear();
 
-    parent_.raise(Stack::StackChanged, nullptr);
+    changed();
 
     return;
 }
@@ -165,6 +660,51 @@ double Stack::pop(bool suppressChangeEvent)
     return pimpl_->pop(suppressChangeEvent);
 }
 
+void Stack::push(double d, const ExactValue& exact, bool suppressChangeEvent)
+{
+    pimpl_->push(d, exact, suppressChangeEvent);
+    return;
+}
+
+double Stack::pop(ExactValue& exact, bool suppressChangeEvent)
+{
+    return pimpl_->pop(exact, suppressChangeEvent);
+}
+
+vector<Stack::ExactValue> Stack::getExactElements(size_t n) const
+{
+    return pimpl_->getExactElements(n);
+}
+
+unsigned Stack::precision() const
+{
+    return pimpl_->precision();
+}
+
+void Stack::setPrecision(unsigned digits)
+{
+    pimpl_->setPrecision(digits);
+    return;
+}
+
+void Stack::pushElements(const double* d, size_t n, bool suppressChangeEvent)
+{
+    pimpl_->pushElements(d, n, suppressChangeEvent);
+    return;
+}
+
+void Stack::popElements(size_t n, double* d, bool suppressChangeEvent)
+{
+    pimpl_->popElements(n, d, suppressChangeEvent);
+    return;
+}
+
+void Stack::peekElements(size_t n, double* d) const
+{
+    pimpl_->peekElements(n, d);
+    return;
+}
+
 void Stack::swapTop()
 {
     pimpl_->swapTop();
@@ -182,6 +722,76 @@ void Stack::getElements(size_t n, vector<double>& v) const
     return;
 }
 
+const vector<double>& Stack::elements() const
+{
+    return pimpl_->elements();
+}
+
+const vector<Stack::ExactValue>& Stack::exactElements() const
+{
+    return pimpl_->exactElements();
+}
+
+void Stack::swapElements(vector<double>& d, vector<ExactValue>& exact, bool suppressChangeEvent)
+{
+    pimpl_->swapElements(d, exact, suppressChangeEvent);
+    return;
+}
+
+void Stack::setPersistent(bool persistent)
+{
+    pimpl_->setPersistent(persistent);
+    return;
+}
+
+bool Stack::persistent() const
+{
+    return pimpl_->persistent();
+}
+
+StackVersion Stack::version() const
+{
+    return StackVersion{ pimpl_->version() };
+}
+
+StackVersion Stack::published() const
+{
+    return StackVersion{ pimpl_->published() };
+}
+
+void Stack::checkout(const StackVersion& v, bool suppressChangeEvent)
+{
+    pimpl_->checkout(v.data_, suppressChangeEvent);
+    return;
+}
+
+void Stack::beginDelta()
+{
+    pimpl_->beginDelta();
+    return;
+}
+
+StackDelta Stack::endDelta()
+{
+    return pimpl_->endDelta();
+}
+
+void Stack::applyDelta(const StackDelta& d, bool forward, bool suppressChangeEvent)
+{
+    pimpl_->applyDelta(d, forward, suppressChangeEvent);
+    return;
+}
+
+uint64_t Stack::mark()
+{
+    return pimpl_->mark();
+}
+
+size_t Stack::unchangedSince(uint64_t m) const
+{
+    return pimpl_->unchangedSince(m);
+}
+
 size_t Stack::size() const
 {
     return pimpl_->size();
@@ -20,16 +20,20 @@
 #define STACK_H
 
 #include "../utilities/Publisher.h"
+#include "../utilities/StackChange.h"
 #include <vector>
 #include <memory>
 #include <string>
 
 namespace pdCalc {
 
+class BigFloat;
+class StackVersionData;
+
 class StackEventData : public EventData
 {
 public:
-    enum class ErrorConditions { Empty, TooFewArguments };
+    enum class ErrorConditions { Empty, TooFewArguments, TooFewElements };
     explicit StackEventData(ErrorConditions e) : err_(e) { }
 
     static const char* Message(ErrorConditions ec);
@@ -40,6 +44,60 @@ private:
     ErrorConditions err_;
 };
 
+// the data of a StackChanged event
+class StackChangedData : public EventData
+{
+public:
+    explicit StackChangedData(const StackChange& c) : change_(c) { }
+
+    const StackChange& change() const { return change_; }
+
+private:
+    StackChange change_;
+};
+
+// An immutable copy of the whole stack at one moment (see Stack::version). A version
+// is a handle: copies share one set of elements, and versions share with each other,
+// and with a persistent stack, the chunks of elements they have in common, so that
+// holding many versions costs little more than the elements in which they differ.
+// Versions may be read from any thread.
+class StackVersion
+{
+public:
+    StackVersion();
+
+    size_t size() const;
+    unsigned precision() const;
+
+    // as Stack::getElements
+    std::vector<double> getElements(size_t n) const;
+
+    // the whole stack, bottom first, and its exact values, as Stack::elements and
+    // Stack::exactElements
+    void copyElements(std::vector<double>& d, std::vector<std::shared_ptr<const BigFloat>>& exact) const;
+
+private:
+    friend class Stack;
+    explicit StackVersion(std::shared_ptr<const StackVersionData> data);
+
+    std::shared_ptr<const StackVersionData> data_;
+};
+
+// What a stack lost and gained between Stack::beginDelta and Stack::endDelta: the
+// first base elements were left alone, and the removed elements above them were
+// replaced by the added ones, both bottom first. The exact values are each either
+// empty or parallel to their elements.
+struct StackDelta
+{
+    size_t base = 0;
+    std::vector<double> removed;
+    std::vector<double> added;
+    std::vector<std::shared_ptr<const BigFloat>> removedExact;
+    std::vector<std::shared_ptr<const BigFloat>> addedExact;
+    unsigned precisionBefore = 0;
+    unsigned precisionAfter = 0;
+};
+
 class Stack : private Publisher
 {
     class StackImpl; // so that the implementation can raise events
@@ -50,10 +108,91 @@ public:
     double pop(bool suppressChangeEvent = false);
     void swapTop();
 
+    // In exact mode (nonzero precision), an element may carry an exact decimal value
+    // alongside its double, which is then the nearest double to it. Everything that
+    // only knows doubles (plugins, the bulk calls below) keeps working on the doubles;
+    // an element without an exact value is exactly its double.
+    using ExactValue = std::shared_ptr<const BigFloat>;
+
+    // pushes d carrying exact, which may be null; d must be the nearest double to exact
+    void push(double d, const ExactValue& exact, bool suppressChangeEvent = false);
+
+    // pops the top element, returning its exact value (null if it has none) in exact
+    double pop(ExactValue& exact, bool suppressChangeEvent = false);
+
+    // exact values of the first min(n, stackSize) elements in the order of getElements
+    std::vector<ExactValue> getExactElements(size_t n) const;
+
+    // significant digits carried by exact arithmetic; 0 turns exact mode off, after
+    // which the exact values kept are not shown. Turning exact mode on or off raises
+    // no event, but the next one reports the whole stack as changed.
+    unsigned precision() const;
+    void setPrecision(unsigned digits);
+
+    // bulk versions of push and pop that raise at most one change event
+    // pushes n elements with d[n-1] becoming the top of the stack
+    void pushElements(const double* d, size_t n, bool suppressChangeEvent = false);
+
+    // pops n elements into d in stack order, bottom first: d[n-1] is the old top
+    void popElements(size_t n, double* d, bool suppressChangeEvent = false);
+
+    // copies the top n elements into d in the same order as popElements without
+    // removing them
+    void peekElements(size_t n, double* d) const;
+
     // returns first min(n, stackSize) elements of the stack with the top of stack at position 0
     std::vector<double> getElements(size_t n) const;
     void getElements(size_t n, std::vector<double>&) const;
 
+    // the whole stack, bottom first, and the exact values parallel to it, which are
+    // empty if no element carries one; valid until the stack next changes, for bulk
+    // readers, such as snapshots, that would otherwise copy the stack
+    const std::vector<double>& elements() const;
+    const std::vector<ExactValue>& exactElements() const;
+
+    // exchanges the contents of the stack, in constant time, for d and exact, which
+    // is either empty or parallel to d
+    void swapElements(std::vector<double>& d, std::vector<ExactValue>& exact, bool suppressChangeEvent = false);
+
+    // A persistent stack also keeps its elements as a chain of immutable chunks that
+    // versions share, which makes version() O(1) (it copies at most the partial chunk
+    // on top), and publishes a version at every StackChanged event for readers on
+    // other threads. Turning persistence off releases the chunks.
+    void setPersistent(bool persistent);
+    bool persistent() const;
+
+    // the stack as it is now, precision included; O(size) unless persistent
+    StackVersion version() const;
+
+    // The version published at the last StackChanged event, for readers on threads
+    // other than the one changing the stack, which never waits for them; empty unless
+    // persistent.
+    StackVersion published() const;
+
+    // Makes the stack v, raising one change event. A persistent stack copies only the
+    // chunks in which it and v differ, so moving between nearby versions costs their
+    // difference, not the size of the stack or the number of commands between them.
+    void checkout(const StackVersion& v, bool suppressChangeEvent = false);
+
+    // Between beginDelta and endDelta, the stack records the elements it loses, at a
+    // cost proportional to them, and endDelta returns the change as a StackDelta,
+    // which applyDelta can undo or redo without the commands that made it. Deltas do
+    // not nest.
+    void beginDelta();
+    StackDelta endDelta();
+
+    // applies d forward, from the stack before it to the stack after, or backward,
+    // raising one change event
+    void applyDelta(const StackDelta& d, bool forward, bool suppressChangeEvent = false);
+
+    // For a reader that keeps a copy of the stack, such as a plugin host's helper:
+    // mark marks the stack as it is, and unchangedSince(m) is the number of elements,
+    // from the bottom, the stack has kept as they were at m, so that the reader brings
+    // its copy up to date by replacing only those above. Only the last mark is
+    // followed; nothing is known to be unchanged since an earlier one.
+    uint64_t mark();
+    size_t unchangedSince(uint64_t m) const;
+
     using Publisher::attach;
     using Publisher::detach;
 
@@ -49,3 +49,24 @@ double StackSecondElement()
     vector<double> v = pdCalc::Stack::Instance().getElements(2);
     return v[1];
 }
+
+void StackPushElements(const double* d, size_t n, bool suppressChangeEvent)
+{
+    pdCalc::Stack::Instance().pushElements(d, n, suppressChangeEvent);
+
+    return;
+}
+
+void StackPopElements(size_t n, double* d, bool suppressChangeEvent)
+{
+    pdCalc::Stack::Instance().popElements(n, d, suppressChangeEvent);
+
+    return;
+}
+
+void StackPeekElements(size_t n, double* d)
+{
+    pdCalc::Stack::Instance().peekElements(n, d);
+
+    return;
+}
@@ -25,4 +25,10 @@ extern "C" size_t StackSize();
 extern "C" double StackFirstElement();
 extern "C" double StackSecondElement();
 
+// bulk transfers for plugins working on many elements at once; see Stack::pushElements
+// and Stack::popElements for the element order
+extern "C" void StackPushElements(const double* d, size_t n, bool suppressChangeEvent);
+extern "C" void StackPopElements(size_t n, double* d, bool suppressChangeEvent);
+extern "C" void StackPeekElements(size_t n, double* d);
+
 #endif
@@ -0,0 +1,336 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StackSnapshot.h"
+#include "Stack.h"
+#include "MappedFile.h"
+#include "AppendFile.h"
+#include "PlatformFactory.h"
+#include "utilities/Exception.h"
+#include "utilities/BigNumber.h"
+#include "utilities/ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::ostringstream;
+
+namespace pdCalc {
+
+namespace {
+
+const char Magic[8] = {'p', 'd', 'C', 'a', 'l', 'c', 'S', 'S'};
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t precision;
+    uint64_t nElements;
+    uint64_t nExact;
+    uint64_t exactBytes;
+    uint64_t elementsChecksum;
+    uint64_t exactChecksum;
+    uint64_t tag;
+};
+
+static_assert(sizeof(Header) == 64, "the snapshot header is 64 bytes");
+
+// The checksum hashes each block of the data on its own, so blocks can be hashed
+// concurrently, and then hashes the block hashes; it does not depend on how many
+// threads take part.
+const size_t ChecksumBlock = size_t{1} << 20;
+const size_t MinChunkBlocks = 8;
+
+const uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t load(const char* p)
+{
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 33)) * Prime2;
+    z = (z ^ (z >> 29)) * Prime1;
+    return z ^ (z >> 32);
+}
+
+// four independent lanes of multiply and rotate, so the multiplies overlap
+uint64_t hashBlock(const char* p, size_t n)
+{
+    uint64_t h[4] = {Prime1, Prime2, ~Prime1, ~Prime2};
+
+    size_t i{0};
+    for(; i + 32 <= n; i += 32)
+    {
+        for(int lane = 0; lane < 4; ++lane)
+            h[lane] = rotl( h[lane] ^ (load(p + i + 8 * lane) * Prime2), 31 ) * Prime1;
+    }
+
+    for(; i < n; i += 8)
+    {
+        uint64_t w{0};
+        std::memcpy( &w, p + i, std::min(size_t{8}, n - i) );
+        h[0] = rotl( h[0] ^ (w * Prime2), 31 ) * Prime1;
+    }
+
+    return mix( h[0] ^ rotl(h[1], 16) ^ rotl(h[2], 32) ^ rotl(h[3], 48) ^ n );
+}
+
+uint64_t checksum(const char* p, size_t n)
+{
+    const size_t nBlocks{ (n + ChecksumBlock - 1) / ChecksumBlock };
+    vector<uint64_t> hashes(nBlocks);
+    ThreadPool::Instance().parallelFor(nBlocks, MinChunkBlocks, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t b = begin; b < end; ++b)
+            hashes[b] = hashBlock( p + b * ChecksumBlock, std::min(ChecksumBlock, n - b * ChecksumBlock) );
+    });
+
+    return hashBlock( reinterpret_cast<const char*>( hashes.data() ), hashes.size() * sizeof(uint64_t) );
+}
+
+string exactSection(const vector<Stack::ExactValue>& exact, uint64_t& nExact)
+{
+    string section;
+    nExact = 0;
+    for(size_t i = 0; i < exact.size(); ++i)
+    {
+        if(!exact[i]) continue;
+
+        string s{ exact[i]->toString() };
+        uint64_t position{i};
+        uint32_t length( s.size() );
+        section.append( reinterpret_cast<const char*>(&position), sizeof(position) );
+        section.append( reinterpret_cast<const char*>(&length), sizeof(length) );
+        section += s;
+        ++nExact;
+    }
+
+    return section;
+}
+
+void readSnapshot(const string& filename, vector<double>& elements, vector<Stack::ExactValue>& exact,
+    unsigned& precision, uint64_t& tag)
+{
+    auto file = PlatformFactory::Instance().createMappedFile(filename);
+    const char* p{ file->data() };
+    const size_t size{ file->size() };
+
+    Header header;
+    if( size < sizeof(header) )
+        throw Exception{filename + " is not a stack snapshot"};
+
+    std::memcpy( &header, p, sizeof(header) );
+    if( std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 )
+        throw Exception{filename + " is not a stack snapshot"};
+
+    if(header.version != StackSnapshotVersion)
+    {
+        ostringstream oss;
+        oss << "Snapshot version " << header.version << " is not supported";
+        throw Exception{ oss.str() };
+    }
+
+    const size_t available{ size - sizeof(header) };
+    if( header.nElements > available / sizeof(double)
+        || header.exactBytes != available - header.nElements * sizeof(double) )
+    {
+        throw Exception{filename + " is truncated or damaged"};
+    }
+
+    const char* elementBytes{ p + sizeof(header) };
+    const char* exactBytes{ elementBytes + header.nElements * sizeof(double) };
+    if( checksum(elementBytes, header.nElements * sizeof(double)) != header.elementsChecksum
+        || checksum(exactBytes, header.exactBytes) != header.exactChecksum )
+    {
+        throw Exception{filename + " is damaged"};
+    }
+
+    const double* first{ reinterpret_cast<const double*>(elementBytes) };
+    vector<double> e( first, first + header.nElements );
+
+    vector<Stack::ExactValue> x;
+    const char* q{exactBytes};
+    const char* end{exactBytes + header.exactBytes};
+    uint64_t previous{0};
+    for(uint64_t k = 0; k < header.nExact; ++k)
+    {
+        uint64_t position;
+        uint32_t length;
+        if( static_cast<size_t>(end - q) < sizeof(position) + sizeof(length) )
+            throw Exception{filename + " is damaged"};
+        std::memcpy( &position, q, sizeof(position) );
+        std::memcpy( &length, q + sizeof(position), sizeof(length) );
+        q += sizeof(position) + sizeof(length);
+
+        if( position >= header.nElements || (k > 0 && position <= previous) || length > static_cast<size_t>(end - q) )
+            throw Exception{filename + " is damaged"};
+
+        string s{q, length};
+        q += length;
+        previous = position;
+
+        x.resize( header.nElements );
+        x[position] = std::make_shared<const BigFloat>( BigFloat::FromString( s, static_cast<unsigned>( s.size() ) ) );
+    }
+
+    if(q != end)
+        throw Exception{filename + " is damaged"};
+
+    elements.swap(e);
+    exact.swap(x);
+    precision = header.precision;
+    tag = header.tag;
+
+    return;
+}
+
+}
+
+void SaveStackSnapshot(const string& filename, uint64_t tag)
+{
+    const Stack& stack = Stack::Instance();
+    const vector<double>& elements = stack.elements();
+
+    Header header;
+    std::memcpy( header.magic, Magic, sizeof(Magic) );
+    header.version = StackSnapshotVersion;
+    header.precision = stack.precision();
+    header.nElements = elements.size();
+
+    string exact{ exactSection(stack.exactElements(), header.nExact) };
+    header.exactBytes = exact.size();
+
+    const char* elementBytes{ reinterpret_cast<const char*>( elements.data() ) };
+    header.elementsChecksum = checksum(elementBytes, elements.size() * sizeof(double));
+    header.exactChecksum = checksum(exact.data(), exact.size());
+    header.tag = tag;
+
+    // written beside the old snapshot and moved over it, so a failure part way
+    // leaves the old one whole; the contents reach the disk before the move, so a
+    // crash cannot leave a snapshot whose data was never written
+    const string temporary{ filename + ".tmp" };
+    try
+    {
+        auto file = PlatformFactory::Instance().createAppendFile(temporary, true);
+        file->write( reinterpret_cast<const char*>(&header), sizeof(header) );
+        file->write( elementBytes, elements.size() * sizeof(double) );
+        file->write( exact.data(), exact.size() );
+        file->sync();
+    }
+    catch(Exception&)
+    {
+        std::remove( temporary.c_str() );
+        throw Exception{"Could not write " + filename};
+    }
+
+    // rename does not replace an existing file on every platform
+    if( std::rename(temporary.c_str(), filename.c_str()) != 0 )
+    {
+        std::remove( filename.c_str() );
+        if( std::rename(temporary.c_str(), filename.c_str()) != 0 )
+        {
+            std::remove( temporary.c_str() );
+            throw Exception{"Could not write " + filename};
+        }
+    }
+
+    return;
+}
+
+uint64_t RestoreStackSnapshot(const string& filename)
+{
+    vector<double> elements;
+    vector<Stack::ExactValue> exact;
+    unsigned precision;
+    uint64_t tag;
+    readSnapshot(filename, elements, exact, precision, tag);
+
+    Stack& stack = Stack::Instance();
+    stack.setPrecision(precision);
+    stack.swapElements(elements, exact);
+
+    return tag;
+}
+
+LoadSnapshot::LoadSnapshot(const string& filename)
+: filename_{filename}
+, precision_{0}
+{ }
+
+LoadSnapshot::~LoadSnapshot()
+{ }
+
+// the snapshot is read, once, as the precondition, so that a bad file leaves the
+// stack alone
+void LoadSnapshot::checkPreconditionsImpl() const
+{
+    if(!read_)
+    {
+        uint64_t tag;
+        readSnapshot(filename_, elements_, exact_, precision_, tag);
+        read_ = true;
+    }
+
+    return;
+}
+
+// execution and undo exchange the stack and the held contents
+void LoadSnapshot::executeImpl() noexcept
+{
+    Stack& stack = Stack::Instance();
+    unsigned precision{ stack.precision() };
+    stack.setPrecision(precision_);
+    precision_ = precision;
+    stack.swapElements(elements_, exact_);
+
+    return;
+}
+
+void LoadSnapshot::undoImpl() noexcept
+{
+    executeImpl();
+
+    return;
+}
+
+Command* LoadSnapshot::cloneImpl() const noexcept
+{
+    return 0;
+}
+
+const char* LoadSnapshot::helpMessageImpl() const noexcept
+{
+    return "Replaces the stack with a snapshot written by save:";
+}
+
+}
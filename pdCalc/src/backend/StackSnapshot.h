@@ -0,0 +1,90 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STACK_SNAPSHOT_H
+#define STACK_SNAPSHOT_H
+
+#include "Command.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace pdCalc {
+
+// A snapshot is a binary copy of the stack, its elements, the exact values they
+// carry, and the precision, which reloads without passing text through the
+// dispatcher. Snapshots are read through a memory mapping, checked, and copied onto
+// the stack in bulk. Numbers are stored in the byte order of the machine that wrote
+// them, so a snapshot from a machine of the other order fails its checks. The undo
+// history is not part of a snapshot.
+//
+// Layout, all integers unsigned:
+//     64 byte header: "pdCalcSS", version (4 bytes), precision (4), element
+//         count (8), exact value count (8), exact section size (8), checksum of
+//         the elements (8), checksum of the exact section (8), tag (8)
+//     the elements as doubles, bottom of the stack first
+//     the exact section: for each element carrying an exact value, bottom first,
+//         its position (8), the length of its decimal string (4), and the string
+
+const unsigned StackSnapshotVersion = 1;
+
+// writes the stack to filename, replacing any file there only once the snapshot is
+// complete; the tag is kept for the caller, such as the generation of a journal
+// that continues from the snapshot; throws Exception if the file cannot be written
+void SaveStackSnapshot(const std::string& filename, uint64_t tag = 0);
+
+// replaces the stack and its precision with those of the snapshot in filename and
+// returns its tag; throws Exception, leaving the stack alone, if the file is not a
+// valid snapshot of a supported version
+uint64_t RestoreStackSnapshot(const std::string& filename);
+
+// the command form of RestoreStackSnapshot, which keeps the contents it replaced so
+// that undo can put them back
+// precondition: filename is a valid snapshot of a supported version
+class LoadSnapshot : public Command
+{
+public:
+    explicit LoadSnapshot(const std::string& filename);
+    ~LoadSnapshot();
+
+private:
+    LoadSnapshot() = delete;
+    LoadSnapshot(LoadSnapshot&&) = delete;
+    LoadSnapshot& operator=(const LoadSnapshot&) = delete;
+    LoadSnapshot& operator=(LoadSnapshot&&) = delete;
+    LoadSnapshot(const LoadSnapshot&) = delete;
+
+    void checkPreconditionsImpl() const override;
+    void executeImpl() noexcept override;
+    void undoImpl() noexcept override;
+    Command* cloneImpl() const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
+
+    std::string filename_;
+
+    // the snapshot before execution and the replaced stack after it
+    mutable std::vector<double> elements_;
+    mutable std::vector<std::shared_ptr<const BigFloat>> exact_;
+    mutable unsigned precision_;
+    mutable bool read_ = false;
+};
+
+}
+
+#endif
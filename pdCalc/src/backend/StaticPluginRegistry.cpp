@@ -0,0 +1,171 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StaticPluginRegistry.h"
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "Plugin.h"
+
+using std::string;
+using std::unordered_map;
+using std::pair;
+using std::mutex;
+using std::lock_guard;
+using std::unique_ptr;
+
+namespace pdCalc {
+
+class StaticPluginRegistry::StaticPluginRegistryImpl
+{
+public:
+    void registerPlugin(const string& name, PluginAllocator, PluginDeallocator);
+    void deregisterPlugin(const string& name);
+    bool hasPlugin(const string& filename) const;
+
+    // the functions of the plugin in filename; false if it is not registered
+    bool find(const string& filename, PluginAllocator&, PluginDeallocator&) const;
+
+private:
+    unordered_map<string, pair<PluginAllocator, PluginDeallocator>> plugins_;
+    mutable mutex mutex_;
+};
+
+// Allocates registered plugins, remembering the deallocator of the one allocated.
+class StaticPluginRegistry::StaticLoader : public DynamicLoader
+{
+public:
+    explicit StaticLoader(const StaticPluginRegistryImpl& registry);
+
+    Plugin* allocatePlugin(const string& pluginName) override;
+    void deallocatePlugin(Plugin*) override;
+
+private:
+    const StaticPluginRegistryImpl& registry_;
+    PluginDeallocator deallocator_;
+};
+
+void StaticPluginRegistry::StaticPluginRegistryImpl::registerPlugin(const string& name, PluginAllocator alloc,
+    PluginDeallocator dealloc)
+{
+    lock_guard<mutex> lock{mutex_};
+    plugins_[name] = std::make_pair(alloc, dealloc);
+
+    return;
+}
+
+void StaticPluginRegistry::StaticPluginRegistryImpl::deregisterPlugin(const string& name)
+{
+    lock_guard<mutex> lock{mutex_};
+    plugins_.erase(name);
+
+    return;
+}
+
+bool StaticPluginRegistry::StaticPluginRegistryImpl::hasPlugin(const string& filename) const
+{
+    lock_guard<mutex> lock{mutex_};
+
+    return plugins_.find( PluginName(filename) ) != plugins_.end();
+}
+
+bool StaticPluginRegistry::StaticPluginRegistryImpl::find(const string& filename, PluginAllocator& alloc,
+    PluginDeallocator& dealloc) const
+{
+    lock_guard<mutex> lock{mutex_};
+    auto i = plugins_.find( PluginName(filename) );
+    if( i == plugins_.end() ) return false;
+
+    alloc = i->second.first;
+    dealloc = i->second.second;
+
+    return true;
+}
+
+StaticPluginRegistry::StaticLoader::StaticLoader(const StaticPluginRegistryImpl& registry)
+: registry_(registry)
+, deallocator_{nullptr}
+{ }
+
+Plugin* StaticPluginRegistry::StaticLoader::allocatePlugin(const string& pluginName)
+{
+    PluginAllocator alloc;
+    if( !registry_.find(pluginName, alloc, deallocator_) ) return nullptr;
+
+    return static_cast<Plugin*>( alloc() );
+}
+
+void StaticPluginRegistry::StaticLoader::deallocatePlugin(Plugin* p)
+{
+    if(deallocator_) deallocator_(p);
+
+    return;
+}
+
+StaticPluginRegistry::StaticPluginRegistry()
+: pimpl_{ new StaticPluginRegistryImpl }
+{ }
+
+StaticPluginRegistry::~StaticPluginRegistry()
+{ }
+
+StaticPluginRegistry& StaticPluginRegistry::Instance()
+{
+    static StaticPluginRegistry instance;
+    return instance;
+}
+
+void StaticPluginRegistry::registerPlugin(const string& name, PluginAllocator alloc, PluginDeallocator dealloc)
+{
+    pimpl_->registerPlugin(name, alloc, dealloc);
+}
+
+void StaticPluginRegistry::deregisterPlugin(const string& name)
+{
+    pimpl_->deregisterPlugin(name);
+}
+
+bool StaticPluginRegistry::hasPlugin(const string& filename) const
+{
+    return pimpl_->hasPlugin(filename);
+}
+
+unique_ptr<DynamicLoader> StaticPluginRegistry::createDynamicLoader() const
+{
+    return std::make_unique<StaticLoader>(*pimpl_);
+}
+
+string StaticPluginRegistry::PluginName(const string& filename)
+{
+    const auto slash = filename.find_last_of("/\\");
+    string name = slash == string::npos ? filename : filename.substr(slash + 1);
+
+    const auto dot = name.find('.');
+    if(dot != string::npos) name.erase(dot);
+
+#ifdef WIN32
+    const auto version = name.find_last_not_of("0123456789");
+    if(version != string::npos) name.erase(version + 1);
+#else
+    if(name.compare(0, 3, "lib") == 0) name.erase(0, 3);
+#endif
+
+    return name;
+}
+
+}
@@ -0,0 +1,75 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATIC_PLUGIN_REGISTRY_H
+#define STATIC_PLUGIN_REGISTRY_H
+
+// The StaticPluginRegistry holds the plugins linked into pdCalc, rather than built
+// as libraries of their own. A linked plugin registers, before plugins are loaded,
+// under the name of the library it would otherwise be built as, e.g.,
+// hyperbolicLnPlugin. PluginLoader loads a plugin the plugin file names from here
+// when it was registered and from its library otherwise, so that the plugin file
+// selects the plugins either way. A linked plugin is part of pdCalc, so it is neither
+// reloaded when its library changes nor run in the plugin host.
+
+#include <memory>
+#include <string>
+#include "DynamicLoader.h"
+
+namespace pdCalc {
+
+class StaticPluginRegistry
+{
+    class StaticPluginRegistryImpl;
+    class StaticLoader;
+public:
+    static StaticPluginRegistry& Instance();
+
+    // registers a plugin under name, replacing any registered under the name before
+    void registerPlugin(const std::string& name, PluginAllocator, PluginDeallocator);
+
+    // deregisters the plugin registered under name, if any; mainly needed for testing
+    void deregisterPlugin(const std::string& name);
+
+    // returns true if the plugin in the library filename is registered
+    bool hasPlugin(const std::string& filename) const;
+
+    // a loader of the plugins registered, by their libraries' file names, whose
+    // allocatePlugin returns a nullptr for a plugin that is not
+    std::unique_ptr<DynamicLoader> createDynamicLoader() const;
+
+    // the name of the plugin in the library filename: the file's name without its
+    // directory, extension, and, on POSIX systems, its lib prefix or, on Windows, its
+    // version, e.g., hyperbolicLnPlugin for ../lib/libhyperbolicLnPlugin.so
+    static std::string PluginName(const std::string& filename);
+
+private:
+    StaticPluginRegistry();
+    ~StaticPluginRegistry();
+
+    StaticPluginRegistry(StaticPluginRegistry&) = delete;
+    StaticPluginRegistry(StaticPluginRegistry&&) = delete;
+    StaticPluginRegistry& operator=(StaticPluginRegistry&) = delete;
+    StaticPluginRegistry& operator=(StaticPluginRegistry&&) = delete;
+
+    std::unique_ptr<StaticPluginRegistryImpl> pimpl_;
+};
+
+}
+
+#endif
@@ -18,18 +18,26 @@
 
 #include "StoredProcedure.h"
 #include "CommandDispatcher.h"
+#include "ProcedureOptimizer.h"
+#include "Stack.h"
+#include "utilities/UserInterface.h"
 #include "utilities/Exception.h"
 #include "utilities/Tokenizer.h"
+#include "utilities/CancellationToken.h"
+#include <cmath>
 #include <fstream>
 
 using std::string;
+using std::vector;
 
 namespace pdCalc {
 
-StoredProcedure::StoredProcedure(UserInterface& ui, const string& filename)
-: filename_{filename}
+StoredProcedure::StoredProcedure(UserInterface& ui, const string& filename, CancellationToken* token)
+: ui_(ui)
+, token_{token}
+, filename_{filename}
 {
-    ce_ = std::make_unique<CommandDispatcher>(ui);
+    ce_ = token ? std::make_unique<CommandDispatcher>(ui, *token) : std::make_unique<CommandDispatcher>(ui);
 }
 
 StoredProcedure::~StoredProcedure()
@@ -39,17 +47,212 @@ void StoredProcedure::checkPreconditionsImpl() const
 {
     if(first_)
     {
-        try
+        program_ = Compile( optimize( Load(filename_) ) );
+    }
+
+    return;
+}
+
+Tokenizer::Tokens StoredProcedure::Load(const string& filename)
+{
+    std::unique_ptr<Tokenizer> tokenizer;
+    try
+    {
+        std::ifstream ifs{ filename.c_str() };
+        if(!ifs)
+            throw Exception{"Could not open procedure"};
+
+        tokenizer = std::make_unique<Tokenizer>(ifs);
+    }
+    catch(...)
+    {
+        throw Exception{"Could not open procedure"};
+    }
+
+    return Tokenizer::Tokens{ tokenizer->begin(), tokenizer->end() };
+}
+
+// the optimizer depends on the stack the procedure starts from; anything it cannot
+// handle leaves the procedure as written
+Tokenizer::Tokens StoredProcedure::optimize(const Tokenizer::Tokens& tokens) const
+{
+    report_.clear();
+
+    try
+    {
+        Stack& stack = Stack::Instance();
+        bool plain{ stack.precision() == 0 };
+        for(const auto& e : stack.getExactElements( stack.size() ))
+            plain = plain && !e;
+
+        ProcedureOptimizer optimizer{stack.size(), plain};
+        Tokenizer::Tokens optimized = optimizer.optimize(tokens);
+        report_ = optimizer.report();
+
+        return optimized;
+    }
+    catch(...)
+    {
+        report_.clear();
+    }
+
+    return tokens;
+}
+
+// resolves every control flow keyword to a jump; times, if, and else are left
+// pointing at their end, and end becomes a loop back or nothing
+StoredProcedure::Program StoredProcedure::Compile(const Tokenizer::Tokens& tokens)
+{
+    using Op = Instruction::Op;
+
+    Program program;
+    program.reserve( tokens.size() );
+
+    // the open constructs, innermost last
+    vector<size_t> open;
+
+    for(const auto& t : tokens)
+    {
+        if(t == "times")
         {
-            std::ifstream ifs{ filename_.c_str() };
-            if(!ifs)
-                throw Exception{"Could not open procedure"};
+            open.push_back( program.size() );
+            program.push_back( Instruction{Op::Times, 0, ""} );
+        }
+        else if(t == "if")
+        {
+            open.push_back( program.size() );
+            program.push_back( Instruction{Op::If, 0, ""} );
+        }
+        else if(t == "else")
+        {
+            if( open.empty() || program[open.back()].op != Op::If )
+                throw Exception{"Procedure has else without if"};
 
-            tokenizer_ = std::make_unique<Tokenizer>(ifs);
+            // the if jumps past this jump into the else body
+            program[open.back()].target = program.size() + 1;
+            open.back() = program.size();
+            program.push_back( Instruction{Op::Jump, 0, ""} );
         }
-        catch(...)
+        else if(t == "end")
         {
-            throw Exception{"Could not open procedure"};
+            if( open.empty() )
+                throw Exception{"Procedure has end without times or if"};
+
+            Instruction& construct = program[open.back()];
+            if(construct.op == Op::Times)
+            {
+                program.push_back( Instruction{Op::Loop, open.back() + 1, ""} );
+                construct.target = program.size();
+            }
+            else construct.target = program.size();
+
+            open.pop_back();
+        }
+        else program.push_back( Instruction{Op::Command, 0, t} );
+    }
+
+    if( !open.empty() )
+        throw Exception{"Procedure has times or if without end"};
+
+    return program;
+}
+
+// a command counts as a step where it is executed, and control flow counts here
+bool StoredProcedure::stopped(const Instruction& i) noexcept
+{
+    if(!token_) return false;
+
+    return i.op == Instruction::Op::Command ? token_->stopped() : !token_->step();
+}
+
+// runs the program once, counting the commands entered so that undo and redo can
+// replay them; a control flow error stops the procedure where it is, as does the
+// token, in which case whoever executes the procedure undoes it
+void StoredProcedure::run() noexcept
+{
+    using Op = Instruction::Op;
+
+    Stack& stack = Stack::Instance();
+
+    // iterations left in the open loops, innermost last
+    vector<unsigned long long> remaining;
+
+    size_t pc{0};
+    while( pc < program_.size() )
+    {
+        const Instruction& i = program_[pc];
+        if( stopped(i) ) return;
+
+        switch(i.op)
+        {
+        case Op::Command:
+            ce_->commandEntered(i.command);
+            ++nCommands_;
+            ++pc;
+            break;
+
+        case Op::Times:
+        {
+            if(stack.size() < 1)
+            {
+                ui_.postMessage("times: Stack must have one element");
+                return;
+            }
+
+            double count{ stack.getElements(1).front() };
+            if( !(count >= 0 && count <= 1e18 && std::floor(count) == count) )
+            {
+                ui_.postMessage("times: count must be a nonnegative integer");
+                return;
+            }
+
+            ce_->commandEntered("drop");
+            ++nCommands_;
+
+            if(count == 0)
+            {
+                pc = i.target;
+            }
+            else
+            {
+                remaining.push_back( static_cast<unsigned long long>(count) );
+                ++pc;
+            }
+            break;
+        }
+
+        case Op::Loop:
+            if(--remaining.back() > 0)
+            {
+                pc = i.target;
+            }
+            else
+            {
+                remaining.pop_back();
+                ++pc;
+            }
+            break;
+
+        case Op::If:
+        {
+            if(stack.size() < 1)
+            {
+                ui_.postMessage("if: Stack must have one element");
+                return;
+            }
+
+            double condition{ stack.getElements(1).front() };
+
+            ce_->commandEntered("drop");
+            ++nCommands_;
+
+            pc = condition != 0 ? pc + 1 : i.target;
+            break;
+        }
+
+        case Op::Jump:
+            pc = i.target;
+            break;
         }
     }
 
@@ -60,15 +263,12 @@ void StoredProcedure::executeImpl() noexcept
 {
     if(first_)
     {
-        for(auto c : *tokenizer_)
-        {
-            ce_->commandEntered(c);
-        }
+        run();
         first_ = false;
     }
     else
     {
-        for(unsigned int i = 0; i < tokenizer_->nTokens(); ++i)
+        for(size_t i = 0; i < nCommands_; ++i)
             ce_->commandEntered("redo");
     }
 
@@ -77,7 +277,7 @@ void StoredProcedure::executeImpl() noexcept
 
 void StoredProcedure::undoImpl() noexcept
 {
-    for(unsigned int i = 0; i < tokenizer_->nTokens(); ++i)
+    for(size_t i = 0; i < nCommands_; ++i)
         ce_->commandEntered("undo");
 
     return;
@@ -23,18 +23,55 @@
 #include "utilities/Tokenizer.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace pdCalc {
 
 class CommandDispatcher;
 class UserInterface;
+class CancellationToken;
 
+// A stored procedure is a file of commands entered in order. Besides commands, a
+// procedure may use these control flow constructs, which nest:
+//     times ... end            pops a nonnegative integer n and runs the body n times
+//     if ... end               pops x and runs the body if x is nonzero
+//     if ... else ... end      pops x and runs the first body if x is nonzero and
+//                              the second body otherwise
+// Calls to other procedures are commands like any other (proc:<file>). The file is
+// compiled once, on first execution, into commands and jumps, so a loop costs its
+// body's size and not its iteration count.
+//
+// Given a token, the procedure's commands and control flow are steps of the entry
+// that runs it, as are those of the procedures it calls. A procedure the token stops
+// ends before its next instruction, and the CommandManager executing it undoes what
+// it did.
 class StoredProcedure : public Command
 {
 public:
-    StoredProcedure(UserInterface& ui, const std::string& filename);
+    StoredProcedure(UserInterface& ui, const std::string& filename, CancellationToken* token = nullptr);
     ~StoredProcedure();
 
+    // what the optimizer did to the procedure on its first execution
+    const std::string& optimizationReport() const { return report_; }
+
+    // the commands of a procedure and the jumps of its control flow
+    struct Instruction
+    {
+        enum class Op { Command, Times, Loop, If, Jump };
+
+        Op op;
+        size_t target; // the instruction a jump may go to
+        std::string command;
+    };
+
+    using Program = std::vector<Instruction>;
+
+    // reads the tokens of a procedure file; throws if the file cannot be read
+    static Tokenizer::Tokens Load(const std::string& filename);
+
+    // throws if the control flow constructs do not nest
+    static Program Compile(const Tokenizer::Tokens&);
+
 private:
     StoredProcedure() = delete;
     StoredProcedure(StoredProcedure&&) = delete;
@@ -43,13 +80,20 @@ private:
     StoredProcedure(const StoredProcedure&) = delete;
 
     void checkPreconditionsImpl() const override;
+    Tokenizer::Tokens optimize(const Tokenizer::Tokens&) const;
+    void run() noexcept;
+    bool stopped(const Instruction&) noexcept;
     void executeImpl() noexcept override;
     void undoImpl() noexcept override;
     Command* cloneImpl() const noexcept override;
     const char* helpMessageImpl() const noexcept override;
 
-    mutable std::unique_ptr<Tokenizer> tokenizer_;
+    mutable Program program_;
+    mutable std::string report_;
+    UserInterface& ui_;
     std::unique_ptr<CommandDispatcher> ce_;
+    CancellationToken* token_;
+    size_t nCommands_ = 0;
     std::string filename_;
     bool first_ = true;
 };
@@ -0,0 +1,87 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "WindowsAppendFile.h"
+#include "utilities/Exception.h"
+
+using std::string;
+
+namespace pdCalc {
+
+WindowsAppendFile::WindowsAppendFile(const string& filename, bool truncate)
+: AppendFile{}
+, filename_{filename}
+, file_{INVALID_HANDLE_VALUE}
+{
+    // FILE_APPEND_DATA without FILE_WRITE_DATA makes every write an append; sharing
+    // writes lets truncate open the file again
+    file_ = CreateFileA(filename.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file_ == INVALID_HANDLE_VALUE)
+        throw Exception{"Could not open " + filename};
+}
+
+WindowsAppendFile::~WindowsAppendFile()
+{
+    CloseHandle(file_);
+}
+
+void WindowsAppendFile::write(const char* data, size_t n)
+{
+    while(n > 0)
+    {
+        DWORD written{0};
+        DWORD chunk{ n > 0x40000000 ? 0x40000000 : static_cast<DWORD>(n) };
+        if( !WriteFile(file_, data, chunk, &written, nullptr) )
+            throw Exception{"Could not write " + filename_};
+
+        data += written;
+        n -= written;
+    }
+
+    return;
+}
+
+void WindowsAppendFile::sync()
+{
+    if( !FlushFileBuffers(file_) )
+        throw Exception{"Could not write " + filename_};
+
+    return;
+}
+
+// a handle that only appends cannot set the end of the file, so a second handle
+// does, and appends then follow the new end
+void WindowsAppendFile::truncate(size_t size)
+{
+    HANDLE file{ CreateFileA(filename_.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    if(file == INVALID_HANDLE_VALUE)
+        throw Exception{"Could not write " + filename_};
+
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    const bool truncated{ SetFilePointerEx(file, end, nullptr, FILE_BEGIN) && SetEndOfFile(file) };
+    CloseHandle(file);
+    if(!truncated)
+        throw Exception{"Could not write " + filename_};
+
+    return;
+}
+
+}
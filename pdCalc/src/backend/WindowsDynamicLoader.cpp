@@ -61,6 +61,10 @@ Plugin* WindowsDynamicLoader::allocatePlugin(const std::string& pluginName)
         PluginAllocator allocator{ reinterpret_cast<PluginAllocator>(alloc) };
         if(allocator)
         {
+            char path[MAX_PATH];
+            const DWORD n{ GetModuleFileNameA(handle_, path, MAX_PATH) };
+            if(n > 0 && n < MAX_PATH) loadedFrom_.assign(path, n);
+
             auto p = static_cast<Plugin*>((*allocator)());
             return p;
         }
@@ -33,9 +33,11 @@ public:
 
     Plugin* allocatePlugin(const std::string& pluginName) override;
     void deallocatePlugin(Plugin* p) override;
+    std::string loadedFrom() const override { return loadedFrom_; }
 
 private:
     HINSTANCE handle_;
+    std::string loadedFrom_;
 };
 
 }
@@ -18,6 +18,10 @@
 
 #include "WindowsFactory.h"
 #include "WindowsDynamicLoader.h"
+#include "WindowsMappedFile.h"
+#include "WindowsAppendFile.h"
+#include "WindowsFileWatcher.h"
+#include "WindowsProcessChannel.h"
 
 namespace pdCalc {
 
@@ -29,5 +33,35 @@ std::unique_ptr<DynamicLoader> WindowsFactory::createDynamicLoader()
     return std::make_unique<WindowsDynamicLoader>();
 }
 
+std::unique_ptr<MappedFile> WindowsFactory::createMappedFile(const std::string& filename)
+{
+    return std::make_unique<WindowsMappedFile>(filename);
 }
 
+std::unique_ptr<MappedFile> WindowsFactory::createMappedFile(const std::string& filename, size_t offset, size_t length)
+{
+    return std::make_unique<WindowsMappedFile>(filename, offset, length);
+}
+
+std::unique_ptr<AppendFile> WindowsFactory::createAppendFile(const std::string& filename, bool truncate)
+{
+    return std::make_unique<WindowsAppendFile>(filename, truncate);
+}
+
+std::unique_ptr<FileWatcher> WindowsFactory::createFileWatcher(const std::vector<std::string>& filenames,
+    FileWatcher::Changed changed)
+{
+    return std::make_unique<WindowsFileWatcher>( filenames, std::move(changed) );
+}
+
+std::unique_ptr<ProcessChannel> WindowsFactory::createProcessChannel(const std::string& executable, size_t size)
+{
+    return std::make_unique<WindowsProcessChannel>(executable, size);
+}
+
+std::unique_ptr<ProcessChannel> WindowsFactory::openProcessChannel(const std::string& description)
+{
+    return std::make_unique<WindowsProcessChannel>(description);
+}
+
+}
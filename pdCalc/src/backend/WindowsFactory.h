@@ -30,6 +30,13 @@ public:
     WindowsFactory();
 
     std::unique_ptr<DynamicLoader> createDynamicLoader() override;
+    std::unique_ptr<MappedFile> createMappedFile(const std::string& filename) override;
+    std::unique_ptr<MappedFile> createMappedFile(const std::string& filename, size_t offset, size_t length) override;
+    std::unique_ptr<AppendFile> createAppendFile(const std::string& filename, bool truncate) override;
+    std::unique_ptr<FileWatcher> createFileWatcher(const std::vector<std::string>& filenames,
+        FileWatcher::Changed changed) override;
+    std::unique_ptr<ProcessChannel> createProcessChannel(const std::string& executable, size_t size) override;
+    std::unique_ptr<ProcessChannel> openProcessChannel(const std::string& description) override;
 };
 
 }
@@ -0,0 +1,123 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "WindowsFileWatcher.h"
+#include "utilities/Exception.h"
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// whether the file's size or last write time differ from those recorded, which
+// they are then updated to
+bool updated(const string& filename, ULARGE_INTEGER& size, FILETIME& written)
+{
+    WIN32_FILE_ATTRIBUTE_DATA a;
+    if( !GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &a) ) return false;
+
+    if( a.nFileSizeLow == size.LowPart && a.nFileSizeHigh == size.HighPart
+        && CompareFileTime(&a.ftLastWriteTime, &written) == 0 ) return false;
+
+    size.LowPart = a.nFileSizeLow;
+    size.HighPart = a.nFileSizeHigh;
+    written = a.ftLastWriteTime;
+
+    return true;
+}
+
+}
+
+WindowsFileWatcher::WindowsFileWatcher(const vector<string>& filenames, Changed changed)
+: FileWatcher{}
+, changed_{ std::move(changed) }
+{
+    notifications_.push_back( CreateEventA(nullptr, TRUE, FALSE, nullptr) );
+    if(!notifications_[0])
+        throw Exception{"Could not watch files"};
+
+    vector<string> directories;
+    for(const auto& f : filenames)
+    {
+        const auto slash = f.find_last_of("/\\");
+        const string directory{ slash == string::npos ? "." : f.substr(0, slash + 1) };
+
+        size_t d{0};
+        while(d < directories.size() && directories[d] != directory) ++d;
+        if( d == directories.size() )
+        {
+            HANDLE h{ FindFirstChangeNotificationA( directory.c_str(), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE ) };
+            if(h == INVALID_HANDLE_VALUE || notifications_.size() == MAXIMUM_WAIT_OBJECTS)
+            {
+                if(h != INVALID_HANDLE_VALUE) FindCloseChangeNotification(h);
+                close();
+                throw Exception{"Could not watch " + f};
+            }
+
+            directories.push_back(directory);
+            notifications_.push_back(h);
+        }
+
+        Watched w{ f, d + 1, {}, {} };
+        updated(w.filename, w.size, w.written);
+        files_.push_back( std::move(w) );
+    }
+
+    thread_ = std::thread{ [this]{ run(); } };
+}
+
+WindowsFileWatcher::~WindowsFileWatcher()
+{
+    SetEvent(notifications_[0]);
+    thread_.join();
+
+    close();
+}
+
+void WindowsFileWatcher::close()
+{
+    for(size_t i = 1; i < notifications_.size(); ++i)
+        FindCloseChangeNotification(notifications_[i]);
+    CloseHandle(notifications_[0]);
+
+    return;
+}
+
+// the thread waits on the directories' notifications until the stop event is set
+void WindowsFileWatcher::run()
+{
+    while(true)
+    {
+        DWORD signalled{ WaitForMultipleObjects( static_cast<DWORD>( notifications_.size() ),
+            notifications_.data(), FALSE, INFINITE ) };
+        if(signalled == WAIT_OBJECT_0 || signalled == WAIT_FAILED) return;
+
+        const size_t d{ signalled - WAIT_OBJECT_0 };
+        if( d >= notifications_.size() ) return;
+
+        for(auto& w : files_)
+            if( w.directory == d && updated(w.filename, w.size, w.written) ) changed_(w.filename);
+
+        if( !FindNextChangeNotification(notifications_[d]) ) return;
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WINDOWS_FILE_WATCHER_H
+#define WINDOWS_FILE_WATCHER_H
+
+#include <windows.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileWatcher.h"
+
+namespace pdCalc {
+
+class WindowsFileWatcher : public FileWatcher
+{
+public:
+    // starts watching filenames, calling changed with each that changes; throws
+    // Exception if they cannot be watched
+    WindowsFileWatcher(const std::vector<std::string>& filenames, Changed changed);
+    ~WindowsFileWatcher();
+
+private:
+    WindowsFileWatcher(const WindowsFileWatcher&) = delete;
+    WindowsFileWatcher(WindowsFileWatcher&&) = delete;
+    WindowsFileWatcher& operator=(const WindowsFileWatcher&) = delete;
+    WindowsFileWatcher& operator=(WindowsFileWatcher&&) = delete;
+
+    // A notification only says that something in a directory changed, so a file
+    // has changed when its size or last write time has.
+    struct Watched
+    {
+        std::string filename;
+        size_t directory; // its index in notifications_
+        ULARGE_INTEGER size;
+        FILETIME written;
+    };
+
+    void run();
+    void close();
+
+    Changed changed_;
+    std::vector<Watched> files_;
+    std::vector<HANDLE> notifications_; // the stop event first, then a handle per directory
+    std::thread thread_;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "WindowsMappedFile.h"
+#include "utilities/Exception.h"
+
+using std::string;
+
+namespace pdCalc {
+
+WindowsMappedFile::WindowsMappedFile(const string& filename)
+: MappedFile{}
+, file_{INVALID_HANDLE_VALUE}
+, mapping_{nullptr}
+, data_{nullptr}
+, size_{0}
+, view_{nullptr}
+{
+    map(filename, true, 0, 0);
+}
+
+WindowsMappedFile::WindowsMappedFile(const string& filename, size_t offset, size_t length)
+: MappedFile{}
+, file_{INVALID_HANDLE_VALUE}
+, mapping_{nullptr}
+, data_{nullptr}
+, size_{0}
+, view_{nullptr}
+{
+    map(filename, false, offset, length);
+}
+
+WindowsMappedFile::~WindowsMappedFile()
+{
+    if(view_) UnmapViewOfFile(view_);
+    if(mapping_) CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+
+// a view must start on an allocation granularity boundary, so a range maps from the
+// boundary before its first byte; sharing writes lets a file still being appended
+// to be mapped
+void WindowsMappedFile::map(const string& filename, bool whole, size_t offset, size_t length)
+{
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | (whole ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS), nullptr);
+    if(file_ == INVALID_HANDLE_VALUE)
+        throw Exception{"Could not open " + filename};
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx(file_, &size) )
+    {
+        CloseHandle(file_);
+        throw Exception{"Could not read " + filename};
+    }
+
+    const size_t fileSize{ static_cast<size_t>(size.QuadPart) };
+    if(whole) length = fileSize;
+    else if(offset > fileSize || length > fileSize - offset)
+    {
+        CloseHandle(file_);
+        throw Exception{"Could not read " + filename};
+    }
+
+    size_ = length;
+    if(size_ > 0)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        const size_t start{ offset - offset % info.dwAllocationGranularity };
+        const unsigned long long first{ start };
+
+        mapping_ = CreateFileMapping(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* p{ mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, static_cast<DWORD>(first >> 32),
+            static_cast<DWORD>(first & 0xFFFFFFFF), size_ + (offset - start)) : nullptr };
+        if(!p)
+        {
+            if(mapping_) CloseHandle(mapping_);
+            CloseHandle(file_);
+            throw Exception{"Could not map " + filename};
+        }
+
+        view_ = p;
+        data_ = static_cast<const char*>(p) + (offset - start);
+    }
+
+    return;
+}
+
+}
@@ -0,0 +1,60 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WINDOWS_MAPPED_FILE_H
+#define WINDOWS_MAPPED_FILE_H
+
+#include <windows.h>
+#include <string>
+#include "MappedFile.h"
+
+namespace pdCalc {
+
+class WindowsMappedFile : public MappedFile
+{
+public:
+    // throws Exception if the file cannot be opened or mapped
+    explicit WindowsMappedFile(const std::string& filename);
+
+    // maps only length bytes from offset
+    WindowsMappedFile(const std::string& filename, size_t offset, size_t length);
+    ~WindowsMappedFile();
+
+    const char* data() const override { return data_; }
+    size_t size() const override { return size_; }
+
+private:
+    WindowsMappedFile(const WindowsMappedFile&) = delete;
+    WindowsMappedFile(WindowsMappedFile&&) = delete;
+    WindowsMappedFile& operator=(const WindowsMappedFile&) = delete;
+    WindowsMappedFile& operator=(WindowsMappedFile&&) = delete;
+
+    void map(const std::string& filename, bool whole, size_t offset, size_t length);
+
+    HANDLE file_;
+    HANDLE mapping_;
+    const char* data_;
+    size_t size_;
+
+    // the view mapped, which starts at or before data_
+    void* view_;
+};
+
+}
+
+#endif
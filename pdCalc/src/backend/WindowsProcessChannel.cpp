@@ -0,0 +1,184 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "WindowsProcessChannel.h"
+#include "utilities/Exception.h"
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::ostringstream;
+using std::istringstream;
+
+namespace pdCalc {
+
+namespace {
+
+// how long a helper whose channel has closed is given to exit before it is ended
+const DWORD ExitMilliseconds = 1000;
+
+uintptr_t value(HANDLE h)
+{
+    return reinterpret_cast<uintptr_t>(h);
+}
+
+}
+
+// The helper inherits the mapping, the doorbells, and a handle to this process,
+// whose values the description gives; the handles are inheritable only for as long
+// as it takes to start it.
+WindowsProcessChannel::WindowsProcessChannel(const string& executable, size_t size)
+: mapping_{nullptr}
+, memory_{nullptr}
+, size_{size}
+, doorbell_{nullptr}
+, peerDoorbell_{nullptr}
+, peer_{nullptr}
+, parent_{true}
+, helperId_{0}
+{
+    SECURITY_ATTRIBUTES inherited{ sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    const uint64_t size64{size};
+    mapping_ = CreateFileMappingA( INVALID_HANDLE_VALUE, &inherited, PAGE_READWRITE,
+        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr );
+    doorbell_ = CreateEventA(&inherited, FALSE, FALSE, nullptr);
+    peerDoorbell_ = CreateEventA(&inherited, FALSE, FALSE, nullptr);
+    HANDLE self{ OpenProcess(SYNCHRONIZE, TRUE, GetCurrentProcessId()) };
+    if(!mapping_ || !doorbell_ || !peerDoorbell_ || !self)
+    {
+        if(self) CloseHandle(self);
+        close();
+        throw Exception{"Could not create memory for " + executable};
+    }
+
+    try
+    {
+        map();
+    }
+    catch(Exception&)
+    {
+        CloseHandle(self);
+        close();
+        throw;
+    }
+
+    ostringstream oss;
+    oss << '"' << executable << "\" " << value(mapping_) << ',' << value(peerDoorbell_) << ','
+        << value(doorbell_) << ',' << value(self) << ',' << size;
+    const string s{ oss.str() };
+    vector<char> commandLine{ s.begin(), s.end() };
+    commandLine.push_back('\0');
+
+    STARTUPINFOA startup;
+    ZeroMemory( &startup, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process;
+    const BOOL started{ CreateProcessA(executable.c_str(), commandLine.data(), nullptr, nullptr, TRUE, 0,
+        nullptr, nullptr, &startup, &process) };
+    CloseHandle(self);
+
+    SetHandleInformation(mapping_, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(doorbell_, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(peerDoorbell_, HANDLE_FLAG_INHERIT, 0);
+    if(!started)
+    {
+        close();
+        throw Exception{"Could not start " + executable};
+    }
+
+    CloseHandle(process.hThread);
+    peer_ = process.hProcess;
+    helperId_ = static_cast<long>(process.dwProcessId);
+}
+
+WindowsProcessChannel::WindowsProcessChannel(const string& description)
+: mapping_{nullptr}
+, memory_{nullptr}
+, size_{0}
+, doorbell_{nullptr}
+, peerDoorbell_{nullptr}
+, peer_{nullptr}
+, parent_{false}
+, helperId_{0}
+{
+    uintptr_t handles[4];
+    char commas[4];
+    istringstream iss{description};
+    if( !(iss >> handles[0] >> commas[0] >> handles[1] >> commas[1] >> handles[2] >> commas[2]
+        >> handles[3] >> commas[3] >> size_) )
+        throw Exception{"Not a channel: " + description};
+
+    mapping_ = reinterpret_cast<HANDLE>(handles[0]);
+    doorbell_ = reinterpret_cast<HANDLE>(handles[1]);
+    peerDoorbell_ = reinterpret_cast<HANDLE>(handles[2]);
+    peer_ = reinterpret_cast<HANDLE>(handles[3]);
+    map();
+}
+
+WindowsProcessChannel::~WindowsProcessChannel()
+{
+    if(memory_) UnmapViewOfFile(memory_);
+    memory_ = nullptr;
+
+    if( parent_ && peer_ && WaitForSingleObject(peer_, ExitMilliseconds) != WAIT_OBJECT_0 )
+        TerminateProcess(peer_, 1);
+
+    close();
+}
+
+void WindowsProcessChannel::map()
+{
+    memory_ = static_cast<char*>( MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size_) );
+    if(!memory_)
+        throw Exception{"Could not map the memory of a channel"};
+
+    return;
+}
+
+void WindowsProcessChannel::close()
+{
+    if(mapping_) CloseHandle(mapping_);
+    if(doorbell_) CloseHandle(doorbell_);
+    if(peerDoorbell_) CloseHandle(peerDoorbell_);
+    if(peer_) CloseHandle(peer_);
+    mapping_ = doorbell_ = peerDoorbell_ = peer_ = nullptr;
+
+    return;
+}
+
+void WindowsProcessChannel::notify()
+{
+    SetEvent(peerDoorbell_);
+
+    return;
+}
+
+bool WindowsProcessChannel::wait(int milliseconds)
+{
+    HANDLE handles[] = { peer_, doorbell_ };
+    switch( WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(milliseconds)) )
+    {
+    case WAIT_OBJECT_0 + 1: return true;
+    case WAIT_TIMEOUT: return false;
+    default: throw Exception{"The other side of the channel has gone"};
+    }
+}
+
+}
@@ -18,18 +18,41 @@ HEADERS += Stack.h \
     CommandRepository.h \
     CommandDispatcher.h \
     CoreCommands.h \
+    CoreOperations.h \
     StoredProcedure.h \
+    MapProcedure.h \
+    ProcedureOptimizer.h \
+    StackSnapshot.h \
+    Journal.h \
+    SpilledHistory.h \
+    ImportNumbers.h \
     PluginLoader.h \
     DynamicLoader.h \
+    MappedFile.h \
+    AppendFile.h \
+    FileWatcher.h \
+    ProcessChannel.h \
+    MessageChannel.h \
+    PluginHost.h \
+    StaticPluginRegistry.h \
     Plugin.h \
     PlatformFactory.h \
     StackPluginInterface.h \
-    AppObservers.h
+    AppObservers.h \
+    CommandWorker.h
 
 unix:HEADERS += PosixDynamicLoader.h \
+    PosixMappedFile.h \
+    PosixAppendFile.h \
+    PosixFileWatcher.h \
+    PosixProcessChannel.h \
     PosixFactory.h
 
 win32:HEADERS += WindowsDynamicLoader.h \
+                 WindowsMappedFile.h \
+                 WindowsAppendFile.h \
+                 WindowsFileWatcher.h \
+                 WindowsProcessChannel.h \
                  WindowsFactory.h
 
 SOURCES += Stack.cpp \
@@ -40,16 +63,39 @@ SOURCES += Stack.cpp \
     Command.cpp \
     CoreCommands.cpp \
     StoredProcedure.cpp \
+    MapProcedure.cpp \
+    ProcedureOptimizer.cpp \
+    StackSnapshot.cpp \
+    Journal.cpp \
+    SpilledHistory.cpp \
+    ImportNumbers.cpp \
     PluginLoader.cpp \
     DynamicLoader.cpp \
+    MappedFile.cpp \
+    AppendFile.cpp \
+    FileWatcher.cpp \
+    ProcessChannel.cpp \
+    MessageChannel.cpp \
+    PluginHost.cpp \
+    StaticPluginRegistry.cpp \
     PlatformFactory.cpp \
-    AppObservers.cpp
+    AppObservers.cpp \
+    CommandWorker.cpp
 
 unix:SOURCES += PosixDynamicLoader.cpp \
+                PosixMappedFile.cpp \
+                PosixAppendFile.cpp \
+                PosixFileWatcher.cpp \
+                PosixProcessChannel.cpp \
                 PosixFactory.cpp
 
 win32:SOURCES += WindowsDynamicLoader.cpp \
+                 WindowsMappedFile.cpp \
+                 WindowsAppendFile.cpp \
+                 WindowsFileWatcher.cpp \
+                 WindowsProcessChannel.cpp \
                  WindowsFactory.cpp
 
 unix:LIBS += -ldl
+linux:LIBS += -lrt
 win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1
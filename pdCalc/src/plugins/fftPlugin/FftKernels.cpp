@@ -0,0 +1,349 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "FftKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::vector;
+using std::shared_ptr;
+
+namespace FftKernels {
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+
+// beyond this many lengths the cache starts over rather than grow without bound
+const size_t MaxCachedPlans = 32;
+
+// kernels shorter than this are convolved directly
+const size_t DirectConvolutionLength = 32;
+
+bool isPowerOfTwo(size_t n)
+{
+    return (n & (n - 1)) == 0;
+}
+
+size_t nextPowerOfTwo(size_t n)
+{
+    size_t m{1};
+    while(m < n) m *= 2;
+    return m;
+}
+
+// Precomputed tables for one transform length. For a power of two, twiddles_
+// holds the twiddle factors of every radix 2 stage back to back (the stage that
+// combines blocks of 2 * half starts at offset half - 1), so each stage reads them
+// contiguously. Any other length n is computed as a circular convolution of
+// length m, a power of two, against the transformed chirp in filter_.
+class Plan
+{
+public:
+    explicit Plan(size_t n);
+
+    size_t size() const { return n_; }
+
+    void transform(Complex* x) const;
+
+private:
+    void radix2(Complex* x) const;
+    void bluestein(Complex* x) const;
+
+    size_t n_;
+
+    // radix 2
+    vector<size_t> bitReverse_;
+    vector<Complex> twiddles_;
+
+    // Bluestein
+    shared_ptr<const Plan> inner_;
+    vector<Complex> chirp_;
+    vector<Complex> filter_;
+};
+
+shared_ptr<const Plan> GetPlan(size_t n)
+{
+    static std::mutex mutex;
+    static std::map<size_t, shared_ptr<const Plan>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto i = cache.find(n);
+        if( i != cache.end() ) return i->second;
+    }
+
+    // built unlocked because a Bluestein plan asks for its inner plan; if two
+    // threads race, the first plan inserted wins
+    auto plan = std::make_shared<const Plan>(n);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if(cache.size() >= MaxCachedPlans) cache.clear();
+    return cache.emplace(n, plan).first->second;
+}
+
+// b = b * w, a = a + b, b = a - b for half consecutive pairs
+inline void butterflies(Complex* a, Complex* b, const Complex* w, size_t half)
+{
+#ifdef __SSE2__
+    double* pa{ reinterpret_cast<double*>(a) };
+    double* pb{ reinterpret_cast<double*>(b) };
+    const double* pw{ reinterpret_cast<const double*>(w) };
+
+    // negates the real lane of (ai wi, ar wi) so the sum below is the product
+    const __m128d sign = _mm_set_pd(0.0, -0.0);
+    for(size_t j = 0; j < 2 * half; j += 2)
+    {
+        __m128d u = _mm_loadu_pd(pa + j);
+        __m128d v = _mm_loadu_pd(pb + j);
+        __m128d t = _mm_loadu_pd(pw + j);
+        __m128d wr = _mm_unpacklo_pd(t, t);
+        __m128d wi = _mm_unpackhi_pd(t, t);
+        __m128d vs = _mm_shuffle_pd(v, v, 1);
+        __m128d vw = _mm_add_pd( _mm_mul_pd(v, wr), _mm_xor_pd(_mm_mul_pd(vs, wi), sign) );
+        _mm_storeu_pd(pa + j, _mm_add_pd(u, vw));
+        _mm_storeu_pd(pb + j, _mm_sub_pd(u, vw));
+    }
+#else
+    for(size_t j = 0; j < half; ++j)
+    {
+        Complex u{ a[j] };
+        Complex v{ b[j] * w[j] };
+        a[j] = u + v;
+        b[j] = u - v;
+    }
+#endif
+
+    return;
+}
+
+void conjugate(Complex* x, size_t n)
+{
+    for(size_t i = 0; i < n; ++i)
+        x[i] = std::conj(x[i]);
+
+    return;
+}
+
+Plan::Plan(size_t n)
+: n_{n}
+{
+    if( isPowerOfTwo(n) )
+    {
+        size_t bits{0};
+        while( (size_t{1} << bits) < n ) ++bits;
+
+        bitReverse_.resize(n);
+        for(size_t i = 0; i < n; ++i)
+        {
+            size_t r{0};
+            for(size_t b = 0; b < bits; ++b)
+                if( i & (size_t{1} << b) ) r |= size_t{1} << (bits - 1 - b);
+            bitReverse_[i] = r;
+        }
+
+        twiddles_.reserve(n > 1 ? n - 1 : 0);
+        for(size_t half = 1; half < n; half *= 2)
+            for(size_t j = 0; j < half; ++j)
+                twiddles_.push_back( std::polar(1.0, -Pi * j / half) );
+    }
+    else
+    {
+        size_t m{ nextPowerOfTwo(2 * n - 1) };
+        inner_ = GetPlan(m);
+
+        // exp(-i pi k^2 / n) with k^2 reduced modulo 2n to keep the angle exact
+        chirp_.resize(n);
+        for(size_t k = 0; k < n; ++k)
+        {
+            unsigned long long k2{ static_cast<unsigned long long>(k) * k % (2 * n) };
+            chirp_[k] = std::polar(1.0, -Pi * k2 / n);
+        }
+
+        // the conjugate chirp wrapped around for circular convolution, transformed
+        // and scaled for the unnormalized inverse transform in bluestein()
+        filter_.assign(m, Complex{0.0, 0.0});
+        filter_[0] = std::conj(chirp_[0]);
+        for(size_t k = 1; k < n; ++k)
+            filter_[k] = filter_[m - k] = std::conj(chirp_[k]);
+        inner_->transform( filter_.data() );
+        for(auto& f : filter_)
+            f /= static_cast<double>(m);
+    }
+}
+
+void Plan::transform(Complex* x) const
+{
+    if(n_ < 2) return;
+
+    if(inner_) bluestein(x);
+    else radix2(x);
+
+    return;
+}
+
+void Plan::radix2(Complex* x) const
+{
+    for(size_t i = 0; i < n_; ++i)
+    {
+        size_t j{ bitReverse_[i] };
+        if(i < j) std::swap(x[i], x[j]);
+    }
+
+    // the first stage's only twiddle is 1
+    for(size_t i = 0; i < n_; i += 2)
+    {
+        Complex u{ x[i] };
+        Complex v{ x[i + 1] };
+        x[i] = u + v;
+        x[i + 1] = u - v;
+    }
+
+    for(size_t half = 2; half < n_; half *= 2)
+    {
+        const Complex* w{ twiddles_.data() + half - 1 };
+        for(size_t i = 0; i < n_; i += 2 * half)
+            butterflies(x + i, x + i + half, w, half);
+    }
+
+    return;
+}
+
+// X_k = chirp_k sum_j (x_j chirp_j) conj(chirp_{k - j}), where the sum is a
+// circular convolution of length m done with two power of two transforms
+void Plan::bluestein(Complex* x) const
+{
+    const size_t m{ inner_->size() };
+    vector<Complex> a(m, Complex{0.0, 0.0});
+    for(size_t k = 0; k < n_; ++k)
+        a[k] = x[k] * chirp_[k];
+
+    inner_->transform( a.data() );
+    for(size_t k = 0; k < m; ++k)
+        a[k] *= filter_[k];
+
+    // unnormalized inverse; the 1/m is folded into filter_
+    conjugate(a.data(), m);
+    inner_->transform( a.data() );
+
+    for(size_t k = 0; k < n_; ++k)
+        x[k] = std::conj(a[k]) * chirp_[k];
+
+    return;
+}
+
+}
+
+void Transform(Complex* x, size_t n)
+{
+    if(n < 2) return;
+
+    GetPlan(n)->transform(x);
+
+    return;
+}
+
+void InverseTransform(Complex* x, size_t n)
+{
+    if(n < 2) return;
+
+    conjugate(x, n);
+    GetPlan(n)->transform(x);
+
+    const double scale{ 1.0 / n };
+    for(size_t i = 0; i < n; ++i)
+        x[i] = std::conj(x[i]) * scale;
+
+    return;
+}
+
+vector<double> PowerSpectrum(const double* x, size_t n)
+{
+    vector<Complex> X(x, x + n);
+    Transform(X.data(), n);
+
+    vector<double> p(n / 2 + 1);
+    for(size_t k = 0; k < p.size(); ++k)
+        p[k] = std::norm(X[k]) / n;
+
+    return p;
+}
+
+vector<double> Convolve(const double* a, size_t m, const double* b, size_t n)
+{
+    const size_t length{ m + n - 1 };
+    vector<double> c(length, 0.0);
+
+    if( std::min(m, n) < DirectConvolutionLength )
+    {
+        for(size_t i = 0; i < m; ++i)
+            for(size_t j = 0; j < n; ++j)
+                c[i + j] += a[i] * b[j];
+
+        return c;
+    }
+
+    // with z = a + i b, the transforms of the real series are
+    // A_k = (Z_k + conj(Z_-k)) / 2 and B_k = (Z_k - conj(Z_-k)) / 2i
+    const size_t N{ nextPowerOfTwo(length) };
+    vector<Complex> z(N, Complex{0.0, 0.0});
+    for(size_t i = 0; i < m; ++i)
+        z[i].real(a[i]);
+    for(size_t j = 0; j < n; ++j)
+        z[j].imag(b[j]);
+
+    Transform(z.data(), N);
+
+    vector<Complex> p(N);
+    for(size_t k = 0; k < N; ++k)
+    {
+        Complex zk{ z[k] };
+        Complex zmk{ std::conj( z[(N - k) % N] ) };
+        Complex A{ (zk + zmk) * 0.5 };
+        Complex B{ (zk - zmk) * Complex{0.0, -0.5} };
+        p[k] = A * B;
+    }
+
+    InverseTransform(p.data(), N);
+    for(size_t i = 0; i < length; ++i)
+        c[i] = p[i].real();
+
+    return c;
+}
+
+void NaiveTransform(const Complex* x, Complex* X, size_t n)
+{
+    for(size_t k = 0; k < n; ++k)
+    {
+        Complex s{0.0, 0.0};
+        for(size_t j = 0; j < n; ++j)
+            s += x[j] * std::polar(1.0, -2.0 * Pi * static_cast<double>(j * k % n) / n);
+        X[k] = s;
+    }
+
+    return;
+}
+
+}
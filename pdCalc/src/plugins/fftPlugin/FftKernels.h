@@ -0,0 +1,55 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FFT_KERNELS_H
+#define FFT_KERNELS_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Discrete Fourier transforms over contiguous buffers used by the fft plugin.
+// Powers of two are transformed in place by an iterative radix 2 algorithm with
+// SSE2 butterflies; every other length is reduced to a power of two by Bluestein's
+// chirp z algorithm. Twiddle factors and chirps are computed once per length and
+// cached, so repeated transforms of the same length only do the butterflies.
+namespace FftKernels {
+
+using Complex = std::complex<double>;
+
+// X_k = sum_j x_j exp(-2 pi i j k / n), in place
+void Transform(Complex* x, size_t n);
+
+// x_j = (1 / n) sum_k X_k exp(2 pi i j k / n), in place
+void InverseTransform(Complex* x, size_t n);
+
+// periodogram |X_k|^2 / n of a real series for k = 0, ..., n / 2
+std::vector<double> PowerSpectrum(const double* x, size_t n);
+
+// linear convolution of a (length m) and b (length n), of length m + n - 1;
+// short kernels are convolved directly, longer ones through one transform of the
+// packed complex series a + i b
+// preconditions: m >= 1, n >= 1
+std::vector<double> Convolve(const double* a, size_t m, const double* b, size_t n);
+
+// the O(n^2) definition; kept as the reference for tests and benchmarks
+void NaiveTransform(const Complex* x, Complex* X, size_t n);
+
+}
+
+#endif
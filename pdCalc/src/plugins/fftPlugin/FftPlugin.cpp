@@ -0,0 +1,603 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "FftPlugin.h"
+#include "FftKernels.h"
+#include "backend/Command.h"
+#include "backend/StackPluginInterface.h"
+#include "backend/StaticPluginRegistry.h"
+#include <cmath>
+#include <vector>
+#include <string>
+#include <memory>
+#include <new>
+
+using std::vector;
+using std::string;
+using std::unique_ptr;
+using FftKernels::Complex;
+
+namespace {
+
+// a series as it sits on the stack, without its count; a complex series has
+// 2 n values
+struct Series
+{
+    const double* values;
+    size_t n;
+};
+
+vector<Complex> toComplex(const Series& s)
+{
+    const Complex* p{ reinterpret_cast<const Complex*>(s.values) };
+    return vector<Complex>(p, p + s.n);
+}
+
+void appendComplex(const vector<Complex>& x, vector<double>& result)
+{
+    const double* p{ reinterpret_cast<const double*>( x.data() ) };
+    result.assign(p, p + 2 * x.size());
+    result.push_back( x.size() );
+
+    return;
+}
+
+void appendReal(const vector<double>& x, vector<double>& result)
+{
+    result = x;
+    result.push_back( x.size() );
+
+    return;
+}
+
+}
+
+// Base class for the fft commands. As in the matrix plugin, the result is computed
+// while checking the preconditions, where running out of memory can still be
+// reported as an error, and execute only moves the cached values: the operands
+// leave the stack in one bulk pop and the result arrives in one bulk push, which
+// keeps the command a single undo entry.
+class FftPluginCommand : public pdCalc::PluginCommand
+{
+public:
+    FftPluginCommand() { }
+    explicit FftPluginCommand(const FftPluginCommand& rhs);
+    virtual ~FftPluginCommand(){}
+    void deallocate() override;
+
+protected:
+    const char* checkPluginPreconditions() const noexcept override;
+
+private:
+    void executeImpl() noexcept override;
+
+    // drops the result and returns the operands to the stack
+    void undoImpl() noexcept override;
+
+    FftPluginCommand* clonePluginImpl() const noexcept override;
+    virtual FftPluginCommand* doClone() const = 0;
+
+    // number of series the command consumes
+    virtual size_t nOperands() const { return 1; }
+
+    // true if the operands are complex series
+    virtual bool complexOperands() const { return false; }
+
+    // computes the result from the operands, deepest first, in its stack form
+    // including the trailing count
+    virtual const char* compute(const vector<Series>& operands, vector<double>& result) const = 0;
+
+    const char* prepare() const;
+
+    // stack order, bottom first, including the counts
+    mutable vector<double> operands_;
+    mutable vector<double> result_;
+};
+
+void FftPluginCommand::deallocate()
+{
+    delete this;
+}
+
+FftPluginCommand::FftPluginCommand(const FftPluginCommand& rhs)
+: PluginCommand(rhs)
+{
+}
+
+const char* FftPluginCommand::checkPluginPreconditions() const noexcept
+{
+    try
+    {
+        return prepare();
+    }
+    catch(std::bad_alloc&)
+    {
+        return "Not enough memory for transform";
+    }
+    catch(...)
+    {
+        return "FourierTransform failed";
+    }
+}
+
+const char* FftPluginCommand::prepare() const
+{
+    const size_t size{ StackSize() };
+    const size_t width{ complexOperands() ? size_t{2} : size_t{1} };
+
+    // walk down the stack from the top to find each operand's count
+    vector<size_t> counts;
+    size_t depth{0};
+    vector<double> top;
+    for(size_t i = 0; i < nOperands(); ++i)
+    {
+        if(size < depth + 1)
+            return "Stack must have a series: its values, then their count";
+
+        top.resize(depth + 1);
+        StackPeekElements(top.size(), top.data());
+        double n{ top[0] };
+        if( !(n >= 1.0) || n != std::floor(n) )
+            return "Series count must be a positive integer";
+
+        if( n * width > size - depth - 1 )
+            return "Stack has fewer entries than the series count requires";
+
+        counts.push_back( static_cast<size_t>(n) );
+        depth += 1 + width * counts.back();
+    }
+
+    operands_.resize(depth);
+    StackPeekElements(operands_.size(), operands_.data());
+
+    vector<Series> series;
+    const double* p{ operands_.data() };
+    for(size_t i = nOperands(); i-- > 0; )
+    {
+        series.push_back( {p, counts[i]} );
+        p += width * counts[i] + 1;
+    }
+
+    return compute(series, result_);
+}
+
+void FftPluginCommand::executeImpl() noexcept
+{
+    StackPopElements(operands_.size(), operands_.data(), true);
+    StackPushElements(result_.data(), result_.size(), false);
+
+    return;
+}
+
+void FftPluginCommand::undoImpl() noexcept
+{
+    StackPopElements(result_.size(), result_.data(), true);
+    StackPushElements(operands_.data(), operands_.size(), false);
+
+    // a redo recomputes both from the stack
+    vector<double>{}.swap(operands_);
+    vector<double>{}.swap(result_);
+
+    return;
+}
+
+FftPluginCommand* FftPluginCommand::clonePluginImpl() const noexcept
+{
+    FftPluginCommand* p;
+    try
+    {
+        p = doClone();
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+// discrete Fourier transform of the real series on top of the stack
+class FourierTransform : public FftPluginCommand
+{
+public:
+    FourierTransform() { }
+    explicit FourierTransform(const FourierTransform&);
+    ~FourierTransform();
+
+private:
+    FourierTransform(FourierTransform&&) = delete;
+    FourierTransform& operator=(const FourierTransform&) = delete;
+    FourierTransform& operator=(FourierTransform&&) = delete;
+
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    FourierTransform* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+FourierTransform::FourierTransform(const FourierTransform& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+FourierTransform::~FourierTransform()
+{ }
+
+const char* FourierTransform::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    const Series& s = operands[0];
+    vector<Complex> x(s.values, s.values + s.n);
+    FftKernels::Transform(x.data(), x.size());
+    appendComplex(x, result);
+
+    return nullptr;
+}
+
+FourierTransform* FourierTransform::doClone() const
+{
+    return new FourierTransform{*this};
+}
+
+const char* FourierTransform::helpMessageImpl() const noexcept
+{
+    return "Replace the series on top of the stack, its n values and then n, with its discrete Fourier transform: n complex values as real, imaginary pairs, then n";
+}
+
+// inverse discrete Fourier transform of the complex series on top of the stack,
+// keeping the real part, which undoes fft
+class InverseFourierTransform : public FftPluginCommand
+{
+public:
+    InverseFourierTransform() { }
+    explicit InverseFourierTransform(const InverseFourierTransform&);
+    ~InverseFourierTransform();
+
+private:
+    InverseFourierTransform(InverseFourierTransform&&) = delete;
+    InverseFourierTransform& operator=(const InverseFourierTransform&) = delete;
+    InverseFourierTransform& operator=(InverseFourierTransform&&) = delete;
+
+    bool complexOperands() const override { return true; }
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    InverseFourierTransform* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+InverseFourierTransform::InverseFourierTransform(const InverseFourierTransform& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+InverseFourierTransform::~InverseFourierTransform()
+{ }
+
+const char* InverseFourierTransform::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    vector<Complex> x{ toComplex(operands[0]) };
+    FftKernels::InverseTransform(x.data(), x.size());
+
+    vector<double> re(x.size());
+    for(size_t i = 0; i < x.size(); ++i)
+        re[i] = x[i].real();
+    appendReal(re, result);
+
+    return nullptr;
+}
+
+InverseFourierTransform* InverseFourierTransform::doClone() const
+{
+    return new InverseFourierTransform{*this};
+}
+
+const char* InverseFourierTransform::helpMessageImpl() const noexcept
+{
+    return "Replace the complex series on top of the stack, its n real, imaginary pairs and then n, with the real part of its inverse discrete Fourier transform, then n";
+}
+
+// discrete Fourier transform of the complex series on top of the stack
+class ComplexFourierTransform : public FftPluginCommand
+{
+public:
+    ComplexFourierTransform() { }
+    explicit ComplexFourierTransform(const ComplexFourierTransform&);
+    ~ComplexFourierTransform();
+
+private:
+    ComplexFourierTransform(ComplexFourierTransform&&) = delete;
+    ComplexFourierTransform& operator=(const ComplexFourierTransform&) = delete;
+    ComplexFourierTransform& operator=(ComplexFourierTransform&&) = delete;
+
+    bool complexOperands() const override { return true; }
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    ComplexFourierTransform* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+ComplexFourierTransform::ComplexFourierTransform(const ComplexFourierTransform& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+ComplexFourierTransform::~ComplexFourierTransform()
+{ }
+
+const char* ComplexFourierTransform::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    vector<Complex> x{ toComplex(operands[0]) };
+    FftKernels::Transform(x.data(), x.size());
+    appendComplex(x, result);
+
+    return nullptr;
+}
+
+ComplexFourierTransform* ComplexFourierTransform::doClone() const
+{
+    return new ComplexFourierTransform{*this};
+}
+
+const char* ComplexFourierTransform::helpMessageImpl() const noexcept
+{
+    return "Replace the complex series on top of the stack, its n real, imaginary pairs and then n, with its discrete Fourier transform";
+}
+
+// inverse discrete Fourier transform of the complex series on top of the stack
+class ComplexInverseFourierTransform : public FftPluginCommand
+{
+public:
+    ComplexInverseFourierTransform() { }
+    explicit ComplexInverseFourierTransform(const ComplexInverseFourierTransform&);
+    ~ComplexInverseFourierTransform();
+
+private:
+    ComplexInverseFourierTransform(ComplexInverseFourierTransform&&) = delete;
+    ComplexInverseFourierTransform& operator=(const ComplexInverseFourierTransform&) = delete;
+    ComplexInverseFourierTransform& operator=(ComplexInverseFourierTransform&&) = delete;
+
+    bool complexOperands() const override { return true; }
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    ComplexInverseFourierTransform* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+ComplexInverseFourierTransform::ComplexInverseFourierTransform(const ComplexInverseFourierTransform& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+ComplexInverseFourierTransform::~ComplexInverseFourierTransform()
+{ }
+
+const char* ComplexInverseFourierTransform::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    vector<Complex> x{ toComplex(operands[0]) };
+    FftKernels::InverseTransform(x.data(), x.size());
+    appendComplex(x, result);
+
+    return nullptr;
+}
+
+ComplexInverseFourierTransform* ComplexInverseFourierTransform::doClone() const
+{
+    return new ComplexInverseFourierTransform{*this};
+}
+
+const char* ComplexInverseFourierTransform::helpMessageImpl() const noexcept
+{
+    return "Replace the complex series on top of the stack, its n real, imaginary pairs and then n, with its inverse discrete Fourier transform";
+}
+
+// periodogram of the real series on top of the stack
+class PowerSpectralDensity : public FftPluginCommand
+{
+public:
+    PowerSpectralDensity() { }
+    explicit PowerSpectralDensity(const PowerSpectralDensity&);
+    ~PowerSpectralDensity();
+
+private:
+    PowerSpectralDensity(PowerSpectralDensity&&) = delete;
+    PowerSpectralDensity& operator=(const PowerSpectralDensity&) = delete;
+    PowerSpectralDensity& operator=(PowerSpectralDensity&&) = delete;
+
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    PowerSpectralDensity* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+PowerSpectralDensity::PowerSpectralDensity(const PowerSpectralDensity& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+PowerSpectralDensity::~PowerSpectralDensity()
+{ }
+
+const char* PowerSpectralDensity::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    const Series& s = operands[0];
+    appendReal( FftKernels::PowerSpectrum(s.values, s.n), result );
+
+    return nullptr;
+}
+
+PowerSpectralDensity* PowerSpectralDensity::doClone() const
+{
+    return new PowerSpectralDensity{*this};
+}
+
+const char* PowerSpectralDensity::helpMessageImpl() const noexcept
+{
+    return "Replace the series on top of the stack, its n values and then n, with its power spectrum |X_k|^2 / n for k = 0, ..., n / 2, then the number of values";
+}
+
+// linear convolution of the top two real series on the stack
+class Convolution : public FftPluginCommand
+{
+public:
+    Convolution() { }
+    explicit Convolution(const Convolution&);
+    ~Convolution();
+
+private:
+    Convolution(Convolution&&) = delete;
+    Convolution& operator=(const Convolution&) = delete;
+    Convolution& operator=(Convolution&&) = delete;
+
+    size_t nOperands() const override { return 2; }
+    const char* compute(const vector<Series>& operands, vector<double>& result) const override;
+
+    Convolution* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Convolution::Convolution(const Convolution& rhs)
+: FftPluginCommand{rhs}
+{ }
+
+Convolution::~Convolution()
+{ }
+
+const char* Convolution::compute(const vector<Series>& operands, vector<double>& result) const
+{
+    const Series& a = operands[0];
+    const Series& b = operands[1];
+    appendReal( FftKernels::Convolve(a.values, a.n, b.values, b.n), result );
+
+    return nullptr;
+}
+
+Convolution* Convolution::doClone() const
+{
+    return new Convolution{*this};
+}
+
+const char* Convolution::helpMessageImpl() const noexcept
+{
+    return "Replace the top two series on the stack, each its n values and then n, with their convolution, then its length";
+}
+
+// The double buffering of the PluginDescriptor is to maintain exception safety by
+// keeping all memory allocation in RAII containers (see HyperbolicLnPlugin).
+class FftPlugin::FftPluginImpl
+{
+public:
+    FftPluginImpl();
+    ~FftPluginImpl();
+
+    const PluginDescriptor& getPluginDescriptor() const { return pd_; }
+
+private:
+    pdCalc::Plugin::PluginDescriptor pd_;
+    vector<pdCalc::Command*> rawCommands_;
+    vector<unique_ptr<pdCalc::Command>> commands_;
+    vector<char*> rawNames_;
+    vector<string> commandNames_;
+};
+
+FftPlugin::FftPluginImpl::FftPluginImpl()
+{
+    const int n = 6;
+    pd_.nCommands = n;
+    commandNames_.reserve(n);
+    commands_.reserve(n);
+
+    commandNames_.emplace_back("fft");
+    commands_.emplace_back(new FourierTransform);
+
+    commandNames_.emplace_back("ifft");
+    commands_.emplace_back(new InverseFourierTransform);
+
+    commandNames_.emplace_back("cfft");
+    commands_.emplace_back(new ComplexFourierTransform);
+
+    commandNames_.emplace_back("cifft");
+    commands_.emplace_back(new ComplexInverseFourierTransform);
+
+    commandNames_.emplace_back("psd");
+    commands_.emplace_back(new PowerSpectralDensity);
+
+    commandNames_.emplace_back("conv");
+    commands_.emplace_back(new Convolution);
+
+    rawNames_.resize(n);
+    rawCommands_.resize(n);
+    for(int i = 0; i < n; ++i)
+    {
+        rawCommands_[i] = commands_[i].get();
+        rawNames_[i] = &commandNames_[i][0];
+    }
+
+    pd_.commands = &rawCommands_[0];
+    pd_.commandNames = &rawNames_[0];
+}
+
+FftPlugin::FftPluginImpl::~FftPluginImpl()
+{ }
+
+FftPlugin::FftPlugin()
+: Plugin{}
+, pimpl_{ std::make_unique<FftPluginImpl>() }
+{ }
+
+FftPlugin::~FftPlugin()
+{ }
+
+const pdCalc::Plugin::PluginDescriptor& FftPlugin::getPluginDescriptor() const
+{
+    return pimpl_->getPluginDescriptor();
+}
+
+// series are entered from the command line, so no buttons are provided
+const pdCalc::Plugin::PluginButtonDescriptor* FftPlugin::getPluginButtonDescriptor() const
+{
+    return nullptr;
+}
+
+pdCalc::Plugin::ApiVersion FftPlugin::apiVersion() const
+{
+    return {1, 0};
+}
+
+#ifdef STATIC_PLUGIN
+
+void RegisterFftPlugin()
+{
+    pdCalc::StaticPluginRegistry::Instance().registerPlugin( "fftPlugin",
+        []() -> void* { return new FftPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+}
+
+#else
+
+extern "C" void* AllocPlugin()
+{
+    return new FftPlugin;
+}
+
+extern "C" void DeallocPlugin(void* p)
+{
+    auto d = static_cast<pdCalc::Plugin*>(p);
+    delete d;
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FFT_PLUGIN_H
+#define FFT_PLUGIN_H
+
+#include <memory>
+#include "backend/Plugin.h"
+
+// Spectral analysis of series stored on the stack. A series occupies its values
+// followed by their count; a complex series stores each value as a real,
+// imaginary pair. The commands are fft, ifft, cfft, cifft, psd, and conv; each
+// replaces its series with the result, again followed by its count, as a single
+// undoable operation.
+class FftPlugin : public pdCalc::Plugin
+{
+    class FftPluginImpl;
+public:
+    FftPlugin();
+    ~FftPlugin();
+
+    const PluginDescriptor& getPluginDescriptor() const override;
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override;
+    pdCalc::Plugin::ApiVersion apiVersion() const override;
+
+private:
+    std::unique_ptr<FftPluginImpl> pimpl_;
+};
+
+extern "C" void* AllocPlugin();
+extern "C" void DeallocPlugin(void*);
+
+// registers the plugin with pdCalc::StaticPluginRegistry, in place of the above when
+// the plugin is linked into pdCalc
+void RegisterFftPlugin();
+
+#endif
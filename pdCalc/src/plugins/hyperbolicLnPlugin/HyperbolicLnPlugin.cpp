@@ -19,6 +19,8 @@
 #include "HyperbolicLnPlugin.h"
 #include "backend/Command.h"
 #include "backend/StackPluginInterface.h"
+#include "backend/StaticPluginRegistry.h"
+#include "utilities/VectorMath.h"
 #include <cmath>
 #include <vector>
 #include <iostream>
@@ -31,6 +33,32 @@ using std::vector;
 using std::string;
 using std::unique_ptr;
 
+namespace {
+
+// domain checks shared by the single value and block forms of the commands; each
+// returns an error message for an argument outside the domain
+const char* ArccoshDomain(double x)
+{
+    return x < 1.0 ? "Imaginary result" : nullptr;
+}
+
+const char* ArctanhDomain(double x)
+{
+    return std::fabs(x) >= 1.0 ? "Imaginary result" : nullptr;
+}
+
+const char* LnDomain(double x)
+{
+    if(x == 0.0)
+        return "Infinite result";
+    if(x < 0.0)
+        return "Imaginary result";
+
+    return nullptr;
+}
+
+}
+
 class HyperbolicLnPluginCommand : public pdCalc::PluginCommand
 {
 public:
@@ -314,11 +342,7 @@ const char* Arccosh::checkPluginPreconditions() const noexcept
     const char* r = HyperbolicLnPluginCommand::checkPluginPreconditions();
     if(r) return r;
 
-    auto v = StackFirstElement();
-    if(v < 1.0)
-        return "Imaginary result";
-
-    return nullptr;
+    return ArccoshDomain( StackFirstElement() );
 }
 
 double Arccosh::unaryOperation(double top) const
@@ -371,11 +395,7 @@ const char* Arctanh::checkPluginPreconditions() const noexcept
     const char* r = HyperbolicLnPluginCommand::checkPluginPreconditions();
     if(r) return r;
 
-    auto v = StackFirstElement();
-    if(std::fabs(v) >= 1.0)
-        return "Imaginary result";
-
-    return nullptr;
+    return ArctanhDomain( StackFirstElement() );
 }
 
 double Arctanh::unaryOperation(double top) const
@@ -471,13 +491,7 @@ const char* NaturalLog::checkPluginPreconditions() const noexcept
     const char* r = HyperbolicLnPluginCommand::checkPluginPreconditions();
     if(r) return r;
 
-    auto v = StackFirstElement();
-    if(v == 0.0)
-        return "Infinite result";
-    if(v < 0.0)
-         return "Imaginary result";
-
-    return nullptr;
+    return LnDomain( StackFirstElement() );
 }
 
 double NaturalLog::unaryOperation(double top) const
@@ -495,6 +509,156 @@ const char* NaturalLog::helpMessageImpl() const noexcept
     return "Replace the first element, x, on the stack with ln(x)";
 }
 
+// Applies one of the functions above to each of the n elements below a count n on
+// the top of the stack, evaluating the whole block at once with the VectorMath
+// kernels. The count and the block are removed with one bulk pop and the results
+// pushed with one bulk push, so the command is a single undo entry regardless of
+// its size.
+// preconditions: 1) the top of the stack is a positive integer count, n
+//                2) at least n numbers below the count
+//                3) each of the n numbers in the domain of the function
+class HyperbolicLnBlockCommand : public pdCalc::PluginCommand
+{
+public:
+    using Kernel = void(const double*, double*, size_t);
+
+    // returns an error message if the argument is outside the function's domain
+    using Domain = const char*(double);
+
+    HyperbolicLnBlockCommand(const char* help, Kernel* kernel, Domain* domain = nullptr);
+    explicit HyperbolicLnBlockCommand(const HyperbolicLnBlockCommand& rhs);
+    ~HyperbolicLnBlockCommand();
+    void deallocate() override;
+
+private:
+    HyperbolicLnBlockCommand(HyperbolicLnBlockCommand&&) = delete;
+    HyperbolicLnBlockCommand& operator=(const HyperbolicLnBlockCommand&) = delete;
+    HyperbolicLnBlockCommand& operator=(HyperbolicLnBlockCommand&&) = delete;
+
+    const char* checkPluginPreconditions() const noexcept override;
+
+    void executeImpl() noexcept override;
+
+    // drops the results and returns the count and the original numbers to the stack
+    void undoImpl() noexcept override;
+
+    HyperbolicLnBlockCommand* clonePluginImpl() const noexcept override;
+
+    const char* helpMessageImpl() const noexcept override;
+
+    const char* help_;
+    Kernel* kernel_;
+    Domain* domain_;
+
+    // operands in stack order, bottom first: the block, then the count
+    mutable vector<double> operands_;
+};
+
+HyperbolicLnBlockCommand::HyperbolicLnBlockCommand(const char* help, Kernel* kernel, Domain* domain)
+: help_(help)
+, kernel_(kernel)
+, domain_(domain)
+{
+}
+
+HyperbolicLnBlockCommand::HyperbolicLnBlockCommand(const HyperbolicLnBlockCommand& rhs)
+: PluginCommand(rhs)
+, help_(rhs.help_)
+, kernel_(rhs.kernel_)
+, domain_(rhs.domain_)
+{
+}
+
+HyperbolicLnBlockCommand::~HyperbolicLnBlockCommand()
+{ }
+
+void HyperbolicLnBlockCommand::deallocate()
+{
+    delete this;
+}
+
+const char* HyperbolicLnBlockCommand::checkPluginPreconditions() const noexcept
+{
+    size_t size{ StackSize() };
+    if(size < 1)
+        return "Stack must have a count on top";
+
+    double count{ StackFirstElement() };
+    if( !(count >= 1.0) || count != std::floor(count) )
+        return "Count must be a positive integer";
+
+    if(count > size - 1)
+        return "Stack has fewer elements than the count";
+
+    if(domain_)
+    {
+        try
+        {
+            operands_.resize( static_cast<size_t>(count) + 1 );
+        }
+        catch(...)
+        {
+            return "Out of memory";
+        }
+
+        StackPeekElements( operands_.size(), operands_.data() );
+        for(size_t i = 0; i + 1 < operands_.size(); ++i)
+        {
+            if( const char* error = domain_(operands_[i]) )
+                return error;
+        }
+    }
+
+    return nullptr;
+}
+
+void HyperbolicLnBlockCommand::executeImpl() noexcept
+{
+    size_t n{ static_cast<size_t>( StackFirstElement() ) };
+
+    operands_.resize(n + 1);
+    StackPopElements(operands_.size(), operands_.data(), true);
+
+    vector<double> results(n);
+    kernel_( operands_.data(), results.data(), n );
+    StackPushElements(results.data(), n, false);
+
+    return;
+}
+
+void HyperbolicLnBlockCommand::undoImpl() noexcept
+{
+    size_t n{ operands_.size() - 1 };
+    vector<double> results(n);
+    StackPopElements(n, results.data(), true);
+    StackPushElements(operands_.data(), operands_.size(), false);
+
+    // a redo pops the operands again, so there is no reason to hold on to them
+    vector<double>{}.swap(operands_);
+
+    return;
+}
+
+HyperbolicLnBlockCommand* HyperbolicLnBlockCommand::clonePluginImpl() const noexcept
+{
+    HyperbolicLnBlockCommand* p;
+    try
+    {
+        p = new HyperbolicLnBlockCommand{*this};
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+const char* HyperbolicLnBlockCommand::helpMessageImpl() const noexcept
+{
+    return help_;
+}
+
 // The double buffering of the PluginDescriptor and PluginButtonDescriptor is to maintain exception safety by
 // keeping all memory allocation in RAII containers. Without regard to exception safety, this can be made
 // much simpler without buffering.
@@ -530,7 +694,7 @@ private:
 
 void HyperbolicLnPlugin::HyperbolicLnPluginImpl::createPluginDescriptor()
 {
-    const int n = 8;
+    const int n = 16;
     pd_.nCommands = n;
     commandNames_.reserve(n);
     commands_.reserve(n);
@@ -559,6 +723,38 @@ void HyperbolicLnPlugin::HyperbolicLnPluginImpl::createPluginDescriptor()
     commandNames_.emplace_back("ln\0");
     commands_.emplace_back(new NaturalLog);
 
+    commandNames_.emplace_back("sinhn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their sinh. Note, n is top of stack",
+        pdCalc::VectorMath::Sinh} );
+
+    commandNames_.emplace_back("coshn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their cosh. Note, n is top of stack",
+        pdCalc::VectorMath::Cosh} );
+
+    commandNames_.emplace_back("tanhn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their tanh. Note, n is top of stack",
+        pdCalc::VectorMath::Tanh} );
+
+    commandNames_.emplace_back("arcsinhn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their arcsinh. Note, n is top of stack",
+        pdCalc::VectorMath::Asinh} );
+
+    commandNames_.emplace_back("arccoshn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their arccosh. Note, n is top of stack",
+        pdCalc::VectorMath::Acosh, ArccoshDomain} );
+
+    commandNames_.emplace_back("arctanhn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their arctanh. Note, n is top of stack",
+        pdCalc::VectorMath::Atanh, ArctanhDomain} );
+
+    commandNames_.emplace_back("expn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their exp. Note, n is top of stack",
+        pdCalc::VectorMath::Exp} );
+
+    commandNames_.emplace_back("lnn\0");
+    commands_.emplace_back( new HyperbolicLnBlockCommand{"Replace the top n elements on the stack with their ln. Note, n is top of stack",
+        pdCalc::VectorMath::Log, LnDomain} );
+
     rawNames_.resize(n);
     rawCommands_.resize(n);
     for(int i = 0; i < n; ++i)
@@ -654,6 +850,17 @@ pdCalc::Plugin::ApiVersion HyperbolicLnPlugin::apiVersion() const
     return {1, 0};
 }
 
+#ifdef STATIC_PLUGIN
+
+void RegisterHyperbolicLnPlugin()
+{
+    pdCalc::StaticPluginRegistry::Instance().registerPlugin( "hyperbolicLnPlugin",
+        []() -> void* { return new HyperbolicLnPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+}
+
+#else
+
 extern "C" void* AllocPlugin()
 {
     return new HyperbolicLnPlugin;
@@ -664,3 +871,5 @@ extern "C" void DeallocPlugin(void* p)
     auto d = static_cast<pdCalc::Plugin*>(p);
     delete d;
 }
+
+#endif
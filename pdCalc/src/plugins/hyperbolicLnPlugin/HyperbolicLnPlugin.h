@@ -41,4 +41,8 @@ private:
 extern "C" void* AllocPlugin();
 extern "C" void DeallocPlugin(void*);
 
+// registers the plugin with pdCalc::StaticPluginRegistry, in place of the above when
+// the plugin is linked into pdCalc
+void RegisterHyperbolicLnPlugin();
+
 #endif
@@ -6,6 +6,13 @@ DEPENDPATH += .
 INCLUDEPATH += . $$HOME/src
 unix:DESTDIR = $$HOME/lib
 win32:DESTDIR = $$HOME/bin
+
+# linked into pdCalc rather than loaded from a library of its own (see common.pri)
+contains(STATIC_PLUGINS, hyperbolicLnPlugin) {
+    CONFIG += staticlib ltcg
+    DEFINES += STATIC_PLUGIN
+}
+
 QT += widgets
 
 # Input
@@ -0,0 +1,403 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Matrix.h"
+#include "utilities/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::vector;
+using std::min;
+
+namespace {
+
+// register block of the micro kernel
+const size_t MR = 4;
+const size_t NR = 4;
+
+// cache blocks: an MC x KC block of A lives in L2, a KC x NR panel of B in L1,
+// and a KC x NC block of B in L3
+const size_t MC = 64;
+const size_t KC = 256;
+const size_t NC = 1024;
+
+// products of at least this many multiply adds use the thread pool
+const size_t ParallelThreshold = size_t{1} << 21;
+
+// copies the mc x kc block of A into row panels of MR rows, each stored column by
+// column, padding the last panel with zeros
+void packA(size_t mc, size_t kc, const double* A, size_t lda, double* Ap)
+{
+    for(size_t i0 = 0; i0 < mc; i0 += MR)
+    {
+        size_t mr{ min(MR, mc - i0) };
+        for(size_t p = 0; p < kc; ++p)
+        {
+            for(size_t r = 0; r < mr; ++r)
+                Ap[p * MR + r] = A[(i0 + r) * lda + p];
+            for(size_t r = mr; r < MR; ++r)
+                Ap[p * MR + r] = 0.0;
+        }
+        Ap += MR * kc;
+    }
+
+    return;
+}
+
+// copies the kc x nc block of B into column panels of NR columns, each stored row
+// by row, padding the last panel with zeros
+void packB(size_t kc, size_t nc, const double* B, size_t ldb, double* Bp)
+{
+    for(size_t j0 = 0; j0 < nc; j0 += NR)
+    {
+        size_t nr{ min(NR, nc - j0) };
+        for(size_t p = 0; p < kc; ++p)
+        {
+            const double* b = B + p * ldb + j0;
+            for(size_t c = 0; c < nr; ++c)
+                Bp[p * NR + c] = b[c];
+            for(size_t c = nr; c < NR; ++c)
+                Bp[p * NR + c] = 0.0;
+        }
+        Bp += NR * kc;
+    }
+
+    return;
+}
+
+// C[0:mr, 0:nr] += alpha Ap Bp for one packed MR row panel and NR column panel
+void microKernel(size_t kc, double alpha, const double* Ap, const double* Bp, double* C, size_t ldc, size_t mr, size_t nr)
+{
+    double ab[MR * NR];
+
+#ifdef __SSE2__
+    __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+    __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+    __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+    __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+
+    for(size_t p = 0; p < kc; ++p)
+    {
+        __m128d b0 = _mm_loadu_pd(Bp);
+        __m128d b1 = _mm_loadu_pd(Bp + 2);
+
+        __m128d a = _mm_set1_pd(Ap[0]);
+        c00 = _mm_add_pd( c00, _mm_mul_pd(a, b0) );
+        c01 = _mm_add_pd( c01, _mm_mul_pd(a, b1) );
+        a = _mm_set1_pd(Ap[1]);
+        c10 = _mm_add_pd( c10, _mm_mul_pd(a, b0) );
+        c11 = _mm_add_pd( c11, _mm_mul_pd(a, b1) );
+        a = _mm_set1_pd(Ap[2]);
+        c20 = _mm_add_pd( c20, _mm_mul_pd(a, b0) );
+        c21 = _mm_add_pd( c21, _mm_mul_pd(a, b1) );
+        a = _mm_set1_pd(Ap[3]);
+        c30 = _mm_add_pd( c30, _mm_mul_pd(a, b0) );
+        c31 = _mm_add_pd( c31, _mm_mul_pd(a, b1) );
+
+        Ap += MR;
+        Bp += NR;
+    }
+
+    _mm_storeu_pd(ab, c00);      _mm_storeu_pd(ab + 2, c01);
+    _mm_storeu_pd(ab + 4, c10);  _mm_storeu_pd(ab + 6, c11);
+    _mm_storeu_pd(ab + 8, c20);  _mm_storeu_pd(ab + 10, c21);
+    _mm_storeu_pd(ab + 12, c30); _mm_storeu_pd(ab + 14, c31);
+#else
+    std::fill(ab, ab + MR * NR, 0.0);
+    for(size_t p = 0; p < kc; ++p)
+    {
+        for(size_t r = 0; r < MR; ++r)
+            for(size_t c = 0; c < NR; ++c)
+                ab[r * NR + c] += Ap[r] * Bp[c];
+
+        Ap += MR;
+        Bp += NR;
+    }
+#endif
+
+    for(size_t r = 0; r < mr; ++r)
+        for(size_t c = 0; c < nr; ++c)
+            C[r * ldc + c] += alpha * ab[r * NR + c];
+
+    return;
+}
+
+// multiplies a packed mc x kc block of A by the packed kc x nc block of B
+void macroKernel(size_t mc, size_t nc, size_t kc, double alpha, const double* Ap, const double* Bp, double* C, size_t ldc)
+{
+    for(size_t j0 = 0; j0 < nc; j0 += NR)
+    {
+        size_t nr{ min(NR, nc - j0) };
+        for(size_t i0 = 0; i0 < mc; i0 += MR)
+        {
+            size_t mr{ min(MR, mc - i0) };
+            microKernel(kc, alpha, Ap + i0 * kc, Bp + j0 * kc, C + i0 * ldc + j0, ldc, mr, nr);
+        }
+    }
+
+    return;
+}
+
+size_t roundUp(size_t n, size_t m)
+{
+    return (n + m - 1) / m * m;
+}
+
+// y += a x
+void axpy(size_t n, double a, const double* x, double* y)
+{
+    size_t i{0};
+#ifdef __SSE2__
+    __m128d av = _mm_set1_pd(a);
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_pd( y + i, _mm_add_pd( _mm_loadu_pd(y + i), _mm_mul_pd(av, _mm_loadu_pd(x + i)) ) );
+        _mm_storeu_pd( y + i + 2, _mm_add_pd( _mm_loadu_pd(y + i + 2), _mm_mul_pd(av, _mm_loadu_pd(x + i + 2)) ) );
+    }
+#endif
+    for(; i < n; ++i)
+        y[i] += a * x[i];
+
+    return;
+}
+
+}
+
+Matrix::Matrix(size_t rows, size_t cols)
+: rows_{rows}
+, cols_{cols}
+, data_(rows * cols, 0.0)
+{ }
+
+Matrix::Matrix(size_t rows, size_t cols, const double* rowMajor)
+: rows_{rows}
+, cols_{cols}
+, data_(rowMajor, rowMajor + rows * cols)
+{ }
+
+Matrix Matrix::Identity(size_t n)
+{
+    Matrix I{n, n};
+    for(size_t i = 0; i < n; ++i)
+        I(i, i) = 1.0;
+
+    return I;
+}
+
+void Gemm(size_t m, size_t n, size_t k, double alpha, const double* A, size_t lda,
+    const double* B, size_t ldb, double* C, size_t ldc)
+{
+    if(m == 0 || n == 0 || k == 0) return;
+
+    auto& pool = pdCalc::ThreadPool::Instance();
+    const bool parallel{ m * n * k >= ParallelThreshold };
+    const size_t nBlocks{ (m + MC - 1) / MC };
+
+    vector<double> Bp( roundUp(min(NC, n), NR) * min(KC, k) );
+    vector<double> Ap( MC * min(KC, k) );
+
+    for(size_t jc = 0; jc < n; jc += NC)
+    {
+        size_t nc{ min(NC, n - jc) };
+        for(size_t pc = 0; pc < k; pc += KC)
+        {
+            size_t kc{ min(KC, k - pc) };
+            packB(kc, nc, B + pc * ldb + jc, ldb, Bp.data());
+
+            if(parallel)
+            {
+                // each chunk owns a range of row blocks of C and packs its own A
+                pool.parallelFor(nBlocks, 1, [&](size_t, size_t begin, size_t end)
+                {
+                    vector<double> localAp( MC * kc );
+                    for(size_t b = begin; b < end; ++b)
+                    {
+                        size_t ic{ b * MC };
+                        size_t mc{ min(MC, m - ic) };
+                        packA(mc, kc, A + ic * lda + pc, lda, localAp.data());
+                        macroKernel(mc, nc, kc, alpha, localAp.data(), Bp.data(), C + ic * ldc + jc, ldc);
+                    }
+                });
+            }
+            else
+            {
+                for(size_t ic = 0; ic < m; ic += MC)
+                {
+                    size_t mc{ min(MC, m - ic) };
+                    packA(mc, kc, A + ic * lda + pc, lda, Ap.data());
+                    macroKernel(mc, nc, kc, alpha, Ap.data(), Bp.data(), C + ic * ldc + jc, ldc);
+                }
+            }
+        }
+    }
+
+    return;
+}
+
+Matrix Multiply(const Matrix& A, const Matrix& B)
+{
+    Matrix C{A.rows(), B.cols()};
+    Gemm(A.rows(), B.cols(), A.cols(), 1.0, A.data(), A.cols(), B.data(), B.cols(), C.data(), C.cols());
+
+    return C;
+}
+
+Matrix MultiplyNaive(const Matrix& A, const Matrix& B)
+{
+    Matrix C{A.rows(), B.cols()};
+    for(size_t i = 0; i < A.rows(); ++i)
+        for(size_t j = 0; j < B.cols(); ++j)
+        {
+            double s{0};
+            for(size_t p = 0; p < A.cols(); ++p)
+                s += A(i, p) * B(p, j);
+            C(i, j) = s;
+        }
+
+    return C;
+}
+
+Matrix Transpose(const Matrix& A)
+{
+    // Square tiles keep both the reads and the writes within a few cache lines. The
+    // tile is small because with power of two leading dimensions the strided side of
+    // a larger tile maps onto too few cache sets.
+    const size_t tile = 16;
+    const size_t m{ A.rows() };
+    const size_t n{ A.cols() };
+    Matrix T{n, m};
+    const double* a{ A.data() };
+    double* t{ T.data() };
+    for(size_t i0 = 0; i0 < m; i0 += tile)
+        for(size_t j0 = 0; j0 < n; j0 += tile)
+        {
+            size_t iEnd{ min(i0 + tile, m) };
+            size_t jEnd{ min(j0 + tile, n) };
+            for(size_t j = j0; j < jEnd; ++j)
+                for(size_t i = i0; i < iEnd; ++i)
+                    t[j * m + i] = a[i * n + j];
+        }
+
+    return T;
+}
+
+LuDecomposition::LuDecomposition(const Matrix& A)
+: lu_{A}
+, pivots_(A.rows())
+, singular_{false}
+, sign_{1}
+{
+    const size_t n{ lu_.rows() };
+    const size_t nb = 64;
+    double* a{ lu_.data() };
+
+    for(size_t k0 = 0; k0 < n; k0 += nb)
+    {
+        size_t kEnd{ min(k0 + nb, n) };
+
+        // factor the panel of columns [k0, kEnd) over all rows below k0
+        for(size_t k = k0; k < kEnd; ++k)
+        {
+            size_t p{k};
+            for(size_t i = k + 1; i < n; ++i)
+                if( std::fabs(a[i * n + k]) > std::fabs(a[p * n + k]) ) p = i;
+
+            pivots_[k] = p;
+            if(a[p * n + k] == 0.0)
+            {
+                singular_ = true;
+                return;
+            }
+
+            if(p != k)
+            {
+                std::swap_ranges(a + k * n, a + (k + 1) * n, a + p * n);
+                sign_ = -sign_;
+            }
+
+            double inv{ 1.0 / a[k * n + k] };
+            for(size_t i = k + 1; i < n; ++i)
+            {
+                double l{ a[i * n + k] *= inv };
+                for(size_t j = k + 1; j < kEnd; ++j)
+                    a[i * n + j] -= l * a[k * n + j];
+            }
+        }
+
+        if(kEnd == n) break;
+
+        // U12 = L11^-1 A12
+        for(size_t k = k0; k < kEnd; ++k)
+            for(size_t i = k + 1; i < kEnd; ++i)
+                axpy(n - kEnd, -a[i * n + k], a + k * n + kEnd, a + i * n + kEnd);
+
+        // A22 -= L21 U12
+        Gemm(n - kEnd, n - kEnd, kEnd - k0, -1.0, a + kEnd * n + k0, n, a + k0 * n + kEnd, n, a + kEnd * n + kEnd, n);
+    }
+}
+
+double LuDecomposition::determinant() const
+{
+    if(singular_) return 0.0;
+
+    double d{ static_cast<double>(sign_) };
+    for(size_t i = 0; i < lu_.rows(); ++i)
+        d *= lu_(i, i);
+
+    return d;
+}
+
+Matrix LuDecomposition::solve(const Matrix& B) const
+{
+    const size_t n{ lu_.rows() };
+    const size_t m{ B.cols() };
+    Matrix X{B};
+    double* x{ X.data() };
+    const double* a{ lu_.data() };
+
+    for(size_t k = 0; k < n; ++k)
+        if(pivots_[k] != k)
+            std::swap_ranges(x + k * m, x + (k + 1) * m, x + pivots_[k] * m);
+
+    // forward substitution with the unit lower triangle
+    for(size_t i = 1; i < n; ++i)
+        for(size_t j = 0; j < i; ++j)
+            axpy(m, -a[i * n + j], x + j * m, x + i * m);
+
+    // back substitution with the upper triangle
+    for(size_t i = n; i-- > 0; )
+    {
+        for(size_t j = i + 1; j < n; ++j)
+            axpy(m, -a[i * n + j], x + j * m, x + i * m);
+
+        double inv{ 1.0 / a[i * n + i] };
+        for(size_t c = 0; c < m; ++c)
+            x[i * m + c] *= inv;
+    }
+
+    return X;
+}
+
+Matrix LuDecomposition::inverse() const
+{
+    return solve( Matrix::Identity( lu_.rows() ) );
+}
@@ -0,0 +1,95 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <vector>
+
+// A dense matrix of doubles stored row major, the same order in which its entries
+// sit on the stack. On the stack, a matrix is its entries followed by the number of
+// rows and then the number of columns, so the column count is on top.
+class Matrix
+{
+public:
+    Matrix() : rows_{0}, cols_{0} { }
+    Matrix(size_t rows, size_t cols);
+    Matrix(size_t rows, size_t cols, const double* rowMajor);
+
+    static Matrix Identity(size_t n);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t size() const { return data_.size(); }
+
+    double* data() { return data_.data(); }
+    const double* data() const { return data_.data(); }
+
+    double& operator()(size_t i, size_t j) { return data_[i * cols_ + j]; }
+    double operator()(size_t i, size_t j) const { return data_[i * cols_ + j]; }
+
+private:
+    size_t rows_;
+    size_t cols_;
+    std::vector<double> data_;
+};
+
+// C = A B using the blocked kernel
+// precondition: A.cols() == B.rows()
+Matrix Multiply(const Matrix& A, const Matrix& B);
+
+// C = A B by the textbook triple loop; kept as the reference for tests and benchmarks
+Matrix MultiplyNaive(const Matrix& A, const Matrix& B);
+
+Matrix Transpose(const Matrix& A);
+
+// C += alpha A B on row major storage with leading dimensions lda, ldb, ldc, where
+// A is m x k, B is k x n, and C is m x n. Blocks are packed into contiguous panels
+// sized for the caches and multiplied by a 4x4 SSE2 register kernel. Products with
+// at least ParallelThreshold flops split the rows of C across the ThreadPool.
+void Gemm(size_t m, size_t n, size_t k, double alpha, const double* A, size_t lda,
+    const double* B, size_t ldb, double* C, size_t ldc);
+
+// LU decomposition with partial pivoting, PA = LU, computed by a blocked right
+// looking algorithm so that most of the work is done by Gemm.
+class LuDecomposition
+{
+public:
+    // precondition: A is square
+    explicit LuDecomposition(const Matrix& A);
+
+    // true if a zero pivot was encountered; solve and inverse are then undefined
+    bool singular() const { return singular_; }
+
+    double determinant() const;
+
+    // returns X such that A X = B
+    // precondition: B.rows() equals the order of A
+    Matrix solve(const Matrix& B) const;
+
+    Matrix inverse() const;
+
+private:
+    Matrix lu_;
+    std::vector<size_t> pivots_;
+    bool singular_;
+    int sign_;
+};
+
+#endif
@@ -0,0 +1,553 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MatrixPlugin.h"
+#include "Matrix.h"
+#include "backend/Command.h"
+#include "backend/StackPluginInterface.h"
+#include "backend/StaticPluginRegistry.h"
+#include <cmath>
+#include <vector>
+#include <string>
+#include <memory>
+#include <new>
+
+using std::vector;
+using std::string;
+using std::unique_ptr;
+
+// Base class for the matrix commands. Unlike the core commands, a matrix command
+// can only discover some failures (a singular matrix) by doing the work, so the
+// result is computed while checking the preconditions, which leave the stack
+// untouched if anything is wrong. Execute then only moves the cached values: all
+// operands leave the stack in one bulk pop and the result arrives in one bulk
+// push, which keeps the command a single undo entry.
+class MatrixPluginCommand : public pdCalc::PluginCommand
+{
+public:
+    MatrixPluginCommand() { }
+    explicit MatrixPluginCommand(const MatrixPluginCommand& rhs);
+    virtual ~MatrixPluginCommand(){}
+    void deallocate() override;
+
+protected:
+    const char* checkPluginPreconditions() const noexcept override;
+
+private:
+    void executeImpl() noexcept override;
+
+    // drops the result and returns the operands to the stack
+    void undoImpl() noexcept override;
+
+    MatrixPluginCommand* clonePluginImpl() const noexcept override;
+    virtual MatrixPluginCommand* doClone() const = 0;
+
+    // number of matrices the command consumes
+    virtual size_t nOperands() const { return 1; }
+
+    // true if the result is pushed as a plain number rather than as a matrix
+    virtual bool scalarResult() const { return false; }
+
+    // computes the result from the operands, deepest first; returns an error
+    // message instead if the operands are unsuitable
+    virtual const char* compute(const vector<Matrix>& operands, Matrix& result) const = 0;
+
+    const char* prepare() const;
+
+    // stack order, bottom first, including the dimensions
+    mutable vector<double> operands_;
+    mutable vector<double> result_;
+};
+
+void MatrixPluginCommand::deallocate()
+{
+    delete this;
+}
+
+MatrixPluginCommand::MatrixPluginCommand(const MatrixPluginCommand& rhs)
+: PluginCommand(rhs)
+{
+}
+
+const char* MatrixPluginCommand::checkPluginPreconditions() const noexcept
+{
+    try
+    {
+        return prepare();
+    }
+    catch(std::bad_alloc&)
+    {
+        return "Not enough memory for matrix operation";
+    }
+    catch(...)
+    {
+        return "Matrix operation failed";
+    }
+}
+
+const char* MatrixPluginCommand::prepare() const
+{
+    const size_t size{ StackSize() };
+
+    // walk down the stack from the top to find each operand's shape
+    vector<size_t> rows;
+    vector<size_t> cols;
+    size_t depth{0};
+    vector<double> top;
+    for(size_t i = 0; i < nOperands(); ++i)
+    {
+        if(size < depth + 2)
+            return "Stack must have a matrix: its entries, then rows, then columns";
+
+        top.resize(depth + 2);
+        StackPeekElements(top.size(), top.data());
+        double r{ top[0] };
+        double c{ top[1] };
+        if( !(r >= 1.0 && c >= 1.0) || r != std::floor(r) || c != std::floor(c) )
+            return "Matrix dimensions must be positive integers";
+
+        size_t available{ size - depth - 2 };
+        if( r > available || c > available || r * c > available )
+            return "Stack has fewer entries than the matrix dimensions require";
+
+        rows.push_back( static_cast<size_t>(r) );
+        cols.push_back( static_cast<size_t>(c) );
+        depth += 2 + rows.back() * cols.back();
+    }
+
+    operands_.resize(depth);
+    StackPeekElements(operands_.size(), operands_.data());
+
+    vector<Matrix> matrices;
+    const double* p{ operands_.data() };
+    for(size_t i = nOperands(); i-- > 0; )
+    {
+        matrices.emplace_back(rows[i], cols[i], p);
+        p += rows[i] * cols[i] + 2;
+    }
+
+    Matrix result;
+    const char* error{ compute(matrices, result) };
+    if(error) return error;
+
+    if( scalarResult() )
+    {
+        result_.assign(1, result(0, 0));
+    }
+    else
+    {
+        result_.assign(result.data(), result.data() + result.size());
+        result_.push_back( result.rows() );
+        result_.push_back( result.cols() );
+    }
+
+    return nullptr;
+}
+
+void MatrixPluginCommand::executeImpl() noexcept
+{
+    StackPopElements(operands_.size(), operands_.data(), true);
+    StackPushElements(result_.data(), result_.size(), false);
+
+    return;
+}
+
+void MatrixPluginCommand::undoImpl() noexcept
+{
+    StackPopElements(result_.size(), result_.data(), true);
+    StackPushElements(operands_.data(), operands_.size(), false);
+
+    // a redo recomputes both from the stack
+    vector<double>{}.swap(operands_);
+    vector<double>{}.swap(result_);
+
+    return;
+}
+
+MatrixPluginCommand* MatrixPluginCommand::clonePluginImpl() const noexcept
+{
+    MatrixPluginCommand* p;
+    try
+    {
+        p = doClone();
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+// multiplies the two matrices on top of the stack, next times top
+// precondition: the columns of next equal the rows of top
+class MatrixMultiply : public MatrixPluginCommand
+{
+public:
+    MatrixMultiply() { }
+    explicit MatrixMultiply(const MatrixMultiply&);
+    ~MatrixMultiply();
+
+private:
+    MatrixMultiply(MatrixMultiply&&) = delete;
+    MatrixMultiply& operator=(const MatrixMultiply&) = delete;
+    MatrixMultiply& operator=(MatrixMultiply&&) = delete;
+
+    size_t nOperands() const override { return 2; }
+    const char* compute(const vector<Matrix>& operands, Matrix& result) const override;
+
+    MatrixMultiply* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+MatrixMultiply::MatrixMultiply(const MatrixMultiply& rhs)
+: MatrixPluginCommand{rhs}
+{ }
+
+MatrixMultiply::~MatrixMultiply()
+{ }
+
+const char* MatrixMultiply::compute(const vector<Matrix>& operands, Matrix& result) const
+{
+    if( operands[0].cols() != operands[1].rows() )
+        return "Matrix dimensions do not agree";
+
+    result = Multiply(operands[0], operands[1]);
+
+    return nullptr;
+}
+
+MatrixMultiply* MatrixMultiply::doClone() const
+{
+    return new MatrixMultiply{*this};
+}
+
+const char* MatrixMultiply::helpMessageImpl() const noexcept
+{
+    return "Replace the top two matrices on the stack, A, B, with their product AB. Note, B is top of stack";
+}
+
+// transposes the matrix on top of the stack
+class MatrixTranspose : public MatrixPluginCommand
+{
+public:
+    MatrixTranspose() { }
+    explicit MatrixTranspose(const MatrixTranspose&);
+    ~MatrixTranspose();
+
+private:
+    MatrixTranspose(MatrixTranspose&&) = delete;
+    MatrixTranspose& operator=(const MatrixTranspose&) = delete;
+    MatrixTranspose& operator=(MatrixTranspose&&) = delete;
+
+    const char* compute(const vector<Matrix>& operands, Matrix& result) const override;
+
+    MatrixTranspose* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+MatrixTranspose::MatrixTranspose(const MatrixTranspose& rhs)
+: MatrixPluginCommand{rhs}
+{ }
+
+MatrixTranspose::~MatrixTranspose()
+{ }
+
+const char* MatrixTranspose::compute(const vector<Matrix>& operands, Matrix& result) const
+{
+    result = Transpose(operands[0]);
+
+    return nullptr;
+}
+
+MatrixTranspose* MatrixTranspose::doClone() const
+{
+    return new MatrixTranspose{*this};
+}
+
+const char* MatrixTranspose::helpMessageImpl() const noexcept
+{
+    return "Replace the matrix on top of the stack with its transpose";
+}
+
+// solves A X = B for X where B is the top matrix and A the next
+// preconditions: A is square and nonsingular
+//                the rows of B equal the order of A
+class MatrixSolve : public MatrixPluginCommand
+{
+public:
+    MatrixSolve() { }
+    explicit MatrixSolve(const MatrixSolve&);
+    ~MatrixSolve();
+
+private:
+    MatrixSolve(MatrixSolve&&) = delete;
+    MatrixSolve& operator=(const MatrixSolve&) = delete;
+    MatrixSolve& operator=(MatrixSolve&&) = delete;
+
+    size_t nOperands() const override { return 2; }
+    const char* compute(const vector<Matrix>& operands, Matrix& result) const override;
+
+    MatrixSolve* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+MatrixSolve::MatrixSolve(const MatrixSolve& rhs)
+: MatrixPluginCommand{rhs}
+{ }
+
+MatrixSolve::~MatrixSolve()
+{ }
+
+const char* MatrixSolve::compute(const vector<Matrix>& operands, Matrix& result) const
+{
+    const Matrix& A = operands[0];
+    const Matrix& B = operands[1];
+    if( A.rows() != A.cols() )
+        return "Matrix must be square";
+    if( B.rows() != A.rows() )
+        return "Matrix dimensions do not agree";
+
+    LuDecomposition lu{A};
+    if( lu.singular() )
+        return "Matrix is singular";
+
+    result = lu.solve(B);
+
+    return nullptr;
+}
+
+MatrixSolve* MatrixSolve::doClone() const
+{
+    return new MatrixSolve{*this};
+}
+
+const char* MatrixSolve::helpMessageImpl() const noexcept
+{
+    return "Replace the top two matrices on the stack, A, B, with the solution X of AX = B. Note, B is top of stack";
+}
+
+// determinant of the matrix on top of the stack
+// precondition: the matrix is square
+class MatrixDeterminant : public MatrixPluginCommand
+{
+public:
+    MatrixDeterminant() { }
+    explicit MatrixDeterminant(const MatrixDeterminant&);
+    ~MatrixDeterminant();
+
+private:
+    MatrixDeterminant(MatrixDeterminant&&) = delete;
+    MatrixDeterminant& operator=(const MatrixDeterminant&) = delete;
+    MatrixDeterminant& operator=(MatrixDeterminant&&) = delete;
+
+    bool scalarResult() const override { return true; }
+    const char* compute(const vector<Matrix>& operands, Matrix& result) const override;
+
+    MatrixDeterminant* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+MatrixDeterminant::MatrixDeterminant(const MatrixDeterminant& rhs)
+: MatrixPluginCommand{rhs}
+{ }
+
+MatrixDeterminant::~MatrixDeterminant()
+{ }
+
+const char* MatrixDeterminant::compute(const vector<Matrix>& operands, Matrix& result) const
+{
+    const Matrix& A = operands[0];
+    if( A.rows() != A.cols() )
+        return "Matrix must be square";
+
+    result = Matrix{1, 1};
+    result(0, 0) = LuDecomposition{A}.determinant();
+
+    return nullptr;
+}
+
+MatrixDeterminant* MatrixDeterminant::doClone() const
+{
+    return new MatrixDeterminant{*this};
+}
+
+const char* MatrixDeterminant::helpMessageImpl() const noexcept
+{
+    return "Replace the matrix on top of the stack with its determinant";
+}
+
+// inverse of the matrix on top of the stack
+// preconditions: the matrix is square and nonsingular
+class MatrixInverse : public MatrixPluginCommand
+{
+public:
+    MatrixInverse() { }
+    explicit MatrixInverse(const MatrixInverse&);
+    ~MatrixInverse();
+
+private:
+    MatrixInverse(MatrixInverse&&) = delete;
+    MatrixInverse& operator=(const MatrixInverse&) = delete;
+    MatrixInverse& operator=(MatrixInverse&&) = delete;
+
+    const char* compute(const vector<Matrix>& operands, Matrix& result) const override;
+
+    MatrixInverse* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+MatrixInverse::MatrixInverse(const MatrixInverse& rhs)
+: MatrixPluginCommand{rhs}
+{ }
+
+MatrixInverse::~MatrixInverse()
+{ }
+
+const char* MatrixInverse::compute(const vector<Matrix>& operands, Matrix& result) const
+{
+    const Matrix& A = operands[0];
+    if( A.rows() != A.cols() )
+        return "Matrix must be square";
+
+    LuDecomposition lu{A};
+    if( lu.singular() )
+        return "Matrix is singular";
+
+    result = lu.inverse();
+
+    return nullptr;
+}
+
+MatrixInverse* MatrixInverse::doClone() const
+{
+    return new MatrixInverse{*this};
+}
+
+const char* MatrixInverse::helpMessageImpl() const noexcept
+{
+    return "Replace the matrix on top of the stack with its inverse";
+}
+
+// The double buffering of the PluginDescriptor is to maintain exception safety by
+// keeping all memory allocation in RAII containers (see HyperbolicLnPlugin).
+class MatrixPlugin::MatrixPluginImpl
+{
+public:
+    MatrixPluginImpl();
+    ~MatrixPluginImpl();
+
+    const PluginDescriptor& getPluginDescriptor() const { return pd_; }
+
+private:
+    pdCalc::Plugin::PluginDescriptor pd_;
+    vector<pdCalc::Command*> rawCommands_;
+    vector<unique_ptr<pdCalc::Command>> commands_;
+    vector<char*> rawNames_;
+    vector<string> commandNames_;
+};
+
+MatrixPlugin::MatrixPluginImpl::MatrixPluginImpl()
+{
+    const int n = 5;
+    pd_.nCommands = n;
+    commandNames_.reserve(n);
+    commands_.reserve(n);
+
+    commandNames_.emplace_back("mmul");
+    commands_.emplace_back(new MatrixMultiply);
+
+    commandNames_.emplace_back("mtrans");
+    commands_.emplace_back(new MatrixTranspose);
+
+    commandNames_.emplace_back("msolve");
+    commands_.emplace_back(new MatrixSolve);
+
+    commandNames_.emplace_back("mdet");
+    commands_.emplace_back(new MatrixDeterminant);
+
+    commandNames_.emplace_back("minv");
+    commands_.emplace_back(new MatrixInverse);
+
+    rawNames_.resize(n);
+    rawCommands_.resize(n);
+    for(int i = 0; i < n; ++i)
+    {
+        rawCommands_[i] = commands_[i].get();
+        rawNames_[i] = &commandNames_[i][0];
+    }
+
+    pd_.commands = &rawCommands_[0];
+    pd_.commandNames = &rawNames_[0];
+}
+
+MatrixPlugin::MatrixPluginImpl::~MatrixPluginImpl()
+{ }
+
+MatrixPlugin::MatrixPlugin()
+: Plugin{}
+, pimpl_{ std::make_unique<MatrixPluginImpl>() }
+{ }
+
+MatrixPlugin::~MatrixPlugin()
+{ }
+
+const pdCalc::Plugin::PluginDescriptor& MatrixPlugin::getPluginDescriptor() const
+{
+    return pimpl_->getPluginDescriptor();
+}
+
+// matrices are entered from the command line, so no buttons are provided
+const pdCalc::Plugin::PluginButtonDescriptor* MatrixPlugin::getPluginButtonDescriptor() const
+{
+    return nullptr;
+}
+
+pdCalc::Plugin::ApiVersion MatrixPlugin::apiVersion() const
+{
+    return {1, 0};
+}
+
+#ifdef STATIC_PLUGIN
+
+void RegisterMatrixPlugin()
+{
+    pdCalc::StaticPluginRegistry::Instance().registerPlugin( "matrixPlugin",
+        []() -> void* { return new MatrixPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+}
+
+#else
+
+extern "C" void* AllocPlugin()
+{
+    return new MatrixPlugin;
+}
+
+extern "C" void DeallocPlugin(void* p)
+{
+    auto d = static_cast<pdCalc::Plugin*>(p);
+    delete d;
+}
+
+#endif
@@ -0,0 +1,51 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MATRIX_PLUGIN_H
+#define MATRIX_PLUGIN_H
+
+#include <memory>
+#include "backend/Plugin.h"
+
+// Linear algebra on matrices stored on the stack. A matrix occupies its entries in
+// row major order followed by its number of rows and then its number of columns.
+// The commands are mmul, mtrans, msolve, mdet, and minv; each replaces its matrix
+// operands with the result as a single undoable operation.
+class MatrixPlugin : public pdCalc::Plugin
+{
+    class MatrixPluginImpl;
+public:
+    MatrixPlugin();
+    ~MatrixPlugin();
+
+    const PluginDescriptor& getPluginDescriptor() const override;
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override;
+    pdCalc::Plugin::ApiVersion apiVersion() const override;
+
+private:
+    std::unique_ptr<MatrixPluginImpl> pimpl_;
+};
+
+extern "C" void* AllocPlugin();
+extern "C" void DeallocPlugin(void*);
+
+// registers the plugin with pdCalc::StaticPluginRegistry, in place of the above when
+// the plugin is linked into pdCalc
+void RegisterMatrixPlugin();
+
+#endif
@@ -1,3 +1,9 @@
 TEMPLATE = subdirs
 
-SUBDIRS += hyperbolicLnPlugin
+# each plugin can instead be linked into pdCalc; see STATIC_PLUGINS in common.pri
+
+SUBDIRS += hyperbolicLnPlugin \
+           statisticsPlugin \
+           matrixPlugin \
+           fftPlugin \
+           randomPlugin
@@ -0,0 +1,232 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "RandomKernels.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/VectorMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::vector;
+
+namespace RandomKernels {
+
+namespace {
+
+// blocks per chunk of a parallel fill; below this the thread pool is not worth
+// waking
+const size_t MinChunkBlocks = 16;
+
+const uint64_t Gamma = 0x9E3779B97F4A7C15ULL;
+
+// the bits of 1.0; an output shifted under them is a double in [1, 2)
+const uint64_t OneBits = 0x3FF0000000000000ULL;
+
+const double TwoPi = 6.28318530717958647692;
+
+uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// the first m uniforms of a block
+void uniformBlock(uint64_t seed, uint64_t block, double* x, size_t m)
+{
+    uint64_t s[Streams][4];
+    for(unsigned i = 0; i < Streams; ++i)
+        SeedStream(seed, block, i, s[i]);
+
+    size_t j{0};
+#ifdef __SSE2__
+    // streams 0 and 1 in the a registers, 2 and 3 in the b registers
+    __m128i a0 = _mm_set_epi64x(s[1][0], s[0][0]), b0 = _mm_set_epi64x(s[3][0], s[2][0]);
+    __m128i a1 = _mm_set_epi64x(s[1][1], s[0][1]), b1 = _mm_set_epi64x(s[3][1], s[2][1]);
+    __m128i a2 = _mm_set_epi64x(s[1][2], s[0][2]), b2 = _mm_set_epi64x(s[3][2], s[2][2]);
+    __m128i a3 = _mm_set_epi64x(s[1][3], s[0][3]), b3 = _mm_set_epi64x(s[3][3], s[2][3]);
+    const __m128i oneBits = _mm_set1_epi64x(OneBits);
+    const __m128d one = _mm_set1_pd(1.0);
+
+    auto rotlv = [](__m128i v, int k) { return _mm_or_si128( _mm_slli_epi64(v, k), _mm_srli_epi64(v, 64 - k) ); };
+    auto step = [&](__m128i& s0, __m128i& s1, __m128i& s2, __m128i& s3)
+    {
+        __m128i r = _mm_add_epi64( rotlv( _mm_add_epi64(s0, s3), 23 ), s0 );
+        __m128i t = _mm_slli_epi64(s1, 17);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = rotlv(s3, 45);
+        return _mm_sub_pd( _mm_castsi128_pd( _mm_or_si128( _mm_srli_epi64(r, 12), oneBits ) ), one );
+    };
+
+    for(; j + Streams <= m; j += Streams)
+    {
+        _mm_storeu_pd( x + j, step(a0, a1, a2, a3) );
+        _mm_storeu_pd( x + j + 2, step(b0, b1, b2, b3) );
+    }
+
+    if(j < m)
+    {
+        double tail[Streams];
+        _mm_storeu_pd( tail, step(a0, a1, a2, a3) );
+        _mm_storeu_pd( tail + 2, step(b0, b1, b2, b3) );
+        std::copy(tail, tail + (m - j), x + j);
+    }
+#else
+    for(; j < m; ++j)
+        x[j] = ToUniform( Next(s[j % Streams]) );
+#endif
+
+    return;
+}
+
+// Box-Muller on consecutive uniform pairs, through the vector math kernels; u1
+// comes in as 1 - u, in (0, 1], so that its log is finite
+void normalBlock(uint64_t seed, uint64_t block, double* x, size_t m, vector<double>& scratch)
+{
+    double u[BlockSize];
+    uniformBlock(seed, block, u, BlockSize);
+
+    const size_t half{ BlockSize / 2 };
+    scratch.resize(4 * half);
+    double* r = scratch.data();
+    double* theta = r + half;
+    double* c = theta + half;
+    double* s = c + half;
+    for(size_t i = 0; i < half; ++i)
+    {
+        r[i] = 1.0 - u[2 * i];
+        theta[i] = TwoPi * u[2 * i + 1];
+    }
+
+    pdCalc::VectorMath::Log(r, r, half);
+    pdCalc::VectorMath::Cos(theta, c, half);
+    pdCalc::VectorMath::Sin(theta, s, half);
+
+    const size_t pairs{ (m + 1) / 2 };
+    for(size_t i = 0; i < pairs; ++i)
+    {
+        double radius{ std::sqrt(-2.0 * r[i]) };
+        x[2 * i] = radius * c[i];
+        if(2 * i + 1 < m) x[2 * i + 1] = radius * s[i];
+    }
+
+    return;
+}
+
+// inversion, -log(1 - u)
+void exponentialBlock(uint64_t seed, uint64_t block, double* x, size_t m)
+{
+    uniformBlock(seed, block, x, m);
+
+    for(size_t i = 0; i < m; ++i)
+        x[i] = 1.0 - x[i];
+
+    pdCalc::VectorMath::Log(x, x, m);
+
+    // 0 - x rather than -x, so that log(1) gives 0 and not -0
+    for(size_t i = 0; i < m; ++i)
+        x[i] = 0.0 - x[i];
+
+    return;
+}
+
+}
+
+void SeedStream(uint64_t seed, uint64_t block, unsigned stream, uint64_t s[4])
+{
+    // stream k of a seed takes outputs 4 k, ..., 4 k + 3 of the seed's splitmix64
+    // sequence
+    uint64_t state{ mix(seed) + (block * Streams + stream) * 4 * Gamma };
+    for(int i = 0; i < 4; ++i)
+    {
+        state += Gamma;
+        s[i] = mix(state);
+    }
+
+    return;
+}
+
+uint64_t Next(uint64_t s[4])
+{
+    const uint64_t result{ rotl(s[0] + s[3], 23) + s[0] };
+    const uint64_t t{ s[1] << 17 };
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+double ToUniform(uint64_t x)
+{
+    uint64_t bits{ (x >> 12) | OneBits };
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+
+    return d - 1.0;
+}
+
+void Fill(Distribution distribution, uint64_t seed, uint64_t firstBlock, double* x, size_t n)
+{
+    const size_t nBlocks{ static_cast<size_t>( Blocks(n) ) };
+
+    pdCalc::ThreadPool::Instance().parallelFor(nBlocks, MinChunkBlocks, [&](size_t, size_t begin, size_t end)
+    {
+        vector<double> scratch;
+        for(size_t b = begin; b < end; ++b)
+        {
+            double* p{ x + b * BlockSize };
+            size_t m{ std::min(BlockSize, n - b * BlockSize) };
+            switch(distribution)
+            {
+            case Distribution::Uniform:
+                uniformBlock(seed, firstBlock + b, p, m);
+                break;
+            case Distribution::Normal:
+                normalBlock(seed, firstBlock + b, p, m, scratch);
+                break;
+            case Distribution::Exponential:
+                exponentialBlock(seed, firstBlock + b, p, m);
+                break;
+            }
+        }
+    });
+
+    return;
+}
+
+}
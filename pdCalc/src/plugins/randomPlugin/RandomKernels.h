@@ -0,0 +1,62 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RANDOM_KERNELS_H
+#define RANDOM_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Pseudo-random samples for the random plugin. Samples come in blocks of
+// BlockSize, and block b of a seed is generated independently of every other
+// block, so blocks can be filled in parallel and a seed reproduces the same samples
+// however many threads fill them. Each block interleaves four xoshiro256++ streams
+// (element j comes from stream j % 4) that SSE2 advances two at a time, and the
+// streams of a block are seeded from consecutive outputs of a splitmix64 sequence
+// keyed by the seed. Every ISA produces the same bits.
+namespace RandomKernels {
+
+enum class Distribution
+{
+    Uniform,     // [0, 1)
+    Normal,      // mean 0, standard deviation 1
+    Exponential  // rate 1
+};
+
+const size_t BlockSize = 2048;
+const unsigned Streams = 4;
+
+// number of blocks n samples take
+inline uint64_t Blocks(size_t n) { return (n + BlockSize - 1) / BlockSize; }
+
+// fills x[0, n) from blocks firstBlock, firstBlock + 1, ..., Blocks(n) blocks in
+// all, using the thread pool for large n; a partial last block uses its first
+// samples
+void Fill(Distribution, uint64_t seed, uint64_t firstBlock, double* x, size_t n);
+
+// the generator itself, for tests: the starting state of a stream of a block, and
+// one xoshiro256++ step
+void SeedStream(uint64_t seed, uint64_t block, unsigned stream, uint64_t s[4]);
+uint64_t Next(uint64_t s[4]);
+
+// a uniform [0, 1) double from the top 52 bits of a generator output
+double ToUniform(uint64_t);
+
+}
+
+#endif
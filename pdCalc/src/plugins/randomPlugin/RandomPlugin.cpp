@@ -0,0 +1,375 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "RandomPlugin.h"
+#include "RandomKernels.h"
+#include "backend/Command.h"
+#include "backend/StackPluginInterface.h"
+#include "backend/StaticPluginRegistry.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <new>
+
+using std::vector;
+using std::string;
+using std::unique_ptr;
+using RandomKernels::Distribution;
+
+namespace {
+
+// The generator is its seed and the next block the samples come from. Commands
+// record the position they started from so that undo can rewind to it, which makes
+// a redo, or the next command after an undo, draw the same samples again.
+struct Generator
+{
+    uint64_t seed;
+    uint64_t nextBlock;
+};
+
+Generator& TheGenerator()
+{
+    static Generator generator{ (uint64_t{std::random_device{}()} << 32) ^ std::random_device{}(), 0 };
+    return generator;
+}
+
+// seeds are integers a double holds exactly
+const double MaxSeed = 9007199254740992.0;
+
+}
+
+// Draws n samples from one distribution. As in the fft plugin, the samples are
+// generated while checking the preconditions, where running out of memory can
+// still be reported as an error, and execute only moves them onto the stack.
+class SampleCommand : public pdCalc::PluginCommand
+{
+public:
+    SampleCommand(Distribution, const char* help);
+    explicit SampleCommand(const SampleCommand& rhs);
+    ~SampleCommand();
+    void deallocate() override;
+
+private:
+    SampleCommand(SampleCommand&&) = delete;
+    SampleCommand& operator=(const SampleCommand&) = delete;
+    SampleCommand& operator=(SampleCommand&&) = delete;
+
+    const char* checkPluginPreconditions() const noexcept override;
+    void executeImpl() noexcept override;
+
+    // drops the samples, returns the count to the stack, and rewinds the generator
+    void undoImpl() noexcept override;
+
+    SampleCommand* clonePluginImpl() const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
+
+    Distribution distribution_;
+    const char* help_;
+
+    mutable double count_;
+    mutable uint64_t firstBlock_;
+    mutable vector<double> samples_;
+};
+
+SampleCommand::SampleCommand(Distribution d, const char* help)
+: distribution_{d}
+, help_{help}
+, count_{0}
+, firstBlock_{0}
+{ }
+
+SampleCommand::SampleCommand(const SampleCommand& rhs)
+: PluginCommand(rhs)
+, distribution_{rhs.distribution_}
+, help_{rhs.help_}
+, count_{0}
+, firstBlock_{0}
+{ }
+
+SampleCommand::~SampleCommand()
+{ }
+
+void SampleCommand::deallocate()
+{
+    delete this;
+}
+
+const char* SampleCommand::checkPluginPreconditions() const noexcept
+{
+    if(StackSize() < 1)
+        return "Stack must have a count on top";
+
+    double n{ StackFirstElement() };
+    if( !(n >= 1.0) || n != std::floor(n) || n > MaxSeed )
+        return "Count must be a positive integer";
+
+    try
+    {
+        const Generator& g = TheGenerator();
+        samples_.resize( static_cast<size_t>(n) );
+        RandomKernels::Fill(distribution_, g.seed, g.nextBlock, samples_.data(), samples_.size());
+        count_ = n;
+        firstBlock_ = g.nextBlock;
+    }
+    catch(std::bad_alloc&)
+    {
+        vector<double>{}.swap(samples_);
+        return "Not enough memory for samples";
+    }
+    catch(...)
+    {
+        return "Sampling failed";
+    }
+
+    return nullptr;
+}
+
+void SampleCommand::executeImpl() noexcept
+{
+    StackPop(true);
+    StackPushElements(samples_.data(), samples_.size(), false);
+    TheGenerator().nextBlock = firstBlock_ + RandomKernels::Blocks( samples_.size() );
+
+    return;
+}
+
+void SampleCommand::undoImpl() noexcept
+{
+    StackPopElements(samples_.size(), samples_.data(), true);
+    StackPush(count_, false);
+    TheGenerator().nextBlock = firstBlock_;
+
+    // a redo draws them again
+    vector<double>{}.swap(samples_);
+
+    return;
+}
+
+SampleCommand* SampleCommand::clonePluginImpl() const noexcept
+{
+    SampleCommand* p;
+    try
+    {
+        p = new SampleCommand{*this};
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+const char* SampleCommand::helpMessageImpl() const noexcept
+{
+    return help_;
+}
+
+// replaces the generator's seed and starts its sequence over
+class SeedCommand : public pdCalc::PluginCommand
+{
+public:
+    SeedCommand() { }
+    explicit SeedCommand(const SeedCommand& rhs);
+    ~SeedCommand();
+    void deallocate() override;
+
+private:
+    SeedCommand(SeedCommand&&) = delete;
+    SeedCommand& operator=(const SeedCommand&) = delete;
+    SeedCommand& operator=(SeedCommand&&) = delete;
+
+    const char* checkPluginPreconditions() const noexcept override;
+    void executeImpl() noexcept override;
+
+    // returns the seed to the stack and the generator to where it was
+    void undoImpl() noexcept override;
+
+    SeedCommand* clonePluginImpl() const noexcept override;
+    const char* helpMessageImpl() const noexcept override;
+
+    double seed_ = 0;
+    Generator previous_ = {0, 0};
+};
+
+SeedCommand::SeedCommand(const SeedCommand& rhs)
+: PluginCommand(rhs)
+{ }
+
+SeedCommand::~SeedCommand()
+{ }
+
+void SeedCommand::deallocate()
+{
+    delete this;
+}
+
+const char* SeedCommand::checkPluginPreconditions() const noexcept
+{
+    if(StackSize() < 1)
+        return "Stack must have one element";
+
+    double s{ StackFirstElement() };
+    if( !(s >= 0.0) || s != std::floor(s) || s > MaxSeed )
+        return "Seed must be a nonnegative integer no greater than 2^53";
+
+    return nullptr;
+}
+
+void SeedCommand::executeImpl() noexcept
+{
+    seed_ = StackPop(false);
+    previous_ = TheGenerator();
+    TheGenerator() = Generator{ static_cast<uint64_t>(seed_), 0 };
+
+    return;
+}
+
+void SeedCommand::undoImpl() noexcept
+{
+    TheGenerator() = previous_;
+    StackPush(seed_, false);
+
+    return;
+}
+
+SeedCommand* SeedCommand::clonePluginImpl() const noexcept
+{
+    SeedCommand* p;
+    try
+    {
+        p = new SeedCommand{*this};
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+const char* SeedCommand::helpMessageImpl() const noexcept
+{
+    return "Seed the random number generator with the nonnegative integer on top of the stack";
+}
+
+// The double buffering of the PluginDescriptor is to maintain exception safety by
+// keeping all memory allocation in RAII containers (see HyperbolicLnPlugin).
+class RandomPlugin::RandomPluginImpl
+{
+public:
+    RandomPluginImpl();
+    ~RandomPluginImpl();
+
+    const PluginDescriptor& getPluginDescriptor() const { return pd_; }
+
+private:
+    pdCalc::Plugin::PluginDescriptor pd_;
+    vector<pdCalc::Command*> rawCommands_;
+    vector<unique_ptr<pdCalc::Command>> commands_;
+    vector<char*> rawNames_;
+    vector<string> commandNames_;
+};
+
+RandomPlugin::RandomPluginImpl::RandomPluginImpl()
+{
+    const int n = 4;
+    pd_.nCommands = n;
+    commandNames_.reserve(n);
+    commands_.reserve(n);
+
+    commandNames_.emplace_back("rand");
+    commands_.emplace_back(new SampleCommand{Distribution::Uniform,
+        "Replace the count n on top of the stack with n samples uniform on [0, 1)"});
+
+    commandNames_.emplace_back("randn");
+    commands_.emplace_back(new SampleCommand{Distribution::Normal,
+        "Replace the count n on top of the stack with n standard normal samples"});
+
+    commandNames_.emplace_back("rande");
+    commands_.emplace_back(new SampleCommand{Distribution::Exponential,
+        "Replace the count n on top of the stack with n exponential samples of rate 1"});
+
+    commandNames_.emplace_back("seed");
+    commands_.emplace_back(new SeedCommand);
+
+    rawNames_.resize(n);
+    rawCommands_.resize(n);
+    for(int i = 0; i < n; ++i)
+    {
+        rawCommands_[i] = commands_[i].get();
+        rawNames_[i] = &commandNames_[i][0];
+    }
+
+    pd_.commands = &rawCommands_[0];
+    pd_.commandNames = &rawNames_[0];
+}
+
+RandomPlugin::RandomPluginImpl::~RandomPluginImpl()
+{ }
+
+RandomPlugin::RandomPlugin()
+: Plugin{}
+, pimpl_{ std::make_unique<RandomPluginImpl>() }
+{ }
+
+RandomPlugin::~RandomPlugin()
+{ }
+
+const pdCalc::Plugin::PluginDescriptor& RandomPlugin::getPluginDescriptor() const
+{
+    return pimpl_->getPluginDescriptor();
+}
+
+// counts are entered from the command line, so no buttons are provided
+const pdCalc::Plugin::PluginButtonDescriptor* RandomPlugin::getPluginButtonDescriptor() const
+{
+    return nullptr;
+}
+
+pdCalc::Plugin::ApiVersion RandomPlugin::apiVersion() const
+{
+    return {1, 0};
+}
+
+#ifdef STATIC_PLUGIN
+
+void RegisterRandomPlugin()
+{
+    pdCalc::StaticPluginRegistry::Instance().registerPlugin( "randomPlugin",
+        []() -> void* { return new RandomPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+}
+
+#else
+
+extern "C" void* AllocPlugin()
+{
+    return new RandomPlugin;
+}
+
+extern "C" void DeallocPlugin(void* p)
+{
+    auto d = static_cast<pdCalc::Plugin*>(p);
+    delete d;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RANDOM_PLUGIN_H
+#define RANDOM_PLUGIN_H
+
+#include <memory>
+#include "backend/Plugin.h"
+
+// Pseudo-random samples for Monte Carlo work. The commands rand, randn, and rande
+// replace a count n on the top of the stack with n samples from the uniform [0, 1),
+// standard normal, and unit rate exponential distributions, as a single undoable
+// operation. seed replaces the generator's seed with the integer on the top of the
+// stack; after it, the same commands produce the same samples. The generator is
+// seeded from the system at load.
+class RandomPlugin : public pdCalc::Plugin
+{
+    class RandomPluginImpl;
+public:
+    RandomPlugin();
+    ~RandomPlugin();
+
+    const PluginDescriptor& getPluginDescriptor() const override;
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override;
+    pdCalc::Plugin::ApiVersion apiVersion() const override;
+
+private:
+    std::unique_ptr<RandomPluginImpl> pimpl_;
+};
+
+extern "C" void* AllocPlugin();
+extern "C" void DeallocPlugin(void*);
+
+// registers the plugin with pdCalc::StaticPluginRegistry, in place of the above when
+// the plugin is linked into pdCalc
+void RegisterRandomPlugin();
+
+#endif
@@ -0,0 +1,27 @@
+HOME = ../../..
+include ($$HOME/common.pri)
+TEMPLATE = lib
+TARGET = randomPlugin
+DEPENDPATH += .
+INCLUDEPATH += . $$HOME/src
+unix:DESTDIR = $$HOME/lib
+win32:DESTDIR = $$HOME/bin
+
+# linked into pdCalc rather than loaded from a library of its own (see common.pri)
+contains(STATIC_PLUGINS, randomPlugin) {
+    CONFIG += staticlib ltcg
+    DEFINES += STATIC_PLUGIN
+}
+
+QT -= gui core
+
+# Input
+HEADERS += RandomPlugin.h \
+    RandomKernels.h
+SOURCES += RandomPlugin.cpp \
+    RandomKernels.cpp
+
+unix:QMAKE_PRE_LINK+=$(COPY_FILE) $$PWD/../plugins.pdp.unix $$HOME/bin/plugins.pdp
+win32:QMAKE_PRE_LINK+=$(COPY_FILE) $$shell_path($$PWD/../plugins.pdp.win) $$shell_path($$HOME/bin/plugins.pdp)
+
+win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1 -lpdCalcBackend1
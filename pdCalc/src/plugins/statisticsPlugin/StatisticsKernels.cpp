@@ -0,0 +1,292 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StatisticsKernels.h"
+#include "utilities/ThreadPool.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cmath>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::vector;
+
+namespace StatisticsKernels {
+
+namespace {
+
+// arrays this short are summed directly; longer arrays are split in half
+const size_t BlockSize = 256;
+
+// Neumaier's variant of Kahan summation, used to combine per thread results
+double compensatedSum(const vector<double>& v)
+{
+    double sum{0};
+    double c{0};
+    for(auto x : v)
+    {
+        double t{ sum + x };
+        if( std::fabs(sum) >= std::fabs(x) ) c += (sum - t) + x;
+        else c += (x - t) + sum;
+        sum = t;
+    }
+
+    return sum + c;
+}
+
+double blockSum(const double* x, size_t n)
+{
+    size_t i{0};
+    double r{0};
+#ifdef __SSE2__
+    __m128d a0 = _mm_setzero_pd();
+    __m128d a1 = _mm_setzero_pd();
+    __m128d a2 = _mm_setzero_pd();
+    __m128d a3 = _mm_setzero_pd();
+    for(; i + 8 <= n; i += 8)
+    {
+        a0 = _mm_add_pd( a0, _mm_loadu_pd(x + i) );
+        a1 = _mm_add_pd( a1, _mm_loadu_pd(x + i + 2) );
+        a2 = _mm_add_pd( a2, _mm_loadu_pd(x + i + 4) );
+        a3 = _mm_add_pd( a3, _mm_loadu_pd(x + i + 6) );
+    }
+    __m128d s = _mm_add_pd( _mm_add_pd(a0, a1), _mm_add_pd(a2, a3) );
+    double lanes[2];
+    _mm_storeu_pd(lanes, s);
+    r = lanes[0] + lanes[1];
+#else
+    double a[4] = {0, 0, 0, 0};
+    for(; i + 4 <= n; i += 4)
+    {
+        a[0] += x[i];
+        a[1] += x[i + 1];
+        a[2] += x[i + 2];
+        a[3] += x[i + 3];
+    }
+    r = (a[0] + a[1]) + (a[2] + a[3]);
+#endif
+    for(; i < n; ++i)
+        r += x[i];
+
+    return r;
+}
+
+double pairwiseSum(const double* x, size_t n)
+{
+    if(n <= BlockSize) return blockSum(x, n);
+
+    size_t half{ n / 2 };
+    return pairwiseSum(x, half) + pairwiseSum(x + half, n - half);
+}
+
+// sums of (x - m)^2 and of (x - m); the latter is zero in exact arithmetic and
+// corrects the rounding error in the mean
+struct Deviations
+{
+    double squares;
+    double linear;
+};
+
+Deviations blockDeviations(const double* x, size_t n, double m)
+{
+    size_t i{0};
+    Deviations r{0, 0};
+#ifdef __SSE2__
+    const __m128d mv = _mm_set1_pd(m);
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128d l0 = _mm_setzero_pd();
+    __m128d l1 = _mm_setzero_pd();
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128d d0 = _mm_sub_pd( _mm_loadu_pd(x + i), mv );
+        __m128d d1 = _mm_sub_pd( _mm_loadu_pd(x + i + 2), mv );
+        s0 = _mm_add_pd( s0, _mm_mul_pd(d0, d0) );
+        s1 = _mm_add_pd( s1, _mm_mul_pd(d1, d1) );
+        l0 = _mm_add_pd(l0, d0);
+        l1 = _mm_add_pd(l1, d1);
+    }
+    double lanes[2];
+    _mm_storeu_pd( lanes, _mm_add_pd(s0, s1) );
+    r.squares = lanes[0] + lanes[1];
+    _mm_storeu_pd( lanes, _mm_add_pd(l0, l1) );
+    r.linear = lanes[0] + lanes[1];
+#endif
+    for(; i < n; ++i)
+    {
+        double d{ x[i] - m };
+        r.squares += d * d;
+        r.linear += d;
+    }
+
+    return r;
+}
+
+Deviations pairwiseDeviations(const double* x, size_t n, double m)
+{
+    if(n <= BlockSize) return blockDeviations(x, n, m);
+
+    size_t half{ n / 2 };
+    Deviations a{ pairwiseDeviations(x, half, m) };
+    Deviations b{ pairwiseDeviations(x + half, n - half, m) };
+
+    return { a.squares + b.squares, a.linear + b.linear };
+}
+
+// Compare is std::less for minimum and std::greater for maximum; the SIMD
+// operation must match it
+template<typename Compare>
+double extremum(const double* x, size_t n, double init, Compare better)
+{
+    size_t i{0};
+    double r{init};
+#ifdef __SSE2__
+    const bool isMin{ better(0.0, 1.0) };
+    __m128d a0 = _mm_set1_pd(init);
+    __m128d a1 = _mm_set1_pd(init);
+    // with a NaN in either operand, min/max return the second operand, so keeping
+    // the accumulator second skips NaNs
+    if(isMin)
+    {
+        for(; i + 4 <= n; i += 4)
+        {
+            a0 = _mm_min_pd( _mm_loadu_pd(x + i), a0 );
+            a1 = _mm_min_pd( _mm_loadu_pd(x + i + 2), a1 );
+        }
+    }
+    else
+    {
+        for(; i + 4 <= n; i += 4)
+        {
+            a0 = _mm_max_pd( _mm_loadu_pd(x + i), a0 );
+            a1 = _mm_max_pd( _mm_loadu_pd(x + i + 2), a1 );
+        }
+    }
+    double lanes[4];
+    _mm_storeu_pd(lanes, a0);
+    _mm_storeu_pd(lanes + 2, a1);
+    for(auto v : lanes)
+        if( better(v, r) ) r = v;
+#endif
+    for(; i < n; ++i)
+        if( better(x[i], r) ) r = x[i];
+
+    return r;
+}
+
+// runs kernel(x + begin, end - begin) on the thread pool and returns each chunk's result
+template<typename Kernel>
+auto parallelPartials(const double* x, size_t n, Kernel kernel) -> vector<decltype(kernel(x, n))>
+{
+    auto& pool = pdCalc::ThreadPool::Instance();
+    const size_t minChunk{ ParallelThreshold / 2 };
+    vector<decltype(kernel(x, n))> partials( pool.nChunks(n, minChunk) );
+
+    pool.parallelFor(n, minChunk, [&](size_t chunk, size_t begin, size_t end)
+    {
+        partials[chunk] = kernel(x + begin, end - begin);
+    });
+
+    return partials;
+}
+
+}
+
+double Sum(const double* x, size_t n)
+{
+    if(n < ParallelThreshold) return pairwiseSum(x, n);
+
+    return compensatedSum( parallelPartials(x, n, pairwiseSum) );
+}
+
+double Mean(const double* x, size_t n)
+{
+    return n > 0 ? Sum(x, n) / n : 0.0;
+}
+
+double Variance(const double* x, size_t n)
+{
+    if(n < 2) return 0.0;
+
+    double m{ Mean(x, n) };
+    Deviations d;
+    if(n < ParallelThreshold)
+    {
+        d = pairwiseDeviations(x, n, m);
+    }
+    else
+    {
+        auto partials = parallelPartials(x, n, [m](const double* p, size_t k){ return pairwiseDeviations(p, k, m); });
+        vector<double> squares;
+        vector<double> linear;
+        for(const auto& i : partials)
+        {
+            squares.push_back(i.squares);
+            linear.push_back(i.linear);
+        }
+        d.squares = compensatedSum(squares);
+        d.linear = compensatedSum(linear);
+    }
+
+    return ( d.squares - d.linear * d.linear / n ) / (n - 1);
+}
+
+double Min(const double* x, size_t n)
+{
+    const double init{ std::numeric_limits<double>::infinity() };
+    auto kernel = [init](const double* p, size_t k){ return extremum(p, k, init, std::less<double>{}); };
+    if(n < ParallelThreshold) return kernel(x, n);
+
+    auto partials = parallelPartials(x, n, kernel);
+    return kernel( partials.data(), partials.size() );
+}
+
+double Max(const double* x, size_t n)
+{
+    const double init{ -std::numeric_limits<double>::infinity() };
+    auto kernel = [init](const double* p, size_t k){ return extremum(p, k, init, std::greater<double>{}); };
+    if(n < ParallelThreshold) return kernel(x, n);
+
+    auto partials = parallelPartials(x, n, kernel);
+    return kernel( partials.data(), partials.size() );
+}
+
+double Percentile(double* x, size_t n, double p)
+{
+    double h{ (n - 1) * p / 100.0 };
+    size_t lo{ static_cast<size_t>( std::floor(h) ) };
+    if(lo >= n - 1) return *std::max_element(x, x + n);
+
+    std::nth_element(x, x + lo, x + n);
+    double v{ x[lo] };
+    double frac{ h - lo };
+    if(frac > 0)
+    {
+        // everything after position lo is at least x[lo]; the next rank is their minimum
+        double next{ *std::min_element(x + lo + 1, x + n) };
+        v += frac * (next - v);
+    }
+
+    return v;
+}
+
+}
@@ -0,0 +1,52 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATISTICS_KERNELS_H
+#define STATISTICS_KERNELS_H
+
+#include <cstddef>
+
+// Reductions over contiguous arrays of doubles used by the statistics plugin.
+// Sums are computed pairwise over SSE2 blocks, which bounds the rounding error by
+// O(log n) ulps instead of the O(n) of a running sum. Arrays of at least
+// ParallelThreshold elements are split across the program's ThreadPool, and the
+// per thread partial results are combined with compensated (Neumaier) summation.
+namespace StatisticsKernels {
+
+const size_t ParallelThreshold = size_t{1} << 16;
+
+double Sum(const double* x, size_t n);
+
+double Mean(const double* x, size_t n);
+
+// sample variance (n - 1 denominator) by the corrected two pass algorithm
+// precondition: n >= 2
+double Variance(const double* x, size_t n);
+
+// NaN elements are ignored
+double Min(const double* x, size_t n);
+double Max(const double* x, size_t n);
+
+// percentile p in [0, 100], interpolating linearly between the closest ranks (so
+// p = 50 is the median); partially reorders x
+// precondition: n >= 1
+double Percentile(double* x, size_t n, double p);
+
+}
+
+#endif
@@ -0,0 +1,599 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StatisticsPlugin.h"
+#include "StatisticsKernels.h"
+#include "backend/Command.h"
+#include "backend/StackPluginInterface.h"
+#include "backend/StaticPluginRegistry.h"
+#include <cmath>
+#include <vector>
+#include <string>
+#include <memory>
+
+using std::vector;
+using std::string;
+using std::unique_ptr;
+
+// Base class for the statistics commands. A command either reduces the entire
+// stack or, in its TopN form, the n elements below a count n on the top of the
+// stack. Commands with a parameter (the percentile) take it from the stack as well:
+// from the top for the whole stack form and from just below the count for the TopN
+// form. All operands are removed with one bulk pop and restored with one bulk push,
+// so a reduction is a single undo entry regardless of its size.
+class StatisticsPluginCommand : public pdCalc::PluginCommand
+{
+public:
+    enum class Range { WholeStack, TopN };
+
+    explicit StatisticsPluginCommand(Range r) : range_{r} { }
+    explicit StatisticsPluginCommand(const StatisticsPluginCommand& rhs);
+    virtual ~StatisticsPluginCommand(){}
+    void deallocate() override;
+
+protected:
+    Range range() const { return range_; }
+    const char* checkPluginPreconditions() const noexcept override;
+
+private:
+    void executeImpl() noexcept override;
+
+    // drops the result and returns all of the operands to the stack
+    void undoImpl() noexcept override;
+
+    StatisticsPluginCommand* clonePluginImpl() const noexcept override;
+    virtual StatisticsPluginCommand* doClone() const = 0;
+
+    // number of values besides the data and the count that the command takes from the stack
+    virtual size_t nParameters() const { return 0; }
+
+    // smallest number of data elements for which the statistic is defined
+    virtual size_t minElements() const { return 1; }
+
+    // returns an error message if the parameter is invalid
+    virtual const char* checkParameter(double) const noexcept { return nullptr; }
+
+    virtual double reduce(const double* x, size_t n, double parameter) const = 0;
+
+    // number of stack elements above the data
+    size_t nHeader() const { return nParameters() + (range_ == Range::TopN ? 1 : 0); }
+
+    Range range_;
+
+    // operands in stack order, bottom first: the data, then the parameter, then the count
+    vector<double> operands_;
+};
+
+void StatisticsPluginCommand::deallocate()
+{
+    delete this;
+}
+
+StatisticsPluginCommand::StatisticsPluginCommand(const StatisticsPluginCommand& rhs)
+: PluginCommand(rhs)
+, range_(rhs.range_)
+{
+}
+
+const char* StatisticsPluginCommand::checkPluginPreconditions() const noexcept
+{
+    size_t size{ StackSize() };
+    size_t header{ nHeader() };
+    if(size < header)
+        return range_ == Range::TopN ? "Stack must have a count on top" : "Stack must have a percentile on top";
+
+    size_t n;
+    if(range_ == Range::TopN)
+    {
+        double count{ StackFirstElement() };
+        if( !(count >= 1.0) || count != std::floor(count) )
+            return "Count must be a positive integer";
+
+        if(count > size - header)
+            return "Stack has fewer elements than the count";
+
+        n = static_cast<size_t>(count);
+    }
+    else n = size - header;
+
+    if(n < minElements())
+        return minElements() == 1 ? "Statistic needs at least one element" : "Statistic needs at least two elements";
+
+    if( nParameters() > 0 )
+        return checkParameter( range_ == Range::TopN ? StackSecondElement() : StackFirstElement() );
+
+    return nullptr;
+}
+
+void StatisticsPluginCommand::executeImpl() noexcept
+{
+    size_t header{ nHeader() };
+    size_t n{ range_ == Range::TopN ? static_cast<size_t>( StackFirstElement() ) : StackSize() - header };
+
+    operands_.resize(n + header);
+    StackPopElements(operands_.size(), operands_.data(), true);
+
+    double parameter{ nParameters() > 0 ? operands_[n] : 0.0 };
+    StackPush( reduce(operands_.data(), n, parameter), false );
+
+    return;
+}
+
+void StatisticsPluginCommand::undoImpl() noexcept
+{
+    StackPop(true);
+    StackPushElements(operands_.data(), operands_.size(), false);
+
+    // a redo pops the operands again, so there is no reason to hold on to them
+    vector<double>{}.swap(operands_);
+
+    return;
+}
+
+StatisticsPluginCommand* StatisticsPluginCommand::clonePluginImpl() const noexcept
+{
+    StatisticsPluginCommand* p;
+    try
+    {
+        p = doClone();
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+
+    return p;
+}
+
+// sums the elements
+class Sum : public StatisticsPluginCommand
+{
+public:
+    explicit Sum(Range r) : StatisticsPluginCommand{r} { }
+    explicit Sum(const Sum&);
+    ~Sum();
+
+private:
+    Sum(Sum&&) = delete;
+    Sum& operator=(const Sum&) = delete;
+    Sum& operator=(Sum&&) = delete;
+
+    double reduce(const double* x, size_t n, double) const override;
+
+    Sum* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Sum::Sum(const Sum& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Sum::~Sum()
+{ }
+
+double Sum::reduce(const double* x, size_t n, double) const
+{
+    return StatisticsKernels::Sum(x, n);
+}
+
+Sum* Sum::doClone() const
+{
+    return new Sum{*this};
+}
+
+const char* Sum::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their sum" :
+        "Replace the top n elements on the stack with their sum. Note, n is top of stack";
+}
+
+// averages the elements
+class Mean : public StatisticsPluginCommand
+{
+public:
+    explicit Mean(Range r) : StatisticsPluginCommand{r} { }
+    explicit Mean(const Mean&);
+    ~Mean();
+
+private:
+    Mean(Mean&&) = delete;
+    Mean& operator=(const Mean&) = delete;
+    Mean& operator=(Mean&&) = delete;
+
+    double reduce(const double* x, size_t n, double) const override;
+
+    Mean* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Mean::Mean(const Mean& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Mean::~Mean()
+{ }
+
+double Mean::reduce(const double* x, size_t n, double) const
+{
+    return StatisticsKernels::Mean(x, n);
+}
+
+Mean* Mean::doClone() const
+{
+    return new Mean{*this};
+}
+
+const char* Mean::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their mean" :
+        "Replace the top n elements on the stack with their mean. Note, n is top of stack";
+}
+
+// sample variance of the elements
+// precondition: at least two elements
+class Variance : public StatisticsPluginCommand
+{
+public:
+    explicit Variance(Range r) : StatisticsPluginCommand{r} { }
+    explicit Variance(const Variance&);
+    ~Variance();
+
+private:
+    Variance(Variance&&) = delete;
+    Variance& operator=(const Variance&) = delete;
+    Variance& operator=(Variance&&) = delete;
+
+    size_t minElements() const override { return 2; }
+    double reduce(const double* x, size_t n, double) const override;
+
+    Variance* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Variance::Variance(const Variance& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Variance::~Variance()
+{ }
+
+double Variance::reduce(const double* x, size_t n, double) const
+{
+    return StatisticsKernels::Variance(x, n);
+}
+
+Variance* Variance::doClone() const
+{
+    return new Variance{*this};
+}
+
+const char* Variance::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their sample variance" :
+        "Replace the top n elements on the stack with their sample variance. Note, n is top of stack";
+}
+
+// smallest element
+class Minimum : public StatisticsPluginCommand
+{
+public:
+    explicit Minimum(Range r) : StatisticsPluginCommand{r} { }
+    explicit Minimum(const Minimum&);
+    ~Minimum();
+
+private:
+    Minimum(Minimum&&) = delete;
+    Minimum& operator=(const Minimum&) = delete;
+    Minimum& operator=(Minimum&&) = delete;
+
+    double reduce(const double* x, size_t n, double) const override;
+
+    Minimum* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Minimum::Minimum(const Minimum& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Minimum::~Minimum()
+{ }
+
+double Minimum::reduce(const double* x, size_t n, double) const
+{
+    return StatisticsKernels::Min(x, n);
+}
+
+Minimum* Minimum::doClone() const
+{
+    return new Minimum{*this};
+}
+
+const char* Minimum::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their minimum" :
+        "Replace the top n elements on the stack with their minimum. Note, n is top of stack";
+}
+
+// largest element
+class Maximum : public StatisticsPluginCommand
+{
+public:
+    explicit Maximum(Range r) : StatisticsPluginCommand{r} { }
+    explicit Maximum(const Maximum&);
+    ~Maximum();
+
+private:
+    Maximum(Maximum&&) = delete;
+    Maximum& operator=(const Maximum&) = delete;
+    Maximum& operator=(Maximum&&) = delete;
+
+    double reduce(const double* x, size_t n, double) const override;
+
+    Maximum* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Maximum::Maximum(const Maximum& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Maximum::~Maximum()
+{ }
+
+double Maximum::reduce(const double* x, size_t n, double) const
+{
+    return StatisticsKernels::Max(x, n);
+}
+
+Maximum* Maximum::doClone() const
+{
+    return new Maximum{*this};
+}
+
+const char* Maximum::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their maximum" :
+        "Replace the top n elements on the stack with their maximum. Note, n is top of stack";
+}
+
+// median of the elements; the mean of the two middle elements for an even count
+class Median : public StatisticsPluginCommand
+{
+public:
+    explicit Median(Range r) : StatisticsPluginCommand{r} { }
+    explicit Median(const Median&);
+    ~Median();
+
+private:
+    Median(Median&&) = delete;
+    Median& operator=(const Median&) = delete;
+    Median& operator=(Median&&) = delete;
+
+    double reduce(const double* x, size_t n, double) const override;
+
+    Median* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Median::Median(const Median& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Median::~Median()
+{ }
+
+double Median::reduce(const double* x, size_t n, double) const
+{
+    // the operands are kept in stack order for undo, so select on a copy
+    vector<double> scratch(x, x + n);
+    return StatisticsKernels::Percentile(scratch.data(), n, 50.0);
+}
+
+Median* Median::doClone() const
+{
+    return new Median{*this};
+}
+
+const char* Median::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their median" :
+        "Replace the top n elements on the stack with their median. Note, n is top of stack";
+}
+
+// percentile p of the elements, interpolating linearly between closest ranks
+// preconditions: p is on the stack above the elements
+//                0 <= p <= 100
+class Percentile : public StatisticsPluginCommand
+{
+public:
+    explicit Percentile(Range r) : StatisticsPluginCommand{r} { }
+    explicit Percentile(const Percentile&);
+    ~Percentile();
+
+private:
+    Percentile(Percentile&&) = delete;
+    Percentile& operator=(const Percentile&) = delete;
+    Percentile& operator=(Percentile&&) = delete;
+
+    size_t nParameters() const override { return 1; }
+    const char* checkParameter(double p) const noexcept override;
+    double reduce(const double* x, size_t n, double p) const override;
+
+    Percentile* doClone() const override;
+
+    const char* helpMessageImpl() const noexcept override;
+};
+
+Percentile::Percentile(const Percentile& rhs)
+: StatisticsPluginCommand{rhs}
+{ }
+
+Percentile::~Percentile()
+{ }
+
+const char* Percentile::checkParameter(double p) const noexcept
+{
+    if( !(p >= 0.0 && p <= 100.0) )
+        return "Percentile must be between 0 and 100";
+
+    return nullptr;
+}
+
+double Percentile::reduce(const double* x, size_t n, double p) const
+{
+    vector<double> scratch(x, x + n);
+    return StatisticsKernels::Percentile(scratch.data(), n, p);
+}
+
+Percentile* Percentile::doClone() const
+{
+    return new Percentile{*this};
+}
+
+const char* Percentile::helpMessageImpl() const noexcept
+{
+    return range() == Range::WholeStack ?
+        "Replace all elements on the stack with their pth percentile. Note, p is top of stack" :
+        "Replace the top n elements on the stack with their pth percentile. Note, n is top of stack and p is next";
+}
+
+// The double buffering of the PluginDescriptor is to maintain exception safety by
+// keeping all memory allocation in RAII containers (see HyperbolicLnPlugin).
+class StatisticsPlugin::StatisticsPluginImpl
+{
+public:
+    StatisticsPluginImpl();
+    ~StatisticsPluginImpl();
+
+    const PluginDescriptor& getPluginDescriptor() const { return pd_; }
+
+private:
+    template<typename T>
+    void addCommand(const char* name);
+
+    pdCalc::Plugin::PluginDescriptor pd_;
+    vector<pdCalc::Command*> rawCommands_;
+    vector<unique_ptr<pdCalc::Command>> commands_;
+    vector<char*> rawNames_;
+    vector<string> commandNames_;
+};
+
+// adds both the whole stack form, name, and the top n form, name followed by n
+template<typename T>
+void StatisticsPlugin::StatisticsPluginImpl::addCommand(const char* name)
+{
+    commandNames_.emplace_back(name);
+    commands_.emplace_back( new T{StatisticsPluginCommand::Range::WholeStack} );
+
+    commandNames_.emplace_back( string{name} + "n" );
+    commands_.emplace_back( new T{StatisticsPluginCommand::Range::TopN} );
+
+    return;
+}
+
+StatisticsPlugin::StatisticsPluginImpl::StatisticsPluginImpl()
+{
+    const int n = 14;
+    pd_.nCommands = n;
+    commandNames_.reserve(n);
+    commands_.reserve(n);
+
+    addCommand<Sum>("sum");
+    addCommand<Mean>("mean");
+    addCommand<Variance>("var");
+    addCommand<Minimum>("min");
+    addCommand<Maximum>("max");
+    addCommand<Median>("median");
+    addCommand<Percentile>("pctl");
+
+    rawNames_.resize(n);
+    rawCommands_.resize(n);
+    for(int i = 0; i < n; ++i)
+    {
+        rawCommands_[i] = commands_[i].get();
+        rawNames_[i] = &commandNames_[i][0];
+    }
+
+    pd_.commands = &rawCommands_[0];
+    pd_.commandNames = &rawNames_[0];
+}
+
+StatisticsPlugin::StatisticsPluginImpl::~StatisticsPluginImpl()
+{ }
+
+StatisticsPlugin::StatisticsPlugin()
+: Plugin{}
+, pimpl_{ std::make_unique<StatisticsPluginImpl>() }
+{ }
+
+StatisticsPlugin::~StatisticsPlugin()
+{ }
+
+const pdCalc::Plugin::PluginDescriptor& StatisticsPlugin::getPluginDescriptor() const
+{
+    return pimpl_->getPluginDescriptor();
+}
+
+// the reductions have no natural place among the calculator's buttons, so they
+// are available from the command line only
+const pdCalc::Plugin::PluginButtonDescriptor* StatisticsPlugin::getPluginButtonDescriptor() const
+{
+    return nullptr;
+}
+
+pdCalc::Plugin::ApiVersion StatisticsPlugin::apiVersion() const
+{
+    return {1, 0};
+}
+
+#ifdef STATIC_PLUGIN
+
+void RegisterStatisticsPlugin()
+{
+    pdCalc::StaticPluginRegistry::Instance().registerPlugin( "statisticsPlugin",
+        []() -> void* { return new StatisticsPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+}
+
+#else
+
+extern "C" void* AllocPlugin()
+{
+    return new StatisticsPlugin;
+}
+
+extern "C" void DeallocPlugin(void* p)
+{
+    auto d = static_cast<pdCalc::Plugin*>(p);
+    delete d;
+}
+
+#endif
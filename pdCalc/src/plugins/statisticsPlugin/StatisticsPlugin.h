@@ -0,0 +1,52 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATISTICS_PLUGIN_H
+#define STATISTICS_PLUGIN_H
+
+#include <memory>
+#include "backend/Plugin.h"
+
+// Reductions over many stack elements at once: sum, mean, var, min, max, median,
+// and pctl operate on the entire stack, while sumn, meann, varn, minn, maxn,
+// mediann, and pctln operate on the n elements below a count n on the top of the
+// stack. Each reduction, no matter how many elements it consumes, is a single
+// undoable operation.
+class StatisticsPlugin : public pdCalc::Plugin
+{
+    class StatisticsPluginImpl;
+public:
+    StatisticsPlugin();
+    ~StatisticsPlugin();
+
+    const PluginDescriptor& getPluginDescriptor() const override;
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override;
+    pdCalc::Plugin::ApiVersion apiVersion() const override;
+
+private:
+    std::unique_ptr<StatisticsPluginImpl> pimpl_;
+};
+
+extern "C" void* AllocPlugin();
+extern "C" void DeallocPlugin(void*);
+
+// registers the plugin with pdCalc::StaticPluginRegistry, in place of the above when
+// the plugin is linked into pdCalc
+void RegisterStatisticsPlugin();
+
+#endif
@@ -0,0 +1,27 @@
+HOME = ../../..
+include ($$HOME/common.pri)
+TEMPLATE = lib
+TARGET = statisticsPlugin
+DEPENDPATH += .
+INCLUDEPATH += . $$HOME/src
+unix:DESTDIR = $$HOME/lib
+win32:DESTDIR = $$HOME/bin
+
+# linked into pdCalc rather than loaded from a library of its own (see common.pri)
+contains(STATIC_PLUGINS, statisticsPlugin) {
+    CONFIG += staticlib ltcg
+    DEFINES += STATIC_PLUGIN
+}
+
+QT -= gui core
+
+# Input
+HEADERS += StatisticsPlugin.h \
+    StatisticsKernels.h
+SOURCES += StatisticsPlugin.cpp \
+    StatisticsKernels.cpp
+
+unix:QMAKE_PRE_LINK+=$(COPY_FILE) $$PWD/../plugins.pdp.unix $$HOME/bin/plugins.pdp
+win32:QMAKE_PRE_LINK+=$(COPY_FILE) $$shell_path($$PWD/../plugins.pdp.win) $$shell_path($$HOME/bin/plugins.pdp)
+
+win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1 -lpdCalcBackend1
@@ -4,5 +4,5 @@ SUBDIRS += utilities \
            backend \
            ui/cli \
            ui/gui \
-           app \
-           plugins
+           plugins \
+           app
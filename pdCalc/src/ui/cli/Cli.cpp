@@ -19,6 +19,9 @@
 #include "Cli.h"
 #include "utilities/Tokenizer.h"
 #include "backend/Stack.h"
+#include "utilities/BigNumber.h"
+#include <algorithm>
+#include <mutex>
 #include <vector>
 #include <sstream>
 
@@ -28,6 +31,8 @@ using std::istream;
 using std::ostream;
 using std::endl;
 using std::ostringstream;
+using std::mutex;
+using std::lock_guard;
 
 namespace pdCalc {
 
@@ -38,24 +43,46 @@ public:
     void postMessage(const string& m);
     void execute(bool suppressStartupMessage, bool echo);
     void stackChanged();
+    void stackChangedBy(const StackChange& change);
 
 private:
     void startupMessage();
 
+    // the element at depth below the top of the stack as the stack is shown; in
+    // exact mode, those with an exact value show all of its digits
+    string formatElement(size_t depth) const;
+
+    // posts the stack from view_
+    void showStack();
+
     Cli& parent_;
     istream& in_;
     ostream& out_;
+
+    // held for each write to out_, since plugin reloads are posted from the
+    // watcher's thread
+    mutex outMutex_;
+
+    // the top elements of the stack, top first, as shown, and the change they reflect
+    vector<string> view_;
+    uint64_t generation_;
+
+    static const size_t NElements = 4;
 };
 
+const size_t Cli::CliImpl::NElements;
+
 Cli::CliImpl::CliImpl(Cli& p, istream& in, ostream& out)
 : parent_(p)
 , in_(in)
 , out_(out)
+, generation_{UnknownGeneration}
 {
 }
 
 void Cli::CliImpl::postMessage(const string& m)
 {
+    lock_guard<mutex> lock{outMutex_};
     out_ << m << endl;
     return;
 }
@@ -71,14 +98,18 @@ void Cli::CliImpl::startupMessage()
 
 void Cli::CliImpl::execute(bool suppressStartupMessage, bool echo)
 {
-    if(!suppressStartupMessage) startupMessage();
+    if(!suppressStartupMessage)
+    {
+        lock_guard<mutex> lock{outMutex_};
+        startupMessage();
+    }
 
     for(string line; std::getline(in_, line, '\n'); )
     {
         Tokenizer tokenizer{line};
         for(const auto& i : tokenizer)
         {
-            if(echo) out_ << i << endl;
+            if(echo) postMessage(i);
             if(i == "exit" || i == "quit")
             {
                 return;
@@ -93,33 +124,56 @@ void Cli::CliImpl::execute(bool suppressStartupMessage, bool echo)
     return;
 }
 
-void Cli::CliImpl::stackChanged()
+string Cli::CliImpl::formatElement(size_t depth) const
 {
-    unsigned int nElements{4};
-    auto v = Stack::Instance().getElements(nElements);
+    const Stack& stack = Stack::Instance();
+    const size_t i{ stack.size() - 1 - depth };
+
     ostringstream oss;
     oss.precision(12);
+    if( stack.precision() > 0 && !stack.exactElements().empty() && stack.exactElements()[i] ) oss << stack.exactElements()[i]->toString();
+    else oss << stack.elements()[i];
+
+    return oss.str();
+}
+
+void Cli::CliImpl::showStack()
+{
+    ostringstream oss;
     size_t size = Stack::Instance().size();
     oss << "\n";
     if(size == 0)
         oss << "Stack currently empty.\n";
     else if(size == 1)
         oss << "Top element of stack (size = " << size << "):\n";
-    else if(size > 1 && size <= nElements)
+    else if(size > 1 && size <= NElements)
         oss << "Top " << size << " elements of stack (size = " << size << "):\n";
     else
-        oss << "Top " << nElements << " elements of stack (size = " << size << "):\n";
+        oss << "Top " << NElements << " elements of stack (size = " << size << "):\n";
 
-    size_t j{ v.size() };
-    for(auto i = v.rbegin(); i != v.rend(); ++i)
-    {
-        oss << j << ":\t" << *i << "\n";
-        --j;
-    }
+    for(size_t j = view_.size(); j > 0; --j)
+        oss << j << ":\t" << view_[j - 1] << "\n";
 
     postMessage( oss.str() );
 }
 
+void Cli::CliImpl::stackChanged()
+{
+    view_.clear();
+    for(size_t depth = 0; depth < std::min(Stack::Instance().size(), NElements); ++depth)
+        view_.push_back( formatElement(depth) );
+    generation_ = UnknownGeneration;
+
+    showStack();
+}
+
+void Cli::CliImpl::stackChangedBy(const StackChange& change)
+{
+    ApplyStackChange(change, view_, NElements, generation_, [this](size_t depth){ return formatElement(depth); });
+
+    showStack();
+}
+
 Cli::Cli(istream& in, ostream& out)
 {
     pimpl_ = std::make_unique<CliImpl>(*this, in, out);
@@ -140,6 +194,12 @@ void Cli::stackChanged()
     return;
 }
 
+void Cli::stackChangedBy(const StackChange& change)
+{
+    pimpl_->stackChangedBy(change);
+    return;
+}
+
 void Cli::execute(bool suppressStartupMessage, bool echo)
 {
     pimpl_->execute(suppressStartupMessage, echo);
@@ -37,12 +37,15 @@ public:
     void execute(bool suppressStartupMessage = false, bool echo = false);
 
 private:
-    // posts a text message to the output
+    // posts a text message to the output; may be called from any thread
     void postMessage(const std::string& m) override;
 
     // updates the output when the stack is changed
     void stackChanged() override;
 
+    // the same, formatting only the elements that change brought into view
+    void stackChangedBy(const StackChange& change) override;
+
     Cli(const Cli&) = delete;
     Cli(Cli&&) = delete;
     Cli& operator=(const Cli&) = delete;
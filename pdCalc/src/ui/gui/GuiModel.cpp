@@ -17,6 +17,7 @@
 // along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
 
 #include "GuiModel.h"
+#include "utilities/StackChange.h"
 #include <string>
 #include <utility>
 #include <iostream>
@@ -33,6 +34,7 @@ public:
     explicit GuiModelImpl(GuiModel& p);
     void onShift();
     void stackChanged(const std::vector<double>& v);
+    void stackChangedBy(const StackChange& change, size_t nLines, const std::function<double(size_t)>& element);
     const GuiModel::State& getState() const { return state_; }
 
     void onCharacterEntered(char c);
@@ -52,11 +54,15 @@ private:
     GuiModel& parent_;
     GuiModel::State state_;
     QDoubleValidator validator_;
+
+    // the change state_.curStack reflects
+    uint64_t generation_;
 };
 
 GuiModel::GuiModelImpl::GuiModelImpl(GuiModel& p)
 : parent_{p}
 , state_{}
+, generation_{UnknownGeneration}
 {
     validator_.setNotation(QDoubleValidator::ScientificNotation);
 }
@@ -72,6 +78,14 @@ void GuiModel::GuiModelImpl::onShift()
 void GuiModel::GuiModelImpl::stackChanged(const vector<double>& v)
 {
     state_.curStack = v;
+    generation_ = UnknownGeneration;
+
+    emit parent_.modelChanged();
+}
+
+void GuiModel::GuiModelImpl::stackChangedBy(const StackChange& change, size_t nLines, const std::function<double(size_t)>& element)
+{
+    ApplyStackChange(change, state_.curStack, nLines, generation_, element);
 
     emit parent_.modelChanged();
 }
@@ -280,6 +294,13 @@ void GuiModel::stackChanged(const vector<double>& v)
     return;
 }
 
+void GuiModel::stackChangedBy(const StackChange& change, size_t nLines, const std::function<double(size_t)>& element)
+{
+    pimpl_->stackChangedBy(change, nLines, element);
+
+    return;
+}
+
 const GuiModel::State& GuiModel::getState() const
 {
     return pimpl_->getState();
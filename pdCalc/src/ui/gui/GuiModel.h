@@ -23,10 +23,13 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <functional>
 #include <QDoubleValidator>
 
 namespace pdCalc {
 
+struct StackChange;
+
 class GuiModel : public QObject
 {
     class GuiModelImpl;
@@ -49,6 +52,10 @@ public:
 
     void stackChanged(const std::vector<double>& v);
 
+    // updates curStack, which holds at most nLines elements, in place for change,
+    // taking the elements it brought into view from element (see ApplyStackChange)
+    void stackChangedBy(const StackChange& change, size_t nLines, const std::function<double(size_t depth)>& element);
+
     const State& getState() const;
 
     // exposed externally for testing only
@@ -29,6 +29,14 @@
 #include "StoredProcedureDialog.h"
 #include <sstream>
 #include "GuiModel.h"
+#include "backend/CommandWorker.h"
+#include "utilities/StackChange.h"
+#include <mutex>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
 
 using std::ostringstream;
 using std::cout;
@@ -38,6 +46,12 @@ using std::vector;
 
 namespace pdCalc {
 
+// Stack changes and messages arrive on whichever thread runs the commands, the
+// worker's when there is one. That thread keeps the view of the top of the stack up
+// to date and leaves it for the next frame, with the messages and the changes since
+// the last frame, folded into one. The event loop draws a frame at most once per
+// FrameMilliseconds however fast the changes come, and hands the folded change to
+// the model, which updates its view in place.
 class MainWindow::MainWindowImpl : public QWidget
 {
     Q_OBJECT
@@ -45,8 +59,11 @@ public:
     explicit MainWindowImpl(MainWindow* parent);
     void showMessage(const string& m);
     void stackChanged();
+    void stackChangedBy(const StackChange& change);
     void setupFinalButtons();
     void addCommandButton(const std::string& dispPrimaryCmd, const std::string& primaryCmd, const std::string& dispShftCmd, const std::string& shftCmd);
+    void setCommandWorker(CommandWorker* worker) { worker_ = worker; }
+    const GuiModel& guiModel() const { return *guiModel_; }
 
 public slots:
     void onCommandEntered(std::string cmd);
@@ -54,22 +71,62 @@ public slots:
 
 private slots:
     void onProcedure();
+    void onFrame();
+    void onProgress();
+    void onCancel();
 
 private:
     void connectInputToModel();
     void doLayout();
+    void publishStack(const StackChange* change);
+    void requestFrame();
+
+    static const int FrameMilliseconds = 16;
+
+    // entries that finish sooner never show as running
+    static const int ProgressDelayMilliseconds = 200;
 
     MainWindow& parent_;
     int nLinesStack_;
     Display* display_;
     InputWidget* inputWidget_;
     GuiModel* guiModel_;
+    QProgressBar* progressBar_;
+    QPushButton* cancelButton_;
+    QTimer* progressTimer_;
+    QElapsedTimer lastFrame_;
+    QElapsedTimer running_;
+    CommandWorker* worker_;
+
+    // owned by the thread running commands
+    vector<double> view_;
+    uint64_t generation_;
+
+    // left by that thread for the next frame; the change is the changes since the
+    // last frame, unless the view was rebuilt, in which case the model is too
+    std::mutex mutex_;
+    vector<double> pendingStack_;
+    bool stackPending_;
+    StackChange pendingChange_;
+    bool rebuildPending_;
+    vector<string> pendingMessages_;
+    bool framePosted_;
+
+    // the frames drawn from a change, which number the changes given the model
+    uint64_t frames_;
 };
 
 MainWindow::MainWindowImpl::MainWindowImpl(MainWindow* parent)
 : QWidget{parent}
 , parent_(*parent)
 , nLinesStack_{6}
+, worker_{nullptr}
+, generation_{UnknownGeneration}
+, stackPending_{false}
+, pendingChange_{}
+, rebuildPending_{false}
+, framePosted_{false}
+, frames_{0}
 {
     guiModel_ = new GuiModel{this};
     display_ = new Display{*guiModel_, this, nLinesStack_};
@@ -78,6 +135,20 @@ MainWindow::MainWindowImpl::MainWindowImpl(MainWindow* parent)
 
     inputWidget_ = new InputWidget{this};
 
+    progressBar_ = new QProgressBar{this};
+    progressBar_->setRange(0, 1);
+    progressBar_->setValue(0);
+    progressBar_->setTextVisible(false);
+
+    cancelButton_ = new QPushButton{"Cancel", this};
+    cancelButton_->setFont( LookAndFeel::Instance().getButtonFont() );
+    cancelButton_->setEnabled(false);
+
+    progressTimer_ = new QTimer{this};
+    progressTimer_->setInterval(FrameMilliseconds);
+
+    lastFrame_.start();
+
     doLayout();
 
     connectInputToModel();
@@ -87,21 +158,146 @@ void MainWindow::MainWindowImpl::doLayout()
 {
     auto vblayout = new QVBoxLayout{this};
     vblayout->addWidget(display_);
+
+    auto progressLayout = new QHBoxLayout;
+    progressLayout->addWidget(progressBar_);
+    progressLayout->addWidget(cancelButton_);
+    vblayout->addLayout(progressLayout);
+
     vblayout->addWidget(inputWidget_);
     vblayout->addStretch();
 }
 
 void MainWindow::MainWindowImpl::showMessage(const string& m)
 {
-    display_->showMessage(m);
+    std::lock_guard<std::mutex> lock{mutex_};
+    pendingMessages_.push_back(m);
+    requestFrame();
 
     return;
 }
 
 void MainWindow::MainWindowImpl::stackChanged()
 {
-    auto v = Stack::Instance().getElements(nLinesStack_);
-    guiModel_->stackChanged(v);
+    view_ = Stack::Instance().getElements(nLinesStack_);
+    generation_ = UnknownGeneration;
+    publishStack(nullptr);
+
+    return;
+}
+
+// a change that does not follow the last one rebuilds the view, and the model's
+void MainWindow::MainWindowImpl::stackChangedBy(const StackChange& change)
+{
+    const bool follows{ generation_ != UnknownGeneration && change.generation == generation_ + 1 };
+    ApplyStackChange(change, view_, nLinesStack_, generation_, [](size_t depth)
+    {
+        const auto& elements = Stack::Instance().elements();
+        return elements[elements.size() - 1 - depth];
+    });
+    publishStack(follows ? &change : nullptr);
+
+    return;
+}
+
+// change is null when the view was rebuilt
+void MainWindow::MainWindowImpl::publishStack(const StackChange* change)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    pendingStack_ = view_;
+
+    if(!change) rebuildPending_ = true;
+    else if(!rebuildPending_)
+        pendingChange_ = stackPending_ ? ComposeStackChanges(pendingChange_, *change) : *change;
+
+    stackPending_ = true;
+    requestFrame();
+
+    return;
+}
+
+// with mutex_ held; one frame is posted at a time, and it takes everything left
+// since
+void MainWindow::MainWindowImpl::requestFrame()
+{
+    if(framePosted_) return;
+
+    framePosted_ = true;
+    QMetaObject::invokeMethod(this, &MainWindowImpl::onFrame, Qt::QueuedConnection);
+
+    return;
+}
+
+void MainWindow::MainWindowImpl::onFrame()
+{
+    const qint64 elapsed{ lastFrame_.elapsed() };
+    if(elapsed < FrameMilliseconds)
+    {
+        QTimer::singleShot(FrameMilliseconds - elapsed, this, &MainWindowImpl::onFrame);
+        return;
+    }
+
+    vector<double> stack;
+    bool stackChanged;
+    StackChange change;
+    bool rebuild;
+    vector<string> messages;
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stack.swap(pendingStack_);
+        stackChanged = stackPending_;
+        change = pendingChange_;
+        rebuild = rebuildPending_;
+        messages.swap(pendingMessages_);
+        stackPending_ = false;
+        rebuildPending_ = false;
+        framePosted_ = false;
+    }
+
+    // the model takes what a change brought into view from the frame's view
+    if(stackChanged && rebuild) guiModel_->stackChanged(stack);
+    else if(stackChanged)
+    {
+        change.generation = ++frames_;
+        guiModel_->stackChangedBy(change, nLinesStack_, [&stack](size_t depth){ return stack[depth]; });
+    }
+    for(const auto& m : messages)
+        display_->showMessage(m);
+
+    lastFrame_.restart();
+
+    return;
+}
+
+// the worker's progress is polled once a frame while it is busy
+void MainWindow::MainWindowImpl::onProgress()
+{
+    if( !worker_ || !worker_->busy() )
+    {
+        progressTimer_->stop();
+        progressBar_->setRange(0, 1);
+        progressBar_->setValue(0);
+        progressBar_->setTextVisible(false);
+        cancelButton_->setEnabled(false);
+    }
+    else if(running_.elapsed() >= ProgressDelayMilliseconds)
+    {
+        // how far a procedure has to go is not known, so the bar only shows that
+        // it is moving
+        progressBar_->setRange(0, 0);
+        progressBar_->setFormat( QString{"%1 steps"}.arg( static_cast<qulonglong>( worker_->progress() ) ) );
+        progressBar_->setTextVisible(true);
+        cancelButton_->setEnabled(true);
+    }
+
+    return;
+}
+
+void MainWindow::MainWindowImpl::onCancel()
+{
+    if(!worker_) return;
+
+    worker_->cancel();
 
     return;
 }
@@ -130,6 +326,8 @@ void MainWindow::MainWindowImpl::connectInputToModel()
     connect(inputWidget_, SIGNAL(shiftPressed()), guiModel_, SLOT(onShift()));
     connect(guiModel_, SIGNAL(commandEntered(std::string)), this, SLOT(onCommandEntered(std::string)));
     connect(guiModel_, SIGNAL(errorDetected(std::string)), this, SLOT(onShowMessage(std::string)));
+    connect(progressTimer_, SIGNAL(timeout()), this, SLOT(onProgress()));
+    connect(cancelButton_, SIGNAL(clicked()), this, SLOT(onCancel()));
 
     return;
 }
@@ -151,12 +349,18 @@ void MainWindow::MainWindowImpl::onCommandEntered(std::string cmd)
 {
     parent_.UserInterface::raise(UserInterface::CommandEntered, std::make_shared<CommandData>(cmd));
 
+    if( worker_ && !progressTimer_->isActive() )
+    {
+        running_.start();
+        progressTimer_->start();
+    }
+
     return;
 }
 
 void MainWindow::MainWindowImpl::onShowMessage(std::string m)
 {
-    showMessage(m);
+    display_->showMessage(m);
 }
 
 MainWindow::MainWindow(int, char*[], QWidget* parent)
@@ -178,12 +382,29 @@ void MainWindow::stackChanged()
     pimpl_->stackChanged();
 }
 
+void MainWindow::stackChangedBy(const StackChange& change)
+{
+    pimpl_->stackChangedBy(change);
+}
+
 void MainWindow::addCommandButton(const string& dispPrimaryCmd, const string& primaryCmd,
 const string& dispShftCmd, const string& shftCmd)
 {
     pimpl_->addCommandButton(dispPrimaryCmd, primaryCmd, dispShftCmd, shftCmd);
 }
 
+void MainWindow::setCommandWorker(CommandWorker* worker)
+{
+    pimpl_->setCommandWorker(worker);
+
+    return;
+}
+
+const GuiModel& MainWindow::guiModel() const
+{
+    return pimpl_->guiModel();
+}
+
 void MainWindow::setupFinalButtons()
 {
     pimpl_->setupFinalButtons();
@@ -26,6 +26,8 @@
 namespace pdCalc {
 
 class CommandButton;
+class CommandWorker;
+class GuiModel;
 
 class MainWindow : public QMainWindow, public UserInterface
 {
@@ -35,6 +37,7 @@ public:
 
     void postMessage(const std::string& m) override;
     void stackChanged() override;
+    void stackChangedBy(const StackChange& change) override;
 
     // Add a command button, for example, from a plugin
     // Buttons are added in order from left to right just below the
@@ -42,12 +45,20 @@ public:
     // Buttons are reparented to MainWindow
     void addCommandButton(const std::string& dispPrimaryCmd, const std::string& primaryCmd, const std::string& dispShftCmd, const std::string& shftCmd);
 
+    // Commands entered are run by worker, if there is one, while the window shows
+    // their progress and offers to cancel them. The window takes its stack changes
+    // and messages from any thread and draws them in its own.
+    void setCommandWorker(CommandWorker* worker);
+
     // setup the undo, redo, proc buttons after inserting plugin buttons
     void setupFinalButtons();
 
     // force the window to be fixed size...should be called as a final step once the GUI has fixed its own size
     void fixSize();
 
+    // exposed externally for testing only
+    const GuiModel& guiModel() const;
+
 private:
     MainWindowImpl* pimpl_;
 };
@@ -0,0 +1,1202 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "BigNumber.h"
+#include "Exception.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+
+using std::vector;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+using std::int64_t;
+
+namespace pdCalc {
+
+namespace {
+
+using Limb = BigInteger::Limb;
+using Limbs = vector<Limb>;
+
+const uint64_t Base = BigInteger::Base;
+
+// operand sizes, in limbs of nine digits, at which the asymptotically faster
+// algorithms take over (see the BigNumber benchmarks)
+const size_t KaratsubaThreshold = 40;
+const size_t NttThreshold = 1500;
+const size_t NewtonThreshold = 400;
+
+const Limb Pow10Table[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+    100000000, 1000000000 };
+
+void trim(Limbs& a)
+{
+    while( !a.empty() && a.back() == 0 ) a.pop_back();
+    return;
+}
+
+int compareMag(const Limb* a, size_t an, const Limb* b, size_t bn)
+{
+    while(an > 0 && a[an - 1] == 0) --an;
+    while(bn > 0 && b[bn - 1] == 0) --bn;
+    if(an != bn) return an < bn ? -1 : 1;
+    for(size_t i = an; i-- > 0; )
+        if(a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+
+    return 0;
+}
+
+int compareMag(const Limbs& a, const Limbs& b)
+{
+    return compareMag(a.data(), a.size(), b.data(), b.size());
+}
+
+// r[0, rn) += a[0, an) where rn >= an; a carry out of r is dropped
+void addInto(Limb* r, size_t rn, const Limb* a, size_t an)
+{
+    Limb carry{0};
+    size_t i{0};
+    for(; i < an; ++i)
+    {
+        Limb s{ r[i] + a[i] + carry };
+        carry = s >= Base;
+        r[i] = carry ? s - Base : s;
+    }
+    for(; carry && i < rn; ++i)
+    {
+        Limb s{ r[i] + 1 };
+        carry = s >= Base;
+        r[i] = carry ? s - Base : s;
+    }
+
+    return;
+}
+
+// r[0, rn) -= a[0, an)
+// precondition: r >= a
+void subtractFrom(Limb* r, size_t rn, const Limb* a, size_t an)
+{
+    Limb borrow{0};
+    size_t i{0};
+    for(; i < an; ++i)
+    {
+        int64_t s{ int64_t{r[i]} - a[i] - borrow };
+        borrow = s < 0;
+        r[i] = static_cast<Limb>(borrow ? s + Base : s);
+    }
+    for(; borrow && i < rn; ++i)
+    {
+        borrow = r[i] == 0;
+        r[i] = borrow ? Limb(Base - 1) : r[i] - 1;
+    }
+
+    return;
+}
+
+Limbs addMag(const Limbs& a, const Limbs& b)
+{
+    const Limbs& big = a.size() >= b.size() ? a : b;
+    const Limbs& small = a.size() >= b.size() ? b : a;
+    Limbs r(big.size() + 1, 0);
+    std::copy(big.begin(), big.end(), r.begin());
+    addInto(r.data(), r.size(), small.data(), small.size());
+    trim(r);
+
+    return r;
+}
+
+// precondition: a >= b
+Limbs subtractMag(const Limbs& a, const Limbs& b)
+{
+    Limbs r{a};
+    subtractFrom(r.data(), r.size(), b.data(), b.size());
+    trim(r);
+
+    return r;
+}
+
+Limbs multiplySmall(const Limbs& a, Limb m)
+{
+    Limbs r(a.size() + 1);
+    uint64_t carry{0};
+    for(size_t i = 0; i < a.size(); ++i)
+    {
+        uint64_t cur{ uint64_t{a[i]} * m + carry };
+        carry = cur / Base;
+        r[i] = static_cast<Limb>(cur - carry * Base);
+    }
+    r[a.size()] = static_cast<Limb>(carry);
+    trim(r);
+
+    return r;
+}
+
+Limbs divideSmall(const Limbs& a, Limb d, Limb& remainder)
+{
+    Limbs q(a.size());
+    uint64_t rem{0};
+    for(size_t i = a.size(); i-- > 0; )
+    {
+        uint64_t cur{ a[i] + rem * Base };
+        q[i] = static_cast<Limb>(cur / d);
+        rem = cur % d;
+    }
+    trim(q);
+    remainder = static_cast<Limb>(rem);
+
+    return q;
+}
+
+Limbs shiftLimbsLeft(const Limbs& a, size_t k)
+{
+    if( a.empty() ) return a;
+
+    Limbs r(k, 0);
+    r.insert(r.end(), a.begin(), a.end());
+    return r;
+}
+
+Limbs shiftLimbsRight(const Limbs& a, size_t k)
+{
+    if(k >= a.size()) return Limbs{};
+    return Limbs(a.begin() + k, a.end());
+}
+
+void multiplySchoolbook(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* r)
+{
+    std::fill(r, r + an + bn, 0);
+    for(size_t i = 0; i < an; ++i)
+    {
+        uint64_t ai{ a[i] };
+        if(ai == 0) continue;
+
+        uint64_t carry{0};
+        for(size_t j = 0; j < bn; ++j)
+        {
+            uint64_t cur{ r[i + j] + ai * b[j] + carry };
+            carry = cur / Base;
+            r[i + j] = static_cast<Limb>(cur - carry * Base);
+        }
+        r[i + bn] = static_cast<Limb>(carry);
+    }
+
+    return;
+}
+
+// Number theoretic transform modulo the prime p = 2^64 - 2^32 + 1, which has roots
+// of unity of every power of two order up to 2^32. Limbs are split into base 1000
+// digits so that no coefficient of the product can reach p.
+namespace Ntt {
+
+const uint64_t P = 0xFFFFFFFF00000001ULL;
+const uint64_t Epsilon = 0xFFFFFFFFULL; // 2^64 mod p
+const uint64_t Generator = 7;
+
+// reduces hi * 2^64 + lo using 2^64 = 2^32 - 1 and 2^96 = -1 (mod p)
+inline uint64_t reduce(uint64_t lo, uint64_t hi)
+{
+    uint64_t hiHi{ hi >> 32 };
+    uint64_t hiLo{ hi & Epsilon };
+
+    uint64_t t0{ lo - hiHi };
+    if(lo < hiHi) t0 -= Epsilon;
+
+    uint64_t t1{ hiLo * Epsilon };
+    uint64_t r{ t0 + t1 };
+    if(r < t1) r += Epsilon;
+
+    return r >= P ? r - P : r;
+}
+
+inline uint64_t multiply(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 p{ static_cast<unsigned __int128>(a) * b };
+    return reduce( static_cast<uint64_t>(p), static_cast<uint64_t>(p >> 64) );
+#else
+    uint64_t aLo{ a & 0xFFFFFFFFULL }, aHi{ a >> 32 };
+    uint64_t bLo{ b & 0xFFFFFFFFULL }, bHi{ b >> 32 };
+    uint64_t ll{ aLo * bLo }, lh{ aLo * bHi }, hl{ aHi * bLo }, hh{ aHi * bHi };
+    uint64_t mid{ (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL) };
+    uint64_t lo{ (ll & 0xFFFFFFFFULL) | (mid << 32) };
+    uint64_t hi{ hh + (lh >> 32) + (hl >> 32) + (mid >> 32) };
+    return reduce(lo, hi);
+#endif
+}
+
+inline uint64_t add(uint64_t a, uint64_t b)
+{
+    uint64_t s{ a + b };
+    if(s < a || s >= P) s -= P;
+    return s;
+}
+
+inline uint64_t subtract(uint64_t a, uint64_t b)
+{
+    return a >= b ? a - b : a + (P - b);
+}
+
+uint64_t power(uint64_t a, uint64_t e)
+{
+    uint64_t r{1};
+    while(e)
+    {
+        if(e & 1) r = multiply(r, a);
+        a = multiply(a, a);
+        e >>= 1;
+    }
+
+    return r;
+}
+
+void transform(vector<uint64_t>& a, bool inverse)
+{
+    const size_t n{ a.size() };
+    for(size_t i = 1, j = 0; i < n; ++i)
+    {
+        size_t bit{ n >> 1 };
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) std::swap(a[i], a[j]);
+    }
+
+    vector<uint64_t> roots;
+    for(size_t len = 2; len <= n; len <<= 1)
+    {
+        uint64_t w{ power(Generator, (P - 1) / len) };
+        if(inverse) w = power(w, P - 2);
+
+        const size_t half{ len / 2 };
+        roots.resize(half);
+        roots[0] = 1;
+        for(size_t j = 1; j < half; ++j)
+            roots[j] = multiply(roots[j - 1], w);
+
+        for(size_t i = 0; i < n; i += len)
+        {
+            for(size_t j = 0; j < half; ++j)
+            {
+                uint64_t u{ a[i + j] };
+                uint64_t v{ multiply(a[i + j + half], roots[j]) };
+                a[i + j] = add(u, v);
+                a[i + j + half] = subtract(u, v);
+            }
+        }
+    }
+
+    if(inverse)
+    {
+        uint64_t nInverse{ power(n, P - 2) };
+        for(auto& x : a)
+            x = multiply(x, nInverse);
+    }
+
+    return;
+}
+
+// Each pair of limbs, 18 digits, is split into three points of base 10^6. Every
+// coefficient of the product's convolution is then below MaxLimbs 10^12 < p.
+const size_t MaxLimbs = 12000000;
+const uint64_t PointBase = 1000000;
+
+// three points for every two limbs of x[0, xn) in d, which is zero beyond them
+void split(const Limb* x, size_t xn, vector<uint64_t>& d)
+{
+    for(size_t i = 0, k = 0; i < xn; i += 2, k += 3)
+    {
+        uint64_t lo{ x[i] };
+        uint64_t hi{ i + 1 < xn ? x[i + 1] : 0 };
+        d[k] = lo % PointBase;
+        d[k + 1] = lo / PointBase + hi % 1000 * 1000;
+        d[k + 2] = hi / 1000;
+    }
+
+    return;
+}
+
+// precondition: an, bn <= MaxLimbs
+void multiply(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* r)
+{
+    const size_t rn{ an + bn };
+    const size_t points{ 3 * ((rn + 1) / 2) };
+    size_t n{1};
+    while(n < points) n <<= 1;
+
+    vector<uint64_t> fa(n, 0);
+    split(a, an, fa);
+    transform(fa, false);
+
+    // squaring, as in the Newton iterations, needs only the one forward transform
+    if(a == b && an == bn)
+    {
+        for(auto& x : fa)
+            x = multiply(x, x);
+    }
+    else
+    {
+        vector<uint64_t> fb(n, 0);
+        split(b, bn, fb);
+        transform(fb, false);
+        for(size_t i = 0; i < n; ++i)
+            fa[i] = multiply(fa[i], fb[i]);
+    }
+    transform(fa, true);
+
+    uint64_t carry{0};
+    for(size_t i = 0; i < points; ++i)
+    {
+        uint64_t cur{ fa[i] + carry };
+        carry = cur / PointBase;
+        fa[i] = cur - carry * PointBase;
+    }
+
+    for(size_t i = 0, k = 0; i < rn; i += 2, k += 3)
+    {
+        r[i] = static_cast<Limb>( fa[k] + fa[k + 1] % 1000 * PointBase );
+        if(i + 1 < rn) r[i + 1] = static_cast<Limb>( fa[k + 1] / 1000 + fa[k + 2] * 1000 );
+    }
+
+    return;
+}
+
+}
+
+// r[0, an + bn) = a * b
+void multiplyInto(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* r)
+{
+    if(an < bn)
+    {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    if(bn < KaratsubaThreshold)
+    {
+        multiplySchoolbook(a, an, b, bn, r);
+        return;
+    }
+
+    if(bn >= NttThreshold && an <= Ntt::MaxLimbs)
+    {
+        Ntt::multiply(a, an, b, bn, r);
+        return;
+    }
+
+    // very unbalanced operands: multiply b by slices of a of its own size
+    if(2 * bn <= an)
+    {
+        std::fill(r, r + an + bn, 0);
+        Limbs t(2 * bn);
+        for(size_t i = 0; i < an; i += bn)
+        {
+            size_t len{ std::min(bn, an - i) };
+            multiplyInto(a + i, len, b, bn, t.data());
+            addInto(r + i, an + bn - i, t.data(), len + bn);
+        }
+        return;
+    }
+
+    // Karatsuba: with a = a1 B^h + a0 and b = b1 B^h + b0,
+    // a b = z2 B^2h + ((a0 + a1)(b0 + b1) - z0 - z2) B^h + z0
+    const size_t h{ an / 2 };
+    multiplyInto(a, h, b, h, r);
+    multiplyInto(a + h, an - h, b + h, bn - h, r + 2 * h);
+
+    Limbs sa(an - h + 1, 0);
+    std::copy(a + h, a + an, sa.begin());
+    addInto(sa.data(), sa.size(), a, h);
+
+    Limbs sb(std::max(h, bn - h) + 1, 0);
+    std::copy(b + h, b + bn, sb.begin());
+    addInto(sb.data(), sb.size(), b, h);
+
+    Limbs z1(sa.size() + sb.size());
+    multiplyInto(sa.data(), sa.size(), sb.data(), sb.size(), z1.data());
+    subtractFrom(z1.data(), z1.size(), r, 2 * h);
+    subtractFrom(z1.data(), z1.size(), r + 2 * h, an + bn - 2 * h);
+    trim(z1);
+
+    addInto(r + h, an + bn - h, z1.data(), z1.size());
+
+    return;
+}
+
+Limbs multiplyMag(const Limbs& a, const Limbs& b)
+{
+    if( a.empty() || b.empty() ) return Limbs{};
+
+    Limbs r(a.size() + b.size());
+    multiplyInto(a.data(), a.size(), b.data(), b.size(), r.data());
+    trim(r);
+
+    return r;
+}
+
+// Knuth's algorithm D
+// preconditions: b.size() >= 2, a >= b
+void divideSchoolbook(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r)
+{
+    const size_t n{ b.size() };
+    const size_t m{ a.size() };
+
+    // scale so that the leading limb of the divisor is at least Base / 2
+    Limb d{ static_cast<Limb>( Base / (uint64_t{b.back()} + 1) ) };
+    Limbs u{ multiplySmall(a, d) };
+    u.resize(m + 1, 0);
+    Limbs v{ multiplySmall(b, d) };
+
+    q.assign(m - n + 1, 0);
+    for(size_t j = m - n + 1; j-- > 0; )
+    {
+        uint64_t num{ uint64_t{u[j + n]} * Base + u[j + n - 1] };
+        uint64_t qhat{ num / v[n - 1] };
+        uint64_t rhat{ num % v[n - 1] };
+        while( qhat >= Base || qhat * v[n - 2] > rhat * Base + u[j + n - 2] )
+        {
+            --qhat;
+            rhat += v[n - 1];
+            if(rhat >= Base) break;
+        }
+
+        int64_t borrow{0};
+        uint64_t carry{0};
+        for(size_t i = 0; i < n; ++i)
+        {
+            uint64_t p{ qhat * v[i] + carry };
+            carry = p / Base;
+            int64_t t{ int64_t{u[i + j]} - static_cast<int64_t>(p - carry * Base) - borrow };
+            borrow = t < 0;
+            u[i + j] = static_cast<Limb>(borrow ? t + static_cast<int64_t>(Base) : t);
+        }
+        int64_t t{ int64_t{u[j + n]} - static_cast<int64_t>(carry) - borrow };
+
+        if(t < 0)
+        {
+            // qhat was one too large: add the divisor back
+            --qhat;
+            Limb c{0};
+            for(size_t i = 0; i < n; ++i)
+            {
+                Limb s{ u[i + j] + v[i] + c };
+                c = s >= Base;
+                u[i + j] = c ? s - Base : s;
+            }
+            t += c;
+        }
+        u[j + n] = static_cast<Limb>(t);
+        q[j] = static_cast<Limb>(qhat);
+    }
+    trim(q);
+
+    u.resize(n);
+    trim(u);
+    Limb remainder;
+    r = divideSmall(u, d, remainder);
+
+    return;
+}
+
+void divideMag(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r);
+
+// moves an estimate x of floor(u / t) to the floor given tx = x t, leaving the
+// remainder in r; the residual is divided out rather than stepped through, so the
+// estimate may be off by more than a few units
+void correctQuotient(const Limbs& u, const Limbs& t, const Limbs& tx, Limbs& x, Limbs& r)
+{
+    Limbs d;
+    if(compareMag(tx, u) > 0)
+    {
+        Limbs rem;
+        divideMag(subtractMag(tx, u), t, d, rem);
+        x = subtractMag(x, d);
+        if( rem.empty() ) r.clear();
+        else
+        {
+            x = subtractMag(x, Limbs{1});
+            r = subtractMag(t, rem);
+        }
+    }
+    else
+    {
+        divideMag(subtractMag(u, tx), t, d, r);
+        x = addMag(x, d);
+    }
+
+    return;
+}
+
+// B^2p / t for a t of p limbs to within a few units in the last of its p + 1
+// limbs, by Newton's iteration x += x (1 - t x) from a reciprocal of the leading
+// half of t; each level doubles the correct limbs. Only the quotient built from it
+// is corrected, so no level spends a multiplication on making x exact.
+Limbs reciprocal(const Limbs& t)
+{
+    const size_t p{ t.size() };
+
+    Limbs unit(2 * p + 1, 0);
+    unit[2 * p] = 1;
+
+    if(p <= NewtonThreshold)
+    {
+        Limbs x, rem;
+        divideSchoolbook(unit, t, x, rem);
+        return x;
+    }
+
+    const size_t h{ p / 2 + 1 };
+    Limbs x{ shiftLimbsLeft( reciprocal( Limbs(t.end() - h, t.end()) ), p - h ) };
+
+    Limbs tx{ multiplyMag(t, x) };
+    if(compareMag(tx, unit) <= 0)
+        x = addMag(x, shiftLimbsRight( multiplyMag(x, subtractMag(unit, tx)), 2 * p ));
+    else
+        x = subtractMag(x, shiftLimbsRight( multiplyMag(x, subtractMag(tx, unit)), 2 * p ));
+
+    return x;
+}
+
+// a / b through a reciprocal of the leading limbs of b
+// precondition: a.size() <= 2 b.size()
+void divideNewton(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r)
+{
+    const size_t n{ b.size() };
+    const size_t m{ a.size() };
+
+    // enough leading limbs of b that the quotient is within about a limb
+    const size_t p{ std::min(n, m - n + 4) };
+    Limbs x{ reciprocal( Limbs(b.end() - p, b.end()) ) };
+    q = shiftLimbsRight( multiplyMag( shiftLimbsRight(a, n - p), x ), 2 * p );
+
+    correctQuotient(a, b, multiplyMag(q, b), q, r);
+
+    return;
+}
+
+void divideMag(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r)
+{
+    if(compareMag(a, b) < 0)
+    {
+        q.clear();
+        r = a;
+        return;
+    }
+
+    if(b.size() == 1)
+    {
+        Limb remainder;
+        q = divideSmall(a, b[0], remainder);
+        r.assign(remainder ? 1 : 0, remainder);
+        return;
+    }
+
+    const size_t n{ b.size() };
+    if(n < NewtonThreshold || a.size() - n < NewtonThreshold)
+    {
+        divideSchoolbook(a, b, q, r);
+        return;
+    }
+
+    if(a.size() <= 2 * n)
+    {
+        divideNewton(a, b, q, r);
+        return;
+    }
+
+    // long division by b with "digits" of n limbs, each step a 2n by n division
+    const size_t nBlocks{ (a.size() + n - 1) / n };
+    q.assign(nBlocks * n, 0);
+    r.clear();
+    for(size_t i = nBlocks; i-- > 0; )
+    {
+        Limbs cur(a.begin() + i * n, a.begin() + std::min(a.size(), (i + 1) * n));
+        cur.resize(n, 0);
+        cur.insert(cur.end(), r.begin(), r.end());
+        trim(cur);
+
+        Limbs qi;
+        divideMag(cur, b, qi, r);
+        std::copy(qi.begin(), qi.end(), q.begin() + i * n);
+    }
+    trim(q);
+
+    return;
+}
+
+size_t limbDigits(Limb x)
+{
+    size_t d{1};
+    while(d < 10 && x >= Pow10Table[d]) ++d;
+    return d;
+}
+
+}
+
+BigInteger::BigInteger(long long n)
+: negative_{n < 0}
+{
+    // negate in unsigned arithmetic so that the most negative value works
+    unsigned long long m{ negative_ ? 0ULL - static_cast<unsigned long long>(n) : static_cast<unsigned long long>(n) };
+    while(m)
+    {
+        limbs_.push_back( static_cast<Limb>(m % Base) );
+        m /= Base;
+    }
+}
+
+BigInteger::BigInteger(const string& s)
+: negative_{false}
+{
+    size_t start{0};
+    if( !s.empty() && (s[0] == '+' || s[0] == '-') )
+    {
+        negative_ = s[0] == '-';
+        start = 1;
+    }
+
+    if( start == s.size() )
+        throw Exception{"Invalid integer: " + s};
+
+    for(size_t i = start; i < s.size(); ++i)
+        if( !std::isdigit( static_cast<unsigned char>(s[i]) ) )
+            throw Exception{"Invalid integer: " + s};
+
+    for(size_t end = s.size(); end > start; )
+    {
+        size_t begin{ end - start > static_cast<size_t>(LimbDigits) ? end - LimbDigits : start };
+        Limb limb{0};
+        for(size_t i = begin; i < end; ++i)
+            limb = limb * 10 + (s[i] - '0');
+        limbs_.push_back(limb);
+        end = begin;
+    }
+    trim(limbs_);
+
+    if( limbs_.empty() ) negative_ = false;
+}
+
+size_t BigInteger::nDigits() const
+{
+    if( limbs_.empty() ) return 0;
+    return LimbDigits * (limbs_.size() - 1) + limbDigits( limbs_.back() );
+}
+
+int BigInteger::digit(size_t i) const
+{
+    size_t limb{ i / LimbDigits };
+    if( limb >= limbs_.size() ) return 0;
+    return limbs_[limb] / Pow10Table[i % LimbDigits] % 10;
+}
+
+bool BigInteger::anyDigitBelow(size_t i) const
+{
+    size_t limb{ i / LimbDigits };
+    for(size_t j = 0; j < std::min(limb, limbs_.size()); ++j)
+        if(limbs_[j] != 0) return true;
+
+    return limb < limbs_.size() && limbs_[limb] % Pow10Table[i % LimbDigits] != 0;
+}
+
+string BigInteger::toString() const
+{
+    if( limbs_.empty() ) return "0";
+
+    string s;
+    s.reserve( nDigits() + 1 );
+    if(negative_) s += '-';
+    s += std::to_string( limbs_.back() );
+    for(size_t i = limbs_.size() - 1; i-- > 0; )
+    {
+        string limb{ std::to_string(limbs_[i]) };
+        s.append(LimbDigits - limb.size(), '0');
+        s += limb;
+    }
+
+    return s;
+}
+
+double BigInteger::toDouble() const
+{
+    return BigFloat{*this, 0}.toDouble();
+}
+
+BigInteger BigInteger::operator-() const
+{
+    BigInteger r{*this};
+    if( !r.isZero() ) r.negative_ = !r.negative_;
+    return r;
+}
+
+BigInteger BigInteger::abs() const
+{
+    BigInteger r{*this};
+    r.negative_ = false;
+    return r;
+}
+
+BigInteger operator+(const BigInteger& a, const BigInteger& b)
+{
+    BigInteger r;
+    if(a.negative_ == b.negative_)
+    {
+        r.limbs_ = addMag(a.limbs_, b.limbs_);
+        r.negative_ = a.negative_;
+    }
+    else if(compareMag(a.limbs_, b.limbs_) >= 0)
+    {
+        r.limbs_ = subtractMag(a.limbs_, b.limbs_);
+        r.negative_ = a.negative_;
+    }
+    else
+    {
+        r.limbs_ = subtractMag(b.limbs_, a.limbs_);
+        r.negative_ = b.negative_;
+    }
+    if( r.limbs_.empty() ) r.negative_ = false;
+
+    return r;
+}
+
+BigInteger operator-(const BigInteger& a, const BigInteger& b)
+{
+    return a + -b;
+}
+
+BigInteger operator*(const BigInteger& a, const BigInteger& b)
+{
+    BigInteger r;
+    r.limbs_ = multiplyMag(a.limbs_, b.limbs_);
+    r.negative_ = !r.limbs_.empty() && a.negative_ != b.negative_;
+
+    return r;
+}
+
+void BigInteger::DivMod(const BigInteger& a, const BigInteger& b, BigInteger& q, BigInteger& r)
+{
+    if( b.isZero() )
+        throw Exception{"Division by zero"};
+
+    Limbs ql, rl;
+    divideMag(a.limbs_, b.limbs_, ql, rl);
+
+    q.limbs_ = std::move(ql);
+    q.negative_ = !q.limbs_.empty() && a.negative_ != b.negative_;
+    r.limbs_ = std::move(rl);
+    r.negative_ = !r.limbs_.empty() && a.negative_;
+
+    return;
+}
+
+BigInteger operator/(const BigInteger& a, const BigInteger& b)
+{
+    BigInteger q, r;
+    BigInteger::DivMod(a, b, q, r);
+    return q;
+}
+
+BigInteger operator%(const BigInteger& a, const BigInteger& b)
+{
+    BigInteger q, r;
+    BigInteger::DivMod(a, b, q, r);
+    return r;
+}
+
+int BigInteger::Compare(const BigInteger& a, const BigInteger& b)
+{
+    if(a.negative_ != b.negative_) return a.negative_ ? -1 : 1;
+
+    int c{ compareMag(a.limbs_, b.limbs_) };
+    return a.negative_ ? -c : c;
+}
+
+BigInteger BigInteger::Pow(const BigInteger& x, unsigned long long n)
+{
+    BigInteger r{1};
+    BigInteger base{x};
+    while(n)
+    {
+        if(n & 1) r = r * base;
+        n >>= 1;
+        if(n) base = base * base;
+    }
+
+    return r;
+}
+
+BigInteger BigInteger::Pow10(size_t n)
+{
+    return ScaleUp(BigInteger{1}, n);
+}
+
+BigInteger BigInteger::ScaleUp(const BigInteger& x, size_t n)
+{
+    if( x.isZero() || n == 0 ) return x;
+
+    BigInteger r;
+    r.limbs_ = shiftLimbsLeft( multiplySmall(x.limbs_, Pow10Table[n % LimbDigits]), n / LimbDigits );
+    r.negative_ = x.negative_;
+
+    return r;
+}
+
+BigInteger BigInteger::ScaleDown(const BigInteger& x, size_t n)
+{
+    if(n == 0) return x;
+
+    Limb remainder;
+    BigInteger r;
+    r.limbs_ = divideSmall( shiftLimbsRight(x.limbs_, n / LimbDigits), Pow10Table[n % LimbDigits], remainder );
+    r.negative_ = !r.limbs_.empty() && x.negative_;
+
+    return r;
+}
+
+BigInteger BigInteger::Root(const BigInteger& x, unsigned n)
+{
+    if( x.negative() )
+        throw Exception{"Root of a negative integer"};
+    if(n == 0)
+        throw Exception{"Zeroth root"};
+    if(n == 1 || x.isZero()) return x;
+
+    BigInteger r;
+    const size_t d{ x.nDigits() };
+    const size_t rootDigits{ (d + n - 1) / n };
+    if(rootDigits > 30)
+    {
+        // the root of the leading digits gives the leading half of the root, and
+        // rounding it up keeps the start above the root
+        const size_t h{ rootDigits / 2 - 1 };
+        r = ScaleUp(Root(ScaleDown(x, n * h), n) + BigInteger{1}, h);
+    }
+    else
+    {
+        // an overestimate from the leading digits, good to about 1e-9
+        const size_t lead{ std::min<size_t>(d, 17) };
+        const Limbs top{ ScaleDown(x, d - lead).limbs_ };
+        double mantissa{0};
+        for(size_t i = top.size(); i-- > 0; )
+            mantissa = mantissa * Base + top[i];
+
+        double e{ (std::log10(mantissa) + (d - lead)) / n };
+        double ip{ std::floor(e) };
+        if(ip < 15)
+            r = BigInteger{ static_cast<long long>( std::ceil( std::pow(10.0, e) * (1 + 1e-9) ) ) + 1 };
+        else
+            r = ScaleUp( BigInteger{ static_cast<long long>( std::ceil( std::pow(10.0, e - ip + 15) * (1 + 1e-9) ) ) + 1 },
+                static_cast<size_t>(ip) - 15 );
+    }
+
+    // Newton's iteration decreases monotonically from above to the floor of the root
+    const BigInteger nn{ static_cast<long long>(n) };
+    const BigInteger nm1{ static_cast<long long>(n - 1) };
+    while(true)
+    {
+        BigInteger next{ (nm1 * r + x / Pow(r, n - 1)) / nn };
+        if(next >= r) break;
+        r = std::move(next);
+    }
+
+    return r;
+}
+
+BigFloat::BigFloat(const BigInteger& mantissa, long long exponent)
+: mantissa_{mantissa}
+, exponent_{exponent}
+{
+    if( mantissa_.isZero() )
+    {
+        exponent_ = 0;
+        return;
+    }
+
+    size_t zeros{0};
+    while( mantissa_.digit(zeros) == 0 ) ++zeros;
+    if(zeros)
+    {
+        mantissa_ = BigInteger::ScaleDown(mantissa_, zeros);
+        exponent_ += zeros;
+    }
+}
+
+BigFloat BigFloat::Round(BigInteger mantissa, long long exponent, unsigned digits, bool sticky)
+{
+    const size_t d{ mantissa.nDigits() };
+    if(d <= digits) return BigFloat{mantissa, exponent};
+
+    // round half to even on the first discarded digit and those below it
+    const size_t k{ d - digits };
+    int first{ mantissa.digit(k - 1) };
+    bool rest{ sticky || mantissa.anyDigitBelow(k - 1) };
+    BigInteger q{ BigInteger::ScaleDown(mantissa, k) };
+    if( first > 5 || (first == 5 && (rest || q.odd())) )
+        q = q + BigInteger{ q.negative() ? -1 : 1 };
+
+    return BigFloat{q, exponent + static_cast<long long>(k)};
+}
+
+BigFloat BigFloat::FromString(const string& s, unsigned digits)
+{
+    auto invalid = [&s]() { return Exception{"Invalid number: " + s}; };
+
+    size_t i{0};
+    bool negative{false};
+    if( i < s.size() && (s[i] == '+' || s[i] == '-') )
+        negative = s[i++] == '-';
+
+    string mantissa;
+    long long exponent{0};
+    bool point{false};
+    for(; i < s.size(); ++i)
+    {
+        char c{ s[i] };
+        if( std::isdigit( static_cast<unsigned char>(c) ) )
+        {
+            mantissa += c;
+            if(point) --exponent;
+        }
+        else if(c == '.' && !point) point = true;
+        else break;
+    }
+    if( mantissa.empty() ) throw invalid();
+
+    if( i < s.size() && (s[i] == 'e' || s[i] == 'E') )
+    {
+        ++i;
+        bool negativeExponent{false};
+        if( i < s.size() && (s[i] == '+' || s[i] == '-') )
+            negativeExponent = s[i++] == '-';
+        if(i == s.size()) throw invalid();
+
+        long long e{0};
+        for(; i < s.size(); ++i)
+        {
+            if( !std::isdigit( static_cast<unsigned char>(s[i]) ) ) throw invalid();
+            if(e > 100000000000000LL) throw Exception{"Exponent out of range: " + s};
+            e = 10 * e + (s[i] - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    if(i != s.size()) throw invalid();
+
+    BigInteger m{mantissa};
+    return Round(negative ? -m : m, exponent, digits);
+}
+
+BigFloat BigFloat::FromDouble(double d)
+{
+    // the shortest of 15, 16, or 17 significant digits that reads back as d
+    std::ostringstream oss;
+    oss.imbue( std::locale::classic() );
+    oss << std::scientific;
+    string s;
+    for(int p = 15; p <= 17; ++p)
+    {
+        oss.str("");
+        oss.precision(p - 1);
+        oss << d;
+        s = oss.str();
+
+        std::istringstream iss{s};
+        iss.imbue( std::locale::classic() );
+        double back;
+        iss >> back;
+        if(back == d) break;
+    }
+
+    return FromString(s, 17);
+}
+
+bool BigFloat::toInteger(long long& n) const
+{
+    if( exponent_ < 0 || mantissa_.nDigits() + exponent_ > 18 ) return false;
+
+    BigInteger m{ BigInteger::ScaleUp(mantissa_, static_cast<size_t>(exponent_)) };
+    n = std::stoll( m.toString() );
+
+    return true;
+}
+
+double BigFloat::toDouble() const
+{
+    if( isZero() ) return 0.0;
+
+    // strtod rounds the leading 25 digits correctly; no radix character is
+    // involved, so the conversion is independent of the locale
+    const size_t d{ mantissa_.nDigits() };
+    const size_t drop{ d > 25 ? d - 25 : 0 };
+    long long e{ exponent_ + static_cast<long long>(drop) };
+    if(e > 100000) return negative() ? -HUGE_VAL : HUGE_VAL;
+    if(e < -100000) return negative() ? -0.0 : 0.0;
+
+    string s{ BigInteger::ScaleDown(mantissa_, drop).toString() };
+    s += "e" + std::to_string(e);
+
+    return std::strtod(s.c_str(), nullptr);
+}
+
+string BigFloat::toString() const
+{
+    string digits{ mantissa_.abs().toString() };
+    const long long nd{ static_cast<long long>( digits.size() ) };
+    const long long point{ nd + exponent_ };
+
+    string s{ negative() ? "-" : "" };
+    if(exponent_ >= 0 && point <= 40)
+    {
+        s += digits;
+        s.append(static_cast<size_t>(exponent_), '0');
+    }
+    else if(exponent_ < 0 && point > 0)
+    {
+        s += digits.substr(0, static_cast<size_t>(point));
+        s += '.';
+        s += digits.substr( static_cast<size_t>(point) );
+    }
+    else if(exponent_ < 0 && point > -6)
+    {
+        s += "0.";
+        s.append(static_cast<size_t>(-point), '0');
+        s += digits;
+    }
+    else
+    {
+        s += digits[0];
+        if(nd > 1)
+        {
+            s += '.';
+            s += digits.substr(1);
+        }
+        s += "e" + std::to_string(point - 1);
+    }
+
+    return s;
+}
+
+BigFloat BigFloat::operator-() const
+{
+    BigFloat r{*this};
+    r.mantissa_ = -r.mantissa_;
+    return r;
+}
+
+BigFloat BigFloat::Add(const BigFloat& a, const BigFloat& b, unsigned digits)
+{
+    if( a.isZero() ) return Round(b.mantissa_, b.exponent_, digits);
+    if( b.isZero() ) return Round(a.mantissa_, a.exponent_, digits);
+
+    // position just past the leading digit of each operand
+    auto top = [](const BigFloat& x) { return x.exponent_ + static_cast<long long>( x.mantissa_.nDigits() ); };
+    const BigFloat& hi = top(a) >= top(b) ? a : b;
+    const BigFloat& lo = top(a) >= top(b) ? b : a;
+
+    // An operand entirely below the rounding position of the other only decides
+    // the rounding direction, so it is replaced by a single unit two places below
+    // that position rather than aligned digit by digit.
+    long long cut{ std::min(hi.exponent_, top(hi) - static_cast<long long>(digits)) - 2 };
+    BigInteger loMantissa{ lo.mantissa_ };
+    long long loExponent{ lo.exponent_ };
+    if(top(lo) < cut)
+    {
+        loMantissa = BigInteger{ lo.negative() ? -1 : 1 };
+        loExponent = cut;
+    }
+
+    long long e{ std::min(hi.exponent_, loExponent) };
+    BigInteger sum{ BigInteger::ScaleUp(hi.mantissa_, static_cast<size_t>(hi.exponent_ - e))
+        + BigInteger::ScaleUp(loMantissa, static_cast<size_t>(loExponent - e)) };
+
+    return Round(sum, e, digits);
+}
+
+BigFloat BigFloat::Subtract(const BigFloat& a, const BigFloat& b, unsigned digits)
+{
+    return Add(a, -b, digits);
+}
+
+BigFloat BigFloat::Multiply(const BigFloat& a, const BigFloat& b, unsigned digits)
+{
+    return Round(a.mantissa_ * b.mantissa_, a.exponent_ + b.exponent_, digits);
+}
+
+BigFloat BigFloat::Divide(const BigFloat& a, const BigFloat& b, unsigned digits)
+{
+    if( b.isZero() )
+        throw Exception{"Division by zero"};
+    if( a.isZero() ) return BigFloat{};
+
+    // scale the dividend so the quotient has at least one digit beyond those kept
+    long long na{ static_cast<long long>( a.mantissa_.nDigits() ) };
+    long long nb{ static_cast<long long>( b.mantissa_.nDigits() ) };
+    size_t s{ static_cast<size_t>( std::max(0LL, static_cast<long long>(digits) + 1 + nb - na) ) };
+
+    BigInteger q, r;
+    BigInteger::DivMod(BigInteger::ScaleUp(a.mantissa_, s), b.mantissa_, q, r);
+
+    return Round(q, a.exponent_ - b.exponent_ - static_cast<long long>(s), digits, !r.isZero());
+}
+
+BigFloat BigFloat::Pow(const BigFloat& a, long long n, unsigned digits)
+{
+    unsigned long long u{ n < 0 ? 0ULL - static_cast<unsigned long long>(n) : static_cast<unsigned long long>(n) };
+
+    // guard digits for the roundings of the repeated squaring
+    unsigned bits{0};
+    for(unsigned long long v = u; v; v >>= 1) ++bits;
+    const unsigned working{ digits + 2 * bits + 5 };
+
+    BigFloat r{ BigInteger{1}, 0 };
+    BigFloat base{a};
+    while(u)
+    {
+        if(u & 1) r = Multiply(r, base, working);
+        u >>= 1;
+        if(u) base = Multiply(base, base, working);
+    }
+
+    if(n < 0) return Divide(BigFloat{BigInteger{1}, 0}, r, digits);
+
+    return Round(r.mantissa_, r.exponent_, digits);
+}
+
+BigFloat BigFloat::Root(const BigFloat& a, unsigned n, unsigned digits)
+{
+    if(n == 0)
+        throw Exception{"Zeroth root"};
+    if( a.negative() && n % 2 == 0 )
+        throw Exception{"Even root of a negative number"};
+    if( a.isZero() || n == 1 ) return Round(a.mantissa_, a.exponent_, digits);
+
+    // scale the mantissa so its root has at least one digit beyond those kept and
+    // the remaining power of ten divides evenly by n
+    const long long ln{ static_cast<long long>(n) };
+    long long t{ std::max(0LL, ln * (digits + 1) - static_cast<long long>( a.mantissa_.nDigits() )) };
+    while( ((a.exponent_ - t) % ln + ln) % ln != 0 ) ++t;
+
+    BigInteger x{ BigInteger::ScaleUp(a.mantissa_.abs(), static_cast<size_t>(t)) };
+    BigInteger r{ BigInteger::Root(x, n) };
+    bool sticky{ BigInteger::Pow(r, n) != x };
+
+    return Round(a.negative() ? -r : r, (a.exponent_ - t) / ln, digits, sticky);
+}
+
+}
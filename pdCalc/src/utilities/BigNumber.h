@@ -0,0 +1,169 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BIG_NUMBER_H
+#define BIG_NUMBER_H
+
+// Arbitrary precision arithmetic for pdCalc's exact numeric mode. BigInteger keeps
+// its magnitude in base 10^9 limbs so that decimal input, output, and rounding are
+// limb operations. Multiplication switches from the schoolbook method to Karatsuba
+// and then to a number theoretic transform as the operands grow; division and roots
+// are computed by Newton iteration once the operands are large enough for the fast
+// multiplication to pay off.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pdCalc {
+
+class BigInteger
+{
+public:
+    using Limb = std::uint32_t;
+    static const Limb Base = 1000000000;
+    static const int LimbDigits = 9;
+
+    BigInteger() : negative_{false} { }
+    BigInteger(long long);
+
+    // an optional sign followed by decimal digits; throws Exception otherwise
+    explicit BigInteger(const std::string&);
+
+    bool isZero() const { return limbs_.empty(); }
+    bool negative() const { return negative_; }
+    bool odd() const { return !limbs_.empty() && (limbs_[0] & 1); }
+
+    // number of decimal digits of the magnitude, 0 for zero
+    size_t nDigits() const;
+
+    // the decimal digit at position i (0 is the units digit) of the magnitude
+    int digit(size_t i) const;
+
+    // true if any digit below position i of the magnitude is nonzero
+    bool anyDigitBelow(size_t i) const;
+
+    std::string toString() const;
+
+    // nearest double to the value, or +/- infinity if it is out of range
+    double toDouble() const;
+
+    BigInteger operator-() const;
+    BigInteger abs() const;
+
+    friend BigInteger operator+(const BigInteger&, const BigInteger&);
+    friend BigInteger operator-(const BigInteger&, const BigInteger&);
+    friend BigInteger operator*(const BigInteger&, const BigInteger&);
+
+    // truncating division, as for the built in integers
+    // precondition: the divisor is not zero
+    friend BigInteger operator/(const BigInteger&, const BigInteger&);
+    friend BigInteger operator%(const BigInteger&, const BigInteger&);
+    static void DivMod(const BigInteger& a, const BigInteger& b, BigInteger& q, BigInteger& r);
+
+    // -1, 0, or 1 as a is less than, equal to, or greater than b
+    static int Compare(const BigInteger& a, const BigInteger& b);
+
+    friend bool operator==(const BigInteger& a, const BigInteger& b) { return Compare(a, b) == 0; }
+    friend bool operator!=(const BigInteger& a, const BigInteger& b) { return Compare(a, b) != 0; }
+    friend bool operator<(const BigInteger& a, const BigInteger& b) { return Compare(a, b) < 0; }
+    friend bool operator>(const BigInteger& a, const BigInteger& b) { return Compare(a, b) > 0; }
+    friend bool operator<=(const BigInteger& a, const BigInteger& b) { return Compare(a, b) <= 0; }
+    friend bool operator>=(const BigInteger& a, const BigInteger& b) { return Compare(a, b) >= 0; }
+
+    static BigInteger Pow(const BigInteger& x, unsigned long long n);
+    static BigInteger Pow10(size_t n);
+
+    // x * 10^n
+    static BigInteger ScaleUp(const BigInteger& x, size_t n);
+
+    // x / 10^n, truncated toward zero
+    static BigInteger ScaleDown(const BigInteger& x, size_t n);
+
+    // floor of the nth root of x
+    // preconditions: x >= 0, n >= 1
+    static BigInteger Root(const BigInteger& x, unsigned n);
+
+private:
+    std::vector<Limb> limbs_; // least significant first, no leading zero limbs
+    bool negative_;           // never true for zero
+};
+
+// A decimal floating point number, mantissa * 10^exponent, with the mantissa kept
+// free of trailing zeros. Operations that cannot be exact are rounded half to even
+// to the given number of significant digits; addition, subtraction, and
+// multiplication are exact whenever the exact result fits in that many digits, so
+// decimal inputs such as 0.1 behave as they are written.
+class BigFloat
+{
+public:
+    BigFloat() : exponent_{0} { }
+    BigFloat(const BigInteger& mantissa, long long exponent);
+
+    // decimal notation with optional fraction and exponent, as accepted by the
+    // calculator's number entry; throws Exception otherwise
+    static BigFloat FromString(const std::string&, unsigned digits);
+
+    // the shortest decimal that converts back to d
+    // precondition: d is finite
+    static BigFloat FromDouble(double d);
+
+    const BigInteger& mantissa() const { return mantissa_; }
+    long long exponent() const { return exponent_; }
+
+    bool isZero() const { return mantissa_.isZero(); }
+    bool negative() const { return mantissa_.negative(); }
+
+    // true if the value is an integer that fits in a long long, returned in n
+    bool toInteger(long long& n) const;
+
+    double toDouble() const;
+
+    // plain notation when the decimal point falls near the digits, scientific
+    // notation otherwise
+    std::string toString() const;
+
+    BigFloat operator-() const;
+
+    static BigFloat Add(const BigFloat& a, const BigFloat& b, unsigned digits);
+    static BigFloat Subtract(const BigFloat& a, const BigFloat& b, unsigned digits);
+    static BigFloat Multiply(const BigFloat& a, const BigFloat& b, unsigned digits);
+
+    // precondition: b is not zero
+    static BigFloat Divide(const BigFloat& a, const BigFloat& b, unsigned digits);
+
+    // precondition: a is not zero if n < 0
+    static BigFloat Pow(const BigFloat& a, long long n, unsigned digits);
+
+    // nth root, negative only for odd n
+    // preconditions: n >= 1, a >= 0 if n is even
+    static BigFloat Root(const BigFloat& a, unsigned n, unsigned digits);
+
+private:
+    // rounds mantissa * 10^exponent to digits, where sticky records that nonzero
+    // digits were already discarded below the mantissa
+    static BigFloat Round(BigInteger mantissa, long long exponent, unsigned digits, bool sticky = false);
+
+    BigInteger mantissa_;
+    long long exponent_;
+};
+
+}
+
+#endif
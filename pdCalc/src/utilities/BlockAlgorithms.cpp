@@ -0,0 +1,276 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockAlgorithms.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+namespace pdCalc {
+
+namespace BlockAlgorithms {
+
+namespace {
+
+// the radix sort takes a byte of the keys per pass
+const unsigned DigitBits = 11;
+const size_t Buckets = size_t{1} << DigitBits;
+const unsigned Passes = (64 + DigitBits - 1) / DigitBits;
+const uint64_t DigitMask = Buckets - 1;
+
+const uint64_t SignBit = uint64_t{1} << 63;
+
+// Maps a double to an unsigned integer that orders the same way: positive
+// numbers get their sign bit set, and negative numbers, whose magnitudes grow
+// with their bit patterns, are complemented.
+uint64_t toKey(double d)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+
+    return bits ^ ( static_cast<uint64_t>( static_cast<int64_t>(bits) >> 63 ) | SignBit );
+}
+
+double fromKey(uint64_t key)
+{
+    uint64_t bits{ key & SignBit ? key ^ SignBit : ~key };
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+
+    return d;
+}
+
+// a key and the position of the element it came from
+struct Keyed
+{
+    uint64_t key;
+    size_t index;
+};
+
+inline uint64_t keyOf(uint64_t k) { return k; }
+inline uint64_t keyOf(const Keyed& k) { return k.key; }
+
+// Stable least significant digit radix sort. Each pass scatters chunks of the
+// array concurrently, each chunk starting, in every bucket, after the elements
+// of the chunks before it. A single read of the keys counts the digits of every
+// pass for every chunk; the counts of later passes are only taken again when
+// there is more than one chunk, since the earlier passes move elements between
+// chunks. A pass is skipped when all the keys share its digit, which is common in
+// the exponent bits.
+template<typename Item>
+void radixSort(vector<Item>& a)
+{
+    const size_t n{ a.size() };
+    ThreadPool& pool = ThreadPool::Instance();
+    const size_t chunks{ pool.nChunks(n, ParallelThreshold) };
+
+    vector<size_t> counts(chunks * Passes * Buckets, 0);
+    auto countsOf = [&counts](size_t chunk, unsigned pass) { return counts.data() + (chunk * Passes + pass) * Buckets; };
+
+    pool.parallelFor(n, ParallelThreshold, [&](size_t chunk, size_t begin, size_t end)
+    {
+        size_t* c{ countsOf(chunk, 0) };
+        for(size_t i = begin; i < end; ++i)
+        {
+            const uint64_t key{ keyOf(a[i]) };
+            for(unsigned pass = 0; pass < Passes; ++pass)
+                ++c[ pass * Buckets + ((key >> (pass * DigitBits)) & DigitMask) ];
+        }
+    });
+
+    vector<Item> scratch(n);
+    Item* from{ a.data() };
+    Item* to{ scratch.data() };
+    bool moved{false};
+
+    for(unsigned pass = 0; pass < Passes; ++pass)
+    {
+        const unsigned shift{ pass * DigitBits };
+
+        const size_t firstDigit{ (keyOf(from[0]) >> shift) & DigitMask };
+        size_t shared{0};
+        for(size_t chunk = 0; chunk < chunks; ++chunk)
+            shared += countsOf(chunk, pass)[firstDigit];
+        if(shared == n) continue;
+
+        if(moved && chunks > 1)
+        {
+            pool.parallelFor(n, ParallelThreshold, [&](size_t chunk, size_t begin, size_t end)
+            {
+                size_t* c{ countsOf(chunk, pass) };
+                std::fill(c, c + Buckets, 0);
+                for(size_t i = begin; i < end; ++i)
+                    ++c[ (keyOf(from[i]) >> shift) & DigitMask ];
+            });
+        }
+
+        // bucket by bucket, and within a bucket chunk by chunk, to keep the sort stable
+        size_t total{0};
+        for(size_t digit = 0; digit < Buckets; ++digit)
+        {
+            for(size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                size_t& c = countsOf(chunk, pass)[digit];
+                size_t count{c};
+                c = total;
+                total += count;
+            }
+        }
+
+        pool.parallelFor(n, ParallelThreshold, [&](size_t chunk, size_t begin, size_t end)
+        {
+            size_t* next{ countsOf(chunk, pass) };
+            for(size_t i = begin; i < end; ++i)
+                to[ next[ (keyOf(from[i]) >> shift) & DigitMask ]++ ] = from[i];
+        });
+
+        std::swap(from, to);
+        moved = true;
+    }
+
+    if( from != a.data() ) a.swap(scratch);
+
+    return;
+}
+
+// Scans each block on its own, concurrently, and then adds to every element the
+// total of the blocks before its own.
+template<typename Operation>
+void scan(double* x, size_t n, Operation op)
+{
+    const size_t nBlocks{ (n + ScanBlock - 1) / ScanBlock };
+    auto scanBlocks = [x, n, op](size_t, size_t begin, size_t end)
+    {
+        for(size_t b = begin; b < end; ++b)
+        {
+            size_t last{ std::min(n, (b + 1) * ScanBlock) };
+            for(size_t i = b * ScanBlock + 1; i < last; ++i)
+                x[i] = op(x[i - 1], x[i]);
+        }
+    };
+
+    if(nBlocks < 2)
+    {
+        scanBlocks(0, 0, nBlocks);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::Instance();
+    const size_t minChunkBlocks{ ParallelThreshold / ScanBlock };
+    pool.parallelFor(nBlocks, minChunkBlocks, scanBlocks);
+
+    // carry[b] is the scan up to the end of block b - 1
+    vector<double> carry(nBlocks);
+    carry[1] = x[ScanBlock - 1];
+    for(size_t b = 2; b < nBlocks; ++b)
+        carry[b] = op( carry[b - 1], x[b * ScanBlock - 1] );
+
+    pool.parallelFor(nBlocks - 1, minChunkBlocks, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t b = begin + 1; b < end + 1; ++b)
+        {
+            size_t last{ std::min(n, (b + 1) * ScanBlock) };
+            for(size_t i = b * ScanBlock; i < last; ++i)
+                x[i] = op(carry[b], x[i]);
+        }
+    });
+
+    return;
+}
+
+}
+
+void Sort(double* x, size_t n)
+{
+    if(n < 2) return;
+
+    ThreadPool& pool = ThreadPool::Instance();
+    vector<uint64_t> keys(n);
+    pool.parallelFor(n, ParallelThreshold, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+            keys[i] = toKey(x[i]);
+    });
+
+    if(n < RadixThreshold) std::sort( keys.begin(), keys.end() );
+    else radixSort(keys);
+
+    pool.parallelFor(n, ParallelThreshold, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+            x[i] = fromKey(keys[i]);
+    });
+
+    return;
+}
+
+size_t Unique(double* x, size_t n)
+{
+    if(n < 2) return n;
+
+    // sorting the keys stably with their positions brings equal elements together,
+    // earliest first
+    vector<Keyed> keys(n);
+    ThreadPool::Instance().parallelFor(n, ParallelThreshold, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+            keys[i] = Keyed{ toKey(x[i] == 0.0 ? 0.0 : x[i]), i };
+    });
+
+    if(n < RadixThreshold)
+        std::stable_sort( keys.begin(), keys.end(), [](const Keyed& a, const Keyed& b) { return a.key < b.key; } );
+    else radixSort(keys);
+
+    vector<char> keep(n, 0);
+    keep[ keys[0].index ] = 1;
+    for(size_t i = 1; i < n; ++i)
+    {
+        if(keys[i].key != keys[i - 1].key)
+            keep[ keys[i].index ] = 1;
+    }
+
+    size_t m{0};
+    for(size_t i = 0; i < n; ++i)
+    {
+        if(keep[i]) x[m++] = x[i];
+    }
+
+    return m;
+}
+
+void PrefixSum(double* x, size_t n)
+{
+    scan( x, n, [](double a, double b) { return a + b; } );
+
+    return;
+}
+
+void PrefixProduct(double* x, size_t n)
+{
+    scan( x, n, [](double a, double b) { return a * b; } );
+
+    return;
+}
+
+}
+
+}
@@ -0,0 +1,57 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BLOCK_ALGORITHMS_H
+#define BLOCK_ALGORITHMS_H
+
+#include <cstddef>
+
+namespace pdCalc {
+
+// Reordering and accumulating algorithms over contiguous arrays of doubles, in
+// place. Arrays of at least ParallelThreshold elements are split across the
+// program's ThreadPool; the results do not depend on how many threads take part.
+namespace BlockAlgorithms {
+
+const size_t ParallelThreshold = size_t{1} << 15;
+
+// Sorts x into increasing order. Doubles are ordered by their bit patterns, which
+// agrees with < and adds -0 before +0 and NaNs at either end by sign. Large
+// arrays are radix sorted on the bit patterns; below RadixThreshold elements,
+// where the passes over the buckets cost more than they save, std::sort is used.
+const size_t RadixThreshold = 512;
+void Sort(double* x, size_t n);
+
+// Removes every element equal to an earlier one, keeping the order of the rest,
+// and returns the number of elements left at the front of x. -0 equals +0, and a
+// NaN equals a NaN with the same bits.
+size_t Unique(double* x, size_t n);
+
+// inclusive scans: x[i] becomes x[0] + ... + x[i], or x[0] * ... * x[i]; the
+// partial results of every ScanBlock elements are carried into the next block as
+// one total, so rounding can differ slightly from a sequential loop beyond the
+// first block
+const size_t ScanBlock = 4096;
+void PrefixSum(double* x, size_t n);
+void PrefixProduct(double* x, size_t n);
+
+}
+
+}
+
+#endif
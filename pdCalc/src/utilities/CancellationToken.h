@@ -0,0 +1,159 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace pdCalc {
+
+// Stops an evaluation that another thread cancels or that runs past its budget of
+// steps or time. The evaluating thread calls step() at its safe points, after each
+// command and each control flow instruction, and stops at the first that returns
+// false, so an evaluation is never stopped in the middle of a step. The step budget
+// is checked at every step, and the clock at the first step and every 16th after,
+// which keeps a step to a few instructions. Only the evaluating thread calls
+// restart(), step(), and poll(); any thread may call cancel(), expired(), and
+// steps().
+class CancellationToken
+{
+public:
+    CancellationToken();
+
+    // limits each evaluation to maxSteps steps and maxTime; zero is no limit
+    void setBudget(size_t maxSteps, std::chrono::milliseconds maxTime);
+
+    // begins an evaluation, counting steps from zero and time from now; a pending
+    // cancellation still stops it
+    void restart();
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    // forgets a cancellation, between evaluations
+    void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+
+    // counts a step; false if the evaluation must stop
+    bool step();
+
+    // reads the clock, as the occasional step does; false if the evaluation must stop
+    bool poll();
+
+    // whether the evaluation must stop, as of its last step
+    bool stopped() const { return cancelled() || exceeded_.load(std::memory_order_relaxed) != Exceeded::None; }
+
+    // whether the evaluation must stop, reading the clock rather than relying on
+    // the last step
+    bool expired() const;
+
+    // why the evaluation must stop, for a message
+    const char* reason() const;
+
+    size_t steps() const { return steps_.load(std::memory_order_relaxed); }
+
+private:
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken(CancellationToken&&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+    CancellationToken& operator=(CancellationToken&&) = delete;
+
+    using Clock = std::chrono::steady_clock;
+    enum class Exceeded { None, Steps, Time };
+
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    bool pastDeadline() const { return maxTime_.count() > 0 && Clock::now() > deadline_; }
+
+    std::atomic<bool> cancelled_;
+    std::atomic<Exceeded> exceeded_;
+    std::atomic<size_t> steps_;
+
+    size_t maxSteps_;
+    std::chrono::milliseconds maxTime_;
+    Clock::time_point deadline_;
+};
+
+inline CancellationToken::CancellationToken()
+: cancelled_{false}
+, exceeded_{Exceeded::None}
+, steps_{0}
+, maxSteps_{0}
+, maxTime_{0}
+{ }
+
+inline void CancellationToken::setBudget(size_t maxSteps, std::chrono::milliseconds maxTime)
+{
+    maxSteps_ = maxSteps;
+    maxTime_ = maxTime;
+
+    return;
+}
+
+inline void CancellationToken::restart()
+{
+    steps_.store(0, std::memory_order_relaxed);
+    exceeded_.store(Exceeded::None, std::memory_order_relaxed);
+    if(maxTime_.count() > 0) deadline_ = Clock::now() + maxTime_;
+
+    return;
+}
+
+inline bool CancellationToken::step()
+{
+    const size_t n{ steps_.load(std::memory_order_relaxed) + 1 };
+    steps_.store(n, std::memory_order_relaxed);
+
+    if(maxSteps_ > 0 && n > maxSteps_)
+        exceeded_.store(Exceeded::Steps, std::memory_order_relaxed);
+    else if( (n & 15) == 1 )
+        return poll();
+
+    return !stopped();
+}
+
+inline bool CancellationToken::poll()
+{
+    if( exceeded_.load(std::memory_order_relaxed) == Exceeded::None && pastDeadline() )
+        exceeded_.store(Exceeded::Time, std::memory_order_relaxed);
+
+    return !stopped();
+}
+
+inline bool CancellationToken::expired() const
+{
+    return stopped() || pastDeadline();
+}
+
+inline const char* CancellationToken::reason() const
+{
+    if( cancelled() ) return "Cancelled";
+
+    switch( exceeded_.load(std::memory_order_relaxed) )
+    {
+    case Exceeded::Steps: return "Exceeded the step budget";
+    case Exceeded::Time: return "Exceeded the time budget";
+    case Exceeded::None: break;
+    }
+
+    return pastDeadline() ? "Exceeded the time budget" : "";
+}
+
+}
+
+#endif
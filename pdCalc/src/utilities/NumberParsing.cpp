@@ -0,0 +1,244 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "NumberParsing.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+using std::vector;
+using std::string;
+
+namespace pdCalc {
+
+namespace NumberParsing {
+
+namespace {
+
+const int MaxDigits = 19;
+const uint64_t MaxExactMantissa = uint64_t{1} << 53;
+const int MaxExactPower = 22;
+
+const double Pow10[MaxExactPower + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool isDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+struct SeparatorTable
+{
+    SeparatorTable() : separator{}
+    {
+        for(unsigned char c : {' ', '\t', '\n', '\r', '\v', '\f', ',', ';'})
+            separator[c] = true;
+    }
+
+    bool separator[256];
+};
+
+const SeparatorTable Separators;
+
+inline bool separates(char c)
+{
+    return Separators.separator[ static_cast<unsigned char>(c) ];
+}
+
+// a chunk parses the tokens that start in [begin, end), reading past end to finish
+// its last one; it returns the offset of its first bad token, or n
+size_t parseChunk(const char* text, size_t n, size_t begin, size_t end, vector<double>& x)
+{
+    size_t i{begin};
+    if(i > 0)
+        while( i < end && !separates(text[i - 1]) ) ++i;
+
+    for(;;)
+    {
+        while( i < end && separates(text[i]) ) ++i;
+        if(i >= end) break;
+
+        size_t j{i + 1};
+        while( j < n && !separates(text[j]) ) ++j;
+
+        double d;
+        if( !ParseDouble(text + i, text + j, d) ) return i;
+        x.push_back(d);
+        i = j;
+    }
+
+    return n;
+}
+
+}
+
+bool ParseDouble(const char* first, const char* last, double& d)
+{
+    const char* p{first};
+    bool negative{false};
+    if( p != last && (*p == '+' || *p == '-') )
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // the first MaxDigits significant digits, and the power of ten that scales
+    // them; exact is false if a nonzero digit did not fit
+    uint64_t mantissa{0};
+    int digits{0};
+    long exponent{0};
+    bool exact{true};
+
+    const char* integer{p};
+    for(; p != last && isDigit(*p); ++p)
+    {
+        if(digits < MaxDigits)
+        {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            if(mantissa) ++digits;
+        }
+        else
+        {
+            ++exponent;
+            exact = exact && *p == '0';
+        }
+    }
+    bool anyDigit{ p != integer };
+
+    if(p != last && *p == '.')
+    {
+        const char* fraction{++p};
+        for(; p != last && isDigit(*p); ++p)
+        {
+            if(digits < MaxDigits)
+            {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                if(mantissa) ++digits;
+                --exponent;
+            }
+            else exact = exact && *p == '0';
+        }
+        anyDigit = anyDigit || p != fraction;
+    }
+
+    if(!anyDigit) return false;
+
+    if( p != last && (*p == 'e' || *p == 'E') )
+    {
+        ++p;
+        bool negativeExponent{false};
+        if( p != last && (*p == '+' || *p == '-') )
+        {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+
+        if( p == last || !isDigit(*p) ) return false;
+
+        // far beyond the range of double, so the value is already decided
+        long e{0};
+        for(; p != last && isDigit(*p); ++p)
+            if(e < 100000) e = e * 10 + (*p - '0');
+
+        exponent += negativeExponent ? -e : e;
+    }
+
+    if(p != last) return false;
+
+    if(mantissa == 0)
+        d = 0.0;
+    else if(exact && mantissa <= MaxExactMantissa && exponent >= -MaxExactPower && exponent <= MaxExactPower)
+    {
+        d = static_cast<double>(mantissa);
+        d = exponent < 0 ? d / Pow10[-exponent] : d * Pow10[exponent];
+    }
+    else
+    {
+        // strtod needs a terminated copy; tokens that fit skip the allocation
+        char buffer[64];
+        const size_t length{ static_cast<size_t>(last - first) };
+        if( length < sizeof(buffer) )
+        {
+            std::copy(first, last, buffer);
+            buffer[length] = '\0';
+            d = std::strtod(buffer, nullptr);
+        }
+        else
+            d = std::strtod( string{first, last}.c_str(), nullptr );
+
+        return true;
+    }
+
+    d = negative ? -d : d;
+
+    return true;
+}
+
+bool IsSeparator(char c)
+{
+    return separates(c);
+}
+
+bool ParseText(const char* text, size_t n, vector<double>& x, size_t& badToken)
+{
+    ThreadPool& pool = ThreadPool::Instance();
+    const size_t chunks{ pool.nChunks(n, ParallelThreshold) };
+
+    vector<vector<double>> parts(chunks);
+    vector<size_t> bad(chunks, n);
+    pool.parallelFor(n, ParallelThreshold, [&](size_t chunk, size_t begin, size_t end)
+    {
+        parts[chunk].reserve( (end - begin) / 16 );
+        bad[chunk] = parseChunk(text, n, begin, end, parts[chunk]);
+    });
+
+    for(size_t c = 0; c < chunks; ++c)
+    {
+        if(bad[c] < n)
+        {
+            badToken = bad[c];
+            return false;
+        }
+    }
+
+    if(chunks == 1)
+    {
+        x.swap( parts[0] );
+        return true;
+    }
+
+    vector<size_t> offsets(chunks + 1, 0);
+    for(size_t c = 0; c < chunks; ++c)
+        offsets[c + 1] = offsets[c] + parts[c].size();
+
+    vector<double> all( offsets[chunks] );
+    pool.parallelFor(chunks, 1, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t c = begin; c < end; ++c)
+            std::copy( parts[c].begin(), parts[c].end(), all.begin() + offsets[c] );
+    });
+    x.swap(all);
+
+    return true;
+}
+
+}
+
+}
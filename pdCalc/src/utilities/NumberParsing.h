@@ -0,0 +1,53 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NUMBER_PARSING_H
+#define NUMBER_PARSING_H
+
+#include <cstddef>
+#include <vector>
+
+namespace pdCalc {
+
+// Parsing of decimal numbers straight from memory, for bulk input that would be
+// slow through the tokenizer. Numbers have the syntax the tokenizer accepts: an
+// optional sign, digits with an optional decimal point, and an optional exponent.
+namespace NumberParsing {
+
+// Parses the whole of [first, last) as a number, returning false if it is not one.
+// Numbers of at most 19 significant digits whose value and power of ten are exact
+// doubles are converted with a single correctly rounded multiply or divide; the
+// rest go through strtod, so every result is the correctly rounded double.
+// Magnitudes beyond the range of double become infinity or zero.
+bool ParseDouble(const char* first, const char* last, double& d);
+
+// whitespace, commas and semicolons separate the numbers of a text
+bool IsSeparator(char c);
+
+// Parses every number in the n characters of text into x, in order, returning
+// false, with the offset of the first token that is not a number in badToken, if
+// there is one. Texts of at least ParallelThreshold characters are split across
+// the program's ThreadPool.
+const size_t ParallelThreshold = size_t{1} << 20;
+bool ParseText(const char* text, size_t n, std::vector<double>& x, size_t& badToken);
+
+}
+
+}
+
+#endif
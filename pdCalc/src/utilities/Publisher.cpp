@@ -44,7 +44,7 @@ public:
     
     void attach(const string& eventName, unique_ptr<Observer> observer);
     unique_ptr<Observer> detach(const string& eventName, const string& observer);
-    void notify(const string& eventName, shared_ptr<EventData> d) const;
+    void notify(const string& eventName, const shared_ptr<EventData>& d) const;
     void registerEvent(const string& eventName);
     void registerEvents(const vector<string>& eventNames);
     set<string> listEvents() const;
@@ -120,7 +120,7 @@ unique_ptr<Observer> Publisher::PublisherImpl::detach(const string& eventName, c
     return tmp;
 }
 
-void Publisher::PublisherImpl::notify(const string& eventName, shared_ptr<EventData> d) const
+void Publisher::PublisherImpl::notify(const string& eventName, const shared_ptr<EventData>& d) const
 {
     auto ev = findCheckedEvent(eventName);
     const auto& obsList = ev->second;
@@ -196,7 +196,7 @@ unique_ptr<Observer> Publisher::detach(const string& eventName, const string& ob
     return publisherImpl_->detach(eventName, observer);
 }
 
-void Publisher::raise(const string& eventName, std::shared_ptr<EventData> d) const
+void Publisher::raise(const string& eventName, const std::shared_ptr<EventData>& d) const
 {
     publisherImpl_->notify(eventName, d);
     return;
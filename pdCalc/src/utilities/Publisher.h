@@ -56,7 +56,7 @@ public:
 protected:
     ~Publisher();
 
-    void raise(const std::string& eventName, std::shared_ptr<EventData>) const;
+    void raise(const std::string& eventName, const std::shared_ptr<EventData>&) const;
 
     void registerEvent(const std::string& eventName);
     void registerEvents(const std::vector<std::string>& eventNames);
@@ -0,0 +1,101 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STACK_CHANGE_H
+#define STACK_CHANGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace pdCalc {
+
+// The change to the stack that one StackChanged event describes: popped elements
+// left the top of the stack, and then pushed elements arrived, so that the top
+// pushed of the size elements are new. Changes made with the event suppressed are
+// folded into the next event raised. generation numbers the events, so an observer
+// that sees a gap has missed a change.
+struct StackChange
+{
+    size_t popped;
+    size_t pushed;
+    size_t size;
+    uint64_t generation;
+};
+
+// the generation of a view that does not know which changes it reflects, and so is
+// rebuilt by the next one
+const uint64_t UnknownGeneration = ~uint64_t{0};
+
+// Brings view, the top elements of the stack, top first, up to date with change,
+// touching only the elements the change moved. The view holds at most n elements;
+// element(depth) supplies the element at depth below the top (0 is the top) after
+// the change, and is called only for the pushed elements and for those that rise
+// into view from below. generation is the last change applied, and a gap, or
+// UnknownGeneration, rebuilds the whole view.
+template<typename View, typename Element>
+void ApplyStackChange(const StackChange& change, View& view, size_t n, uint64_t& generation, Element element)
+{
+    const size_t visible{ std::min(change.size, n) };
+
+    if(generation == UnknownGeneration || change.generation != generation + 1)
+    {
+        view.clear();
+        for(size_t depth = 0; depth < visible; ++depth)
+            view.push_back( element(depth) );
+    }
+    else
+    {
+        view.erase( view.begin(), view.begin() + std::min(change.popped, view.size()) );
+
+        const size_t arrived{ std::min(change.pushed, n) };
+        view.insert( view.begin(), arrived, typename View::value_type{} );
+        for(size_t depth = 0; depth < arrived; ++depth)
+            view[depth] = element(depth);
+
+        if(view.size() > visible)
+            view.erase( view.begin() + visible, view.end() );
+
+        while(view.size() < visible)
+            view.push_back( element( view.size() ) );
+    }
+
+    generation = change.generation;
+
+    return;
+}
+
+// The change that first and then second make together, as a single event would
+// describe it, with second's size and generation.
+inline StackChange ComposeStackChanges(const StackChange& first, const StackChange& second)
+{
+    StackChange both{first.popped, first.pushed, second.size, second.generation};
+    if(second.popped <= first.pushed)
+        both.pushed = first.pushed - second.popped + second.pushed;
+    else
+    {
+        both.popped = first.popped + second.popped - first.pushed;
+        both.pushed = second.pushed;
+    }
+
+    return both;
+}
+
+}
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPool.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+using std::vector;
+using std::deque;
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+using std::condition_variable;
+using std::shared_ptr;
+using std::function;
+
+namespace pdCalc {
+
+namespace {
+
+// State of one parallelFor. Chunks are claimed through an atomic counter by the
+// caller and by any worker that picks up a helper task, so it does not matter
+// how many helpers actually get to run.
+struct Loop
+{
+    Loop(size_t n, size_t chunks, const function<void(size_t, size_t, size_t)>& f)
+    : n_{n}, chunks_{chunks}, f_(f), next_{0}, finished_{0}
+    { }
+
+    // runs chunks until none are left to claim
+    void work()
+    {
+        for(size_t c = next_++; c < chunks_; c = next_++)
+        {
+            try
+            {
+                f_(c, c * n_ / chunks_, (c + 1) * n_ / chunks_);
+            }
+            catch(...)
+            {
+                lock_guard<mutex> lock{m_};
+                if(!error_) error_ = std::current_exception();
+            }
+
+            lock_guard<mutex> lock{m_};
+            if(++finished_ == chunks_) done_.notify_all();
+        }
+
+        return;
+    }
+
+    void wait()
+    {
+        unique_lock<mutex> lock{m_};
+        done_.wait(lock, [this]{ return finished_ == chunks_; });
+
+        return;
+    }
+
+    const size_t n_;
+    const size_t chunks_;
+    const function<void(size_t, size_t, size_t)>& f_;
+    std::atomic<size_t> next_;
+    size_t finished_;
+    std::exception_ptr error_;
+    mutex m_;
+    condition_variable done_;
+};
+
+}
+
+class ThreadPool::ThreadPoolImpl
+{
+public:
+    ThreadPoolImpl();
+    ~ThreadPoolImpl();
+
+    size_t concurrency() const { return workers_.size() + 1; }
+    size_t nChunks(size_t n, size_t minChunk) const;
+    void parallelFor(size_t n, size_t minChunk, const function<void(size_t, size_t, size_t)>& f);
+
+private:
+    void run();
+
+    vector<std::thread> workers_;
+    deque<shared_ptr<Loop>> queue_;
+    mutex m_;
+    condition_variable ready_;
+    bool stop_;
+};
+
+ThreadPool::ThreadPoolImpl::ThreadPoolImpl()
+: stop_{false}
+{
+    unsigned int hw{ std::thread::hardware_concurrency() };
+    size_t nWorkers{ hw > 1 ? hw - 1 : 0 };
+
+    for(size_t i = 0; i < nWorkers; ++i)
+        workers_.emplace_back( [this]{ run(); } );
+}
+
+ThreadPool::ThreadPoolImpl::~ThreadPoolImpl()
+{
+    {
+        lock_guard<mutex> lock{m_};
+        stop_ = true;
+    }
+    ready_.notify_all();
+
+    for(auto& t : workers_)
+        t.join();
+}
+
+void ThreadPool::ThreadPoolImpl::run()
+{
+    for(;;)
+    {
+        shared_ptr<Loop> loop;
+        {
+            unique_lock<mutex> lock{m_};
+            ready_.wait(lock, [this]{ return stop_ || !queue_.empty(); });
+            if(stop_ && queue_.empty()) return;
+
+            loop = std::move( queue_.front() );
+            queue_.pop_front();
+        }
+
+        loop->work();
+    }
+}
+
+size_t ThreadPool::ThreadPoolImpl::nChunks(size_t n, size_t minChunk) const
+{
+    if(n == 0) return 0;
+
+    size_t maxChunks{ minChunk > 0 ? std::max(n / minChunk, size_t{1}) : n };
+    return std::min(concurrency(), maxChunks);
+}
+
+void ThreadPool::ThreadPoolImpl::parallelFor(size_t n, size_t minChunk, const function<void(size_t, size_t, size_t)>& f)
+{
+    size_t chunks{ nChunks(n, minChunk) };
+    if(chunks == 0) return;
+    if(chunks == 1)
+    {
+        f(0, 0, n);
+        return;
+    }
+
+    auto loop = std::make_shared<Loop>(n, chunks, f);
+    {
+        lock_guard<mutex> lock{m_};
+        for(size_t i = 1; i < chunks; ++i)
+            queue_.push_back(loop);
+    }
+    ready_.notify_all();
+
+    loop->work();
+    loop->wait();
+
+    // helpers that start after the loop finished find no chunks and never touch f
+    if(loop->error_) std::rethrow_exception(loop->error_);
+
+    return;
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+    static ThreadPool instance;
+    return instance;
+}
+
+ThreadPool::ThreadPool()
+: pimpl_{ new ThreadPoolImpl }
+{ }
+
+ThreadPool::~ThreadPool()
+{ }
+
+size_t ThreadPool::concurrency() const
+{
+    return pimpl_->concurrency();
+}
+
+size_t ThreadPool::nChunks(size_t n, size_t minChunk) const
+{
+    return pimpl_->nChunks(n, minChunk);
+}
+
+void ThreadPool::parallelFor(size_t n, size_t minChunk, const function<void(size_t, size_t, size_t)>& f)
+{
+    pimpl_->parallelFor(n, minChunk, f);
+    return;
+}
+
+}
@@ -0,0 +1,65 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace pdCalc {
+
+// A fixed set of worker threads shared by the whole program for data parallel
+// loops. parallelFor blocks until every chunk has finished, so callers can treat it
+// as an ordinary loop. The calling thread always works on its own loop, so a
+// parallelFor issued while the workers are busy (or from inside a worker) still
+// completes; it simply runs with less help.
+class ThreadPool
+{
+    class ThreadPoolImpl;
+public:
+    static ThreadPool& Instance();
+
+    // number of threads that can take part in a parallelFor, including the caller
+    size_t concurrency() const;
+
+    // number of chunks parallelFor will split n elements into given the minimum
+    // chunk size; useful for sizing per chunk partial results
+    size_t nChunks(size_t n, size_t minChunk) const;
+
+    // Splits [0, n) into nChunks(n, minChunk) contiguous chunks and calls
+    // f(chunk, begin, end) once for each, possibly concurrently. The partition
+    // depends only on n, minChunk, and concurrency(). If f throws, the first
+    // exception is rethrown in the caller after all chunks have finished.
+    void parallelFor(size_t n, size_t minChunk, const std::function<void(size_t, size_t, size_t)>& f);
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    std::unique_ptr<ThreadPoolImpl> pimpl_;
+};
+
+}
+
+#endif
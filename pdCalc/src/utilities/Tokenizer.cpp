@@ -20,6 +20,7 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <cctype>
 
 using std::string;
 using std::istringstream;
@@ -51,4 +52,42 @@ void Tokenizer::tokenize(std::istream& is)
         std::transform(i.begin(), i.end(), i.begin(), ::tolower);
 }
 
+// checks if this is a valid double number, [+-]digits[.digits][(e|E)[+-]digits]
+// with digits optional before and after the decimal point, and if so, converts it
+// into one and returns it
+// The check scans the token by hand; a regex match allocated on every number, and
+// both the dispatcher and the procedure optimizer check every token.
+bool TokenIsNumber(const Tokenizer::Token& s, double& d)
+{
+     if(s == "+" || s == "-") return false;
+
+     auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+     auto i = s.begin();
+     auto digits = [&]() { auto start = i; while(i != s.end() && isDigit(*i)) ++i; return i != start; };
+
+     // every number starts with a sign, a digit, or a decimal point
+     if( s.empty() || !(isDigit(s[0]) || s[0] == '+' || s[0] == '-' || s[0] == '.') )
+         return false;
+
+     if(*i == '+' || *i == '-') ++i;
+     digits();
+     if(i != s.end() && *i == '.')
+     {
+         ++i;
+         digits();
+     }
+     if(i != s.end() && (*i == 'e' || *i == 'E'))
+     {
+         ++i;
+         if(i != s.end() && (*i == '+' || *i == '-')) ++i;
+         if( !digits() ) return false;
+     }
+
+     if(i != s.end()) return false;
+
+     d = std::stod(s);
+
+     return true;
+}
+
 }
@@ -55,6 +55,9 @@ private:
     Tokens tokens_;
 };
 
+// true if the token is a decimal number, which is then converted into d
+bool TokenIsNumber(const Tokenizer::Token& token, double& d);
+
 }
 
 #endif
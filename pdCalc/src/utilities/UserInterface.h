@@ -21,6 +21,7 @@
 
 #include <string>
 #include "Publisher.h"
+#include "StackChange.h"
 
 namespace pdCalc {
 
@@ -46,6 +47,10 @@ public:
     // notifies the interface that the stack has changed
     virtual void stackChanged() = 0;
 
+    // notifies the interface of how the stack changed, so that it can update its
+    // view of the stack incrementally; by default, it rebuilds with stackChanged()
+    virtual void stackChangedBy(const StackChange&) { stackChanged(); }
+
     using Publisher::attach;
     using Publisher::detach;
 
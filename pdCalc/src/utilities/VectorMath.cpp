@@ -0,0 +1,453 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "VectorMath.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+// the AVX2 kernels are compiled for that instruction set function by function, so
+// the rest of the library still runs on any SSE2 processor
+#if defined(__SSE2__) && defined(__GNUC__)
+#define VECTOR_MATH_AVX2
+#endif
+
+namespace pdCalc {
+
+namespace VectorMath {
+
+namespace {
+
+using Function = void (*)(const double*, double*, size_t);
+
+struct Kernels
+{
+    Function sin, cos, tan, asin, acos, atan;
+    Function exp, log, sinh, cosh, tanh, asinh, acosh, atanh;
+};
+
+const double Infinity = std::numeric_limits<double>::infinity();
+const double NotANumber = std::numeric_limits<double>::quiet_NaN();
+
+// adding and subtracting 1.5 * 2^52 rounds to the nearest integer, which is then
+// also held, in two's complement, in the low bits of the sum
+const double RoundingMagic = 6755399441055744.0;
+
+const double TwoTo52 = 4503599627370496.0;
+const double TwoTo54 = 18014398509481984.0;
+const double TwoTo28 = 268435456.0;
+const double TwoToMinus16 = 1.52587890625e-05;
+const double TwoToMinus27 = 7.450580596923828125e-09;
+const double TwoToMinus49 = 1.7763568394002504646778106689453125e-15;
+
+const double Ln2 = 6.93147180559945286227e-01;
+const double Ln2Hi = 6.93147180369123816490e-01;
+const double Ln2Lo = 1.90821492927058770002e-10;
+const double InvLn2 = 1.44269504088896338700e+00;
+const double Sqrt2 = 1.41421356237309514547e+00;
+
+// beyond these, exp is infinite or zero
+const double ExpOverflow = 7.09782712893383973096e+02;
+const double ExpUnderflow = -7.45133219101941108420e+02;
+
+// pi/2 in 33 bit pieces, each followed by the remainder of pi/2 after it
+const double InvPio2 = 6.36619772367581382433e-01;
+const double Pio2_1 = 1.57079632673412561417e+00;
+const double Pio2_1t = 6.07710050650619224932e-11;
+const double Pio2_2 = 6.07710050630396597660e-11;
+const double Pio2_2t = 2.02226624879595063154e-21;
+const double Pio2_3 = 2.02226624871116645580e-21;
+const double Pio2_3t = 8.47842766036889956997e-32;
+
+// 2^19 pi/2, the largest argument fn * Pio2_1 is exact for
+const double MaxTrigReduction = 8.23549664582963928346e+05;
+
+const double SinCoefficients[] = {
+    -1.66666666666666324348e-01, 8.33333333332248946124e-03,
+    -1.98412698298579493134e-04, 2.75573137070700676789e-06,
+    -2.50507602534068634195e-08, 1.58969099521155010221e-10
+};
+
+const double CosCoefficients[] = {
+    4.16666666666666019037e-02, -1.38888888888741095749e-03,
+    2.48015872894767294178e-05, -2.75573143513906633035e-07,
+    2.08757232129817482790e-09, -1.13596475577881948265e-11
+};
+
+// atan(0.5), atan(1), atan(1.5), atan(inf)
+const double AtanHi[] = {
+    4.63647609000806093515e-01, 7.85398163397448278999e-01,
+    9.82793723247329054082e-01, 1.57079632679489655800e+00
+};
+
+const double AtanLo[] = {
+    2.26987774529616870924e-17, 3.06161699786838301793e-17,
+    1.39033110312309984516e-17, 6.12323399573676603587e-17
+};
+
+const double AtanEven[] = {
+    3.33333333333329318027e-01, 1.42857142725034663711e-01,
+    9.09088713343650656196e-02, 6.66107313738753120669e-02,
+    4.97687799461593236017e-02, 1.62858201153657823623e-02
+};
+
+const double AtanOdd[] = {
+    -1.99999999998764832476e-01, -1.11111104054623557880e-01,
+    -7.69187620504482999495e-02, -5.83357013379057348645e-02,
+    -3.65315727442169155270e-02
+};
+
+const double ExpCoefficients[] = {
+    1.66666666666666019037e-01, -2.77777777770155933842e-03,
+    6.61375632143793436117e-05, -1.65339022054652515390e-06,
+    4.13813679705723846039e-08
+};
+
+const double LogOdd[] = {
+    6.666666666666735130e-01, 2.857142874366239149e-01,
+    1.818357216161805012e-01, 1.479819860511658591e-01
+};
+
+const double LogEven[] = {
+    3.999999999940941908e-01, 2.222219843214978396e-01,
+    1.531383769920937332e-01
+};
+
+// 1/3!, 1/5!, ..., 1/17!
+const double SinhCoefficients[] = {
+    1.0 / 6, 1.0 / 120, 1.0 / 5040, 1.0 / 362880, 1.0 / 39916800,
+    1.0 / 6227020800.0, 1.0 / 1307674368000.0, 1.0 / 355687428096000.0
+};
+
+template<double (*F)(double)>
+void ApplyScalar(const double* x, double* y, size_t n)
+{
+    for(size_t i = 0; i < n; ++i)
+        y[i] = F(x[i]);
+
+    return;
+}
+
+double LibmSin(double x) { return std::sin(x); }
+double LibmCos(double x) { return std::cos(x); }
+double LibmTan(double x) { return std::tan(x); }
+double LibmAsin(double x) { return std::asin(x); }
+double LibmAcos(double x) { return std::acos(x); }
+double LibmAtan(double x) { return std::atan(x); }
+double LibmExp(double x) { return std::exp(x); }
+double LibmLog(double x) { return std::log(x); }
+double LibmSinh(double x) { return std::sinh(x); }
+double LibmCosh(double x) { return std::cosh(x); }
+double LibmTanh(double x) { return std::tanh(x); }
+double LibmAsinh(double x) { return std::asinh(x); }
+double LibmAcosh(double x) { return std::acosh(x); }
+double LibmAtanh(double x) { return std::atanh(x); }
+
+const Kernels ScalarTable = {
+    ApplyScalar<LibmSin>, ApplyScalar<LibmCos>, ApplyScalar<LibmTan>, ApplyScalar<LibmAsin>,
+    ApplyScalar<LibmAcos>, ApplyScalar<LibmAtan>, ApplyScalar<LibmExp>, ApplyScalar<LibmLog>,
+    ApplyScalar<LibmSinh>, ApplyScalar<LibmCosh>, ApplyScalar<LibmTanh>, ApplyScalar<LibmAsinh>,
+    ApplyScalar<LibmAcosh>, ApplyScalar<LibmAtanh>
+};
+
+#ifdef __SSE2__
+
+namespace sse2 {
+
+struct Vd { __m128d v; };
+
+const size_t Lanes = 2;
+
+inline Vd Set(double a) { return Vd{ _mm_set1_pd(a) }; }
+inline Vd Load(const double* p) { return Vd{ _mm_load_pd(p) }; }
+inline Vd LoadU(const double* p) { return Vd{ _mm_loadu_pd(p) }; }
+inline void Store(double* p, Vd a) { _mm_store_pd(p, a.v); }
+inline void StoreU(double* p, Vd a) { _mm_storeu_pd(p, a.v); }
+
+inline Vd operator+(Vd a, Vd b) { return Vd{ _mm_add_pd(a.v, b.v) }; }
+inline Vd operator-(Vd a, Vd b) { return Vd{ _mm_sub_pd(a.v, b.v) }; }
+inline Vd operator*(Vd a, Vd b) { return Vd{ _mm_mul_pd(a.v, b.v) }; }
+inline Vd operator/(Vd a, Vd b) { return Vd{ _mm_div_pd(a.v, b.v) }; }
+inline Vd Sqrt(Vd a) { return Vd{ _mm_sqrt_pd(a.v) }; }
+inline Vd Min(Vd a, Vd b) { return Vd{ _mm_min_pd(a.v, b.v) }; }
+inline Vd Max(Vd a, Vd b) { return Vd{ _mm_max_pd(a.v, b.v) }; }
+
+inline Vd And(Vd a, Vd b) { return Vd{ _mm_and_pd(a.v, b.v) }; }
+inline Vd Or(Vd a, Vd b) { return Vd{ _mm_or_pd(a.v, b.v) }; }
+inline Vd Xor(Vd a, Vd b) { return Vd{ _mm_xor_pd(a.v, b.v) }; }
+inline Vd Abs(Vd a) { return Vd{ _mm_andnot_pd(_mm_set1_pd(-0.0), a.v) }; }
+
+// comparisons give masks of all ones or all zeros per lane
+inline Vd Less(Vd a, Vd b) { return Vd{ _mm_cmplt_pd(a.v, b.v) }; }
+inline Vd LessEqual(Vd a, Vd b) { return Vd{ _mm_cmple_pd(a.v, b.v) }; }
+inline Vd Greater(Vd a, Vd b) { return Vd{ _mm_cmpgt_pd(a.v, b.v) }; }
+inline Vd GreaterEqual(Vd a, Vd b) { return Vd{ _mm_cmpge_pd(a.v, b.v) }; }
+inline Vd Equal(Vd a, Vd b) { return Vd{ _mm_cmpeq_pd(a.v, b.v) }; }
+inline Vd IsNan(Vd a) { return Vd{ _mm_cmpunord_pd(a.v, a.v) }; }
+inline Vd Select(Vd m, Vd a, Vd b) { return Vd{ _mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v)) }; }
+inline bool Any(Vd m) { return _mm_movemask_pd(m.v) != 0; }
+
+inline Vd Round(Vd a) { return (a + Set(RoundingMagic)) - Set(RoundingMagic); }
+
+// 2^k for integral k in [-1022, 1023]
+inline Vd Pow2(Vd k)
+{
+    __m128i b = _mm_castpd_si128( (k + Set(RoundingMagic)).v );
+    b = _mm_add_epi64( b, _mm_set1_epi64x(1023 - 0x4338000000000000LL) );
+    return Vd{ _mm_castsi128_pd(_mm_slli_epi64(b, 52)) };
+}
+
+// mask of the lanes where bit B of the integer held by RoundingMagic + k is set
+template<int B>
+inline Vd LowBit(Vd t)
+{
+    __m128i b = _mm_slli_epi64( _mm_castpd_si128(t.v), 62 - B );
+    b = _mm_and_si128( b, _mm_set1_epi64x(0x4000000000000000LL) );
+    return Vd{ _mm_cmpneq_pd(_mm_castsi128_pd(b), _mm_setzero_pd()) };
+}
+
+// biased exponent and significand in [1, 2) of positive normal numbers
+inline Vd Exponent(Vd a)
+{
+    __m128i b = _mm_srli_epi64( _mm_castpd_si128(a.v), 52 );
+    b = _mm_or_si128( b, _mm_set1_epi64x(0x4330000000000000LL) );
+    return Vd{ _mm_castsi128_pd(b) } - Set(TwoTo52);
+}
+
+inline Vd Mantissa(Vd a)
+{
+    __m128i b = _mm_and_si128( _mm_castpd_si128(a.v), _mm_set1_epi64x(0x000fffffffffffffLL) );
+    b = _mm_or_si128( b, _mm_set1_epi64x(0x3ff0000000000000LL) );
+    return Vd{ _mm_castsi128_pd(b) };
+}
+
+#include "VectorMathKernels.h"
+
+}
+
+#endif
+
+#ifdef VECTOR_MATH_AVX2
+
+#ifdef __clang__
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace avx2 {
+
+struct Vd { __m256d v; };
+
+const size_t Lanes = 4;
+
+inline Vd Set(double a) { return Vd{ _mm256_set1_pd(a) }; }
+inline Vd Load(const double* p) { return Vd{ _mm256_load_pd(p) }; }
+inline Vd LoadU(const double* p) { return Vd{ _mm256_loadu_pd(p) }; }
+inline void Store(double* p, Vd a) { _mm256_store_pd(p, a.v); }
+inline void StoreU(double* p, Vd a) { _mm256_storeu_pd(p, a.v); }
+
+inline Vd operator+(Vd a, Vd b) { return Vd{ _mm256_add_pd(a.v, b.v) }; }
+inline Vd operator-(Vd a, Vd b) { return Vd{ _mm256_sub_pd(a.v, b.v) }; }
+inline Vd operator*(Vd a, Vd b) { return Vd{ _mm256_mul_pd(a.v, b.v) }; }
+inline Vd operator/(Vd a, Vd b) { return Vd{ _mm256_div_pd(a.v, b.v) }; }
+inline Vd Sqrt(Vd a) { return Vd{ _mm256_sqrt_pd(a.v) }; }
+inline Vd Min(Vd a, Vd b) { return Vd{ _mm256_min_pd(a.v, b.v) }; }
+inline Vd Max(Vd a, Vd b) { return Vd{ _mm256_max_pd(a.v, b.v) }; }
+
+inline Vd And(Vd a, Vd b) { return Vd{ _mm256_and_pd(a.v, b.v) }; }
+inline Vd Or(Vd a, Vd b) { return Vd{ _mm256_or_pd(a.v, b.v) }; }
+inline Vd Xor(Vd a, Vd b) { return Vd{ _mm256_xor_pd(a.v, b.v) }; }
+inline Vd Abs(Vd a) { return Vd{ _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v) }; }
+
+inline Vd Less(Vd a, Vd b) { return Vd{ _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+inline Vd LessEqual(Vd a, Vd b) { return Vd{ _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ) }; }
+inline Vd Greater(Vd a, Vd b) { return Vd{ _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+inline Vd GreaterEqual(Vd a, Vd b) { return Vd{ _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ) }; }
+inline Vd Equal(Vd a, Vd b) { return Vd{ _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ) }; }
+inline Vd IsNan(Vd a) { return Vd{ _mm256_cmp_pd(a.v, a.v, _CMP_UNORD_Q) }; }
+inline Vd Select(Vd m, Vd a, Vd b) { return Vd{ _mm256_blendv_pd(b.v, a.v, m.v) }; }
+inline bool Any(Vd m) { return _mm256_movemask_pd(m.v) != 0; }
+
+inline Vd Round(Vd a) { return (a + Set(RoundingMagic)) - Set(RoundingMagic); }
+
+inline Vd Pow2(Vd k)
+{
+    __m256i b = _mm256_castpd_si256( (k + Set(RoundingMagic)).v );
+    b = _mm256_add_epi64( b, _mm256_set1_epi64x(1023 - 0x4338000000000000LL) );
+    return Vd{ _mm256_castsi256_pd(_mm256_slli_epi64(b, 52)) };
+}
+
+template<int B>
+inline Vd LowBit(Vd t)
+{
+    __m256i b = _mm256_slli_epi64( _mm256_castpd_si256(t.v), 62 - B );
+    b = _mm256_and_si256( b, _mm256_set1_epi64x(0x4000000000000000LL) );
+    return Vd{ _mm256_cmp_pd(_mm256_castsi256_pd(b), _mm256_setzero_pd(), _CMP_NEQ_OQ) };
+}
+
+inline Vd Exponent(Vd a)
+{
+    __m256i b = _mm256_srli_epi64( _mm256_castpd_si256(a.v), 52 );
+    b = _mm256_or_si256( b, _mm256_set1_epi64x(0x4330000000000000LL) );
+    return Vd{ _mm256_castsi256_pd(b) } - Set(TwoTo52);
+}
+
+inline Vd Mantissa(Vd a)
+{
+    __m256i b = _mm256_and_si256( _mm256_castpd_si256(a.v), _mm256_set1_epi64x(0x000fffffffffffffLL) );
+    b = _mm256_or_si256( b, _mm256_set1_epi64x(0x3ff0000000000000LL) );
+    return Vd{ _mm256_castsi256_pd(b) };
+}
+
+#include "VectorMathKernels.h"
+
+}
+
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
+
+bool Supported(Isa isa)
+{
+    switch(isa)
+    {
+#ifdef __SSE2__
+    case Isa::Sse2:
+        return true;
+#endif
+#ifdef VECTOR_MATH_AVX2
+    case Isa::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    case Isa::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Isa Best()
+{
+    if( Supported(Isa::Avx2) ) return Isa::Avx2;
+    if( Supported(Isa::Sse2) ) return Isa::Sse2;
+    return Isa::Scalar;
+}
+
+std::atomic<Isa>& Active()
+{
+    static std::atomic<Isa> active{ Best() };
+    return active;
+}
+
+const Kernels& ActiveTable()
+{
+    switch( Active().load() )
+    {
+#ifdef VECTOR_MATH_AVX2
+    case Isa::Avx2:
+        return avx2::Table;
+#endif
+#ifdef __SSE2__
+    case Isa::Sse2:
+        return sse2::Table;
+#endif
+    default:
+        return ScalarTable;
+    }
+}
+
+void Run(Function Kernels::* f, const double* x, double* y, size_t n)
+{
+    Function kernel{ ActiveTable().*f };
+    if(n < ParallelThreshold)
+    {
+        kernel(x, y, n);
+    }
+    else
+    {
+        ThreadPool::Instance().parallelFor(n, ParallelThreshold / 2, [&](size_t, size_t begin, size_t end)
+        {
+            kernel(x + begin, y + begin, end - begin);
+        });
+    }
+
+    return;
+}
+
+}
+
+Isa ActiveIsa()
+{
+    return Active().load();
+}
+
+Isa SetIsa(Isa isa)
+{
+    while( !Supported(isa) )
+        isa = isa == Isa::Avx2 ? Isa::Sse2 : Isa::Scalar;
+
+    Active().store(isa);
+
+    return isa;
+}
+
+const char* IsaName(Isa isa)
+{
+    switch(isa)
+    {
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void Sin(const double* x, double* y, size_t n) { Run(&Kernels::sin, x, y, n); }
+void Cos(const double* x, double* y, size_t n) { Run(&Kernels::cos, x, y, n); }
+void Tan(const double* x, double* y, size_t n) { Run(&Kernels::tan, x, y, n); }
+void Asin(const double* x, double* y, size_t n) { Run(&Kernels::asin, x, y, n); }
+void Acos(const double* x, double* y, size_t n) { Run(&Kernels::acos, x, y, n); }
+void Atan(const double* x, double* y, size_t n) { Run(&Kernels::atan, x, y, n); }
+void Exp(const double* x, double* y, size_t n) { Run(&Kernels::exp, x, y, n); }
+void Log(const double* x, double* y, size_t n) { Run(&Kernels::log, x, y, n); }
+void Sinh(const double* x, double* y, size_t n) { Run(&Kernels::sinh, x, y, n); }
+void Cosh(const double* x, double* y, size_t n) { Run(&Kernels::cosh, x, y, n); }
+void Tanh(const double* x, double* y, size_t n) { Run(&Kernels::tanh, x, y, n); }
+void Asinh(const double* x, double* y, size_t n) { Run(&Kernels::asinh, x, y, n); }
+void Acosh(const double* x, double* y, size_t n) { Run(&Kernels::acosh, x, y, n); }
+void Atanh(const double* x, double* y, size_t n) { Run(&Kernels::atanh, x, y, n); }
+
+}
+
+}
@@ -0,0 +1,78 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include <cstddef>
+
+namespace pdCalc {
+
+// Elementwise transcendental functions over contiguous arrays of doubles,
+// y[i] = f(x[i]); x and y may be the same array. The kernels evaluate fdlibm's
+// polynomials several elements at a time with SSE2 or AVX2, whichever the
+// processor supports (decided once, at first use), and produce identical results
+// on either. Arrays of at least ParallelThreshold elements are split across the
+// program's ThreadPool.
+//
+// Maximum errors, in units in the last place of the correctly rounded result, as
+// checked by VectorMathTest against long double references:
+//     Sin, Cos, Atan, Exp, Log                                1
+//     Acos, Asinh                                             2
+//     Tan, Asin, Sinh, Cosh, Tanh, Acosh, Atanh               3
+// Special values (infinities, NaNs, signed zeros, out of domain arguments) give
+// the results of the C library. Sin, Cos, and Tan of arguments beyond 2^19 pi/2
+// (about 8.2e5) in magnitude, where the in-kernel argument reduction is no longer
+// exact, are passed to the C library. Without SSE2, every function is the C
+// library's.
+namespace VectorMath {
+
+const size_t ParallelThreshold = size_t{1} << 15;
+
+enum class Isa { Scalar, Sse2, Avx2 };
+
+// the instruction set in use
+Isa ActiveIsa();
+
+// requests an instruction set, which is limited to what the processor supports,
+// and returns the one in effect; for tests and benchmarks
+Isa SetIsa(Isa);
+
+const char* IsaName(Isa);
+
+void Sin(const double* x, double* y, size_t n);
+void Cos(const double* x, double* y, size_t n);
+void Tan(const double* x, double* y, size_t n);
+void Asin(const double* x, double* y, size_t n);
+void Acos(const double* x, double* y, size_t n);
+void Atan(const double* x, double* y, size_t n);
+
+void Exp(const double* x, double* y, size_t n);
+void Log(const double* x, double* y, size_t n);
+void Sinh(const double* x, double* y, size_t n);
+void Cosh(const double* x, double* y, size_t n);
+void Tanh(const double* x, double* y, size_t n);
+void Asinh(const double* x, double* y, size_t n);
+void Acosh(const double* x, double* y, size_t n);
+void Atanh(const double* x, double* y, size_t n);
+
+}
+
+}
+
+#endif
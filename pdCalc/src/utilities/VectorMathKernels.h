@@ -0,0 +1,406 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+// Vector kernels shared by every instruction set in VectorMath.cpp. This file has
+// no include guard: it is included once inside each instruction set's namespace,
+// after that namespace defines the vector type Vd, its arithmetic operators, and
+// the primitives used below (Set, Select, Less, Pow2, ...). The polynomials and
+// reductions are fdlibm's, evaluated on every lane at once, so each instruction
+// set computes the same roundings in the same order.
+
+// lanes holding the large or non-finite arguments a kernel does not reduce itself
+// are recomputed by the C library
+template<typename F>
+inline Vd PatchLanes(Vd mask, Vd x, Vd y, F f)
+{
+    if( !Any(mask) ) return y;
+
+    alignas(32) double xs[Lanes];
+    alignas(32) double ys[Lanes];
+    alignas(32) double ms[Lanes];
+    Store(xs, x);
+    Store(ys, y);
+    Store(ms, mask);
+    for(size_t i = 0; i < Lanes; ++i)
+        if( std::signbit(ms[i]) ) ys[i] = f(xs[i]);
+
+    return Load(ys);
+}
+
+inline Vd Polynomial(Vd z, const double* c, int n)
+{
+    Vd r{ Set(c[n - 1]) };
+    for(int i = n - 2; i >= 0; --i)
+        r = Set(c[i]) + z * r;
+
+    return r;
+}
+
+// x = n pi/2 + y0 + y1 with |y0 + y1| <= pi/4, for |x| <= MaxTrigReduction; the
+// three step Cody-Waite reduction of fdlibm's __ieee754_rem_pio2, taking the
+// second and third steps only in the lanes where cancellation calls for them
+inline Vd ReducePio2(Vd x, Vd& y0, Vd& y1)
+{
+    const Vd fn{ Round(x * Set(InvPio2)) };
+
+    Vd r{ x - fn * Set(Pio2_1) };
+    Vd w{ fn * Set(Pio2_1t) };
+    y0 = r - w;
+
+    // 2^(exponent of x), against which the cancellation is judged
+    const Vd scale{ And(x, Set(Infinity)) };
+
+    const Vd second{ Less(Abs(y0), scale * Set(TwoToMinus16)) };
+    if( Any(second) )
+    {
+        Vd t{ r };
+        Vd w2{ fn * Set(Pio2_2) };
+        Vd r2{ t - w2 };
+        w2 = fn * Set(Pio2_2t) - ((t - r2) - w2);
+        Vd y2{ r2 - w2 };
+
+        const Vd third{ And( second, Less(Abs(y2), scale * Set(TwoToMinus49)) ) };
+        if( Any(third) )
+        {
+            t = r2;
+            Vd w3{ fn * Set(Pio2_3) };
+            Vd r3{ t - w3 };
+            w3 = fn * Set(Pio2_3t) - ((t - r3) - w3);
+            r2 = Select(third, r3, r2);
+            w2 = Select(third, w3, w2);
+            y2 = r2 - w2;
+        }
+
+        r = Select(second, r2, r);
+        w = Select(second, w2, w);
+        y0 = Select(second, y2, y0);
+    }
+    y1 = (r - y0) - w;
+
+    return fn + Set(RoundingMagic);
+}
+
+// fdlibm's __kernel_sin and __kernel_cos on [-pi/4, pi/4]
+inline Vd KernelSin(Vd x, Vd y)
+{
+    const Vd z{ x * x };
+    const Vd v{ z * x };
+    const Vd r{ Polynomial(z, SinCoefficients + 1, 5) };
+
+    return x - ((z * (Set(0.5) * y - v * r) - y) - v * Set(SinCoefficients[0]));
+}
+
+inline Vd KernelCos(Vd x, Vd y)
+{
+    const Vd z{ x * x };
+    const Vd w{ z * z };
+    const Vd r{ z * Polynomial(z, CosCoefficients, 3) + w * w * Polynomial(z, CosCoefficients + 3, 3) };
+    const Vd hz{ Set(0.5) * z };
+    const Vd u{ Set(1.0) - hz };
+
+    return u + (((Set(1.0) - u) - hz) + (z * r - x * y));
+}
+
+inline Vd NeedsLibmTrig(Vd x)
+{
+    return Or( Greater(Abs(x), Set(MaxTrigReduction)), IsNan(x) );
+}
+
+inline Vd SinV(Vd x)
+{
+    Vd y0, y1;
+    const Vd n{ ReducePio2(x, y0, y1) };
+    const Vd s{ KernelSin(y0, y1) };
+    const Vd c{ KernelCos(y0, y1) };
+
+    Vd r{ Select(LowBit<0>(n), c, s) };
+    r = Xor( r, And(LowBit<1>(n), Set(-0.0)) );
+    r = Select( Less(Abs(x), Set(TwoToMinus27)), x, r );
+
+    return PatchLanes( NeedsLibmTrig(x), x, r, [](double a){ return std::sin(a); } );
+}
+
+inline Vd CosV(Vd x)
+{
+    Vd y0, y1;
+    const Vd n{ ReducePio2(x, y0, y1) };
+    const Vd s{ KernelSin(y0, y1) };
+    const Vd c{ KernelCos(y0, y1) };
+
+    // quadrants 1 and 2 are negative
+    const Vd odd{ LowBit<0>(n) };
+    Vd r{ Select(odd, s, c) };
+    r = Xor( r, And(Xor(odd, LowBit<1>(n)), Set(-0.0)) );
+
+    return PatchLanes( NeedsLibmTrig(x), x, r, [](double a){ return std::cos(a); } );
+}
+
+inline Vd TanV(Vd x)
+{
+    Vd y0, y1;
+    const Vd n{ ReducePio2(x, y0, y1) };
+    const Vd s{ KernelSin(y0, y1) };
+    const Vd c{ KernelCos(y0, y1) };
+
+    const Vd odd{ LowBit<0>(n) };
+    Vd r{ Select(odd, c, s) / Select(odd, s, c) };
+    r = Xor( r, And(odd, Set(-0.0)) );
+    r = Select( Less(Abs(x), Set(TwoToMinus27)), x, r );
+
+    return PatchLanes( NeedsLibmTrig(x), x, r, [](double a){ return std::tan(a); } );
+}
+
+// fdlibm's atan: the argument is mapped into [-7/16, 7/16] about one of four
+// breakpoints whose arctangents are tabulated in two parts
+inline Vd AtanV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    const Vd r0{ GreaterEqual(a, Set(0.4375)) };
+    const Vd r1{ GreaterEqual(a, Set(0.6875)) };
+    const Vd r2{ GreaterEqual(a, Set(1.1875)) };
+    const Vd r3{ GreaterEqual(a, Set(2.4375)) };
+
+    Vd num{ a };
+    Vd den{ Set(1.0) };
+    num = Select( r0, Set(2.0) * a - Set(1.0), num );
+    den = Select( r0, Set(2.0) + a, den );
+    num = Select( r1, a - Set(1.0), num );
+    den = Select( r1, a + Set(1.0), den );
+    num = Select( r2, a - Set(1.5), num );
+    den = Select( r2, Set(1.0) + Set(1.5) * a, den );
+    num = Select( r3, Set(-1.0), num );
+    den = Select( r3, a, den );
+
+    Vd hi{ Set(0.0) };
+    Vd lo{ Set(0.0) };
+    const Vd regions[] = {r0, r1, r2, r3};
+    for(int i = 0; i < 4; ++i)
+    {
+        hi = Select( regions[i], Set(AtanHi[i]), hi );
+        lo = Select( regions[i], Set(AtanLo[i]), lo );
+    }
+
+    const Vd t{ num / den };
+    const Vd z{ t * t };
+    const Vd w{ z * z };
+    const Vd s1{ z * Polynomial(w, AtanEven, 6) };
+    const Vd s2{ w * Polynomial(w, AtanOdd, 5) };
+    const Vd r{ hi - ((t * (s1 + s2) - lo) - t) };
+
+    return Xor(r, sign);
+}
+
+inline Vd AsinV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    Vd r{ AtanV( a / Sqrt((Set(1.0) - a) * (Set(1.0) + a)) ) };
+    r = Select( Greater(a, Set(1.0)), Set(NotANumber), r );
+
+    return Xor(r, sign);
+}
+
+inline Vd AcosV(Vd x)
+{
+    Vd r{ Set(2.0) * AtanV( Sqrt((Set(1.0) - x) / (Set(1.0) + x)) ) };
+
+    return Select( Greater(Abs(x), Set(1.0)), Set(NotANumber), r );
+}
+
+// fdlibm's exp: x = k ln2 + r with |r| <= ln2/2, exp(r) from a rational
+// approximation, and the scaling by 2^k split in two so that neither factor
+// overflows or goes subnormal on its own
+inline Vd ExpV(Vd x)
+{
+    const Vd xc{ Min( Max(x, Set(ExpUnderflow)), Set(ExpOverflow) ) };
+    const Vd k{ Round(xc * Set(InvLn2)) };
+    const Vd hi{ xc - k * Set(Ln2Hi) };
+    const Vd lo{ k * Set(Ln2Lo) };
+    const Vd r{ hi - lo };
+
+    const Vd t{ r * r };
+    const Vd c{ r - t * Polynomial(t, ExpCoefficients, 5) };
+    const Vd y{ Set(1.0) - ((lo - (r * c) / (Set(2.0) - c)) - hi) };
+
+    const Vd k1{ Round(k * Set(0.5)) };
+    Vd e{ y * Pow2(k1) * Pow2(k - k1) };
+
+    e = Select( Greater(x, Set(ExpOverflow)), Set(Infinity), e );
+    e = Select( Less(x, Set(ExpUnderflow)), Set(0.0), e );
+
+    return Select( IsNan(x), x, e );
+}
+
+// fdlibm's log: x = 2^k (1 + f) with sqrt(2)/2 <= 1 + f < sqrt(2), and
+// log(1 + f) = 2s + s R(s^2) for s = f / (2 + f)
+inline Vd LogV(Vd x)
+{
+    const Vd subnormal{ Less(x, Set(std::numeric_limits<double>::min())) };
+    const Vd xs{ Select(subnormal, x * Set(TwoTo54), x) };
+
+    Vd k{ Exponent(xs) - Select(subnormal, Set(1023.0 + 54.0), Set(1023.0)) };
+    Vd m{ Mantissa(xs) };
+    const Vd high{ Greater(m, Set(Sqrt2)) };
+    m = Select( high, m * Set(0.5), m );
+    k = Select( high, k + Set(1.0), k );
+
+    const Vd f{ m - Set(1.0) };
+    const Vd s{ f / (Set(2.0) + f) };
+    const Vd z{ s * s };
+    const Vd w{ z * z };
+    const Vd t1{ w * Polynomial(w, LogEven, 3) };
+    const Vd t2{ z * Polynomial(w, LogOdd, 4) };
+    const Vd hfsq{ Set(0.5) * f * f };
+    Vd r{ k * Set(Ln2Hi) - ((hfsq - (s * (hfsq + t1 + t2) + k * Set(Ln2Lo))) - f) };
+
+    r = Select( Equal(x, Set(Infinity)), x, r );
+    r = Select( Less(x, Set(0.0)), Set(NotANumber), r );
+    r = Select( Equal(x, Set(0.0)), Set(-Infinity), r );
+
+    return Select( IsNan(x), x, r );
+}
+
+// log(1 + x), with the rounding error of forming 1 + x carried as a first order
+// correction
+inline Vd Log1pV(Vd x)
+{
+    const Vd u{ Set(1.0) + x };
+    const Vd c{ (x - (u - Set(1.0))) / u };
+
+    const Vd exact{ Or( Equal(u, Set(Infinity)), Equal(u, Set(0.0)) ) };
+
+    return LogV(u) + Select( exact, Set(0.0), c );
+}
+
+// exp(a/2)^2 for the a at which exp(a) alone overflows
+inline Vd HalfExpSquared(Vd a)
+{
+    const Vd h{ ExpV(Set(0.5) * a) };
+    return (Set(0.5) * h) * h;
+}
+
+// a + a^3/3! + ... + a^17/17!, for |a| <= 1
+inline Vd SinhSeries(Vd a)
+{
+    const Vd z{ a * a };
+    return a + a * z * Polynomial(z, SinhCoefficients, 8);
+}
+
+inline Vd SinhV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    const Vd e{ ExpV(a) };
+    Vd r{ Set(0.5) * (e - Set(1.0) / e) };
+    r = Select( LessEqual(a, Set(1.0)), SinhSeries(a), r );
+
+    const Vd large{ Greater(a, Set(ExpOverflow)) };
+    if( Any(large) ) r = Select( large, HalfExpSquared(a), r );
+
+    return Xor(r, sign);
+}
+
+inline Vd CoshV(Vd x)
+{
+    const Vd a{ Abs(x) };
+
+    const Vd e{ ExpV(a) };
+    Vd r{ Set(0.5) * (e + Set(1.0) / e) };
+
+    const Vd large{ Greater(a, Set(ExpOverflow)) };
+    if( Any(large) ) r = Select( large, HalfExpSquared(a), r );
+
+    return r;
+}
+
+inline Vd TanhV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    const Vd s{ SinhSeries( Min(a, Set(1.0)) ) };
+    const Vd small{ s / Sqrt(Set(1.0) + s * s) };
+    const Vd large{ Set(1.0) - Set(2.0) / (ExpV(Set(2.0) * a) + Set(1.0)) };
+
+    return Xor( Select(Less(a, Set(1.0)), small, large), sign );
+}
+
+inline Vd AsinhV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    const Vd big{ Greater(a, Set(TwoTo28)) };
+    const Vd ab{ Select(big, Set(1.0), a) };
+    const Vd z{ ab * ab };
+    Vd r{ Log1pV( ab + z / (Set(1.0) + Sqrt(Set(1.0) + z)) ) };
+    if( Any(big) ) r = Select( big, LogV(a) + Set(Ln2), r );
+
+    return Xor(r, sign);
+}
+
+inline Vd AcoshV(Vd x)
+{
+    const Vd big{ Greater(x, Set(TwoTo28)) };
+    const Vd t{ Select(big, Set(0.0), x - Set(1.0)) };
+    Vd r{ Log1pV( t + Sqrt(Set(2.0) * t + t * t) ) };
+    if( Any(big) ) r = Select( big, LogV(x) + Set(Ln2), r );
+
+    r = Select( Less(x, Set(1.0)), Set(NotANumber), r );
+    return Select( IsNan(x), x, r );
+}
+
+inline Vd AtanhV(Vd x)
+{
+    const Vd sign{ And(x, Set(-0.0)) };
+    const Vd a{ Abs(x) };
+
+    Vd r{ Set(0.5) * Log1pV( Set(2.0) * a / (Set(1.0) - a) ) };
+    r = Select( Greater(a, Set(1.0)), Set(NotANumber), r );
+
+    return Xor(r, sign);
+}
+
+// y[i] = f(x[i]) over whole vectors, and over a zero padded copy of the tail
+template<Vd (*F)(Vd)>
+void Apply(const double* x, double* y, size_t n)
+{
+    size_t i{0};
+    for(; i + Lanes <= n; i += Lanes)
+        StoreU( y + i, F(LoadU(x + i)) );
+
+    if(i < n)
+    {
+        alignas(32) double tail[Lanes] = {};
+        std::copy(x + i, x + n, tail);
+        Store( tail, F(Load(tail)) );
+        std::copy(tail, tail + (n - i), y + i);
+    }
+
+    return;
+}
+
+const Kernels Table = {
+    Apply<SinV>, Apply<CosV>, Apply<TanV>, Apply<AsinV>, Apply<AcosV>, Apply<AtanV>,
+    Apply<ExpV>, Apply<LogV>, Apply<SinhV>, Apply<CoshV>, Apply<TanhV>,
+    Apply<AsinhV>, Apply<AcoshV>, Apply<AtanhV>
+};
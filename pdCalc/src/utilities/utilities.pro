@@ -14,12 +14,25 @@ HEADERS += Exception.h \
            Observer.h \
            Publisher.h \
            Tokenizer.h \
-           UserInterface.h
+           UserInterface.h \
+           ThreadPool.h \
+           BigNumber.h \
+           VectorMath.h \
+           VectorMathKernels.h \
+           BlockAlgorithms.h \
+           NumberParsing.h \
+           StackChange.h \
+           CancellationToken.h
 
 SOURCES += Observer.cpp \
            Publisher.cpp \
            Tokenizer.cpp \
-           UserInterface.cpp
+           UserInterface.cpp \
+           ThreadPool.cpp \
+           BigNumber.cpp \
+           VectorMath.cpp \
+           BlockAlgorithms.cpp \
+           NumberParsing.cpp
 
 OTHER_FILES += \
     Publisher.o \
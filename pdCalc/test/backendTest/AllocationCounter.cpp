@@ -0,0 +1,168 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// plain zero initialized thread locals: these must not require dynamic
+// initialization since operator new can run before any constructor
+thread_local size_t allocationCount = 0;
+thread_local size_t deallocationCount = 0;
+thread_local size_t allocatedBytes = 0;
+
+void* countedAllocate(std::size_t n)
+{
+    ++allocationCount;
+    allocatedBytes += n;
+
+    if(n == 0) n = 1;
+    for(;;)
+    {
+        void* p = std::malloc(n);
+        if(p) return p;
+
+        std::new_handler handler = std::get_new_handler();
+        if(!handler) throw std::bad_alloc{};
+        handler();
+    }
+}
+
+void countedDeallocate(void* p) noexcept
+{
+    if(!p) return;
+
+    ++deallocationCount;
+    std::free(p);
+
+    return;
+}
+
+}
+
+AllocationCounter::AllocationCounter()
+{
+    reset();
+}
+
+void AllocationCounter::reset()
+{
+    allocations_ = allocationCount;
+    deallocations_ = deallocationCount;
+    bytes_ = allocatedBytes;
+
+    return;
+}
+
+size_t AllocationCounter::allocations() const
+{
+    return allocationCount - allocations_;
+}
+
+size_t AllocationCounter::deallocations() const
+{
+    return deallocationCount - deallocations_;
+}
+
+size_t AllocationCounter::bytes() const
+{
+    return allocatedBytes - bytes_;
+}
+
+#ifdef WIN32
+
+// operators replaced in a DLL only affect that DLL on Windows, so no counting is done
+bool AllocationCounter::Active()
+{
+    return false;
+}
+
+#else
+
+bool AllocationCounter::Active()
+{
+    return true;
+}
+
+void* operator new(std::size_t n)
+{
+    return countedAllocate(n);
+}
+
+void* operator new[](std::size_t n)
+{
+    return countedAllocate(n);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return countedAllocate(n);
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return countedAllocate(n);
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    countedDeallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedDeallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    countedDeallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    countedDeallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    countedDeallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    countedDeallocate(p);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Test only allocation tracker. The test library replaces the global operator new
+// and operator delete with versions that count calls made by the current thread.
+// An AllocationCounter reports the allocations made by its thread since it was
+// constructed, so a scope is measured simply by declaring a counter at its start.
+// Counting is per thread so that allocations made elsewhere in the process do not
+// pollute a measurement.
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+
+    size_t allocations() const;
+    size_t deallocations() const;
+    size_t bytes() const;
+
+    // restarts the measurement from the current point
+    void reset();
+
+    // false on platforms where the global operator new cannot be replaced from a
+    // shared library (Windows DLLs); tests should skip rather than fail there
+    static bool Active();
+
+private:
+    size_t allocations_;
+    size_t deallocations_;
+    size_t bytes_;
+};
+
+#endif
@@ -0,0 +1,222 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "AllocationTest.h"
+#include "AllocationCounter.h"
+#include "src/backend/Stack.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/CommandManager.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/StoredProcedure.h"
+#include "src/utilities/UserInterface.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <memory>
+
+using std::vector;
+using std::string;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    TestInterface() { }
+    void postMessage(const string&) override { }
+    void stackChanged() override { }
+};
+
+// number of times each measured operation is repeated; large enough that
+// amortized growth of a container would show up
+const int Repetitions = 1000;
+
+// Upper bound on allocations for a 1000 token procedure. Each token creates one
+// command (about 1000 in total); the rest covers reading, tokenizing, and
+// optimizing the file and growing the undo stack.
+// Raise this only with a reason.
+const size_t ProcedureAllocationBudget = 1500;
+
+void warmStack(int n)
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+
+    // grow past anything the tests push, then shrink back to n
+    for(int i = 0; i < Repetitions + n; ++i)
+        stack.push(1.0, true);
+
+    while( static_cast<int>( stack.size() ) > n )
+        stack.pop(true);
+
+    return;
+}
+
+}
+
+void AllocationTest::testCounter()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    AllocationCounter counter;
+    auto p = std::make_unique<vector<double>>(100);
+    QVERIFY(p->size() == 100);
+    QCOMPARE(counter.allocations(), size_t{2});
+    QVERIFY(counter.bytes() >= 100 * sizeof(double));
+
+    p.reset();
+    QCOMPARE(counter.deallocations(), size_t{2});
+
+    counter.reset();
+    QCOMPARE(counter.allocations(), size_t{0});
+
+    return;
+}
+
+void AllocationTest::testStackPushPop()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    warmStack(0);
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    AllocationCounter counter;
+    for(int i = 0; i < Repetitions; ++i)
+        stack.push(i);
+    for(int i = 0; i < Repetitions; ++i)
+        stack.pop();
+
+    QCOMPARE(counter.allocations(), size_t{0});
+
+    return;
+}
+
+// Once a session is warmed up, executing and undoing + must not touch the heap.
+// The command object itself comes from the repository's clone, which is made
+// before the measurement starts.
+void AllocationTest::testExecuteAdd()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    warmStack(2);
+    pdCalc::CommandManager cm{pdCalc::CommandManager::UndoRedoStrategy::ListStrategyVector};
+    cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::Add>() );
+    cm.undo();
+
+    size_t allocations{0};
+    for(int i = 0; i < Repetitions; ++i)
+    {
+        auto c = pdCalc::MakeCommandPtr<pdCalc::Add>();
+
+        AllocationCounter counter;
+        cm.executeCommand( std::move(c) );
+        cm.undo();
+        allocations += counter.allocations();
+    }
+
+    QCOMPARE(allocations, size_t{0});
+
+    return;
+}
+
+// Through the dispatcher, + and undo cost exactly the one cloned command.
+void AllocationTest::testDispatchAdd()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+
+    warmStack(2);
+    pdCalc::CommandDispatcher ce{ui};
+    ce.commandEntered("+");
+    ce.commandEntered("undo");
+
+    AllocationCounter counter;
+    for(int i = 0; i < Repetitions; ++i)
+    {
+        ce.commandEntered("+");
+        ce.commandEntered("undo");
+    }
+
+    QCOMPARE(counter.allocations(), size_t{Repetitions});
+
+    return;
+}
+
+// Entering a number allocates its EnterNumber command, and recognizing the
+// number allocates nothing.
+void AllocationTest::testDispatchNumber()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+
+    warmStack(0);
+    pdCalc::CommandDispatcher ce{ui};
+    ce.commandEntered("3.14159");
+    ce.commandEntered("undo");
+
+    AllocationCounter counter;
+    for(int i = 0; i < Repetitions; ++i)
+    {
+        ce.commandEntered("3.14159");
+        ce.commandEntered("undo");
+    }
+
+    QCOMPARE(counter.allocations(), size_t{Repetitions});
+
+    return;
+}
+
+void AllocationTest::testStoredProcedure()
+{
+    if( !AllocationCounter::Active() ) QSKIP("Allocation counting is not supported on this platform");
+
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+
+    const string file{"allocationTestProcedure.psp"};
+    {
+        std::ofstream ofs{ file.c_str() };
+        for(int i = 0; i < 500; ++i)
+            ofs << "1 +\n";
+    }
+
+    warmStack(1);
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        pdCalc::StoredProcedure sp{ui, file};
+        sp.execute();
+        allocations = counter.allocations();
+    }
+
+    std::remove( file.c_str() );
+
+    QCOMPARE(pdCalc::Stack::Instance().getElements(1).front(), 501.0);
+    QVERIFY(allocations <= ProcedureAllocationBudget);
+
+    return;
+}
@@ -22,8 +22,11 @@
 #include "src/backend/CommandDispatcher.h"
 #include "src/backend/CommandRepository.h"
 #include "src/backend/Stack.h"
+#include "src/utilities/BigNumber.h"
 
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -157,3 +160,239 @@ void CommandDispatcherTest::testCommandDispatcher()
     return;
 }
 
+
+void CommandDispatcherTest::testExactMode()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack::Instance().clear();
+    TestInterface ui;
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::RegisterCoreCommands(ui);
+
+    auto exactTop = []
+    {
+        auto e = pdCalc::Stack::Instance().getExactElements(1).front();
+        return e ? e->toString() : string{};
+    };
+
+    ce.commandEntered("2.5");
+    ce.commandEntered("prec");
+    QCOMPARE(ui.getLastMessage(), string{"Precision must be an integer from 0 to 1000000"});
+    ce.commandEntered("drop");
+
+    ce.commandEntered("60");
+    ce.commandEntered("prec");
+    QCOMPARE( pdCalc::Stack::Instance().precision(), 60u );
+
+    // numbers entered keep all of their digits
+    ce.commandEntered("0.1");
+    ce.commandEntered("0.2");
+    ce.commandEntered("+");
+    QCOMPARE( exactTop(), string{"0.3"} );
+    QCOMPARE( ui.top(), 0.3 );
+
+    ce.commandEntered("1.00000000000000000000000000001");
+    ce.commandEntered("*");
+    QCOMPARE( exactTop(), string{"0.300000000000000000000000000003"} );
+
+    ce.commandEntered("7");
+    ce.commandEntered("/");
+    QCOMPARE( exactTop(), string{"0.0428571428571428571428571428575714285714285714285714285714286"} );
+
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    QCOMPARE( exactTop(), string{"0.300000000000000000000000000003"} );
+
+    // undoing prec restores double mode
+    ce.commandEntered("clear");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    ce.commandEntered("undo");
+    QCOMPARE( pdCalc::Stack::Instance().precision(), 0u );
+    QCOMPARE( ui.top(), 60.0 );
+
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+void CommandDispatcherTest::testBudget()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    TestInterface ui;
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::RegisterCoreCommands(ui);
+
+    const string inner{"budgettestinner.psp"};
+    const string outer{"budgettestouter.psp"};
+    const string map{"budgettestmap.psp"};
+    std::ofstream{inner} << "times 1 + end";
+    std::ofstream{outer} << "2 + 10 proc:" << inner << " 3 +";
+    std::ofstream{map} << "100000000 times 1 + end";
+
+    ce.commandEntered("5");
+    ce.commandEntered("7");
+    ce.commandEntered("undo");
+
+    // the outer procedure takes 39 steps: 2, +, 10, times, and its drop; 3 a turn
+    // of the loop; the inner procedure itself; 3, +; and the outer procedure itself
+    ce.setBudget(38, 0);
+    ce.commandEntered("proc:" + outer);
+    QCOMPARE( ui.getLastMessage(), string{"Exceeded the step budget"} );
+    QCOMPARE( stack.getElements( stack.size() ), vector<double>{5.0} );
+
+    // the history is as it was, so the undone 7 can still be redone
+    ce.commandEntered("redo");
+    QCOMPARE( stack.getElements( stack.size() ), (vector<double>{7.0, 5.0}) );
+    ce.commandEntered("undo");
+
+    ce.setBudget(39, 0);
+    ce.commandEntered("proc:" + outer);
+    QCOMPARE( ui.top(), 20.0 );
+    ce.commandEntered("undo");
+    QCOMPARE( stack.getElements( stack.size() ), vector<double>{5.0} );
+
+    // time is checked where steps are
+    ce.setBudget(0, 20);
+    ce.commandEntered("1000000000");
+    ce.commandEntered("proc:" + inner);
+    QCOMPARE( ui.getLastMessage(), string{"Exceeded the time budget"} );
+    QCOMPARE( stack.getElements( stack.size() ), (vector<double>{1000000000.0, 5.0}) );
+    ce.commandEntered("drop");
+
+    // and between the elements and loop iterations of a map
+    ce.commandEntered("1");
+    ce.commandEntered("map:" + map);
+    QCOMPARE( ui.getLastMessage(), string{"Exceeded the time budget"} );
+    QCOMPARE( stack.getElements( stack.size() ), (vector<double>{1.0, 5.0}) );
+
+    // each entry has a budget of its own
+    ce.commandEntered("drop");
+    ce.commandEntered("1");
+    ce.commandEntered("+");
+    QCOMPARE( ui.top(), 6.0 );
+
+    ce.setBudget(0, 0);
+    std::remove( inner.c_str() );
+    std::remove( outer.c_str() );
+    std::remove( map.c_str() );
+    stack.clear();
+
+    return;
+}
+
+void CommandDispatcherTest::testVersionedHistory()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack::Instance().clear();
+    TestInterface ui;
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::RegisterCoreCommands(ui);
+    ce.setVersionedHistory(true);
+
+    for(int i = 1; i <= 100; ++i)
+        ce.commandEntered( std::to_string(i) );
+    ce.commandEntered("+");
+    ce.commandEntered("swap");
+    QCOMPARE( ui.top(), 98.0 );
+
+    ce.commandEntered("undo:2");
+    QCOMPARE( ui.top(), 100.0 );
+    QCOMPARE( pdCalc::Stack::Instance().size(), size_t{100} );
+
+    ce.commandEntered("undo:50");
+    QCOMPARE( ui.top(), 50.0 );
+    QCOMPARE( pdCalc::Stack::Instance().size(), size_t{50} );
+
+    ce.commandEntered("redo:51");
+    QCOMPARE( ui.top(), 199.0 );
+
+    ce.commandEntered("undo");
+    ce.commandEntered("redo:1");
+    QCOMPARE( ui.top(), 199.0 );
+    QCOMPARE( pdCalc::Stack::Instance().size(), size_t{99} );
+
+    ce.commandEntered("undo:1000");
+    QCOMPARE( pdCalc::Stack::Instance().size(), size_t{0} );
+
+    ce.commandEntered("redo:1000");
+    QCOMPARE( ui.top(), 98.0 );
+    QCOMPARE( pdCalc::Stack::Instance().getElements(2), (vector<double>{98.0, 199.0}) );
+
+    ce.commandEntered("undo:x");
+    QCOMPARE( ui.getLastMessage(), string{"undo: x is not a positive count"} );
+    ce.commandEntered("redo:0");
+    QCOMPARE( ui.getLastMessage(), string{"redo: 0 is not a positive count"} );
+
+    // entering a command discards what could be redone
+    ce.commandEntered("undo:3");
+    ce.commandEntered("drop");
+    ce.commandEntered("redo:5");
+    QCOMPARE( ui.top(), 98.0 );
+
+    ce.setVersionedHistory(false);
+    QVERIFY( !pdCalc::Stack::Instance().persistent() );
+
+    // a history of branches keeps deltas, not versions, so the stack need not be
+    // persistent, in whichever order the two are set
+    ce.setVersionedHistory(true);
+    QVERIFY( pdCalc::Stack::Instance().persistent() );
+    ce.keepBranches();
+    QVERIFY( !pdCalc::Stack::Instance().persistent() );
+    ce.setVersionedHistory(true);
+    QVERIFY( !pdCalc::Stack::Instance().persistent() );
+
+    return;
+}
+
+void CommandDispatcherTest::testBranches()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack::Instance().clear();
+    TestInterface ui;
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::RegisterCoreCommands(ui);
+
+    ce.commandEntered("branches");
+    QCOMPARE( ui.getLastMessage(), string{"The undo history has no branches"} );
+    ce.commandEntered("branch:1");
+    QCOMPARE( ui.getLastMessage(), string{"branch: 1 is not a branch of the undo history"} );
+
+    ce.keepBranches();
+    ce.commandEntered("3");
+    ce.commandEntered("4");
+    ce.commandEntered("+");
+    ce.commandEntered("undo");
+    ce.commandEntered("*");
+    QCOMPARE( ui.top(), 12.0 );
+
+    ce.commandEntered("branch:1");
+    QCOMPARE( ui.top(), 7.0 );
+    ce.commandEntered("branch:2");
+    QCOMPARE( ui.top(), 12.0 );
+    QCOMPARE( pdCalc::Stack::Instance().size(), size_t{1} );
+
+    ce.commandEntered("branches");
+    std::istringstream iss{ ui.getLastMessage() };
+    string first, second;
+    std::getline(iss, first);
+    std::getline(iss, second);
+    QVERIFY( first.compare(0, 37, "  branch 1: 3 entries, forked after 0") == 0 );
+    QVERIFY( second.compare(0, 37, "* branch 2: 3 entries, forked after 2") == 0 );
+    QVERIFY( second.find(" bytes own, ") != string::npos );
+
+    ce.commandEntered("branch:3");
+    QCOMPARE( ui.getLastMessage(), string{"branch: 3 is not a branch of the undo history"} );
+    ce.commandEntered("branch:0");
+    QCOMPARE( ui.getLastMessage(), string{"branch: 0 is not a branch of the undo history"} );
+
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
@@ -32,6 +32,10 @@ class CommandDispatcherTest : public QObject
 
 private slots:
     void testCommandDispatcher();
+    void testExactMode();
+    void testBudget();
+    void testVersionedHistory();
+    void testBranches();
 };
 
 #endif
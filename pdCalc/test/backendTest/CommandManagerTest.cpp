@@ -19,6 +19,10 @@
 #include "CommandManagerTest.h"
 #include "src/backend/Command.h"
 #include "src/backend/CommandManager.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/CancellationToken.h"
+#include "src/utilities/Exception.h"
 
 #include <memory>
 #include <string>
@@ -26,6 +30,7 @@
 using std::cout;
 using std::endl;
 using std::string;
+using std::vector;
 
 namespace {
 
@@ -343,6 +348,108 @@ void CommandManagerTest::testResourceCleanupStackStrategy()
     testResourceCleanup(pdCalc::CommandManager::UndoRedoStrategy::StackStrategy);
 }
 
+void CommandManagerTest::testClear(pdCalc::CommandManager::UndoRedoStrategy st)
+{
+    TestCommand* raw1 = new TestCommand;
+    bool deleted = false;
+
+    pdCalc::CommandManager cm(st);
+
+    cm.executeCommand( pdCalc::MakeCommandPtr(raw1) );
+    cm.executeCommand( pdCalc::MakeCommandPtr<TestDeleteCommand>(deleted) );
+    cm.undo();
+
+    // clearing releases both stacks without touching the commands
+    cm.clear();
+    QCOMPARE( deleted, true );
+    QVERIFY( cm.getUndoSize() == 0 );
+    QVERIFY( cm.getRedoSize() == 0 );
+
+    cm.undo();
+    cm.redo();
+    QVERIFY( cm.getUndoSize() == 0 );
+    QVERIFY( cm.getRedoSize() == 0 );
+
+    TestCommand* raw2 = new TestCommand;
+    cm.executeCommand( pdCalc::MakeCommandPtr(raw2) );
+    cm.undo();
+    QCOMPARE( raw2->getUndoCount(), 1u );
+    cm.redo();
+    QCOMPARE( raw2->getExecuteCount(), 2u );
+    QVERIFY( cm.getUndoSize() == 1 );
+    QVERIFY( cm.getRedoSize() == 0 );
+
+    return;
+}
+
+// a command that stops its evaluation is undone and kept out of the history
+void CommandManagerTest::testStopped(pdCalc::CommandManager::UndoRedoStrategy st)
+{
+    pdCalc::CancellationToken token;
+    token.setBudget( 2, std::chrono::milliseconds{0} );
+    token.restart();
+
+    pdCalc::CommandManager cm(st);
+
+    TestCommand* raw1 = new TestCommand;
+    TestCommand* raw2 = new TestCommand;
+    cm.executeCommand( pdCalc::MakeCommandPtr(raw1), &token );
+    cm.executeCommand( pdCalc::MakeCommandPtr(raw2), &token );
+    cm.undo();
+
+    TestCommand* raw3 = new TestCommand;
+    try
+    {
+        cm.executeCommand( pdCalc::MakeCommandPtr(raw3), &token );
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Exceeded the step budget"} );
+    }
+
+    // the redo stack survives, since nothing replaced it
+    QVERIFY( cm.getUndoSize() == 1 );
+    QVERIFY( cm.getRedoSize() == 1 );
+
+    token.restart();
+    token.cancel();
+    bool deleted = false;
+    try
+    {
+        cm.executeCommand( pdCalc::MakeCommandPtr<TestDeleteCommand>(deleted), &token );
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Cancelled"} );
+    }
+    QVERIFY(deleted);
+
+    token.reset();
+    token.restart();
+    cm.redo();
+    QCOMPARE( raw2->getExecuteCount(), 2u );
+    QVERIFY( cm.getUndoSize() == 2 );
+
+    return;
+}
+
+void CommandManagerTest::testStoppedStackStrategy()
+{
+    testStopped(pdCalc::CommandManager::UndoRedoStrategy::StackStrategy);
+}
+
+void CommandManagerTest::testStoppedListStrategy()
+{
+    testStopped(pdCalc::CommandManager::UndoRedoStrategy::ListStrategy);
+}
+
+void CommandManagerTest::testStoppedListStrategyVector()
+{
+    testStopped(pdCalc::CommandManager::UndoRedoStrategy::ListStrategyVector);
+}
+
 void CommandManagerTest::ignoreErrorStackStrategy()
 {
     ignoreError(pdCalc::CommandManager::UndoRedoStrategy::StackStrategy);
@@ -407,3 +514,151 @@ void CommandManagerTest::ignoreErrorListStrategyVector()
 {
     ignoreError(pdCalc::CommandManager::UndoRedoStrategy::ListStrategyVector);
 }
+
+void CommandManagerTest::testClearStackStrategy()
+{
+    testClear(pdCalc::CommandManager::UndoRedoStrategy::StackStrategy);
+}
+
+void CommandManagerTest::testClearListStrategy()
+{
+    testClear(pdCalc::CommandManager::UndoRedoStrategy::ListStrategy);
+}
+
+void CommandManagerTest::testClearListStrategyVector()
+{
+    testClear(pdCalc::CommandManager::UndoRedoStrategy::ListStrategyVector);
+}
+
+// a tree keeps the changes commands made to the stack, not the commands
+void CommandManagerTest::testUndoRedoTreeStrategy()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    pdCalc::CommandManager cm(pdCalc::CommandManager::UndoRedoStrategy::TreeStrategy);
+
+    for(int i = 1; i <= 3; ++i)
+        cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::EnterNumber>( static_cast<double>(i) ) );
+    QCOMPARE( cm.getUndoSize(), size_t{3} );
+    QCOMPARE( cm.getRedoSize(), size_t{0} );
+
+    cm.undo();
+    cm.undo();
+    QCOMPARE( stack.getElements(1), vector<double>{1.0} );
+    QCOMPARE( cm.getUndoSize(), size_t{1} );
+    QCOMPARE( cm.getRedoSize(), size_t{2} );
+
+    cm.redo(5);
+    QCOMPARE( stack.getElements(3), (vector<double>{3.0, 2.0, 1.0}) );
+    QCOMPARE( cm.getRedoSize(), size_t{0} );
+
+    cm.undo(5);
+    QCOMPARE( stack.size(), size_t{0} );
+    cm.redo();
+    QCOMPARE( stack.getElements(1), vector<double>{1.0} );
+
+    cm.clear();
+    QCOMPARE( cm.getUndoSize(), size_t{0} );
+    QCOMPARE( cm.getRedoSize(), size_t{0} );
+    QVERIFY( cm.branches().empty() );
+    stack.clear();
+
+    return;
+}
+
+void CommandManagerTest::testBranchesTreeStrategy()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    pdCalc::CommandManager cm;
+    cm.keepBranches();
+
+    for(int i = 1; i <= 3; ++i)
+        cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::EnterNumber>( static_cast<double>(i) ) );
+    QCOMPARE( cm.branches().size(), size_t{1} );
+
+    // a command after undo starts a branch, keeping what could have been redone
+    cm.undo(2);
+    cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::EnterNumber>(4.0) );
+    QCOMPARE( stack.getElements(2), (vector<double>{4.0, 1.0}) );
+    QCOMPARE( cm.getRedoSize(), size_t{0} );
+
+    auto branches = cm.branches();
+    QCOMPARE( branches.size(), size_t{2} );
+    QCOMPARE( cm.currentBranch(), size_t{1} );
+    QCOMPARE( branches[0].commands, size_t{3} );
+    QCOMPARE( branches[0].fork, size_t{0} );
+    QCOMPARE( branches[0].sharedBytes, size_t{0} );
+    QCOMPARE( branches[1].commands, size_t{2} );
+    QCOMPARE( branches[1].fork, size_t{1} );
+
+    // the first command is stored once, by the branch that made it
+    QVERIFY( branches[1].sharedBytes > 0 );
+    QCOMPARE( branches[1].sharedBytes * 3, branches[0].ownBytes );
+    QCOMPARE( branches[1].ownBytes, branches[1].sharedBytes );
+
+    cm.switchBranch(0);
+    QCOMPARE( stack.getElements(3), (vector<double>{3.0, 2.0, 1.0}) );
+    QCOMPARE( cm.currentBranch(), size_t{0} );
+    QCOMPARE( cm.getUndoSize(), size_t{3} );
+
+    // extending the current branch does not start another, and redo follows it
+    cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::EnterNumber>(5.0) );
+    QCOMPARE( cm.branches().size(), size_t{2} );
+    cm.undo(3);
+    cm.redo(3);
+    QCOMPARE( stack.getElements(4), (vector<double>{5.0, 3.0, 2.0, 1.0}) );
+
+    cm.undo(4);
+    cm.executeCommand( pdCalc::MakeCommandPtr<pdCalc::EnterNumber>(6.0) );
+    QCOMPARE( cm.branches().size(), size_t{3} );
+    QCOMPARE( cm.branches()[2].fork, size_t{0} );
+    QCOMPARE( cm.branches()[2].sharedBytes, size_t{0} );
+
+    cm.switchBranch(1);
+    QCOMPARE( stack.getElements(2), (vector<double>{4.0, 1.0}) );
+    cm.undo();
+    QCOMPARE( cm.getRedoSize(), size_t{1} );
+    cm.switchBranch(1);
+    QCOMPARE( stack.getElements(2), (vector<double>{4.0, 1.0}) );
+
+    cm.switchBranch(0);
+    cm.undo(4);
+    cm.redo(4);
+    QCOMPARE( stack.getElements(4), (vector<double>{5.0, 3.0, 2.0, 1.0}) );
+
+    try
+    {
+        cm.switchBranch(3);
+        QFAIL("Failed to throw for a missing branch");
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"The undo history has no such branch"} );
+    }
+    QCOMPARE( stack.size(), size_t{4} );
+
+    cm.clear();
+    stack.clear();
+
+    return;
+}
+
+void CommandManagerTest::testNoBranches()
+{
+    pdCalc::CommandManager cm;
+    cm.executeCommand( pdCalc::MakeCommandPtr(new TestCommand) );
+    QVERIFY( cm.branches().empty() );
+
+    try
+    {
+        cm.switchBranch(0);
+        QFAIL("Failed to throw without branches");
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"The undo history has no branches"} );
+    }
+
+    return;
+}
@@ -32,6 +32,8 @@ private slots:
     void testRedoStackFlushStackStrategy();
     void testResourceCleanupStackStrategy();
     void ignoreErrorStackStrategy();
+    void testClearStackStrategy();
+    void testStoppedStackStrategy();
 
     void testExecuteListStrategy();
     void testUndoListStrategy();
@@ -39,6 +41,8 @@ private slots:
     void testRedoStackFlushListStrategy();
     void testResourceCleanupListStrategy();
     void ignoreErrorListStrategy();
+    void testClearListStrategy();
+    void testStoppedListStrategy();
 
     void testExecuteListStrategyVector();
     void testUndoListStrategyVector();
@@ -46,6 +50,12 @@ private slots:
     void testRedoStackFlushListStrategyVector();
     void testResourceCleanupListStrategyVector();
     void ignoreErrorListStrategyVector();
+    void testClearListStrategyVector();
+    void testStoppedListStrategyVector();
+
+    void testUndoRedoTreeStrategy();
+    void testBranchesTreeStrategy();
+    void testNoBranches();
 
 private:
     void testExecute(pdCalc::CommandManager::UndoRedoStrategy);
@@ -54,6 +64,8 @@ private:
     void testRedoStackFlush(pdCalc::CommandManager::UndoRedoStrategy);
     void testResourceCleanup(pdCalc::CommandManager::UndoRedoStrategy);
     void ignoreError(pdCalc::CommandManager::UndoRedoStrategy);
+    void testClear(pdCalc::CommandManager::UndoRedoStrategy);
+    void testStopped(pdCalc::CommandManager::UndoRedoStrategy);
 };
 
 #endif
@@ -0,0 +1,171 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "CommandWorkerTest.h"
+#include "src/backend/CommandWorker.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/UserInterface.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string&) override { }
+    void stackChanged() override { }
+};
+
+class ProcedureFile
+{
+public:
+    ProcedureFile(const string& name, const string& text)
+    : name_{name}
+    {
+        std::ofstream ofs{ name_.c_str() };
+        ofs << text;
+    }
+
+    ~ProcedureFile() { std::remove( name_.c_str() ); }
+
+    const string& name() const { return name_; }
+
+private:
+    string name_;
+};
+
+// lets the worker get well into whatever it is running; false if it never does
+bool waitForProgress(const pdCalc::CommandWorker& worker, size_t steps)
+{
+    for(int i = 0; i < 10000 && worker.progress() < steps; ++i)
+        std::this_thread::sleep_for( std::chrono::milliseconds{1} );
+
+    return worker.progress() >= steps;
+}
+
+}
+
+void CommandWorkerTest::testInOrder()
+{
+    TestInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::RegisterCoreCommands(ui);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+
+    pdCalc::CommandDispatcher ce{ui};
+    {
+        pdCalc::CommandWorker worker{ce};
+        for(const char* c : {"2", "3", "+", "4", "*", "1", "-"})
+            worker.commandEntered(c);
+
+        worker.wait();
+        QVERIFY( !worker.busy() );
+    }
+
+    QCOMPARE( stack.size(), size_t{1} );
+    QCOMPARE( stack.getElements(1).front(), 19.0 );
+
+    stack.clear();
+
+    return;
+}
+
+void CommandWorkerTest::testCancel()
+{
+    TestInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::RegisterCoreCommands(ui);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.push(5.0);
+
+    ProcedureFile file{"workertestprocedure.psp", "1000000000 times 1 + end"};
+    pdCalc::CommandDispatcher ce{ui};
+    {
+        pdCalc::CommandWorker worker{ce};
+        worker.commandEntered("proc:" + file.name());
+        worker.commandEntered("7");
+
+        QVERIFY( waitForProgress(worker, 1000) );
+        QVERIFY( worker.busy() );
+        worker.cancel();
+        worker.wait();
+
+        // the queued entry was discarded along with the procedure's work
+        QCOMPARE( stack.getElements( stack.size() ), vector<double>{5.0} );
+
+        // the worker carries on with later entries
+        worker.commandEntered("7");
+        worker.commandEntered("+");
+        worker.wait();
+    }
+
+    QCOMPARE( stack.getElements( stack.size() ), vector<double>{12.0} );
+
+    stack.clear();
+
+    return;
+}
+
+void CommandWorkerTest::testCancelNested()
+{
+    TestInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::RegisterCoreCommands(ui);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.push(5.0);
+
+    ProcedureFile inner{"workertestinner.psp", "1000000000 times 1 + end"};
+    ProcedureFile outer{"workertestouter.psp", "2 + proc:" + inner.name() + " 3 +"};
+    pdCalc::CommandDispatcher ce{ui};
+    {
+        pdCalc::CommandWorker worker{ce};
+        worker.commandEntered("proc:" + outer.name());
+
+        QVERIFY( waitForProgress(worker, 1000) );
+        worker.cancel();
+        worker.wait();
+    }
+
+    QCOMPARE( stack.getElements( stack.size() ), vector<double>{5.0} );
+
+    // once the worker is gone, its cancellation no longer stops entries
+    ProcedureFile quick{"workertestquick.psp", "4 times 1 + end"};
+    ce.commandEntered("proc:" + quick.name());
+    QCOMPARE( stack.getElements( stack.size() ), vector<double>{9.0} );
+
+    stack.clear();
+
+    return;
+}
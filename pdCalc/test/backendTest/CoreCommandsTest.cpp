@@ -21,6 +21,9 @@
 #include "src/backend/CoreCommands.h"
 #include "src/utilities/Exception.h"
 #include "src/utilities/Observer.h"
+#include "src/utilities/BigNumber.h"
+#include "src/utilities/VectorMath.h"
+#include "src/utilities/BlockAlgorithms.h"
 #include <vector>
 #include <cmath>
 #include <string>
@@ -75,6 +78,7 @@ void CoreCommandsTest::init()
 void CoreCommandsTest::cleanup()
 {
     pdCalc::Stack::Instance().detach( pdCalc::Stack::StackChanged, "StackChangedObserver");
+    pdCalc::Stack::Instance().setPrecision(0);
 
     return;
 }
@@ -518,6 +522,39 @@ void CoreCommandsTest::testSubtract()
     return;
 }
 
+void CoreCommandsTest::testMultiplyPreconditions()
+{
+    pdCalc::Multiply mul;
+    testBinaryCommandPreconditions(mul);
+
+    return;
+}
+
+void CoreCommandsTest::testMultiplyClone()
+{
+    pdCalc::Multiply c;
+    testClone<pdCalc::Multiply>(c);
+
+    // generated commands keep their help in static storage, shared by every clone
+    pdCalc::Command* clone = c.clone();
+    QCOMPARE( clone->helpMessage(), c.helpMessage() );
+    delete clone;
+
+    return;
+}
+
+void CoreCommandsTest::testMultiply()
+{
+    pdCalc::Multiply mul;
+    double top = 2.0;
+    double next = -1.5;
+    double result = next * top;
+
+    testBinaryCommand(mul, top, next, result);
+
+    return;
+}
+
 void CoreCommandsTest::testDividePreconditions()
 {
     pdCalc::Divide div;
@@ -842,6 +879,174 @@ void CoreCommandsTest::testArctangent()
     return;
 }
 
+void CoreCommandsTest::testBlockUnaryCommandPreconditions()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    pdCalc::BlockUnaryCommand arcsinn{"", pdCalc::VectorMath::Asin,
+        [](double d) -> const char* { return std::fabs(d) <= 1 ? nullptr : "Invalid argument"; }};
+    pdCalc::Command& c = arcsinn;
+
+    try
+    {
+        c.execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    // counts that are not positive integers or exceed the elements below them
+    stack.push(0.5);
+    stack.push(0.25);
+    for(double count : {0.0, -1.0, 1.5, 3.0})
+    {
+        stack.push(count);
+        try
+        {
+            c.execute();
+            QVERIFY(false);
+        }
+        catch(pdCalc::Exception&)
+        {
+            QVERIFY(true);
+        }
+        stack.pop();
+    }
+
+    // an element of the block outside the domain
+    stack.push(2.0);
+    stack.push(0.75);
+    stack.push(3.0);
+    try
+    {
+        c.execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Invalid argument"} );
+    }
+    QCOMPARE( stack.size(), size_t{5} );
+
+    // elements below the block are not checked
+    stack.pop();
+    stack.push(1.0);
+    try
+    {
+        c.execute();
+        QVERIFY(true);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(false);
+    }
+
+    return;
+}
+
+void CoreCommandsTest::testBlockUnaryCommand()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    pdCalc::BlockUnaryCommand sinn{"sines", pdCalc::VectorMath::Sin};
+    pdCalc::Command& c = sinn;
+    QCOMPARE( string{c.helpMessage()}, string{"sines"} );
+
+    // whole vectors and a tail below one element outside the block
+    vector<double> block;
+    for(int i = 0; i < 13; ++i)
+        block.push_back(0.7 * i - 4.0);
+
+    stack.push(42.0);
+    for(double d : block)
+        stack.push(d);
+    stack.push( static_cast<double>( block.size() ) );
+
+    unsigned int changes{ raw->changeCount() };
+    c.execute();
+    QCOMPARE( raw->changeCount(), changes + 1 );
+
+    QCOMPARE( stack.size(), block.size() + 1 );
+    vector<double> v{ stack.getElements( stack.size() ) };
+    for(size_t i = 0; i < block.size(); ++i)
+        QVERIFY( std::fabs(v[block.size() - 1 - i] - std::sin(block[i])) < 1e-15 );
+    QCOMPARE( v.back(), 42.0 );
+
+    c.undo();
+    QCOMPARE( raw->changeCount(), changes + 2 );
+
+    QCOMPARE( stack.size(), block.size() + 2 );
+    v = stack.getElements( stack.size() );
+    QCOMPARE( v.front(), static_cast<double>( block.size() ) );
+    for(size_t i = 0; i < block.size(); ++i)
+        QCOMPARE( v[block.size() - i], block[i] );
+
+    // exact operands come back with their exact values
+    stack.clear();
+    stack.setPrecision(30);
+    auto third = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.333333333333333333333333333333", 30) );
+    stack.push( third->toDouble(), third );
+    stack.push(1.0);
+    c.execute();
+    QVERIFY( !stack.getExactElements(1).front() );
+
+    c.undo();
+    auto exact = stack.getExactElements(2);
+    QVERIFY( !exact[0] );
+    QVERIFY( exact[1] && exact[1]->toString() == third->toString() );
+
+    return;
+}
+
+void CoreCommandsTest::testBlockCommand()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    pdCalc::BlockCommand uniquen{"unique", pdCalc::BlockAlgorithms::Unique};
+    pdCalc::Command& c = uniquen;
+    QCOMPARE( string{c.helpMessage()}, string{"unique"} );
+
+    stack.push(2.0);
+    try
+    {
+        c.execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Stack has fewer elements than the count"} );
+    }
+
+    // fewer results than operands, with an element below the block left alone
+    stack.clear();
+    vector<double> block{3.0, 1.0, 3.0, -0.0, 2.0, 0.0, 1.0};
+    stack.push(42.0);
+    for(double d : block)
+        stack.push(d);
+    stack.push( static_cast<double>( block.size() ) );
+
+    unsigned int changes{ raw->changeCount() };
+    c.execute();
+    QCOMPARE( raw->changeCount(), changes + 1 );
+
+    // top first
+    QCOMPARE( stack.getElements( stack.size() ), (vector<double>{2.0, -0.0, 1.0, 3.0, 42.0}) );
+
+    c.undo();
+    QCOMPARE( raw->changeCount(), changes + 2 );
+
+    QCOMPARE( stack.size(), block.size() + 2 );
+    vector<double> v{ stack.getElements( stack.size() ) };
+    QCOMPARE( v.front(), static_cast<double>( block.size() ) );
+    for(size_t i = 0; i < block.size(); ++i)
+        QCOMPARE( v[block.size() - i], block[i] );
+
+    // a redo after an undo sees the same operands
+    c.execute();
+    QCOMPARE( stack.size(), size_t{5} );
+
+    return;
+}
+
 void CoreCommandsTest::testPowerPreconditions()
 {
     pdCalc::Power power;
@@ -1083,6 +1288,33 @@ void CoreCommandsTest::testNegate()
     return;
 }
 
+void CoreCommandsTest::testSquarePreconditions()
+{
+    pdCalc::Square sq;
+    testUnaryCommandPreconditions(sq);
+
+    return;
+}
+
+void CoreCommandsTest::testSquareClone()
+{
+    pdCalc::Square c;
+    testClone<pdCalc::Square>(c);
+
+    return;
+}
+
+void CoreCommandsTest::testSquare()
+{
+    pdCalc::Square sq;
+    double top = -5.34;
+    double result = top * top;
+
+    testUnaryCommand(sq, top, result);
+
+    return;
+}
+
 void CoreCommandsTest::testDuplicatePreconditions()
 {
     pdCalc::Stack& stack = getCheckedStack();
@@ -1137,3 +1369,170 @@ void CoreCommandsTest::testDuplicate()
     QCOMPARE(v[0], num);
     QCOMPARE(v[1], num);
 }
+
+void CoreCommandsTest::testSetPrecisionPreconditions()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    pdCalc::SetPrecision prec;
+    pdCalc::Command& c = prec;
+
+    for(double d : {-1.0, 2.5, 1e7})
+    {
+        stack.push(d);
+        try
+        {
+            c.execute();
+            QVERIFY(false);
+        }
+        catch(pdCalc::Exception&)
+        {
+            QVERIFY(true);
+        }
+        stack.pop();
+    }
+
+    try
+    {
+        c.execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    return;
+}
+
+void CoreCommandsTest::testSetPrecision()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    stack.setPrecision(20);
+    stack.push(7.0);
+    stack.push(50.0);
+
+    pdCalc::SetPrecision prec;
+    pdCalc::Command& c = prec;
+    c.execute();
+    QCOMPARE( stack.precision(), 50u );
+    QVERIFY( stack.size() == 1 );
+
+    c.undo();
+    QCOMPARE( stack.precision(), 20u );
+    QVERIFY( stack.size() == 2 );
+    QCOMPARE( stackTop(), 50.0 );
+
+    return;
+}
+
+namespace {
+
+using ExactPtr = std::shared_ptr<const pdCalc::BigFloat>;
+
+void pushExact(const string& s)
+{
+    auto e = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString(s, 50) );
+    pdCalc::Stack::Instance().push(e->toDouble(), e);
+}
+
+string exactTop()
+{
+    auto e = pdCalc::Stack::Instance().getExactElements(1).front();
+    return e ? e->toString() : string{};
+}
+
+}
+
+void CoreCommandsTest::testExactArithmetic()
+{
+    pdCalc::Stack& stack = getCheckedStack();
+    stack.setPrecision(50);
+
+    // 0.1 + 0.2 is 0.3 exactly, and undo restores both exact operands
+    pushExact("0.1");
+    pushExact("0.2");
+    pdCalc::Add add;
+    pdCalc::Command& a = add;
+    a.execute();
+    QCOMPARE( exactTop(), string{"0.3"} );
+    QCOMPARE( stackTop(), 0.3 );
+    a.undo();
+    QCOMPARE( exactTop(), string{"0.2"} );
+    stack.clear();
+
+    // a double operand takes part through its shortest decimal
+    stack.push(1.0);
+    pushExact("3");
+    pdCalc::Divide div;
+    pdCalc::Command& d = div;
+    d.execute();
+    QCOMPARE( exactTop(), "0." + string(50, '3') );
+
+    // which negate keeps exact
+    pdCalc::Negate neg;
+    pdCalc::Command& n = neg;
+    n.execute();
+    QCOMPARE( exactTop(), "-0." + string(50, '3') );
+    stack.clear();
+
+    // a divisor too small for a double still divides
+    stack.push(1.0);
+    pushExact("1e-400");
+    d.execute();
+    QCOMPARE( exactTop(), string{"1e400"} );
+    stack.clear();
+
+    pushExact("2");
+    stack.push(2.0);
+    pdCalc::Root root;
+    pdCalc::Command& r = root;
+    r.execute();
+    QCOMPARE( exactTop(), string{"1.4142135623730950488016887242096980785696718753769"} );
+    stack.clear();
+
+    pushExact("2");
+    stack.push(100.0);
+    pdCalc::Power power;
+    pdCalc::Command& p = power;
+    p.execute();
+    QCOMPARE( exactTop(), string{"1267650600228229401496703205376"} );
+    stack.clear();
+
+    // a non-integer power has only a double result
+    stack.push(2.0);
+    stack.push(0.5);
+    p.execute();
+    QVERIFY( !stack.getExactElements(1).front() );
+    QCOMPARE( stackTop(), std::sqrt(2.0) );
+    stack.clear();
+
+    // dup, drop and clear carry exact values along
+    pushExact("0.7");
+    pdCalc::Duplicate dup;
+    pdCalc::Command& du = dup;
+    du.execute();
+    QCOMPARE( exactTop(), string{"0.7"} );
+    pdCalc::DropTopOfStack drop;
+    pdCalc::Command& dr = drop;
+    dr.execute();
+    dr.undo();
+    QCOMPARE( exactTop(), string{"0.7"} );
+    pdCalc::ClearStack clear;
+    pdCalc::Command& cl = clear;
+    cl.execute();
+    cl.undo();
+    QVERIFY( stack.size() == 2 );
+    QCOMPARE( exactTop(), string{"0.7"} );
+    stack.clear();
+
+    // with exact mode off, arithmetic is on doubles again
+    stack.setPrecision(0);
+    pushExact("0.1");
+    pushExact("0.2");
+    a.execute();
+    QVERIFY( !stack.getExactElements(1).front() );
+    QCOMPARE( stackTop(), 0.1 + 0.2 );
+    stack.clear();
+
+    return;
+}
@@ -50,6 +50,9 @@ private slots:
     void testSubtractPreconditions();
     void testSubtractClone();
     void testSubtract();
+    void testMultiplyPreconditions();
+    void testMultiplyClone();
+    void testMultiply();
     void testDividePreconditions();
     void testDivideClone();
     void testDivide();
@@ -71,6 +74,9 @@ private slots:
     void testArctangentPreconditions();
     void testArctangentClone();
     void testArctangent();
+    void testBlockUnaryCommandPreconditions();
+    void testBlockUnaryCommand();
+    void testBlockCommand();
     void testPowerPreconditions();
     void testPowerClone();
     void testPower();
@@ -80,9 +86,15 @@ private slots:
     void testNegatePreconditions();
     void testNegateClone();
     void testNegate();
+    void testSquarePreconditions();
+    void testSquareClone();
+    void testSquare();
     void testDuplicatePreconditions();
     void testDuplicateClone();
     void testDuplicate();
+    void testSetPrecisionPreconditions();
+    void testSetPrecision();
+    void testExactArithmetic();
 
 private:
     pdCalc::Stack& getCheckedStack();
@@ -0,0 +1,190 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ImportNumbersTest.h"
+#include "src/backend/ImportNumbers.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/Exception.h"
+#include "src/utilities/UserInterface.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { lastMessage = m; }
+    void stackChanged() override { }
+
+    string lastMessage;
+};
+
+const char* TextFileName = "importNumbersTest.csv";
+const char* BinaryFileName = "importNumbersTest.f64";
+
+void writeFile(const char* name, const string& contents)
+{
+    std::ofstream ofs{name, std::ios::binary};
+    ofs << contents;
+}
+
+void writeDoubles(const char* name, const vector<double>& v)
+{
+    string bytes( v.size() * sizeof(double), '\0' );
+    for(size_t i = 0; i < v.size(); ++i)
+    {
+        uint64_t w;
+        std::memcpy( &w, &v[i], sizeof(w) );
+        for(size_t b = 0; b < sizeof(w); ++b)
+            bytes[i * sizeof(w) + b] = static_cast<char>( (w >> (8 * b)) & 0xFF );
+    }
+    writeFile(name, bytes);
+}
+
+// the message of the exception reading the file throws, or "" if it succeeds
+string readError(const char* name, bool binary)
+{
+    try
+    {
+        binary ? pdCalc::ReadBinaryNumbers(name) : pdCalc::ReadTextNumbers(name);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        return e.what();
+    }
+
+    return "";
+}
+
+}
+
+void ImportNumbersTest::init()
+{
+    pdCalc::Stack::Instance().clear();
+    pdCalc::Stack::Instance().setPrecision(0);
+
+    return;
+}
+
+void ImportNumbersTest::cleanup()
+{
+    init();
+    std::remove(TextFileName);
+    std::remove(BinaryFileName);
+
+    return;
+}
+
+void ImportNumbersTest::testText()
+{
+    writeFile(TextFileName, "1.5,2,-3\r\n4e2,0.25,6\r\n\r\n7 8;9");
+    QCOMPARE( pdCalc::ReadTextNumbers(TextFileName),
+        (vector<double>{1.5, 2.0, -3.0, 400.0, 0.25, 6.0, 7.0, 8.0, 9.0}) );
+
+    writeFile(TextFileName, "");
+    QVERIFY( pdCalc::ReadTextNumbers(TextFileName).empty() );
+
+    return;
+}
+
+void ImportNumbersTest::testBinary()
+{
+    const vector<double> v{1.0, -0.0, std::numeric_limits<double>::infinity(), 3.25e-300, 42.0};
+    writeDoubles(BinaryFileName, v);
+    const vector<double> x{ pdCalc::ReadBinaryNumbers(BinaryFileName) };
+    QCOMPARE( x.size(), v.size() );
+    QVERIFY( std::memcmp( x.data(), v.data(), v.size() * sizeof(double) ) == 0 );
+
+    return;
+}
+
+void ImportNumbersTest::testErrors()
+{
+    QCOMPARE( readError("noSuchFile.csv", false), string{"Could not open noSuchFile.csv"} );
+
+    writeFile(TextFileName, "1,2,3\n4,five,6\n");
+    QCOMPARE( readError(TextFileName, false), string{TextFileName} + " line 2: five is not a number" );
+
+    writeFile(BinaryFileName, "123456789");
+    QCOMPARE( readError(BinaryFileName, true), string{BinaryFileName} + " is not a whole number of doubles" );
+
+    return;
+}
+
+void ImportNumbersTest::testDispatch()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    // onto an empty stack and onto a full one, each a single undo record
+    writeFile(TextFileName, "1 2 3");
+    writeDoubles(BinaryFileName, {4.0, 5.0});
+    ce.commandEntered( string{"import:"} + TextFileName );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+    ce.commandEntered( string{"importbin:"} + BinaryFileName );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0, 4.0, 5.0}) );
+
+    ce.commandEntered("undo");
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+    ce.commandEntered("undo");
+    QVERIFY( stack.elements().empty() );
+    ce.commandEntered("redo");
+    ce.commandEntered("redo");
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0, 4.0, 5.0}) );
+
+    // a bad file leaves the stack alone
+    writeFile(TextFileName, "1 2 oops");
+    ce.commandEntered( string{"import:"} + TextFileName );
+    QCOMPARE( ui.lastMessage, string{TextFileName} + " line 1: oops is not a number" );
+    QCOMPARE( stack.size(), size_t{5} );
+
+    // a file of no numbers imports nothing and leaves no undo record
+    writeFile(TextFileName, " \n");
+    ce.commandEntered( string{"import:"} + TextFileName );
+    QCOMPARE( ui.lastMessage, string{TextFileName} + " holds no numbers; nothing imported" );
+    writeDoubles(BinaryFileName, {});
+    ce.commandEntered( string{"importbin:"} + BinaryFileName );
+    QCOMPARE( ui.lastMessage, string{BinaryFileName} + " holds no numbers; nothing imported" );
+    ce.commandEntered("undo");
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+    ce.commandEntered("redo");
+
+    // imported numbers carry no exact values, even in exact mode
+    ce.commandEntered("10");
+    ce.commandEntered("prec");
+    writeFile(TextFileName, "0.1");
+    ce.commandEntered( string{"import:"} + TextFileName );
+    QCOMPARE( stack.size(), size_t{6} );
+    QVERIFY( stack.exactElements().empty() || !stack.exactElements().back() );
+
+    return;
+}
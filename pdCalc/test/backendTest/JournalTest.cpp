@@ -0,0 +1,340 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "JournalTest.h"
+#include "src/backend/Journal.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/backend/StackSnapshot.h"
+#include "src/utilities/BigNumber.h"
+#include "src/utilities/UserInterface.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { lastMessage = m; }
+    void stackChanged() override { }
+
+    string lastMessage;
+};
+
+const char* JournalFileName = "journalTest.pjl";
+const char* CheckpointFileName = "journalTest.pjl.pss";
+const char* HistoryFileName = "journalTest.psh";
+
+string readFile(const char* name)
+{
+    std::ifstream ifs{name, std::ios::binary};
+    return string{ std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{} };
+}
+
+void writeFile(const char* name, const string& contents)
+{
+    std::ofstream ofs{name, std::ios::binary};
+    ofs << contents;
+}
+
+// the entries of the journal, numbers written out as text
+vector<string> replay(uint64_t generation)
+{
+    vector<string> entries;
+    pdCalc::Journal::Replay(JournalFileName, generation,
+        [&](double d){ entries.push_back( std::to_string(d) ); },
+        [&](const string& t){ entries.push_back(t); });
+
+    return entries;
+}
+
+}
+
+void JournalTest::init()
+{
+    pdCalc::Stack::Instance().clear();
+    pdCalc::Stack::Instance().setPrecision(0);
+
+    return;
+}
+
+void JournalTest::cleanup()
+{
+    init();
+    std::remove(JournalFileName);
+    std::remove(CheckpointFileName);
+
+    return;
+}
+
+void JournalTest::testRoundTrip()
+{
+    {
+        pdCalc::Journal journal{JournalFileName, 7, 0};
+        journal.recordNumber(1.5);
+        journal.recordToken("+");
+        journal.recordToken("swap");
+        journal.recordToken("+");
+        journal.recordNumber(-2.0);
+
+        // each entry is durable once recorded
+        QCOMPARE( replay(7), (vector<string>{"1.500000", "+", "swap", "+", "-2.000000"}) );
+    }
+
+    QCOMPARE( replay(7), (vector<string>{"1.500000", "+", "swap", "+", "-2.000000"}) );
+
+    // a journal of another generation, a missing one, or a foreign file replays nothing
+    QVERIFY( replay(8).empty() );
+    std::remove(JournalFileName);
+    QVERIFY( replay(7).empty() );
+    writeFile(JournalFileName, "not a journal at all");
+    QVERIFY( replay(7).empty() );
+
+    return;
+}
+
+void JournalTest::testGroupCommit()
+{
+    const size_t n = 10000;
+    {
+        pdCalc::Journal journal{JournalFileName, 1, 20};
+        for(size_t i = 0; i < n; ++i)
+            journal.recordToken( i % 2 ? "dup" : std::to_string(i % 100) );
+
+        journal.sync();
+        QCOMPARE( replay(1).size(), n );
+
+        journal.recordToken("drop");
+    }
+
+    // the destructor writes what is still waiting for its window
+    vector<string> entries{ replay(1) };
+    QCOMPARE( entries.size(), n + 1 );
+    QCOMPARE( entries[0], string{"0"} );
+    QCOMPARE( entries[n - 2], string{"98"} );
+    QCOMPARE( entries[n - 1], string{"dup"} );
+    QCOMPARE( entries[n], string{"drop"} );
+
+    return;
+}
+
+void JournalTest::testTornTail()
+{
+    {
+        pdCalc::Journal journal{JournalFileName, 3, 0};
+        journal.recordNumber(1.0);
+        journal.recordNumber(2.0);
+        journal.recordToken("+");
+    }
+
+    // a crash part way through the last batch leaves a torn tail, which is ignored
+    string contents{ readFile(JournalFileName) };
+    writeFile( JournalFileName, contents.substr(0, contents.size() - 1) );
+    QCOMPARE( replay(3), (vector<string>{"1.000000", "2.000000"}) );
+
+    // so does a batch whose records are damaged
+    string damaged{contents};
+    damaged[damaged.size() - 1] = '-';
+    writeFile(JournalFileName, damaged);
+    QCOMPARE( replay(3), (vector<string>{"1.000000", "2.000000"}) );
+
+    // continuing the journal drops the torn tail rather than hiding new batches
+    // behind it
+    {
+        pdCalc::Journal journal{JournalFileName, 3, 0};
+        journal.recordToken("*");
+    }
+    QCOMPARE( replay(3), (vector<string>{"1.000000", "2.000000", "*"}) );
+
+    // a journal of another generation is started over
+    {
+        pdCalc::Journal journal{JournalFileName, 4, 0};
+        journal.recordToken("neg");
+    }
+    QVERIFY( replay(3).empty() );
+    QCOMPARE( replay(4), vector<string>{"neg"} );
+
+    return;
+}
+
+void JournalTest::testRestart()
+{
+    pdCalc::Journal journal{JournalFileName, 5, 10};
+    journal.recordNumber(1.0);
+    journal.recordToken("+");
+    journal.sync();
+    journal.recordToken("dropped");
+
+    journal.restart(6);
+    QCOMPARE( journal.generation(), uint64_t{6} );
+    QVERIFY( replay(5).empty() );
+    QVERIFY( replay(6).empty() );
+
+    journal.recordToken("+");
+    journal.sync();
+    QCOMPARE( replay(6), vector<string>{"+"} );
+
+    return;
+}
+
+void JournalTest::testRecovery()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    {
+        pdCalc::CommandDispatcher ce{ui};
+        ce.startJournal(JournalFileName, 10, 0);
+        ce.commandEntered("3");
+        ce.commandEntered("4");
+        ce.commandEntered("+");
+        ce.commandEntered("10");
+        ce.commandEntered("undo");
+        ce.commandEntered("undo");
+        ce.commandEntered("redo");
+
+        // entries that fail or leave the stack alone are not journaled
+        ce.commandEntered("swap");
+        ce.commandEntered("help");
+        ce.commandEntered("notACommand");
+
+        ce.commandEntered("20");
+        ce.commandEntered("prec");
+        ce.commandEntered("0.1");
+    }
+    QCOMPARE( stack.elements(), (vector<double>{7.0, 0.1}) );
+    QCOMPARE( replay(0).size(), size_t{10} );
+
+    stack.clear();
+    stack.setPrecision(0);
+    {
+        pdCalc::CommandDispatcher ce{ui};
+        ce.startJournal(JournalFileName, 10, 0);
+        QCOMPARE( stack.elements(), (vector<double>{7.0, 0.1}) );
+        QCOMPARE( stack.precision(), 20u );
+        QVERIFY( !stack.exactElements().empty() && stack.exactElements().back() );
+        QCOMPARE( stack.exactElements().back()->toString(), string{"0.1"} );
+
+        // the undo history came back with the stack, and the session carries on
+        for(int i = 0; i < 4; ++i)
+            ce.commandEntered("undo");
+        QCOMPARE( stack.elements(), (vector<double>{3.0, 4.0}) );
+        QCOMPARE( stack.precision(), 0u );
+        ce.commandEntered("*");
+        QCOMPARE( stack.elements(), vector<double>{12.0} );
+    }
+    QCOMPARE( replay(0).size(), size_t{15} );
+
+    return;
+}
+
+void JournalTest::testCheckpoint()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    {
+        pdCalc::CommandDispatcher ce{ui};
+        ce.startJournal(JournalFileName, 0, 3);
+        ce.commandEntered("1");
+        ce.commandEntered("2");
+        ce.commandEntered("3");
+        QCOMPARE( replay(1).size(), size_t{0} );
+
+        // the undo history ends at the checkpoint
+        ce.commandEntered("undo");
+        QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+
+        ce.commandEntered("4");
+        ce.commandEntered("+");
+        QCOMPARE( replay(1), (vector<string>{"4.000000", "+"}) );
+    }
+
+    // entries replayed count toward the next checkpoint
+    stack.clear();
+    {
+        pdCalc::CommandDispatcher ce{ui};
+        ce.startJournal(JournalFileName, 0, 3);
+        QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 7.0}) );
+
+        ce.commandEntered("undo");
+        QVERIFY( replay(2).empty() );
+        ce.commandEntered("undo");
+        QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0, 4.0}) );
+
+        ce.commandEntered("5");
+        QCOMPARE( replay(2), vector<string>{"5.000000"} );
+
+        // a checkpoint written just before a crash, before the journal was emptied
+        pdCalc::SaveStackSnapshot(CheckpointFileName, 3);
+    }
+
+    // supersedes the journal
+    stack.clear();
+    pdCalc::CommandDispatcher ce{ui};
+    ce.startJournal(JournalFileName, 0, 3);
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0, 4.0, 5.0}) );
+    QVERIFY( replay(2).empty() );
+
+    return;
+}
+
+// an undo that fails partway is journaled as the steps it took
+void JournalTest::testPartialUndo()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    {
+        pdCalc::CommandDispatcher ce{ui};
+        ce.spillHistory(HistoryFileName, 2);
+        ce.startJournal(JournalFileName, 0, 0);
+        for(int i = 1; i <= 5; ++i)
+            ce.commandEntered( std::to_string(i) );
+
+        // the spilled entries cannot be read back once their file is gone
+        std::remove(HistoryFileName);
+        ce.commandEntered("undo:4");
+        QVERIFY( !ui.lastMessage.empty() );
+        QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+    }
+
+    QCOMPARE( replay(0), (vector<string>{"1.000000", "2.000000", "3.000000", "4.000000", "5.000000", "undo:2"}) );
+
+    stack.clear();
+    pdCalc::CommandDispatcher ce{ui};
+    ce.startJournal(JournalFileName, 0, 0);
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0, 3.0}) );
+
+    return;
+}
@@ -0,0 +1,332 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MapProcedureTest.h"
+#include "src/backend/MapProcedure.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/Exception.h"
+#include "src/utilities/UserInterface.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { lastMessage = m; }
+    void stackChanged() override { }
+
+    string lastMessage;
+};
+
+const char* ProcedureFileName = "mapTestProcedure.psp";
+
+void writeProcedure(const string& text)
+{
+    std::ofstream ofs{ProcedureFileName};
+    ofs << text;
+}
+
+// the whole stack, bottom first
+vector<double> stackContents()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    vector<double> v( stack.size() );
+    stack.peekElements( v.size(), v.data() );
+
+    return v;
+}
+
+void pushAll(const vector<double>& v)
+{
+    for(auto d : v)
+        pdCalc::Stack::Instance().push(d);
+}
+
+// the message of the exception executing a map throws, or "" if it succeeds
+string mapError(pdCalc::MapProcedure& map)
+{
+    try
+    {
+        map.execute();
+    }
+    catch(pdCalc::Exception& e)
+    {
+        return e.what();
+    }
+
+    return "";
+}
+
+}
+
+void MapProcedureTest::init()
+{
+    pdCalc::Stack::Instance().clear();
+    std::remove(ProcedureFileName);
+
+    return;
+}
+
+void MapProcedureTest::testPreconditions()
+{
+    writeProcedure("1 +");
+
+    pdCalc::MapProcedure map{ProcedureFileName};
+    QCOMPARE( mapError(map), string{"Stack must have a count on top"} );
+
+    pushAll({1.0, 2.0, 0.0});
+    QCOMPARE( mapError(map), string{"Count must be a positive integer"} );
+
+    pdCalc::Stack::Instance().clear();
+    pushAll({1.0, 2.0, 1.5});
+    QCOMPARE( mapError(map), string{"Count must be a positive integer"} );
+
+    pdCalc::Stack::Instance().clear();
+    pushAll({1.0, 2.0, 3.0});
+    QCOMPARE( mapError(map), string{"Stack has fewer elements than the count"} );
+    QCOMPARE( stackContents(), (vector<double>{1.0, 2.0, 3.0}) );
+
+    pdCalc::MapProcedure missing{"DoesNotExist"};
+    pdCalc::Stack::Instance().clear();
+    pushAll({1.0, 1.0});
+    QCOMPARE( mapError(missing), string{"Could not open procedure"} );
+
+    return;
+}
+
+void MapProcedureTest::testMap()
+{
+    writeProcedure("dup * 1 +");
+    pushAll({10.0, 1.0, 2.0, 3.0, 4.0, 4.0});
+
+    pdCalc::MapProcedure map{ProcedureFileName};
+    QCOMPARE( mapError(map), string{""} );
+    QCOMPARE( stackContents(), (vector<double>{10.0, 2.0, 5.0, 10.0, 17.0}) );
+
+    map.undo();
+    QCOMPARE( stackContents(), (vector<double>{10.0, 1.0, 2.0, 3.0, 4.0, 4.0}) );
+
+    map.execute();
+    QCOMPARE( stackContents(), (vector<double>{10.0, 2.0, 5.0, 10.0, 17.0}) );
+
+    return;
+}
+
+void MapProcedureTest::testControlFlow()
+{
+    // x * 8 for negative x, x + 1 otherwise
+    writeProcedure("dup dup sq 0.5 pow swap - if 3 times 2 * end else 1 + end");
+    pushAll({-1.0, 2.0, -3.0, 0.0, 4.0});
+
+    pdCalc::MapProcedure map{ProcedureFileName};
+    QCOMPARE( mapError(map), string{""} );
+    QCOMPARE( stackContents(), (vector<double>{-8.0, 3.0, -24.0, 1.0}) );
+
+    return;
+}
+
+void MapProcedureTest::testSideEffectsRejected()
+{
+    vector<std::pair<string, string>> procedures = {
+        {"1 + 10 prec", "Map procedures cannot use prec"},
+        {"clear 1", "Map procedures cannot use clear"},
+        {"1 + undo", "Map procedures cannot use undo"},
+        {"proc:other", "Map procedures cannot use proc:other"},
+        {"sinh", "Map procedures cannot use sinh"},
+        {"drop drop 1", "Element 1 below the count: Procedure reaches outside its element"},
+        {"+", "Element 1 below the count: Procedure reaches outside its element"},
+        {"dup", "Element 1 below the count: Procedure must leave one result"},
+        {"1 + end", "Procedure has end without times or if"}
+    };
+
+    for(const auto& p : procedures)
+    {
+        writeProcedure(p.first);
+        pdCalc::Stack::Instance().clear();
+        pushAll({5.0, 1.0, 2.0, 2.0});
+
+        pdCalc::MapProcedure map{ProcedureFileName};
+        QCOMPARE( mapError(map), p.second );
+        QCOMPARE( stackContents(), (vector<double>{5.0, 1.0, 2.0, 2.0}) );
+    }
+
+    return;
+}
+
+void MapProcedureTest::testElementErrors()
+{
+    // the failure nearest the top is the one reported
+    writeProcedure("1 swap /");
+    pushAll({0.0, 1.0, 0.0, 2.0, 4.0});
+
+    pdCalc::MapProcedure map{ProcedureFileName};
+    QCOMPARE( mapError(map), string{"Element 2 below the count: Division by zero"} );
+    QCOMPARE( stackContents(), (vector<double>{0.0, 1.0, 0.0, 2.0, 4.0}) );
+
+    vector<std::pair<string, string>> procedures = {
+        {"arcsin", "Invalid argument"},
+        {"0.5 pow", "Invalid result"},
+        {"drop 1.5707963267948966 tan", "Infinite result"},
+        {"times 1 end", "times: count must be a nonnegative integer"}
+    };
+
+    for(const auto& p : procedures)
+    {
+        writeProcedure(p.first);
+        pdCalc::Stack::Instance().clear();
+        pushAll({-2.5, 1.0});
+
+        pdCalc::MapProcedure m{ProcedureFileName};
+        QCOMPARE( mapError(m), "Element 1 below the count: " + p.second );
+    }
+
+    return;
+}
+
+// a map of one command gives what the command gives, error or result, since both
+// use the core operations
+void MapProcedureTest::testAgreesWithCommands()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+
+    struct Case { double next; double top; string command; };
+    vector<Case> cases = {
+        {1.0, 0.0, "/"}, {1.0, 4.0, "/"}, {0.0, -0.5, "pow"}, {-8.0, 0.5, "pow"}, {-8.0, 3.0, "pow"},
+        {9.0, 0.0, "root"}, {9.0, 2.0, "root"}, {-8.0, 0.5, "root"},
+        {0.0, 1.5707963267948966, "tan"}, {0.0, 0.5, "tan"}, {0.0, 1.5, "arcsin"}, {0.0, -1.0, "arccos"},
+        {0.0, 2.0, "sq"}, {0.0, 2.0, "neg"}, {0.0, 2.0, "arctan"}
+    };
+
+    for(const auto& c : cases)
+    {
+        const bool unary{ c.command != "/" && c.command != "pow" && c.command != "root" };
+
+        pdCalc::Stack& stack = pdCalc::Stack::Instance();
+        stack.clear();
+        pushAll({c.next, c.top});
+        auto command = pdCalc::CommandRepository::Instance().allocateCommand(c.command);
+        string commandError;
+        try
+        {
+            command->execute();
+        }
+        catch(pdCalc::Exception& e)
+        {
+            commandError = e.what();
+        }
+        const double commandResult{ stack.getElements(1).front() };
+
+        // the map's element is the command's top operand, or its next for a binary
+        // command, whose top is then a literal
+        std::ostringstream procedure;
+        procedure.precision(17);
+        if(!unary) procedure << c.top << " ";
+        procedure << c.command;
+        writeProcedure( procedure.str() );
+        stack.clear();
+        pushAll({unary ? c.top : c.next, 1.0});
+        pdCalc::MapProcedure map{ProcedureFileName};
+        const string mapMessage{ mapError(map) };
+
+        if( commandError.empty() )
+        {
+            QCOMPARE( mapMessage, string{""} );
+            QCOMPARE( stack.getElements(1).front(), commandResult );
+        }
+        else QCOMPARE( mapMessage, "Element 1 below the count: " + commandError );
+    }
+
+    return;
+}
+
+void MapProcedureTest::testManyElements()
+{
+    writeProcedure("2 times dup sin swap cos * end 3 +");
+
+    const size_t n{100003};
+    vector<double> elements(n);
+    for(size_t i = 0; i < n; ++i)
+        elements[i] = 0.001 * static_cast<double>(i) - 50.0;
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.pushElements( elements.data(), n, true );
+    stack.push( static_cast<double>(n) );
+
+    pdCalc::MapProcedure map{ProcedureFileName};
+    QCOMPARE( mapError(map), string{""} );
+
+    vector<double> results = stackContents();
+    QCOMPARE( results.size(), n );
+
+    bool inOrder{true};
+    for(size_t i = 0; i < n; ++i)
+    {
+        double x{ elements[i] };
+        for(int j = 0; j < 2; ++j)
+            x = std::sin(x) * std::cos(x);
+
+        inOrder = inOrder && results[i] == x + 3;
+    }
+    QVERIFY(inOrder);
+
+    map.undo();
+    QCOMPARE( stack.size(), n + 1 );
+    QCOMPARE( stack.getElements(1)[0], static_cast<double>(n) );
+
+    return;
+}
+
+void MapProcedureTest::testDispatch()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::CommandDispatcher ce{ui};
+
+    writeProcedure("neg");
+    pushAll({1.0, 2.0, 3.0, 2.0});
+
+    ce.commandEntered( string{"map:"} + ProcedureFileName );
+    QCOMPARE( stackContents(), (vector<double>{1.0, -2.0, -3.0}) );
+
+    ce.commandEntered("undo");
+    QCOMPARE( stackContents(), (vector<double>{1.0, 2.0, 3.0, 2.0}) );
+
+    ce.commandEntered("redo");
+    QCOMPARE( stackContents(), (vector<double>{1.0, -2.0, -3.0}) );
+
+    ce.commandEntered( string{"map:"} + ProcedureFileName );
+    QCOMPARE( ui.lastMessage, string{"Count must be a positive integer"} );
+
+    std::remove(ProcedureFileName);
+
+    return;
+}
@@ -0,0 +1,462 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PluginHostTest.h"
+#include "backend/PluginHost.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "backend/Command.h"
+#include "backend/CommandRepository.h"
+#include "backend/Stack.h"
+#include "utilities/UserInterface.h"
+#include "utilities/Exception.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef POSIX
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::vector;
+using std::string;
+using std::shared_ptr;
+using namespace pdCalc;
+
+namespace {
+
+class HostTestInterface : public UserInterface
+{
+public:
+    void postMessage(const string& m) override { messages.push_back(m); }
+    void stackChanged() override { }
+
+    vector<string> messages;
+};
+
+string pluginFile()
+{
+    std::ostringstream oss;
+    oss << BACKEND_TEST_DIR << "/" << PLUGIN_TEST_FILE;
+
+    return oss.str();
+}
+
+// the command name of the plugin, as loaded in the helper or in this process
+CommandPtr command(const Plugin& p, const string& name)
+{
+    const auto& d = p.getPluginDescriptor();
+    for(int i = 0; i < d.nCommands; ++i)
+        if(d.commandNames[i] == name) return MakeCommandPtr( d.commands[i]->clone() );
+
+    return MakeCommandPtr(nullptr);
+}
+
+// the library named first in the plugin file
+string testLibrary()
+{
+    std::ifstream ifs{ pluginFile() };
+    string library;
+    ifs >> library;
+
+    return library;
+}
+
+// puts a copy of from in place of to, as a deployment would
+void replaceFile(const string& from, const string& to)
+{
+    const string staged{to + ".new"};
+    {
+        std::ifstream in{from, std::ios::binary};
+        std::ofstream out{staged, std::ios::binary};
+        out << in.rdbuf();
+    }
+    std::remove( to.c_str() );
+    std::rename( staged.c_str(), to.c_str() );
+
+    return;
+}
+
+vector<double> stackElements()
+{
+    return Stack::Instance().elements();
+}
+
+void setStack(vector<double> v)
+{
+    vector<Stack::ExactValue> noExact;
+    Stack::Instance().swapElements(v, noExact);
+
+    return;
+}
+
+// whether name, run in the helper and in this process on the stack as it is, gives
+// the same stack; the stack is left as it was
+bool agree(const Plugin& hosted, const Plugin& inProcess, const string& name)
+{
+    auto h = command(hosted, name);
+    h->execute();
+    const auto result = stackElements();
+    h->undo();
+
+    auto p = command(inProcess, name);
+    p->execute();
+    const bool same{ stackElements() == result };
+    p->undo();
+
+    return same;
+}
+
+}
+
+void PluginHostTest::testLoading()
+{
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    QVERIFY(host->processId() != 0);
+
+    HostTestInterface ui;
+    PluginLoader hosted{host};
+    hosted.loadPlugins( ui, pluginFile() );
+    QCOMPARE(ui.messages.size(), size_t{1});
+    QCOMPARE(ui.messages[0], string{"Error opening plugin"});
+
+    HostTestInterface ui2;
+    PluginLoader loader;
+    loader.loadPlugins( ui2, pluginFile() );
+
+    auto plugins = hosted.getPlugins();
+    auto inProcess = loader.getPlugins();
+    QCOMPARE( plugins.size(), size_t{1} );
+    QCOMPARE( inProcess.size(), size_t{1} );
+    QVERIFY( PluginLoader::Supported(*plugins[0]) );
+
+    const auto& d = plugins[0]->getPluginDescriptor();
+    const auto& expected = inProcess[0]->getPluginDescriptor();
+    QCOMPARE(d.nCommands, expected.nCommands);
+    for(int i = 0; i < d.nCommands; ++i)
+    {
+        QCOMPARE( string{d.commandNames[i]}, string{expected.commandNames[i]} );
+        QCOMPARE( string{d.commands[i]->helpMessage()}, string{expected.commands[i]->helpMessage()} );
+    }
+
+    auto b = plugins[0]->getPluginButtonDescriptor();
+    auto expectedButtons = inProcess[0]->getPluginButtonDescriptor();
+    QCOMPARE(b != nullptr, expectedButtons != nullptr);
+    if(b)
+    {
+        QCOMPARE(b->nButtons, expectedButtons->nButtons);
+        for(int i = 0; i < b->nButtons; ++i)
+        {
+            QCOMPARE( string{b->dispPrimaryCmd[i]}, string{expectedButtons->dispPrimaryCmd[i]} );
+            QCOMPARE( string{b->primaryCmd[i]}, string{expectedButtons->primaryCmd[i]} );
+            QCOMPARE( string{b->dispShftCmd[i]}, string{expectedButtons->dispShftCmd[i]} );
+            QCOMPARE( string{b->shftCmd[i]}, string{expectedButtons->shftCmd[i]} );
+        }
+    }
+
+    QCOMPARE(host->restarts(), size_t{0});
+}
+
+void PluginHostTest::testCommands()
+{
+    HostTestInterface ui;
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader loader{host};
+    loader.loadPlugins( ui, pluginFile() );
+    auto names = loader.registerCommands(ui);
+    QVERIFY( names.find("sinh") != names.end() );
+
+    Stack& stack = Stack::Instance();
+    stack.clear();
+    auto& repository = CommandRepository::Instance();
+
+    // a failed precondition is the plugin's, and leaves the stack alone
+    auto c = repository.allocateCommand("sinh");
+    try
+    {
+        c->execute();
+        QVERIFY(false);
+    }
+    catch(Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Stack must have one element"} );
+    }
+    QCOMPARE( stack.size(), size_t{0} );
+
+    setStack({2.0, 0.5});
+    c->execute();
+    QCOMPARE( stackElements(), (vector<double>{2.0, std::sinh(0.5)}) );
+
+    auto c2 = repository.allocateCommand("ln");
+    c2->execute();
+    QCOMPARE( stackElements(), (vector<double>{2.0, std::log( std::sinh(0.5) )}) );
+
+    // undo and redo do not go to the helper
+    c2->undo();
+    c->undo();
+    QCOMPARE( stackElements(), (vector<double>{2.0, 0.5}) );
+    c->execute();
+    c2->execute();
+    QCOMPARE( stackElements(), (vector<double>{2.0, std::log( std::sinh(0.5) )}) );
+
+    // a copy runs afresh
+    auto c3 = MakeCommandPtr( c->clone() );
+    c3->execute();
+    QCOMPARE( stackElements(), (vector<double>{2.0, std::sinh( std::log( std::sinh(0.5) ) )}) );
+
+    c3.reset();
+    c2.reset();
+    c.reset();
+    loader.deregisterCommands();
+    stack.clear();
+}
+
+// the stack streams through the rings, which it is larger than
+void PluginHostTest::testBlockCommands()
+{
+    HostTestInterface ui;
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader hosted{host};
+    hosted.loadPlugins( ui, pluginFile() );
+    PluginLoader loader;
+    loader.loadPlugins( ui, pluginFile() );
+
+    const size_t n{300000};
+    vector<double> v(n + 1);
+    for(size_t i = 0; i < n; ++i) v[i] = 0.001 * static_cast<double>(i % 1000) - 0.5;
+    v[n] = static_cast<double>(n - 10);
+
+    setStack(v);
+    auto expected = command(*loader.getPlugins()[0], "sinhn");
+    expected->execute();
+    const auto inProcess = stackElements();
+    QCOMPARE( inProcess.size(), n );
+
+    setStack(v);
+    auto c = command(*hosted.getPlugins()[0], "sinhn");
+    c->execute();
+    QVERIFY( stackElements() == inProcess );
+    c->undo();
+    QVERIFY( stackElements() == v );
+    c->execute();
+    QVERIFY( stackElements() == inProcess );
+
+    // a block too large for the stack fails in the helper
+    setStack({1.0, 2.0, 5.0});
+    auto tooMany = command(*hosted.getPlugins()[0], "sinhn");
+    try
+    {
+        tooMany->execute();
+        QVERIFY(false);
+    }
+    catch(Exception&)
+    { }
+    QCOMPARE( stackElements(), (vector<double>{1.0, 2.0, 5.0}) );
+
+    Stack::Instance().clear();
+}
+
+// the helper's copy of the stack follows every change made between calls
+void PluginHostTest::testStackCopy()
+{
+    HostTestInterface ui;
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader hosted{host};
+    hosted.loadPlugins( ui, pluginFile() );
+    auto otherHost = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader other{otherHost};
+    other.loadPlugins( ui, pluginFile() );
+    PluginLoader loader;
+    loader.loadPlugins( ui, pluginFile() );
+
+    const Plugin& h = *hosted.getPlugins()[0];
+    const Plugin& o = *other.getPlugins()[0];
+    const Plugin& p = *loader.getPlugins()[0];
+    Stack& stack = Stack::Instance();
+
+    setStack({0.1, 0.2, 0.3, 0.4, 4.0});
+    QVERIFY( agree(h, p, "sinhn") );
+
+    // changes below the top
+    stack.pop();
+    stack.pop();
+    stack.pop();
+    stack.push(0.8);
+    stack.push(0.6);
+    stack.push(4.0);
+    QVERIFY( agree(h, p, "sinhn") );
+
+    // a change at the bottom only
+    setStack({0.5, 0.2, 0.8, 0.6, 4.0});
+    QVERIFY( agree(h, p, "sinhn") );
+
+    // calls to another helper in between
+    QVERIFY( agree(o, p, "sinhn") );
+    stack.pop();
+    stack.push(3.0);
+    QVERIFY( agree(h, p, "sinhn") );
+
+    Stack::Instance().clear();
+}
+
+void PluginHostTest::testRestart()
+{
+#ifdef POSIX
+    HostTestInterface ui;
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader loader{host};
+    loader.loadPlugins( ui, pluginFile() );
+    auto plugin = loader.getPlugins()[0];
+
+    setStack({0.5});
+    auto c = command(*plugin, "sinh");
+    c->execute();
+
+    // a helper that stops between calls is restarted, and the call goes to the new one
+    const long first{ host->processId() };
+    kill(static_cast<pid_t>(first), SIGKILL);
+
+    auto c2 = command(*plugin, "exp");
+    c2->execute();
+    QCOMPARE( stackElements(), (vector<double>{ std::exp( std::sinh(0.5) ) }) );
+    QCOMPARE( host->restarts(), size_t{1} );
+    QVERIFY( host->processId() != first );
+
+    // what ran in the old helper is undone without it
+    c2->undo();
+    c->undo();
+    QCOMPARE( stackElements(), (vector<double>{0.5}) );
+
+    Stack::Instance().clear();
+#endif
+}
+
+void PluginHostTest::testReloadRestart()
+{
+#ifdef POSIX
+    const string original{ testLibrary() };
+    const string library{ "./hostReloadTestPlugin" + original.substr( original.find_last_of('.') ) };
+    const string file{"hostReloadTest.pdp"};
+    replaceFile(original, library);
+    std::ofstream{file} << library << std::endl;
+
+    HostTestInterface ui;
+    CommandRepository::Instance().clearAllCommands();
+    auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+    PluginLoader loader{host};
+    loader.loadPlugins(ui, file);
+    loader.registerCommands(ui);
+    loader.watchPlugins(ui);
+
+    setStack({0.5});
+    auto old = CommandRepository::Instance().allocateCommand("sinh");
+    old->execute();
+
+    // the reload is done once both versions are open
+    replaceFile(original, library);
+    for(int i = 0; i < 500 && loader.openLibraries() < 2; ++i)
+        std::this_thread::sleep_for( std::chrono::milliseconds{10} );
+    QCOMPARE( loader.openLibraries(), size_t{2} );
+
+    // a restarted helper loads both versions again, the new one from its copy
+    kill(static_cast<pid_t>( host->processId() ), SIGKILL);
+
+    auto c = CommandRepository::Instance().allocateCommand("arcsinh");
+    c->execute();
+    QVERIFY( std::abs( stackElements().back() - 0.5 ) < 1e-12 );
+    QCOMPARE( host->restarts(), size_t{1} );
+
+    auto again = MakeCommandPtr( old->clone() );
+    again->execute();
+    QVERIFY( std::abs( stackElements().back() - std::sinh(0.5) ) < 1e-12 );
+
+    again.reset();
+    c.reset();
+    old.reset();
+    loader.deregisterCommands();
+    Stack::Instance().clear();
+    std::remove( library.c_str() );
+    std::remove( file.c_str() );
+#endif
+}
+
+void PluginHostTest::testReloadFromSearchPath()
+{
+#ifdef POSIX
+    // a plugin named without a directory is found on the helper's search path, and
+    // is watched and copied there, not beside pdCalc
+    char cwd[4096];
+    QVERIFY( getcwd( cwd, sizeof(cwd) ) != nullptr );
+    const string directory{ string{cwd} + "/hostSearchPath" };
+    mkdir(directory.c_str(), 0755);
+
+    const string original{ testLibrary() };
+    const string name{ "libhostSearchTestPlugin" + original.substr( original.find_last_of('.') ) };
+    const string library{ directory + "/" + name };
+    const string file{"hostSearchTest.pdp"};
+    replaceFile(original, library);
+    std::ofstream{file} << name << std::endl;
+
+    const char* path{ getenv("LD_LIBRARY_PATH") };
+    const string oldPath{ path ? path : "" };
+    setenv("LD_LIBRARY_PATH", ( oldPath.empty() ? directory : directory + ":" + oldPath ).c_str(), 1);
+
+    // the copy the reload loaded is kept until the loader closes it
+    {
+        HostTestInterface ui;
+        CommandRepository::Instance().clearAllCommands();
+        auto host = std::make_shared<PluginHost>(PLUGIN_HOST_TEST_FILE);
+        PluginLoader loader{host};
+        loader.loadPlugins(ui, file);
+        QCOMPARE( loader.getPlugins().size(), size_t{1} );
+        loader.registerCommands(ui);
+        loader.watchPlugins(ui);
+
+        // the reload is done once both versions are open
+        setStack({0.5});
+        auto old = CommandRepository::Instance().allocateCommand("sinh");
+        old->execute();
+        replaceFile(original, library);
+        for(int i = 0; i < 500 && loader.openLibraries() < 2; ++i)
+            std::this_thread::sleep_for( std::chrono::milliseconds{10} );
+        QCOMPARE( loader.openLibraries(), size_t{2} );
+
+        auto c = CommandRepository::Instance().allocateCommand("arcsinh");
+        c->execute();
+        QVERIFY( std::abs( stackElements().back() - 0.5 ) < 1e-12 );
+
+        c.reset();
+        old.reset();
+        loader.deregisterCommands();
+    }
+    Stack::Instance().clear();
+    if( oldPath.empty() ) unsetenv("LD_LIBRARY_PATH");
+    else setenv("LD_LIBRARY_PATH", oldPath.c_str(), 1);
+    std::remove( library.c_str() );
+    std::remove( file.c_str() );
+    rmdir( directory.c_str() );
+#endif
+}
@@ -20,6 +20,15 @@
 #include "backend/PluginLoader.h"
 #include "utilities/UserInterface.h"
 #include "backend/Plugin.h"
+#include "backend/CommandRepository.h"
+#include "backend/Stack.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -38,6 +47,87 @@ public:
     void stackChanged() override { }
 };
 
+namespace {
+
+// reloads are reported on the watcher's thread
+class WatchingInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override;
+    void stackChanged() override { }
+
+    // waits up to five seconds for message m
+    bool waitFor(const string& m);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable posted_;
+    vector<string> messages_;
+};
+
+void WatchingInterface::postMessage(const string& m)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        messages_.push_back(m);
+    }
+    posted_.notify_all();
+
+    return;
+}
+
+bool WatchingInterface::waitFor(const string& m)
+{
+    std::unique_lock<std::mutex> lock{mutex_};
+    bool found = posted_.wait_for( lock, std::chrono::seconds{5},
+        [&]{ return std::find( messages_.begin(), messages_.end(), m ) != messages_.end(); } );
+    messages_.clear();
+
+    return found;
+}
+
+// the library named first in the plugin file
+string testLibrary()
+{
+    std::ostringstream pluginFile;
+    pluginFile << BACKEND_TEST_DIR << "/" << PLUGIN_TEST_FILE;
+    std::ifstream ifs{ pluginFile.str() };
+    string library;
+    ifs >> library;
+
+    return library;
+}
+
+void copyFile(const string& from, const string& to)
+{
+    std::ifstream in{from, std::ios::binary};
+    std::ofstream out{to, std::ios::binary};
+    out << in.rdbuf();
+
+    return;
+}
+
+// puts a new file in place of to, as a deployment would
+void replaceFile(const string& from, const string& to)
+{
+    const string staged{to + ".new"};
+    copyFile(from, staged);
+    std::remove( to.c_str() );
+    std::rename( staged.c_str(), to.c_str() );
+
+    return;
+}
+
+double runCommand(const string& name)
+{
+    auto c = pdCalc::CommandRepository::Instance().allocateCommand(name);
+    c->execute();
+
+    return pdCalc::Stack::Instance().getElements(1).back();
+}
+
+}
+
 void PluginLoaderTest::testLoading()
 {
     TestInterface ui;
@@ -66,3 +156,87 @@ void PluginLoaderTest::testNoPluginFile()
 
     return;
 }
+
+void PluginLoaderTest::testRegisterCommands()
+{
+    TestInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack::Instance().clear();
+
+    {
+        pdCalc::PluginLoader loader;
+
+        std::ostringstream pluginFile;
+        pluginFile << BACKEND_TEST_DIR << "/" << PLUGIN_TEST_FILE;
+        loader.loadPlugins(ui, pluginFile.str());
+        auto names = loader.registerCommands(ui);
+        QVERIFY( names.count("sinh") == 1 );
+        QCOMPARE( pdCalc::CommandRepository::Instance().getNumberCommands(), names.size() );
+        QVERIFY( pdCalc::PluginLoader::Supported( *loader.getPlugins()[0] ) );
+
+        pdCalc::Stack::Instance().push(1.0);
+        QCOMPARE( runCommand("sinh"), std::sinh(1.0) );
+
+        // a command outlives the loader, and keeps the library open
+        auto c = pdCalc::CommandRepository::Instance().allocateCommand("cosh");
+        loader.deregisterCommands();
+        QCOMPARE( pdCalc::CommandRepository::Instance().getNumberCommands(), size_t{0} );
+        QCOMPARE( loader.openLibraries(), size_t{1} );
+
+        c->execute();
+    }
+    QCOMPARE( pdCalc::Stack::Instance().getElements(1).back(), std::cosh( std::sinh(1.0) ) );
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+void PluginLoaderTest::testReload()
+{
+    WatchingInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack::Instance().clear();
+
+    const string original{ testLibrary() };
+    const string library{ "./reloadTestPlugin" + original.substr( original.find_last_of('.') ) };
+    const string pluginFile{"reloadTest.pdp"};
+    copyFile(original, library);
+    std::ofstream{pluginFile} << library << std::endl;
+
+    pdCalc::PluginLoader loader;
+    loader.loadPlugins(ui, pluginFile);
+    loader.registerCommands(ui);
+    loader.watchPlugins(ui);
+
+    pdCalc::Stack::Instance().push(1.0);
+    auto old = pdCalc::CommandRepository::Instance().allocateCommand("sinh");
+    old->execute();
+
+    // the old version stays open for the command still using it
+    replaceFile(original, library);
+    QVERIFY( ui.waitFor("Reloaded plugin " + library) );
+    QCOMPARE( loader.openLibraries(), size_t{2} );
+    QCOMPARE( runCommand("arcsinh"), 1.0 );
+
+    old->undo();
+    QCOMPARE( pdCalc::Stack::Instance().getElements(2), vector<double>{1.0} );
+    old.reset();
+    QCOMPARE( loader.openLibraries(), size_t{1} );
+
+    // a version that does not load leaves the last one in place
+    {
+        std::ofstream{pluginFile + ".broken"} << "not a library" << std::endl;
+    }
+    replaceFile(pluginFile + ".broken", library);
+    QVERIFY( ui.waitFor("Error opening plugin " + library) );
+    QCOMPARE( loader.openLibraries(), size_t{1} );
+    QCOMPARE( runCommand("sinh"), std::sinh(1.0) );
+
+    loader.deregisterCommands();
+    pdCalc::Stack::Instance().clear();
+    std::remove( library.c_str() );
+    std::remove( pluginFile.c_str() );
+    std::remove( (pluginFile + ".broken").c_str() );
+
+    return;
+}
@@ -27,6 +27,8 @@ class PluginLoaderTest : public QObject
 private slots:
     void testLoading();
     void testNoPluginFile();
+    void testRegisterCommands();
+    void testReload();
 };
 
 #endif
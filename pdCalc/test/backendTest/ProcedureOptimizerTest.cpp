@@ -0,0 +1,177 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ProcedureOptimizerTest.h"
+#include "src/backend/ProcedureOptimizer.h"
+#include <sstream>
+#include <string>
+
+using std::string;
+using pdCalc::ProcedureOptimizer;
+using pdCalc::Tokenizer;
+
+namespace {
+
+string optimize(const string& procedure, size_t stackDepth, bool plain = true)
+{
+    std::istringstream iss{procedure};
+    Tokenizer t{iss};
+    ProcedureOptimizer optimizer{stackDepth, plain};
+    Tokenizer::Tokens tokens = optimizer.optimize( Tokenizer::Tokens{t.begin(), t.end()} );
+
+    string result;
+    for(const auto& token : tokens)
+        result += (result.empty() ? "" : " ") + token;
+
+    return result;
+}
+
+}
+
+void ProcedureOptimizerTest::testFolding()
+{
+    QCOMPARE( optimize("2 3 pow 4 *", 0), string{"32"} );
+    QCOMPARE( optimize("1 4 / 2 -", 0), string{"-1.75"} );
+    QCOMPARE( optimize("1.5 neg", 0), string{"-1.5"} );
+    QCOMPARE( optimize("-2 sq", 0), string{"4"} );
+    QCOMPARE( optimize("1 2 swap -", 0), string{"1"} );
+    QCOMPARE( optimize("7 drop", 0), string{""} );
+    QCOMPARE( optimize("5 4 3 + +", 0), string{"12"} );
+    QCOMPARE( optimize("0.1 0.2 +", 0), string{"0.30000000000000004"} );
+
+    // only numbers fold, and sin is not folded
+    QCOMPARE( optimize("2 sin 3 +", 0), string{"2 sin 3 +"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testFoldingKeepsErrors()
+{
+    QCOMPARE( optimize("1 0 /", 0), string{"1 0 /"} );
+    QCOMPARE( optimize("-1 0.5 pow", 0), string{"-1 0.5 pow"} );
+    QCOMPARE( optimize("0 -1 pow", 0), string{"0 -1 pow"} );
+    QCOMPARE( optimize("1e300 1e300 *", 0), string{"1e300 1e300 *"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testCancellation()
+{
+    QCOMPARE( optimize("swap swap neg neg dup drop", 2), string{""} );
+    QCOMPARE( optimize("swap neg neg swap", 2), string{""} );
+
+    // the pairs would have reported a short stack
+    QCOMPARE( optimize("swap swap", 1), string{"swap swap"} );
+    QCOMPARE( optimize("neg neg", 0), string{"neg neg"} );
+    QCOMPARE( optimize("dup drop", 0), string{"dup drop"} );
+
+    // a plugin command leaves the depth unknown
+    QCOMPARE( optimize("sinh swap swap", 2), string{"sinh swap swap"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testIdentities()
+{
+    QCOMPARE( optimize("1 * 0 - 1 / 1 pow -0 +", 1), string{""} );
+    QCOMPARE( optimize("1 *", 0), string{"1 *"} );
+
+    // * fails on a short stack and leaves the 1 behind for 0 -
+    QCOMPARE( optimize("1 * 0 -", 0), string{"1 *"} );
+
+    // x + 0 turns -0 into 0, and x - -0 does the same
+    QCOMPARE( optimize("0 +", 1), string{"0 +"} );
+    QCOMPARE( optimize("-0 -", 1), string{"-0 -"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testFusion()
+{
+    QCOMPARE( optimize("dup *", 1), string{"sq"} );
+    QCOMPARE( optimize("dup *", 0), string{"dup *"} );
+    QCOMPARE( optimize("3 dup *", 0), string{"9"} );
+    QCOMPARE( optimize("swap dup * swap dup * +", 2), string{"swap sq swap sq +"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testExactMode()
+{
+    QCOMPARE( optimize("2 3 +", 0, false), string{"2 3 +"} );
+    QCOMPARE( optimize("neg neg", 1, false), string{"neg neg"} );
+    QCOMPARE( optimize("swap swap dup *", 2, false), string{"sq"} );
+
+    // a precision change ends plain arithmetic
+    QCOMPARE( optimize("2 3 + 10 prec 2 3 +", 0), string{"5 10 prec 2 3 +"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testUndoRedoLeftAlone()
+{
+    QCOMPARE( optimize("2 3 + undo", 0), string{"2 3 + undo"} );
+    QCOMPARE( optimize("swap swap redo", 2), string{"swap swap redo"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testControlFlow()
+{
+    QCOMPARE( optimize("2 3 * times 3 4 + end", 0), string{"6 times 7 end"} );
+
+    // the depth inside a body is unknown
+    QCOMPARE( optimize("swap swap times swap swap end", 2), string{"times swap swap end"} );
+    QCOMPARE( optimize("if dup * else 1 * end", 3), string{"if dup * else 1 * end"} );
+
+    // no rewrite spans a keyword
+    QCOMPARE( optimize("if 2 else 3 end drop", 1), string{"if 2 else 3 end drop"} );
+
+    // the second iteration may start in exact mode
+    QCOMPARE( optimize("times 2 3 + 10 prec end", 1), string{"times 2 3 + 10 prec end"} );
+
+    return;
+}
+
+void ProcedureOptimizerTest::testReport()
+{
+    std::istringstream iss{"swap swap 2 3 pow dup *"};
+    Tokenizer t{iss};
+    ProcedureOptimizer optimizer{2, true};
+    Tokenizer::Tokens tokens = optimizer.optimize( Tokenizer::Tokens{t.begin(), t.end()} );
+
+    QCOMPARE( tokens.size(), size_t{1} );
+    QCOMPARE( tokens[0], string{"64"} );
+
+    const auto& rewrites = optimizer.rewrites();
+    QCOMPARE( rewrites.size(), size_t{4} );
+    QCOMPARE( rewrites[0].rule, string{"cancel"} );
+    QCOMPARE( rewrites[0].before, string{"swap swap"} );
+    QCOMPARE( rewrites[0].after, string{""} );
+    QCOMPARE( rewrites[1].before, string{"2 3 pow"} );
+    QCOMPARE( rewrites[1].after, string{"8"} );
+    QCOMPARE( rewrites[2].before, string{"8 dup"} );
+    QCOMPARE( rewrites[3].before, string{"8 8 *"} );
+
+    string report = optimizer.report();
+    QCOMPARE( report.substr(0, report.find('\n')), string{"Optimized 7 tokens to 1 with 4 rewrites"} );
+    QVERIFY( report.find("fold: 2 3 pow -> 8") != string::npos );
+    QVERIFY( report.find("cancel: swap swap -> (nothing)") != string::npos );
+
+    return;
+}
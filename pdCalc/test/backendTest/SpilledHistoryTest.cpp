@@ -0,0 +1,214 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "SpilledHistoryTest.h"
+#include "src/backend/SpilledHistory.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/BigNumber.h"
+#include "src/utilities/UserInterface.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { lastMessage = m; }
+    void stackChanged() override { }
+
+    string lastMessage;
+};
+
+const char* HistoryFileName = "spilledHistoryTest.psh";
+
+pdCalc::StackDelta makeDelta(size_t base, size_t removed, size_t added, double first)
+{
+    pdCalc::StackDelta d;
+    d.base = base;
+    for(size_t i = 0; i < removed; ++i) d.removed.push_back(first + i);
+    for(size_t i = 0; i < added; ++i) d.added.push_back(-first - i);
+    d.precisionBefore = 0;
+    d.precisionAfter = 0;
+
+    return d;
+}
+
+bool sameDelta(const pdCalc::StackDelta& a, const pdCalc::StackDelta& b)
+{
+    auto sameExact = [](const vector<pdCalc::Stack::ExactValue>& x, const vector<pdCalc::Stack::ExactValue>& y)
+    {
+        if( x.size() != y.size() ) return false;
+        for(size_t i = 0; i < x.size(); ++i)
+        {
+            if( bool(x[i]) != bool(y[i]) ) return false;
+            if( x[i] && x[i]->toString() != y[i]->toString() ) return false;
+        }
+        return true;
+    };
+
+    return a.base == b.base && a.removed == b.removed && a.added == b.added
+        && sameExact(a.removedExact, b.removedExact) && sameExact(a.addedExact, b.addedExact)
+        && a.precisionBefore == b.precisionBefore && a.precisionAfter == b.precisionAfter;
+}
+
+}
+
+void SpilledHistoryTest::testRecords()
+{
+    vector<pdCalc::StackDelta> deltas;
+    deltas.push_back( makeDelta(0, 0, 1, 1.0) );
+    deltas.push_back( makeDelta(1, 2, 0, 2.0) );
+    deltas.push_back( makeDelta(7, 3, 5, 3.0) );
+
+    pdCalc::StackDelta exact{ makeDelta(2, 2, 1, 4.0) };
+    exact.removedExact = { nullptr, std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.1", 30) ) };
+    exact.addedExact = { std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("1.25", 30) ) };
+    exact.precisionBefore = 30;
+    exact.precisionAfter = 40;
+    deltas.push_back(exact);
+
+    {
+        pdCalc::SpilledHistory history{HistoryFileName};
+        for(const auto& d : deltas)
+            history.append(d);
+        QCOMPARE( history.before(), size_t{4} );
+        QCOMPARE( history.after(), size_t{0} );
+
+        for(size_t i = deltas.size(); i > 0; --i)
+            QVERIFY( sameDelta( history.previous(), deltas[i - 1] ) );
+        QCOMPARE( history.before(), size_t{0} );
+        QCOMPARE( history.after(), size_t{4} );
+
+        QVERIFY( sameDelta( history.next(), deltas[0] ) );
+        QVERIFY( sameDelta( history.next(), deltas[1] ) );
+
+        // appending where redo was possible discards what followed
+        history.truncate();
+        QCOMPARE( history.after(), size_t{0} );
+        history.append(exact);
+        QVERIFY( sameDelta( history.previous(), exact ) );
+        QVERIFY( sameDelta( history.previous(), deltas[1] ) );
+
+        history.clear();
+        QCOMPARE( history.before() + history.after(), size_t{0} );
+        QCOMPARE( history.bytes(), uint64_t{0} );
+    }
+
+    // the file is scratch space, removed with the history
+    QVERIFY( !std::ifstream{HistoryFileName} );
+
+    return;
+}
+
+// enough records to need several views of the file, and one larger than a view
+void SpilledHistoryTest::testViews()
+{
+    pdCalc::SpilledHistory history{HistoryFileName};
+    const size_t n{400};
+    for(size_t i = 0; i < n; ++i)
+        history.append( makeDelta(i, i % 3, 8000, i) );
+    history.append( makeDelta(0, 0, 3000000, -1.0) );
+    QVERIFY( history.bytes() > (uint64_t{1} << 25) );
+
+    QVERIFY( sameDelta( history.previous(), makeDelta(0, 0, 3000000, -1.0) ) );
+    for(size_t i = n; i > 0; --i)
+        QVERIFY( sameDelta( history.previous(), makeDelta(i - 1, (i - 1) % 3, 8000, i - 1) ) );
+
+    for(size_t i = 0; i < n; ++i)
+        QVERIFY( sameDelta( history.next(), makeDelta(i, i % 3, 8000, i) ) );
+    QVERIFY( sameDelta( history.next(), makeDelta(0, 0, 3000000, -1.0) ) );
+
+    return;
+}
+
+// undo and redo cross between the window in memory and the file, and entering a
+// command deep in the file discards what could be redone
+void SpilledHistoryTest::testSpilledUndo()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+
+    pdCalc::CommandDispatcher ce{ui};
+    ce.spillHistory(HistoryFileName, 4);
+
+    vector<vector<double>> states{ stack.elements() };
+    const vector<string> entries{"1", "2", "+", "3", "swap", "4", "5", "*", "-", "dup", "drop", "6", "7", "8", "9",
+        "+", "+", "clear", "10", "11", "neg"};
+    for(const auto& e : entries)
+    {
+        ce.commandEntered(e);
+        states.push_back( stack.elements() );
+    }
+
+    for(size_t i = entries.size(); i > 0; --i)
+    {
+        ce.commandEntered("undo");
+        QCOMPARE( stack.elements(), states[i - 1] );
+    }
+
+    ce.commandEntered("redo:" + std::to_string( entries.size() ));
+    QCOMPARE( stack.elements(), states.back() );
+
+    ce.commandEntered("undo:16");
+    QCOMPARE( stack.elements(), states[entries.size() - 16] );
+    ce.commandEntered("redo:2");
+    QCOMPARE( stack.elements(), states[entries.size() - 14] );
+
+    ce.commandEntered("42");
+    const vector<double> branched{ stack.elements() };
+    ce.commandEntered("redo");
+    QCOMPARE( stack.elements(), branched );
+    ce.commandEntered("undo");
+    QCOMPARE( stack.elements(), states[entries.size() - 14] );
+    ce.commandEntered("undo:3");
+    QCOMPARE( stack.elements(), states[entries.size() - 17] );
+
+    // exact values and the precision come back from the file
+    ce.commandEntered("clear");
+    ce.commandEntered("25");
+    ce.commandEntered("prec");
+    ce.commandEntered("0.1");
+    ce.commandEntered("0.2");
+    ce.commandEntered("+");
+    for(int i = 0; i < 5; ++i) ce.commandEntered("1");
+    ce.commandEntered("undo:5");
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.3"} );
+    ce.commandEntered("undo:4");
+    QCOMPARE( stack.precision(), 0u );
+    QCOMPARE( stack.elements(), vector<double>{25.0} );
+    ce.commandEntered("redo:3");
+    QCOMPARE( stack.precision(), 25u );
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.2"} );
+
+    stack.setPrecision(0);
+    stack.clear();
+
+    return;
+}
@@ -0,0 +1,269 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StackSnapshotTest.h"
+#include "src/backend/StackSnapshot.h"
+#include "src/backend/CommandDispatcher.h"
+#include "src/backend/CommandRepository.h"
+#include "src/backend/CoreCommands.h"
+#include "src/backend/Stack.h"
+#include "src/utilities/Exception.h"
+#include "src/utilities/BigNumber.h"
+#include "src/utilities/UserInterface.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { lastMessage = m; }
+    void stackChanged() override { }
+
+    string lastMessage;
+};
+
+const char* SnapshotFileName = "stackSnapshotTest.pss";
+
+string readFile(const char* name)
+{
+    std::ifstream ifs{name, std::ios::binary};
+    return string{ std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{} };
+}
+
+void writeFile(const char* name, const string& contents)
+{
+    std::ofstream ofs{name, std::ios::binary};
+    ofs << contents;
+}
+
+// the message of the exception restoring the snapshot throws, or "" if it succeeds
+string restoreError(const char* name)
+{
+    try
+    {
+        pdCalc::RestoreStackSnapshot(name);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        return e.what();
+    }
+
+    return "";
+}
+
+bool sameBits(const vector<double>& a, const vector<double>& b)
+{
+    return a.size() == b.size() && std::memcmp( a.data(), b.data(), a.size() * sizeof(double) ) == 0;
+}
+
+}
+
+void StackSnapshotTest::init()
+{
+    pdCalc::Stack::Instance().clear();
+    pdCalc::Stack::Instance().setPrecision(0);
+
+    return;
+}
+
+void StackSnapshotTest::cleanup()
+{
+    init();
+    std::remove(SnapshotFileName);
+
+    return;
+}
+
+void StackSnapshotTest::testRoundTrip()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    const vector<double> v{1.0, -0.0, std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::denorm_min(), -1.5e300, 3.25};
+    stack.pushElements( v.data(), v.size() );
+    pdCalc::SaveStackSnapshot(SnapshotFileName);
+    QCOMPARE( readFile(SnapshotFileName).size(), 64 + v.size() * sizeof(double) );
+
+    stack.clear();
+    stack.push(99.0);
+    QCOMPARE( restoreError(SnapshotFileName), string{} );
+    QVERIFY( sameBits(stack.elements(), v) );
+    QVERIFY( stack.exactElements().empty() );
+
+    // an empty stack
+    stack.clear();
+    pdCalc::SaveStackSnapshot(SnapshotFileName);
+    stack.push(1.0);
+    QCOMPARE( restoreError(SnapshotFileName), string{} );
+    QCOMPARE( stack.size(), size_t{0} );
+
+    return;
+}
+
+void StackSnapshotTest::testExactValues()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.setPrecision(30);
+
+    auto third = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.333333333333333333333333333333", 30) );
+    auto big = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("-1.23456789012345678901234567e250", 30) );
+    stack.push(1.0);
+    stack.push(third->toDouble(), third);
+    stack.push(2.0);
+    stack.push(big->toDouble(), big);
+    pdCalc::SaveStackSnapshot(SnapshotFileName);
+
+    stack.clear();
+    stack.setPrecision(0);
+    QCOMPARE( restoreError(SnapshotFileName), string{} );
+    QCOMPARE( stack.precision(), 30u );
+    QCOMPARE( stack.getElements(4), (vector<double>{big->toDouble(), 2.0, third->toDouble(), 1.0}) );
+
+    auto exact = stack.getExactElements(4);
+    QVERIFY( exact[0] && exact[0]->toString() == big->toString() );
+    QVERIFY( !exact[1] );
+    QVERIFY( exact[2] && exact[2]->toString() == third->toString() );
+    QVERIFY( !exact[3] );
+
+    return;
+}
+
+void StackSnapshotTest::testLargeStack()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    // several checksum blocks, the last one partial
+    vector<double> v(300007);
+    for(size_t i = 0; i < v.size(); ++i)
+        v[i] = 0.5 * i - 1000;
+    stack.pushElements( v.data(), v.size() );
+    pdCalc::SaveStackSnapshot(SnapshotFileName);
+
+    stack.clear();
+    QCOMPARE( restoreError(SnapshotFileName), string{} );
+    QVERIFY( sameBits(stack.elements(), v) );
+
+    // damage near the end is found as well as damage near the start
+    string contents{ readFile(SnapshotFileName) };
+    contents[contents.size() - 3] ^= 1;
+    writeFile(SnapshotFileName, contents);
+    stack.clear();
+    QCOMPARE( restoreError(SnapshotFileName), string{SnapshotFileName} + " is damaged" );
+    QCOMPARE( stack.size(), size_t{0} );
+
+    return;
+}
+
+void StackSnapshotTest::testDamagedFiles()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    QCOMPARE( restoreError("noSuchSnapshot.pss"), string{"Could not open noSuchSnapshot.pss"} );
+
+    stack.setPrecision(20);
+    stack.push(1.0);
+    stack.push(0.1, std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.1", 20) ));
+    pdCalc::SaveStackSnapshot(SnapshotFileName);
+    const string good{ readFile(SnapshotFileName) };
+
+    // a failed restore leaves the stack and precision alone
+    stack.clear();
+    stack.setPrecision(0);
+    stack.push(42.0);
+
+    auto damaged = [&](size_t position, char value)
+    {
+        string contents{good};
+        contents[position] = value;
+        writeFile(SnapshotFileName, contents);
+        return restoreError(SnapshotFileName);
+    };
+
+    const string name{SnapshotFileName};
+    QCOMPARE( damaged(0, 'x'), name + " is not a stack snapshot" );
+    QCOMPARE( damaged(8, 2), string{"Snapshot version 2 is not supported"} );
+    QCOMPARE( damaged(16, 3), name + " is truncated or damaged" );
+    QCOMPARE( damaged(64, 1), name + " is damaged" );
+    QCOMPARE( damaged(good.size() - 1, '7'), name + " is damaged" );
+
+    writeFile( SnapshotFileName, good.substr(0, good.size() - 1) );
+    QCOMPARE( restoreError(SnapshotFileName), name + " is truncated or damaged" );
+
+    writeFile( SnapshotFileName, good.substr(0, 10) );
+    QCOMPARE( restoreError(SnapshotFileName), name + " is not a stack snapshot" );
+
+    QCOMPARE( stack.elements(), vector<double>{42.0} );
+    QCOMPARE( stack.precision(), 0u );
+
+    writeFile(SnapshotFileName, good);
+    QCOMPARE( restoreError(SnapshotFileName), string{} );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 0.1}) );
+
+    return;
+}
+
+void StackSnapshotTest::testDispatch()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    pdCalc::CommandDispatcher ce{ui};
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    ce.commandEntered("1");
+    ce.commandEntered("2");
+    ce.commandEntered( string{"save:"} + SnapshotFileName );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+
+    // saving is not undone, so undo drops the 2
+    ce.commandEntered("undo");
+    QCOMPARE( stack.elements(), vector<double>{1.0} );
+
+    ce.commandEntered("5");
+    ce.commandEntered("prec");
+    ce.commandEntered( string{"load:"} + SnapshotFileName );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+    QCOMPARE( stack.precision(), 0u );
+
+    ce.commandEntered("undo");
+    QCOMPARE( stack.elements(), vector<double>{1.0} );
+    QCOMPARE( stack.precision(), 5u );
+
+    ce.commandEntered("redo");
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+    QCOMPARE( stack.precision(), 0u );
+
+    ce.commandEntered("load:noSuchSnapshot.pss");
+    QCOMPARE( ui.lastMessage, string{"Could not open noSuchSnapshot.pss"} );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+
+    ce.commandEntered("save:noSuchDirectory/snapshot.pss");
+    QCOMPARE( ui.lastMessage, string{"Could not write noSuchDirectory/snapshot.pss"} );
+
+    return;
+}
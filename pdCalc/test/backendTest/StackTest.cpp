@@ -20,7 +20,9 @@
 #include "src/backend/Stack.h"
 #include "src/utilities/Observer.h"
 #include "src/utilities/Exception.h"
+#include "src/utilities/BigNumber.h"
 #include <vector>
+#include <algorithm>
 
 using std::vector;
 using std::vector;
@@ -35,6 +37,8 @@ public:
     unsigned int changeCount() const { return changeCount_; }
     void notifyImpl(std::shared_ptr<pdCalc::EventData>);
 
+    pdCalc::StackChange lastChange;
+
 private:
     unsigned int changeCount_;
 };
@@ -45,9 +49,11 @@ StackChangedObserver::StackChangedObserver(string name)
 {
 }
 
-void StackChangedObserver::notifyImpl(std::shared_ptr<pdCalc::EventData>)
+void StackChangedObserver::notifyImpl(std::shared_ptr<pdCalc::EventData> data)
 {
     ++changeCount_;
+    auto p = std::dynamic_pointer_cast<pdCalc::StackChangedData>(data);
+    if(p) lastChange = p->change();
 }
 
 class StackErrorObserver : public pdCalc::Observer
@@ -184,6 +190,392 @@ void StackTest::testSwapTop()
     return;
 }
 
+void StackTest::testBulkPushPop()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    StackChangedObserver* raw = new StackChangedObserver{"StackChangedObserver"};
+    stack.attach( pdCalc::Stack::StackChanged, unique_ptr<pdCalc::Observer>{raw} );
+    StackErrorObserver* rawError = new StackErrorObserver{"StackErrorObserver"};
+    stack.attach( pdCalc::Stack::StackError, unique_ptr<pdCalc::Observer>{rawError} );
+
+    stack.push(1.0);
+    vector<double> in{2.0, 3.0, 4.0};
+    stack.pushElements(in.data(), in.size());
+
+    QVERIFY( stack.size() == 4 );
+    vector<double> cur{ stack.getElements(4) };
+    QCOMPARE( cur[0], 4.0 );
+    QCOMPARE( cur[1], 3.0 );
+    QCOMPARE( cur[2], 2.0 );
+    QCOMPARE( cur[3], 1.0 );
+
+    vector<double> out(3);
+    stack.peekElements(3, out.data());
+    QVERIFY( stack.size() == 4 );
+    QCOMPARE( out, in );
+
+    std::fill(out.begin(), out.end(), 0.0);
+    stack.popElements(3, out.data());
+    QVERIFY( stack.size() == 1 );
+    QCOMPARE( out, in );
+
+    QCOMPARE(raw->changeCount(), 3u);
+
+    stack.pushElements(in.data(), in.size(), true);
+    stack.popElements(2, out.data(), true);
+    QCOMPARE(raw->changeCount(), 3u);
+
+    try
+    {
+        stack.popElements(3, out.data());
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE(e.what(), string{pdCalc::StackEventData::Message(pdCalc::StackEventData::ErrorConditions::TooFewElements)});
+    }
+
+    QVERIFY( stack.size() == 2 );
+    QVERIFY( rawError->errors().size() == 1 );
+    QVERIFY( rawError->errors()[0] == pdCalc::StackEventData::ErrorConditions::TooFewElements );
+
+    stack.clear();
+    stack.detach(pdCalc::Stack::StackChanged, "StackChangedObserver");
+    stack.detach(pdCalc::Stack::StackError, "StackErrorObserver");
+
+    return;
+}
+
+void StackTest::testExactValues()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+
+    QCOMPARE( stack.precision(), 0u );
+    stack.setPrecision(40);
+    QCOMPARE( stack.precision(), 40u );
+
+    auto third = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.3333333333333333333333", 40) );
+    stack.push(1.0);
+    stack.push(third->toDouble(), third);
+    stack.push(2.0);
+
+    // elements without an exact value report null, before and after the first one
+    auto exact = stack.getExactElements(5);
+    QVERIFY( exact.size() == 3 );
+    QVERIFY( !exact[0] && exact[1] == third && !exact[2] );
+    QCOMPARE( stack.getElements(3)[1], third->toDouble() );
+
+    stack.swapTop();
+    exact = stack.getExactElements(2);
+    QVERIFY( exact[0] == third && !exact[1] );
+
+    // the bulk calls work on the doubles and keep the exact values aligned
+    vector<double> in{4.0, 5.0};
+    stack.pushElements(in.data(), in.size());
+    vector<double> out(3);
+    stack.popElements(3, out.data());
+    QCOMPARE( out[0], third->toDouble() );
+
+    pdCalc::Stack::ExactValue e;
+    QCOMPARE( stack.pop(e), 2.0 );
+    QVERIFY( !e );
+
+    stack.push(third->toDouble(), third);
+    QCOMPARE( stack.pop(e), third->toDouble() );
+    QVERIFY( e == third );
+
+    stack.push(third->toDouble(), third);
+    stack.clear();
+    stack.push(1.0);
+    QVERIFY( !stack.getExactElements(1).front() );
+
+    stack.setPrecision(0);
+    stack.clear();
+
+    return;
+}
+
+void StackTest::testSwapElements()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    StackChangedObserver* raw = new StackChangedObserver{"StackChangedObserver"};
+    stack.attach( pdCalc::Stack::StackChanged, unique_ptr<pdCalc::Observer>{raw} );
+
+    stack.push(1.0);
+    stack.push(2.0, true);
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+    QVERIFY( stack.exactElements().empty() );
+
+    auto third = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.3333333333333333333333", 40) );
+    vector<double> d{5.0, third->toDouble(), 7.0};
+    vector<pdCalc::Stack::ExactValue> exact{nullptr, third, nullptr};
+    stack.swapElements(d, exact);
+    QCOMPARE( raw->changeCount(), 2u );
+
+    QCOMPARE( d, (vector<double>{1.0, 2.0}) );
+    QVERIFY( exact.empty() );
+    QCOMPARE( stack.getElements(3), (vector<double>{7.0, third->toDouble(), 5.0}) );
+    QVERIFY( stack.getExactElements(2)[1] == third );
+    QCOMPARE( stack.exactElements().size(), size_t{3} );
+
+    stack.swapElements(d, exact, true);
+    QCOMPARE( raw->changeCount(), 2u );
+    QCOMPARE( stack.elements(), (vector<double>{1.0, 2.0}) );
+    QVERIFY( !stack.getExactElements(1).front() );
+
+    stack.clear();
+    stack.detach(pdCalc::Stack::StackChanged, "StackChangedObserver");
+
+    return;
+}
+
+namespace {
+
+// the popped, pushed and size of a change, with its generation relative to first
+vector<size_t> describe(const pdCalc::StackChange& c, uint64_t first)
+{
+    return vector<size_t>{c.popped, c.pushed, c.size, static_cast<size_t>(c.generation - first)};
+}
+
+}
+
+void StackTest::testChangeEvents()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    StackChangedObserver* raw = new StackChangedObserver{"StackChangedObserver"};
+    stack.attach( pdCalc::Stack::StackChanged, unique_ptr<pdCalc::Observer>{raw} );
+
+    stack.push(1.0);
+    const uint64_t first{ raw->lastChange.generation };
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{0, 1, 1, 0}) );
+
+    const double d[] = {2.0, 3.0, 4.0};
+    stack.pushElements(d, 3);
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{0, 3, 4, 1}) );
+
+    stack.swapTop();
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{2, 2, 4, 2}) );
+
+    // suppressed changes fold into the next event: a binary operation pops two and
+    // pushes one, while pushing back what was popped leaves nothing popped
+    stack.pop(true);
+    stack.pop(true);
+    stack.push(7.0);
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{2, 1, 3, 3}) );
+
+    stack.push(8.0, true);
+    stack.pop();
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{0, 0, 3, 4}) );
+
+    double out[2];
+    stack.popElements(2, out);
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{2, 0, 1, 5}) );
+
+    vector<double> replacement{5.0, 6.0};
+    vector<pdCalc::Stack::ExactValue> noExact;
+    stack.swapElements(replacement, noExact);
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{1, 2, 2, 6}) );
+
+    stack.clear();
+    QCOMPARE( describe(raw->lastChange, first), (vector<size_t>{2, 0, 0, 7}) );
+    QCOMPARE( raw->changeCount(), 8u );
+
+    stack.detach(pdCalc::Stack::StackChanged, "StackChangedObserver");
+
+    return;
+}
+
+void StackTest::testVersions()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.setPersistent(true);
+    StackChangedObserver* raw = new StackChangedObserver{"StackChangedObserver"};
+    stack.attach( pdCalc::Stack::StackChanged, unique_ptr<pdCalc::Observer>{raw} );
+
+    vector<double> d(300);
+    for(size_t i = 0; i < d.size(); ++i) d[i] = i;
+
+    stack.pushElements(d.data(), 100);
+    const pdCalc::StackVersion first{ stack.version() };
+    QCOMPARE( first.size(), size_t{100} );
+    QCOMPARE( first.getElements(3), (vector<double>{99.0, 98.0, 97.0}) );
+    QCOMPARE( stack.published().getElements(100), stack.getElements(100) );
+
+    // the bottom two chunks, 64 elements, are shared with the first version, while
+    // the third changed when the stack was popped below its top
+    double out[10];
+    stack.popElements(10, out);
+    stack.pushElements(d.data() + 100, 200);
+    const pdCalc::StackVersion second{ stack.version() };
+    const vector<double> secondElements{ stack.elements() };
+    QCOMPARE( second.size(), size_t{290} );
+
+    stack.checkout(first);
+    QCOMPARE( stack.getElements(100), first.getElements(100) );
+    QCOMPARE( stack.size(), size_t{100} );
+    QCOMPARE( raw->lastChange.popped, size_t{226} );
+    QCOMPARE( raw->lastChange.pushed, size_t{36} );
+    QCOMPARE( stack.published().size(), size_t{100} );
+
+    stack.checkout(second);
+    QCOMPARE( stack.elements(), secondElements );
+
+    vector<double> copy;
+    vector<pdCalc::Stack::ExactValue> exactCopy;
+    second.copyElements(copy, exactCopy);
+    QCOMPARE( copy, secondElements );
+    QVERIFY( exactCopy.empty() );
+
+    // exact values and the precision are part of the version
+    stack.setPrecision(20);
+    auto exact = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.1", 20) );
+    stack.push(0.1, exact);
+    const pdCalc::StackVersion third{ stack.version() };
+    stack.setPrecision(0);
+    stack.clear();
+    stack.checkout(third);
+    QCOMPARE( stack.size(), size_t{291} );
+    QCOMPARE( stack.precision(), 20u );
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.1"} );
+    QVERIFY( !stack.getExactElements(2).back() );
+
+    // without persistence, versions are whole copies that still check out
+    stack.setPersistent(false);
+    QCOMPARE( stack.published().size(), size_t{0} );
+    const pdCalc::StackVersion fourth{ stack.version() };
+    stack.checkout(first);
+    QCOMPARE( stack.size(), size_t{100} );
+    QVERIFY( !stack.getExactElements(1).front() );
+    stack.checkout(fourth);
+    QCOMPARE( stack.size(), size_t{291} );
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.1"} );
+
+    stack.checkout( pdCalc::StackVersion{} );
+    QCOMPARE( stack.size(), size_t{0} );
+    QCOMPARE( stack.precision(), 0u );
+
+    stack.detach(pdCalc::Stack::StackChanged, "StackChangedObserver");
+
+    return;
+}
+
+void StackTest::testDeltas()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    const double d[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    stack.pushElements(d, 5);
+    const vector<double> before{ stack.elements() };
+
+    // only the elements below which the stack went are recorded
+    stack.beginDelta();
+    stack.pop();
+    stack.push(6.0);
+    stack.swapTop();
+    double out[3];
+    stack.popElements(3, out);
+    stack.push(7.0);
+    pdCalc::StackDelta delta{ stack.endDelta() };
+    const vector<double> after{ stack.elements() };
+
+    QCOMPARE( delta.base, size_t{2} );
+    QCOMPARE( delta.removed, (vector<double>{3.0, 4.0, 5.0}) );
+    QCOMPARE( delta.added, vector<double>{7.0} );
+    QVERIFY( delta.removedExact.empty() && delta.addedExact.empty() );
+
+    stack.applyDelta(delta, false);
+    QCOMPARE( stack.elements(), before );
+    stack.applyDelta(delta, true);
+    QCOMPARE( stack.elements(), after );
+
+    // a delta that only pushes removes nothing
+    stack.beginDelta();
+    stack.push(8.0);
+    delta = stack.endDelta();
+    QCOMPARE( delta.base, size_t{3} );
+    QVERIFY( delta.removed.empty() );
+    QCOMPARE( delta.added, vector<double>{8.0} );
+
+    // exact values and the precision
+    stack.beginDelta();
+    stack.setPrecision(20);
+    auto exact = std::make_shared<const pdCalc::BigFloat>( pdCalc::BigFloat::FromString("0.1", 20) );
+    stack.pop();
+    stack.pop();
+    stack.push(0.1, exact);
+    delta = stack.endDelta();
+    QCOMPARE( delta.base, size_t{2} );
+    QCOMPARE( delta.precisionBefore, 0u );
+    QCOMPARE( delta.precisionAfter, 20u );
+    QVERIFY( delta.removedExact.empty() );
+    QCOMPARE( delta.addedExact.size(), size_t{1} );
+
+    stack.applyDelta(delta, false);
+    QCOMPARE( stack.precision(), 0u );
+    QCOMPARE( stack.getElements(2), (vector<double>{8.0, 7.0}) );
+    QVERIFY( !stack.getExactElements(1).front() );
+    stack.applyDelta(delta, true);
+    QCOMPARE( stack.precision(), 20u );
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.1"} );
+
+    // clearing records the whole stack, exact values included
+    stack.beginDelta();
+    stack.clear();
+    delta = stack.endDelta();
+    QCOMPARE( delta.base, size_t{0} );
+    QCOMPARE( delta.removed, (vector<double>{1.0, 2.0, 0.1}) );
+    QCOMPARE( delta.removedExact.size(), size_t{3} );
+    stack.applyDelta(delta, false);
+    QCOMPARE( stack.getExactElements(1).front()->toString(), string{"0.1"} );
+
+    stack.setPrecision(0);
+    stack.clear();
+
+    return;
+}
+
+void StackTest::testMarks()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    for(double d : {1.0, 2.0, 3.0, 4.0}) stack.push(d);
+
+    auto m = stack.mark();
+    QCOMPARE( stack.unchangedSince(m), size_t{4} );
+
+    // what is pushed above the mark does not count against it
+    stack.push(5.0);
+    QCOMPARE( stack.unchangedSince(m), size_t{4} );
+
+    stack.pop();
+    stack.pop();
+    QCOMPARE( stack.unchangedSince(m), size_t{3} );
+
+    stack.swapTop();
+    QCOMPARE( stack.unchangedSince(m), size_t{1} );
+
+    // only the last mark is followed
+    m = stack.mark();
+    QCOMPARE( stack.unchangedSince(m), size_t{3} );
+    const auto last = stack.mark();
+    QCOMPARE( stack.unchangedSince(m), size_t{0} );
+    QCOMPARE( stack.unchangedSince(last), size_t{3} );
+
+    vector<double> d{1.0, 2.0, 3.0};
+    vector<pdCalc::Stack::ExactValue> exact;
+    stack.swapElements(d, exact);
+    QCOMPARE( stack.unchangedSince(last), size_t{0} );
+
+    stack.clear();
+
+    return;
+}
+
 void StackTest::testErrors()
 {
     pdCalc::Stack& stack = pdCalc::Stack::Instance();
@@ -27,6 +27,13 @@ class StackTest : public QObject
 private slots:
     void testPushPop();
     void testSwapTop();
+    void testBulkPushPop();
+    void testExactValues();
+    void testSwapElements();
+    void testChangeEvents();
+    void testVersions();
+    void testDeltas();
+    void testMarks();
     void testErrors();
 };
 
@@ -0,0 +1,186 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StaticPluginRegistryTest.h"
+#include "backend/StaticPluginRegistry.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "backend/CommandRepository.h"
+#include "utilities/UserInterface.h"
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using pdCalc::StaticPluginRegistry;
+
+namespace {
+
+class RegistryInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { messages.push_back(m); }
+    void stackChanged() override { }
+
+    vector<string> messages;
+};
+
+class StaticTestCommand : public pdCalc::Command
+{
+private:
+    void executeImpl() noexcept override { }
+    void undoImpl() noexcept override { }
+    Command* cloneImpl() const noexcept override { return new StaticTestCommand; }
+    const char* helpMessageImpl() const noexcept override { return ""; }
+};
+
+int allocated = 0;
+
+class StaticTestPlugin : public pdCalc::Plugin
+{
+public:
+    StaticTestPlugin();
+    ~StaticTestPlugin() { --allocated; }
+
+    const PluginDescriptor& getPluginDescriptor() const override { return descriptor_; }
+    const PluginButtonDescriptor* getPluginButtonDescriptor() const override { return nullptr; }
+    ApiVersion apiVersion() const override { return {1, 0}; }
+
+private:
+    StaticTestCommand command_;
+    char name_[11];
+    char* names_[1];
+    pdCalc::Command* commands_[1];
+    PluginDescriptor descriptor_;
+};
+
+StaticTestPlugin::StaticTestPlugin()
+: name_{"staticTest"}
+, names_{name_}
+, commands_{&command_}
+, descriptor_{1, names_, commands_}
+{
+    ++allocated;
+}
+
+// the plugin file names the plugin's library, which does not exist
+#ifdef WIN32
+const char* TestLibrary = "staticTestPlugin1.dll";
+#else
+const char* TestLibrary = "../lib/libstaticTestPlugin.so";
+#endif
+
+const char* TestPluginFile = "staticTestPlugin.pdp";
+
+void writePluginFile()
+{
+    std::ofstream ofs{TestPluginFile};
+    ofs << TestLibrary << std::endl;
+
+    return;
+}
+
+void registerTestPlugin()
+{
+    StaticPluginRegistry::Instance().registerPlugin( "staticTestPlugin",
+        []() -> void* { return new StaticTestPlugin; },
+        [](void* p){ delete static_cast<pdCalc::Plugin*>(p); } );
+
+    return;
+}
+
+}
+
+void StaticPluginRegistryTest::testPluginName()
+{
+#ifdef WIN32
+    QCOMPARE( StaticPluginRegistry::PluginName("hyperbolicLnPlugin1.dll"), string{"hyperbolicLnPlugin"} );
+    QCOMPARE( StaticPluginRegistry::PluginName("..\\bin\\fftPlugin1.dll"), string{"fftPlugin"} );
+#else
+    QCOMPARE( StaticPluginRegistry::PluginName("../lib/libhyperbolicLnPlugin.so"), string{"hyperbolicLnPlugin"} );
+    QCOMPARE( StaticPluginRegistry::PluginName("/usr/lib/libfftPlugin.so.1"), string{"fftPlugin"} );
+    QCOMPARE( StaticPluginRegistry::PluginName("libmatrixPlugin.dylib"), string{"matrixPlugin"} );
+#endif
+    QCOMPARE( StaticPluginRegistry::PluginName("randomPlugin"), string{"randomPlugin"} );
+
+    return;
+}
+
+void StaticPluginRegistryTest::testLoading()
+{
+    auto& registry = StaticPluginRegistry::Instance();
+    QVERIFY( !registry.hasPlugin(TestLibrary) );
+
+    registerTestPlugin();
+    QVERIFY( registry.hasPlugin(TestLibrary) );
+
+    writePluginFile();
+    {
+        RegistryInterface ui;
+        pdCalc::PluginLoader loader;
+        loader.loadPlugins(ui, TestPluginFile);
+        QVERIFY( ui.messages.empty() );
+        QCOMPARE( loader.getPlugins().size(), size_t{1} );
+        QCOMPARE( allocated, 1 );
+
+        auto names = loader.registerCommands(ui);
+        QCOMPARE( names, std::set<string>{"staticTest"} );
+        auto c = pdCalc::CommandRepository::Instance().allocateCommand("staticTest");
+        QVERIFY( c != nullptr );
+        c->execute();
+
+        // the plugin has no file of its own to watch
+        loader.watchPlugins(ui);
+        QCOMPARE( loader.openLibraries(), size_t{1} );
+
+        loader.deregisterCommands();
+        QVERIFY( !pdCalc::CommandRepository::Instance().hasKey("staticTest") );
+    }
+    QCOMPARE( allocated, 0 );
+
+    std::remove(TestPluginFile);
+    registry.deregisterPlugin("staticTestPlugin");
+
+    return;
+}
+
+void StaticPluginRegistryTest::testDeregister()
+{
+    auto& registry = StaticPluginRegistry::Instance();
+    registerTestPlugin();
+    registry.deregisterPlugin("staticTestPlugin");
+    QVERIFY( !registry.hasPlugin(TestLibrary) );
+
+    auto loader = registry.createDynamicLoader();
+    QVERIFY( loader->allocatePlugin(TestLibrary) == nullptr );
+
+    // without the plugin registered, the loader looks for its library
+    writePluginFile();
+    RegistryInterface ui;
+    pdCalc::PluginLoader pluginLoader;
+    pluginLoader.loadPlugins(ui, TestPluginFile);
+    QVERIFY( pluginLoader.getPlugins().empty() );
+    QCOMPARE( ui.messages, vector<string>{"Error opening plugin"} );
+
+    std::remove(TestPluginFile);
+
+    return;
+}
@@ -25,6 +25,9 @@
 #include "backend/CoreCommands.h"
 #include "backend/CommandRepository.h"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
 
 using std::vector;
 using std::string;
@@ -39,6 +42,70 @@ public:
     void stackChanged() override { }
 };
 
+class RecordingInterface : public pdCalc::UserInterface
+{
+public:
+    void postMessage(const string& m) override { messages.push_back(m); }
+    void stackChanged() override { }
+
+    vector<string> messages;
+};
+
+// writes a procedure to a file that lives as long as the object
+class ProcedureFile
+{
+public:
+    ProcedureFile(const string& name, const string& text)
+    : name_{name}
+    {
+        std::ofstream ofs{ name_.c_str() };
+        ofs << text;
+    }
+
+    ~ProcedureFile() { std::remove( name_.c_str() ); }
+
+    const string& name() const { return name_; }
+
+private:
+    string name_;
+};
+
+// runs a procedure on the given stack, bottom first, and checks the stack after
+// execute, undo, and redo
+void testProcedure(pdCalc::UserInterface& ui, const string& text, const vector<double>& start, const vector<double>& expected)
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::RegisterCoreCommands(ui);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    for(auto d : start)
+        stack.push(d);
+
+    ProcedureFile file{"controlFlowTestProcedure.psp", text};
+    pdCalc::StoredProcedure sp{ui, file.name()};
+    sp.execute();
+
+    vector<double> result = stack.getElements( stack.size() );
+    std::reverse( result.begin(), result.end() );
+    QCOMPARE(result, expected);
+
+    // undo restores the starting stack and redo the result
+    sp.undo();
+    vector<double> undone = stack.getElements( stack.size() );
+    std::reverse( undone.begin(), undone.end() );
+    QCOMPARE(undone, start);
+
+    sp.execute();
+    vector<double> redone = stack.getElements( stack.size() );
+    std::reverse( redone.begin(), redone.end() );
+    QCOMPARE(redone, result);
+
+    stack.clear();
+
+    return;
+}
+
 }
 
 void StoredProcedureTest::testMissingProcedure()
@@ -103,3 +170,135 @@ void StoredProcedureTest::testStoredProcedure()
 
     return;
 }
+
+void StoredProcedureTest::testOptimizedProcedure()
+{
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    TestInterface ui;
+    pdCalc::RegisterCoreCommands(ui);
+    std::ostringstream oss;
+    oss << BACKEND_TEST_DIR << "/sumOfSquares";
+    pdCalc::StoredProcedure sp(ui, oss.str());
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.push(3.0);
+    stack.push(4.0);
+
+    sp.execute();
+
+    QCOMPARE( stack.size(), size_t{1} );
+    QCOMPARE( stack.getElements(1)[0], 25.0 / 8.0 );
+
+    string report = sp.optimizationReport();
+    QCOMPARE( report.substr(0, report.find('\n')), string{"Optimized 14 tokens to 6 with 5 rewrites"} );
+
+    sp.undo();
+
+    vector<double> vals = stack.getElements(2);
+    QCOMPARE( stack.size(), size_t{2} );
+    QCOMPARE(vals[0], 4.0);
+    QCOMPARE(vals[1], 3.0);
+
+    sp.execute();
+
+    QCOMPARE( stack.size(), size_t{1} );
+    QCOMPARE( stack.getElements(1)[0], 25.0 / 8.0 );
+
+    stack.clear();
+
+    return;
+}
+
+void StoredProcedureTest::testLoops()
+{
+    TestInterface ui;
+
+    testProcedure(ui, "10 times 2 * end", {1.0}, {1024.0});
+    testProcedure(ui, "3 times\n 2 times 1 + end\nend", {0.0}, {6.0});
+    testProcedure(ui, "0 times 1 + end", {7.0}, {7.0});
+
+    // the count comes from the stack
+    testProcedure(ui, "times dup end", {4.0, 3.0}, {4.0, 4.0, 4.0, 4.0});
+
+    // a loop costs its body, not its iterations
+    testProcedure(ui, "100000 times 1 + end", {0.0}, {100000.0});
+
+    return;
+}
+
+void StoredProcedureTest::testConditionals()
+{
+    TestInterface ui;
+
+    testProcedure(ui, "if 10 + else 20 + end", {5.0, 1.0}, {15.0});
+    testProcedure(ui, "if 10 + else 20 + end", {5.0, 0.0}, {25.0});
+    testProcedure(ui, "if 10 + end", {5.0, 0.0}, {5.0});
+    testProcedure(ui, "if 10 + end", {5.0, -2.0}, {15.0});
+
+    // counts up, except that 3 jumps to 30
+    testProcedure(ui, "5 times dup 3 - if 1 + else 10 * end end", {0.0}, {31.0});
+
+    return;
+}
+
+void StoredProcedureTest::testControlFlowErrors()
+{
+    RecordingInterface ui;
+    pdCalc::CommandRepository::Instance().clearAllCommands();
+    pdCalc::RegisterCoreCommands(ui);
+
+    vector<std::pair<string, string>> malformed = {
+        {"1 + end", "Procedure has end without times or if"},
+        {"times if 1 else 2 else 3 end end", "Procedure has else without if"},
+        {"3 times else end", "Procedure has else without if"},
+        {"3 times 1 +", "Procedure has times or if without end"}
+    };
+
+    for(const auto& m : malformed)
+    {
+        ProcedureFile file{"controlFlowTestProcedure.psp", m.first};
+        pdCalc::StoredProcedure sp{ui, file.name()};
+        try
+        {
+            sp.execute();
+            QVERIFY(false);
+        }
+        catch(pdCalc::Exception& e)
+        {
+            QCOMPARE(e.what(), m.second);
+        }
+    }
+
+    // a control flow error stops the procedure, and undo still removes what ran
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+
+    vector<std::pair<string, string>> failing = {
+        {"5 -1 times 1 + end 6", "times: count must be a nonnegative integer"},
+        {"5 2.5 times 1 + end 6", "times: count must be a nonnegative integer"},
+        {"drop times 1 + end 6", "times: Stack must have one element"},
+        {"drop if 1 end 6", "if: Stack must have one element"}
+    };
+
+    for(const auto& f : failing)
+    {
+        ui.messages.clear();
+        stack.push(1.0);
+
+        ProcedureFile file{"controlFlowTestProcedure.psp", f.first};
+        pdCalc::StoredProcedure sp{ui, file.name()};
+        sp.execute();
+
+        QCOMPARE( ui.messages.size(), size_t{1} );
+        QCOMPARE( ui.messages[0], f.second );
+        QVERIFY( stack.size() == 0 || stack.getElements(1)[0] != 6.0 );
+
+        sp.undo();
+        QCOMPARE( stack.size(), size_t{1} );
+        QCOMPARE( stack.getElements(1)[0], 1.0 );
+        stack.clear();
+    }
+
+    return;
+}
@@ -28,6 +28,10 @@ class StoredProcedureTest : public QObject
 private slots:
     void testMissingProcedure();
     void testStoredProcedure();
+    void testOptimizedProcedure();
+    void testLoops();
+    void testConditionals();
+    void testControlFlowErrors();
 };
 
 #endif
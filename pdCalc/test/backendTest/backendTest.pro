@@ -9,6 +9,8 @@ win32:DESTDIR = $$HOME/bin
 DEFINES += BACKEND_TEST_DIR=\\\"$$PWD\\\"
 unix:DEFINES += PLUGIN_TEST_FILE=\\\"plugins.unix.pdp\\\"
 win32:DEFINES += PLUGIN_TEST_FILE=\\\"plugins.win.pdp\\\"
+unix:DEFINES += PLUGIN_HOST_TEST_FILE=\\\"./pdCalcPluginHost\\\"
+win32:DEFINES += PLUGIN_HOST_TEST_FILE=\\\"pdCalcPluginHost.exe\\\"
 
 
 # Input
@@ -18,14 +20,36 @@ HEADERS += StackTest.h \
     CoreCommandsTest.h \
     CommandDispatcherTest.h \
     StoredProcedureTest.h \
-    PluginLoaderTest.h
+    MapProcedureTest.h \
+    ProcedureOptimizerTest.h \
+    StackSnapshotTest.h \
+    JournalTest.h \
+    SpilledHistoryTest.h \
+    ImportNumbersTest.h \
+    CommandWorkerTest.h \
+    PluginLoaderTest.h \
+    PluginHostTest.h \
+    StaticPluginRegistryTest.h \
+    AllocationCounter.h \
+    AllocationTest.h
 SOURCES += StackTest.cpp \
     CommandManagerTest.cpp \
     CommandRepositoryTest.cpp \
     CoreCommandsTest.cpp \
     CommandDispatcherTest.cpp \
     StoredProcedureTest.cpp \
-    PluginLoaderTest.cpp
+    MapProcedureTest.cpp \
+    ProcedureOptimizerTest.cpp \
+    StackSnapshotTest.cpp \
+    JournalTest.cpp \
+    SpilledHistoryTest.cpp \
+    ImportNumbersTest.cpp \
+    CommandWorkerTest.cpp \
+    PluginLoaderTest.cpp \
+    PluginHostTest.cpp \
+    StaticPluginRegistryTest.cpp \
+    AllocationCounter.cpp \
+    AllocationTest.cpp
 
 unix:LIBS += -L$$HOME/lib -lpdCalcUtilities -lpdCalcBackend
 win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1 -lpdCalcBackend1
@@ -0,0 +1,535 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "backend/Stack.h"
+#include "backend/CommandManager.h"
+#include "backend/CommandDispatcher.h"
+#include "backend/Journal.h"
+#include "backend/CoreCommands.h"
+#include "backend/CommandRepository.h"
+#include "backend/StoredProcedure.h"
+#include "backend/MapProcedure.h"
+#include "backend/StackSnapshot.h"
+#include "backend/ImportNumbers.h"
+#include "utilities/UserInterface.h"
+#include "utilities/Tokenizer.h"
+#include <fstream>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace pdCalc {
+
+namespace {
+
+class BenchmarkInterface : public UserInterface
+{
+public:
+    void postMessage(const string&) override { }
+    void stackChanged() override { }
+};
+
+BenchmarkInterface& ui()
+{
+    static BenchmarkInterface instance;
+    return instance;
+}
+
+void resetStack(size_t n)
+{
+    Stack::Instance().clear();
+    for(size_t i = 0; i < n; ++i)
+        Stack::Instance().push(1.0 + i, true);
+
+    return;
+}
+
+void stackPushPop(size_t iterations)
+{
+    resetStack(0);
+    auto& stack = Stack::Instance();
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        stack.push(2.5);
+        DoNotOptimize( stack.pop() );
+    }
+
+    return;
+}
+
+// a version of a persistent stack of 100000 elements, each after a push
+void stackPushVersion(size_t iterations)
+{
+    resetStack(100000);
+    auto& stack = Stack::Instance();
+    stack.setPersistent(true);
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        stack.push(2.5);
+        DoNotOptimize( stack.version().size() );
+        stack.pop();
+    }
+    stack.setPersistent(false);
+
+    return;
+}
+
+void managerExecuteUndoAdd(size_t iterations)
+{
+    resetStack(2);
+    CommandManager manager;
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        manager.executeCommand( MakeCommandPtr<Add>() );
+        manager.undo();
+    }
+
+    return;
+}
+
+// the cost of one operation as the dispatcher pays it: a clone from the repository,
+// then execute and undo
+BenchmarkRunner::Benchmark cloneExecuteUndo(const string& name, size_t nOperands)
+{
+    return [name, nOperands](size_t iterations)
+    {
+        resetStack(nOperands);
+        const CommandRepository& repository = CommandRepository::Instance();
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            CommandPtr c{ repository.allocateCommand(name) };
+            c->execute();
+            c->undo();
+        }
+
+        return;
+    };
+}
+
+void dispatcherEnterNumber(size_t iterations)
+{
+    resetStack(0);
+    CommandDispatcher dispatcher{ui()};
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        dispatcher.commandEntered("3.14159");
+        dispatcher.commandEntered("undo");
+    }
+
+    return;
+}
+
+void dispatcherAdd(size_t iterations)
+{
+    resetStack(2);
+    CommandDispatcher dispatcher{ui()};
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        dispatcher.commandEntered("+");
+        dispatcher.commandEntered("undo");
+    }
+
+    return;
+}
+
+// dispatcherAdd with versioned history, to measure the cost of keeping versions
+void dispatcherAddVersioned(size_t iterations)
+{
+    resetStack(2);
+    CommandDispatcher dispatcher{ui()};
+    dispatcher.setVersionedHistory(true);
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        dispatcher.commandEntered("+");
+        dispatcher.commandEntered("undo");
+    }
+    dispatcher.setVersionedHistory(false);
+
+    return;
+}
+
+// entering numbers with all but the last 100 entries of the history spilled to disk
+void dispatcherEnterNumberSpilled(size_t iterations)
+{
+    const string file{"benchmarkHistory.psh"};
+    resetStack(0);
+    {
+        CommandDispatcher dispatcher{ui()};
+        dispatcher.spillHistory(file, 100);
+        for(size_t i = 0; i < iterations; ++i)
+            dispatcher.commandEntered("2.5");
+    }
+    Stack::Instance().clear();
+
+    return;
+}
+
+// undoes and redoes 10000 entries, all but 100 of them read back from disk
+void dispatcherUndoRedoSpilled(size_t iterations)
+{
+    const string file{"benchmarkHistory.psh"};
+    resetStack(2);
+    {
+        CommandDispatcher dispatcher{ui()};
+        dispatcher.spillHistory(file, 100);
+        for(size_t i = 0; i < 10000; ++i)
+            dispatcher.commandEntered(i % 2 ? "+" : "1");
+
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            dispatcher.commandEntered("undo:10000");
+            dispatcher.commandEntered("redo:10000");
+        }
+    }
+    Stack::Instance().clear();
+
+    return;
+}
+
+// jumps back and forth across 1000 entries on a stack of 100000 elements
+BenchmarkRunner::Benchmark dispatcherJump1000(bool versioned)
+{
+    return [versioned](size_t iterations)
+    {
+        resetStack(100000);
+        CommandDispatcher dispatcher{ui()};
+        dispatcher.setVersionedHistory(versioned);
+        for(size_t i = 0; i < 1000; ++i)
+            dispatcher.commandEntered(i % 2 ? "+" : "1");
+
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            dispatcher.commandEntered("undo:1000");
+            dispatcher.commandEntered("redo:1000");
+        }
+        dispatcher.setVersionedHistory(false);
+    };
+}
+
+// switches between two branches that fork 10 entries before the end of a history
+// of 1000, which costs the 20 entries between them, not the length of the history
+void dispatcherSwitchBranch(size_t iterations)
+{
+    resetStack(2);
+    CommandDispatcher dispatcher{ui()};
+    dispatcher.keepBranches();
+    for(size_t i = 0; i < 1000; ++i)
+        dispatcher.commandEntered(i % 2 ? "+" : "1");
+
+    dispatcher.commandEntered("undo:10");
+    for(size_t i = 0; i < 10; ++i)
+        dispatcher.commandEntered(i % 2 ? "*" : "2");
+
+    for(size_t i = 0; i < iterations; ++i)
+        dispatcher.commandEntered(i % 2 ? "branch:2" : "branch:1");
+
+    return;
+}
+
+// A journal, or a dispatcher journaling, opened by the first, untimed, run of a
+// benchmark and kept to the end, so that the benchmark times the entries rather
+// than opening and closing the journal, which a session does once. The file goes
+// when the journal does.
+class KeptJournal
+{
+public:
+    explicit KeptJournal(const char* file) : file_{file}, journal_{ std::make_unique<Journal>(file, 0, 50) } { }
+    ~KeptJournal() { journal_.reset(); std::remove(file_); }
+
+    Journal& journal() { return *journal_; }
+
+private:
+    const char* file_;
+    std::unique_ptr<Journal> journal_;
+};
+
+class KeptJournaledDispatcher
+{
+public:
+    explicit KeptJournaledDispatcher(const char* file)
+    : file_{file}
+    , dispatcher_{ std::make_unique<CommandDispatcher>( ui() ) }
+    { dispatcher_->startJournal(file, 50, 0); }
+
+    ~KeptJournaledDispatcher() { dispatcher_.reset(); std::remove(file_); }
+
+    CommandDispatcher& dispatcher() { return *dispatcher_; }
+
+private:
+    const char* file_;
+    std::unique_ptr<CommandDispatcher> dispatcher_;
+};
+
+// dispatcherAdd with every entry journaled, to measure the journal's overhead
+void dispatcherAddJournaled(size_t iterations)
+{
+    resetStack(2);
+    static KeptJournaledDispatcher kept{"benchmarkJournal.pjl"};
+    CommandDispatcher& dispatcher = kept.dispatcher();
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        dispatcher.commandEntered("+");
+        dispatcher.commandEntered("undo");
+    }
+
+    return;
+}
+
+// the journal's own part of CommandDispatcher/AddUndo/Journaled, which the
+// dispatcher alone does not show
+void journalRecordAddUndo(size_t iterations)
+{
+    const string plus{"+"};
+    const string undo{"undo"};
+    static KeptJournal kept{"benchmarkRecord.pjl"};
+    Journal& journal = kept.journal();
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        journal.recordToken(plus);
+        journal.recordToken(undo);
+    }
+
+    return;
+}
+
+// recovery of a session of 100000 journaled entries
+void journalRecover(size_t iterations)
+{
+    const string file{"benchmarkRecover.pjl"};
+    resetStack(1);
+    {
+        CommandDispatcher dispatcher{ui()};
+        dispatcher.startJournal(file, 50, 0);
+        for(size_t i = 0; i < 50000; ++i)
+        {
+            dispatcher.commandEntered("1");
+            dispatcher.commandEntered("+");
+        }
+    }
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        resetStack(1);
+        CommandDispatcher dispatcher{ui()};
+        dispatcher.startJournal(file, 50, 0);
+    }
+
+    std::remove( file.c_str() );
+    Stack::Instance().clear();
+
+    return;
+}
+
+void storedProcedure1000Tokens(size_t iterations)
+{
+    const string file{"benchmarkProcedure.psp"};
+    {
+        std::ofstream ofs{file.c_str()};
+        for(int i = 0; i < 500; ++i)
+            ofs << "1 +\n";
+    }
+
+    resetStack(1);
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        StoredProcedure sp{ui(), file};
+        sp.execute();
+        sp.undo();
+    }
+
+    std::remove( file.c_str() );
+
+    return;
+}
+
+// the same work as storedProcedure1000Tokens, written as a loop
+void storedProcedureLoop(size_t iterations)
+{
+    const string file{"benchmarkLoopProcedure.psp"};
+    {
+        std::ofstream ofs{file.c_str()};
+        ofs << "500 times\n1 +\nend\n";
+    }
+
+    resetStack(1);
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        StoredProcedure sp{ui(), file};
+        sp.execute();
+        sp.undo();
+    }
+
+    std::remove( file.c_str() );
+
+    return;
+}
+
+// one procedure over 10000 elements, executed and undone
+void mapProcedure10000(size_t iterations)
+{
+    const string file{"benchmarkMapProcedure.psp"};
+    {
+        std::ofstream ofs{file.c_str()};
+        ofs << "dup sin swap cos * 3 +\n";
+    }
+
+    const size_t n{10000};
+    resetStack(n);
+    Stack::Instance().push( static_cast<double>(n) );
+
+    MapProcedure map{file};
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        map.execute();
+        map.undo();
+    }
+
+    std::remove( file.c_str() );
+
+    return;
+}
+
+// a snapshot of 10 million elements, saved, and restored
+void snapshotSave(size_t iterations)
+{
+    const string file{"benchmarkSnapshot.pss"};
+    resetStack(10000000);
+
+    for(size_t i = 0; i < iterations; ++i)
+        SaveStackSnapshot(file);
+
+    std::remove( file.c_str() );
+    Stack::Instance().clear();
+
+    return;
+}
+
+void snapshotRestore(size_t iterations)
+{
+    const string file{"benchmarkSnapshot.pss"};
+    resetStack(10000000);
+    SaveStackSnapshot(file);
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        Stack::Instance().clear();
+        RestoreStackSnapshot(file);
+    }
+
+    std::remove( file.c_str() );
+    Stack::Instance().clear();
+
+    return;
+}
+
+// bulk import of a million numbers written as text and ten million as binary
+void importText(size_t iterations)
+{
+    const string file{"benchmarkImport.csv"};
+    {
+        // rows of ten, repeated, so that writing the file costs little next to reading it
+        const string row{"0.5,-12.25,3e8,1024,0.001,-7,299792458,6.02214076e23,1.5,-0.0625\n"};
+        std::ofstream ofs{file.c_str()};
+        for(int i = 0; i < 100000; ++i)
+            ofs << row;
+    }
+
+    for(size_t i = 0; i < iterations; ++i)
+        DoNotOptimize( ReadTextNumbers(file).back() );
+
+    std::remove( file.c_str() );
+
+    return;
+}
+
+void importBinary(size_t iterations)
+{
+    const string file{"benchmarkImport.f64"};
+    {
+        // the file is little endian, as is every host the benchmarks run on
+        std::vector<double> x(10000000);
+        for(size_t i = 0; i < x.size(); ++i)
+            x[i] = 1.0 + i;
+        std::ofstream ofs{file.c_str(), std::ios::binary};
+        ofs.write( reinterpret_cast<const char*>( x.data() ), x.size() * sizeof(double) );
+    }
+
+    for(size_t i = 0; i < iterations; ++i)
+        DoNotOptimize( ReadBinaryNumbers(file).back() );
+
+    std::remove( file.c_str() );
+
+    return;
+}
+
+void tokenizeLine(size_t iterations)
+{
+    string line;
+    for(int i = 0; i < 50; ++i)
+        line += "1.5e3 SWAP ";
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+        Tokenizer t{line};
+        DoNotOptimize( t.nTokens() );
+    }
+
+    return;
+}
+
+}
+
+void RegisterBackendBenchmarks(BenchmarkRunner& runner)
+{
+    RegisterCoreCommands( ui() );
+
+    runner.add("Stack/PushPop", stackPushPop);
+    runner.add("Stack/PushVersion/100000", stackPushVersion);
+    runner.add("CommandManager/ExecuteUndoAdd", managerExecuteUndoAdd);
+    runner.add("Command/CloneExecuteUndo/Add", cloneExecuteUndo("+", 2));
+    runner.add("Command/CloneExecuteUndo/Multiply", cloneExecuteUndo("*", 2));
+    runner.add("Command/CloneExecuteUndo/Power", cloneExecuteUndo("pow", 2));
+    runner.add("Command/CloneExecuteUndo/Sine", cloneExecuteUndo("sin", 1));
+    runner.add("CommandDispatcher/EnterNumberUndo", dispatcherEnterNumber);
+    runner.add("CommandDispatcher/AddUndo", dispatcherAdd);
+    runner.add("CommandDispatcher/AddUndo/Journaled", dispatcherAddJournaled);
+    runner.add("CommandDispatcher/AddUndo/Versioned", dispatcherAddVersioned);
+    runner.add("CommandDispatcher/EnterNumber/Spilled", dispatcherEnterNumberSpilled);
+    runner.add("CommandDispatcher/UndoRedo10000/Spilled", dispatcherUndoRedoSpilled);
+    runner.add("CommandDispatcher/Jump1000", dispatcherJump1000(false));
+    runner.add("CommandDispatcher/Jump1000/Versioned", dispatcherJump1000(true));
+    runner.add("CommandDispatcher/SwitchBranch/1000", dispatcherSwitchBranch);
+    runner.add("Journal/Record/AddUndo", journalRecordAddUndo);
+    runner.add("Journal/Recover/100000", journalRecover);
+    runner.add("StoredProcedure/1000Tokens", storedProcedure1000Tokens);
+    runner.add("StoredProcedure/Loop500", storedProcedureLoop);
+    runner.add("MapProcedure/10000Elements", mapProcedure10000);
+    runner.add("Tokenizer/100Tokens", tokenizeLine);
+    runner.add("StackSnapshot/Save/10000000", snapshotSave);
+    runner.add("StackSnapshot/Restore/10000000", snapshotRestore);
+    runner.add("Import/Text/1000000", importText);
+    runner.add("Import/Binary/10000000", importBinary);
+
+    return;
+}
+
+}
@@ -0,0 +1,132 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include <chrono>
+#include <ctime>
+#include <ostream>
+#include <thread>
+
+using std::string;
+using std::ostream;
+using std::endl;
+
+namespace pdCalc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedSeconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+BenchmarkRunner::BenchmarkRunner()
+: repetitions_{9}
+, minTime_{0.05}
+{ }
+
+void BenchmarkRunner::add(const string& name, Benchmark b)
+{
+    benchmarks_.push_back( Entry{name, std::move(b)} );
+    return;
+}
+
+size_t BenchmarkRunner::calibrate(const Benchmark& b) const
+{
+    // a first run may set up what later runs reuse, and is not timed
+    b(1);
+
+    // grow the iteration count geometrically until a run is long enough to time
+    // reliably, then extrapolate to the minimum time
+    size_t n{1};
+    for(;;)
+    {
+        auto start = Clock::now();
+        b(n);
+        double t{ elapsedSeconds(start) };
+        if(t >= minTime_ / 10 || n >= (size_t{1} << 30))
+        {
+            double perIteration{ t / n };
+            size_t target = perIteration > 0 ? static_cast<size_t>(minTime_ / perIteration) + 1 : n;
+            return target > n ? target : n;
+        }
+        n *= 10;
+    }
+}
+
+void BenchmarkRunner::run(ostream& json, const string& filter) const
+{
+    json << "{\n"
+         << "  \"context\": {\n"
+         << "    \"executable\": \"benchmarkPdCalc\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef DEBUG
+         << "    \"library_build_type\": \"debug\"\n"
+#else
+         << "    \"library_build_type\": \"release\"\n"
+#endif
+         << "  },\n"
+         << "  \"benchmarks\": [";
+
+    bool first{true};
+    for(const auto& entry : benchmarks_)
+    {
+        if(entry.name.find(filter) == string::npos) continue;
+
+        size_t iterations{ calibrate(entry.benchmark) };
+        for(size_t rep = 0; rep < repetitions_; ++rep)
+        {
+            auto cpuStart = std::clock();
+            auto start = Clock::now();
+            entry.benchmark(iterations);
+            double real{ elapsedSeconds(start) };
+            double cpu{ static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC };
+
+            json << (first ? "\n" : ",\n")
+                 << "    {\n"
+                 << "      \"name\": \"" << entry.name << "\",\n"
+                 << "      \"run_type\": \"iteration\",\n"
+                 << "      \"repetitions\": " << repetitions_ << ",\n"
+                 << "      \"repetition_index\": " << rep << ",\n"
+                 << "      \"iterations\": " << iterations << ",\n"
+                 << "      \"real_time\": " << real * 1e9 / iterations << ",\n"
+                 << "      \"cpu_time\": " << cpu * 1e9 / iterations << ",\n"
+                 << "      \"time_unit\": \"ns\"\n"
+                 << "    }";
+            first = false;
+        }
+    }
+
+    json << "\n  ]\n}" << endl;
+
+    return;
+}
+
+void BenchmarkRunner::list(ostream& os) const
+{
+    for(const auto& entry : benchmarks_)
+        os << entry.name << "\n";
+
+    return;
+}
+
+}
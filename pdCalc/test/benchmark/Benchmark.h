@@ -0,0 +1,106 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// A deliberately small benchmark harness for pdCalc. Each benchmark is a function
+// that runs its operation a requested number of times. The runner calibrates the
+// iteration count so that one repetition takes at least the minimum time, runs
+// several repetitions, and writes one record per repetition in the JSON layout used
+// by Google Benchmark. Keeping every repetition (instead of just an average) is what
+// allows perfGate to reason about noise.
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iosfwd>
+
+namespace pdCalc {
+
+// prevents the compiler from optimizing away a value computed inside a benchmark
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+class BenchmarkRunner
+{
+public:
+    using Benchmark = std::function<void(size_t iterations)>;
+
+    BenchmarkRunner();
+
+    void add(const std::string& name, Benchmark b);
+
+    void setRepetitions(size_t n) { repetitions_ = n; }
+    void setMinTime(double seconds) { minTime_ = seconds; }
+
+    // runs all benchmarks whose name contains filter and writes the JSON report
+    void run(std::ostream& json, const std::string& filter = "") const;
+
+    // prints the names of all registered benchmarks
+    void list(std::ostream&) const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Benchmark benchmark;
+    };
+
+    size_t calibrate(const Benchmark&) const;
+
+    std::vector<Entry> benchmarks_;
+    size_t repetitions_;
+    double minTime_;
+};
+
+void RegisterBackendBenchmarks(BenchmarkRunner&);
+
+// the matrix plugin kernels, including the naive multiply they replace
+void RegisterMatrixBenchmarks(BenchmarkRunner&);
+
+// the fft plugin transforms, including the definition they replace
+void RegisterFftBenchmarks(BenchmarkRunner&);
+
+// arbitrary precision multiplication, division and roots on 10000 digit operands
+void RegisterBigNumberBenchmarks(BenchmarkRunner&);
+
+// the vectorized transcendental kernels, including the libm loops they replace
+void RegisterVectorMathBenchmarks(BenchmarkRunner&);
+
+// the random plugin fills, including the standard library generator they replace
+void RegisterRandomBenchmarks(BenchmarkRunner&);
+
+// sorting, unique, and scans over a block, including the std::sort they replace
+void RegisterBlockAlgorithmsBenchmarks(BenchmarkRunner&);
+
+// plugin commands run in pdCalc and in the plugin host, when the plugin file and the
+// host are beside the benchmarks
+void RegisterPluginHostBenchmarks(BenchmarkRunner&);
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "utilities/BigNumber.h"
+#include <random>
+#include <string>
+
+using std::string;
+
+namespace pdCalc {
+
+namespace {
+
+BigInteger randomInteger(size_t digits, unsigned seed)
+{
+    std::mt19937 gen{seed};
+    std::uniform_int_distribution<int> dist{0, 9};
+
+    string s(digits, '0');
+    for(auto& c : s)
+        c = static_cast<char>( '0' + dist(gen) );
+    s[0] = '9';
+
+    return BigInteger{s};
+}
+
+BenchmarkRunner::Benchmark multiply(size_t digits)
+{
+    return [digits](size_t iterations)
+    {
+        BigInteger a{ randomInteger(digits, 1) };
+        BigInteger b{ randomInteger(digits, 2) };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( (a * b).isZero() );
+    };
+}
+
+// a 2n by n digit division, the shape that dominates BigFloat::Divide
+BenchmarkRunner::Benchmark divide(size_t digits)
+{
+    return [digits](size_t iterations)
+    {
+        BigInteger a{ randomInteger(2 * digits, 3) };
+        BigInteger b{ randomInteger(digits, 4) };
+        BigInteger q, r;
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            BigInteger::DivMod(a, b, q, r);
+            DoNotOptimize( q.isZero() );
+        }
+    };
+}
+
+BenchmarkRunner::Benchmark squareRoot(unsigned digits)
+{
+    return [digits](size_t iterations)
+    {
+        BigFloat two{ BigInteger{2}, 0 };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( BigFloat::Root(two, 2, digits).isZero() );
+    };
+}
+
+}
+
+void RegisterBigNumberBenchmarks(BenchmarkRunner& runner)
+{
+    // 1000 digits multiplies by Karatsuba, 100000 by the number theoretic transform,
+    // and 10000 is near the crossover between them
+    runner.add("BigNumber/Multiply/1000", multiply(1000));
+    runner.add("BigNumber/Multiply/10000", multiply(10000));
+    runner.add("BigNumber/Multiply/100000", multiply(100000));
+    runner.add("BigNumber/Divide/10000", divide(10000));
+    runner.add("BigNumber/Sqrt/10000", squareRoot(10000));
+
+    return;
+}
+
+}
@@ -0,0 +1,73 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "utilities/BlockAlgorithms.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+vector<double> randomBlock(size_t n)
+{
+    std::mt19937_64 gen{42};
+    std::normal_distribution<double> dist{0.0, 1000.0};
+
+    vector<double> x(n);
+    for(auto& v : x)
+        v = dist(gen);
+
+    return x;
+}
+
+// each iteration works on a fresh copy, which the comparison pays for too
+template<typename Algorithm>
+BenchmarkRunner::Benchmark onCopy(size_t n, Algorithm algorithm)
+{
+    return [n, algorithm](size_t iterations)
+    {
+        const vector<double> x{ randomBlock(n) };
+        vector<double> y(n);
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            std::copy( x.begin(), x.end(), y.begin() );
+            algorithm( y.data(), n );
+            DoNotOptimize( y[0] );
+        }
+    };
+}
+
+}
+
+void RegisterBlockAlgorithmsBenchmarks(BenchmarkRunner& runner)
+{
+    const size_t n{1000000};
+    runner.add("BlockAlgorithms/StdSort/1000000", onCopy(n, [](double* x, size_t n) { std::sort(x, x + n); }));
+    runner.add("BlockAlgorithms/Sort/1000000", onCopy(n, BlockAlgorithms::Sort));
+    runner.add("BlockAlgorithms/Unique/1000000", onCopy(n, BlockAlgorithms::Unique));
+    runner.add("BlockAlgorithms/PrefixSum/1000000", onCopy(n, BlockAlgorithms::PrefixSum));
+
+    return;
+}
+
+}
@@ -0,0 +1,95 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "FftKernels.h"
+#include <random>
+#include <vector>
+
+using std::vector;
+using FftKernels::Complex;
+
+namespace pdCalc {
+
+namespace {
+
+vector<Complex> randomSeries(size_t n)
+{
+    std::mt19937_64 gen{42};
+    std::uniform_real_distribution<double> dist{-1.0, 1.0};
+
+    vector<Complex> x(n);
+    for(auto& v : x)
+        v = Complex{ dist(gen), dist(gen) };
+
+    return x;
+}
+
+BenchmarkRunner::Benchmark transform(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        vector<Complex> x{ randomSeries(n) };
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            FftKernels::Transform(x.data(), n);
+            DoNotOptimize( x[0] );
+        }
+    };
+}
+
+// the O(n^2) definition the transforms are measured against
+BenchmarkRunner::Benchmark naiveTransform(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        vector<Complex> x{ randomSeries(n) };
+        vector<Complex> X(n);
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            FftKernels::NaiveTransform(x.data(), X.data(), n);
+            DoNotOptimize( X[0] );
+        }
+    };
+}
+
+BenchmarkRunner::Benchmark convolve(size_t m, size_t n)
+{
+    return [m, n](size_t iterations)
+    {
+        vector<double> a(m, 0.5);
+        vector<double> b(n, -0.25);
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( FftKernels::Convolve(a.data(), m, b.data(), n)[0] );
+    };
+}
+
+}
+
+void RegisterFftBenchmarks(BenchmarkRunner& runner)
+{
+    runner.add("Fft/Naive/1024", naiveTransform(1024));
+    runner.add("Fft/Radix2/1024", transform(1024));
+    runner.add("Fft/Radix2/65536", transform(65536));
+    runner.add("Fft/Bluestein/1000", transform(1000));
+    runner.add("Fft/Convolve/4096x512", convolve(4096, 512));
+
+    return;
+}
+
+}
@@ -0,0 +1,98 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "Matrix.h"
+#include <random>
+
+namespace pdCalc {
+
+namespace {
+
+Matrix randomMatrix(size_t rows, size_t cols)
+{
+    std::mt19937_64 gen{42};
+    std::uniform_real_distribution<double> dist{-1.0, 1.0};
+
+    Matrix m{rows, cols};
+    for(size_t i = 0; i < m.size(); ++i)
+        m.data()[i] = dist(gen);
+
+    return m;
+}
+
+BenchmarkRunner::Benchmark multiply(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        Matrix a{ randomMatrix(n, n) };
+        Matrix b{ randomMatrix(n, n) };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( Multiply(a, b).data()[0] );
+    };
+}
+
+// the textbook triple loop the blocked kernel is measured against
+BenchmarkRunner::Benchmark multiplyNaive(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        Matrix a{ randomMatrix(n, n) };
+        Matrix b{ randomMatrix(n, n) };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( MultiplyNaive(a, b).data()[0] );
+    };
+}
+
+BenchmarkRunner::Benchmark luSolve(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        Matrix a{ randomMatrix(n, n) };
+        for(size_t i = 0; i < n; ++i)
+            a(i, i) += n;
+        Matrix b{ randomMatrix(n, 1) };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( LuDecomposition{a}.solve(b).data()[0] );
+    };
+}
+
+BenchmarkRunner::Benchmark transpose(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        Matrix a{ randomMatrix(n, n) };
+        for(size_t i = 0; i < iterations; ++i)
+            DoNotOptimize( Transpose(a).data()[0] );
+    };
+}
+
+}
+
+void RegisterMatrixBenchmarks(BenchmarkRunner& runner)
+{
+    runner.add("Matrix/MultiplyNaive/256", multiplyNaive(256));
+    runner.add("Matrix/Multiply/256", multiply(256));
+    runner.add("Matrix/Multiply/512", multiply(512));
+    runner.add("Matrix/LuSolve/256", luSolve(256));
+    runner.add("Matrix/Transpose/1024", transpose(1024));
+
+    return;
+}
+
+}
@@ -0,0 +1,133 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "backend/Command.h"
+#include "backend/Plugin.h"
+#include "backend/PluginHost.h"
+#include "backend/PluginLoader.h"
+#include "backend/Stack.h"
+#include "utilities/UserInterface.h"
+#include "utilities/Exception.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+// the plugin file and the helper, beside the benchmarks, as pdCalc finds them
+const char* PluginFile = "plugins.pdp";
+#ifdef WIN32
+const char* HostExecutable = "pdCalcPluginHost.exe";
+#else
+const char* HostExecutable = "./pdCalcPluginHost";
+#endif
+
+class BenchmarkInterface : public UserInterface
+{
+public:
+    void postMessage(const string&) override { }
+    void stackChanged() override { }
+};
+
+// the plugins, loaded in this process and in the helper the first time they are
+// wanted
+const Plugin& plugin(bool hosted)
+{
+    static BenchmarkInterface ui;
+    static PluginLoader inProcess;
+    static PluginLoader inHost{ std::make_shared<PluginHost>(HostExecutable) };
+    static bool loaded{false};
+    if(!loaded)
+    {
+        inProcess.loadPlugins(ui, PluginFile);
+        inHost.loadPlugins(ui, PluginFile);
+        if( inProcess.getPlugins().empty() || inHost.getPlugins().empty() )
+            throw Exception{"Could not load the plugins in " + string{PluginFile}};
+        loaded = true;
+    }
+
+    return *(hosted ? inHost : inProcess).getPlugins()[0];
+}
+
+const Command& prototype(bool hosted, const string& name)
+{
+    const auto& d = plugin(hosted).getPluginDescriptor();
+    for(int i = 0; i < d.nCommands; ++i)
+        if(d.commandNames[i] == name) return *d.commands[i];
+
+    throw Exception{"No plugin command " + name};
+}
+
+// A plugin command on n elements below their count, or on one element if n is 0,
+// above depth elements it does not touch. In the helper, one crossing each way
+// carries the elements changed, so the per element cost of a block command shows
+// how far the crossing is amortized, and a deep stack should cost nothing more. A
+// deep stack is left in place for the next run, so that the runs time the command
+// rather than building the stack and sending it to the helper.
+BenchmarkRunner::Benchmark cloneExecuteUndo(const string& name, size_t n, bool hosted, size_t depth = 0)
+{
+    return [name, n, hosted, depth](size_t iterations)
+    {
+        const Command& c = prototype(hosted, name);
+
+        Stack& stack = Stack::Instance();
+        if( depth == 0 || stack.size() != depth + n + 1 )
+        {
+            vector<double> v( depth + n + 1, 0.5 );
+            if(n > 0) v[depth + n] = static_cast<double>(n);
+            vector<Stack::ExactValue> noExact;
+            stack.swapElements(v, noExact, true);
+        }
+
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            auto p = MakeCommandPtr( c.clone() );
+            p->execute();
+            p->undo();
+        }
+
+        if(depth == 0) stack.clear();
+
+        return;
+    };
+}
+
+}
+
+void RegisterPluginHostBenchmarks(BenchmarkRunner& runner)
+{
+    if( !std::ifstream{PluginFile} || !std::ifstream{HostExecutable} ) return;
+
+    runner.add("Plugin/CloneExecuteUndo/Sinh/InProcess", cloneExecuteUndo("sinh", 0, false));
+    runner.add("Plugin/CloneExecuteUndo/Sinh/Hosted", cloneExecuteUndo("sinh", 0, true));
+    runner.add("Plugin/CloneExecuteUndo/Sinhn/100000/InProcess", cloneExecuteUndo("sinhn", 100000, false));
+    runner.add("Plugin/CloneExecuteUndo/Sinhn/100000/Hosted", cloneExecuteUndo("sinhn", 100000, true));
+    runner.add("Plugin/CloneExecuteUndo/Sinh/Depth/2000000/InProcess", cloneExecuteUndo("sinh", 0, false, 2000000));
+    runner.add("Plugin/CloneExecuteUndo/Sinh/Depth/2000000/Hosted", cloneExecuteUndo("sinh", 0, true, 2000000));
+
+    return;
+}
+
+}
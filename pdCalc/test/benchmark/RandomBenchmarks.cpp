@@ -0,0 +1,73 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "RandomKernels.h"
+#include <random>
+#include <vector>
+
+using std::vector;
+using RandomKernels::Distribution;
+
+namespace pdCalc {
+
+namespace {
+
+BenchmarkRunner::Benchmark fill(Distribution distribution, size_t n)
+{
+    return [distribution, n](size_t iterations)
+    {
+        vector<double> x(n);
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            RandomKernels::Fill(distribution, 42, i, x.data(), n);
+            DoNotOptimize( x[0] );
+        }
+    };
+}
+
+// the standard library generator the kernels are measured against
+BenchmarkRunner::Benchmark standardFill(size_t n)
+{
+    return [n](size_t iterations)
+    {
+        std::mt19937_64 gen{42};
+        std::normal_distribution<double> dist;
+        vector<double> x(n);
+        for(size_t i = 0; i < iterations; ++i)
+        {
+            for(auto& v : x)
+                v = dist(gen);
+            DoNotOptimize( x[0] );
+        }
+    };
+}
+
+}
+
+void RegisterRandomBenchmarks(BenchmarkRunner& runner)
+{
+    runner.add("Random/Uniform/1000000", fill(Distribution::Uniform, 1000000));
+    runner.add("Random/Normal/1000000", fill(Distribution::Normal, 1000000));
+    runner.add("Random/Exponential/1000000", fill(Distribution::Exponential, 1000000));
+    runner.add("Random/StdNormal/1000000", standardFill(1000000));
+
+    return;
+}
+
+}
@@ -0,0 +1,91 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Benchmark.h"
+#include "utilities/VectorMath.h"
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+namespace pdCalc {
+
+namespace {
+
+using Kernel = void(const double*, double*, size_t);
+
+// a series of n arguments spread over several periods
+vector<double> series(size_t n)
+{
+    vector<double> x(n);
+    for(size_t i = 0; i < n; ++i)
+        x[i] = 0.001 * static_cast<double>(i % 20000) - 10.0;
+
+    return x;
+}
+
+// the loop the block commands replace
+BenchmarkRunner::Benchmark libm(double (*f)(double), size_t n)
+{
+    return [f, n](size_t iterations)
+    {
+        vector<double> x{ series(n) };
+        vector<double> y(n);
+        for(size_t it = 0; it < iterations; ++it)
+        {
+            for(size_t i = 0; i < n; ++i)
+                y[i] = f(x[i]);
+            DoNotOptimize( y.back() );
+        }
+    };
+}
+
+BenchmarkRunner::Benchmark kernel(Kernel* f, size_t n)
+{
+    return [f, n](size_t iterations)
+    {
+        vector<double> x{ series(n) };
+        vector<double> y(n);
+        for(size_t it = 0; it < iterations; ++it)
+        {
+            f( x.data(), y.data(), n );
+            DoNotOptimize( y.back() );
+        }
+    };
+}
+
+}
+
+void RegisterVectorMathBenchmarks(BenchmarkRunner& runner)
+{
+    // below VectorMath::ParallelThreshold, so single threaded
+    const size_t n{10000};
+    runner.add("VectorMath/Sin/Libm/10000", libm(std::sin, n));
+    runner.add("VectorMath/Sin/10000", kernel(VectorMath::Sin, n));
+    runner.add("VectorMath/Exp/Libm/10000", libm(std::exp, n));
+    runner.add("VectorMath/Exp/10000", kernel(VectorMath::Exp, n));
+    runner.add("VectorMath/Tanh/Libm/10000", libm(std::tanh, n));
+    runner.add("VectorMath/Tanh/10000", kernel(VectorMath::Tanh, n));
+
+    // split across the thread pool
+    runner.add("VectorMath/Sin/1000000", kernel(VectorMath::Sin, 1000000));
+
+    return;
+}
+
+}
@@ -0,0 +1,30 @@
+HOME = ../..
+include ($$HOME/common.pri)
+TEMPLATE = app
+TARGET = benchmarkPdCalc
+INCLUDEPATH += . $$HOME/src $$HOME/src/plugins/matrixPlugin \
+    $$HOME/src/plugins/fftPlugin $$HOME/src/plugins/randomPlugin
+DESTDIR = $$HOME/bin
+
+QT -= gui core
+CONFIG += console
+CONFIG -= app_bundle
+
+# Input
+HEADERS += Benchmark.h
+SOURCES += main.cpp \
+    Benchmark.cpp \
+    BackendBenchmarks.cpp \
+    MatrixBenchmarks.cpp \
+    $$HOME/src/plugins/matrixPlugin/Matrix.cpp \
+    FftBenchmarks.cpp \
+    $$HOME/src/plugins/fftPlugin/FftKernels.cpp \
+    BigNumberBenchmarks.cpp \
+    VectorMathBenchmarks.cpp \
+    RandomBenchmarks.cpp \
+    $$HOME/src/plugins/randomPlugin/RandomKernels.cpp \
+    BlockAlgorithmsBenchmarks.cpp \
+    PluginHostBenchmarks.cpp
+
+unix:LIBS += -L$$HOME/lib -lpdCalcBackend -lpdCalcUtilities
+win32:LIBS += -L$$HOME/bin -lpdCalcBackend1 -lpdCalcUtilities1
@@ -0,0 +1,94 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+// Runs the pdCalc benchmark suite. The JSON report is meant to be compared against
+// the checked-in baseline with perfGate.
+//
+//    benchmarkPdCalc [--json <file>] [--filter <substring>] [--repetitions <n>]
+//                    [--min-time <seconds>] [--list]
+
+#include "Benchmark.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace {
+
+void usage()
+{
+    cerr << "benchmarkPdCalc [--json <file>] [--filter <substring>] [--repetitions <n>]\n"
+         << "                [--min-time <seconds>] [--list]" << endl;
+
+    exit(2);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    pdCalc::BenchmarkRunner runner;
+    pdCalc::RegisterBackendBenchmarks(runner);
+    pdCalc::RegisterMatrixBenchmarks(runner);
+    pdCalc::RegisterFftBenchmarks(runner);
+    pdCalc::RegisterBigNumberBenchmarks(runner);
+    pdCalc::RegisterVectorMathBenchmarks(runner);
+    pdCalc::RegisterRandomBenchmarks(runner);
+    pdCalc::RegisterBlockAlgorithmsBenchmarks(runner);
+    pdCalc::RegisterPluginHostBenchmarks(runner);
+
+    string jsonFile;
+    string filter;
+    for(int i = 1; i < argc; ++i)
+    {
+        string arg{argv[i]};
+        bool hasValue{ i + 1 < argc };
+        if(arg == "--json" && hasValue) jsonFile = argv[++i];
+        else if(arg == "--filter" && hasValue) filter = argv[++i];
+        else if(arg == "--repetitions" && hasValue) runner.setRepetitions( std::strtoul(argv[++i], nullptr, 10) );
+        else if(arg == "--min-time" && hasValue) runner.setMinTime( std::strtod(argv[++i], nullptr) );
+        else if(arg == "--list")
+        {
+            runner.list(cout);
+            return 0;
+        }
+        else usage();
+    }
+
+    if(jsonFile.empty())
+    {
+        runner.run(cout, filter);
+    }
+    else
+    {
+        std::ofstream ofs{ jsonFile.c_str() };
+        if(!ofs)
+        {
+            cerr << "Could not open " << jsonFile << " for writing." << endl;
+            return 1;
+        }
+        runner.run(ofs, filter);
+    }
+
+    return 0;
+}
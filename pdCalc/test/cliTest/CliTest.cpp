@@ -17,12 +17,14 @@
 // along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
 
 #include "CliTest.h"
+#include "ui/cli/Cli.h"
 
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
 #include <cstdio>
+#include <thread>
 
 using std::ifstream;
 using std::string;
@@ -148,3 +150,43 @@ void CliTest::testCli2()
 
     return;
 }
+
+// exact values are shown in exact mode only
+void CliTest::testCli3()
+{
+    runTest("Cli3");
+
+    return;
+}
+
+// messages posted from another thread, as plugin reloads are, come out whole
+// between the lines the cli writes
+void CliTest::testConcurrentMessages()
+{
+    const size_t n{20000};
+    ostringstream input;
+    for(size_t i = 0; i < n; ++i) input << "echoed\n";
+
+    std::istringstream in{ input.str() };
+    ostringstream out;
+    pdCalc::Cli cli{in, out};
+    pdCalc::UserInterface& ui = cli;
+
+    std::thread poster{ [&ui, n]{ for(size_t i = 0; i < n; ++i) ui.postMessage("posted"); } };
+    cli.execute(true, true);
+    poster.join();
+
+    std::istringstream result{ out.str() };
+    size_t echoed{0};
+    size_t posted{0};
+    for(string line; std::getline(result, line); )
+    {
+        if(line == "echoed") ++echoed;
+        else if(line == "posted") ++posted;
+        else QFAIL( ("Unexpected output line " + line).c_str() );
+    }
+    QCOMPARE(echoed, n);
+    QCOMPARE(posted, n);
+
+    return;
+}
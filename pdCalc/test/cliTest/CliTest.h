@@ -30,6 +30,8 @@ class CliTest : public QObject
 private slots:
     void testCli1();
     void testCli2();
+    void testCli3();
+    void testConcurrentMessages();
 
 private:
     void runCliOnFile(const std::string& in, const std::string& out);
@@ -0,0 +1,82 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MainWindowTest.h"
+#include "src/ui/gui/MainWindow.h"
+#include "src/ui/gui/GuiModel.h"
+#include "backend/AppObservers.h"
+#include "backend/Stack.h"
+#include <QApplication>
+#include <QSignalSpy>
+#include <memory>
+#include <vector>
+
+using std::vector;
+using namespace pdCalc;
+
+void MainWindowTest::init()
+{
+    int argc = 1;
+    char* argv[1];
+    argv[0] = new char[2]{'t', '\0'};
+    app_ = new QApplication(argc, argv);
+
+    window_ = new MainWindow{argc, argv};
+
+    Stack::Instance().clear();
+    Stack::Instance().attach( Stack::StackChanged, std::make_unique<StackUpdatedObserver>(*window_) );
+
+    delete [] argv[0];
+}
+
+void MainWindowTest::cleanup()
+{
+    Stack::Instance().detach(Stack::StackChanged, "StackUpdated");
+    Stack::Instance().clear();
+
+    delete window_;
+    delete app_;
+}
+
+// StackChanged events raised between two frames reach the model as one change
+void MainWindowTest::testFoldedFrame()
+{
+    Stack& stack = Stack::Instance();
+    const GuiModel& model = window_->guiModel();
+
+    // the first change rebuilds the view
+    stack.push(1.0);
+    QTRY_COMPARE( model.getState().curStack, vector<double>{1.0} );
+
+    QSignalSpy frames{ &model, SIGNAL(modelChanged()) };
+    for(int i = 2; i <= 8; ++i)
+        stack.push(i);
+    stack.pop();
+    stack.pop();
+    stack.push(10.0);
+
+    QTRY_COMPARE( model.getState().curStack, (vector<double>{10.0, 6.0, 5.0, 4.0, 3.0, 2.0}) );
+    QCOMPARE( frames.count(), 1 );
+
+    // a pop brings the element below into view
+    stack.pop();
+    QTRY_COMPARE( model.getState().curStack, (vector<double>{6.0, 5.0, 4.0, 3.0, 2.0, 1.0}) );
+    QCOMPARE( frames.count(), 2 );
+
+    return;
+}
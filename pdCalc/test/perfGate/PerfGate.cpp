@@ -0,0 +1,335 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PerfGate.h"
+#include "utilities/Exception.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <istream>
+#include <iterator>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::istream;
+using std::ostringstream;
+
+namespace pdCalc {
+
+namespace {
+
+// Just enough JSON to read benchmark reports. Numbers, strings, objects, arrays,
+// true, false, and null are understood; anything malformed throws.
+class JsonValue
+{
+public:
+    enum class Type { Null, Boolean, Number, String, Array, Object };
+
+    JsonValue() : type_{Type::Null}, number_{0} { }
+
+    Type type() const { return type_; }
+    double number() const { return number_; }
+    const string& str() const { return str_; }
+    const vector<JsonValue>& array() const { return array_; }
+
+    // returns nullptr if this is not an object or the key is absent
+    const JsonValue* find(const string& key) const
+    {
+        for(const auto& i : object_)
+            if(i.first == key) return &i.second;
+        return nullptr;
+    }
+
+    static JsonValue Parse(const string& text)
+    {
+        size_t pos{0};
+        JsonValue v{ parseValue(text, pos) };
+        skipSpace(text, pos);
+        if(pos != text.size()) fail("trailing characters", pos);
+        return v;
+    }
+
+private:
+    static void fail(const char* what, size_t pos)
+    {
+        ostringstream oss;
+        oss << "Malformed benchmark report: " << what << " at offset " << pos;
+        throw Exception{ oss.str() };
+    }
+
+    static void skipSpace(const string& t, size_t& pos)
+    {
+        while( pos < t.size() && std::isspace(static_cast<unsigned char>(t[pos])) ) ++pos;
+    }
+
+    static void expect(const string& t, size_t& pos, const char* word)
+    {
+        for(const char* c = word; *c; ++c, ++pos)
+            if(pos >= t.size() || t[pos] != *c) fail("unexpected token", pos);
+    }
+
+    static JsonValue parseValue(const string& t, size_t& pos)
+    {
+        skipSpace(t, pos);
+        if(pos >= t.size()) fail("unexpected end", pos);
+
+        JsonValue v;
+        char c{ t[pos] };
+        if(c == '{')
+        {
+            v.type_ = Type::Object;
+            ++pos;
+            skipSpace(t, pos);
+            if(pos < t.size() && t[pos] == '}') { ++pos; return v; }
+            for(;;)
+            {
+                skipSpace(t, pos);
+                string key{ parseString(t, pos) };
+                skipSpace(t, pos);
+                expect(t, pos, ":");
+                v.object_.emplace_back( key, parseValue(t, pos) );
+                skipSpace(t, pos);
+                if(pos < t.size() && t[pos] == ',') { ++pos; continue; }
+                expect(t, pos, "}");
+                return v;
+            }
+        }
+        else if(c == '[')
+        {
+            v.type_ = Type::Array;
+            ++pos;
+            skipSpace(t, pos);
+            if(pos < t.size() && t[pos] == ']') { ++pos; return v; }
+            for(;;)
+            {
+                v.array_.push_back( parseValue(t, pos) );
+                skipSpace(t, pos);
+                if(pos < t.size() && t[pos] == ',') { ++pos; continue; }
+                expect(t, pos, "]");
+                return v;
+            }
+        }
+        else if(c == '"')
+        {
+            v.type_ = Type::String;
+            v.str_ = parseString(t, pos);
+        }
+        else if(c == 't') { expect(t, pos, "true"); v.type_ = Type::Boolean; v.number_ = 1; }
+        else if(c == 'f') { expect(t, pos, "false"); v.type_ = Type::Boolean; }
+        else if(c == 'n') { expect(t, pos, "null"); }
+        else
+        {
+            const char* begin{ t.c_str() + pos };
+            char* end;
+            v.number_ = std::strtod(begin, &end);
+            if(end == begin) fail("invalid number", pos);
+            v.type_ = Type::Number;
+            pos += end - begin;
+        }
+
+        return v;
+    }
+
+    static string parseString(const string& t, size_t& pos)
+    {
+        expect(t, pos, "\"");
+        string s;
+        while(pos < t.size() && t[pos] != '"')
+        {
+            if(t[pos] == '\\')
+            {
+                if(++pos >= t.size()) break;
+                switch(t[pos])
+                {
+                case 'n': s += '\n'; break;
+                case 't': s += '\t'; break;
+                case 'r': s += '\r'; break;
+                case 'b': s += '\b'; break;
+                case 'f': s += '\f'; break;
+                case 'u': s += '?'; pos += 4; break; // benchmark names are ASCII
+                default: s += t[pos]; break;
+                }
+                ++pos;
+            }
+            else s += t[pos++];
+        }
+        expect(t, pos, "\"");
+        return s;
+    }
+
+    Type type_;
+    double number_;
+    string str_;
+    vector<JsonValue> array_;
+    vector<pair<string, JsonValue>> object_;
+};
+
+double toNanoseconds(double t, const string& unit)
+{
+    if(unit == "ns" || unit.empty()) return t;
+    else if(unit == "us") return t * 1e3;
+    else if(unit == "ms") return t * 1e6;
+    else if(unit == "s") return t * 1e9;
+    else throw Exception{"Unknown time unit " + unit};
+}
+
+// log of the binomial(n, 1/2) probability mass at k
+double logBinomialHalf(size_t n, size_t k)
+{
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0) - n * std::log(2.0);
+}
+
+}
+
+PerfGate::Samples PerfGate::ReadSamples(istream& is)
+{
+    string text{ std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{} };
+    JsonValue report{ JsonValue::Parse(text) };
+
+    const JsonValue* benchmarks{ report.find("benchmarks") };
+    if(!benchmarks || benchmarks->type() != JsonValue::Type::Array)
+        throw Exception{"Benchmark report has no benchmarks array"};
+
+    Samples samples;
+    for(const auto& b : benchmarks->array())
+    {
+        const JsonValue* runType{ b.find("run_type") };
+        if(runType && runType->str() == "aggregate") continue;
+
+        const JsonValue* name{ b.find("name") };
+        const JsonValue* time{ b.find("real_time") };
+        const JsonValue* unit{ b.find("time_unit") };
+        if(!name || !time || time->type() != JsonValue::Type::Number)
+            throw Exception{"Benchmark record is missing its name or real_time"};
+
+        samples[name->str()].push_back( toNanoseconds(time->number(), unit ? unit->str() : "") );
+    }
+
+    return samples;
+}
+
+double PerfGate::Median(vector<double> v)
+{
+    if(v.empty()) return 0;
+
+    auto mid = v.begin() + v.size() / 2;
+    std::nth_element(v.begin(), mid, v.end());
+    double m{ *mid };
+    if(v.size() % 2 == 0)
+        m = ( m + *std::max_element(v.begin(), mid) ) / 2;
+
+    return m;
+}
+
+pair<double, double> PerfGate::MedianInterval(vector<double> v, double confidence)
+{
+    if(v.empty()) return {0, 0};
+
+    std::sort(v.begin(), v.end());
+    const size_t n{ v.size() };
+
+    // The interval [x(k), x(n-1-k)] (zero based) covers the median with probability
+    // 1 - 2 P(B <= k) for B ~ binomial(n, 1/2). Find the largest k that still
+    // achieves the requested confidence. With very few samples no k does, and the
+    // full range is the best available interval.
+    const double alpha{ (1.0 - confidence) / 2 };
+    double tail{0};
+    size_t k{0};
+    for(size_t j = 0; j < n / 2; ++j)
+    {
+        tail += std::exp( logBinomialHalf(n, j) );
+        if(tail > alpha) break;
+        k = j;
+    }
+
+    return { v[k], v[n - 1 - k] };
+}
+
+const char* PerfGate::VerdictName(Verdict v)
+{
+    switch(v)
+    {
+    case Verdict::Unchanged: return "unchanged";
+    case Verdict::Faster: return "faster";
+    case Verdict::Slower: return "SLOWER";
+    case Verdict::Missing: return "missing";
+    case Verdict::New: return "new";
+    default: return "unknown";
+    }
+}
+
+vector<PerfGate::Comparison> PerfGate::Compare(const Samples& baseline, const Samples& current, const Options& opt)
+{
+    vector<Comparison> result;
+
+    for(const auto& b : baseline)
+    {
+        Comparison c;
+        c.name = b.first;
+        c.nBaseline = b.second.size();
+        c.baselineMedian = Median(b.second);
+        c.baselineInterval = MedianInterval(b.second, opt.confidence);
+
+        auto cur = current.find(b.first);
+        if(cur == current.end())
+        {
+            c.verdict = Verdict::Missing;
+            c.nCurrent = 0;
+            c.currentMedian = 0;
+            c.currentInterval = {0, 0};
+        }
+        else
+        {
+            c.nCurrent = cur->second.size();
+            c.currentMedian = Median(cur->second);
+            c.currentInterval = MedianInterval(cur->second, opt.confidence);
+
+            double ratio{ c.baselineMedian > 0 ? c.currentMedian / c.baselineMedian : 1.0 };
+            if(ratio > 1 + opt.tolerance && c.currentInterval.first > c.baselineInterval.second)
+                c.verdict = Verdict::Slower;
+            else if(ratio < 1 - opt.tolerance && c.currentInterval.second < c.baselineInterval.first)
+                c.verdict = Verdict::Faster;
+            else
+                c.verdict = Verdict::Unchanged;
+        }
+
+        result.push_back(c);
+    }
+
+    for(const auto& cur : current)
+    {
+        if(baseline.find(cur.first) != baseline.end()) continue;
+
+        Comparison c;
+        c.name = cur.first;
+        c.verdict = Verdict::New;
+        c.nBaseline = 0;
+        c.baselineMedian = 0;
+        c.baselineInterval = {0, 0};
+        c.nCurrent = cur.second.size();
+        c.currentMedian = Median(cur.second);
+        c.currentInterval = MedianInterval(cur.second, opt.confidence);
+        result.push_back(c);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,86 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PERF_GATE_H
+#define PERF_GATE_H
+
+// The PerfGate compares the JSON report written by the benchmark suite against a
+// checked-in baseline report. Timings are noisy, so a single slow run must not fail
+// the gate. Instead, every benchmark is summarized by the median of its repetitions
+// together with a distribution free confidence interval for that median (built from
+// order statistics). A benchmark is only declared slower if its median exceeds the
+// baseline median by more than the tolerance AND the two confidence intervals do not
+// overlap.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <iosfwd>
+
+namespace pdCalc {
+
+class PerfGate
+{
+public:
+    struct Options
+    {
+        Options() : tolerance{0.10}, confidence{0.95} { }
+
+        // relative slowdown of the median that is tolerated before failing
+        double tolerance;
+
+        // confidence level of the interval placed around each median
+        double confidence;
+    };
+
+    enum class Verdict { Unchanged, Faster, Slower, Missing, New };
+
+    struct Comparison
+    {
+        std::string name;
+        Verdict verdict;
+        double baselineMedian;
+        double currentMedian;
+        std::pair<double, double> baselineInterval;
+        std::pair<double, double> currentInterval;
+        size_t nBaseline;
+        size_t nCurrent;
+    };
+
+    // timings in nanoseconds per iteration for each repetition, keyed by benchmark name
+    using Samples = std::map<std::string, std::vector<double>>;
+
+    // reads a benchmark JSON report; aggregate records are ignored because the gate
+    // computes its own statistics from the individual repetitions
+    // throws an Exception if the report cannot be parsed
+    static Samples ReadSamples(std::istream&);
+
+    static std::vector<Comparison> Compare(const Samples& baseline, const Samples& current, const Options& = Options{});
+
+    static double Median(std::vector<double>);
+
+    // distribution free confidence interval for the median of the samples
+    static std::pair<double, double> MedianInterval(std::vector<double>, double confidence);
+
+    static const char* VerdictName(Verdict);
+};
+
+}
+
+#endif
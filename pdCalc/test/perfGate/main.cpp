@@ -0,0 +1,131 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+// Compares a benchmark JSON report against a stored baseline report.
+//
+//    perfGate <results.json> <baseline.json> [--tolerance <fraction>]
+//             [--confidence <level>] [--update]
+//
+// Exit status is 0 if no benchmark is significantly slower, 1 if at least one is,
+// and 2 for usage or input errors. --update replaces the baseline with the results.
+
+#include "PerfGate.h"
+#include "utilities/Exception.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::setw;
+
+namespace {
+
+void usage()
+{
+    cerr << "perfGate <results.json> <baseline.json> [--tolerance <fraction>]\n"
+         << "         [--confidence <level>] [--update]" << endl;
+
+    exit(2);
+}
+
+pdCalc::PerfGate::Samples readFile(const string& name)
+{
+    std::ifstream ifs{ name.c_str() };
+    if(!ifs) throw pdCalc::Exception{"Could not open " + name};
+
+    return pdCalc::PerfGate::ReadSamples(ifs);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using pdCalc::PerfGate;
+
+    PerfGate::Options opt;
+    bool update{false};
+    string files[2];
+    int nFiles{0};
+    for(int i = 1; i < argc; ++i)
+    {
+        string arg{argv[i]};
+        bool hasValue{ i + 1 < argc };
+        if(arg == "--tolerance" && hasValue) opt.tolerance = std::strtod(argv[++i], nullptr);
+        else if(arg == "--confidence" && hasValue) opt.confidence = std::strtod(argv[++i], nullptr);
+        else if(arg == "--update") update = true;
+        else if(arg[0] != '-' && nFiles < 2) files[nFiles++] = arg;
+        else usage();
+    }
+
+    if(nFiles != 2 || opt.tolerance < 0 || opt.confidence <= 0 || opt.confidence >= 1)
+        usage();
+
+    try
+    {
+        PerfGate::Samples current{ readFile(files[0]) };
+
+        if(update)
+        {
+            std::ifstream ifs{ files[0].c_str(), std::ios::binary };
+            std::ofstream ofs{ files[1].c_str(), std::ios::binary };
+            if(!ofs) throw pdCalc::Exception{"Could not open " + files[1] + " for writing"};
+            ofs << ifs.rdbuf();
+            cout << "Baseline " << files[1] << " updated with " << current.size() << " benchmarks" << endl;
+            return 0;
+        }
+
+        PerfGate::Samples baseline{ readFile(files[1]) };
+        auto comparisons = PerfGate::Compare(baseline, current, opt);
+
+        int slower{0};
+        cout << std::fixed << std::setprecision(1);
+        for(const auto& c : comparisons)
+        {
+            cout << std::left << setw(40) << c.name << std::right << setw(10) << PerfGate::VerdictName(c.verdict);
+            if(c.nBaseline > 0)
+                cout << "  baseline " << setw(12) << c.baselineMedian << " ns ["
+                     << c.baselineInterval.first << ", " << c.baselineInterval.second << "]";
+            if(c.nCurrent > 0)
+                cout << "  current " << setw(12) << c.currentMedian << " ns ["
+                     << c.currentInterval.first << ", " << c.currentInterval.second << "]";
+            cout << endl;
+
+            if(c.verdict == PerfGate::Verdict::Slower) ++slower;
+        }
+
+        cout << endl;
+        if(slower == 0)
+        {
+            cout << "No significant slowdowns" << endl;
+            return 0;
+        }
+
+        cout << slower << " benchmark(s) significantly slower than baseline" << endl;
+        return 1;
+    }
+    catch(pdCalc::Exception& e)
+    {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
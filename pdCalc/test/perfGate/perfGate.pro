@@ -0,0 +1,18 @@
+HOME = ../..
+include ($$HOME/common.pri)
+TEMPLATE = app
+TARGET = perfGate
+INCLUDEPATH += . $$HOME/src
+DESTDIR = $$HOME/bin
+
+QT -= gui core
+CONFIG += console
+CONFIG -= app_bundle
+
+# Input
+HEADERS += PerfGate.h
+SOURCES += main.cpp \
+    PerfGate.cpp
+
+unix:LIBS += -L$$HOME/lib -lpdCalcUtilities
+win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1
@@ -0,0 +1,328 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "FftPluginTest.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "utilities/UserInterface.h"
+#include "backend/Stack.h"
+#include "utilities/Exception.h"
+#include "backend/Command.h"
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+using std::map;
+using std::string;
+using std::vector;
+using pdCalc::Plugin;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    TestInterface() { }
+    void postMessage(const string&) override {  }
+    void stackChanged() override { }
+};
+
+// the loader must outlive the commands taken from its plugins
+TestInterface ui;
+std::unique_ptr<pdCalc::PluginLoader> loader;
+
+const double Pi = 3.14159265358979323846;
+
+// stack encoding of a series: its values, then their count
+vector<double> encode(vector<double> values, size_t count)
+{
+    values.push_back(count);
+    return values;
+}
+
+vector<double> concat(vector<double> a, const vector<double>& b)
+{
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+// the transform by its definition, as real, imaginary pairs
+vector<double> dft(const vector<double>& x)
+{
+    const size_t n{ x.size() };
+    vector<double> X;
+    for(size_t k = 0; k < n; ++k)
+    {
+        std::complex<double> s{0.0, 0.0};
+        for(size_t j = 0; j < n; ++j)
+            s += x[j] * std::polar(1.0, -2.0 * Pi * static_cast<double>(j * k % n) / n);
+        X.push_back( s.real() );
+        X.push_back( s.imag() );
+    }
+
+    return X;
+}
+
+}
+
+void FftPluginTest::initTestCase()
+{
+    loader = std::make_unique<pdCalc::PluginLoader>();
+
+    string pluginFile{PLUGIN_TEST_DIR};
+    pluginFile += "/";
+    pluginFile += FFT_PLUGIN_TEST_FILE;
+    loader->loadPlugins(ui, pluginFile);
+
+    vector<const Plugin*> plugins{ loader->getPlugins() };
+    QVERIFY(plugins.size() == 1);
+
+    Plugin::PluginDescriptor descriptor = plugins[0]->getPluginDescriptor();
+    for(int i = 0; i < descriptor.nCommands; ++i)
+        commands_[descriptor.commandNames[i]] = descriptor.commands[i];
+
+    return;
+}
+
+void FftPluginTest::cleanupTestCase()
+{
+    commands_.clear();
+    loader.reset();
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+pdCalc::Command* FftPluginTest::command(const string& name) const
+{
+    auto i = commands_.find(name);
+    return i == commands_.end() ? nullptr : i->second;
+}
+
+void FftPluginTest::setStack(const vector<double>& v)
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.pushElements(v.data(), v.size(), true);
+
+    return;
+}
+
+vector<double> FftPluginTest::topOfStack(size_t n) const
+{
+    vector<double> top(n);
+    pdCalc::Stack::Instance().peekElements(n, top.data());
+    return top;
+}
+
+// executes the command on the given stack (bottom first), checks that the operands
+// were replaced by the result (bottom first), and that a single undo restores the
+// stack exactly
+void FftPluginTest::testResult(const string& name, const vector<double>& v, const vector<double>& result)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack( concat({-7}, v) );
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    c->execute();
+
+    QCOMPARE( stack.size(), result.size() + 1 );
+    vector<double> top{ topOfStack( result.size() ) };
+    for(size_t i = 0; i < result.size(); ++i)
+        QVERIFY( std::abs(top[i] - result[i]) <= 1e-12 * std::max(1.0, std::abs(result[i])) );
+
+    c->undo();
+
+    QCOMPARE( topOfStack( stack.size() ), concat({-7}, v) );
+
+    return;
+}
+
+void FftPluginTest::testFails(const string& name, const vector<double>& v)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack(v);
+    try
+    {
+        c->execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    QVERIFY( pdCalc::Stack::Instance().size() == v.size() );
+
+    return;
+}
+
+void FftPluginTest::testDescriptor()
+{
+    QCOMPARE( commands_.size(), size_t{6} );
+
+    for(auto name : {"fft", "ifft", "cfft", "cifft", "psd", "conv"})
+        QVERIFY( command(name) != nullptr );
+
+    return;
+}
+
+void FftPluginTest::testTransform()
+{
+    testResult("fft", encode({1, 0, 0, 0}, 4), encode({1, 0, 1, 0, 1, 0, 1, 0}, 4));
+    testResult("fft", encode({1, 2, 3, 4}, 4), encode({10, 0, -2, 2, -2, 0, -2, -2}, 4));
+    testResult("fft", encode({5}, 1), encode({5, 0}, 1));
+
+    // a length that is not a power of two goes through Bluestein's algorithm
+    testResult("fft", encode({1, 2, 3}, 3), encode(dft({1, 2, 3}), 3));
+    testResult("fft", encode({1, -1, 2, 0.5, 3, 7}, 6), encode(dft({1, -1, 2, 0.5, 3, 7}), 6));
+
+    testResult("cfft", encode({0, 1, 0, 0}, 2), encode({0, 1, 0, 1}, 2));
+    testResult("cifft", encode({0, 2, 0, 0}, 2), encode({0, 1, 0, 1}, 2));
+    testResult("ifft", encode({10, 0, -2, 2, -2, 0, -2, -2}, 4), encode({1, 2, 3, 4}, 4));
+
+    return;
+}
+
+void FftPluginTest::testRoundTrip()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    for(size_t n : {size_t{8}, size_t{12}, size_t{17}})
+    {
+        vector<double> x(n);
+        for(size_t i = 0; i < n; ++i)
+            x[i] = std::sin(0.3 * i) + 0.1 * i;
+
+        setStack( encode(x, n) );
+        command("fft")->execute();
+        QCOMPARE( stack.size(), 2 * n + 1 );
+        command("ifft")->execute();
+        QCOMPARE( stack.size(), n + 1 );
+
+        vector<double> y{ topOfStack(n + 1) };
+        for(size_t i = 0; i < n; ++i)
+            QVERIFY( std::abs(y[i] - x[i]) < 1e-12 );
+        QCOMPARE( y[n], double(n) );
+
+        vector<double> c(2 * n);
+        for(size_t i = 0; i < n; ++i)
+        {
+            c[2 * i] = x[i];
+            c[2 * i + 1] = -x[n - 1 - i];
+        }
+
+        setStack( encode(c, n) );
+        command("cfft")->execute();
+        command("cifft")->execute();
+        QCOMPARE( stack.size(), 2 * n + 1 );
+
+        vector<double> z{ topOfStack(2 * n + 1) };
+        for(size_t i = 0; i < 2 * n; ++i)
+            QVERIFY( std::abs(z[i] - c[i]) < 1e-12 );
+    }
+
+    return;
+}
+
+void FftPluginTest::testPowerSpectrum()
+{
+    testResult("psd", encode({1, 1, 1, 1}, 4), encode({4, 0, 0}, 3));
+    testResult("psd", encode({1, -1, 1, -1}, 4), encode({0, 0, 4}, 3));
+    testResult("psd", encode({1, 2, 3}, 3), encode({12, 1}, 2));
+
+    return;
+}
+
+void FftPluginTest::testConvolution()
+{
+    testResult("conv", concat(encode({1, 2, 3}, 3), encode({0, 1, 0.5}, 3)), encode({0, 1, 2.5, 4, 1.5}, 5));
+    testResult("conv", concat(encode({2}, 1), encode({1, 2, 3}, 3)), encode({2, 4, 6}, 3));
+
+    // long enough on both sides to go through the transform
+    std::mt19937_64 gen{7};
+    std::uniform_real_distribution<double> dist{-1.0, 1.0};
+    vector<double> a(100);
+    vector<double> b(77);
+    for(auto& x : a) x = dist(gen);
+    for(auto& x : b) x = dist(gen);
+
+    vector<double> c(a.size() + b.size() - 1, 0.0);
+    for(size_t i = 0; i < a.size(); ++i)
+        for(size_t j = 0; j < b.size(); ++j)
+            c[i + j] += a[i] * b[j];
+
+    setStack( concat(encode(a, a.size()), encode(b, b.size())) );
+    command("conv")->execute();
+    vector<double> top{ topOfStack(c.size() + 1) };
+    for(size_t i = 0; i < c.size(); ++i)
+        QVERIFY( std::abs(top[i] - c[i]) < 1e-12 );
+    QCOMPARE( top.back(), double(c.size()) );
+
+    return;
+}
+
+void FftPluginTest::testPreconditions()
+{
+    testFails("fft", {});
+    testFails("fft", {0});
+    testFails("fft", {1, 2, 1.5});
+    testFails("fft", {1, 2, -1});
+    testFails("fft", {1, 2, 3});
+    testFails("fft", {1, 2, 1e300});
+    testFails("cfft", {1, 2, 3, 2});
+    testFails("ifft", {1, 2, 3, 2});
+    testFails("conv", encode({1, 2}, 2));
+    testFails("conv", concat({1}, encode({1, 2}, 2)));
+
+    return;
+}
+
+// large power of two and Bluestein lengths against the definition
+void FftPluginTest::testLargeInput()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    std::mt19937_64 gen{42};
+    std::uniform_real_distribution<double> dist{-1.0, 1.0};
+
+    for(size_t n : {size_t{1024}, size_t{1000}})
+    {
+        vector<double> x(n);
+        for(auto& v : x) v = dist(gen);
+        vector<double> X{ dft(x) };
+
+        setStack( encode(x, n) );
+        command("fft")->execute();
+        vector<double> top{ topOfStack(2 * n + 1) };
+        for(size_t i = 0; i < 2 * n; ++i)
+            QVERIFY( std::abs(top[i] - X[i]) < 1e-10 );
+
+        command("fft")->undo();
+        QCOMPARE( stack.size(), n + 1 );
+    }
+
+    stack.clear();
+
+    return;
+}
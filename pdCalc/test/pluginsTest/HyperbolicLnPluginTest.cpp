@@ -23,6 +23,7 @@
 #include "backend/Stack.h"
 #include "utilities/Exception.h"
 #include "backend/Command.h"
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <map>
@@ -110,6 +111,34 @@ void HyperbolicLnPluginTest::testCommand(pdCalc::Command* command, double top, d
     return;
 }
 
+void HyperbolicLnPluginTest::testBlockCommand(pdCalc::Command* command, const vector<double>& block, double (*f)(double))
+{
+    pdCalc::Stack& stack = getCheckedStack();
+
+    stack.push(99.0);
+    for(double d : block)
+        stack.push(d);
+    stack.push( static_cast<double>( block.size() ) );
+
+    command->execute();
+
+    QCOMPARE( stack.size(), block.size() + 1 );
+    vector<double> v{ stack.getElements( block.size() + 1 ) };
+    for(size_t i = 0; i < block.size(); ++i)
+        QVERIFY( std::abs(v[block.size() - 1 - i] - f(block[i])) <= 1e-14 * std::max(1.0, std::abs(f(block[i]))) );
+    QCOMPARE( v.back(), 99.0 );
+
+    command->undo();
+
+    QCOMPARE( stack.size(), block.size() + 2 );
+    v = stack.getElements( block.size() + 2 );
+    QCOMPARE( v[0], static_cast<double>( block.size() ) );
+    for(size_t i = 0; i < block.size(); ++i)
+        QCOMPARE( v[block.size() - i], block[i] );
+
+    return;
+}
+
 void HyperbolicLnPluginTest::testHyperbolicLnPlugin()
 {
     TestInterface ui;
@@ -127,7 +156,7 @@ void HyperbolicLnPluginTest::testHyperbolicLnPlugin()
     const Plugin* p = plugins[0];
     Plugin::PluginDescriptor descriptor = p->getPluginDescriptor();
 
-    QCOMPARE(descriptor.nCommands, 8);
+    QCOMPARE(descriptor.nCommands, 16);
 
     map<string, pdCalc::Command*> commands;
     for(int i = 0; i < descriptor.nCommands; ++i)
@@ -206,3 +235,78 @@ void HyperbolicLnPluginTest::testHyperbolicLnPlugin()
     testCommand( commands.find("ln")->second, top, std::log(top) );
     return;
 }
+
+void HyperbolicLnPluginTest::testBlockCommands()
+{
+    TestInterface ui;
+    pdCalc::PluginLoader loader;
+
+    string pluginFile{PLUGIN_TEST_DIR};
+    pluginFile += "/../backendTest/";
+    pluginFile += PLUGIN_TEST_FILE;
+    loader.loadPlugins(ui, pluginFile);
+
+    vector<const Plugin*> plugins{ loader.getPlugins() };
+    QVERIFY(plugins.size() == 1);
+
+    Plugin::PluginDescriptor descriptor = plugins[0]->getPluginDescriptor();
+    map<string, pdCalc::Command*> commands;
+    for(int i = 0; i < descriptor.nCommands; ++i)
+        commands[descriptor.commandNames[i]] = descriptor.commands[i];
+
+    // long enough for whole vectors and a tail
+    vector<double> block;
+    for(int i = 0; i < 11; ++i)
+        block.push_back(0.083 * i - 0.41);
+
+    testBlockCommand( commands.find("sinhn")->second, block, std::sinh );
+    testBlockCommand( commands.find("coshn")->second, block, std::cosh );
+    testBlockCommand( commands.find("tanhn")->second, block, std::tanh );
+    testBlockCommand( commands.find("arcsinhn")->second, block, std::asinh );
+    testBlockCommand( commands.find("arctanhn")->second, block, std::atanh );
+    testBlockCommand( commands.find("expn")->second, block, std::exp );
+
+    vector<double> positive;
+    for(double d : block)
+        positive.push_back(d + 1.5);
+    testBlockCommand( commands.find("arccoshn")->second, positive, std::acosh );
+    testBlockCommand( commands.find("lnn")->second, positive, std::log );
+
+    // the count, then each element of the block against the domain
+    pdCalc::Stack& stack = getCheckedStack();
+    pdCalc::Command* lnn = commands.find("lnn")->second;
+    for(double count : {0.0, 2.5, 3.0})
+    {
+        stack.clear();
+        stack.push(1.0);
+        stack.push(2.0);
+        stack.push(count);
+        try
+        {
+            lnn->execute();
+            QVERIFY(false);
+        }
+        catch(pdCalc::Exception&)
+        {
+            QVERIFY(true);
+        }
+    }
+
+    stack.clear();
+    stack.push(1.0);
+    stack.push(-2.0);
+    stack.push(3.0);
+    stack.push(3.0);
+    try
+    {
+        lnn->execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Imaginary result"} );
+    }
+    QCOMPARE( stack.size(), size_t{4} );
+
+    return;
+}
@@ -20,6 +20,7 @@
 #define HYPERBOLIC_LN_PLUGIN_TEST_H
 
 #include <QtTest/QtTest>
+#include <vector>
 
 namespace pdCalc {
     class Stack;
@@ -31,11 +32,13 @@ class HyperbolicLnPluginTest : public QObject
     Q_OBJECT
 private slots:
     void testHyperbolicLnPlugin();
+    void testBlockCommands();
 
 private:
     pdCalc::Stack& getCheckedStack();
     void testPreconditions(pdCalc::Command* command, double number);
     void testCommand(pdCalc::Command* command, double top, double result);
+    void testBlockCommand(pdCalc::Command* command, const std::vector<double>& block, double (*f)(double));
 };
 
 #endif
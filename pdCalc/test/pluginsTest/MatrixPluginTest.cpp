@@ -0,0 +1,334 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "MatrixPluginTest.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "utilities/UserInterface.h"
+#include "backend/Stack.h"
+#include "utilities/Exception.h"
+#include "backend/Command.h"
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+using std::map;
+using std::string;
+using std::vector;
+using pdCalc::Plugin;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    TestInterface() { }
+    void postMessage(const string&) override {  }
+    void stackChanged() override { }
+};
+
+// the loader must outlive the commands taken from its plugins
+TestInterface ui;
+std::unique_ptr<pdCalc::PluginLoader> loader;
+
+// stack encoding of an r x c matrix: entries row major, then rows, then columns
+vector<double> encode(size_t r, size_t c, vector<double> entries)
+{
+    entries.push_back(r);
+    entries.push_back(c);
+    return entries;
+}
+
+vector<double> concat(vector<double> a, const vector<double>& b)
+{
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+}
+
+void MatrixPluginTest::initTestCase()
+{
+    loader = std::make_unique<pdCalc::PluginLoader>();
+
+    string pluginFile{PLUGIN_TEST_DIR};
+    pluginFile += "/";
+    pluginFile += MATRIX_PLUGIN_TEST_FILE;
+    loader->loadPlugins(ui, pluginFile);
+
+    vector<const Plugin*> plugins{ loader->getPlugins() };
+    QVERIFY(plugins.size() == 1);
+
+    Plugin::PluginDescriptor descriptor = plugins[0]->getPluginDescriptor();
+    for(int i = 0; i < descriptor.nCommands; ++i)
+        commands_[descriptor.commandNames[i]] = descriptor.commands[i];
+
+    return;
+}
+
+void MatrixPluginTest::cleanupTestCase()
+{
+    commands_.clear();
+    loader.reset();
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+pdCalc::Command* MatrixPluginTest::command(const string& name) const
+{
+    auto i = commands_.find(name);
+    return i == commands_.end() ? nullptr : i->second;
+}
+
+void MatrixPluginTest::setStack(const vector<double>& v)
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.pushElements(v.data(), v.size(), true);
+
+    return;
+}
+
+// executes the command on the given stack (bottom first), checks that the operands
+// were replaced by the result (bottom first), and that a single undo restores the
+// stack exactly
+void MatrixPluginTest::testResult(const string& name, const vector<double>& v, const vector<double>& result)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack( concat({-7}, v) );
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    c->execute();
+
+    QCOMPARE( stack.size(), result.size() + 1 );
+    vector<double> top(result.size());
+    stack.peekElements(top.size(), top.data());
+    for(size_t i = 0; i < result.size(); ++i)
+        QVERIFY( std::abs(top[i] - result[i]) <= 1e-12 * std::max(1.0, std::abs(result[i])) );
+
+    c->undo();
+
+    vector<double> restored( stack.size() );
+    stack.peekElements(restored.size(), restored.data());
+    QCOMPARE( restored, concat({-7}, v) );
+
+    return;
+}
+
+void MatrixPluginTest::testFails(const string& name, const vector<double>& v)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack(v);
+    try
+    {
+        c->execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    QVERIFY( pdCalc::Stack::Instance().size() == v.size() );
+
+    return;
+}
+
+void MatrixPluginTest::testDescriptor()
+{
+    QCOMPARE( commands_.size(), size_t{5} );
+
+    for(auto name : {"mmul", "mtrans", "msolve", "mdet", "minv"})
+        QVERIFY( command(name) != nullptr );
+
+    return;
+}
+
+void MatrixPluginTest::testMultiply()
+{
+    vector<double> A{ encode(2, 3, {1, 2, 3,
+                                    4, 5, 6}) };
+    vector<double> B{ encode(3, 2, {7, 8,
+                                    9, 10,
+                                    11, 12}) };
+
+    testResult("mmul", concat(A, B), encode(2, 2, {58, 64, 139, 154}));
+    testResult("mmul", concat(B, A), encode(3, 3, {39, 54, 69, 49, 68, 87, 59, 82, 105}));
+    testResult("mmul", concat(encode(1, 1, {3}), encode(1, 1, {4})), encode(1, 1, {12}));
+
+    return;
+}
+
+void MatrixPluginTest::testTranspose()
+{
+    testResult("mtrans", encode(2, 3, {1, 2, 3, 4, 5, 6}), encode(3, 2, {1, 4, 2, 5, 3, 6}));
+    testResult("mtrans", encode(1, 4, {1, 2, 3, 4}), encode(4, 1, {1, 2, 3, 4}));
+
+    return;
+}
+
+void MatrixPluginTest::testSolve()
+{
+    vector<double> A{ encode(2, 2, {2, 1,
+                                    1, 3}) };
+
+    testResult("msolve", concat(A, encode(2, 1, {3, 5})), encode(2, 1, {0.8, 1.4}));
+    testResult("msolve", concat(A, encode(2, 2, {2, 1, 1, 3})), encode(2, 2, {1, 0, 0, 1}));
+
+    // requires a row interchange
+    vector<double> P{ encode(3, 3, {0, 1, 0,
+                                    0, 0, 1,
+                                    1, 0, 0}) };
+    testResult("msolve", concat(P, encode(3, 1, {1, 2, 3})), encode(3, 1, {3, 1, 2}));
+
+    return;
+}
+
+void MatrixPluginTest::testDeterminant()
+{
+    testResult("mdet", encode(2, 2, {1, 2, 3, 4}), {-2});
+    testResult("mdet", encode(3, 3, {0, 1, 0, 0, 0, 1, 1, 0, 0}), {1});
+    testResult("mdet", encode(3, 3, {0, 1, 0, 1, 0, 0, 0, 0, 1}), {-1});
+    testResult("mdet", encode(3, 3, {2, -3, 1, 2, 0, -1, 1, 4, 5}), {49});
+
+    // a singular matrix has a determinant, just zero
+    testResult("mdet", encode(2, 2, {1, 2, 2, 4}), {0});
+
+    return;
+}
+
+void MatrixPluginTest::testInverse()
+{
+    testResult("minv", encode(2, 2, {4, 7, 2, 6}), encode(2, 2, {0.6, -0.7, -0.2, 0.4}));
+    testResult("minv", encode(3, 3, {0, 1, 0, 0, 0, 1, 1, 0, 0}), encode(3, 3, {0, 0, 1, 1, 0, 0, 0, 1, 0}));
+
+    return;
+}
+
+void MatrixPluginTest::testPreconditions()
+{
+    testFails("mtrans", {});
+    testFails("mtrans", {2});
+    testFails("mtrans", {1, 2, 3, 2, 2});
+    testFails("mtrans", {1, 2, 1, 2.5});
+    testFails("mtrans", {1, 2, 0, 2});
+    testFails("mtrans", {1, 2, -1, 2});
+    testFails("mtrans", {1, 2, 1e300, 1e300});
+
+    vector<double> A{ encode(2, 3, {1, 2, 3, 4, 5, 6}) };
+    testFails("mmul", A);
+    testFails("mmul", concat(A, A));
+    testFails("msolve", concat(A, encode(2, 1, {1, 1})));
+    testFails("msolve", concat(encode(2, 2, {1, 2, 3, 4}), encode(3, 1, {1, 1, 1})));
+    testFails("mdet", A);
+    testFails("minv", A);
+
+    testFails("minv", encode(2, 2, {1, 2, 2, 4}));
+    testFails("msolve", concat(encode(2, 2, {1, 2, 2, 4}), encode(2, 1, {1, 1})));
+
+    return;
+}
+
+// large enough to take the blocked and parallel paths
+void MatrixPluginTest::testLargeInput()
+{
+    const size_t n = 300;
+    const size_t m = 7;
+    std::mt19937_64 gen{42};
+    std::uniform_real_distribution<double> dist{-1.0, 1.0};
+
+    vector<double> a(n * n);
+    for(auto& x : a) x = dist(gen);
+    // diagonally dominant, so well conditioned
+    for(size_t i = 0; i < n; ++i) a[i * n + i] += n;
+
+    vector<double> b(n * m);
+    for(auto& x : b) x = dist(gen);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    setStack( concat(encode(n, n, a), encode(n, m, b)) );
+    command("mmul")->execute();
+    QCOMPARE( stack.size(), n * m + 2 );
+    vector<double> c(n * m + 2);
+    stack.peekElements(c.size(), c.data());
+    for(size_t i = 0; i < n; ++i)
+    {
+        for(size_t j = 0; j < m; ++j)
+        {
+            double s{0};
+            for(size_t k = 0; k < n; ++k)
+                s += a[i * n + k] * b[k * m + j];
+            QVERIFY( std::abs(c[i * m + j] - s) < 1e-10 * n );
+        }
+    }
+    command("mmul")->undo();
+    QCOMPARE( stack.size(), n * n + n * m + 4 );
+
+    command("msolve")->execute();
+    vector<double> x(n * m + 2);
+    stack.peekElements(x.size(), x.data());
+    for(size_t i = 0; i < n; ++i)
+    {
+        for(size_t j = 0; j < m; ++j)
+        {
+            double s{0};
+            for(size_t k = 0; k < n; ++k)
+                s += a[i * n + k] * x[k * m + j];
+            QVERIFY( std::abs(s - b[i * m + j]) < 1e-10 );
+        }
+    }
+
+    // a large square product so every worker gets a row block
+    setStack( concat(encode(n, n, a), encode(n, n, a)) );
+    command("mmul")->execute();
+    vector<double> sq(n * n + 2);
+    stack.peekElements(sq.size(), sq.data());
+    for(size_t i = 0; i < n; i += 37)
+    {
+        for(size_t j = 0; j < n; j += 11)
+        {
+            double s{0};
+            for(size_t k = 0; k < n; ++k)
+                s += a[i * n + k] * a[k * n + j];
+            QVERIFY( std::abs(sq[i * n + j] - s) < 1e-9 * n );
+        }
+    }
+
+    setStack( encode(n, n, a) );
+    command("minv")->execute();
+    vector<double> inv(n * n + 2);
+    stack.peekElements(inv.size(), inv.data());
+    for(size_t i = 0; i < n; i += 13)
+    {
+        double s{0};
+        for(size_t k = 0; k < n; ++k)
+            s += a[i * n + k] * inv[k * n + i];
+        QVERIFY( std::abs(s - 1.0) < 1e-10 );
+    }
+
+    stack.clear();
+
+    return;
+}
@@ -0,0 +1,351 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "RandomPluginTest.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "utilities/UserInterface.h"
+#include "backend/Stack.h"
+#include "utilities/Exception.h"
+#include "backend/Command.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+using std::map;
+using std::string;
+using std::vector;
+using pdCalc::Plugin;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    TestInterface() { }
+    void postMessage(const string&) override {  }
+    void stackChanged() override { }
+};
+
+// the loader must outlive the commands taken from its plugins
+TestInterface ui;
+std::unique_ptr<pdCalc::PluginLoader> loader;
+
+// the generator as documented, one value at a time: block b interleaves four
+// xoshiro256++ streams seeded from outputs 16 b + 4 k, ..., 16 b + 4 k + 3 of the
+// seed's splitmix64 sequence
+uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+vector<double> referenceUniforms(uint64_t seed, size_t n)
+{
+    const uint64_t gamma{0x9E3779B97F4A7C15ULL};
+    const size_t blockSize{2048};
+
+    vector<double> x;
+    for(uint64_t b = 0; x.size() < n; ++b)
+    {
+        uint64_t s[4][4];
+        for(uint64_t k = 0; k < 4; ++k)
+        {
+            uint64_t state{ mix(seed) + (4 * b + k) * 4 * gamma };
+            for(int i = 0; i < 4; ++i)
+            {
+                state += gamma;
+                s[k][i] = mix(state);
+            }
+        }
+
+        for(size_t j = 0; j < blockSize && x.size() < n; ++j)
+        {
+            uint64_t* t = s[j % 4];
+            uint64_t r{ rotl(t[0] + t[3], 23) + t[0] };
+            uint64_t u{ t[1] << 17 };
+            t[2] ^= t[0];
+            t[3] ^= t[1];
+            t[1] ^= t[2];
+            t[0] ^= t[3];
+            t[2] ^= u;
+            t[3] = rotl(t[3], 45);
+
+            x.push_back( std::ldexp( static_cast<double>(r >> 12), -52 ) );
+        }
+    }
+
+    return x;
+}
+
+double mean(const vector<double>& x)
+{
+    double s{0};
+    for(auto v : x) s += v;
+    return s / x.size();
+}
+
+double variance(const vector<double>& x)
+{
+    double m{ mean(x) };
+    double s{0};
+    for(auto v : x) s += (v - m) * (v - m);
+    return s / (x.size() - 1);
+}
+
+}
+
+void RandomPluginTest::initTestCase()
+{
+    loader = std::make_unique<pdCalc::PluginLoader>();
+
+    string pluginFile{PLUGIN_TEST_DIR};
+    pluginFile += "/";
+    pluginFile += RANDOM_PLUGIN_TEST_FILE;
+    loader->loadPlugins(ui, pluginFile);
+
+    vector<const Plugin*> plugins{ loader->getPlugins() };
+    QVERIFY(plugins.size() == 1);
+
+    Plugin::PluginDescriptor descriptor = plugins[0]->getPluginDescriptor();
+    for(int i = 0; i < descriptor.nCommands; ++i)
+        commands_[descriptor.commandNames[i]] = descriptor.commands[i];
+
+    return;
+}
+
+void RandomPluginTest::cleanupTestCase()
+{
+    commands_.clear();
+    loader.reset();
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+pdCalc::Command* RandomPluginTest::command(const string& name) const
+{
+    auto i = commands_.find(name);
+    return i == commands_.end() ? nullptr : i->second;
+}
+
+void RandomPluginTest::seed(double s)
+{
+    pdCalc::Stack::Instance().push(s);
+    command("seed")->execute();
+
+    return;
+}
+
+// the n samples a command pushes, which it leaves on the stack
+vector<double> RandomPluginTest::sample(const string& name, size_t n)
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.push( static_cast<double>(n) );
+    command(name)->execute();
+
+    vector<double> x(n);
+    stack.peekElements(n, x.data());
+
+    return x;
+}
+
+void RandomPluginTest::testDescriptor()
+{
+    QCOMPARE( commands_.size(), size_t{4} );
+
+    for(auto name : {"rand", "randn", "rande", "seed"})
+        QVERIFY( command(name) != nullptr );
+
+    return;
+}
+
+void RandomPluginTest::testGenerator()
+{
+    pdCalc::Stack::Instance().clear();
+
+    // three blocks, the last partial, and a second command starting a new block
+    seed(20161101);
+    vector<double> x{ sample("rand", 5000) };
+    vector<double> y{ sample("rand", 7) };
+
+    vector<double> reference{ referenceUniforms(20161101, 3 * 2048 + 7) };
+    QVERIFY( std::equal(x.begin(), x.end(), reference.begin()) );
+    QVERIFY( std::equal(y.begin(), y.end(), reference.begin() + 3 * 2048) );
+
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+void RandomPluginTest::testReproducible()
+{
+    pdCalc::Stack::Instance().clear();
+
+    for(auto name : {"rand", "randn", "rande"})
+    {
+        seed(42);
+        vector<double> a{ sample(name, 100000) };
+        vector<double> b{ sample(name, 3) };
+
+        seed(42);
+        QCOMPARE( sample(name, 100000), a );
+        QCOMPARE( sample(name, 3), b );
+
+        seed(43);
+        QVERIFY( sample(name, 3) != vector<double>(a.begin(), a.begin() + 3) );
+    }
+
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+void RandomPluginTest::testUndoRedo()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    stack.push(-1.0);
+
+    seed(9);
+    stack.push(1000.0);
+    pdCalc::Command* c{ command("randn")->clone() };
+    c->execute();
+    QCOMPARE( stack.size(), size_t{1001} );
+    vector<double> first( stack.size() );
+    stack.peekElements(first.size(), first.data());
+
+    // undo returns the count and rewinds the generator, so a redo repeats the samples
+    c->undo();
+    QCOMPARE( stack.size(), size_t{2} );
+    QCOMPARE( stack.getElements(1)[0], 1000.0 );
+
+    c->execute();
+    vector<double> again( stack.size() );
+    stack.peekElements(again.size(), again.data());
+    QCOMPARE(again, first);
+    c->deallocate();
+
+    // undoing a seed restores the generator it replaced
+    vector<double> next{ sample("randn", 5) };
+    stack.push(123.0);
+    pdCalc::Command* s{ command("seed")->clone() };
+    s->execute();
+    s->undo();
+    QCOMPARE( stack.getElements(1)[0], 123.0 );
+    stack.pop();
+    s->deallocate();
+
+    stack.clear();
+    seed(9);
+    sample("randn", 1000);
+    QCOMPARE( sample("randn", 5), next );
+
+    stack.clear();
+
+    return;
+}
+
+void RandomPluginTest::testDistributions()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    seed(1);
+
+    const size_t n{1000000};
+
+    vector<double> u{ sample("rand", n) };
+    QVERIFY( *std::min_element(u.begin(), u.end()) >= 0.0 );
+    QVERIFY( *std::max_element(u.begin(), u.end()) < 1.0 );
+    QVERIFY( std::fabs(mean(u) - 0.5) < 0.002 );
+    QVERIFY( std::fabs(variance(u) - 1.0 / 12.0) < 0.001 );
+    stack.clear();
+
+    vector<double> z{ sample("randn", n) };
+    QVERIFY( std::fabs(mean(z)) < 0.005 );
+    QVERIFY( std::fabs(variance(z) - 1.0) < 0.01 );
+    size_t within{0};
+    for(auto v : z) within += std::fabs(v) < 1.0;
+    QVERIFY( std::fabs(within / static_cast<double>(n) - 0.6826895) < 0.002 );
+    stack.clear();
+
+    vector<double> e{ sample("rande", n) };
+    QVERIFY( *std::min_element(e.begin(), e.end()) >= 0.0 );
+    QVERIFY( std::fabs(mean(e) - 1.0) < 0.005 );
+    QVERIFY( std::fabs(variance(e) - 1.0) < 0.02 );
+    stack.clear();
+
+    return;
+}
+
+void RandomPluginTest::testPreconditions()
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    for(auto name : {"rand", "randn", "rande", "seed"})
+    {
+        for(double top : {-1.0, 2.5, std::nan("")})
+        {
+            stack.clear();
+            stack.push(top);
+            try
+            {
+                command(name)->execute();
+                QVERIFY(false);
+            }
+            catch(pdCalc::Exception&)
+            {
+                QCOMPARE( stack.size(), size_t{1} );
+            }
+        }
+
+        stack.clear();
+        try
+        {
+            command(name)->execute();
+            QVERIFY(false);
+        }
+        catch(pdCalc::Exception&)
+        {
+            QVERIFY(true);
+        }
+    }
+
+    stack.push(0.0);
+    try
+    {
+        command("rand")->execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception& e)
+    {
+        QCOMPARE( e.what(), string{"Count must be a positive integer"} );
+    }
+
+    stack.clear();
+
+    return;
+}
@@ -0,0 +1,268 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StatisticsPluginTest.h"
+#include "backend/PluginLoader.h"
+#include "backend/Plugin.h"
+#include "utilities/UserInterface.h"
+#include "backend/Stack.h"
+#include "utilities/Exception.h"
+#include "backend/Command.h"
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+using std::map;
+using std::string;
+using std::vector;
+using pdCalc::Plugin;
+
+namespace {
+
+class TestInterface : public pdCalc::UserInterface
+{
+public:
+    TestInterface() { }
+    void postMessage(const string&) override {  }
+    void stackChanged() override { }
+};
+
+// the loader must outlive the commands taken from its plugins
+TestInterface ui;
+std::unique_ptr<pdCalc::PluginLoader> loader;
+
+}
+
+void StatisticsPluginTest::initTestCase()
+{
+    loader = std::make_unique<pdCalc::PluginLoader>();
+
+    string pluginFile{PLUGIN_TEST_DIR};
+    pluginFile += "/";
+    pluginFile += STATISTICS_PLUGIN_TEST_FILE;
+    loader->loadPlugins(ui, pluginFile);
+
+    vector<const Plugin*> plugins{ loader->getPlugins() };
+    QVERIFY(plugins.size() == 1);
+
+    Plugin::PluginDescriptor descriptor = plugins[0]->getPluginDescriptor();
+    for(int i = 0; i < descriptor.nCommands; ++i)
+        commands_[descriptor.commandNames[i]] = descriptor.commands[i];
+
+    return;
+}
+
+void StatisticsPluginTest::cleanupTestCase()
+{
+    commands_.clear();
+    loader.reset();
+    pdCalc::Stack::Instance().clear();
+
+    return;
+}
+
+pdCalc::Command* StatisticsPluginTest::command(const string& name) const
+{
+    auto i = commands_.find(name);
+    return i == commands_.end() ? nullptr : i->second;
+}
+
+void StatisticsPluginTest::setStack(const vector<double>& v)
+{
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    stack.clear();
+    for(auto d : v)
+        stack.push(d, true);
+
+    return;
+}
+
+// executes the command on the given stack (bottom first), checks that the whole
+// operation left one result in place of its operands, and that a single undo
+// restores the stack exactly
+void StatisticsPluginTest::testReduction(const string& name, const vector<double>& v, double result)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack(v);
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    c->execute();
+
+    vector<double> top{ stack.getElements(1) };
+    QVERIFY( std::abs(top[0] - result) <= 1e-12 * std::max(1.0, std::abs(result)) );
+
+    c->undo();
+
+    vector<double> restored{ stack.getElements( stack.size() ) };
+    vector<double> expected{ v.rbegin(), v.rend() };
+    QCOMPARE(restored, expected);
+
+    return;
+}
+
+void StatisticsPluginTest::testFails(const string& name, const vector<double>& v)
+{
+    pdCalc::Command* c{ command(name) };
+    QVERIFY(c != nullptr);
+
+    setStack(v);
+    try
+    {
+        c->execute();
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    QVERIFY( pdCalc::Stack::Instance().size() == v.size() );
+
+    return;
+}
+
+void StatisticsPluginTest::testDescriptor()
+{
+    QCOMPARE( commands_.size(), size_t{14} );
+
+    for(auto name : {"sum", "mean", "var", "min", "max", "median", "pctl"})
+    {
+        QVERIFY( command(name) != nullptr );
+        QVERIFY( command( string{name} + "n" ) != nullptr );
+    }
+
+    return;
+}
+
+void StatisticsPluginTest::testWholeStack()
+{
+    vector<double> v{2, 4, 4, 4, 5, 5, 7, 9};
+
+    testReduction("sum", v, 40.0);
+    testReduction("mean", v, 5.0);
+    testReduction("var", v, 32.0 / 7.0);
+    testReduction("min", v, 2.0);
+    testReduction("max", v, 9.0);
+    testReduction("median", v, 4.5);
+    testReduction("median", {3, 1, 2}, 2.0);
+    testReduction("min", {-1.5}, -1.5);
+
+    return;
+}
+
+void StatisticsPluginTest::testTopN()
+{
+    // elements below the n are left alone
+    testReduction("sumn", {100, 1, 2, 3, 3}, 6.0);
+    testReduction("meann", {100, 1, 2, 3, 3}, 2.0);
+    testReduction("varn", {100, 1, 2, 3, 3}, 1.0);
+    testReduction("minn", {-100, 1, 2, 3, 3}, 1.0);
+    testReduction("maxn", {100, 1, 2, 3, 3}, 3.0);
+    testReduction("mediann", {100, 7, 1, 5, 3, 4}, 4.0);
+    testReduction("sumn", {1, 2, 3, 3}, 6.0);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+    setStack({100, 1, 2, 3, 3});
+    command("sumn")->execute();
+    QVERIFY( stack.size() == 2 );
+    QCOMPARE( stack.getElements(2)[1], 100.0 );
+
+    return;
+}
+
+void StatisticsPluginTest::testPercentile()
+{
+    testReduction("pctl", {5, 1, 4, 2, 3, 25}, 2.0);
+    testReduction("pctl", {5, 1, 4, 2, 3, 0}, 1.0);
+    testReduction("pctl", {5, 1, 4, 2, 3, 100}, 5.0);
+    testReduction("pctl", {1, 2, 3, 4, 90}, 3.7);
+    testReduction("pctln", {100, 5, 1, 4, 2, 3, 50, 5}, 3.0);
+
+    return;
+}
+
+void StatisticsPluginTest::testPreconditions()
+{
+    testFails("sum", {});
+    testFails("var", {1});
+    testFails("sumn", {});
+    testFails("sumn", {1, 2, 3});
+    testFails("sumn", {1, 2, 1.5});
+    testFails("sumn", {1, 2, 0});
+    testFails("sumn", {1, 2, -1});
+    testFails("varn", {1, 2, 1});
+    testFails("pctl", {1, 2, -1});
+    testFails("pctl", {1, 2, 101});
+    testFails("pctl", {50});
+    testFails("pctln", {1, 2, 50, 3});
+
+    return;
+}
+
+// large enough to take the parallel path
+void StatisticsPluginTest::testLargeInput()
+{
+    const size_t n = 300001;
+    std::mt19937_64 gen{42};
+    std::uniform_real_distribution<double> dist{-1.0, 3.0};
+
+    vector<double> v(n);
+    long double sum{0};
+    for(auto& x : v)
+    {
+        x = dist(gen);
+        sum += x;
+    }
+    double lo{ *std::min_element(v.begin(), v.end()) };
+    double hi{ *std::max_element(v.begin(), v.end()) };
+
+    long double mean{ sum / n };
+    long double ss{0};
+    for(auto x : v)
+        ss += (x - mean) * (x - mean);
+
+    pdCalc::Stack& stack = pdCalc::Stack::Instance();
+
+    setStack(v);
+    command("sum")->execute();
+    QVERIFY( std::abs( stack.getElements(1)[0] - static_cast<double>(sum) ) < 1e-9 );
+    command("sum")->undo();
+    QVERIFY( stack.size() == n );
+
+    setStack(v);
+    command("var")->execute();
+    QVERIFY( std::abs( stack.getElements(1)[0] - static_cast<double>( ss / (n - 1) ) ) < 1e-12 );
+
+    setStack(v);
+    command("min")->execute();
+    QCOMPARE( stack.getElements(1)[0], lo );
+
+    setStack(v);
+    command("max")->execute();
+    QCOMPARE( stack.getElements(1)[0], hi );
+
+    // a long run of 0.1 drifts visibly with a running sum
+    testReduction("sum", vector<double>(n, 0.1), 30000.1);
+
+    stack.clear();
+
+    return;
+}
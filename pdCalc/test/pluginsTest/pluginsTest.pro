@@ -10,11 +10,27 @@ win32:DESTDIR = $$HOME/bin
 DEFINES += PLUGIN_TEST_DIR=\\\"$$PWD\\\"
 unix:DEFINES += PLUGIN_TEST_FILE=\\\"plugins.unix.pdp\\\"
 win32:DEFINES += PLUGIN_TEST_FILE=\\\"plugins.win.pdp\\\"
+unix:DEFINES += STATISTICS_PLUGIN_TEST_FILE=\\\"statisticsPlugin.unix.pdp\\\"
+win32:DEFINES += STATISTICS_PLUGIN_TEST_FILE=\\\"statisticsPlugin.win.pdp\\\"
+unix:DEFINES += MATRIX_PLUGIN_TEST_FILE=\\\"matrixPlugin.unix.pdp\\\"
+win32:DEFINES += MATRIX_PLUGIN_TEST_FILE=\\\"matrixPlugin.win.pdp\\\"
+unix:DEFINES += FFT_PLUGIN_TEST_FILE=\\\"fftPlugin.unix.pdp\\\"
+win32:DEFINES += FFT_PLUGIN_TEST_FILE=\\\"fftPlugin.win.pdp\\\"
+unix:DEFINES += RANDOM_PLUGIN_TEST_FILE=\\\"randomPlugin.unix.pdp\\\"
+win32:DEFINES += RANDOM_PLUGIN_TEST_FILE=\\\"randomPlugin.win.pdp\\\"
 
 QT += testlib
 
 # Input
-HEADERS += HyperbolicLnPluginTest.h
-SOURCES += HyperbolicLnPluginTest.cpp
+HEADERS += HyperbolicLnPluginTest.h \
+    StatisticsPluginTest.h \
+    MatrixPluginTest.h \
+    FftPluginTest.h \
+    RandomPluginTest.h
+SOURCES += HyperbolicLnPluginTest.cpp \
+    StatisticsPluginTest.cpp \
+    MatrixPluginTest.cpp \
+    FftPluginTest.cpp \
+    RandomPluginTest.cpp
 unix:LIBS += -L$$HOME/lib -lpdCalcUtilities -lpdCalcBackend
 win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1 -lpdCalcBackend1
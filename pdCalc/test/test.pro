@@ -5,4 +5,6 @@ SUBDIRS += utilitiesTest \
            cliTest \
            guiTest \
            pluginsTest \
+           benchmark \
+           perfGate \
            testDriver
@@ -19,24 +19,74 @@
 #include <QtTest/QtTest>
 #include "../utilitiesTest/PublisherObserverTest.h"
 #include "../utilitiesTest/TokenizerTest.h"
+#include "../utilitiesTest/ThreadPoolTest.h"
+#include "../utilitiesTest/BigNumberTest.h"
+#include "../utilitiesTest/VectorMathTest.h"
+#include "../utilitiesTest/BlockAlgorithmsTest.h"
+#include "../utilitiesTest/NumberParsingTest.h"
+#include "../utilitiesTest/StackChangeTest.h"
+#include "../utilitiesTest/PerfGateTest.h"
 #include "../pluginsTest/HyperbolicLnPluginTest.h"
+#include "../pluginsTest/StatisticsPluginTest.h"
+#include "../pluginsTest/MatrixPluginTest.h"
+#include "../pluginsTest/FftPluginTest.h"
+#include "../pluginsTest/RandomPluginTest.h"
 #include "../guiTest/DisplayTest.h"
+#include "../guiTest/MainWindowTest.h"
 #include "../cliTest/CliTest.h"
 #include "../backendTest/CommandDispatcherTest.h"
 #include "../backendTest/CommandManagerTest.h"
 #include "../backendTest/CommandRepositoryTest.h"
 #include "../backendTest/CoreCommandsTest.h"
 #include "../backendTest/PluginLoaderTest.h"
+#include "../backendTest/PluginHostTest.h"
+#include "../backendTest/StaticPluginRegistryTest.h"
 #include "../backendTest/StackTest.h"
 #include "../backendTest/StoredProcedureTest.h"
+#include "../backendTest/ProcedureOptimizerTest.h"
+#include "../backendTest/MapProcedureTest.h"
+#include "../backendTest/StackSnapshotTest.h"
+#include "../backendTest/JournalTest.h"
+#include "../backendTest/SpilledHistoryTest.h"
+#include "../backendTest/ImportNumbersTest.h"
+#include "../backendTest/CommandWorkerTest.h"
+#include "../backendTest/AllocationTest.h"
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
 #include <QStringList>
 #include <unordered_map>
 
 using std::cout;
 using std::endl;
 
+namespace {
+
+// Optional stage enabled with --perf-gate. Runs the benchmark suite and compares
+// its report against the stored baseline. Timings are machine dependent, so this
+// stage is not part of the default run; regenerate the baseline on the reference
+// machine with perfGate --update.
+int runPerfGate()
+{
+    std::ostringstream cmd;
+#ifdef WIN32
+    cmd << "benchmarkPdCalc --json perfResults.json && perfGate perfResults.json ";
+#else
+    cmd << "./benchmarkPdCalc --json perfResults.json && ./perfGate perfResults.json ";
+#endif
+    cmd << "\"" << PERF_GATE_BASELINE << "\"";
+
+    cout << "********* Start perf gate *********" << endl;
+    int result = system( cmd.str().c_str() );
+    cout << "********* Finished perf gate *********" << endl;
+
+    return result == 0 ? 0 : 1;
+}
+
+}
+
 int main(int argc, char* argv[])
 {
     // I use QStringList instead of argv directly because the QStringList
@@ -44,8 +94,12 @@ int main(int argc, char* argv[])
     // version, it may alter argv making repeated calls to qExec unstable
     // with respect to the arguments.
     QStringList args;
+    bool perfGate{false};
     for(int i = 0; i < argc; ++i)
-        args.append( QString{argv[i]} );
+    {
+        if(std::string{argv[i]} == "--perf-gate") perfGate = true;
+        else args.append( QString{argv[i]} );
+    }
 
     std::unordered_map<std::string, int> passFail;
 
@@ -55,12 +109,48 @@ int main(int argc, char* argv[])
     TokenizerTest tt;
     passFail["TokenizerTest"] = QTest::qExec(&tt, args);
 
+    ThreadPoolTest tpt;
+    passFail["ThreadPoolTest"] = QTest::qExec(&tpt, args);
+
+    BigNumberTest bnt;
+    passFail["BigNumberTest"] = QTest::qExec(&bnt, args);
+
+    VectorMathTest vmt;
+    passFail["VectorMathTest"] = QTest::qExec(&vmt, args);
+
+    BlockAlgorithmsTest bat;
+    passFail["BlockAlgorithmsTest"] = QTest::qExec(&bat, args);
+
+    NumberParsingTest npt;
+    passFail["NumberParsingTest"] = QTest::qExec(&npt, args);
+
+    StackChangeTest sct;
+    passFail["StackChangeTest"] = QTest::qExec(&sct, args);
+
+    PerfGateTest pgt;
+    passFail["PerfGateTest"] = QTest::qExec(&pgt, args);
+
     HyperbolicLnPluginTest hpt;
     passFail["HyperbolicPluginTest"] = QTest::qExec(&hpt, args);
 
+    StatisticsPluginTest stpt;
+    passFail["StatisticsPluginTest"] = QTest::qExec(&stpt, args);
+
+    MatrixPluginTest mpt;
+    passFail["MatrixPluginTest"] = QTest::qExec(&mpt, args);
+
+    FftPluginTest fpt;
+    passFail["FftPluginTest"] = QTest::qExec(&fpt, args);
+
+    RandomPluginTest rpt;
+    passFail["RandomPluginTest"] = QTest::qExec(&rpt, args);
+
     DisplayTest dt;
     passFail["DisplayTest"] = QTest::qExec(&dt, args);
 
+    MainWindowTest mwt;
+    passFail["MainWindowTest"] = QTest::qExec(&mwt, args);
+
     CliTest ct;
     passFail["CliTest"] = QTest::qExec(&ct, args);
 
@@ -79,12 +169,45 @@ int main(int argc, char* argv[])
     PluginLoaderTest plt;
     passFail["PluginLoaderTest"] = QTest::qExec(&plt, args);
 
+    PluginHostTest pht;
+    passFail["PluginHostTest"] = QTest::qExec(&pht, args);
+
+    StaticPluginRegistryTest sprt;
+    passFail["StaticPluginRegistryTest"] = QTest::qExec(&sprt, args);
+
     StackTest st;
     passFail["StackTest"] = QTest::qExec(&st, args);
 
     StoredProcedureTest spt;
     passFail["StoredProcedureTest"] = QTest::qExec(&spt, args);
 
+    ProcedureOptimizerTest opt;
+    passFail["ProcedureOptimizerTest"] = QTest::qExec(&opt, args);
+
+    MapProcedureTest mapt;
+    passFail["MapProcedureTest"] = QTest::qExec(&mapt, args);
+
+    StackSnapshotTest sst;
+    passFail["StackSnapshotTest"] = QTest::qExec(&sst, args);
+
+    JournalTest jt;
+    passFail["JournalTest"] = QTest::qExec(&jt, args);
+
+    SpilledHistoryTest sht;
+    passFail["SpilledHistoryTest"] = QTest::qExec(&sht, args);
+
+    ImportNumbersTest int_;
+    passFail["ImportNumbersTest"] = QTest::qExec(&int_, args);
+
+    CommandWorkerTest cwt;
+    passFail["CommandWorkerTest"] = QTest::qExec(&cwt, args);
+
+    AllocationTest at;
+    passFail["AllocationTest"] = QTest::qExec(&at, args);
+
+    if(perfGate)
+        passFail["PerfGate"] = runPerfGate();
+
     cout << endl;
     int errors = 0;
     for(const auto& i : passFail)
@@ -5,6 +5,7 @@ TEMPLATE = app
 TARGET = testPdCalc
 INCLUDEPATH += $$HOME $$HOME/src
 DESTDIR = $$HOME/bin
+DEFINES += PERF_GATE_BASELINE=\\\"$$PWD/../perfGate/baselines/baselineBenchmark.json\\\"
 
 QT += testlib
 
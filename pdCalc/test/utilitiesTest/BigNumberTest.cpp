@@ -0,0 +1,212 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "BigNumberTest.h"
+#include "src/utilities/BigNumber.h"
+#include "src/utilities/Exception.h"
+#include <string>
+
+using std::string;
+using pdCalc::BigInteger;
+using pdCalc::BigFloat;
+
+namespace {
+
+// 10^n - 1
+BigInteger Nines(size_t n)
+{
+    return BigInteger{ string(n, '9') };
+}
+
+// a deterministic n digit number with no long runs, so that every limb differs
+BigInteger Digits(size_t n, unsigned seed)
+{
+    string s(n, '0');
+    unsigned x{seed};
+    for(auto& c : s)
+    {
+        x = x * 1103515245u + 12345u;
+        c = static_cast<char>( '0' + (x >> 16) % 10 );
+    }
+    s[0] = '7';
+
+    return BigInteger{s};
+}
+
+}
+
+void BigNumberTest::testIntegerArithmetic()
+{
+    BigInteger a{ string{"123456789012345678901234567890"} };
+    BigInteger b{-987654321};
+
+    QCOMPARE( (a + b).toString(), string{"123456789012345678900246913569"} );
+    QCOMPARE( (b - a).toString(), string{"-123456789012345678902222222211"} );
+    QCOMPARE( (a * b).toString(), string{"-121932631124828532112482853211126352690"} );
+    QCOMPARE( (a / b).toString(), string{"-124999998873437499901"} );
+    QCOMPARE( (a % b).toString(), string{"574845669"} );
+
+    // carries and borrows across every limb
+    QCOMPARE( (Nines(45) + BigInteger{1}).toString(), "1" + string(45, '0') );
+    QCOMPARE( (BigInteger{ "1" + string(45, '0') } - BigInteger{1}).toString(), string(45, '9') );
+
+    QVERIFY( BigInteger{0}.isZero() );
+    QVERIFY( !(a - a).negative() );
+    QVERIFY( b < BigInteger{0} && a > b );
+    QCOMPARE( BigInteger::Pow(BigInteger{3}, 40).toString(), string{"12157665459056928801"} );
+
+    try
+    {
+        BigInteger{ string{"12a"} };
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    return;
+}
+
+void BigNumberTest::testLargeMultiply()
+{
+    // (10^n - 1)^2 = 10^2n - 2 10^n + 1 at sizes taking the schoolbook, Karatsuba
+    // and number theoretic transform paths
+    for(size_t n : {100, 2000, 60000})
+    {
+        string expected{ string(n - 1, '9') + "8" + string(n - 1, '0') + "1" };
+        QCOMPARE( (Nines(n) * Nines(n)).toString(), expected );
+    }
+
+    // the paths agree on unbalanced, irregular operands
+    BigInteger a{ Digits(50000, 1) };
+    BigInteger b{ Digits(7000, 2) };
+    BigInteger c{ Digits(300, 3) };
+    QVERIFY( a * (b + c) == a * b + a * c );
+    QVERIFY( (a * b) * c == a * (b * c) );
+
+    return;
+}
+
+void BigNumberTest::testDivision()
+{
+    // both the schoolbook and Newton paths must leave 0 <= r < b with a = q b + r
+    for(size_t n : {30, 1000, 9000})
+    {
+        BigInteger a{ Digits(3 * n, 4) };
+        BigInteger b{ Digits(n, 5) };
+        BigInteger q, r;
+        BigInteger::DivMod(a, b, q, r);
+
+        QVERIFY( q * b + r == a );
+        QVERIFY( !r.negative() && r < b );
+    }
+
+    // a quotient that is a power of the limb base less one
+    BigInteger q, r;
+    BigInteger::DivMod(Nines(7200), Nines(3600), q, r);
+    QCOMPARE( q.toString(), "1" + string(3599, '0') + "1" );
+    QVERIFY( r.isZero() );
+
+    try
+    {
+        BigInteger::DivMod(Nines(10), BigInteger{0}, q, r);
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    return;
+}
+
+void BigNumberTest::testRoot()
+{
+    BigInteger x{ Digits(3000, 6) };
+    for(unsigned n : {2, 3, 7})
+    {
+        BigInteger p{ BigInteger::Pow(x, n) };
+        QVERIFY( BigInteger::Root(p, n) == x );
+        QVERIFY( BigInteger::Root(p - BigInteger{1}, n) == x - BigInteger{1} );
+    }
+
+    QCOMPARE( BigInteger::Root(BigInteger{1000000}, 2).toString(), string{"1000"} );
+    QCOMPARE( BigInteger::Root(BigInteger{999999}, 2).toString(), string{"999"} );
+
+    return;
+}
+
+void BigNumberTest::testFloatConversions()
+{
+    QCOMPARE( BigFloat::FromString("0.1", 20).toString(), string{"0.1"} );
+    QCOMPARE( BigFloat::FromString("-1.25e-30", 20).toString(), string{"-1.25e-30"} );
+    QCOMPARE( BigFloat::FromString("1200", 20).toString(), string{"1200"} );
+    QCOMPARE( BigFloat::FromString("1e40", 20).toString(), string{"1e40"} );
+
+    // rounding to the precision is half to even
+    QCOMPARE( BigFloat::FromString("123456", 3).toString(), string{"123000"} );
+    QCOMPARE( BigFloat::FromString("2.5", 1).toString(), string{"2"} );
+    QCOMPARE( BigFloat::FromString("3.5", 1).toString(), string{"4"} );
+
+    // doubles convert to their shortest round trip decimal
+    QCOMPARE( BigFloat::FromDouble(0.1).toString(), string{"0.1"} );
+    QCOMPARE( BigFloat::FromDouble(-1.5e300).toDouble(), -1.5e300 );
+    QCOMPARE( BigFloat::FromString("0.1", 40).toDouble(), 0.1 );
+
+    long long n;
+    QVERIFY( BigFloat::FromString("-42e3", 10).toInteger(n) && n == -42000 );
+    QVERIFY( !BigFloat::FromString("4.2", 10).toInteger(n) );
+
+    try
+    {
+        BigFloat::FromString("1.2.3", 10);
+        QVERIFY(false);
+    }
+    catch(pdCalc::Exception&)
+    {
+        QVERIFY(true);
+    }
+
+    return;
+}
+
+void BigNumberTest::testFloatArithmetic()
+{
+    BigFloat one{ BigInteger{1}, 0 };
+    BigFloat two{ BigInteger{2}, 0 };
+
+    QCOMPARE( BigFloat::Add(BigFloat::FromString("0.1", 50), BigFloat::FromString("0.2", 50), 50).toString(), string{"0.3"} );
+    QCOMPARE( BigFloat::Subtract(one, BigFloat::FromString("1e-60", 70), 70).toString(), "0." + string(60, '9') );
+    QCOMPARE( BigFloat::Subtract(one, BigFloat::FromString("1e-60", 70), 50).toString(), string{"1"} );
+    QCOMPARE( BigFloat::Multiply(BigFloat::FromString("1.5", 10), BigFloat::FromString("-0.25", 10), 10).toString(), string{"-0.375"} );
+    QCOMPARE( BigFloat::Divide(one, BigFloat{BigInteger{3}, 0}, 30).toString(), "0." + string(30, '3') );
+    QCOMPARE( BigFloat::Divide(two, BigFloat{BigInteger{3}, 0}, 5).toString(), string{"0.66667"} );
+
+    QCOMPARE( BigFloat::Pow(two, 100, 50).toString(), string{"1267650600228229401496703205376"} );
+    QCOMPARE( BigFloat::Pow(two, -3, 50).toString(), string{"0.125"} );
+    QCOMPARE( BigFloat::Root(two, 2, 50).toString(), string{"1.4142135623730950488016887242096980785696718753769"} );
+    QCOMPARE( BigFloat::Root(BigFloat{BigInteger{-27}, 0}, 3, 50).toString(), string{"-3"} );
+
+    // a 10000 digit square root squares back to within the last digit
+    BigFloat r{ BigFloat::Root(two, 2, 10000) };
+    BigFloat err{ BigFloat::Subtract(BigFloat::Multiply(r, r, 10010), two, 10010) };
+    QVERIFY( err.isZero() || err.exponent() + static_cast<long long>(err.mantissa().nDigits()) <= -9998 );
+
+    return;
+}
@@ -0,0 +1,195 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockAlgorithmsTest.h"
+#include "src/utilities/BlockAlgorithms.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+using std::vector;
+namespace BlockAlgorithms = pdCalc::BlockAlgorithms;
+
+namespace {
+
+// a mix of magnitudes and signs with many repeats
+vector<double> randomBlock(size_t n, unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+    std::uniform_int_distribution<int> small{-50, 50};
+    std::normal_distribution<double> normal{0.0, 1e6};
+
+    vector<double> x(n);
+    for(size_t i = 0; i < n; ++i)
+        x[i] = i % 3 == 0 ? small(gen) : normal(gen);
+
+    return x;
+}
+
+bool sameBits(const vector<double>& a, const vector<double>& b)
+{
+    return a.size() == b.size() && std::memcmp( a.data(), b.data(), a.size() * sizeof(double) ) == 0;
+}
+
+}
+
+void BlockAlgorithmsTest::testSort()
+{
+    // either side of the radix threshold, and large enough to run in parallel
+    for(size_t n : {size_t{100}, BlockAlgorithms::RadixThreshold, size_t{300001}})
+    {
+        vector<double> x{ randomBlock(n, 7) };
+        vector<double> expected{x};
+        std::sort( expected.begin(), expected.end() );
+
+        BlockAlgorithms::Sort( x.data(), x.size() );
+        QCOMPARE(x, expected);
+    }
+
+    return;
+}
+
+void BlockAlgorithmsTest::testSortSpecialValues()
+{
+    const double inf{ std::numeric_limits<double>::infinity() };
+    const double denormal{ std::numeric_limits<double>::denorm_min() };
+
+    vector<double> expected{-inf, -1e300, -1.0, -denormal, -0.0, 0.0, denormal, 1.0, 1e300, inf};
+    for(size_t repeat : {size_t{1}, size_t{100}})
+    {
+        vector<double> x;
+        for(size_t r = 0; r < repeat; ++r)
+            x.insert( x.end(), expected.rbegin(), expected.rend() );
+
+        BlockAlgorithms::Sort( x.data(), x.size() );
+
+        vector<double> sorted;
+        for(double d : expected)
+            sorted.insert( sorted.end(), repeat, d );
+        QVERIFY( sameBits(x, sorted) );
+    }
+
+    return;
+}
+
+void BlockAlgorithmsTest::testUnique()
+{
+    for(size_t n : {size_t{100}, size_t{300001}})
+    {
+        vector<double> x{ randomBlock(n, 11) };
+
+        vector<double> expected;
+        std::set<double> seen;
+        for(double d : x)
+        {
+            if( seen.insert(d).second )
+                expected.push_back(d);
+        }
+
+        size_t m{ BlockAlgorithms::Unique( x.data(), x.size() ) };
+        x.resize(m);
+        QVERIFY( sameBits(x, expected) );
+    }
+
+    // the first of -0 and +0 stands for both
+    vector<double> zeros{-0.0, 1.0, 0.0, -0.0};
+    QCOMPARE( BlockAlgorithms::Unique( zeros.data(), zeros.size() ), size_t{2} );
+    QVERIFY( std::signbit(zeros[0]) );
+
+    return;
+}
+
+void BlockAlgorithmsTest::testPrefixScans()
+{
+    // within a block the scans are the sequential loop exactly
+    vector<double> x{ randomBlock(BlockAlgorithms::ScanBlock, 3) };
+    vector<double> sums{x};
+    BlockAlgorithms::PrefixSum( sums.data(), sums.size() );
+    double s{0};
+    bool exact{true};
+    for(size_t i = 0; i < x.size(); ++i)
+    {
+        s = i == 0 ? x[0] : s + x[i];
+        exact = exact && sums[i] == s;
+    }
+    QVERIFY(exact);
+
+    // across blocks, each block's sums are offset by the sum of the blocks before
+    // it, which agrees with a long double loop to rounding
+    const size_t n{ 40 * BlockAlgorithms::ScanBlock + 17 };
+    x = randomBlock(n, 5);
+    sums = x;
+    BlockAlgorithms::PrefixSum( sums.data(), sums.size() );
+    long double reference{0};
+    double maxError{0};
+    for(size_t i = 0; i < n; ++i)
+    {
+        reference += x[i];
+        maxError = std::max( maxError, static_cast<double>( std::fabs(sums[i] - reference) ) );
+    }
+    QVERIFY( maxError < 1e-3 );
+
+    // products of factors near one stay finite over many blocks
+    vector<double> factors(n);
+    std::mt19937_64 gen{9};
+    std::uniform_real_distribution<double> near{0.9999, 1.0001};
+    for(auto& f : factors)
+        f = near(gen);
+    vector<double> products{factors};
+    BlockAlgorithms::PrefixProduct( products.data(), products.size() );
+    long double p{1};
+    double maxRelative{0};
+    for(size_t i = 0; i < n; ++i)
+    {
+        p *= factors[i];
+        maxRelative = std::max( maxRelative, static_cast<double>( std::fabs(products[i] / p - 1) ) );
+    }
+    QVERIFY( maxRelative < 1e-11 );
+
+    return;
+}
+
+void BlockAlgorithmsTest::testShortArrays()
+{
+    vector<double> empty;
+    BlockAlgorithms::Sort( empty.data(), 0 );
+    BlockAlgorithms::PrefixSum( empty.data(), 0 );
+    BlockAlgorithms::PrefixProduct( empty.data(), 0 );
+    QCOMPARE( BlockAlgorithms::Unique( empty.data(), 0 ), size_t{0} );
+
+    vector<double> one{-3.0};
+    BlockAlgorithms::Sort( one.data(), 1 );
+    BlockAlgorithms::PrefixSum( one.data(), 1 );
+    BlockAlgorithms::PrefixProduct( one.data(), 1 );
+    QCOMPARE( BlockAlgorithms::Unique( one.data(), 1 ), size_t{1} );
+    QCOMPARE( one.front(), -3.0 );
+
+    // exactly one block, and one block and one element
+    for(size_t n : {BlockAlgorithms::ScanBlock, BlockAlgorithms::ScanBlock + 1})
+    {
+        vector<double> x(n, 2.0);
+        BlockAlgorithms::PrefixSum( x.data(), n );
+        QCOMPARE( x.back(), 2.0 * n );
+    }
+
+    return;
+}
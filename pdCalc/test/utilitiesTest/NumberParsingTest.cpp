@@ -0,0 +1,175 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "NumberParsingTest.h"
+#include "src/utilities/NumberParsing.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+namespace NumberParsing = pdCalc::NumberParsing;
+
+namespace {
+
+bool parse(const string& s, double& d)
+{
+    return NumberParsing::ParseDouble( s.data(), s.data() + s.size(), d );
+}
+
+bool sameBits(double a, double b)
+{
+    return std::memcmp( &a, &b, sizeof(a) ) == 0;
+}
+
+// parses s and compares the result, bit for bit, with strtod's
+bool agreesWithStrtod(const string& s)
+{
+    double d;
+    return parse(s, d) && sameBits( d, std::strtod(s.c_str(), nullptr) );
+}
+
+}
+
+void NumberParsingTest::testParseDouble()
+{
+    double d;
+    QVERIFY( parse("0", d) && sameBits(d, 0.0) );
+    QVERIFY( parse("-0", d) && sameBits(d, -0.0) );
+    QVERIFY( parse("-0.0e5", d) && sameBits(d, -0.0) );
+    QVERIFY( parse("42", d) && d == 42.0 );
+    QVERIFY( parse("+3.25", d) && d == 3.25 );
+    QVERIFY( parse("-.5", d) && d == -0.5 );
+    QVERIFY( parse("7.", d) && d == 7.0 );
+    QVERIFY( parse("1e3", d) && d == 1000.0 );
+    QVERIFY( parse("2.5E-3", d) && d == 0.0025 );
+    QVERIFY( parse("0.1", d) && d == 0.1 );
+    QVERIFY( parse("000123.4500", d) && d == 123.45 );
+    QVERIFY( parse("9007199254740993", d) && d == 9007199254740992.0 );
+    QVERIFY( parse("1e308", d) && d == 1e308 );
+    QVERIFY( parse("1e400", d) && d == std::numeric_limits<double>::infinity() );
+    QVERIFY( parse("-1e400", d) && d == -std::numeric_limits<double>::infinity() );
+    QVERIFY( parse("1e-400", d) && sameBits(d, 0.0) );
+    QVERIFY( parse("4.9406564584124654e-324", d) && d == std::numeric_limits<double>::denorm_min() );
+
+    return;
+}
+
+void NumberParsingTest::testRoundingAgreesWithStrtod()
+{
+    const char* hard[] = {"0.1", "0.3", "1.7976931348623157e308", "2.2250738585072014e-308",
+        "2.2250738585072011e-308", "123456789012345678901234567890", "0.000000000000000000000123",
+        "9007199254740993", "9007199254740993.0000000000001", "1.00000000000000011102230246251565",
+        "3.14159265358979323846264338327950288", "1e22", "1e23", "8.98846567431158e307",
+        "12345678901234567890", "1234567890123456789", "0.1234567890123456789e-5"};
+    for(auto s : hard)
+        QVERIFY( agreesWithStrtod(s) );
+
+    // random digit strings of every length and exponent
+    std::mt19937_64 gen{17};
+    std::uniform_int_distribution<int> digit{0, 9}, length{1, 25}, point{0, 25}, exponent{-330, 330};
+    bool all{true};
+    for(int k = 0; k < 20000; ++k)
+    {
+        string s{ k % 2 ? "-" : "" };
+        const int n{ length(gen) };
+        const int p{ point(gen) };
+        for(int i = 0; i < n; ++i)
+        {
+            if(i == p) s += '.';
+            s += static_cast<char>( '0' + digit(gen) );
+        }
+        if(k % 3) s += "e" + std::to_string( exponent(gen) / (k % 3 == 1 ? 15 : 1) );
+
+        all = all && agreesWithStrtod(s);
+    }
+    QVERIFY(all);
+
+    return;
+}
+
+void NumberParsingTest::testRejects()
+{
+    double d;
+    for(auto s : {"", "+", "-", ".", "-.", "e5", "1e", "1e+", "1.2.3", "1-2", "abc", "1x", "inf", "nan",
+                  "0x10", " 1", "1 ", "--1", "1e5.0"})
+    {
+        QVERIFY( !parse(s, d) );
+    }
+
+    return;
+}
+
+void NumberParsingTest::testParseText()
+{
+    const string text{"1, 2.5;-3\n\n4e1\t\r\n  5,,6 "};
+    vector<double> x;
+    size_t bad{0};
+    QVERIFY( NumberParsing::ParseText(text.data(), text.size(), x, bad) );
+    QCOMPARE( x, (vector<double>{1.0, 2.5, -3.0, 40.0, 5.0, 6.0}) );
+
+    QVERIFY( NumberParsing::ParseText(text.data(), 0, x, bad) );
+    QVERIFY( x.empty() );
+
+    const string badText{"1 2\n3 x4 5"};
+    QVERIFY( !NumberParsing::ParseText(badText.data(), badText.size(), x, bad) );
+    QCOMPARE( bad, size_t{6} );
+
+    return;
+}
+
+// numbers of every length straddle the chunk boundaries of a large text
+void NumberParsingTest::testParallelText()
+{
+    std::mt19937_64 gen{5};
+    std::uniform_real_distribution<double> value{-1e6, 1e6};
+    std::uniform_int_distribution<int> separator{0, 3};
+    const char* separators[] = {" ", ",", "\n", " ,\r\n"};
+
+    string text;
+    vector<double> expected;
+    char buffer[40];
+    while( text.size() < 4 * NumberParsing::ParallelThreshold + 12345 )
+    {
+        const double v{ value(gen) };
+        std::snprintf( buffer, sizeof(buffer), "%.*g", static_cast<int>(expected.size() % 17) + 1, v );
+        text += buffer;
+        text += separators[ separator(gen) ];
+        expected.push_back( std::strtod(buffer, nullptr) );
+    }
+
+    vector<double> x;
+    size_t bad{0};
+    QVERIFY( NumberParsing::ParseText(text.data(), text.size(), x, bad) );
+    QCOMPARE( x.size(), expected.size() );
+    QVERIFY( x == expected );
+
+    // the first bad token is reported, even when a later chunk has one too
+    text[text.size() / 3] = 'x';
+    text[text.size() - 10] = 'y';
+    QVERIFY( !NumberParsing::ParseText(text.data(), text.size(), x, bad) );
+    QVERIFY( bad <= text.size() / 3 && text.size() / 3 - bad < 40 );
+
+    return;
+}
@@ -0,0 +1,113 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "PerfGateTest.h"
+#include "test/perfGate/PerfGate.h"
+#include <string>
+#include <vector>
+
+using std::vector;
+using std::string;
+using std::pair;
+using pdCalc::PerfGate;
+
+namespace {
+
+PerfGate::Verdict verdict(const vector<PerfGate::Comparison>& comparisons, const string& name)
+{
+    for(const auto& c : comparisons)
+        if(c.name == name) return c.verdict;
+
+    return PerfGate::Verdict::Missing;
+}
+
+// n timings from first, one apart, in no particular order
+vector<double> timings(double first, size_t n)
+{
+    vector<double> v;
+    for(size_t i = 0; i < n; ++i) v.push_back( first + static_cast<double>( (i * 7) % n ) );
+
+    return v;
+}
+
+}
+
+void PerfGateTest::testMedian()
+{
+    QCOMPARE( PerfGate::Median({}), 0.0 );
+    QCOMPARE( PerfGate::Median({7.0}), 7.0 );
+    QCOMPARE( PerfGate::Median({3.0, 1.0, 2.0}), 2.0 );
+    QCOMPARE( PerfGate::Median({4.0, 1.0, 3.0, 2.0}), 2.5 );
+    QCOMPARE( PerfGate::Median( timings(100, 9) ), 104.0 );
+
+    return;
+}
+
+void PerfGateTest::testMedianInterval()
+{
+    QCOMPARE( PerfGate::MedianInterval({}, 0.95), (pair<double, double>{0, 0}) );
+
+    // too few samples for any narrower interval to reach the confidence
+    QCOMPARE( PerfGate::MedianInterval( timings(1, 5), 0.95 ), (pair<double, double>{1, 5}) );
+
+    // P(B <= 1) = 10/512 for B ~ binomial(9, 1/2), within 2.5%, but P(B <= 2) is not
+    QCOMPARE( PerfGate::MedianInterval( timings(1, 9), 0.95 ), (pair<double, double>{2, 8}) );
+
+    // a lower confidence narrows the interval
+    QCOMPARE( PerfGate::MedianInterval( timings(1, 9), 0.8 ), (pair<double, double>{3, 7}) );
+
+    return;
+}
+
+// A benchmark is slower or faster only if its median moves by more than the
+// tolerance and its interval no longer overlaps the baseline's.
+void PerfGateTest::testCompare()
+{
+    PerfGate::Samples baseline;
+    baseline["same"] = timings(100, 9);
+    baseline["slower"] = timings(100, 9);
+    baseline["faster"] = timings(100, 9);
+    baseline["noisy"] = timings(100, 9);
+    baseline["within"] = timings(100, 9);
+    baseline["gone"] = timings(100, 9);
+
+    PerfGate::Samples current;
+    current["same"] = timings(101, 9);
+    current["slower"] = timings(150, 9);
+    current["faster"] = timings(50, 9);
+    current["noisy"] = {100, 101, 102, 103, 130, 131, 132, 133, 134};
+    current["within"] = timings(108, 9);
+    current["added"] = timings(100, 9);
+
+    const auto result = PerfGate::Compare(baseline, current);
+    QCOMPARE( result.size(), size_t{7} );
+    QCOMPARE( verdict(result, "same"), PerfGate::Verdict::Unchanged );
+    QCOMPARE( verdict(result, "slower"), PerfGate::Verdict::Slower );
+    QCOMPARE( verdict(result, "faster"), PerfGate::Verdict::Faster );
+    QCOMPARE( verdict(result, "noisy"), PerfGate::Verdict::Unchanged );
+    QCOMPARE( verdict(result, "within"), PerfGate::Verdict::Unchanged );
+    QCOMPARE( verdict(result, "gone"), PerfGate::Verdict::Missing );
+    QCOMPARE( verdict(result, "added"), PerfGate::Verdict::New );
+
+    // the tolerance is relative to the baseline median
+    PerfGate::Options strict;
+    strict.tolerance = 0.05;
+    QCOMPARE( verdict( PerfGate::Compare(baseline, current, strict), "within" ), PerfGate::Verdict::Slower );
+
+    return;
+}
@@ -0,0 +1,185 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "StackChangeTest.h"
+#include "src/utilities/StackChange.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using std::vector;
+using std::string;
+using pdCalc::StackChange;
+
+namespace {
+
+// a stack of numbers, bottom first, that counts the elements a view asks for
+class ModelStack
+{
+public:
+    ModelStack() : generation_{0}, lookups{0} { }
+
+    StackChange change(size_t popped, const vector<double>& pushed)
+    {
+        stack_.erase( stack_.end() - popped, stack_.end() );
+        stack_.insert( stack_.end(), pushed.begin(), pushed.end() );
+
+        return StackChange{popped, pushed.size(), stack_.size(), ++generation_};
+    }
+
+    double element(size_t depth)
+    {
+        ++lookups;
+        return stack_[stack_.size() - 1 - depth];
+    }
+
+    // the top n elements, top first, as a view should hold them
+    vector<double> top(size_t n) const
+    {
+        vector<double> v;
+        for(size_t i = 0; i < n && i < stack_.size(); ++i)
+            v.push_back( stack_[stack_.size() - 1 - i] );
+
+        return v;
+    }
+
+    size_t size() const { return stack_.size(); }
+
+private:
+    vector<double> stack_;
+    uint64_t generation_;
+
+public:
+    size_t lookups;
+};
+
+}
+
+void StackChangeTest::testApply()
+{
+    ModelStack stack;
+    vector<double> view;
+    uint64_t generation{0};
+    auto element = [&stack](size_t depth){ return stack.element(depth); };
+
+    pdCalc::ApplyStackChange(stack.change(0, {1, 2, 3, 4, 5, 6}), view, 4, generation, element);
+    QCOMPARE( view, (vector<double>{6, 5, 4, 3}) );
+    QCOMPARE( generation, uint64_t{1} );
+
+    // a binary operation looks up only its result
+    stack.lookups = 0;
+    pdCalc::ApplyStackChange(stack.change(2, {11}), view, 4, generation, element);
+    QCOMPARE( view, (vector<double>{11, 4, 3, 2}) );
+    QCOMPARE( stack.lookups, size_t{2} );
+
+    // a swap replaces the top two
+    stack.lookups = 0;
+    pdCalc::ApplyStackChange(stack.change(2, {11, 4}), view, 4, generation, element);
+    QCOMPARE( view, (vector<double>{4, 11, 3, 2}) );
+    QCOMPARE( stack.lookups, size_t{2} );
+
+    // pops below the view refill it from the bottom, and the stack may empty
+    pdCalc::ApplyStackChange(stack.change(4, {}), view, 4, generation, element);
+    QCOMPARE( view, (vector<double>{1}) );
+    pdCalc::ApplyStackChange(stack.change(1, {}), view, 4, generation, element);
+    QVERIFY( view.empty() );
+
+    // a push larger than the view looks up only what it shows
+    stack.lookups = 0;
+    pdCalc::ApplyStackChange(stack.change(0, vector<double>(1000, 7.0)), view, 4, generation, element);
+    QCOMPARE( view, stack.top(4) );
+    QCOMPARE( stack.lookups, size_t{4} );
+
+    return;
+}
+
+void StackChangeTest::testRebuild()
+{
+    ModelStack stack;
+    vector<string> view{"stale"};
+    auto element = [&stack](size_t depth){ return std::to_string( static_cast<int>( stack.element(depth) ) ); };
+
+    // a view that does not know its generation is rebuilt
+    uint64_t generation{pdCalc::UnknownGeneration};
+    pdCalc::ApplyStackChange(stack.change(0, {1, 2}), view, 4, generation, element);
+    QCOMPARE( view, (vector<string>{"2", "1"}) );
+
+    // as is one that missed a change
+    stack.change(1, {5, 6});
+    pdCalc::ApplyStackChange(stack.change(0, {7}), view, 4, generation, element);
+    QCOMPARE( view, (vector<string>{"7", "6", "5", "1"}) );
+    QCOMPARE( generation, uint64_t{3} );
+
+    return;
+}
+
+void StackChangeTest::testRandomChanges()
+{
+    std::mt19937 gen{17};
+    ModelStack stack;
+    vector<double> view;
+    uint64_t generation{0};
+    auto element = [&stack](size_t depth){ return stack.element(depth); };
+
+    bool allMatch{true};
+    for(int i = 0; i < 2000; ++i)
+    {
+        const size_t popped{ std::uniform_int_distribution<size_t>{0, std::min<size_t>(stack.size(), 9)}(gen) };
+        vector<double> pushed( std::uniform_int_distribution<size_t>{0, 9}(gen) );
+        for(auto& d : pushed)
+            d = i;
+
+        pdCalc::ApplyStackChange(stack.change(popped, pushed), view, 6, generation, element);
+        allMatch = allMatch && view == stack.top(6);
+    }
+    QVERIFY(allMatch);
+
+    return;
+}
+
+void StackChangeTest::testCompose()
+{
+    std::mt19937 gen{29};
+    ModelStack stack;
+    vector<double> view;
+    uint64_t generation{0};
+    auto element = [&stack](size_t depth){ return stack.element(depth); };
+
+    // runs of changes, folded into one and applied as the next change, as a view
+    // updated once per frame sees them
+    bool allMatch{true};
+    for(int i = 0; i < 500; ++i)
+    {
+        StackChange both{};
+        const int n{ std::uniform_int_distribution<int>{1, 5}(gen) };
+        for(int j = 0; j < n; ++j)
+        {
+            const size_t popped{ std::uniform_int_distribution<size_t>{0, std::min<size_t>(stack.size(), 9)}(gen) };
+            vector<double> pushed( std::uniform_int_distribution<size_t>{0, 9}(gen), i * 10.0 + j );
+            StackChange change{ stack.change(popped, pushed) };
+            both = j == 0 ? change : pdCalc::ComposeStackChanges(both, change);
+        }
+
+        both.generation = generation + 1;
+        pdCalc::ApplyStackChange(both, view, 6, generation, element);
+        allMatch = allMatch && view == stack.top(6);
+    }
+    QVERIFY(allMatch);
+
+    return;
+}
@@ -0,0 +1,34 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STACK_CHANGE_TEST_H
+#define STACK_CHANGE_TEST_H
+
+#include <QtTest/QtTest>
+
+class StackChangeTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testApply();
+    void testRebuild();
+    void testRandomChanges();
+    void testCompose();
+};
+
+#endif
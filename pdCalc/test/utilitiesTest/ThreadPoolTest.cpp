@@ -0,0 +1,116 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPoolTest.h"
+#include "src/utilities/ThreadPool.h"
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+
+using std::vector;
+using pdCalc::ThreadPool;
+
+void ThreadPoolTest::testChunks()
+{
+    ThreadPool& pool = ThreadPool::Instance();
+
+    QVERIFY( pool.concurrency() >= 1 );
+    QCOMPARE( pool.nChunks(0, 10), size_t{0} );
+    QCOMPARE( pool.nChunks(5, 10), size_t{1} );
+    QCOMPARE( pool.nChunks(1000000, 10), pool.concurrency() );
+    QVERIFY( pool.nChunks(30, 10) <= 3 );
+
+    return;
+}
+
+void ThreadPoolTest::testParallelFor()
+{
+    ThreadPool& pool = ThreadPool::Instance();
+
+    const size_t n = 100003;
+    vector<int> visits(n, 0);
+    vector<size_t> chunkSizes( pool.nChunks(n, 1000), 0 );
+
+    pool.parallelFor(n, 1000, [&](size_t chunk, size_t begin, size_t end)
+    {
+        chunkSizes[chunk] = end - begin;
+        for(size_t i = begin; i < end; ++i)
+            ++visits[i];
+    });
+
+    bool allOnce{true};
+    for(auto v : visits)
+        allOnce = allOnce && v == 1;
+    QVERIFY(allOnce);
+
+    size_t total{0};
+    for(auto s : chunkSizes)
+    {
+        QVERIFY(s >= 1000);
+        total += s;
+    }
+    QCOMPARE(total, n);
+
+    return;
+}
+
+void ThreadPoolTest::testNested()
+{
+    ThreadPool& pool = ThreadPool::Instance();
+
+    std::atomic<size_t> count{0};
+    pool.parallelFor(64, 1, [&](size_t, size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+        {
+            pool.parallelFor(100, 1, [&](size_t, size_t b, size_t e)
+            {
+                count += e - b;
+            });
+        }
+    });
+
+    QCOMPARE( count.load(), size_t{6400} );
+
+    return;
+}
+
+void ThreadPoolTest::testException()
+{
+    ThreadPool& pool = ThreadPool::Instance();
+
+    std::atomic<size_t> count{0};
+    try
+    {
+        pool.parallelFor(1000, 1, [&](size_t chunk, size_t begin, size_t end)
+        {
+            count += end - begin;
+            if(chunk == 0) throw std::runtime_error{"chunk failed"};
+        });
+        QVERIFY(false);
+    }
+    catch(std::runtime_error& e)
+    {
+        QCOMPARE( std::string{e.what()}, std::string{"chunk failed"} );
+    }
+
+    // every chunk still ran to completion
+    QCOMPARE( count.load(), size_t{1000} );
+
+    return;
+}
@@ -81,3 +81,24 @@ void TokenizerTest::testTokenizationFromStream()
     return;
 }
 
+
+void TokenizerTest::testTokenIsNumber()
+{
+    vector<string> numbers = {"7", "-7", "+7.", ".5", "-.5e3", "1.25E-2", "3e+8", "0"};
+    vector<double> values = {7, -7, 7, 0.5, -500, 0.0125, 3e8, 0};
+    for(size_t i = 0; i < numbers.size(); ++i)
+    {
+        double d{0};
+        QVERIFY( pdCalc::TokenIsNumber(numbers[i], d) );
+        QCOMPARE(d, values[i]);
+    }
+
+    vector<string> others = {"", "+", "-", "e5", "sin", "1e", "1.2.3", "12a", "--1", "1e+"};
+    for(const auto& s : others)
+    {
+        double d{0};
+        QVERIFY( !pdCalc::TokenIsNumber(s, d) );
+    }
+
+    return;
+}
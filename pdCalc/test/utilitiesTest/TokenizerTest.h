@@ -33,6 +33,7 @@ class TokenizerTest : public QObject
 private slots:
     void testTokenizationFromString();
     void testTokenizationFromStream();
+    void testTokenIsNumber();
 
 private:
     void assertTokenizerMatches(const std::vector<std::string>&, const pdCalc::Tokenizer&);
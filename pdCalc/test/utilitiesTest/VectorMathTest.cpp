@@ -0,0 +1,305 @@
+// Copyright 2016 Adam B. Singer
+// Contact: PracticalDesignBook@gmail.com
+//
+// This file is part of pdCalc.
+//
+// pdCalc is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// pdCalc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with pdCalc; if not, see <http://www.gnu.org/licenses/>.
+
+#include "VectorMathTest.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::vector;
+using std::string;
+namespace VectorMath = pdCalc::VectorMath;
+using VectorMath::Isa;
+
+namespace {
+
+using Function = void(const double*, double*, size_t);
+using Reference = long double(long double);
+
+const double Infinity = std::numeric_limits<double>::infinity();
+const double NotANumber = std::numeric_limits<double>::quiet_NaN();
+
+// distance of y from the long double reference r in units in the last place of the
+// double nearest r
+double UlpError(double y, long double r)
+{
+    double rd{ static_cast<double>(r) };
+    if( std::isnan(rd) ) return std::isnan(y) ? 0 : Infinity;
+    if( std::isinf(rd) || rd == 0 ) return y == rd ? 0 : Infinity;
+
+    int e;
+    std::frexp(rd, &e);
+    double ulp{ std::ldexp(1.0, std::max(e - 53, -1074)) };
+
+    return static_cast<double>( std::fabs(y - r) / ulp );
+}
+
+// the instruction sets this processor can run, besides the C library
+vector<Isa> VectorIsas()
+{
+    vector<Isa> isas;
+    for(Isa isa : {Isa::Sse2, Isa::Avx2})
+    {
+        if( VectorMath::SetIsa(isa) == isa ) isas.push_back(isa);
+    }
+
+    return isas;
+}
+
+// worst error of f against ref over n points drawn uniformly from [lo, hi], or
+// with a uniformly distributed logarithm of the magnitude, and both signs, when
+// logarithmic
+double MaxUlpError(Function* f, Reference* ref, double lo, double hi, bool logarithmic, size_t n = 20000)
+{
+    std::mt19937_64 gen{20161};
+    std::uniform_real_distribution<double> dist{lo, hi};
+    vector<double> x(n);
+    for(auto& v : x)
+        v = logarithmic ? std::copysign( std::exp(dist(gen)), gen() & 1 ? 1.0 : -1.0 ) : dist(gen);
+
+    vector<double> y(n);
+    f( x.data(), y.data(), n );
+
+    double worst{0};
+    for(size_t i = 0; i < n; ++i)
+        worst = std::max( worst, UlpError(y[i], ref(x[i])) );
+
+    return worst;
+}
+
+struct Case
+{
+    const char* name;
+    Function* f;
+    Reference* ref;
+    double lo;
+    double hi;
+    bool logarithmic;
+    double bound;
+};
+
+bool CheckCases(const vector<Case>& cases, string& failure)
+{
+    for(Isa isa : VectorIsas())
+    {
+        VectorMath::SetIsa(isa);
+        for(const auto& c : cases)
+        {
+            double e{ MaxUlpError(c.f, c.ref, c.lo, c.hi, c.logarithmic) };
+            if( !(e <= c.bound) )
+            {
+                failure = string{c.name} + " (" + VectorMath::IsaName(isa) + ") error " + std::to_string(e) + " ulp";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+long double Sinl(long double x) { return std::sin(x); }
+long double Cosl(long double x) { return std::cos(x); }
+long double Tanl(long double x) { return std::tan(x); }
+long double Asinl(long double x) { return std::asin(x); }
+long double Acosl(long double x) { return std::acos(x); }
+long double Atanl(long double x) { return std::atan(x); }
+long double Expl(long double x) { return std::exp(x); }
+long double Logl(long double x) { return std::log(x); }
+long double Sinhl(long double x) { return std::sinh(x); }
+long double Coshl(long double x) { return std::cosh(x); }
+long double Tanhl(long double x) { return std::tanh(x); }
+long double Asinhl(long double x) { return std::asinh(x); }
+long double Acoshl(long double x) { return std::acosh(x); }
+long double Atanhl(long double x) { return std::atanh(x); }
+
+bool SameBits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+}
+
+void VectorMathTest::init()
+{
+    isa_ = VectorMath::ActiveIsa();
+
+    return;
+}
+
+void VectorMathTest::cleanup()
+{
+    VectorMath::SetIsa(isa_);
+
+    return;
+}
+
+void VectorMathTest::testTrigonometricAccuracy()
+{
+    // the bounds documented in VectorMath.h
+    vector<Case> cases = {
+        {"sin", VectorMath::Sin, Sinl, -10, 10, false, 1},
+        {"sin", VectorMath::Sin, Sinl, -40, 13.6, true, 1},
+        {"cos", VectorMath::Cos, Cosl, -10, 10, false, 1},
+        {"cos", VectorMath::Cos, Cosl, -40, 13.6, true, 1},
+        {"tan", VectorMath::Tan, Tanl, -10, 10, false, 3},
+        {"tan", VectorMath::Tan, Tanl, -40, 13.6, true, 3},
+        {"asin", VectorMath::Asin, Asinl, -1, 1, false, 3},
+        {"asin", VectorMath::Asin, Asinl, -40, 0, true, 3},
+        {"acos", VectorMath::Acos, Acosl, -1, 1, false, 2},
+        {"acos", VectorMath::Acos, Acosl, -40, 0, true, 2},
+        {"atan", VectorMath::Atan, Atanl, -10, 10, false, 1},
+        {"atan", VectorMath::Atan, Atanl, -40, 700, true, 1}
+    };
+
+    string failure;
+    QVERIFY2( CheckCases(cases, failure), failure.c_str() );
+
+    return;
+}
+
+void VectorMathTest::testExpLogAccuracy()
+{
+    vector<Case> cases = {
+        {"exp", VectorMath::Exp, Expl, -2, 2, false, 1},
+        {"exp", VectorMath::Exp, Expl, -745, 709.7, false, 1},
+        {"log", VectorMath::Log, Logl, 0, 10, false, 1},
+        {"log", VectorMath::Log, Logl, 0.7, 1.5, false, 1},
+        {"log", VectorMath::Log, Logl, -744, 709, true, 1}
+    };
+
+    string failure;
+    QVERIFY2( CheckCases(cases, failure), failure.c_str() );
+
+    return;
+}
+
+void VectorMathTest::testHyperbolicAccuracy()
+{
+    vector<Case> cases = {
+        {"sinh", VectorMath::Sinh, Sinhl, -5, 5, false, 3},
+        {"sinh", VectorMath::Sinh, Sinhl, -711, 711, false, 3},
+        {"sinh", VectorMath::Sinh, Sinhl, -40, 6.5, true, 3},
+        {"cosh", VectorMath::Cosh, Coshl, -5, 5, false, 3},
+        {"cosh", VectorMath::Cosh, Coshl, -711, 711, false, 3},
+        {"tanh", VectorMath::Tanh, Tanhl, -5, 5, false, 3},
+        {"tanh", VectorMath::Tanh, Tanhl, -40, 5, true, 3},
+        {"asinh", VectorMath::Asinh, Asinhl, -5, 5, false, 2},
+        {"asinh", VectorMath::Asinh, Asinhl, -40, 700, true, 2},
+        {"acosh", VectorMath::Acosh, Acoshl, 1, 5, false, 3},
+        {"acosh", VectorMath::Acosh, Acoshl, 1, 1e300, false, 3},
+        {"atanh", VectorMath::Atanh, Atanhl, -1, 1, false, 3},
+        {"atanh", VectorMath::Atanh, Atanhl, -40, 0, true, 3}
+    };
+
+    string failure;
+    QVERIFY2( CheckCases(cases, failure), failure.c_str() );
+
+    return;
+}
+
+void VectorMathTest::testSpecialValues()
+{
+    const double specials[] = {0.0, -0.0, Infinity, -Infinity, NotANumber, 1.0, -1.0,
+        4.9406564584124654e-324, -2.2250738585072014e-308, 1e300, -1e300, 709.9, -745.5};
+    const size_t n{ sizeof(specials) / sizeof(specials[0]) };
+
+    Function* functions[] = {VectorMath::Sin, VectorMath::Cos, VectorMath::Tan, VectorMath::Asin,
+        VectorMath::Acos, VectorMath::Atan, VectorMath::Exp, VectorMath::Log, VectorMath::Sinh,
+        VectorMath::Cosh, VectorMath::Tanh, VectorMath::Asinh, VectorMath::Acosh, VectorMath::Atanh};
+    double (*libm[])(double) = {std::sin, std::cos, std::tan, std::asin, std::acos, std::atan,
+        std::exp, std::log, std::sinh, std::cosh, std::tanh, std::asinh, std::acosh, std::atanh};
+
+    for(Isa isa : VectorIsas())
+    {
+        VectorMath::SetIsa(isa);
+        for(size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); ++f)
+        {
+            double y[n];
+            functions[f](specials, y, n);
+            for(size_t i = 0; i < n; ++i)
+            {
+                double r{ libm[f](specials[i]) };
+                bool same{ std::isnan(r) ? std::isnan(y[i]) : SameBits(y[i], r) || UlpError(y[i], r) <= 3 };
+                QVERIFY2( same, (std::to_string(f) + ": " + std::to_string(specials[i])).c_str() );
+            }
+        }
+    }
+
+    return;
+}
+
+void VectorMathTest::testIsaAgreement()
+{
+    // the kernels round identically on every instruction set
+    vector<Isa> isas{ VectorIsas() };
+    if(isas.size() < 2) QSKIP("only one vector instruction set");
+
+    std::mt19937_64 gen{7};
+    std::uniform_real_distribution<double> dist{-800, 800};
+    vector<double> x(4099);
+    for(auto& v : x) v = dist(gen);
+
+    vector<double> a(x.size());
+    vector<double> b(x.size());
+    for(Function* f : {VectorMath::Sin, VectorMath::Tan, VectorMath::Atan, VectorMath::Exp,
+        VectorMath::Log, VectorMath::Sinh, VectorMath::Tanh, VectorMath::Acosh})
+    {
+        VectorMath::SetIsa(isas[0]);
+        f( x.data(), a.data(), x.size() );
+        VectorMath::SetIsa(isas[1]);
+        f( x.data(), b.data(), x.size() );
+
+        bool same{true};
+        for(size_t i = 0; i < x.size(); ++i)
+            same = same && ( SameBits(a[i], b[i]) || (std::isnan(a[i]) && std::isnan(b[i])) );
+        QVERIFY(same);
+    }
+
+    return;
+}
+
+void VectorMathTest::testTailsAndInPlace()
+{
+    QCOMPARE( VectorMath::SetIsa(Isa::Scalar), Isa::Scalar );
+    QCOMPARE( string{VectorMath::IsaName(Isa::Scalar)}, string{"scalar"} );
+
+    // every length up to a few vectors, and one split across the thread pool
+    for(Isa isa : VectorIsas())
+    {
+        VectorMath::SetIsa(isa);
+        for(size_t n : {size_t{0}, size_t{1}, size_t{2}, size_t{3}, size_t{5}, size_t{7}, size_t{9}, VectorMath::ParallelThreshold + 3})
+        {
+            vector<double> x(n);
+            for(size_t i = 0; i < n; ++i)
+                x[i] = 0.001 * i - 1.0;
+
+            vector<double> y(x);
+            VectorMath::Cos( y.data(), y.data(), n );
+
+            bool close{true};
+            for(size_t i = 0; i < n; ++i)
+                close = close && UlpError(y[i], std::cos(static_cast<long double>(x[i]))) <= 1;
+            QVERIFY(close);
+        }
+    }
+
+    return;
+}
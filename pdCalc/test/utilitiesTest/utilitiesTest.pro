@@ -3,7 +3,7 @@ include ($$HOME/common.pri)
 TEMPLATE = lib
 TARGET = pdCalcUtilitiesTest
 DEPENDPATH += $$HOME/src/utilities
-INCLUDEPATH += . $$HOME
+INCLUDEPATH += . $$HOME $$HOME/src
 unix:DESTDIR = $$HOME/lib
 win32:DESTDIR = $$HOME/bin
 
@@ -12,9 +12,24 @@ QT += testlib
 
 # Input
 HEADERS += PublisherObserverTest.h \
-    TokenizerTest.h
+    TokenizerTest.h \
+    ThreadPoolTest.h \
+    BigNumberTest.h \
+    VectorMathTest.h \
+    BlockAlgorithmsTest.h \
+    NumberParsingTest.h \
+    StackChangeTest.h \
+    PerfGateTest.h
 SOURCES += PublisherObserverTest.cpp \
-    TokenizerTest.cpp
+    TokenizerTest.cpp \
+    ThreadPoolTest.cpp \
+    BigNumberTest.cpp \
+    VectorMathTest.cpp \
+    BlockAlgorithmsTest.cpp \
+    NumberParsingTest.cpp \
+    StackChangeTest.cpp \
+    PerfGateTest.cpp \
+    ../perfGate/PerfGate.cpp
 
 unix:LIBS += -L$$HOME/lib -lpdCalcUtilities
 win32:LIBS += -L$$HOME/bin -lpdCalcUtilities1